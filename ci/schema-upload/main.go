@@ -253,7 +253,11 @@ func generateSchema() (SchemaRequest, error) {
 
 	for _, line := range lines {
 		line = strings.TrimSpace(line)
-		if !strings.HasPrefix(line, "MEASUREMENT_TRAIT(") {
+		// MEASUREMENT_TRAIT_Q (fixed-point) starts with the same 4 fields
+		prefix := "MEASUREMENT_TRAIT("
+		if strings.HasPrefix(line, "MEASUREMENT_TRAIT_Q(") {
+			prefix = "MEASUREMENT_TRAIT_Q("
+		} else if !strings.HasPrefix(line, prefix) {
 			continue
 		}
 
@@ -264,7 +268,7 @@ func generateSchema() (SchemaRequest, error) {
 		}
 
 		// Extract ID (first param) - this is the enum name
-		idStr := strings.TrimSpace(strings.TrimPrefix(parts[0], "MEASUREMENT_TRAIT("))
+		idStr := strings.TrimSpace(strings.TrimPrefix(parts[0], prefix))
 
 		// Extract TYPE (second param)
 		typeStr := strings.TrimSpace(parts[1])
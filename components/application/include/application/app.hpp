@@ -10,31 +10,96 @@
 
 #include "board.hpp"
 #include "sensor_ids.hpp"
-#include "timestamp_sensor.hpp"
 
+#include "app_config.hpp"
+
+#include <battery/sensor.hpp>
 #include <bme680/sensor.hpp>
 #include <cloud/cloud_manager.hpp>
+#include <cloud/device_config.hpp>
+#include <cloud/mesh_relay.hpp>
+#include <cloud/ota_updater.hpp>
+#include <cloud/rtc_sample_buffer.hpp>
+#include <cloud/telemetry_log.hpp>
 #include <core/app_events.hpp>
 #include <core/application.hpp>
+#include <core/blob_partition.hpp>
 #include <core/event_loop.hpp>
+#include <core/heap_watchdog.hpp>
+#include <core/rtc_mirror.hpp>
 #include <core/rtc_storage.hpp>
+#include <core/semaphore.hpp>
+#include <core/task.hpp>
 #include <core/timer.hpp>
+#include <core/timer_wheel.hpp>
+#include <core/worker.hpp>
 #include <network/wifi_manager.hpp>
+#include <power/battery_policy.hpp>
+#include <power/cycle_planner.hpp>
 #include <power/sleep.hpp>
+#include <power/wake_stub.hpp>
+#include <sensor/anomaly.hpp>
 #include <sensor/data_manager.hpp>
+#include <sensor/deadband.hpp>
 #include <sensor/events.hpp>
 #include <sensor/manager.hpp>
 #include <sensor/monitor.hpp>
+#include <sensor/scheduler.hpp>
+#include <sim/sensor.hpp>
+#include <transport/espnow_transport.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <optional>
 
 namespace application {
 
+/// Samples retained per sensor between telemetry uploads
+inline constexpr size_t HISTORY_DEPTH = 16;
+
+/// DataManager slots: one per sensor this build registers, whatever its
+/// SensorId value (the battery and simulated sensors only when configured)
+inline constexpr auto SENSOR_SLOTS = [] {
+  namespace config = app::config;
+  constexpr size_t count = 2 + (config::battery::MONITOR ? 1 : 0) +
+                           (config::sim::ENABLED ? 1 : 0);
+  sensor::SlotTable<count> slots;
+  (void)slots.add(static_cast<sensor::SensorIdType>(sensor::SensorId::BME680));
+  (void)slots.add(static_cast<sensor::SensorIdType>(sensor::SensorId::Events));
+  if (config::battery::MONITOR) {
+    (void)slots.add(
+        static_cast<sensor::SensorIdType>(sensor::SensorId::Battery));
+  }
+  if (config::sim::ENABLED) {
+    (void)slots.add(static_cast<sensor::SensorIdType>(sensor::SensorId::Sim));
+  }
+  return slots;
+}();
+
 // Application-specific type aliases using our SensorId registry
-using DataManager = sensor::DataManagerT<sensor::sensor_type_count()>;
+using DataManager =
+    sensor::DataManagerT<SENSOR_SLOTS.capacity(),
+                         sensor::MAX_MEASUREMENTS_PER_SENSOR, HISTORY_DEPTH>;
 using SensorManager = sensor::SensorManagerT<DataManager>;
 
+/// Sensor drivers the board setup registers, in registration order
+using SensorRegistry = driver::i2c::DriverRegistry<>;
+
+/// What a timer wake takes from RTC memory instead of reading flash and
+/// probing hardware (saved right before each deep sleep)
+struct FastBootState {
+  int64_t leased_us;                ///< RTC time wifi.ip was DHCP-leased
+  uint32_t boots;                   ///< Boot count of the last cold boot
+  uint32_t wakes;                   ///< Timer wakes since then
+  cloud::DeviceConfig config;       ///< Saves the stored-config read
+  network::FastConnect wifi;        ///< Saves the WiFi scan and DHCP
+  network::ApCache aps;             ///< Channels to scan, AP to roam from
+  SensorRegistry::Layout sensors;   ///< Saves the I2C probing
+  bool wifi_provisioned;            ///< Saves the credentials check
+  bool cloud_provisioned;           ///< Saves the cloud credentials check
+};
+
 /// Measurement probe application
 class MeasurementProbe final : public core::Application {
 public:
@@ -50,22 +115,136 @@ private:
   /// Maximum measurements buffer for zero-allocation logging
   static constexpr size_t MAX_MEASUREMENTS = 32;
 
+  /// Cloud worker items (bits posted to cloud_worker_)
+  enum CloudWork : uint32_t {
+    CLOUD_START = 1U << 0,
+    CLOUD_STOP = 1U << 1,
+    CLOUD_DEVICE_INFO = 1U << 2,
+    CLOUD_TELEMETRY = 1U << 3, // Also replays the offline backlog
+    CLOUD_POLL_COMMANDS = 1U << 4,
+    CLOUD_REFRESH_TOKEN = 1U << 5,
+    CLOUD_TRANSMIT = 1U << 6, // Duty cycle: upload, report, then signal
+    CLOUD_APPLY_CONFIG = 1U << 7, // Battery level changed the intervals
+    CLOUD_ANOMALY = 1U << 8,      // Upload everything now, batch or not
+    CLOUD_RELAY = 1U << 9,        // Aggregator: queue the leaves' samples
+  };
+
+  /// TLS handshakes and protobuf encoding run on this stack
+  static constexpr uint32_t CLOUD_WORKER_STACK = 12288;
+  /// Cloud work deferred on a critical heap is re-posted after this,
+  /// doubling per deferral up to CLOUD_DEFER_MAX
+  static constexpr std::chrono::milliseconds CLOUD_DEFER_MIN{2000};
+  static constexpr std::chrono::milliseconds CLOUD_DEFER_MAX{60000};
+  /// Holds one unpacked leaf sample next to the outbox push
+  static constexpr uint32_t MESH_RELAY_STACK = 4096;
+
   static void log_boot_info();
+  /// Timer wake with a valid RTC snapshot: take it in place of the flash
+  /// reads and bus probing of a cold boot
+  /// @return true if the snapshot was taken (fast_boot_ set)
+  bool resume_fast_boot();
+  /// Snapshot this wake's setup for the next one (before deep sleep)
+  void save_fast_boot();
   void track_boot_count();
+  /// Map the cert/config partition (optional: built-in defaults otherwise)
+  void open_blobs();
+  /// Take the config stored by the last config_update (defaults otherwise)
+  void load_device_config();
+  /// Read the cell before the radio draws any current (deep sleeps if it
+  /// is empty)
+  void init_battery();
+  /// Register a BME680 on the SPI bus (app::config::BME680_SPI_CS), before
+  /// the I2C scan would look for one
+  void init_bme680_spi(core::IStorage &bsec_storage);
+  /// Register the simulated sensor (app::config::sim)
+  void init_sim();
+  /// Classify a battery reading; shuts down at BatteryLevel::Shutdown
+  /// @return true if the level (and so the interval stretch) changed
+  bool update_battery_level(float volts);
+  /// Flush storage and deep sleep until the next battery check
+  [[noreturn]] void shutdown_on_low_battery(float volts);
   void init_wifi();
   void init_sensors();
-  void run_continuous_mode();
+  [[noreturn]] void run_continuous_mode();
+
+  /// Phases of one wake in deep-sleep mode
+  enum class CyclePhase : uint8_t { Init, Measure, Transmit, Sleep };
+
+  /// BSEC ULP mode: INIT -> MEASURE -> TRANSMIT -> SLEEP, one pass per
+  /// wake, each phase bounded. TRANSMIT only runs with DUTY_CYCLE_MODE on
+  /// a provisioned device, and only on wakes plan_transmit() picks; the
+  /// others buffer their sample in flash without starting WiFi. Without
+  /// WiFi credentials the device stays awake in continuous mode for BLE
+  /// provisioning.
+  [[noreturn]] void run_duty_cycle();
+
+  /// Whether this wake has to upload (see power::plan_cycle)
+  [[nodiscard]] power::TransmitReason plan_transmit(bool alert) const;
+
+  /// The latest BME680 sample is past an alert threshold
+  [[nodiscard]] bool alert_active();
+
+  /// Put the pins of a GPIO wake into the history (SensorId::Events)
+  void record_wake_event();
+
+  /// AnomalyDetector handler (sampling task): put the anomaly into the
+  /// history (SensorId::Events) and have it uploaded right away
+  void on_anomaly(const sensor::Anomaly &anomaly);
+  /// Keep the detector's averages and anomaly_pending_ in RTC memory
+  /// (before deep sleep)
+  void save_anomaly_state();
+
+  /// Arm the GPIO wake (if configured) for the coming deep sleep
+  static void arm_wake_sources();
+
+  /// Put the wake profiles saved by earlier wakes into the history
+  /// (SensorId::Events), once each
+  void record_wake_profile();
+
+  /// Close the Sleep phase and keep this wake's profile in RTC memory
+  void save_wake_profile() const;
+
+  /// Put the metrics of the period since the last call into the history
+  /// (SensorId::Events): one system sample, one of per-sensor counts
+  /// (those of earlier wakes included)
+  void record_metrics();
+
+  /// Add this wake's sensor sample counts to those in RTC memory (before
+  /// deep sleep), so wakes that don't record metrics still count
+  void save_sample_counts();
+
+  /// WiFi and cloud for a transmitting wake (does not return while the
+  /// device is not provisioned)
+  void start_radio(power::TransmitReason reason);
+
+  /// ESP-NOW link of a leaf or aggregator (app::config::mesh); a leaf
+  /// starts the WiFi driver without associating
+  void init_mesh();
+
+  /// Leaf: hand this wake's sample, and those the aggregator missed
+  /// before, to the aggregator (kept in RTC memory until it acks)
+  void send_to_aggregator();
+
+  /// Aggregator relay task: queue the leaves' samples for upload
+  [[noreturn]] void run_mesh_relay();
+
+  /// Wait for this cycle's BSEC sample
+  /// @return false on timeout or without a BSEC sensor
+  bool wait_for_sample(std::chrono::milliseconds timeout);
+
+  /// Hand the upload to the cloud worker and wait for it
+  /// @return true once the backend accepted everything queued
+  bool transmit(std::chrono::milliseconds timeout);
+
+  /// Snapshot BSEC to RTC and deep sleep until the next BSEC deadline
+  [[noreturn]] void sleep_until_next_cycle();
 
   /// Handle WiFi state changes
   void on_wifi_state_change(network::WifiState old_state,
                             network::WifiState new_state);
 
-  /// Handle sensor data ready events (event-driven)
-  void on_sensor_data(const sensor::SensorDataEvent &event);
-
-  /// Static event handler (bridges ESP-IDF callback to member function)
-  static void sensor_event_handler(void *arg, esp_event_base_t base,
-                                   int32_t event_id, void *event_data);
+  /// Handle sensors that produced new data (mask of DataManager::bit()s)
+  void on_sensor_data(uint32_t updated);
 
   /// Called periodically to log sensor readings (aggregated)
   void on_log_timer();
@@ -73,17 +252,47 @@ private:
   /// Initialize cloud services
   void init_cloud();
 
+  /// Open the offline telemetry log (once)
+  void open_telemetry_log();
+
+  /// Cloud worker handler: runs every CloudManager call
+  void run_cloud_work(uint32_t work);
+
+  /// Heap check before network work: Low frees the idle connection,
+  /// Critical defers the work (and restarts once the heap doesn't recover)
+  /// @return false to skip the network work
+  bool guard_heap(const char *where);
+
+  /// Cloud worker only: keep work skipped by guard_heap() and re-post it
+  /// after the backoff (CLOUD_START is posted only once per connect)
+  void defer_cloud_work(uint32_t work);
+
   /// Start cloud when WiFi connects
   void start_cloud();
 
-  /// Send telemetry to cloud
+  /// Send telemetry to cloud (queued to flash while offline)
   void send_telemetry();
 
+  /// Cloud worker side of transmit(): send, report, poll once, signal
+  void run_transmit();
+
+  /// Report device info (skipped while unchanged)
+  void report_device_info();
+
+  /// Move the RTC batch and buffered history into the offline telemetry
+  /// log
+  void store_telemetry_offline();
+
+  /// Duty cycle, measure-only wake: move buffered history into the RTC
+  /// batch (spilling to flash only if it is full; a mesh leaf drops the
+  /// oldest samples instead, it never uploads the flash log)
+  void batch_samples_in_rtc();
+
   /// Static cloud event handler (bridges ESP-IDF callback to member function)
   static void cloud_event_handler(void *arg, esp_event_base_t base,
                                   int32_t event_id, void *event_data);
 
-  /// Static network event handler (sets flags for deferred execution)
+  /// Static network event handler (posts cloud start / stop)
   static void network_event_handler(void *arg, esp_event_base_t base,
                                     int32_t event_id, void *event_data);
 
@@ -93,36 +302,117 @@ private:
   /// Handle device revocation
   void on_device_revoked();
 
+  /// ota_update command: validate the payload and start the download
+  cloud::CommandResult on_ota_command(std::string_view payload);
+
+  /// config_update command: merge, apply live and store the settings
+  cloud::CommandResult on_config_command(std::string_view payload);
+
+  /// Push effective_config() to the monitors, deadband filter and cloud
+  void apply_device_config();
+
+  /// device_config_ with its intervals stretched for the battery level
+  /// (and the upload interval for anomaly detection)
+  [[nodiscard]] cloud::DeviceConfig effective_config() const;
+
+  [[nodiscard]] sensor::DeadbandConfig deadband_config() const;
+
   Board &board_;
-  DataManager data_manager_;
+  /// Intervals and deadbands (build defaults until a config_update)
+  cloud::DeviceConfig device_config_;
+  /// Certs and BSEC config, read in place from flash (see open_blobs())
+  core::BlobPartition blobs_;
+  DataManager data_manager_{SENSOR_SLOTS};
+  /// Report-by-exception in front of the DataManager (off unless scaled up)
+  sensor::DeadbandFilter<sensor::sensor_type_count()> deadband_{data_manager_,
+                                                                {}};
+  /// Watches the raw samples in front of the deadband filter
+  sensor::AnomalyDetector<sensor::sensor_type_count()> anomaly_;
   SensorManager sensors_{data_manager_};
+  sensor::SensorScheduler scheduler_;
   power::DeepSleep sleep_;
   network::WifiManager wifi_;
 
+  /// Set on a fast boot (see resume_fast_boot())
+  std::optional<FastBootState> fast_boot_;
+  uint32_t boots_{0}; ///< Cold boots, counted in flash
+  SensorRegistry::Layout sensor_layout_{};
+  bool wifi_provisioned_{false};
+  bool cloud_provisioned_{false};
+  /// The board changed under the snapshot: the next wake boots cold
+  bool fast_boot_stale_{false};
+  /// Pins that woke this boot from deep sleep (0 = timer or cold boot)
+  uint64_t wake_pins_{0};
+  /// Latest battery classification (kept in RTC memory across sleeps)
+  std::atomic<power::BatteryLevel> battery_level_{power::BatteryLevel::Normal};
+
   /// Event subscriptions
-  core::EventSubscription sensor_event_sub_;
   core::EventSubscription cloud_event_sub_;
   core::EventSubscription network_event_sub_;
 
-  /// Deferred cloud operations (set by event, executed on main task)
-  std::atomic<bool> cloud_start_pending_{false};
-  std::atomic<bool> cloud_stop_pending_{false};
-  std::atomic<bool> device_info_pending_{false};
+  /// Owns the CloudManager: events and timers post CloudWork, it runs it
+  core::Worker cloud_worker_{{.name = "cloud",
+                              .stack_size = CLOUD_WORKER_STACK,
+                              .priority = 5}};
 
   /// Periodic logging timer
-  std::unique_ptr<core::PeriodicTimer> log_timer_;
+  core::WheelPeriodicTimer log_timer_{[this]() { on_log_timer(); }};
+
+  /// Duty cycle: forces deep sleep when a wake overruns
+  std::optional<core::OneShotTimer> awake_guard_;
+  /// Duty cycle: run_transmit() -> transmit()
+  core::BinarySemaphore transmit_done_;
+  std::atomic<bool> transmit_acked_{false};
+  bool transmit_pending_{false}; ///< Cloud worker only: waiting for auth
+  bool radio_started_{false};    ///< This wake brought WiFi up
+  /// An anomaly since the last acked upload (duty cycle: this wake
+  /// transmits; kept in RTC memory across sleeps)
+  std::atomic<bool> anomaly_pending_{false};
+  /// Cloud worker only: heap headroom around each cloud operation
+  core::HeapWatchdog heap_watchdog_;
+  /// Work skipped by guard_heap(), re-posted by defer_timer_
+  std::atomic<uint32_t> deferred_work_{0};
+  std::chrono::milliseconds defer_delay_{CLOUD_DEFER_MIN}; ///< Cloud worker
+  core::OneShotTimer defer_timer_{
+      [this] { cloud_worker_.post(deferred_work_.exchange(0)); }};
+  /// Cloud worker only: esp_timer time of the last record_metrics()
+  std::optional<int64_t> metrics_recorded_us_;
 
   // Monitors (owned by app, registered with manager)
   // Using optional for deferred initialization
-  using TimestampMonitor = sensor::SensorMonitor<TimestampSensor>;
   using BME680Monitor =
       sensor::ExternallyTimedMonitor<sensor::bme680::BME680Sensor>;
 
-  std::optional<TimestampMonitor> timestamp_monitor_;
   std::optional<BME680Monitor> bme680_monitor_;
 
+  using BatteryMonitor =
+      sensor::SensorMonitor<sensor::battery::BatterySensor>;
+
+  /// Cell voltage (board without a divider: readings read as no cell)
+  std::optional<BatteryMonitor> battery_monitor_;
+
+  using SimMonitor = sensor::ExternallyTimedMonitor<sensor::sim::SimSensor>;
+
+  /// Synthetic load (app::config::sim)
+  std::optional<SimMonitor> sim_monitor_;
+
   /// Cloud connectivity (optional - device may not be provisioned)
   std::optional<cloud::CloudManager> cloud_;
+
+  /// Local cluster link (app::config::mesh: leaf or aggregator only)
+  std::optional<transport::EspNowTransport> mesh_;
+  /// Aggregator: the leaves' samples into cloud_'s outbox, on a task
+  std::optional<cloud::MeshRelay> mesh_relay_;
+  std::optional<core::StaticTask<MESH_RELAY_STACK>> mesh_relay_task_;
+
+  /// Flash copy of the RTC auth token, so cold boots can skip re-auth
+  std::optional<core::RtcMirror<core::RtcAuthToken>> token_mirror_;
+
+  /// Telemetry that could not be sent, replayed once authenticated
+  cloud::TelemetryLog telemetry_log_;
+
+  /// Firmware updates pushed with the ota_update command
+  cloud::OtaUpdater ota_;
 };
 
 } // namespace application
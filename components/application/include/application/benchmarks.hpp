@@ -0,0 +1,26 @@
+/**
+ * @file benchmarks.hpp
+ * @brief On-device benchmarks of the encode, parse, crypto and BSEC paths
+ *
+ * With CONFIG_CORE_BENCH, main runs them at boot, before the board and
+ * WiFi come up. Each kernel is timed with core::bench (CPU cycles, mean
+ * and p99) and logs one line:
+ *
+ *   I (812) bench: BENCH encode_batch/32 iters=200 cyc_mean=7712
+ *                  cyc_p99=7790 cyc_max=11904 ns_op=48210 bytes=214
+ *                  allocs=0
+ *
+ * The line format is stable, so a rig that flashes each commit can grep
+ * the console for "BENCH " and compare the figures across builds (IRAM
+ * placement, -Os vs -O2). There is no host build yet to run them in CI
+ * (TODO, Phase 8.1).
+ */
+
+#pragma once
+
+namespace application {
+
+/// Register every benchmark kernel, run them and log the results
+void run_benchmarks();
+
+} // namespace application
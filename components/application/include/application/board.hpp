@@ -9,6 +9,7 @@
 #pragma once
 
 #include <i2c/i2c.hpp>
+#include <spi/spi.hpp>
 
 #include <memory>
 
@@ -19,6 +20,10 @@ struct BoardConfig {
   gpio_num_t i2c_sda = GPIO_NUM_NC;
   gpio_num_t i2c_scl = GPIO_NUM_NC;
   uint32_t i2c_freq_hz = 100000;
+  size_t i2c_queue_depth = 0; ///< >0: asynchronous I2C transfers
+  gpio_num_t spi_sclk = GPIO_NUM_NC; ///< NC: no SPI bus
+  gpio_num_t spi_mosi = GPIO_NUM_NC;
+  gpio_num_t spi_miso = GPIO_NUM_NC;
 };
 
 /// Board hardware abstraction - owns all peripherals
@@ -41,9 +46,13 @@ public:
   [[nodiscard]] driver::i2c::Master &i2c() { return *i2c_; }
   [[nodiscard]] const driver::i2c::Master &i2c() const { return *i2c_; }
 
+  /// Get SPI bus (nullptr if the board has none or it failed to start)
+  [[nodiscard]] driver::spi::Master *spi() { return spi_.get(); }
+
 private:
   bool valid_ = false;
   std::unique_ptr<driver::i2c::Master> i2c_;
+  std::unique_ptr<driver::spi::Master> spi_;
 };
 
 } // namespace application
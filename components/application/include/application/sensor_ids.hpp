@@ -7,8 +7,9 @@
  *
  * Usage:
  *   1. Add your sensor to the SensorId enum (before Count)
- *   2. Implement ISensor::id() in your sensor to return the new ID
- *   3. Register the monitor with SensorManager
+ *   2. Add it to SENSOR_SLOTS (app.hpp) when the build registers it
+ *   3. Implement ISensor::id() in your sensor to return the new ID
+ *   4. Register the monitor with SensorManager
  */
 
 #pragma once
@@ -26,19 +27,22 @@ inline constexpr size_t MAX_MEASUREMENTS_PER_SENSOR = 16;
 /**
  * Application-specific sensor identifiers.
  *
- * Add new sensors here. The underlying uint8_t value is used for
- * array indexing in DataManager, so keep values contiguous starting from 0.
+ * Add new sensors here. DataManager finds a sensor's slot through
+ * SENSOR_SLOTS, which holds only the sensors a build registers (a monitor
+ * without a slot fails to register); the deadband filter and anomaly detector still index
+ * by the underlying uint8_t value, so keep values contiguous from 0.
  *
- * Count must always be the last entry - it's used to size arrays.
+ * Count must always be the last entry - it sizes those per-ID arrays.
  */
 enum class SensorId : uint8_t {
-  Timestamp = 0,
-  BME680 = 1,
+  BME680 = 0,
+  Battery = 1,
+  Events = 2, ///< Wake events and profile, recorded by the application
+  Sim = 3,    ///< Synthetic load (app::config::sim), off by default
   // Add new sensors here...
-  // HDC2010 = 2,
-  // ADC = 3,
+  // HDC2010 = 4,
 
-  Count // Must be last - used for array sizing
+  Count // Must be last - number of IDs
 };
 
 /// Convert SensorId to array index
@@ -4,6 +4,16 @@
  */
 
 #include <application/app.hpp>
+#include <core/clock.hpp>
+#include <core/deferred_log.hpp>
+#include <core/fault.hpp>
+#include <core/lock_stats.hpp>
+#include <core/metrics.hpp>
+#include <core/task_registry.hpp>
+#include <core/wake_profile.hpp>
+#include <network/dns_cache.hpp>
+#include <network/sntp.hpp>
+#include <power/pm.hpp>
 #include <sensor/log.hpp>
 
 #include "app_config.hpp"
@@ -11,17 +21,88 @@
 #include <esp_app_desc.h>
 #include <esp_attr.h>
 #include <esp_log.h>
+#include <esp_rtc_time.h>
 #include <esp_system.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cinttypes>
 #include <span>
+#include <utility>
 
 namespace {
 
 /// RTC memory for auth token
 RTC_DATA_ATTR core::RtcAuthToken g_rtc_auth_token;
+RTC_DATA_ATTR core::RtcMirrorState g_rtc_auth_token_mirror;
+
+/// Hash of the last device info the backend accepted (skips repeats)
+RTC_DATA_ATTR core::RtcValue<uint32_t> g_rtc_device_info_hash;
+
+/// Setup of the previous wake (see MeasurementProbe::resume_fast_boot)
+RTC_DATA_ATTR core::RtcValue<application::FastBootState> g_rtc_fast_boot;
+
+/// Duty cycle: the last upload the backend accepted
+struct UploadRecord {
+  int64_t rtc_us; ///< RTC clock (keeps running in deep sleep)
+  bool alert;     ///< Alert condition it reported
+};
+RTC_DATA_ATTR core::RtcValue<UploadRecord> g_rtc_last_upload;
+
+/// Duty cycle: samples of the wakes since the last upload
+RTC_DATA_ATTR cloud::RtcSampleBuffer<
+    app::config::duty_cycle::RTC_BATCH_MEASUREMENTS>
+    g_rtc_samples;
+
+/// Duty cycle: time per phase of the last wake that transmitted, and of
+/// the last one that didn't (reported by the next wake that uploads)
+RTC_DATA_ATTR core::RtcValue<core::WakeProfile> g_rtc_profile_transmit;
+RTC_DATA_ATTR core::RtcValue<core::WakeProfile> g_rtc_profile_measure;
+
+/// Battery level of the last reading (hysteresis continues across sleeps)
+RTC_DATA_ATTR core::RtcValue<power::BatteryLevel> g_rtc_battery_level;
+
+/// Duty cycle: moving averages of the anomaly detector
+using AnomalyState =
+    sensor::AnomalyDetector<sensor::sensor_type_count()>::State;
+RTC_DATA_ATTR core::RtcValue<AnomalyState> g_rtc_anomaly;
+/// Duty cycle: an anomaly not yet in an acked upload
+RTC_DATA_ATTR core::RtcValue<bool> g_rtc_anomaly_pending;
+
+/// Duty cycle: sensor sample counts of the wakes since the last metrics
+/// sample (a measure-only wake doesn't record one)
+RTC_DATA_ATTR core::RtcValue<core::SampleCounts> g_rtc_sample_counts;
+
+/// Rates must span deep sleep: the RTC clock keeps running through it
+[[nodiscard]] int64_t rtc_ms() {
+  return static_cast<int64_t>(esp_rtc_get_time_us() / 1000);
+}
+
+constexpr power::BatteryPolicy BATTERY_POLICY{
+    .low_v = app::config::battery::LOW_V,
+    .critical_v = app::config::battery::CRITICAL_V,
+    .shutdown_v = app::config::battery::SHUTDOWN_V,
+    .hysteresis_v = app::config::battery::HYSTERESIS_V,
+    .low_stretch = app::config::battery::LOW_STRETCH,
+    .critical_stretch = app::config::battery::CRITICAL_STRETCH,
+};
+
+[[nodiscard]] cloud::DeviceConfig default_device_config() {
+  namespace config = app::config;
+  return {
+      .sample_interval_s = config::SENSOR_SAMPLE_INTERVAL_SEC,
+      .upload_interval_s = config::cloud::TELEMETRY_BATCH_WINDOW_SEC,
+      .poll_interval_s = config::cloud::COMMAND_POLL_INTERVAL_MIN * 60U,
+      .poll_max_interval_s =
+          config::cloud::COMMAND_POLL_MAX_INTERVAL_MIN * 60U,
+      .deadband_heartbeat_s = config::DEADBAND_HEARTBEAT_SEC,
+      .deadband_percent = config::DEADBAND_PERCENT,
+  };
+}
 
 } // namespace
 
@@ -29,20 +110,80 @@ namespace application {
 
 MeasurementProbe::MeasurementProbe(Board &board,
                                    std::chrono::seconds sleep_interval)
-    : board_(board), sleep_(sleep_interval) {}
+    : board_(board), device_config_(default_device_config()),
+      anomaly_(deadband_, app::config::anomaly::RULES,
+               {
+                   .alpha = app::config::anomaly::ALPHA,
+                   .warmup = app::config::anomaly::WARMUP_SAMPLES,
+                   .now_ms = rtc_ms,
+               }),
+      sleep_(sleep_interval),
+      heap_watchdog_({
+          .low_block = app::config::heap::LOW_BLOCK,
+          .critical_block = app::config::heap::CRITICAL_BLOCK,
+          .critical_limit = app::config::heap::CRITICAL_LIMIT,
+      }) {}
 
 void MeasurementProbe::run() {
   log_boot_info();
-  track_boot_count();
+  if constexpr (app::config::sensor_events::DEDICATED_LOOP) {
+    // Before anything subscribes to SENSOR_EVENTS
+    namespace config = app::config::sensor_events;
+    if (auto err = core::EventBus::create_loop(
+            SENSOR_EVENTS, {.name = "sensor_evt",
+                            .queue_size = config::QUEUE_SIZE,
+                            .priority = config::PRIORITY,
+                            .stack_size = config::STACK_SIZE});
+        err != ESP_OK) {
+      ESP_LOGW(TAG, "Sensor event loop: %s", esp_err_to_name(err));
+    }
+  }
+  // Restores the wall clock after deep sleep, syncs on WiFi connect
+  network::sntp().configure({
+      .server = app::config::ntp::SERVER,
+      .max_error_ms = app::config::ntp::MAX_ERROR_MS,
+  });
+  if constexpr (app::config::mesh::ROLE == app::config::mesh::Role::Leaf) {
+    // Never synced: stamp samples with the RTC clock, which runs through
+    // deep sleep; the aggregator re-stamps them (see cloud::MeshRelay)
+    if (!core::clock::is_synced()) {
+      core::clock::set_epoch_ms(rtc_ms());
+    }
+  }
+  network::dns_cache().configure({.ttl_s = app::config::DNS_CACHE_TTL_SEC});
+  wake_pins_ = power::gpio_wake_pins();
+  if constexpr (app::config::wake::GPIO_WAKE) {
+    if (uint32_t glitches = power::take_filtered_wakes(); glitches != 0) {
+      ESP_LOGI(TAG, "Slept through %" PRIu32 " GPIO glitch(es)", glitches);
+    }
+  }
+  if constexpr (app::config::AUTO_LIGHT_SLEEP) {
+    (void)power::enable_auto_light_sleep();
+  }
+  bool fast = resume_fast_boot();
+  if (!fast) {
+    track_boot_count();
+  }
 
   if (!board_.valid()) {
     ESP_LOGE(TAG, "Board not valid, halting");
     return;
   }
 
+  open_blobs();
+  if (!fast) {
+    load_device_config();
+  }
+  init_battery();
+
+  if constexpr (app::config::BSEC_DEEP_SLEEP_MODE) {
+    run_duty_cycle();
+  }
+
   init_wifi();
   init_sensors();
   init_cloud();
+  init_mesh();
 
   // All subsystems initialized
   core::events().publish(core::APP_EVENTS, core::AppEvent::StartupComplete);
@@ -58,21 +199,179 @@ void MeasurementProbe::log_boot_info() {
            power::to_string(wake));
 }
 
+bool MeasurementProbe::resume_fast_boot() {
+  auto wake = power::get_wake_reason();
+  if (!app::config::BSEC_DEEP_SLEEP_MODE ||
+      (wake != power::WakeReason::Timer && wake != power::WakeReason::Gpio) ||
+      !g_rtc_fast_boot.is_valid()) {
+    return false;
+  }
+
+  fast_boot_ = g_rtc_fast_boot.value;
+  ++fast_boot_->wakes;
+  boots_ = fast_boot_->boots;
+  device_config_ = fast_boot_->config;
+  wifi_provisioned_ = fast_boot_->wifi_provisioned;
+  cloud_provisioned_ = fast_boot_->cloud_provisioned;
+  // Until the next sleep saves it again: a wake that never gets there
+  // (crash, overrun guard) is followed by a cold boot
+  g_rtc_fast_boot.clear();
+
+  ESP_LOGI(TAG, "Fast boot: boot #%" PRIu32 ", wake #%" PRIu32, boots_,
+           fast_boot_->wakes);
+  return true;
+}
+
+void MeasurementProbe::save_fast_boot() {
+  if (fast_boot_stale_) {
+    g_rtc_fast_boot.clear();
+    return;
+  }
+  // A wake that left WiFi off keeps the last cache; one that could not
+  // connect drops it, so the next wake scans
+  network::FastConnect wifi{};
+  network::ApCache aps = wifi_.ap_cache();
+  int64_t leased_us = 0;
+  if (wifi_.is_connected()) {
+    wifi = network::FastConnect::from(wifi_.connection_info());
+    if (!wifi_.is_static_ip()) {
+      leased_us = static_cast<int64_t>(esp_rtc_get_time_us());
+    } else {
+      leased_us = fast_boot_->leased_us;
+      if (!transmit_acked_) {
+        // Maybe the address was given away: lease again next wake
+        wifi.forget_ip();
+      }
+    }
+  } else if (!radio_started_ && fast_boot_) {
+    wifi = fast_boot_->wifi;
+    aps = fast_boot_->aps;
+    leased_us = fast_boot_->leased_us;
+  }
+  g_rtc_fast_boot.set({
+      .leased_us = leased_us,
+      .boots = boots_,
+      .wakes = fast_boot_ ? fast_boot_->wakes : 0,
+      .config = device_config_,
+      .wifi = wifi,
+      .aps = aps,
+      .sensors = sensor_layout_,
+      .wifi_provisioned = wifi_provisioned_,
+      .cloud_provisioned = cloud_provisioned_,
+  });
+}
+
 void MeasurementProbe::track_boot_count() {
   auto &app_storage = storage(core::NamespaceId::App);
-  auto guard = app_storage.auto_commit();
   uint32_t boots = app_storage.get<uint32_t>("boots").value_or(0) + 1;
-  if (app_storage.set<uint32_t>("boots", boots)) {
+  boots_ = boots;
+  // Not worth holding up boot for: the worker writes it in the background
+  if (storage_worker().submit(app_storage,
+                              core::StorageWrite::value("boots", boots))) {
     ESP_LOGI(TAG, "Boot #%" PRIu32, boots);
   }
 }
 
+void MeasurementProbe::open_blobs() {
+  if (auto status = blobs_.open(); !status) {
+    ESP_LOGI(TAG, "No blob partition (%s), using built-in certs and config",
+             esp_err_to_name(status.error()));
+  }
+}
+
+void MeasurementProbe::load_device_config() {
+  core::ScopedPhase phase(core::WakePhase::Storage);
+  auto config = cloud::load_device_config(storage(core::NamespaceId::App));
+  if (!config) {
+    if (!core::is_not_found(config.error())) {
+      ESP_LOGW(TAG, "Stored config ignored: %s",
+               esp_err_to_name(config.error()));
+    }
+    return;
+  }
+  device_config_ = *config;
+  ESP_LOGI(TAG, "Using stored config (upload %" PRIu32 "s, poll %" PRIu32 "s)",
+           device_config_.upload_interval_s, device_config_.poll_interval_s);
+}
+
+void MeasurementProbe::init_battery() {
+  namespace config = app::config::battery;
+  if constexpr (!config::MONITOR) {
+    return;
+  }
+  if (g_rtc_battery_level.is_valid()) {
+    battery_level_ = g_rtc_battery_level.value;
+  }
+
+  battery_monitor_.emplace(
+      std::chrono::seconds(effective_config().sample_interval_s),
+      sensor::battery::BatterySensor::Config{
+          .pin = config::ADC_PIN,
+          .divider_ratio = config::VOLTAGE_DIVIDER_RATIO,
+          .sensor_id =
+              static_cast<sensor::SensorIdType>(sensor::SensorId::Battery),
+      });
+  if (!battery_monitor_->sensor().valid()) {
+    battery_monitor_.reset();
+    return;
+  }
+
+  // Registered with the other monitors in init_sensors()
+  auto volts = battery_monitor_->sensor().read_voltage();
+  if (!volts) {
+    ESP_LOGW(TAG, "Battery read failed: %s", esp_err_to_name(volts.error()));
+    return;
+  }
+  (void)update_battery_level(*volts);
+  ESP_LOGI(TAG, "Battery %.2f V (%s)", static_cast<double>(*volts),
+           power::to_string(battery_level_.load()));
+}
+
+bool MeasurementProbe::update_battery_level(float volts) {
+  auto previous = battery_level_.load();
+  auto level = power::classify_battery(BATTERY_POLICY, volts, previous);
+  if (level == previous) {
+    return false;
+  }
+  ESP_LOGW(TAG, "Battery %.2f V: %s -> %s", static_cast<double>(volts),
+           power::to_string(previous), power::to_string(level));
+  battery_level_ = level;
+  g_rtc_battery_level.set(level);
+  if (level == power::BatteryLevel::Shutdown) {
+    shutdown_on_low_battery(volts);
+  }
+  return true;
+}
+
+void MeasurementProbe::shutdown_on_low_battery(float volts) {
+  constexpr auto RECHECK =
+      std::chrono::seconds(app::config::battery::SHUTDOWN_RECHECK_SEC);
+  ESP_LOGE(TAG, "Battery empty (%.2f V), sleeping %llds before rechecking",
+           static_cast<double>(volts), static_cast<long long>(RECHECK.count()));
+  sensors_.stop_all();
+  // A few queued writes still fit; a WiFi TX burst might not
+  flush_storage();
+  core::dlog::flush();
+  power::DeepSleep::enter_for(RECHECK);
+}
+
 void MeasurementProbe::init_wifi() {
   // Configure WiFi manager
+  // A duty cycle gives up after a few attempts and tries on a later wake
+  constexpr bool DUTY_CYCLE = app::config::DUTY_CYCLE_MODE;
+  // Modem sleep would drop the frames of an aggregator's leaves
+  constexpr bool AGGREGATOR =
+      app::config::mesh::ROLE == app::config::mesh::Role::Aggregator;
   network::WifiConfig wifi_config{
-      .max_retries = app::config::WIFI_MAX_RETRIES,
+      .max_retries = DUTY_CYCLE ? app::config::duty_cycle::WIFI_MAX_RETRIES
+                                : app::config::WIFI_MAX_RETRIES,
       .initial_backoff_ms = 1000,
       .max_backoff_ms = 30000,
+      .give_up_out_of_range = DUTY_CYCLE,
+      .power_save = AGGREGATOR ? network::PowerSave::None
+                               : app::config::WIFI_POWER_SAVE,
+      .listen_interval = app::config::WIFI_LISTEN_INTERVAL,
+      .scan_mode = app::config::WIFI_SCAN_MODE,
   };
 
   // Initialize WiFi with storage from WiFi namespace
@@ -92,9 +391,27 @@ void MeasurementProbe::init_wifi() {
         on_wifi_state_change(old_state, new_state);
       });
 
-  // Check for stored credentials
-  if (wifi_.has_credentials()) {
+  // Check for stored credentials (a fast boot knows from the last wake)
+  if (!fast_boot_) {
+    wifi_provisioned_ = wifi_.has_credentials();
+  }
+  if (wifi_provisioned_) {
     ESP_LOGI(TAG, "Found stored WiFi credentials, connecting...");
+    // Provisioning won't run before the next reboot: BLE's DRAM is heap
+    (void)wifi_.release_ble();
+    if (fast_boot_) {
+      // The router doesn't see a renewal while we use the lease as a
+      // static IP: lease again before it could expire
+      auto cache = fast_boot_->wifi;
+      auto lease_age = std::chrono::microseconds(
+          static_cast<int64_t>(esp_rtc_get_time_us()) - fast_boot_->leased_us);
+      if (lease_age > std::chrono::seconds(
+                          app::config::WIFI_CACHED_LEASE_MAX_AGE_SEC)) {
+        cache.forget_ip();
+      }
+      wifi_.set_fast_connect(cache);
+      wifi_.set_ap_cache(fast_boot_->aps);
+    }
     if (auto err = wifi_.connect(); !err) {
       ESP_LOGW(TAG, "Connect failed: %s", esp_err_to_name(err.error()));
     }
@@ -125,13 +442,13 @@ void MeasurementProbe::on_wifi_state_change(network::WifiState old_state,
     auto info = wifi_.connection_info();
     ESP_LOGI(TAG, "Connected! IP: %d.%d.%d.%d, RSSI: %d dBm", info.ip[0],
              info.ip[1], info.ip[2], info.ip[3], info.rssi);
-    // Cloud start is deferred to main task via network_event_handler
+    // Cloud start is posted to the cloud worker by network_event_handler
     break;
   }
   case network::WifiState::Disconnected:
     ESP_LOGW(TAG, "WiFi disconnected");
-    // Cloud stop is deferred to main task
-    cloud_stop_pending_ = true;
+    // Cloud stop runs on the cloud worker
+    cloud_worker_.post(CLOUD_STOP);
     break;
   case network::WifiState::Provisioning:
     ESP_LOGI(TAG, "BLE provisioning active - use app to configure WiFi");
@@ -151,15 +468,22 @@ void MeasurementProbe::network_event_handler(void *arg,
   auto *self = static_cast<MeasurementProbe *>(arg);
   auto event = static_cast<network::NetworkEvent>(event_id);
 
-  // Just set flags - actual work happens on main task
+  // Just post work - it runs on the cloud worker
   switch (event) {
   case network::NetworkEvent::WifiConnected:
     ESP_LOGI(TAG, "Network event: WiFi connected - scheduling cloud start");
-    self->cloud_start_pending_ = true;
+    self->cloud_worker_.post(CLOUD_START);
     break;
   case network::NetworkEvent::WifiDisconnected:
     ESP_LOGI(TAG, "Network event: WiFi disconnected - scheduling cloud stop");
-    self->cloud_stop_pending_ = true;
+    self->cloud_worker_.post(CLOUD_STOP);
+    break;
+  case network::NetworkEvent::WifiConnectionFailed:
+    if constexpr (app::config::DUTY_CYCLE_MODE) {
+      // Sleep now instead of at TRANSMIT_TIMEOUT_SEC; the upload stays due
+      ESP_LOGW(TAG, "Network event: WiFi gave up - ending the transmit");
+      self->transmit_done_.give();
+    }
     break;
   default:
     break;
@@ -167,50 +491,172 @@ void MeasurementProbe::network_event_handler(void *arg,
 }
 
 void MeasurementProbe::init_sensors() {
-  // Subscribe to sensor data events (event-driven architecture)
-  sensor_event_sub_ =
-      core::events().subscribe(SENSOR_EVENTS, sensor::SensorEvent::DataReady,
-                               sensor_event_handler, this);
-
-  // Create and register timestamp sensor with 1s interval
-  timestamp_monitor_.emplace(std::chrono::seconds(1));
-  sensors_.register_monitor(*timestamp_monitor_);
+  // Monitors share one wakeup scheduler to coalesce timer interrupts
+  sensors_.set_scheduler(scheduler_);
+  deadband_.set_config(deadband_config());
+  if constexpr (app::config::anomaly::ENABLED) {
+    if (g_rtc_anomaly.is_valid()) {
+      anomaly_.restore(g_rtc_anomaly.value);
+    }
+    // Still due after a wake whose upload wasn't acked
+    if (g_rtc_anomaly_pending.is_valid() && g_rtc_anomaly_pending.value) {
+      anomaly_pending_ = true;
+    }
+    anomaly_.set_handler(
+        [this](const sensor::Anomaly &anomaly) { on_anomaly(anomaly); });
+    sensors_.set_pipeline(anomaly_);
+  } else {
+    sensors_.set_pipeline(deadband_);
+  }
 
-  // Create and register BME680 with externally-timed monitor (BSEC controls
-  // timing)
+  // Drivers for every sensor a board variant may carry; only chips found on
+  // the bus get a monitor
+  driver::i2c::DriverRegistry<> drivers;
+
+  // BME680/688 with externally-timed monitor (BSEC controls timing)
+  // The state lived in NVS before Bulk namespaces moved to LittleFS
+  if (auto status =
+          storage_manager_
+              .migrate_blob<sensor::bme680::BsecWrapper::STATE_SIZE>(
+                  core::NamespaceId::Bsec, core::BackendId::Nvs,
+                  sensor::bme680::BsecWrapper::STATE_KEY);
+      !status) {
+    ESP_LOGW(TAG, "BSEC state not moved from NVS: %s",
+             esp_err_to_name(status.error()));
+  }
   auto &bsec_storage = storage(core::NamespaceId::Bsec);
-  bme680_monitor_.emplace(board_.i2c(), bsec_storage,
-                          sensor::bme680::BME680Sensor::Config{
-                              .address = app::config::BME680_ADDRESS,
-                              .sensor_id = static_cast<sensor::SensorIdType>(
-                                  sensor::SensorId::BME680)});
-  sensors_.register_monitor(*bme680_monitor_);
+  init_bme680_spi(bsec_storage);
+  drivers.add("bme680", driver::bme680::CHIP_SIGNATURE,
+              [this, &bsec_storage](driver::i2c::IMaster &bus,
+                                    uint16_t address) {
+                if (bme680_monitor_) {
+                  return false; // One BME680 per board
+                }
+                bme680_monitor_.emplace(
+                    bus, bsec_storage,
+                    sensor::bme680::BME680Sensor::Config{
+                        .address = static_cast<uint8_t>(address),
+                        .sensor_id = static_cast<sensor::SensorIdType>(
+                            sensor::SensorId::BME680),
+                        .deep_sleep = app::config::BSEC_DEEP_SLEEP_MODE,
+                        .bsec_config = blobs_.find("bsec_config"),
+                        .writer = &storage_worker()});
+                return sensors_.register_monitor(*bme680_monitor_);
+              });
+
+  // A fast boot creates what the last cold boot found, without probing
+  if (fast_boot_) {
+    const auto &layout = fast_boot_->sensors;
+    size_t expected = 0;
+    for (uint8_t bits : layout) {
+      expected += static_cast<size_t>(std::popcount(bits));
+    }
+    if (drivers.attach(board_.i2c(), layout) != expected) {
+      ESP_LOGW(TAG, "Sensor missing since the last wake, rescanning next");
+      fast_boot_stale_ = true;
+    }
+  } else {
+    (void)drivers.discover(board_.i2c());
+  }
+  sensor_layout_ = drivers.layout();
+  if (battery_monitor_ && !sensors_.register_monitor(*battery_monitor_)) {
+    ESP_LOGW(TAG, "Battery monitor not registered");
+  }
+  init_sim();
+  (void)sensors_.set_sample_interval(
+      std::chrono::seconds(effective_config().sample_interval_s));
 
   ESP_LOGI(TAG, "Registered %zu sensor monitor(s)", sensors_.monitor_count());
 
   // Set up periodic logging timer (aggregates multiple sensor readings)
-  log_timer_ =
-      std::make_unique<core::PeriodicTimer>([this]() { on_log_timer(); });
-  [[maybe_unused]] auto status = log_timer_->start(std::chrono::seconds(10));
+  [[maybe_unused]] auto status = log_timer_.start(std::chrono::seconds(10));
 }
 
-void MeasurementProbe::sensor_event_handler(void *arg,
-                                            esp_event_base_t /*base*/,
-                                            int32_t event_id,
-                                            void *event_data) {
-  auto *self = static_cast<MeasurementProbe *>(arg);
-  if (event_id == static_cast<int32_t>(sensor::SensorEvent::DataReady) &&
-      event_data != nullptr) {
-    // ESP-IDF copies event data, so we need to reconstruct it
-    const auto *event =
-        static_cast<const sensor::SensorDataEvent *>(event_data);
-    self->on_sensor_data(*event);
+void MeasurementProbe::init_bme680_spi(core::IStorage &bsec_storage) {
+  if constexpr (app::config::BME680_SPI_CS == GPIO_NUM_NC) {
+    return;
+  }
+  auto *bus = board_.spi();
+  if (bus == nullptr) {
+    ESP_LOGW(TAG, "BME680_SPI_CS set but the board has no SPI bus");
+    return;
+  }
+  bme680_monitor_.emplace(
+      *bus, bsec_storage,
+      sensor::bme680::BME680Sensor::Config{
+          .spi_cs = app::config::BME680_SPI_CS,
+          .sensor_id =
+              static_cast<sensor::SensorIdType>(sensor::SensorId::BME680),
+          .deep_sleep = app::config::BSEC_DEEP_SLEEP_MODE,
+          .bsec_config = blobs_.find("bsec_config"),
+          .writer = &storage_worker()});
+  if (!bme680_monitor_->sensor().driver_open()) {
+    // Leaves the BME680 to the I2C discovery
+    ESP_LOGW(TAG, "No BME680 on SPI (CS=%d)",
+             static_cast<int>(app::config::BME680_SPI_CS));
+    bme680_monitor_.reset();
+    return;
+  }
+  if (!sensors_.register_monitor(*bme680_monitor_)) {
+    ESP_LOGW(TAG, "BME680 on SPI not registered");
+  }
+}
+
+void MeasurementProbe::init_sim() {
+  namespace config = app::config::sim;
+  static_assert(!config::ENABLED || !app::config::DUTY_CYCLE_MODE,
+                "The simulated sensor runs in continuous mode");
+  if constexpr (!config::ENABLED) {
+    return;
+  }
+  sim_monitor_.emplace(sensor::sim::SimSensor::Config{
+      .measurement_count = config::MEASUREMENTS,
+      .rate_hz = config::RATE_HZ,
+      .pattern = config::PATTERN,
+      .amplitude = config::AMPLITUDE,
+      .fail_every = config::FAIL_EVERY,
+      .sensor_id = static_cast<sensor::SensorIdType>(sensor::SensorId::Sim),
+  });
+  if (!sensors_.register_monitor(*sim_monitor_)) {
+    ESP_LOGW(TAG, "Simulated sensor not registered");
+    return;
   }
+  ESP_LOGW(TAG, "Simulated sensor: %u measurement(s) at %" PRIu32 " Hz (%s)",
+           config::MEASUREMENTS, config::RATE_HZ,
+           sensor::sim::to_string(config::PATTERN));
 }
 
-void MeasurementProbe::on_sensor_data(const sensor::SensorDataEvent &event) {
-  ESP_LOGD(TAG, "Sensor %u: %zu measurements ready", event.sensor_id,
-           event.count);
+void MeasurementProbe::on_sensor_data(uint32_t updated) {
+  data_manager_.for_each_sensor([&](sensor::SensorIdType id) {
+    if ((updated & data_manager_.bit(id)) != 0) {
+      CORE_DLOGD(TAG, "Sensor %u: new data (seq %" PRIu32 ")", id,
+                 data_manager_.sequence(id));
+    }
+  });
+
+  if (!app::config::DUTY_CYCLE_MODE && cloud_ &&
+      anomaly_pending_.exchange(false)) {
+    cloud_worker_.post(CLOUD_ANOMALY);
+  }
+
+  auto battery = static_cast<sensor::SensorIdType>(sensor::SensorId::Battery);
+  if ((updated & data_manager_.bit(battery)) == 0) {
+    return;
+  }
+  std::array<sensor::Measurement, MAX_MEASUREMENTS> buffer{};
+  auto sample = std::span(buffer.data(),
+                          data_manager_.read_into(battery, buffer));
+  auto volts = std::ranges::find(sample, sensor::MeasurementId::BatteryVoltage,
+                                 &sensor::Measurement::id);
+  if (volts == sample.end() || !update_battery_level(volts->to<float>())) {
+    return;
+  }
+  // CloudManager calls belong on the cloud worker
+  if (cloud_) {
+    cloud_worker_.post(CLOUD_APPLY_CONFIG);
+  } else {
+    apply_device_config();
+  }
 }
 
 void MeasurementProbe::on_log_timer() {
@@ -218,50 +664,546 @@ void MeasurementProbe::on_log_timer() {
   std::array<sensor::Measurement, MAX_MEASUREMENTS> buffer{};
   size_t count = sensors_.read_all_into(buffer);
   sensor::log_measurements(TAG, std::span(buffer.data(), count));
+  if (sim_monitor_) {
+    auto stats = sim_monitor_->sensor().stats();
+    ESP_LOGI(TAG, "Sim: %" PRIu32 " sample(s), %" PRIu32 " failed, %" PRIu32
+                  " missed",
+             stats.samples, stats.failures, stats.missed);
+  }
 
-  // Also send to cloud if connected
-  send_telemetry();
+  // Upload (or store offline) on the cloud worker, not the timer task
+  cloud_worker_.post(CLOUD_TELEMETRY);
 }
 
 void MeasurementProbe::run_continuous_mode() {
   ESP_LOGI(TAG, "Running - monitors sample independently, logging every 10s");
 
-  // Main loop - processes deferred operations on main task (large stack)
+  // Sensor data wakes this task directly via task notification
+  data_manager_.notifier().set_waiter(xTaskGetCurrentTaskHandle());
+
+  // Cloud work runs on its own task; this one only sleeps until data
   while (true) {
-    // Handle deferred cloud start (triggered by network event)
-    if (cloud_start_pending_.exchange(false)) {
-      ESP_LOGI(TAG, "Executing deferred cloud start on main task");
-      start_cloud();
+    if (uint32_t updated = data_manager_.notifier().wait()) {
+      on_sensor_data(updated);
     }
+  }
+}
 
-    // Handle deferred cloud stop (triggered by network event)
-    if (cloud_stop_pending_.exchange(false)) {
-      ESP_LOGI(TAG, "Executing deferred cloud stop on main task");
-      if (cloud_) {
-        cloud_->stop();
+void MeasurementProbe::run_duty_cycle() {
+  static_assert(!app::config::DUTY_CYCLE_MODE ||
+                    app::config::BSEC_DEEP_SLEEP_MODE,
+                "DUTY_CYCLE_MODE needs the Deep Sleep BSEC mode (tools/setup)");
+  namespace limits = app::config::duty_cycle;
+  constexpr bool TRANSMIT = app::config::DUTY_CYCLE_MODE;
+  constexpr bool MESH_LEAF =
+      app::config::mesh::ROLE == app::config::mesh::Role::Leaf;
+
+  // Last resort for a wedged driver or TLS session: this cycle's BSEC
+  // snapshot is lost, the device is not
+  awake_guard_.emplace([this]() {
+    ESP_LOGE(TAG, "Wake overran, forcing deep sleep");
+    arm_wake_sources();
+    core::dlog::flush(); // What led up to it
+    power::DeepSleep::enter_for(sleep_.interval());
+  });
+  (void)awake_guard_->start(std::chrono::seconds(limits::AWAKE_TIMEOUT_SEC));
+
+  auto phase = CyclePhase::Init;
+  while (true) {
+    switch (phase) {
+    case CyclePhase::Init:
+      init_sensors();
+      if (wake_pins_ != 0) {
+        record_wake_event();
       }
+      // A leaf keeps what it can't hand over in RTC memory, not flash
+      if constexpr (TRANSMIT && !MESH_LEAF) {
+        open_telemetry_log();
+        // Due whatever this sample shows: connect while we measure
+        bool was_alert =
+            g_rtc_last_upload.is_valid() && g_rtc_last_upload.value.alert;
+        if (auto reason = plan_transmit(was_alert);
+            reason != power::TransmitReason::None) {
+          start_radio(reason);
+        }
+      }
+      phase = CyclePhase::Measure;
+      break;
+
+    case CyclePhase::Measure:
+      // An event between BSEC deadlines is reported on its own
+      if (wake_pins_ != 0 && bme680_monitor_ &&
+          bme680_monitor_->sensor().next_sample_delay() >
+              std::chrono::seconds(limits::MEASURE_TIMEOUT_SEC)) {
+        ESP_LOGI(TAG, "Event wake, BSEC sample not due yet");
+      } else if (!wait_for_sample(
+                     std::chrono::seconds(limits::MEASURE_TIMEOUT_SEC))) {
+        ESP_LOGW(TAG, "No BSEC sample this cycle");
+      }
+      if constexpr (MESH_LEAF) {
+        // Every wake: a few frames, no association
+        phase = CyclePhase::Transmit;
+        break;
+      }
+      if constexpr (TRANSMIT) {
+        if (!radio_started_) {
+          auto reason = plan_transmit(alert_active());
+          if (reason == power::TransmitReason::None) {
+            // The sample waits in RTC memory for a wake that transmits
+            batch_samples_in_rtc();
+            ESP_LOGI(TAG,
+                     "Measure-only wake, %zu measurement(s) in RTC, ~%zu "
+                     "record(s) in flash",
+                     g_rtc_samples.size(), telemetry_log_.pending());
+            phase = CyclePhase::Sleep;
+            break;
+          }
+          start_radio(reason);
+        }
+      }
+      phase = TRANSMIT && cloud_ ? CyclePhase::Transmit : CyclePhase::Sleep;
+      break;
+
+    case CyclePhase::Transmit:
+      if constexpr (MESH_LEAF) {
+        send_to_aggregator();
+        phase = CyclePhase::Sleep;
+        break;
+      }
+      if (transmit(std::chrono::seconds(limits::TRANSMIT_TIMEOUT_SEC))) {
+        anomaly_pending_ = false;
+        g_rtc_last_upload.set({
+            .rtc_us = static_cast<int64_t>(esp_rtc_get_time_us()),
+            .alert = alert_active(),
+        });
+      } else {
+        ESP_LOGW(TAG, "Upload not acked, kept for the next cycle");
+        if (wifi_.is_connected()) {
+          // Maybe the backend moved: resolve it again next wake
+          network::dns_cache().clear();
+        }
+      }
+      if (ota_.state() == cloud::OtaState::Downloading) {
+        // The command poll started an update: finish it (it reboots)
+        ESP_LOGI(TAG, "Firmware update in progress - staying awake");
+        awake_guard_->stop();
+        while (ota_.state() == cloud::OtaState::Downloading) {
+          vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+      }
+      phase = CyclePhase::Sleep;
+      break;
+
+    case CyclePhase::Sleep:
+      sleep_until_next_cycle();
     }
+  }
+}
 
-    // Handle deferred device info update (triggered after auth)
-    if (device_info_pending_.exchange(false)) {
-      ESP_LOGI(TAG, "Sending device info to backend");
-      if (cloud_) {
-        const auto *app_desc = esp_app_get_description();
-        (void)cloud_->send_device_info(app_desc->project_name,
-                                       app_desc->version);
-      }
+power::TransmitReason MeasurementProbe::plan_transmit(bool alert) const {
+  using std::chrono::duration_cast;
+  using std::chrono::seconds;
+
+  auto config = effective_config();
+  power::CycleState state{
+      .since_upload = std::nullopt,
+      // Wakes follow the BSEC sample interval
+      .until_next_wake =
+          bme680_monitor_
+              ? duration_cast<seconds>(bme680_monitor_->sensor().min_interval())
+              : sleep_.interval(),
+      .pending = telemetry_log_.pending() + g_rtc_samples.size() +
+                 data_manager_.history_measurement_count(),
+      .alert = alert,
+      .was_alert = false,
+      .event = wake_pins_ != 0,
+      .anomaly = anomaly_pending_.load(),
+  };
+  if (g_rtc_last_upload.is_valid()) {
+    const auto &last = g_rtc_last_upload.value;
+    state.since_upload = duration_cast<seconds>(std::chrono::microseconds(
+        static_cast<int64_t>(esp_rtc_get_time_us()) - last.rtc_us));
+    state.was_alert = last.alert;
+  }
+  return power::plan_cycle(
+      {
+          .upload_interval = seconds(config.upload_interval_s),
+          .max_pending = app::config::duty_cycle::BACKLOG_UPLOAD_RECORDS,
+      },
+      state);
+}
+
+bool MeasurementProbe::alert_active() {
+  if (!bme680_monitor_) {
+    return false;
+  }
+  std::array<sensor::Measurement, MAX_MEASUREMENTS> buffer{};
+  size_t count = data_manager_.read_into(
+      static_cast<sensor::SensorIdType>(sensor::SensorId::BME680), buffer);
+  return std::ranges::any_of(
+      std::span(buffer.data(), count), [](const sensor::Measurement &m) {
+        return m.id == sensor::MeasurementId::IAQ &&
+               m.to<float>() >= app::config::duty_cycle::ALERT_IAQ;
+      });
+}
+
+void MeasurementProbe::on_anomaly(const sensor::Anomaly &anomaly) {
+  using sensor::MeasurementId;
+  const auto &meta =
+      sensor::MEASUREMENT_META.at(static_cast<size_t>(anomaly.id) - 1);
+  ESP_LOGW(TAG, "Anomaly on sensor %u: %s %.2f %s (%s %.1f)",
+           anomaly.sensor_id, meta.name, static_cast<double>(anomaly.value),
+           meta.unit, sensor::to_string(anomaly.kind),
+           static_cast<double>(anomaly.score));
+
+  std::array<sensor::Measurement, 2> sample{
+      sensor::make<MeasurementId::Anomaly>(
+          (static_cast<uint32_t>(anomaly.kind) << 16) |
+          (static_cast<uint32_t>(anomaly.sensor_id) << 8) |
+          static_cast<uint32_t>(anomaly.id)),
+      sensor::make<MeasurementId::AnomalyScore>(anomaly.score),
+  };
+  data_manager_.on_data(
+      static_cast<sensor::SensorIdType>(sensor::SensorId::Events), sample);
+
+  // Picked up once the sample is in the history: by on_sensor_data(), or
+  // by plan_transmit() on a duty-cycled wake
+  anomaly_pending_ = true;
+}
+
+void MeasurementProbe::save_anomaly_state() {
+  if constexpr (app::config::anomaly::ENABLED) {
+    g_rtc_anomaly.set(anomaly_.state());
+    // Cleared only by an acked transmit
+    g_rtc_anomaly_pending.set(anomaly_pending_.load());
+  }
+}
+
+void MeasurementProbe::record_wake_event() {
+  ESP_LOGI(TAG, "Woken by GPIO mask 0x%" PRIx64, wake_pins_);
+  auto event = sensor::make<sensor::MeasurementId::WakeEvent>(
+      static_cast<uint32_t>(wake_pins_));
+  data_manager_.on_data(
+      static_cast<sensor::SensorIdType>(sensor::SensorId::Events),
+      std::span(&event, 1));
+}
+
+void MeasurementProbe::arm_wake_sources() {
+  namespace config = app::config::wake;
+  if constexpr (!config::GPIO_WAKE) {
+    return;
+  }
+  constexpr uint64_t PINS = 1ULL << config::GPIO_PIN;
+  auto err = power::enable_gpio_wakeup(PINS, config::GPIO_LEVEL);
+  if (err == ESP_OK && config::FILTER_GLITCHES) {
+    power::install_wake_stub(PINS, config::GPIO_LEVEL);
+  } else if (err == ESP_ERR_INVALID_STATE) {
+    ESP_LOGI(TAG, "Wake pin still active, timer wake only");
+  } else if (err != ESP_OK) {
+    ESP_LOGW(TAG, "GPIO wake not armed: %s", esp_err_to_name(err));
+  }
+}
+
+void MeasurementProbe::record_wake_profile() {
+  using sensor::MeasurementId;
+  static_assert(static_cast<size_t>(MeasurementId::ProfileSleep) -
+                    static_cast<size_t>(MeasurementId::ProfileBoot) + 1 ==
+                core::WAKE_PHASE_COUNT);
+  constexpr auto MS = [](uint32_t us) { return us / 1000; };
+
+  std::array<sensor::Measurement, core::WAKE_PHASE_COUNT + 2> sample{};
+  size_t count = 0;
+  if (g_rtc_profile_transmit.is_valid()) {
+    const auto &profile = g_rtc_profile_transmit.value;
+    for (size_t i = 0; i < core::WAKE_PHASE_COUNT; ++i) {
+      sample.at(count++) = sensor::Measurement(
+          static_cast<MeasurementId>(
+              static_cast<size_t>(MeasurementId::ProfileBoot) + i),
+          MS(profile.phase_us.at(i)));
+    }
+    sample.at(count++) =
+        sensor::make<MeasurementId::ProfileAwake>(MS(profile.awake_us));
+  }
+  if (g_rtc_profile_measure.is_valid()) {
+    sample.at(count++) = sensor::make<MeasurementId::ProfileMeasureAwake>(
+        MS(g_rtc_profile_measure.value.awake_us));
+  }
+  g_rtc_profile_transmit.clear();
+  g_rtc_profile_measure.clear();
+  if (count == 0) {
+    return;
+  }
+  data_manager_.on_data(
+      static_cast<sensor::SensorIdType>(sensor::SensorId::Events),
+      std::span(sample.data(), count));
+}
+
+void MeasurementProbe::save_wake_profile() const {
+  core::end_phase(core::WakePhase::Sleep);
+  auto profile = core::wake_profile();
+  for (size_t i = 0; i < core::WAKE_PHASE_COUNT; ++i) {
+    ESP_LOGD(TAG, "Phase %s: %" PRIu32 " us",
+             core::to_string(static_cast<core::WakePhase>(i)),
+             profile.phase_us.at(i));
+  }
+  (radio_started_ ? g_rtc_profile_transmit : g_rtc_profile_measure)
+      .set(profile);
+}
+
+void MeasurementProbe::save_sample_counts() {
+  if constexpr (app::config::DUTY_CYCLE_MODE) {
+    auto counts = core::metrics().take_samples();
+    if (g_rtc_sample_counts.is_valid()) {
+      counts.add(g_rtc_sample_counts.value);
+    }
+    g_rtc_sample_counts.set(counts);
+  }
+}
+
+void MeasurementProbe::record_metrics() {
+  using sensor::MeasurementId;
+  auto metrics = core::metrics().take();
+  if (g_rtc_sample_counts.is_valid()) {
+    const auto &carried = g_rtc_sample_counts.value;
+    for (size_t i = 0; i < core::SampleCounts::kMaxSensors; ++i) {
+      metrics.samples.at(i) += carried.good.at(i);
+      metrics.sample_errors.at(i) += carried.failed.at(i);
+    }
+    g_rtc_sample_counts.clear();
+  }
+  const auto &latency = metrics.request_latency_ms;
+  const auto events =
+      static_cast<sensor::SensorIdType>(sensor::SensorId::Events);
+
+  std::array<sensor::Measurement, DataManager::MAX_MEASUREMENTS> sample{};
+  size_t count = 0;
+  auto put = [&sample, &count](const sensor::Measurement &m) {
+    sample.at(count++) = m;
+  };
+  put(sensor::make<MeasurementId::MetricTelemetryBytes>(
+      metrics.telemetry_bytes));
+  put(sensor::make<MeasurementId::MetricRequests>(metrics.requests));
+  put(sensor::make<MeasurementId::MetricRequestRetries>(
+      metrics.request_retries));
+  if (latency.count > 0) {
+    put(sensor::make<MeasurementId::MetricLatencyP50>(latency.p50));
+    put(sensor::make<MeasurementId::MetricLatencyP90>(latency.p90));
+    put(sensor::make<MeasurementId::MetricLatencyMax>(latency.max));
+  }
+  put(sensor::make<MeasurementId::MetricWifiRetries>(metrics.wifi_retries));
+  if (metrics.wifi_rssi_valid) {
+    put(sensor::make<MeasurementId::MetricWifiRssi>(metrics.wifi_rssi));
+  }
+  put(sensor::make<MeasurementId::MetricHeapMinFree>(metrics.heap_min_free));
+  put(sensor::make<MeasurementId::MetricHeapLargestBlock>(
+      metrics.heap_largest_block));
+  data_manager_.on_data(events, std::span(sample.data(), count));
+
+  // Three entries per sensor that sampled at all
+  count = 0;
+  size_t sensors = std::min(sensor::sensor_type_count(),
+                            core::MetricsSnapshot::kMaxSensors);
+  for (size_t id = 0; id < sensors && count + 3 <= sample.size(); ++id) {
+    uint32_t good = metrics.samples.at(id);
+    uint32_t failed = metrics.sample_errors.at(id);
+    if (good == 0 && failed == 0) {
+      continue;
+    }
+    put(sensor::make<MeasurementId::MetricSensor>(static_cast<uint8_t>(id)));
+    put(sensor::make<MeasurementId::MetricSamples>(good));
+    put(sensor::make<MeasurementId::MetricSampleErrors>(failed));
+  }
+  if (count > 0) {
+    data_manager_.on_data(events, std::span(sample.data(), count));
+  }
+}
+
+void MeasurementProbe::start_radio(power::TransmitReason reason) {
+  ESP_LOGI(TAG, "Transmitting this wake (%s)", power::to_string(reason));
+  radio_started_ = true;
+  if constexpr (app::config::duty_cycle::REPORT_WAKE_PROFILE) {
+    record_wake_profile();
+  }
+  init_wifi(); // Connects in the background
+  init_cloud();
+  if (!wifi_provisioned_) {
+    // BLE provisioning needs the device awake
+    ESP_LOGW(TAG, "WiFi not provisioned - staying awake");
+    awake_guard_->stop();
+    core::events().publish(core::APP_EVENTS, core::AppEvent::StartupComplete);
+    run_continuous_mode();
+  }
+}
+
+bool MeasurementProbe::wait_for_sample(std::chrono::milliseconds timeout) {
+  if (!bme680_monitor_) {
+    return false;
+  }
+  core::ScopedPhase phase(core::WakePhase::Bsec);
+
+  // The monitor fires at the deadline restored from RTC memory
+  auto &notifier = data_manager_.notifier();
+  notifier.set_waiter(xTaskGetCurrentTaskHandle());
+  auto bit = data_manager_.bit(
+      static_cast<sensor::SensorIdType>(sensor::SensorId::BME680));
+  int64_t deadline = core::clock::monotonic_ms() + timeout.count() +
+                     std::chrono::duration_cast<std::chrono::milliseconds>(
+                         bme680_monitor_->sensor().next_sample_delay())
+                         .count();
+  while ((notifier.wait(std::chrono::milliseconds(100)) & bit) == 0) {
+    if (core::clock::monotonic_ms() >= deadline) {
+      return false;
+    }
+  }
+
+  std::array<sensor::Measurement, MAX_MEASUREMENTS> buffer{};
+  size_t count = data_manager_.read_into(
+      static_cast<sensor::SensorIdType>(sensor::SensorId::BME680), buffer);
+  sensor::log_measurements<sensor::bme680::BME680Layout>(
+      TAG, std::span(buffer.data(), count));
+  return true;
+}
+
+bool MeasurementProbe::transmit(std::chrono::milliseconds timeout) {
+  (void)transmit_done_.try_take(); // Late give from an earlier attempt
+  transmit_acked_ = false;
+  cloud_worker_.post(CLOUD_TRANSMIT);
+  return transmit_done_.take_for(timeout) && transmit_acked_.load();
+}
+
+void MeasurementProbe::init_mesh() {
+  namespace mesh = app::config::mesh;
+  static_assert(mesh::ROLE != mesh::Role::Leaf || app::config::DUTY_CYCLE_MODE,
+                "A mesh leaf sleeps between samples (DUTY_CYCLE_MODE)");
+  static_assert(mesh::ROLE != mesh::Role::Aggregator ||
+                    !app::config::BSEC_DEEP_SLEEP_MODE,
+                "A mesh aggregator listens all the time (continuous mode)");
+  if (mesh::ROLE == mesh::Role::Off || mesh_) {
+    return;
+  }
+
+  if constexpr (mesh::ROLE == mesh::Role::Leaf) {
+    // The driver only: no scan, no association
+    if (auto status = wifi_.init(storage(core::NamespaceId::Wifi), {});
+        !status) {
+      ESP_LOGE(TAG, "WiFi init failed: %s", esp_err_to_name(status.error()));
+      return;
+    }
+    mesh_.emplace(transport::EspNowTransportConfig{
+        .peer = mesh::AGGREGATOR_MAC,
+        .channel = mesh::CHANNEL,
+    });
+  } else {
+    // Follows the AP's channel once associated
+    mesh_.emplace(transport::EspNowTransportConfig{.senders = mesh::LEAVES});
+  }
+  if (auto status = mesh_->connect(); !status) {
+    ESP_LOGE(TAG, "ESP-NOW start failed: %s", esp_err_to_name(status.error()));
+    mesh_.reset();
+    return;
+  }
+
+  if constexpr (mesh::ROLE == mesh::Role::Aggregator) {
+    if (!cloud_) {
+      ESP_LOGW(TAG, "Cloud disabled - not relaying for the cluster");
+      return;
+    }
+    mesh_relay_.emplace(*mesh_, *cloud_);
+    mesh_relay_task_.emplace([this]() { run_mesh_relay(); },
+                             core::StaticTaskConfig{.name = "mesh_relay",
+                                                    .priority = 4});
+    ESP_LOGI(TAG, "Relaying for the cluster");
+  }
+}
+
+void MeasurementProbe::send_to_aggregator() {
+  core::ScopedPhase phase(core::WakePhase::Upload);
+  batch_samples_in_rtc();
+  if (g_rtc_samples.empty()) {
+    return;
+  }
+
+  init_mesh();
+  if (!mesh_) {
+    return;
+  }
+  size_t count = g_rtc_samples.size();
+  if (auto status = cloud::send_mesh_records(*mesh_, g_rtc_samples.records());
+      !status) {
+    ESP_LOGW(TAG, "Aggregator unreachable (%s), %zu measurement(s) kept",
+             esp_err_to_name(status.error()), count);
+    return;
+  }
+  g_rtc_samples.clear();
+  ESP_LOGI(TAG, "Handed %zu measurement(s) to the aggregator", count);
+}
+
+void MeasurementProbe::run_mesh_relay() {
+  while (true) {
+    auto status = mesh_relay_->relay_one(std::chrono::seconds(60));
+    if (status) {
+      // CloudManager belongs to the cloud worker: it queues the samples
+      cloud_worker_.post(CLOUD_RELAY);
+    } else if (status.error() == ESP_ERR_NO_MEM) {
+      ESP_LOGW(TAG, "Relay inbox full, %" PRIu32 " sample(s) dropped so far",
+               mesh_relay_->dropped());
+      cloud_worker_.post(CLOUD_RELAY);
     }
+  }
+}
+
+void MeasurementProbe::sleep_until_next_cycle() {
+  // Wake this much before the BSEC deadline to cover boot time; the
+  // monitor then waits out the remainder at full accuracy
+  constexpr auto WAKE_MARGIN = std::chrono::milliseconds(500);
+
+  core::begin_phase(core::WakePhase::Sleep);
+  if (!bme680_monitor_) {
+    ESP_LOGW(TAG, "No BSEC sensor, sleeping %llds",
+             static_cast<long long>(sleep_.interval().count()));
+    save_fast_boot();
+    save_anomaly_state();
+    save_sample_counts();
+    flush_storage();
+    save_wake_profile();
+    arm_wake_sources();
+    core::dlog::flush(); // After the profile: its printing isn't timed
+    sleep_.enter();
+  }
 
-    // Sleep briefly, then check again
-    vTaskDelay(pdMS_TO_TICKS(100));
+  bme680_monitor_->stop();
+  auto &bme680 = bme680_monitor_->sensor();
+  if (auto status = bme680.prepare_for_sleep(); !status) {
+    ESP_LOGW(TAG, "BSEC RTC snapshot failed: %s",
+             esp_err_to_name(status.error()));
   }
+
+  auto delay = bme680.next_sample_delay() -
+               std::chrono::duration_cast<std::chrono::microseconds>(
+                   WAKE_MARGIN);
+  ESP_LOGI(TAG, "Deep sleep for %lld ms until next BSEC call (awake %lld ms)",
+           static_cast<long long>(
+               std::chrono::duration_cast<std::chrono::milliseconds>(delay)
+                   .count()),
+           static_cast<long long>(core::clock::monotonic_ms()));
+  save_fast_boot();
+  save_anomaly_state();
+  save_sample_counts();
+  flush_storage(); // Queued writes and cached namespaces
+  save_wake_profile();
+  arm_wake_sources();
+  core::dlog::flush();
+  power::DeepSleep::enter_for(delay);
 }
 
 void MeasurementProbe::init_cloud() {
   auto &creds_storage = storage(core::NamespaceId::Cloud);
 
-  // Check if device is provisioned
-  if (!cloud::is_provisioned(creds_storage)) {
+  // Check if device is provisioned (a fast boot knows from the last wake)
+  if (!fast_boot_) {
+    cloud_provisioned_ = cloud::is_provisioned(creds_storage);
+  }
+  if (!cloud_provisioned_) {
     ESP_LOGW(TAG, "Device not provisioned - cloud disabled");
     return;
   }
@@ -270,13 +1212,31 @@ void MeasurementProbe::init_cloud() {
   cloud_event_sub_ = core::events().subscribe(
       cloud::CLOUD_EVENTS, ESP_EVENT_ANY_ID, cloud_event_handler, this);
 
+  // After a power loss the token is gone from RTC memory; take the flash
+  // copy (the server rejects it if it has expired meanwhile)
+  token_mirror_.emplace(g_rtc_auth_token, g_rtc_auth_token_mirror,
+                        creds_storage, "auth_token");
+  token_mirror_->restore();
+
+  auto config = effective_config();
   cloud::CloudManagerConfig cloud_config{
       .telemetry_interval =
           std::chrono::minutes(app::config::cloud::TELEMETRY_INTERVAL_MIN),
-      .command_poll_interval =
-          std::chrono::minutes(app::config::cloud::COMMAND_POLL_INTERVAL_MIN),
+      .command_poll_interval = std::chrono::seconds(config.poll_interval_s),
+      .command_poll_max_interval =
+          std::chrono::seconds(config.poll_max_interval_s),
+      .command_long_poll =
+          std::chrono::seconds(app::config::cloud::COMMAND_LONG_POLL_SEC),
       .skip_cert_verify = app::config::cloud::SKIP_CERT_VERIFY,
+      .ca_cert = blobs_.text("ca_cert"),
+      .client_cert = blobs_.text("client_cert"),
+      .client_key = blobs_.text("client_key"),
+      .jwt_key = blobs_.text("device_key"),
+      .piggyback_commands = app::config::cloud::PIGGYBACK_COMMANDS,
+      .wire_encoding = app::config::cloud::WIRE_ENCODING,
   };
+  cloud_config.outbox.batch_window =
+      std::chrono::seconds(config.upload_interval_s);
 
   cloud_.emplace(creds_storage, g_rtc_auth_token, cloud_config);
 
@@ -286,15 +1246,223 @@ void MeasurementProbe::init_cloud() {
     return;
   }
 
+  cloud_->on_command(cloud::CommandType::OtaUpdate,
+                     [this](std::string_view payload) {
+                       return on_ota_command(payload);
+                     });
+  cloud_->on_command(cloud::CommandType::ConfigUpdate,
+                     [this](std::string_view payload) {
+                       return on_config_command(payload);
+                     });
+
+  // Timer-driven polls and token refreshes run on the worker as well
+  cloud_->set_dispatcher([this](cloud::CloudWork work) {
+    cloud_worker_.post(work == cloud::CloudWork::PollCommands
+                           ? CLOUD_POLL_COMMANDS
+                           : CLOUD_REFRESH_TOKEN);
+  });
+  if (auto status = cloud_worker_.start(
+          [this](uint32_t work) { run_cloud_work(work); });
+      !status) {
+    ESP_LOGE(TAG, "Cloud worker start failed: %s",
+             esp_err_to_name(status.error()));
+    cloud_.reset();
+    return;
+  }
+
+  open_telemetry_log();
+
   ESP_LOGI(TAG, "Cloud services initialized");
 }
 
+void MeasurementProbe::open_telemetry_log() {
+  if (telemetry_log_.is_ready()) {
+    return;
+  }
+  if (auto status = telemetry_log_.init(); !status) {
+    ESP_LOGW(TAG, "Offline telemetry log unavailable: %s",
+             esp_err_to_name(status.error()));
+  }
+}
+
+void MeasurementProbe::run_cloud_work(uint32_t work) {
+  if (!cloud_) {
+    return;
+  }
+
+  // Stop before start: a disconnect followed by a reconnect ends connected
+  if ((work & CLOUD_STOP) != 0) {
+    ESP_LOGI(TAG, "Stopping cloud");
+    cloud_->stop();
+    deferred_work_ &= ~CLOUD_START; // Left for the next connect
+  }
+  work &= ~CLOUD_STOP;
+
+  // Only moves samples into the outbox: no network, no heap guard
+  if ((work & CLOUD_RELAY) != 0 && mesh_relay_) {
+    if (auto status = mesh_relay_->forward(); !status) {
+      // The outbox is full: upload it instead of dropping more
+      ESP_LOGW(TAG, "Outbox full, %" PRIu32 " relayed sample(s) dropped so far",
+               mesh_relay_->dropped());
+      work |= CLOUD_TELEMETRY;
+    }
+  }
+  work &= ~CLOUD_RELAY;
+  if (work == 0) {
+    return;
+  }
+
+  // Everything below may need a TLS handshake
+  if (!guard_heap("cloud work")) {
+    if ((work & CLOUD_TRANSMIT) != 0) {
+      // Kept for the next wake; transmit() stops waiting on it now
+      store_telemetry_offline();
+      (void)telemetry_log_.flush();
+      transmit_acked_ = false;
+      transmit_done_.give();
+      work &= ~CLOUD_TRANSMIT;
+    }
+    defer_cloud_work(work);
+    return;
+  }
+  defer_delay_ = CLOUD_DEFER_MIN;
+
+  if ((work & CLOUD_START) != 0 && wifi_.is_connected()) {
+    ESP_LOGI(TAG, "Starting cloud");
+    core::ScopedHeapTrace trace("cloud start");
+    start_cloud();
+  }
+
+  // Triggered after auth
+  if ((work & CLOUD_DEVICE_INFO) != 0) {
+    core::ScopedHeapTrace trace("device info");
+    report_device_info();
+  }
+  if ((work & CLOUD_APPLY_CONFIG) != 0) {
+    apply_device_config();
+  }
+
+  if ((work & CLOUD_REFRESH_TOKEN) != 0) {
+    core::ScopedHeapTrace trace("token refresh");
+    cloud_->run(cloud::CloudWork::RefreshToken);
+  }
+  if ((work & (CLOUD_TELEMETRY | CLOUD_ANOMALY)) != 0) {
+    core::ScopedHeapTrace trace("telemetry");
+    send_telemetry();
+  }
+  if ((work & CLOUD_ANOMALY) != 0 && cloud_->is_connected()) {
+    // The anomaly and the routine batch it sits in go out now
+    cloud_->service_outbox(true);
+  }
+  if ((work & CLOUD_POLL_COMMANDS) != 0) {
+    core::ScopedHeapTrace trace("commands");
+    cloud_->run(cloud::CloudWork::PollCommands);
+  }
+
+  if ((work & CLOUD_TRANSMIT) != 0) {
+    // Samples go to flash before any network wait: what isn't acked
+    // before the device sleeps goes out next cycle
+    store_telemetry_offline();
+    (void)telemetry_log_.flush();
+    transmit_pending_ = true;
+  }
+  if (transmit_pending_ && cloud_->is_connected()) {
+    transmit_pending_ = false;
+    run_transmit();
+  }
+
+  // A tight heap gets the idle connection's TLS buffers back until the
+  // next request
+  if (heap_watchdog_.check("after cloud work") != core::HeapPressure::Normal) {
+    (void)cloud_->release_connection();
+  }
+}
+
+bool MeasurementProbe::guard_heap(const char *where) {
+  switch (heap_watchdog_.check(where)) {
+  case core::HeapPressure::Normal:
+    return true;
+  case core::HeapPressure::Low:
+    (void)cloud_->release_connection();
+    return true;
+  case core::HeapPressure::Critical:
+  default:
+    break;
+  }
+
+  // Freeing the idle connection may be enough for the next attempt
+  (void)cloud_->release_connection();
+  if constexpr (!app::config::DUTY_CYCLE_MODE) {
+    // A duty-cycled unit starts with a fresh heap every wake anyway
+    if (heap_watchdog_.exhausted()) {
+      ESP_LOGE(TAG, "Heap not recovering, restarting");
+      (void)core::Fail(ESP_ERR_NO_MEM); // Reported after the restart
+      flush_storage();
+      esp_restart();
+    }
+  }
+  return false;
+}
+
+void MeasurementProbe::defer_cloud_work(uint32_t work) {
+  if (work == 0) {
+    return;
+  }
+  deferred_work_ |= work;
+  ESP_LOGW(TAG, "Cloud work 0x%lx deferred %lld ms: heap too fragmented",
+           static_cast<unsigned long>(deferred_work_.load()),
+           static_cast<long long>(defer_delay_.count()));
+  (void)defer_timer_.stop();
+  if (auto status = defer_timer_.start(defer_delay_); !status) {
+    ESP_LOGE(TAG, "Defer timer start failed: %s",
+             esp_err_to_name(status.error()));
+  }
+  defer_delay_ = std::min(defer_delay_ * 2, CLOUD_DEFER_MAX);
+}
+
+void MeasurementProbe::report_device_info() {
+  ESP_LOGI(TAG, "Reporting device info if changed");
+  // Late in the wake: TLS and the uploads have had their deepest stacks
+  core::task_registry().log_report();
+  core::lock_registry().log_report(); // CONFIG_CORE_LOCK_STATS only
+  core::fault_log().log_report();
+  const auto *app_desc = esp_app_get_description();
+  cloud::DeviceInfo info{
+      .app_name = app_desc->project_name,
+      .app_version = app_desc->version,
+      .free_heap = esp_get_free_heap_size(),
+      .min_free_heap = esp_get_minimum_free_heap_size(),
+      .reset_reason = static_cast<uint32_t>(esp_reset_reason()),
+      .rssi = wifi_.connection_info().rssi,
+      .iaq_accuracy = bme680_monitor_
+                          ? bme680_monitor_->sensor().iaq_accuracy()
+                          : uint8_t{0},
+  };
+  (void)cloud_->report_device_info(info, g_rtc_device_info_hash);
+}
+
+void MeasurementProbe::run_transmit() {
+  {
+    core::ScopedPhase phase(core::WakePhase::Upload);
+    send_telemetry();
+    transmit_acked_ = telemetry_log_.empty();
+    // The Authenticated event's work would only run after we are asleep
+    report_device_info();
+    // A sleeping device only sees commands while it is up
+    cloud_->run(cloud::CloudWork::PollCommands);
+  }
+  transmit_done_.give();
+}
+
 void MeasurementProbe::start_cloud() {
   if (!cloud_) {
     return;
   }
 
-  if (auto status = cloud_->start(); !status) {
+  core::begin_phase(core::WakePhase::Auth);
+  auto status = cloud_->start();
+  core::end_phase(core::WakePhase::Auth);
+  if (!status) {
     ESP_LOGE(TAG, "Cloud start failed: %s", esp_err_to_name(status.error()));
     return;
   }
@@ -304,21 +1472,107 @@ void MeasurementProbe::start_cloud() {
 }
 
 void MeasurementProbe::send_telemetry() {
-  if (!cloud_ || !cloud_->is_connected()) {
+  if (!cloud_) {
     return;
   }
 
-  // Read all current measurements
-  std::array<sensor::Measurement, MAX_MEASUREMENTS> buffer{};
-  size_t count = sensors_.read_all_into(buffer);
+  if (!cloud_->is_connected()) {
+    store_telemetry_offline();
+    return;
+  }
 
-  if (count == 0) {
+  if constexpr (app::config::cloud::METRICS_INTERVAL_MIN > 0) {
+    constexpr int64_t INTERVAL_US =
+        int64_t{app::config::cloud::METRICS_INTERVAL_MIN} * 60 * 1'000'000;
+    int64_t now = esp_timer_get_time();
+    if (!metrics_recorded_us_ || now - *metrics_recorded_us_ >= INTERVAL_US) {
+      metrics_recorded_us_ = now;
+      record_metrics();
+    }
+  }
+
+  // A duty-cycled unit sleeps long before a batch is due: its samples go
+  // through flash and leave with the backlog, acked or kept
+  if constexpr (app::config::DUTY_CYCLE_MODE) {
+    store_telemetry_offline();
+  }
+
+  // Backlog first, so the server sees samples in order
+  if (!telemetry_log_.empty()) {
+    (void)telemetry_log_.drain([this](auto source) {
+      return cloud_->stream_telemetry(std::move(source));
+    });
+  }
+
+  // Routine samples wait in the outbox until a batch is due; whatever
+  // doesn't fit stays in the history ring for the next pass
+  (void)sensors_.drain_each(
+      [this](std::span<const sensor::Measurement> sample) {
+        return cloud_->queue_telemetry(sample, cloud::Priority::Batched);
+      });
+  cloud_->service_outbox();
+
+  // Uploads may have refreshed the token; no-op if unchanged
+  if (auto status = token_mirror_->sync(); !status) {
+    ESP_LOGW(TAG, "Token backup failed: %s", esp_err_to_name(status.error()));
+  }
+}
+
+void MeasurementProbe::store_telemetry_offline() {
+  if (!telemetry_log_.is_ready()) {
+    return;
+  }
+  // Batched by earlier wakes, so older than the history
+  if (!g_rtc_samples.empty()) {
+    if (auto status = g_rtc_samples.spill(telemetry_log_); !status) {
+      ESP_LOGW(TAG, "RTC batch not stored: %s",
+               esp_err_to_name(status.error()));
+      return;
+    }
+  }
+  if (data_manager_.history_measurement_count() == 0) {
     return;
   }
 
-  auto result = cloud_->send_telemetry(std::span(buffer.data(), count));
-  if (!result.success) {
-    ESP_LOGW(TAG, "Telemetry send failed");
+  size_t samples = sensors_.drain_each(
+      [this](std::span<const sensor::Measurement> sample) {
+        return static_cast<bool>(telemetry_log_.append(sample));
+      });
+  ESP_LOGD(TAG, "Queued %zu sample(s) offline, ~%zu pending", samples,
+           telemetry_log_.pending());
+}
+
+void MeasurementProbe::batch_samples_in_rtc() {
+  size_t overwritten = 0;
+  (void)sensors_.drain_each(
+      [this, &overwritten](std::span<const sensor::Measurement> sample) {
+        if (g_rtc_samples.append(sample)) {
+          return true;
+        }
+        if constexpr (app::config::mesh::ROLE ==
+                      app::config::mesh::Role::Leaf) {
+          // A leaf never uploads the flash log: the oldest sample goes
+          while (g_rtc_samples.drop_oldest()) {
+            ++overwritten;
+            if (g_rtc_samples.append(sample)) {
+              return true;
+            }
+          }
+          return false;
+        }
+        // Full: the batch goes to flash early
+        if (auto status = g_rtc_samples.spill(telemetry_log_); !status) {
+          return false;
+        }
+        return g_rtc_samples.append(sample) ||
+               static_cast<bool>(telemetry_log_.append(sample));
+      });
+  if (overwritten != 0) {
+    ESP_LOGW(TAG, "RTC batch full, %zu oldest sample(s) dropped",
+             overwritten);
+  }
+  if (data_manager_.history_measurement_count() != 0) {
+    ESP_LOGW(TAG, "Samples dropped: RTC batch full and flash unavailable");
   }
 }
 
@@ -330,7 +1584,10 @@ void MeasurementProbe::cloud_event_handler(void *arg, esp_event_base_t /*base*/,
   switch (event) {
   case cloud::CloudEvent::Authenticated:
     ESP_LOGI(TAG, "Cloud authenticated - scheduling device info update");
-    self->device_info_pending_ = true;
+    // Reaching the backend is the test a new image has to pass
+    cloud::OtaUpdater::confirm_running_image();
+    // Telemetry replays what was queued offline
+    self->cloud_worker_.post(CLOUD_DEVICE_INFO | CLOUD_TELEMETRY);
     break;
 
   case cloud::CloudEvent::Revoked:
@@ -339,6 +1596,7 @@ void MeasurementProbe::cloud_event_handler(void *arg, esp_event_base_t /*base*/,
 
   case cloud::CloudEvent::RebootRequested:
     ESP_LOGI(TAG, "Reboot requested via cloud command");
+    self->flush_storage();
     vTaskDelay(pdMS_TO_TICKS(500));
     esp_restart();
     break;
@@ -354,21 +1612,19 @@ void MeasurementProbe::cloud_event_handler(void *arg, esp_event_base_t /*base*/,
 }
 
 void MeasurementProbe::handle_factory_reset() {
-  // Use generic storage interface to erase all namespaces
   ESP_LOGW(TAG, "Erasing all storage...");
 
-  // Erase each namespace we use
-  auto &app_storage = storage(core::NamespaceId::App);
-  (void)app_storage.erase_all();
+  // RTC memory survives the restart below
+  g_rtc_auth_token.clear();
 
-  auto &wifi_storage = storage(core::NamespaceId::Wifi);
-  (void)wifi_storage.erase_all();
+  // Nothing queued may land after the wipe
+  (void)storage_worker().flush_and_wait(FLUSH_TIMEOUT);
 
-  auto &bsec_storage = storage(core::NamespaceId::Bsec);
-  (void)bsec_storage.erase_all();
-
-  auto &cloud_storage = storage(core::NamespaceId::Cloud);
-  (void)cloud_storage.erase_all();
+  // One bulk erase per partition (NVS, LittleFS) instead of walking keys
+  if (auto status = storage_manager().format_all(); !status) {
+    ESP_LOGE(TAG, "Storage wipe incomplete: %s",
+             esp_err_to_name(status.error()));
+  }
 
   ESP_LOGI(TAG, "Factory reset complete, rebooting...");
   vTaskDelay(pdMS_TO_TICKS(500));
@@ -380,11 +1636,114 @@ void MeasurementProbe::on_device_revoked() {
   ESP_LOGE(TAG, "Entering safe mode - awaiting factory reset");
 
   // Stop all normal operations
-  if (log_timer_) {
-    log_timer_->stop();
-  }
+  (void)log_timer_.stop();
 
   // Could show LED pattern, enter low-power mode, etc.
 }
 
+cloud::CommandResult MeasurementProbe::on_ota_command(std::string_view payload) {
+  auto request = cloud::parse_ota_request(payload);
+  if (!request) {
+    ESP_LOGW(TAG, "Malformed ota_update payload");
+    return cloud::CommandResult::InvalidPayload;
+  }
+
+  // Modem sleep throttles a bulk download to a crawl
+  (void)wifi_.set_power_save(network::PowerSave::None);
+
+  // Acked as accepted; the new version shows up in the next device info
+  auto status = ota_.start(*request, [this](core::Status result) {
+    if (result) {
+      core::events().publish(cloud::CLOUD_EVENTS,
+                             cloud::CloudEvent::RebootRequested);
+    } else {
+      (void)wifi_.set_power_save(app::config::WIFI_POWER_SAVE);
+    }
+  });
+  if (!status) {
+    ESP_LOGW(TAG, "OTA not started: %s", esp_err_to_name(status.error()));
+    (void)wifi_.set_power_save(app::config::WIFI_POWER_SAVE);
+    return cloud::CommandResult::Failed;
+  }
+  return cloud::CommandResult::Success;
+}
+
+cloud::CommandResult
+MeasurementProbe::on_config_command(std::string_view payload) {
+  auto config = device_config_;
+  if (!cloud::parse_config_update(payload, config)) {
+    ESP_LOGW(TAG, "Rejected config_update payload");
+    return cloud::CommandResult::InvalidPayload;
+  }
+  if (config == device_config_) {
+    return cloud::CommandResult::Success;
+  }
+
+  device_config_ = config;
+  apply_device_config();
+
+  // Queued copy; a config that can't be stored would be lost on reboot
+  cloud::StoredDeviceConfig stored{.config = config};
+  if (auto status = storage_worker().submit(storage(core::NamespaceId::App),
+                                            cloud::device_config_write(stored));
+      !status) {
+    ESP_LOGW(TAG, "Config applied but not stored: %s",
+             esp_err_to_name(status.error()));
+    return cloud::CommandResult::Failed;
+  }
+  return cloud::CommandResult::Success;
+}
+
+void MeasurementProbe::apply_device_config() {
+  const auto config = effective_config();
+  size_t monitors = sensors_.set_sample_interval(
+      std::chrono::seconds(config.sample_interval_s));
+  deadband_.set_config(deadband_config());
+  if (cloud_) {
+    cloud_->set_poll_interval(std::chrono::seconds(config.poll_interval_s),
+                              std::chrono::seconds(config.poll_max_interval_s));
+    auto outbox = cloud::OutboxConfig{};
+    outbox.batch_window = std::chrono::seconds(config.upload_interval_s);
+    cloud_->set_outbox_config(outbox);
+  }
+  ESP_LOGI(TAG,
+           "Config: sample %" PRIu32 "s (%zu monitor(s)), upload %" PRIu32
+           "s, poll %" PRIu32 "-%" PRIu32 "s, deadband %" PRIu32
+           "%% / %" PRIu32 "s",
+           config.sample_interval_s, monitors, config.upload_interval_s,
+           config.poll_interval_s, config.poll_max_interval_s,
+           config.deadband_percent, config.deadband_heartbeat_s);
+}
+
+cloud::DeviceConfig MeasurementProbe::effective_config() const {
+  auto config = device_config_;
+  if constexpr (app::config::anomaly::ENABLED) {
+    // Anomalies don't wait for the batch: routine data can wait longer
+    config.upload_interval_s =
+        std::min(config.upload_interval_s * app::config::anomaly::QUIET_STRETCH,
+                 cloud::device_config::MAX_INTERVAL_S);
+  }
+  uint32_t stretch =
+      power::interval_stretch(BATTERY_POLICY, battery_level_.load());
+  if (stretch <= 1) {
+    return config;
+  }
+  auto scale = [stretch](uint32_t &interval_s) {
+    interval_s =
+        std::min(interval_s * stretch, cloud::device_config::MAX_INTERVAL_S);
+  };
+  scale(config.sample_interval_s);
+  scale(config.upload_interval_s);
+  scale(config.poll_interval_s);
+  scale(config.poll_max_interval_s);
+  return config;
+}
+
+sensor::DeadbandConfig MeasurementProbe::deadband_config() const {
+  return {
+      .heartbeat = std::chrono::seconds(device_config_.deadband_heartbeat_s),
+      .scale_percent = static_cast<uint16_t>(device_config_.deadband_percent),
+  };
+}
+
 } // namespace application
@@ -0,0 +1,243 @@
+/**
+ * @file benchmarks.cpp
+ * @brief Kernels of the on-device benchmarks
+ */
+
+#include <application/app.hpp>
+#include <application/benchmarks.hpp>
+#include <bme680/bsec_wrapper.hpp>
+#include <cloud/command_service.hpp>
+#include <cloud/jwt_signer.hpp>
+#include <core/bench.hpp>
+#include <core/crc.hpp>
+#include <core/url.hpp>
+#include <proto/measurement_adapter.hpp>
+
+#include <esp_log.h>
+#include <esp_random.h>
+#include <mbedtls/pk.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+
+namespace application {
+
+namespace {
+constexpr const char *TAG = "bench";
+
+/// Keeps results the compiler could otherwise drop
+volatile uint32_t g_sink = 0;
+
+/// Sensor-like readings: a timestamp and rotating climate values
+template <size_t N>
+[[nodiscard]] std::array<sensor::Measurement, N> sample_measurements() {
+  using sensor::MeasurementId;
+  std::array<sensor::Measurement, N> out{};
+  for (size_t i = 0; i < N; ++i) {
+    auto step = static_cast<float>(i);
+    switch (i % 4) {
+    case 0:
+      out.at(i) = sensor::make<MeasurementId::Timestamp>(1'712'345'678'000 +
+                                                         (i * 1000));
+      break;
+    case 1:
+      out.at(i) = sensor::make<MeasurementId::Temperature>(21.5F + step);
+      break;
+    case 2:
+      out.at(i) = sensor::make<MeasurementId::Humidity>(45.25F + step);
+      break;
+    default:
+      out.at(i) = sensor::make<MeasurementId::Pressure>(1013.2F + step);
+      break;
+    }
+  }
+  return out;
+}
+
+template <size_t N> void add_encode_batch(const char *name) {
+  static const auto measurements = sample_measurements<N>();
+  static std::array<uint8_t, proto::MAX_BATCH_SIZE> buffer{};
+  core::bench::registry().add(name, 200, [] -> size_t {
+    return proto::encode_batch(measurements, buffer);
+  });
+}
+
+void add_crc32() {
+  static std::array<uint8_t, 1024> block{};
+  for (size_t i = 0; i < block.size(); ++i) {
+    block.at(i) = static_cast<uint8_t>(i * 31);
+  }
+  core::bench::registry().add("crc32/1k", 1000, [] -> size_t {
+    g_sink = core::Crc32::compute(std::span<const uint8_t>(block));
+    return block.size();
+  });
+}
+
+/// GET /commands body with count config_update commands, as the backend
+/// sends it
+[[nodiscard]] size_t command_body(std::span<char> out, size_t count) {
+  size_t len = 0;
+  auto put = [&](const char *text) {
+    int n = snprintf(out.data() + len, out.size() - len, "%s", text);
+    len += static_cast<size_t>(n);
+  };
+  put("{\"data\":[");
+  for (size_t i = 0; i < count; ++i) {
+    std::array<char, 160> command{};
+    snprintf(command.data(), command.size(),
+             "%s{\"id\":\"cmd-%04zu\",\"type\":\"config_update\","
+             "\"payload\":{\"sample_interval_s\":120,"
+             "\"upload_interval_s\":600},\"created_at\":1712345678}",
+             i == 0 ? "" : ",", i);
+    put(command.data());
+  }
+  put("]}");
+  return len;
+}
+
+template <size_t Count> void add_parse_commands(const char *name) {
+  static std::array<char, 2048> body{};
+  static const size_t len = command_body(body, Count);
+  // Borrowed without a lease: the body is static, no pool block is held
+  static const cloud::ApiResponse response{
+      .success = true,
+      .status_code = 200,
+      .raw = transport::Response::borrowed(
+          std::span(reinterpret_cast<const uint8_t *>(body.data()), len), 200,
+          {}),
+  };
+  core::bench::registry().add(name, 200, [] -> size_t {
+    static cloud::CommandBuffer commands;
+    commands.clear();
+    (void)cloud::CommandService::parse(response, commands);
+    return commands.size() * sizeof(cloud::Command);
+  });
+}
+
+void add_data_manager() {
+  static DataManager data;
+  static const auto readings =
+      sample_measurements<sensor::MAX_MEASUREMENTS_PER_SENSOR>();
+  static std::array<sensor::Measurement,
+                    DataManager::SENSOR_COUNT * DataManager::MAX_MEASUREMENTS>
+      out{};
+  for (sensor::SensorIdType id = 1; id < DataManager::SENSOR_COUNT; ++id) {
+    data.on_data(id, readings);
+  }
+
+  auto &registry = core::bench::registry();
+  registry.add("data_manager/on_data", 500, [] -> size_t {
+    data.on_data(0, readings);
+    return readings.size() * sizeof(sensor::Measurement);
+  });
+  registry.add("data_manager/read_all_into", 500, [] -> size_t {
+    return data.read_all_into(out) * sizeof(sensor::Measurement);
+  });
+}
+
+/// What HttpClient::build_url() does for a command poll
+void add_build_url() {
+  static std::array<char, core::http_buffers::URL> buffer{};
+  core::bench::registry().add("build_url", 1000, [] -> size_t {
+    static constexpr std::array<core::QueryParam, 2> query{{
+        {.key = "wait", .value = "30"},
+        {.key = "since", .value = "2024-04-05T19:34:38Z"},
+    }};
+    core::url::UrlWriter url(buffer);
+    url.append("https://telemetry-api-abc123-uw.a.run.app")
+        .append("/v1/devices/probe-0001/commands")
+        .append_query(query);
+    return url.size();
+  });
+}
+
+int fill_random(void * /*ctx*/, unsigned char *buf, size_t len) {
+  esp_fill_random(buf, len);
+  return 0;
+}
+
+/// A throwaway P-256 key in PEM, as the key partition holds one
+[[nodiscard]] bool generate_key_pem(std::span<char> out) {
+  mbedtls_pk_context pk;
+  mbedtls_pk_init(&pk);
+  int ret = mbedtls_pk_setup(&pk, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+  if (ret == 0) {
+    ret = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, mbedtls_pk_ec(pk),
+                              fill_random, nullptr);
+  }
+  if (ret == 0) {
+    ret = mbedtls_pk_write_key_pem(
+        &pk, reinterpret_cast<unsigned char *>(out.data()), out.size());
+  }
+  mbedtls_pk_free(&pk);
+  return ret == 0;
+}
+
+/// ES256 token minting: SHA-256 and one ECDSA signature
+void add_jwt_mint() {
+  static cloud::JwtSigner signer;
+  static std::array<char, 512> key_pem{};
+  if (!generate_key_pem(key_pem) ||
+      !signer.init(std::string_view(key_pem.data()))) {
+    ESP_LOGW(TAG, "jwt/mint: no test key, skipped");
+    return;
+  }
+  core::bench::registry().add("jwt/mint", 20, [] -> size_t {
+    static std::array<char, cloud::jwt::MAX_TOKEN_SIZE> token{};
+    auto len = signer.mint(
+        {.subject = "2f1c8c0e-5d4b-4b7e-9a61-3c1d2e4f5a6b",
+         .audience = "probes",
+         .issued_at = std::chrono::system_clock::time_point(
+             std::chrono::seconds(1'712'345'678))},
+        token);
+    return len.value_or(0);
+  });
+}
+
+/// One bsec_do_steps call on a gas-valid field, timestamps advancing at
+/// the configured sample rate
+void add_bsec_do_steps() {
+  static sensor::bme680::BsecWrapper bsec;
+  if (!bsec.init() || !bsec.subscribe_all()) {
+    ESP_LOGW(TAG, "bsec/do_steps: BSEC init failed, skipped");
+    return;
+  }
+  // process() logs every output at warning level
+  esp_log_level_set("bsec", ESP_LOG_ERROR);
+  core::bench::registry().add("bsec/do_steps", 50, [] -> size_t {
+    static int64_t time_ns = 0;
+    time_ns += std::chrono::nanoseconds(bsec.sample_interval()).count();
+    auto output =
+        bsec.process(time_ns, 23.1F, 100'850.0F, 41.7F, 152'000.0F, true);
+    return output ? sizeof(sensor::bme680::BsecOutput) : 0;
+  });
+}
+} // namespace
+
+void run_benchmarks() {
+  ESP_LOGI(TAG, "Running benchmarks%s",
+           core::bench::alloc_count() < 0
+               ? " (allocs need CONFIG_HEAP_USE_HOOKS)"
+               : "");
+  add_encode_batch<1>("encode_batch/1");
+  add_encode_batch<8>("encode_batch/8");
+  add_encode_batch<proto::MAX_MEASUREMENTS_PER_BATCH>("encode_batch/32");
+  add_crc32();
+  add_parse_commands<1>("parse_commands/1");
+  add_parse_commands<cloud::MAX_COMMANDS>("parse_commands/8");
+  add_data_manager();
+  add_build_url();
+  add_jwt_mint();
+  add_bsec_do_steps();
+
+  core::bench::registry().run_all();
+  esp_log_level_set("bsec",
+                    static_cast<esp_log_level_t>(CONFIG_LOG_DEFAULT_LEVEL));
+  ESP_LOGI(TAG, "Benchmarks done");
+}
+
+} // namespace application
@@ -19,6 +19,7 @@ Board::Board(const BoardConfig &config) {
       .sda_pin = config.i2c_sda,
       .scl_pin = config.i2c_scl,
       .freq_hz = config.i2c_freq_hz,
+      .trans_queue_depth = config.i2c_queue_depth,
   };
 
   i2c_ = std::make_unique<driver::i2c::Master>(i2c_config);
@@ -32,6 +33,25 @@ Board::Board(const BoardConfig &config) {
            static_cast<int>(config.i2c_sda), static_cast<int>(config.i2c_scl),
            static_cast<unsigned long>(config.i2c_freq_hz));
 
+  // SPI bus is optional: only when the board wires one
+  if (config.spi_sclk != GPIO_NUM_NC) {
+    spi_ = std::make_unique<driver::spi::Master>(driver::spi::Config{
+        .sclk_pin = config.spi_sclk,
+        .mosi_pin = config.spi_mosi,
+        .miso_pin = config.spi_miso,
+    });
+    if (spi_->valid()) {
+      ESP_LOGI(TAG, "SPI initialized (SCLK=%d, MOSI=%d, MISO=%d)",
+               static_cast<int>(config.spi_sclk),
+               static_cast<int>(config.spi_mosi),
+               static_cast<int>(config.spi_miso));
+    } else {
+      // The board still works without it: spi() returns nullptr
+      ESP_LOGE(TAG, "Failed to initialize SPI bus");
+      spi_.reset();
+    }
+  }
+
   valid_ = true;
 }
 
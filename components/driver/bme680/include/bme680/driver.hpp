@@ -1,6 +1,10 @@
 /**
  * @file driver.hpp
  * @brief BME680 driver wrapping Bosch BME68x API (VFS-style)
+ *
+ * The chip sits on I2C or on SPI (CSB pulled low selects SPI at the first
+ * frame); the constructor picks the bme68x_dev interface callbacks. At
+ * several MHz an SPI data read takes a fraction of 400 kHz I2C's time.
  */
 
 #pragma once
@@ -9,10 +13,13 @@
 
 #include <driver/driver.hpp>
 #include <i2c/i2c.hpp>
+#include <spi/spi.hpp>
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <memory>
+#include <span>
 
 namespace driver::bme680 {
 
@@ -20,6 +27,36 @@ namespace driver::bme680 {
 inline constexpr uint8_t I2C_ADDR_PRIMARY = 0x76;   // SDO to GND
 inline constexpr uint8_t I2C_ADDR_SECONDARY = 0x77; // SDO to VCC
 
+/// Bus auto-discovery signature (BME680 and BME688 share chip ID 0x61)
+inline constexpr i2c::ChipSignature CHIP_SIGNATURE{
+    .addresses = {I2C_ADDR_PRIMARY, I2C_ADDR_SECONDARY},
+    .address_count = 2,
+    .id_register = BME68X_REG_CHIP_ID,
+    .id_value = BME68X_CHIP_ID,
+};
+
+/// SPI clock (the chip takes up to 10 MHz)
+inline constexpr uint32_t SPI_FREQ_HZ = 8'000'000;
+
+/// Bound on every bus access; a stuck bus surfaces as ESP_ERR_TIMEOUT
+inline constexpr i2c::Timeout BUS_TIMEOUT{50};
+
+/// Heater profile steps supported by the chip
+inline constexpr size_t MAX_HEATER_STEPS = 10;
+
+/// Data fields buffered by the chip in parallel / sequential mode
+inline constexpr size_t MAX_FIELDS = 3;
+
+/// Parallel mode heater cycle (TPH conversion + shared heater duration)
+inline constexpr std::chrono::milliseconds PARALLEL_HEAT_CYCLE{140};
+
+/// Operating mode
+enum class Mode : uint8_t {
+  Forced,     ///< One TPH conversion and one heater step per trigger
+  Parallel,   ///< BME688 only: heater profile runs alongside TPH (continuous)
+  Sequential, ///< One TPH conversion per heater profile step (continuous)
+};
+
 /// Sensor data from BME680
 struct SensorData {
   float temperature;    // °C
@@ -28,6 +65,31 @@ struct SensorData {
   float gas_resistance; // Ohms
   bool gas_valid;
   bool heater_stable;
+  uint8_t gas_index;  // Heater profile step of this field
+  uint8_t meas_index; // Running field counter (parallel / sequential)
+};
+
+/// Fields read by one CollectFields (oldest first)
+struct FieldSet {
+  std::array<SensorData, MAX_FIELDS> fields{};
+  uint8_t count = 0;
+
+  [[nodiscard]] std::span<const SensorData> view() const {
+    return {fields.data(), count};
+  }
+};
+
+/// Heater profile for parallel / sequential mode
+struct HeaterProfile {
+  std::array<uint16_t, MAX_HEATER_STEPS> temperature{}; // °C per step
+  /// Per step: ms in sequential mode, multiples of the heater cycle in
+  /// parallel mode
+  std::array<uint16_t, MAX_HEATER_STEPS> duration{};
+  uint8_t length = 0;
+  /// Parallel mode only (ms); 0 fills the rest of PARALLEL_HEAT_CYCLE
+  uint16_t shared_duration = 0;
+
+  bool operator==(const HeaterProfile &) const = default;
 };
 
 /// Configuration for BME680
@@ -37,9 +99,13 @@ struct Config {
   uint8_t hum_os = BME68X_OS_4X;
   uint8_t filter = BME68X_FILTER_SIZE_3;
   uint8_t odr = BME68X_ODR_NONE;
-  uint16_t heater_temp = 320; // °C
-  uint16_t heater_dur = 150;  // ms
+  uint16_t heater_temp = 320; // °C (forced mode)
+  uint16_t heater_dur = 150;  // ms (forced mode)
   bool enable_gas = true;
+  Mode mode = Mode::Forced;
+  HeaterProfile profile{}; // Parallel / sequential mode
+
+  bool operator==(const Config &) const = default;
 };
 
 /// Device info structure
@@ -50,18 +116,32 @@ struct DeviceInfo {
 
 /// ioctl commands
 // NOLINTNEXTLINE(performance-enum-size)
+///
+/// read()/ReadData trigger, wait and collect in one blocking call. For
+/// non-blocking use, issue TriggerMeasurement, come back after the returned
+/// duration and issue CollectData.
+///
+/// In parallel / sequential mode the chip keeps cycling through the heater
+/// profile after TriggerMeasurement; the returned duration is the time per
+/// field and CollectFields returns every new field (up to MAX_FIELDS).
 enum class IoctlCmd : uint32_t {
   Configure,              // arg: const Config*
-  TriggerMeasurement,     // arg: nullptr
+  TriggerMeasurement,     // arg: nullptr, returns std::chrono::microseconds
   GetMeasurementDuration, // arg: std::chrono::microseconds*
   GetDeviceInfo,          // arg: DeviceInfo*
   ReadData,               // arg: SensorData*
+  CollectData,            // arg: nullptr, returns SensorData (no wait)
+  CollectFields,          // arg: nullptr, returns FieldSet (no wait)
 };
 
 /// Low-level BME680 driver (VFS-style)
 class BME680Driver : public IDriver {
 public:
   BME680Driver(i2c::IMaster &bus, uint8_t address = I2C_ADDR_SECONDARY);
+  /// Chip on an SPI bus (mode 0; the Bosch API sets the read bit and the
+  /// register page itself)
+  BME680Driver(spi::IMaster &bus, gpio_num_t cs_pin,
+               uint32_t freq_hz = SPI_FREQ_HZ);
   ~BME680Driver() override;
 
   BME680Driver(const BME680Driver &) = delete;
@@ -79,12 +159,20 @@ public:
   [[nodiscard]] core::Result<std::any> ioctl(uint32_t cmd,
                                              std::any arg) override;
 
+  /// True once open() found the chip, until close()
+  [[nodiscard]] bool is_open() const { return is_open_; }
+
 private:
   // Internal implementations called via ioctl
   [[nodiscard]] core::Status configure_impl(const Config &config);
   [[nodiscard]] core::Status trigger_measurement_impl();
   [[nodiscard]] std::chrono::microseconds measurement_duration_impl();
   [[nodiscard]] core::Result<SensorData> read_data_impl();
+  [[nodiscard]] core::Result<SensorData> collect_impl();
+  [[nodiscard]] core::Result<FieldSet> collect_fields_impl();
+
+  /// Bosch op mode constant for mode_
+  [[nodiscard]] uint8_t op_mode() const;
 
   // Bosch API callbacks
   static BME68X_INTF_RET_TYPE i2c_read(uint8_t reg_addr, uint8_t *reg_data,
@@ -92,12 +180,43 @@ private:
   static BME68X_INTF_RET_TYPE i2c_write(uint8_t reg_addr,
                                         const uint8_t *reg_data,
                                         uint32_t length, void *intf_ptr);
+  static BME68X_INTF_RET_TYPE spi_read(uint8_t reg_addr, uint8_t *reg_data,
+                                       uint32_t length, void *intf_ptr);
+  static BME68X_INTF_RET_TYPE spi_write(uint8_t reg_addr,
+                                        const uint8_t *reg_data,
+                                        uint32_t length, void *intf_ptr);
   static void delay_us(uint32_t period, void *intf_ptr);
 
-  std::unique_ptr<i2c::IDevice> device_;
+  /// Set up dev_ for the bus in use
+  void init_dev(bme68x_intf intf);
+
+  /// Register block read ahead of bme68x_get_data in one bus transaction
+  struct ShadowRegion {
+    static constexpr size_t MAX_LEN = BME68X_LEN_FIELD * MAX_FIELDS;
+
+    uint8_t reg = 0;
+    uint8_t len = 0;
+    bool valid = false;
+    bool single_use = false; ///< Consumed by the first read it serves
+    std::array<uint8_t, MAX_LEN> data{};
+  };
+
+  /// Read field data and heater registers with a single transfer() (one
+  /// frame per block on SPI)
+  [[nodiscard]] esp_err_t prefetch_field_data();
+
+  /// Serve a Bosch read from the shadow (consumes the region)
+  [[nodiscard]] bool read_shadow(uint8_t reg, std::span<uint8_t> out);
+
+  std::unique_ptr<i2c::IDevice> device_;    ///< On I2C
+  std::unique_ptr<spi::IDevice> spi_device_; ///< On SPI
+  std::array<ShadowRegion, 2> shadow_{};
   bme68x_dev dev_{};
   bme68x_conf conf_{};
   bme68x_heatr_conf heatr_conf_{};
+  HeaterProfile profile_{}; ///< Backs heatr_conf_ profile pointers
+  Mode mode_ = Mode::Forced;
+  bool running_ = false; ///< Continuous mode started since last configure
   bool is_open_ = false;
 };
 
@@ -9,23 +9,47 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <algorithm>
 #include <cstring>
-#include <vector>
+#include <tuple>
 
 namespace driver::bme680 {
 
 namespace {
 constexpr const char *TAG = "bme680_drv";
+
+SensorData to_sensor_data(const bme68x_data &data) {
+  SensorData result{};
+  result.temperature = data.temperature;
+  result.pressure = data.pressure / 100.0F;
+  result.humidity = data.humidity;
+  result.gas_resistance = data.gas_resistance;
+  result.gas_valid = (data.status & BME68X_GASM_VALID_MSK) != 0;
+  result.heater_stable = (data.status & BME68X_HEAT_STAB_MSK) != 0;
+  result.gas_index = data.gas_index;
+  result.meas_index = data.meas_index;
+  return result;
+}
 } // namespace
 
 BME680Driver::BME680Driver(i2c::IMaster &bus, uint8_t address)
     : device_(bus.create_device(address)) {
+  init_dev(BME68X_I2C_INTF);
+}
+
+BME680Driver::BME680Driver(spi::IMaster &bus, gpio_num_t cs_pin,
+                           uint32_t freq_hz)
+    : spi_device_(bus.create_device(spi::DeviceConfig{
+          .cs_pin = cs_pin, .freq_hz = freq_hz, .mode = 0, .read_flag = 0})) {
+  init_dev(BME68X_SPI_INTF);
+}
 
+void BME680Driver::init_dev(bme68x_intf intf) {
   std::memset(&dev_, 0, sizeof(dev_));
-  dev_.intf = BME68X_I2C_INTF;
+  dev_.intf = intf;
   dev_.intf_ptr = this;
-  dev_.read = i2c_read;
-  dev_.write = i2c_write;
+  dev_.read = intf == BME68X_SPI_INTF ? spi_read : i2c_read;
+  dev_.write = intf == BME68X_SPI_INTF ? spi_write : i2c_write;
   dev_.delay_us = delay_us;
   dev_.amb_temp = 25;
 }
@@ -37,7 +61,9 @@ BME680Driver::~BME680Driver() {
 }
 
 core::Status BME680Driver::open() {
-  if (!device_ || !device_->valid()) {
+  bool connected = (device_ && device_->valid()) ||
+                   (spi_device_ && spi_device_->valid());
+  if (!connected) {
     return core::Err(ESP_ERR_INVALID_STATE);
   }
 
@@ -67,6 +93,7 @@ core::Status BME680Driver::close() {
   }
 
   bme68x_set_op_mode(BME68X_SLEEP_MODE, &dev_);
+  running_ = false;
   is_open_ = false;
   return core::Ok();
 }
@@ -125,7 +152,7 @@ core::Result<std::any> BME680Driver::ioctl(uint32_t cmd, std::any arg) {
 
   case IoctlCmd::TriggerMeasurement: {
     auto status = trigger_measurement_impl();
-    return status ? core::Result<std::any>(std::any{})
+    return status ? core::Result<std::any>(measurement_duration_impl())
                   : core::Err(status.error());
   }
 
@@ -149,6 +176,22 @@ core::Result<std::any> BME680Driver::ioctl(uint32_t cmd, std::any arg) {
     return std::any(*result);
   }
 
+  case IoctlCmd::CollectData: {
+    auto result = collect_impl();
+    if (!result) {
+      return core::Err(result.error());
+    }
+    return std::any(*result);
+  }
+
+  case IoctlCmd::CollectFields: {
+    auto result = collect_fields_impl();
+    if (!result) {
+      return core::Err(result.error());
+    }
+    return std::any(*result);
+  }
+
   default:
     return core::Err(ESP_ERR_NOT_SUPPORTED);
   }
@@ -156,6 +199,21 @@ core::Result<std::any> BME680Driver::ioctl(uint32_t cmd, std::any arg) {
 // Private implementations
 
 core::Status BME680Driver::configure_impl(const Config &config) {
+  if (config.mode == Mode::Parallel &&
+      dev_.variant_id != BME68X_VARIANT_GAS_HIGH) {
+    ESP_LOGE(TAG, "Parallel mode requires a BME688");
+    return core::Err(ESP_ERR_NOT_SUPPORTED);
+  }
+  if (config.mode != Mode::Forced && config.enable_gas &&
+      (config.profile.length == 0 ||
+       config.profile.length > MAX_HEATER_STEPS)) {
+    return core::Err(ESP_ERR_INVALID_ARG);
+  }
+
+  // set_conf / set_heatr_conf put the chip to sleep
+  running_ = false;
+  mode_ = config.mode;
+
   conf_.os_temp = config.temp_os;
   conf_.os_pres = config.pres_os;
   conf_.os_hum = config.hum_os;
@@ -170,34 +228,85 @@ core::Status BME680Driver::configure_impl(const Config &config) {
 
   if (config.enable_gas) {
     heatr_conf_.enable = BME68X_ENABLE;
-    heatr_conf_.heatr_temp = config.heater_temp;
-    heatr_conf_.heatr_dur = config.heater_dur;
+    if (mode_ == Mode::Forced) {
+      heatr_conf_.heatr_temp = config.heater_temp;
+      heatr_conf_.heatr_dur = config.heater_dur;
+    } else {
+      profile_ = config.profile;
+      if (mode_ == Mode::Parallel && profile_.shared_duration == 0) {
+        auto tph_ms = static_cast<uint16_t>(
+            bme68x_get_meas_dur(BME68X_PARALLEL_MODE, &conf_, &dev_) / 1000);
+        auto cycle_ms = static_cast<uint16_t>(PARALLEL_HEAT_CYCLE.count());
+        profile_.shared_duration =
+            cycle_ms > tph_ms ? static_cast<uint16_t>(cycle_ms - tph_ms) : 0;
+      }
+      heatr_conf_.heatr_temp_prof = profile_.temperature.data();
+      heatr_conf_.heatr_dur_prof = profile_.duration.data();
+      heatr_conf_.profile_len = profile_.length;
+      heatr_conf_.shared_heatr_dur =
+          mode_ == Mode::Parallel ? profile_.shared_duration : 0;
+    }
 
-    rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf_, &dev_);
+    rslt = bme68x_set_heatr_conf(op_mode(), &heatr_conf_, &dev_);
     if (rslt != BME68X_OK) {
       ESP_LOGE(TAG, "bme68x_set_heatr_conf failed: %d", rslt);
       return core::Err(ESP_FAIL);
     }
   } else {
     heatr_conf_.enable = BME68X_DISABLE;
-    bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf_, &dev_);
+    bme68x_set_heatr_conf(op_mode(), &heatr_conf_, &dev_);
   }
 
   return core::Ok();
 }
 
+uint8_t BME680Driver::op_mode() const {
+  switch (mode_) {
+  case Mode::Parallel:
+    return BME68X_PARALLEL_MODE;
+  case Mode::Sequential:
+    return BME68X_SEQUENTIAL_MODE;
+  case Mode::Forced:
+  default:
+    return BME68X_FORCED_MODE;
+  }
+}
+
 core::Status BME680Driver::trigger_measurement_impl() {
-  int8_t rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &dev_);
+  // Continuous modes keep cycling once started
+  if (mode_ != Mode::Forced && running_) {
+    return core::Ok();
+  }
+
+  int8_t rslt = bme68x_set_op_mode(op_mode(), &dev_);
   if (rslt != BME68X_OK) {
     ESP_LOGE(TAG, "bme68x_set_op_mode failed: %d", rslt);
     return core::Err(ESP_FAIL);
   }
+  running_ = mode_ != Mode::Forced;
   return core::Ok();
 }
 
 std::chrono::microseconds BME680Driver::measurement_duration_impl() {
-  uint32_t dur_us = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf_, &dev_);
-  dur_us += static_cast<uint32_t>(heatr_conf_.heatr_dur) * 1000;
+  uint32_t dur_us = bme68x_get_meas_dur(op_mode(), &conf_, &dev_);
+  switch (mode_) {
+  case Mode::Parallel:
+    dur_us += static_cast<uint32_t>(heatr_conf_.shared_heatr_dur) * 1000;
+    break;
+  case Mode::Sequential: {
+    // Longest step, so every buffered field is complete
+    uint16_t step_ms = 0;
+    for (size_t i = 0; i < profile_.length; ++i) {
+      step_ms = std::max(step_ms, profile_.duration.at(i));
+    }
+    dur_us += static_cast<uint32_t>(step_ms) * 1000;
+    break;
+  }
+  case Mode::Forced:
+  default:
+    dur_us += static_cast<uint32_t>(heatr_conf_.heatr_dur) * 1000;
+    break;
+  }
   return std::chrono::microseconds(dur_us);
 }
 
@@ -213,29 +322,114 @@ core::Result<SensorData> BME680Driver::read_data_impl() {
   uint32_t delay_ms = static_cast<uint32_t>(duration.count() / 1000) + 1;
   vTaskDelay(pdMS_TO_TICKS(delay_ms));
 
-  // Read data
-  bme68x_data data{};
+  return collect_impl();
+}
+
+core::Result<SensorData> BME680Driver::collect_impl() {
+  auto fields = collect_fields_impl();
+  if (!fields) {
+    return core::Err(fields.error());
+  }
+  if (fields->count == 0) {
+    return core::Err(ESP_ERR_NOT_FOUND);
+  }
+  return fields->fields.at(fields->count - 1); // Newest
+}
+
+core::Result<FieldSet> BME680Driver::collect_fields_impl() {
+  // Read data (field + heater registers fetched in one bus transaction;
+  // falls back to per-register reads if the prefetch fails)
+  (void)prefetch_field_data();
+
+  std::array<bme68x_data, MAX_FIELDS> data{};
   uint8_t n_fields = 0;
 
-  int8_t rslt = bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &dev_);
-  if (rslt != BME68X_OK) {
+  int8_t rslt = bme68x_get_data(op_mode(), data.data(), &n_fields, &dev_);
+  for (auto &region : shadow_) {
+    region.valid = false;
+  }
+  if (rslt < BME68X_OK) {
     ESP_LOGE(TAG, "bme68x_get_data failed: %d", rslt);
     return core::Err(ESP_FAIL);
   }
 
-  if (n_fields == 0) {
-    return core::Err(ESP_ERR_NOT_FOUND);
+  // Warnings (e.g. no new data) leave n_fields at 0
+  FieldSet result{};
+  result.count = std::min<uint8_t>(n_fields, MAX_FIELDS);
+  for (size_t i = 0; i < result.count; ++i) {
+    result.fields.at(i) = to_sensor_data(data.at(i));
   }
+  return result;
+}
 
-  SensorData result{};
-  result.temperature = data.temperature;
-  result.pressure = data.pressure / 100.0F;
-  result.humidity = data.humidity;
-  result.gas_resistance = data.gas_resistance;
-  result.gas_valid = (data.status & BME68X_GASM_VALID_MSK) != 0;
-  result.heater_stable = (data.status & BME68X_HEAT_STAB_MSK) != 0;
+esp_err_t BME680Driver::prefetch_field_data() {
+  // Layout read by bme68x_get_data: the field block (one field in forced
+  // mode, all three otherwise), then idac/res_heat/gas_wait (0x50..0x6D,
+  // contiguous) read per byte in forced mode or as one block otherwise
+  constexpr uint8_t HEATER_REGS_LEN = 30;
+  auto field_len = static_cast<uint8_t>(
+      mode_ == Mode::Forced ? BME68X_LEN_FIELD : ShadowRegion::MAX_LEN);
+
+  // Field data is polled for new_data (single use); heater registers are
+  // static and may be read several times
+  auto &field = shadow_.at(0);
+  field = {.reg = BME68X_REG_FIELD0,
+           .len = field_len,
+           .valid = false,
+           .single_use = true,
+           .data = {}};
+  auto &heater = shadow_.at(1);
+  heater = {.reg = BME68X_REG_IDAC_HEAT0,
+            .len = HEATER_REGS_LEN,
+            .valid = false,
+            .single_use = false,
+            .data = {}};
+
+  esp_err_t err = ESP_OK;
+  if (spi_device_) {
+    // Both blocks are below 0x80, on page 0 (BME68X_MEM_PAGE0); the Bosch
+    // API tracks the page, and on page 1 its own reads switch it first
+    if (dev_.mem_page != BME68X_MEM_PAGE0) {
+      return ESP_ERR_INVALID_STATE;
+    }
+    for (auto &region : shadow_) {
+      region.reg |= BME68X_SPI_RD_MSK; // As spi_read() is asked for it
+      err = spi_device_->read_register(
+          region.reg, std::span(region.data.data(), region.len), BUS_TIMEOUT);
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+  } else {
+    i2c::Transaction<std::tuple_size_v<decltype(shadow_)>> txn;
+    for (auto &region : shadow_) {
+      (void)txn.read(region.reg, std::span(region.data.data(), region.len));
+    }
+    err = device_->transfer(txn.ops(), BUS_TIMEOUT);
+  }
 
-  return result;
+  if (err == ESP_OK) {
+    for (auto &region : shadow_) {
+      region.valid = true;
+    }
+  }
+  return err;
+}
+
+bool BME680Driver::read_shadow(uint8_t reg, std::span<uint8_t> out) {
+  for (auto &region : shadow_) {
+    if (region.valid && reg >= region.reg &&
+        reg + out.size() <= static_cast<size_t>(region.reg + region.len)) {
+      std::copy_n(region.data.begin() + (reg - region.reg), out.size(),
+                  out.begin());
+      // Single use: a retry (new_data not yet set) must hit the bus again
+      if (region.single_use) {
+        region.valid = false;
+      }
+      return true;
+    }
+  }
+  return false;
 }
 
 // Bosch API callbacks
@@ -247,10 +441,13 @@ BME68X_INTF_RET_TYPE BME680Driver::i2c_read(uint8_t reg_addr, uint8_t *reg_data,
     return BME68X_E_COM_FAIL;
   }
 
-  std::array<uint8_t, 1> tx = {reg_addr};
   std::span<uint8_t> rx(reg_data, length);
+  if (self->read_shadow(reg_addr, rx)) {
+    return BME68X_OK;
+  }
 
-  esp_err_t err = self->device_->write_read(tx, rx);
+  std::array<uint8_t, 1> tx = {reg_addr};
+  esp_err_t err = self->device_->write_read(tx, rx, BUS_TIMEOUT);
   return (err == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
 }
 
@@ -262,12 +459,41 @@ BME68X_INTF_RET_TYPE BME680Driver::i2c_write(uint8_t reg_addr,
     return BME68X_E_COM_FAIL;
   }
 
-  std::vector<uint8_t> buffer;
-  buffer.reserve(length + 1);
-  buffer.push_back(reg_addr);
-  buffer.insert(buffer.end(), reg_data, reg_data + length);
+  // reg + data as one op, no intermediate copy
+  i2c::Transaction<1> txn;
+  (void)txn.write(reg_addr, std::span(reg_data, length));
+  esp_err_t err = self->device_->transfer(txn.ops(), BUS_TIMEOUT);
+  return (err == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+}
+
+BME68X_INTF_RET_TYPE BME680Driver::spi_read(uint8_t reg_addr, uint8_t *reg_data,
+                                            uint32_t length, void *intf_ptr) {
+  auto *self = static_cast<BME680Driver *>(intf_ptr);
+  if (self == nullptr || self->spi_device_ == nullptr) {
+    return BME68X_E_COM_FAIL;
+  }
+
+  std::span<uint8_t> rx(reg_data, length);
+  if (self->read_shadow(reg_addr, rx)) {
+    return BME68X_OK;
+  }
+
+  // reg_addr carries the read bit already
+  esp_err_t err = self->spi_device_->read_register(reg_addr, rx, BUS_TIMEOUT);
+  return (err == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
+}
+
+BME68X_INTF_RET_TYPE BME680Driver::spi_write(uint8_t reg_addr,
+                                             const uint8_t *reg_data,
+                                             uint32_t length, void *intf_ptr) {
+  auto *self = static_cast<BME680Driver *>(intf_ptr);
+  if (self == nullptr || self->spi_device_ == nullptr) {
+    return BME68X_E_COM_FAIL;
+  }
 
-  esp_err_t err = self->device_->write(buffer);
+  // reg + data (interleaved reg/value pairs) in one frame
+  esp_err_t err = self->spi_device_->write_register(
+      reg_addr, std::span(reg_data, length), BUS_TIMEOUT);
   return (err == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
 }
 
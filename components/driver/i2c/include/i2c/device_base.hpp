@@ -102,6 +102,15 @@ protected:
     return device_->write_read(tx_data, rx_buffer, timeout);
   }
 
+  /// Execute a transaction list as one bus operation
+  [[nodiscard]] esp_err_t transfer(std::span<const RegisterOp> ops,
+                                   Timeout timeout = FOREVER) {
+    if (!is_connected()) {
+      return ESP_ERR_INVALID_STATE;
+    }
+    return device_->transfer(ops, timeout);
+  }
+
   /// @}
 
   /// @name Register operations
@@ -8,4 +8,6 @@
 #include "device_base.hpp" // IWYU pragma: export
 #include "interface.hpp"   // IWYU pragma: export
 #include "master.hpp"      // IWYU pragma: export
+#include "registry.hpp"    // IWYU pragma: export
+#include "transaction.hpp" // IWYU pragma: export
 #include "types.hpp"       // IWYU pragma: export
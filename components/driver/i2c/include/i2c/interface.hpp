@@ -5,10 +5,13 @@
 
 #pragma once
 
+#include "transaction.hpp"
 #include "types.hpp"
 
 #include <esp_err.h>
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <span>
@@ -38,6 +41,32 @@ public:
                                              std::span<uint8_t> rx_buffer,
                                              Timeout timeout = FOREVER) = 0;
 
+  /// Execute a list of register accesses as one bus operation
+  ///
+  /// The default implementation issues the ops one by one; bus drivers
+  /// override it to chain them into a single transfer.
+  [[nodiscard]] virtual esp_err_t transfer(std::span<const RegisterOp> ops,
+                                           Timeout timeout = FOREVER) {
+    for (const auto &op : ops) {
+      esp_err_t err = ESP_OK;
+      if (op.kind == RegisterOp::Kind::Read) {
+        err = write_read(std::span(&op.reg, 1), op.rx, timeout);
+      } else {
+        std::array<uint8_t, MAX_FALLBACK_WRITE> buf{};
+        if (op.tx.size() >= buf.size()) {
+          return ESP_ERR_INVALID_SIZE;
+        }
+        buf[0] = op.reg;
+        std::copy(op.tx.begin(), op.tx.end(), buf.begin() + 1);
+        err = write(std::span(buf.data(), op.tx.size() + 1), timeout);
+      }
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+    return ESP_OK;
+  }
+
   /// Check if device handle is valid
   [[nodiscard]] virtual bool valid() const = 0;
 
@@ -45,6 +74,9 @@ public:
   [[nodiscard]] virtual uint16_t address() const = 0;
 
 protected:
+  /// Largest register write (reg + data) the default transfer() supports
+  static constexpr size_t MAX_FALLBACK_WRITE = 32;
+
   IDevice() = default;
 };
 
@@ -66,6 +98,19 @@ public:
   [[nodiscard]] virtual bool probe(uint16_t address,
                                    Timeout timeout = DEFAULT_PROBE_TIMEOUT) = 0;
 
+  /// Probe every address in [first, last] and collect those that ACK
+  [[nodiscard]] virtual AddressSet
+  scan(uint16_t first = FIRST_ADDRESS, uint16_t last = LAST_ADDRESS,
+       Timeout timeout = DEFAULT_SCAN_TIMEOUT) {
+    AddressSet found;
+    for (uint16_t addr = first; addr <= last; ++addr) {
+      if (probe(addr, timeout)) {
+        found.insert(addr);
+      }
+    }
+    return found;
+  }
+
   /// Check if bus handle is valid
   [[nodiscard]] virtual bool valid() const = 0;
 
@@ -9,7 +9,11 @@
 #include "types.hpp"
 
 #include <driver/i2c_master.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
@@ -22,6 +26,63 @@ namespace driver::i2c {
 /// Forward declaration
 class Master;
 
+/// Completion signal for a device on an asynchronous bus
+///
+/// The driver's on_trans_done ISR callback records the result and gives the
+/// semaphore; the submitting task blocks on it with a bounded timeout.
+class Completion {
+public:
+  Completion() : sem_(xSemaphoreCreateBinaryStatic(&sem_buffer_)) {}
+  ~Completion() { vSemaphoreDelete(sem_); }
+
+  Completion(const Completion &) = delete;
+  Completion &operator=(const Completion &) = delete;
+  Completion(Completion &&) = delete;
+  Completion &operator=(Completion &&) = delete;
+
+  /// Wait for the in-flight transfer
+  /// @return Transfer result, or ESP_ERR_TIMEOUT if it did not complete
+  [[nodiscard]] esp_err_t wait(Timeout timeout) {
+    TickType_t ticks = timeout.count() < 0 ? portMAX_DELAY
+                                           : pdMS_TO_TICKS(timeout.count());
+    if (xSemaphoreTake(sem_, ticks) != pdTRUE) {
+      return ESP_ERR_TIMEOUT;
+    }
+    return result_;
+  }
+
+  /// Discard a late completion left over from a timed-out transfer
+  void reset() { (void)xSemaphoreTake(sem_, 0); }
+
+  /// ISR callback registered with i2c_master_register_event_callbacks
+  static bool IRAM_ATTR on_done(i2c_master_dev_handle_t /*dev*/,
+                                const i2c_master_event_data_t *evt,
+                                void *arg) {
+    auto *self = static_cast<Completion *>(arg);
+    switch (evt->event) {
+    case I2C_EVENT_DONE:
+      self->result_ = ESP_OK;
+      break;
+    case I2C_EVENT_TIMEOUT:
+      self->result_ = ESP_ERR_TIMEOUT;
+      break;
+    case I2C_EVENT_NACK:
+      self->result_ = ESP_FAIL;
+      break;
+    default:
+      return false; // Still in progress
+    }
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(self->sem_, &woken);
+    return woken == pdTRUE;
+  }
+
+private:
+  StaticSemaphore_t sem_buffer_{};
+  SemaphoreHandle_t sem_;
+  volatile esp_err_t result_ = ESP_OK;
+};
+
 /**
  * @brief RAII I2C device handle
  *
@@ -41,7 +102,9 @@ public:
   Device(const Device &) = delete;
   Device &operator=(const Device &) = delete;
 
-  Device(Device &&other) noexcept : handle_(other.handle_), addr_(other.addr_) {
+  Device(Device &&other) noexcept
+      : handle_(other.handle_), bus_(other.bus_), addr_(other.addr_),
+        completion_(std::move(other.completion_)) {
     other.handle_ = nullptr;
   }
 
@@ -51,35 +114,105 @@ public:
         i2c_master_bus_rm_device(handle_);
       }
       handle_ = other.handle_;
+      bus_ = other.bus_;
       addr_ = other.addr_;
+      completion_ = std::move(other.completion_);
       other.handle_ = nullptr;
     }
     return *this;
   }
 
+  /// @name Blocking operations
+  /// On an asynchronous bus these submit the transfer and then block on
+  /// its completion, so a stuck bus ends in ESP_ERR_TIMEOUT.
+  /// @{
+
   /// Write data to device
   [[nodiscard]] esp_err_t write(std::span<const uint8_t> data,
                                 Timeout timeout = FOREVER) override {
-    return i2c_master_transmit(handle_, data.data(), data.size(),
-                               to_ms(timeout));
+    return complete(start_write(data, timeout), timeout);
   }
 
   /// Read data from device
   [[nodiscard]] esp_err_t read(std::span<uint8_t> buffer,
                                Timeout timeout = FOREVER) override {
-    return i2c_master_receive(handle_, buffer.data(), buffer.size(),
-                              to_ms(timeout));
+    return complete(start_read(buffer, timeout), timeout);
   }
 
   /// Write then read (combined transaction)
   [[nodiscard]] esp_err_t write_read(std::span<const uint8_t> tx_data,
                                      std::span<uint8_t> rx_buffer,
                                      Timeout timeout = FOREVER) override {
+    return complete(start_write_read(tx_data, rx_buffer, timeout), timeout);
+  }
+
+  /// Execute register ops as one bus operation (single STOP at the end)
+  [[nodiscard]] esp_err_t transfer(std::span<const RegisterOp> ops,
+                                   Timeout timeout = FOREVER) override {
+    if (is_async()) {
+      // Defined-operation lists are not queued by the async driver
+      return IDevice::transfer(ops, timeout);
+    }
+    std::array<uint8_t, 2> addr = {static_cast<uint8_t>(addr_ << 1),
+                                   static_cast<uint8_t>((addr_ << 1) | 1)};
+    while (!ops.empty()) {
+      auto chunk = ops.first(std::min(ops.size(), MAX_TRANSFER_OPS));
+      if (auto err = transfer_chunk(chunk, addr, timeout); err != ESP_OK) {
+        return err;
+      }
+      ops = ops.subspan(chunk.size());
+    }
+    return ESP_OK;
+  }
+
+  /// @}
+
+  /// @name Non-blocking operations (asynchronous bus only)
+  /// start_*() queue the transfer and return; buffers must stay valid until
+  /// wait() returns. On a synchronous bus they complete before returning.
+  /// @{
+
+  [[nodiscard]] esp_err_t start_write(std::span<const uint8_t> data,
+                                      Timeout timeout = FOREVER) {
+    prepare();
+    return i2c_master_transmit(handle_, data.data(), data.size(),
+                               to_ms(timeout));
+  }
+
+  [[nodiscard]] esp_err_t start_read(std::span<uint8_t> buffer,
+                                     Timeout timeout = FOREVER) {
+    prepare();
+    return i2c_master_receive(handle_, buffer.data(), buffer.size(),
+                              to_ms(timeout));
+  }
+
+  [[nodiscard]] esp_err_t start_write_read(std::span<const uint8_t> tx_data,
+                                           std::span<uint8_t> rx_buffer,
+                                           Timeout timeout = FOREVER) {
+    prepare();
     return i2c_master_transmit_receive(handle_, tx_data.data(), tx_data.size(),
                                        rx_buffer.data(), rx_buffer.size(),
                                        to_ms(timeout));
   }
 
+  /// Wait for the transfer started by start_*()
+  /// @return ESP_ERR_TIMEOUT only once the driver is done with the buffers
+  [[nodiscard]] esp_err_t wait(Timeout timeout = FOREVER) {
+    if (!completion_) {
+      return ESP_OK;
+    }
+    auto err = completion_->wait(timeout);
+    if (err == ESP_ERR_TIMEOUT) {
+      drain();
+    }
+    return err;
+  }
+
+  /// True if this device was added to a bus with a transaction queue
+  [[nodiscard]] bool is_async() const { return completion_ != nullptr; }
+
+  /// @}
+
   /// Write single byte
   [[nodiscard]] esp_err_t write_byte(uint8_t byte, Timeout timeout = FOREVER) {
     return write(std::span(&byte, 1), timeout);
@@ -126,11 +259,88 @@ public:
 private:
   friend class Master;
 
-  Device(i2c_master_dev_handle_t handle, uint16_t addr)
-      : handle_(handle), addr_(addr) {}
+  /// Ops chained per i2c_master_execute_defined_operations() call
+  static constexpr size_t MAX_TRANSFER_OPS = 8;
+  /// Worst case per op (read): START, addr+W, reg, START, addr+R, READ, READ
+  static constexpr size_t JOBS_PER_OP = 7;
+
+  Device(i2c_master_dev_handle_t handle, uint16_t addr,
+         i2c_master_bus_handle_t bus = nullptr,
+         std::unique_ptr<Completion> completion = nullptr)
+      : handle_(handle), bus_(bus), addr_(addr),
+        completion_(std::move(completion)) {}
+
+  void prepare() {
+    if (completion_) {
+      completion_->reset();
+    }
+  }
+
+  /// After a wait() timeout: the queued transfer still points at the
+  /// caller's buffers, often on its stack, so it must end before the caller
+  /// returns. The bus's own transfer timeout ends a stuck one.
+  void drain() {
+    (void)i2c_master_bus_wait_all_done(bus_, -1);
+    completion_->reset(); // Its late completion
+  }
+
+  /// Finish a submitted transfer (no-op on a synchronous bus)
+  [[nodiscard]] esp_err_t complete(esp_err_t submitted, Timeout timeout) {
+    if (submitted != ESP_OK) {
+      return submitted;
+    }
+    return wait(timeout);
+  }
+
+  [[nodiscard]] esp_err_t transfer_chunk(std::span<const RegisterOp> ops,
+                                         std::array<uint8_t, 2> &addr,
+                                         Timeout timeout) {
+    std::array<i2c_operation_job_t, (MAX_TRANSFER_OPS * JOBS_PER_OP) + 1>
+        jobs{};
+    size_t n = 0;
+
+    auto start = [&] { jobs.at(n++).command = I2C_MASTER_CMD_START; };
+    auto send = [&](const uint8_t *data, size_t len) {
+      auto &job = jobs.at(n++);
+      job.command = I2C_MASTER_CMD_WRITE;
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+      job.write = {.ack_check = true,
+                   .data = const_cast<uint8_t *>(data),
+                   .total_bytes = len};
+    };
+    auto recv = [&](uint8_t *data, size_t len, i2c_ack_value_t ack) {
+      auto &job = jobs.at(n++);
+      job.command = I2C_MASTER_CMD_READ;
+      job.read = {.ack_value = ack, .data = data, .total_bytes = len};
+    };
+
+    for (const auto &op : ops) {
+      start();
+      send(&addr[0], 1);
+      send(&op.reg, 1);
+      if (op.kind == RegisterOp::Kind::Write) {
+        if (!op.tx.empty()) {
+          send(op.tx.data(), op.tx.size());
+        }
+      } else if (!op.rx.empty()) {
+        start();
+        send(&addr[1], 1);
+        if (op.rx.size() > 1) {
+          recv(op.rx.data(), op.rx.size() - 1, I2C_ACK_VAL);
+        }
+        recv(&op.rx.back(), 1, I2C_NACK_VAL);
+      }
+    }
+    jobs.at(n++).command = I2C_MASTER_CMD_STOP;
+
+    return i2c_master_execute_defined_operations(handle_, jobs.data(), n,
+                                                 to_ms(timeout));
+  }
 
   i2c_master_dev_handle_t handle_ = nullptr;
+  i2c_master_bus_handle_t bus_ = nullptr; ///< For drain() (async bus only)
   uint16_t addr_ = 0;
+  std::unique_ptr<Completion> completion_;
 };
 
 /// I2C bus configuration
@@ -141,6 +351,11 @@ struct Config {
   uint32_t freq_hz = DEFAULT_FREQ_HZ;
   bool enable_internal_pullup = true;
   uint8_t glitch_ignore_cnt = 7;
+  /// Pending transfers per bus; >0 enables asynchronous (ISR-completed)
+  /// transfers, 0 keeps the driver's synchronous polling mode. An
+  /// asynchronous bus runs Device::transfer() op by op (the driver doesn't
+  /// queue defined-operation lists)
+  size_t trans_queue_depth = 0;
 };
 
 /**
@@ -151,7 +366,8 @@ struct Config {
  */
 class Master final : public IMaster {
 public:
-  explicit Master(const Config &config) : freq_hz_(config.freq_hz) {
+  explicit Master(const Config &config)
+      : freq_hz_(config.freq_hz), async_(config.trans_queue_depth > 0) {
     i2c_master_bus_config_t bus_config = {
         .i2c_port = config.port,
         .sda_io_num = config.sda_pin,
@@ -159,7 +375,7 @@ public:
         .clk_source = I2C_CLK_SRC_DEFAULT,
         .glitch_ignore_cnt = config.glitch_ignore_cnt,
         .intr_priority = 0,
-        .trans_queue_depth = 0, // Synchronous mode
+        .trans_queue_depth = config.trans_queue_depth,
         .flags =
             {
                 .enable_internal_pullup =
@@ -182,7 +398,8 @@ public:
   Master &operator=(const Master &) = delete;
 
   Master(Master &&other) noexcept
-      : handle_(other.handle_), freq_hz_(other.freq_hz_) {
+      : handle_(other.handle_), freq_hz_(other.freq_hz_),
+        async_(other.async_) {
     other.handle_ = nullptr;
   }
 
@@ -193,6 +410,7 @@ public:
       }
       handle_ = other.handle_;
       freq_hz_ = other.freq_hz_;
+      async_ = other.async_;
       other.handle_ = nullptr;
     }
     return *this;
@@ -232,7 +450,21 @@ public:
       return {};
     }
 
-    return {dev_handle, address};
+    if (!async_) {
+      return {dev_handle, address};
+    }
+
+    auto completion = std::make_unique<Completion>();
+    i2c_master_event_callbacks_t callbacks = {
+        .on_trans_done = &Completion::on_done,
+    };
+    err = i2c_master_register_event_callbacks(dev_handle, &callbacks,
+                                              completion.get());
+    if (err != ESP_OK) {
+      i2c_master_bus_rm_device(dev_handle);
+      return {};
+    }
+    return {dev_handle, address, handle_, std::move(completion)};
   }
 
   /// Probe for device at address (check if it ACKs)
@@ -241,18 +473,6 @@ public:
     return i2c_master_probe(handle_, address, to_ms(timeout)) == ESP_OK;
   }
 
-  /// Scan bus and return list of responding addresses
-  [[nodiscard]] std::vector<uint16_t> scan(uint16_t start = 0x08,
-                                           uint16_t end = 0x77) {
-    std::vector<uint16_t> found;
-    for (uint16_t addr = start; addr <= end; ++addr) {
-      if (probe(addr)) {
-        found.push_back(addr);
-      }
-    }
-    return found;
-  }
-
   [[nodiscard]] bool valid() const override { return handle_ != nullptr; }
   [[nodiscard]] explicit operator bool() const { return valid(); }
 
@@ -260,9 +480,12 @@ public:
     return handle_;
   }
 
+  [[nodiscard]] bool is_async() const { return async_; }
+
 private:
   i2c_master_bus_handle_t handle_ = nullptr;
   uint32_t freq_hz_;
+  bool async_ = false;
 };
 
 } // namespace driver::i2c
@@ -0,0 +1,181 @@
+/**
+ * @file registry.hpp
+ * @brief I2C driver registry for bus auto-discovery
+ *
+ * Drivers register a ChipSignature (candidate addresses plus a chip-id
+ * register and expected value) together with a factory. discover() probes
+ * only the candidate addresses (each once, not the whole 7-bit range),
+ * reads the chip-id register only on those that ACKed, and calls the
+ * factory of the first matching driver. One firmware image
+ * can then boot on board variants with different sensor populations
+ * without a sequence of failing add_device calls.
+ *
+ * layout() records where discover() found each driver. A device waking
+ * from deep sleep on the same board can keep it in RTC memory and call
+ * attach() instead, which creates the same drivers without scanning the
+ * bus or reading chip ids.
+ */
+
+#pragma once
+
+#include "interface.hpp"
+#include "types.hpp"
+
+#include <esp_log.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+namespace driver::i2c {
+
+/// Identifies a chip on the bus
+struct ChipSignature {
+  static constexpr size_t MAX_ADDRESSES = 4;
+
+  std::array<uint16_t, MAX_ADDRESSES> addresses{};
+  size_t address_count = 0;
+  uint8_t id_register = 0;
+  uint8_t id_value = 0;
+  uint8_t id_mask = 0xFF;
+
+  [[nodiscard]] std::span<const uint16_t> candidates() const {
+    return {addresses.data(), address_count};
+  }
+
+  [[nodiscard]] bool matches(uint8_t chip_id) const {
+    return (chip_id & id_mask) == (id_value & id_mask);
+  }
+};
+
+/// Fixed-capacity registry of I2C drivers
+/// @tparam MaxDrivers Maximum number of registered drivers
+template <size_t MaxDrivers = 8> class DriverRegistry {
+public:
+  /// Factory invoked for a detected chip; return false if it failed
+  using Factory = std::function<bool(IMaster &bus, uint16_t address)>;
+
+  /// Per driver (in add() order), a bit for each candidate address it was
+  /// instantiated on
+  using Layout = std::array<uint8_t, MaxDrivers>;
+  static_assert(ChipSignature::MAX_ADDRESSES <= 8, "Candidate bit per byte");
+
+  /// Register a driver
+  /// @return false if the registry is full
+  bool add(const char *name, const ChipSignature &signature, Factory factory) {
+    if (count_ >= entries_.size()) {
+      return false;
+    }
+    entries_.at(count_++) = {name, signature, std::move(factory)};
+    return true;
+  }
+
+  /// Probe the candidate addresses and instantiate every registered driver
+  /// that is present
+  /// @return Number of drivers instantiated
+  size_t discover(IMaster &bus, Timeout timeout = DEFAULT_SCAN_TIMEOUT) {
+    AddressSet probed;
+    AddressSet present;
+    AddressSet claimed;
+    size_t created = 0;
+    layout_.fill(0);
+    for (size_t i = 0; i < count_; ++i) {
+      const auto &entry = entries_.at(i);
+      auto candidates = entry.signature.candidates();
+      for (size_t c = 0; c < candidates.size(); ++c) {
+        uint16_t addr = candidates[c];
+        if (!probed.contains(addr)) {
+          probed.insert(addr);
+          if (bus.probe(addr, timeout)) {
+            present.insert(addr);
+          }
+        }
+        if (!present.contains(addr) || claimed.contains(addr)) {
+          continue;
+        }
+        if (!chip_matches(bus, addr, entry.signature)) {
+          continue;
+        }
+        claimed.insert(addr);
+        if (entry.factory(bus, addr)) {
+          ESP_LOGI(TAG, "Found %s at 0x%02X", entry.name, addr);
+          layout_.at(i) |= static_cast<uint8_t>(1U << c);
+          ++created;
+        } else {
+          ESP_LOGW(TAG, "%s at 0x%02X failed to initialize", entry.name,
+                   addr);
+        }
+      }
+    }
+
+    ESP_LOGI(TAG, "Probed %zu candidate address(es), %zu responding",
+             probed.size(), present.size());
+    present.for_each([&claimed](uint16_t addr) {
+      if (!claimed.contains(addr)) {
+        ESP_LOGD(TAG, "No matching chip at 0x%02X", addr);
+      }
+    });
+    return created;
+  }
+
+  /// Instantiate the drivers of an earlier discover() without probing
+  /// @param layout That discover()'s layout(), same drivers in the same order
+  /// @return Number of drivers instantiated (fewer if a factory failed)
+  size_t attach(IMaster &bus, const Layout &layout) {
+    size_t created = 0;
+    layout_.fill(0);
+    for (size_t i = 0; i < count_; ++i) {
+      const auto &entry = entries_.at(i);
+      auto candidates = entry.signature.candidates();
+      for (size_t c = 0; c < candidates.size(); ++c) {
+        if ((layout.at(i) & (1U << c)) == 0) {
+          continue;
+        }
+        if (entry.factory(bus, candidates[c])) {
+          layout_.at(i) |= static_cast<uint8_t>(1U << c);
+          ++created;
+        } else {
+          ESP_LOGW(TAG, "%s at 0x%02X failed to initialize", entry.name,
+                   candidates[c]);
+        }
+      }
+    }
+    return created;
+  }
+
+  /// Drivers the last discover() or attach() instantiated
+  [[nodiscard]] const Layout &layout() const { return layout_; }
+
+  [[nodiscard]] size_t size() const { return count_; }
+
+private:
+  static constexpr const char *TAG = "i2c_registry";
+
+  struct Entry {
+    const char *name = nullptr;
+    ChipSignature signature{};
+    Factory factory;
+  };
+
+  [[nodiscard]] static bool chip_matches(IMaster &bus, uint16_t address,
+                                         const ChipSignature &signature) {
+    auto device = bus.create_device(address);
+    if (!device) {
+      return false;
+    }
+    uint8_t chip_id = 0;
+    const uint8_t reg = signature.id_register;
+    if (device->write_read(std::span(&reg, 1), std::span(&chip_id, 1),
+                           DEFAULT_PROBE_TIMEOUT) != ESP_OK) {
+      return false;
+    }
+    return signature.matches(chip_id);
+  }
+
+  std::array<Entry, MaxDrivers> entries_{};
+  size_t count_ = 0;
+  Layout layout_{};
+};
+
+} // namespace driver::i2c
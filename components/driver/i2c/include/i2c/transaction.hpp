@@ -0,0 +1,72 @@
+/**
+ * @file transaction.hpp
+ * @brief Register transaction lists executed as one bus operation
+ *
+ * A Transaction collects register writes and reads. IDevice::transfer()
+ * submits the whole list at once: on the ESP-IDF master driver it becomes a
+ * single i2c_master_execute_defined_operations() call (repeated STARTs
+ * between ops, one STOP at the end) instead of one transmit/receive per
+ * register access.
+ *
+ * Buffers are referenced, not copied - they must outlive transfer().
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace driver::i2c {
+
+/// One register access in a transaction
+struct RegisterOp {
+  enum class Kind : uint8_t { Write, Read };
+
+  Kind kind = Kind::Write;
+  uint8_t reg = 0;
+  std::span<const uint8_t> tx; ///< Data written after reg (Write)
+  std::span<uint8_t> rx;       ///< Destination for data read (Read)
+};
+
+/// Fixed-capacity transaction builder
+/// @tparam MaxOps Maximum register accesses per transaction
+template <size_t MaxOps = 8> class Transaction {
+public:
+  static constexpr size_t MAX_OPS = MaxOps;
+
+  /// Append a register write (reg followed by data)
+  /// @return false if the transaction is full
+  bool write(uint8_t reg, std::span<const uint8_t> data) {
+    return append(
+        {.kind = RegisterOp::Kind::Write, .reg = reg, .tx = data, .rx = {}});
+  }
+
+  /// Append a register read into buffer
+  /// @return false if the transaction is full
+  bool read(uint8_t reg, std::span<uint8_t> buffer) {
+    return append(
+        {.kind = RegisterOp::Kind::Read, .reg = reg, .tx = {}, .rx = buffer});
+  }
+
+  [[nodiscard]] std::span<const RegisterOp> ops() const {
+    return {ops_.data(), count_};
+  }
+
+  [[nodiscard]] bool empty() const { return count_ == 0; }
+  void clear() { count_ = 0; }
+
+private:
+  bool append(const RegisterOp &op) {
+    if (count_ >= ops_.size()) {
+      return false;
+    }
+    ops_.at(count_++) = op;
+    return true;
+  }
+
+  std::array<RegisterOp, MAX_OPS> ops_{};
+  size_t count_ = 0;
+};
+
+} // namespace driver::i2c
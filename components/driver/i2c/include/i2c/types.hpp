@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <bitset>
 #include <chrono>
 #include <cstdint>
 
@@ -19,6 +20,43 @@ inline constexpr Timeout FOREVER{-1};
 /// Default timeout for probe operations
 inline constexpr Timeout DEFAULT_PROBE_TIMEOUT{100};
 
+/// Per-address timeout used when scanning the whole bus
+inline constexpr Timeout DEFAULT_SCAN_TIMEOUT{10};
+
+/// First and last non-reserved 7-bit addresses
+inline constexpr uint16_t FIRST_ADDRESS = 0x08;
+inline constexpr uint16_t LAST_ADDRESS = 0x77;
+
+/// Set of 7-bit addresses (result of a bus scan, no heap)
+class AddressSet {
+public:
+  void insert(uint16_t address) {
+    if (address < BITS) {
+      bits_.set(address);
+    }
+  }
+
+  [[nodiscard]] bool contains(uint16_t address) const {
+    return address < BITS && bits_.test(address);
+  }
+
+  [[nodiscard]] size_t size() const { return bits_.count(); }
+  [[nodiscard]] bool empty() const { return bits_.none(); }
+
+  /// Visit each address in ascending order
+  template <typename Func> void for_each(const Func &callback) const {
+    for (uint16_t addr = 0; addr < BITS; ++addr) {
+      if (bits_.test(addr)) {
+        callback(addr);
+      }
+    }
+  }
+
+private:
+  static constexpr size_t BITS = 128;
+  std::bitset<BITS> bits_;
+};
+
 /// Default I2C clock frequency (400 kHz / Fast Mode)
 inline constexpr uint32_t DEFAULT_FREQ_HZ = 400'000;
 
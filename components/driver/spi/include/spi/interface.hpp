@@ -0,0 +1,86 @@
+/**
+ * @file interface.hpp
+ * @brief Abstract SPI interfaces for dependency injection and testing
+ *
+ * Mirrors driver::i2c::IDevice / IMaster, so a register-based driver can
+ * take either bus. Every call is one chip-select frame: write_read() and
+ * the register helpers keep CS asserted from the first byte to the last.
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <esp_err.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace driver::spi {
+
+/// Abstract SPI device interface
+class IDevice {
+public:
+  virtual ~IDevice() = default;
+
+  IDevice(const IDevice &) = delete;
+  IDevice &operator=(const IDevice &) = delete;
+  IDevice(IDevice &&) = default;
+  IDevice &operator=(IDevice &&) = default;
+
+  /// Write data to device
+  [[nodiscard]] virtual esp_err_t write(std::span<const uint8_t> data,
+                                        Timeout timeout = FOREVER) = 0;
+
+  /// Read data from device (MOSI idle)
+  [[nodiscard]] virtual esp_err_t read(std::span<uint8_t> buffer,
+                                       Timeout timeout = FOREVER) = 0;
+
+  /// Write then read in one frame
+  [[nodiscard]] virtual esp_err_t write_read(std::span<const uint8_t> tx_data,
+                                             std::span<uint8_t> rx_buffer,
+                                             Timeout timeout = FOREVER) = 0;
+
+  /// Read from register (DeviceConfig::read_flag set in reg)
+  [[nodiscard]] virtual esp_err_t read_register(uint8_t reg,
+                                                std::span<uint8_t> buffer,
+                                                Timeout timeout = FOREVER) = 0;
+
+  /// Write to register (reg + data in one frame, read_flag cleared)
+  [[nodiscard]] virtual esp_err_t
+  write_register(uint8_t reg, std::span<const uint8_t> data,
+                 Timeout timeout = FOREVER) = 0;
+
+  /// Check if device handle is valid
+  [[nodiscard]] virtual bool valid() const = 0;
+
+  /// Get chip select pin
+  [[nodiscard]] virtual gpio_num_t cs_pin() const = 0;
+
+protected:
+  IDevice() = default;
+};
+
+/// Abstract SPI master bus interface
+class IMaster {
+public:
+  virtual ~IMaster() = default;
+
+  IMaster(const IMaster &) = delete;
+  IMaster &operator=(const IMaster &) = delete;
+  IMaster(IMaster &&) = default;
+  IMaster &operator=(IMaster &&) = default;
+
+  /// Add a device to this bus
+  [[nodiscard]] virtual std::unique_ptr<IDevice>
+  create_device(const DeviceConfig &config) = 0;
+
+  /// Check if bus handle is valid
+  [[nodiscard]] virtual bool valid() const = 0;
+
+protected:
+  IMaster() = default;
+};
+
+} // namespace driver::spi
@@ -0,0 +1,286 @@
+/**
+ * @file master.hpp
+ * @brief RAII SPI master driver implementing the SPI interfaces
+ *
+ * Transfers are polled: register accesses are a few bytes to a few dozen,
+ * shorter than an interrupt round trip. Without DMA the controller moves
+ * MAX_CHUNK bytes per transaction; longer frames are chained with CS held.
+ */
+
+#pragma once
+
+#include "interface.hpp"
+#include "types.hpp"
+
+#include <driver/spi_master.h>
+#include <freertos/FreeRTOS.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace driver::spi {
+
+/// Forward declaration
+class Master;
+
+/**
+ * @brief RAII SPI device handle
+ *
+ * Represents a device (chip select) on an SPI bus. Automatically
+ * deregisters from the bus when destroyed.
+ */
+class Device final : public IDevice {
+public:
+  Device() = default;
+
+  ~Device() override {
+    if (handle_ != nullptr) {
+      spi_bus_remove_device(handle_);
+    }
+  }
+
+  Device(const Device &) = delete;
+  Device &operator=(const Device &) = delete;
+
+  Device(Device &&other) noexcept
+      : handle_(other.handle_), cs_pin_(other.cs_pin_),
+        read_flag_(other.read_flag_) {
+    other.handle_ = nullptr;
+  }
+
+  Device &operator=(Device &&other) noexcept {
+    if (this != &other) {
+      if (handle_ != nullptr) {
+        spi_bus_remove_device(handle_);
+      }
+      handle_ = other.handle_;
+      cs_pin_ = other.cs_pin_;
+      read_flag_ = other.read_flag_;
+      other.handle_ = nullptr;
+    }
+    return *this;
+  }
+
+  /// Write data to device
+  [[nodiscard]] esp_err_t write(std::span<const uint8_t> data,
+                                Timeout timeout = FOREVER) override {
+    std::array<Segment, 1> frame{{{data.data(), nullptr, data.size()}}};
+    return run(frame, timeout);
+  }
+
+  /// Read data from device
+  [[nodiscard]] esp_err_t read(std::span<uint8_t> buffer,
+                               Timeout timeout = FOREVER) override {
+    std::array<Segment, 1> frame{{{nullptr, buffer.data(), buffer.size()}}};
+    return run(frame, timeout);
+  }
+
+  /// Write then read in one frame
+  [[nodiscard]] esp_err_t write_read(std::span<const uint8_t> tx_data,
+                                     std::span<uint8_t> rx_buffer,
+                                     Timeout timeout = FOREVER) override {
+    std::array<Segment, 2> frame{{
+        {tx_data.data(), nullptr, tx_data.size()},
+        {nullptr, rx_buffer.data(), rx_buffer.size()},
+    }};
+    return run(frame, timeout);
+  }
+
+  /// Read from register
+  [[nodiscard]] esp_err_t read_register(uint8_t reg, std::span<uint8_t> buffer,
+                                        Timeout timeout = FOREVER) override {
+    auto addr = static_cast<uint8_t>(reg | read_flag_);
+    return write_read(std::span(&addr, 1), buffer, timeout);
+  }
+
+  /// Read single byte from register
+  [[nodiscard]] esp_err_t read_register_byte(uint8_t reg, uint8_t &out,
+                                             Timeout timeout = FOREVER) {
+    return read_register(reg, std::span(&out, 1), timeout);
+  }
+
+  /// Write to register (address + data, no intermediate copy)
+  [[nodiscard]] esp_err_t write_register(uint8_t reg,
+                                         std::span<const uint8_t> data,
+                                         Timeout timeout = FOREVER) override {
+    auto addr = static_cast<uint8_t>(reg & ~read_flag_);
+    std::array<Segment, 2> frame{{
+        {&addr, nullptr, 1},
+        {data.data(), nullptr, data.size()},
+    }};
+    return run(frame, timeout);
+  }
+
+  /// Write single byte to register
+  [[nodiscard]] esp_err_t write_register_byte(uint8_t reg, uint8_t value,
+                                              Timeout timeout = FOREVER) {
+    return write_register(reg, std::span(&value, 1), timeout);
+  }
+
+  [[nodiscard]] bool valid() const override { return handle_ != nullptr; }
+  [[nodiscard]] explicit operator bool() const { return valid(); }
+
+  [[nodiscard]] gpio_num_t cs_pin() const override { return cs_pin_; }
+  [[nodiscard]] spi_device_handle_t native_handle() const { return handle_; }
+
+private:
+  friend class Master;
+
+  /// Part of a frame: bytes out (tx) or in (rx)
+  struct Segment {
+    const uint8_t *tx;
+    uint8_t *rx;
+    size_t len;
+  };
+
+  Device(spi_device_handle_t handle, const DeviceConfig &config)
+      : handle_(handle), cs_pin_(config.cs_pin), read_flag_(config.read_flag) {}
+
+  /// Clock out the segments as one frame (CS asserted throughout)
+  [[nodiscard]] esp_err_t run(std::span<const Segment> frame,
+                              Timeout timeout) {
+    if (handle_ == nullptr) {
+      return ESP_ERR_INVALID_STATE;
+    }
+    TickType_t ticks = timeout.count() < 0 ? portMAX_DELAY
+                                           : pdMS_TO_TICKS(timeout.count());
+
+    // Held for the frame: no other device's transfer between its chunks
+    if (auto err = spi_device_acquire_bus(handle_, portMAX_DELAY);
+        err != ESP_OK) {
+      return err;
+    }
+
+    size_t remaining = 0;
+    for (const auto &segment : frame) {
+      remaining += segment.len;
+    }
+
+    esp_err_t err = ESP_OK;
+    for (const auto &segment : frame) {
+      for (size_t offset = 0; offset < segment.len && err == ESP_OK;) {
+        size_t len = std::min(segment.len - offset, MAX_CHUNK);
+        remaining -= len;
+
+        spi_transaction_t trans{};
+        trans.flags = remaining > 0 ? SPI_TRANS_CS_KEEP_ACTIVE : 0;
+        trans.length = len * 8;
+        trans.rxlength = segment.rx != nullptr ? len * 8 : 0;
+        trans.tx_buffer = segment.tx != nullptr ? segment.tx + offset : nullptr;
+        trans.rx_buffer = segment.rx != nullptr ? segment.rx + offset : nullptr;
+
+        err = spi_device_polling_start(handle_, &trans, ticks);
+        if (err == ESP_OK) {
+          err = spi_device_polling_end(handle_, ticks);
+        }
+        offset += len;
+      }
+    }
+
+    spi_device_release_bus(handle_);
+    return err;
+  }
+
+  spi_device_handle_t handle_ = nullptr;
+  gpio_num_t cs_pin_ = GPIO_NUM_NC;
+  uint8_t read_flag_ = 0;
+};
+
+/// SPI bus configuration
+struct Config {
+  gpio_num_t sclk_pin = GPIO_NUM_NC;
+  gpio_num_t mosi_pin = GPIO_NUM_NC;
+  gpio_num_t miso_pin = GPIO_NUM_NC;
+  spi_host_device_t host = SPI2_HOST; ///< The C3's only general-purpose SPI
+};
+
+/**
+ * @brief RAII SPI master bus
+ *
+ * Manages an SPI master bus and allows adding devices.
+ * Automatically frees the bus when destroyed.
+ */
+class Master final : public IMaster {
+public:
+  explicit Master(const Config &config) : host_(config.host) {
+    spi_bus_config_t bus_config{};
+    bus_config.sclk_io_num = config.sclk_pin;
+    bus_config.mosi_io_num = config.mosi_pin;
+    bus_config.miso_io_num = config.miso_pin;
+    bus_config.quadwp_io_num = -1;
+    bus_config.quadhd_io_num = -1;
+    bus_config.max_transfer_sz = MAX_CHUNK;
+
+    initialized_ =
+        spi_bus_initialize(host_, &bus_config, SPI_DMA_DISABLED) == ESP_OK;
+  }
+
+  ~Master() override {
+    if (initialized_) {
+      spi_bus_free(host_);
+    }
+  }
+
+  Master(const Master &) = delete;
+  Master &operator=(const Master &) = delete;
+
+  Master(Master &&other) noexcept
+      : host_(other.host_), initialized_(other.initialized_) {
+    other.initialized_ = false;
+  }
+
+  Master &operator=(Master &&other) noexcept {
+    if (this != &other) {
+      if (initialized_) {
+        spi_bus_free(host_);
+      }
+      host_ = other.host_;
+      initialized_ = other.initialized_;
+      other.initialized_ = false;
+    }
+    return *this;
+  }
+
+  /// Create a device on this bus (returns interface pointer)
+  [[nodiscard]] std::unique_ptr<IDevice>
+  create_device(const DeviceConfig &config) override {
+    auto device = add_device(config);
+    if (!device.valid()) {
+      return nullptr;
+    }
+    return std::make_unique<Device>(std::move(device));
+  }
+
+  /// Add a device on this bus (returns concrete type)
+  [[nodiscard]] Device add_device(const DeviceConfig &config) {
+    if (!initialized_) {
+      return {};
+    }
+
+    spi_device_interface_config_t dev_config{};
+    dev_config.mode = config.mode;
+    dev_config.clock_speed_hz = static_cast<int>(config.freq_hz);
+    dev_config.spics_io_num = config.cs_pin;
+    dev_config.queue_size = 1; // Polled transfers only
+
+    spi_device_handle_t dev_handle = nullptr;
+    if (spi_bus_add_device(host_, &dev_config, &dev_handle) != ESP_OK) {
+      return {};
+    }
+    return {dev_handle, config};
+  }
+
+  [[nodiscard]] bool valid() const override { return initialized_; }
+  [[nodiscard]] explicit operator bool() const { return valid(); }
+
+  [[nodiscard]] spi_host_device_t host() const { return host_; }
+
+private:
+  spi_host_device_t host_;
+  bool initialized_ = false;
+};
+
+} // namespace driver::spi
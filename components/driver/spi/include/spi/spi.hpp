@@ -0,0 +1,10 @@
+/**
+ * @file spi.hpp
+ * @brief SPI driver convenience header - includes all SPI components
+ */
+
+#pragma once
+
+#include "interface.hpp" // IWYU pragma: export
+#include "master.hpp"    // IWYU pragma: export
+#include "types.hpp"     // IWYU pragma: export
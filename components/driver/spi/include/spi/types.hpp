@@ -0,0 +1,39 @@
+/**
+ * @file types.hpp
+ * @brief Common SPI types and constants
+ */
+
+#pragma once
+
+#include <hal/gpio_types.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace driver::spi {
+
+/// Timeout duration for SPI operations
+using Timeout = std::chrono::milliseconds;
+
+/// Wait forever (blocking)
+inline constexpr Timeout FOREVER{-1};
+
+/// Default SPI clock frequency (1 MHz)
+inline constexpr uint32_t DEFAULT_FREQ_HZ = 1'000'000;
+
+/// Largest transfer without DMA (the controller's data buffer); longer
+/// ones are split into chunks with CS held
+inline constexpr size_t MAX_CHUNK = 64;
+
+/// One device (chip select) on a bus
+struct DeviceConfig {
+  gpio_num_t cs_pin = GPIO_NUM_NC;
+  uint32_t freq_hz = DEFAULT_FREQ_HZ;
+  uint8_t mode = 0; ///< CPOL/CPHA (0-3)
+  /// OR'ed into reg by read_register() and cleared by write_register(),
+  /// e.g. 0x80 for sensors with a read bit. 0 when the caller encodes it
+  /// (as Bosch's APIs do)
+  uint8_t read_flag = 0;
+};
+
+} // namespace driver::spi
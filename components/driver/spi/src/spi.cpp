@@ -0,0 +1,8 @@
+/**
+ * @file spi.cpp
+ * @brief SPI driver (header-only, kept for build system)
+ */
+
+namespace driver::detail {
+static const int spi_init = 1;
+}
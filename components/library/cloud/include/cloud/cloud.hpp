@@ -13,7 +13,16 @@
 #include "config.hpp"
 #include "credentials.hpp"
 #include "device_auth.hpp"
+#include "device_config.hpp"
+#include "device_info.hpp"
 #include "endpoints.hpp"
 #include "events.hpp"
+#include "json_reader.hpp"
+#include "jwt_signer.hpp"
 #include "measurement_serializer.hpp"
+#include "ota_delta.hpp"
+#include "ota_updater.hpp"
+#include "outbox.hpp"
+#include "payload_compressor.hpp"
+#include "telemetry_log.hpp"
 #include "telemetry_service.hpp"
@@ -8,6 +8,10 @@
  * - Protobuf serialization
  *
  * This class only handles: transport, auth injection, and raw HTTP.
+ *
+ * Requests go through a TransportSelector. With an MQTT broker configured,
+ * telemetry and command traffic prefer MQTT and fail over to HTTP;
+ * everything else (and any streamed upload) uses HTTP.
  */
 
 #pragma once
@@ -17,12 +21,14 @@
 
 #include <core/result.hpp>
 #include <transport/http_transport.hpp>
+#include <transport/mqtt_transport.hpp>
+#include <transport/selector.hpp>
 
 #include <esp_log.h>
 
+#include <chrono>
 #include <span>
 #include <string_view>
-#include <vector>
 
 namespace cloud {
 
@@ -38,25 +44,40 @@ enum class CloudError : uint8_t {
   RateLimited,
 };
 
-/// Generic API response (owns body data)
+/// Extras for a GET (see CloudClient::get)
+struct GetOptions {
+  /// Response format to ask for (the body may still be JSON)
+  transport::ContentType accept{transport::ContentType::Json};
+  /// ETag of the last body seen; an unchanged resource answers 304
+  std::string_view if_none_match{};
+  /// Longer network timeout for a long poll (0 = transport default)
+  std::chrono::milliseconds timeout{0};
+};
+
+/// Generic API response
+///
+/// The body is borrowed from the transport's response buffer: it is read in
+/// place and stays valid while the ApiResponse lives. Consume it (copy out
+/// what is needed) before issuing the next request from the same task.
 struct ApiResponse {
   bool success{false};
   int status_code{0};
   CloudError error{CloudError::None};
-  std::vector<uint8_t> body{}; // Owns response data
+  transport::Response raw{}; // Holds the body view and its lease
 
   /// Get body as string view
-  [[nodiscard]] std::string_view body_str() const {
-    return {reinterpret_cast<const char *>(body.data()), body.size()};
-  }
+  [[nodiscard]] std::string_view body_str() const { return raw.body_str(); }
+
+  /// Get body bytes
+  [[nodiscard]] std::span<const uint8_t> body() const { return raw.body(); }
 
   /// Check if body is empty
-  [[nodiscard]] bool body_empty() const { return body.empty(); }
+  [[nodiscard]] bool body_empty() const { return raw.empty(); }
 };
 
 /// Low-level cloud API client
 ///
-/// @thread_safety Thread-safe via HttpTransport's internal mutex.
+/// @thread_safety Thread-safe via the transports' internal mutexes.
 class CloudClient {
 public:
   CloudClient(DeviceAuthProvider &auth, const CloudConfig &config)
@@ -64,15 +85,22 @@ public:
 
   /// Initialize transport (call after WiFi connected)
   [[nodiscard]] core::Status init() {
-    transport::HttpTransportConfig transport_config{
-        .base_url = config_.base_url,
-        .timeout = config_.timeout,
-        .skip_cert_verify = config_.skip_cert_verify,
-    };
-
-    transport_.emplace(transport_config, &auth_);
+    // Keep the transport across stop()/start() so reconnects after a WiFi
+    // drop resume the TLS session
+    if (!transport_) {
+      transport::HttpTransportConfig transport_config{
+          .base_url = config_.base_url,
+          .timeout = config_.timeout,
+          .skip_cert_verify = config_.skip_cert_verify,
+          .ca_cert = config_.ca_cert,
+          .client_cert = config_.client_cert,
+          .client_key = config_.client_key,
+      };
+      transport_.emplace(transport_config, &auth_);
+      add_transports();
+    }
 
-    if (auto status = transport_->connect(); !status) {
+    if (auto status = selector_.connect(); !status) {
       ESP_LOGE(TAG, "Transport connect failed");
       return status;
     }
@@ -82,10 +110,40 @@ public:
   }
 
   /// POST raw bytes to an endpoint
-  [[nodiscard]] ApiResponse post(std::string_view path,
-                                 std::span<const uint8_t> body,
-                                 transport::ContentType content_type) {
-    return execute(transport::HttpMethod::Post, path, body, content_type);
+  [[nodiscard]] ApiResponse
+  post(std::string_view path, std::span<const uint8_t> body,
+       transport::ContentType content_type,
+       transport::ContentEncoding encoding =
+           transport::ContentEncoding::Identity,
+       std::span<const transport::QueryParam> params = {}) {
+    return execute(transport::HttpMethod::Post, path, body, content_type,
+                   encoding, params);
+  }
+
+  /// POST a body streamed from source (chunked, never buffered in full)
+  [[nodiscard]] ApiResponse
+  post_stream(std::string_view path, core::IBodySource &source,
+              transport::ContentType content_type,
+              std::span<const transport::QueryParam> params = {}) {
+    if (!transport_) {
+      return {.error = CloudError::NotInitialized};
+    }
+
+    if (auto err = ensure_auth(); err != CloudError::None) {
+      return {.error = err};
+    }
+
+    transport::Request request{
+        .method = transport::HttpMethod::Post,
+        .path = path,
+        .query_params = params,
+        .content_type = content_type,
+        .response_mode = transport::ResponseMode::Borrowed,
+        .body_source = &source,
+        .message_class = transport::MessageClass::Bulk,
+    };
+
+    return do_request(request);
   }
 
   /// POST with no body
@@ -101,37 +159,120 @@ public:
   }
 
   /// GET with query params
-  [[nodiscard]] ApiResponse get(std::string_view path,
-                                std::span<const transport::QueryParam> params) {
-    return execute_with_params(transport::HttpMethod::Get, path, params);
+  /// @param accept Response format to ask for (the body may still be JSON)
+  [[nodiscard]] ApiResponse
+  get(std::string_view path, std::span<const transport::QueryParam> params,
+      transport::ContentType accept = transport::ContentType::Json) {
+    return execute_with_params(transport::HttpMethod::Get, path, params,
+                               {.accept = accept});
+  }
+
+  /// Conditional or long-poll GET with query params
+  [[nodiscard]] ApiResponse
+  get(std::string_view path, std::span<const transport::QueryParam> params,
+      const GetOptions &options) {
+    return execute_with_params(transport::HttpMethod::Get, path, params,
+                               options);
   }
 
   /// PUT raw bytes to an endpoint
-  [[nodiscard]] ApiResponse put(std::string_view path,
-                                std::span<const uint8_t> body,
-                                transport::ContentType content_type) {
-    return execute(transport::HttpMethod::Put, path, body, content_type);
+  [[nodiscard]] ApiResponse
+  put(std::string_view path, std::span<const uint8_t> body,
+      transport::ContentType content_type,
+      transport::ContentEncoding encoding =
+          transport::ContentEncoding::Identity) {
+    return execute(transport::HttpMethod::Put, path, body, content_type,
+                   encoding);
   }
 
   [[nodiscard]] bool is_connected() const noexcept {
-    return transport_ && transport_->is_connected();
+    return transport_ && selector_.is_connected();
+  }
+
+  /// Socket reuse of telemetry, command and auth traffic on this client
+  [[nodiscard]] core::HttpConnectionStats connection_stats() const {
+    return transport_ ? transport_->connection_stats()
+                      : core::HttpConnectionStats{};
+  }
+
+  /// Routing and per-transport health (HTTP first, then MQTT if configured)
+  [[nodiscard]] const transport::TransportSelector &transports() const {
+    return selector_;
   }
 
   [[nodiscard]] bool is_revoked() const { return auth_.is_revoked(); }
 
   void disconnect() {
     if (transport_) {
-      (void)transport_->disconnect();
+      (void)selector_.disconnect();
+    }
+  }
+
+  /// Close the idle HTTP connection to free its TLS buffers (see
+  /// HttpTransport::release_connection())
+  /// @return false if it is in use or there is none
+  bool release_connection() {
+    return transport_ && transport_->release_connection();
+  }
+
+  /// Make an HTTP request blocked on another task return (see
+  /// HttpTransport::cancel_request())
+  void cancel_request() {
+    if (transport_) {
+      transport_->cancel_request();
     }
   }
 
 private:
   static constexpr const char *TAG = "CloudClient";
 
-  [[nodiscard]] ApiResponse execute(transport::HttpMethod method,
-                                    std::string_view path,
-                                    std::span<const uint8_t> body,
-                                    transport::ContentType content_type) {
+  /// Register HTTP (always) and MQTT (if configured) with the selector
+  void add_transports() {
+    auto http = selector_.add(*transport_, "http");
+    if (!http || config_.mqtt_broker_uri.empty()) {
+      return;
+    }
+
+    transport::MqttTransportConfig mqtt_config{
+        .broker_uri = config_.mqtt_broker_uri,
+        .client_id = config_.mqtt_client_id,
+        .topic_prefix = config_.mqtt_topic_prefix,
+        .timeout = config_.timeout,
+        .skip_cert_verify = config_.skip_cert_verify,
+        .ca_cert = config_.ca_cert,
+    };
+    mqtt_.emplace(mqtt_config, &auth_);
+    auto mqtt = selector_.add(*mqtt_, "mqtt");
+    if (!mqtt) {
+      return;
+    }
+
+    using transport::MessageClass;
+    (void)selector_.route(MessageClass::Telemetry, {*mqtt, *http});
+    (void)selector_.route(MessageClass::Commands, {*mqtt, *http});
+    (void)selector_.route(MessageClass::Default, {*http});
+    (void)selector_.route(MessageClass::Bulk, {*http});
+    ESP_LOGI(TAG, "Telemetry and commands via MQTT, HTTP fallback");
+  }
+
+  /// Routing class of a request to a backend endpoint
+  [[nodiscard]] static transport::MessageClass
+  classify(std::string_view path) {
+    if (path == endpoints::TELEMETRY_PROTO) {
+      return transport::MessageClass::Telemetry;
+    }
+    if (path.starts_with(endpoints::COMMANDS)) {
+      return transport::MessageClass::Commands;
+    }
+    return transport::MessageClass::Default;
+  }
+
+  [[nodiscard]] ApiResponse
+  execute(transport::HttpMethod method, std::string_view path,
+          std::span<const uint8_t> body, transport::ContentType content_type,
+          transport::ContentEncoding encoding =
+              transport::ContentEncoding::Identity,
+          std::span<const transport::QueryParam> params = {}) {
     if (!transport_) {
       return {.error = CloudError::NotInitialized};
     }
@@ -143,8 +284,12 @@ private:
     transport::Request request{
         .method = method,
         .path = path,
+        .query_params = params,
         .body = body,
         .content_type = content_type,
+        .content_encoding = encoding,
+        .response_mode = transport::ResponseMode::Borrowed,
+        .message_class = classify(path),
     };
 
     return do_request(request);
@@ -152,7 +297,8 @@ private:
 
   [[nodiscard]] ApiResponse
   execute_with_params(transport::HttpMethod method, std::string_view path,
-                      std::span<const transport::QueryParam> params) {
+                      std::span<const transport::QueryParam> params,
+                      const GetOptions &options) {
     if (!transport_) {
       return {.error = CloudError::NotInitialized};
     }
@@ -165,6 +311,11 @@ private:
         .method = method,
         .path = path,
         .query_params = params,
+        .accept = options.accept,
+        .response_mode = transport::ResponseMode::Borrowed,
+        .message_class = classify(path),
+        .if_none_match = options.if_none_match,
+        .timeout = options.timeout,
     };
 
     return do_request(request);
@@ -185,7 +336,7 @@ private:
   }
 
   [[nodiscard]] ApiResponse do_request(const transport::Request &request) {
-    auto result = transport_->send(request);
+    auto result = selector_.send(request);
 
     if (!result) {
       return {.error = CloudError::NetworkError};
@@ -193,16 +344,17 @@ private:
 
     auth_.handle_response_status(result->status_code());
 
+    // 304 only answers a conditional GET: nothing new, not a failure
     ApiResponse response{
-        .success = result->is_success(),
+        .success = result->is_success() || result->not_modified(),
         .status_code = result->status_code(),
-        .body = {result->body().begin(), result->body().end()},
+        .raw = std::move(*result),
     };
 
     if (!response.success) {
-      if (result->is_server_error()) {
+      if (response.raw.is_server_error()) {
         response.error = CloudError::ServerError;
-      } else if (result->status_code() == status::TOO_MANY_REQUESTS) {
+      } else if (response.status_code == status::TOO_MANY_REQUESTS) {
         response.error = CloudError::RateLimited;
       } else {
         response.error = CloudError::NetworkError;
@@ -215,6 +367,8 @@ private:
   DeviceAuthProvider &auth_;
   CloudConfig config_;
   std::optional<transport::HttpTransport> transport_;
+  std::optional<transport::MqttTransport> mqtt_;
+  transport::TransportSelector selector_; // Last: destroyed first
 };
 
 } // namespace cloud
@@ -19,21 +19,33 @@
 #include "config.hpp"
 #include "credentials.hpp"
 #include "device_auth.hpp"
+#include "device_info.hpp"
 #include "events.hpp"
 #include "measurement_serializer.hpp"
+#include "outbox.hpp"
+#include "payload_compressor.hpp"
 #include "telemetry_service.hpp"
 
+#include <core/clock.hpp>
 #include <core/event_loop.hpp>
 #include <core/result.hpp>
 #include <core/rtc_storage.hpp>
+#include <core/semaphore.hpp>
 #include <core/storage.hpp>
-#include <core/timer.hpp>
+#include <core/task.hpp>
+#include <core/timer_wheel.hpp>
+#include <proto/batch_stream.hpp>
 #include <proto/measurement_adapter.hpp>
 #include <sensor/measurement.hpp>
 
 #include <esp_log.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <functional>
 #include <memory>
 #include <span>
 
@@ -49,11 +61,51 @@ enum class CloudState : uint8_t {
   Error,
 };
 
+/// Timer-driven work, handed to the task that owns the manager
+enum class CloudWork : uint8_t {
+  PollCommands,
+  RefreshToken,
+};
+
+/// Receives CloudWork from the esp_timer task; post it to the owning task,
+/// which then calls CloudManager::run(work)
+using CloudWorkFn = std::function<void(CloudWork work)>;
+
 /// Cloud manager configuration
 struct CloudManagerConfig {
   std::chrono::minutes telemetry_interval{5};
-  std::chrono::minutes command_poll_interval{1};
+  std::chrono::seconds command_poll_interval{60};
+  /// Empty polls double the poll interval up to this; a command resets it
+  /// and a server-advertised X-Poll-Interval replaces it
+  std::chrono::seconds command_poll_max_interval{900};
+  /// Long poll: the backend holds GET /commands open up to this long and
+  /// answers as soon as a command is queued (0 = periodic polling). Keeps a
+  /// request in flight on its own task - for mains-powered units
+  std::chrono::seconds command_long_poll{0};
   bool skip_cert_verify{false};
+  /// PEM views passed to every transport (see CloudConfig::ca_cert)
+  std::string_view ca_cert{};
+  std::string_view client_cert{};
+  std::string_view client_key{};
+  /// Device key for locally signed tokens (see CloudConfig::jwt_key)
+  std::string_view jwt_key{};
+  std::string_view jwt_audience{};
+  /// Deflate telemetry / device-info bodies when that makes them smaller
+  /// (Content-Encoding: deflate; the backend must accept it)
+  bool compress_payloads{false};
+  /// Take pending commands from the telemetry response instead of a
+  /// separate poll (backend must honor `?commands=pending` on uploads).
+  /// The poll timer then only fires a request when no upload went out
+  /// since its last tick.
+  bool piggyback_commands{false};
+  /// Values with a fixed-point form as sint32 quantized_val instead of
+  /// floats (the backend must decode it)
+  proto::WireEncoding wire_encoding{proto::WireEncoding::Native};
+  /// MQTT broker for telemetry and commands, HTTP as fallback (empty =
+  /// HTTP only). Client id is the device id, topics "probes/<device_id>/..."
+  std::string_view mqtt_broker_uri{};
+  /// When queued routine telemetry is uploaded (see queue_telemetry())
+  OutboxConfig outbox{};
 };
 
 /// Cloud connectivity manager
@@ -62,9 +114,12 @@ struct CloudManagerConfig {
 /// 1. Call init() once at startup
 /// 2. Call start() when WiFi connects
 /// 3. Call stop() when WiFi disconnects
-/// 4. Call send_telemetry() to upload measurements immediately
+/// 4. Call send_telemetry() to upload measurements immediately, or
+///    queue_telemetry() + service_outbox() to batch routine data
 ///
-/// @thread_safety Not thread-safe. Call from main task only.
+/// @thread_safety Not thread-safe. Call from one task only; with a
+///                dispatcher set (set_dispatcher()) the timers hand their
+///                work to that task instead of running it themselves.
 class CloudManager {
 public:
   CloudManager(core::IStorage &creds_storage, core::RtcAuthToken &rtc_token,
@@ -94,7 +149,19 @@ public:
     // Build cloud config
     cloud_config_ = CloudConfig{
         .skip_cert_verify = config_.skip_cert_verify,
+        .ca_cert = config_.ca_cert,
+        .client_cert = config_.client_cert,
+        .client_key = config_.client_key,
+        .jwt_key = config_.jwt_key,
+        .jwt_audience = config_.jwt_audience,
     };
+    if (!config_.mqtt_broker_uri.empty()) {
+      std::snprintf(mqtt_topic_prefix_.data(), mqtt_topic_prefix_.size(),
+                    "probes/%s", credentials_.device_id.data());
+      cloud_config_.mqtt_broker_uri = config_.mqtt_broker_uri;
+      cloud_config_.mqtt_client_id = credentials_.device_id.data();
+      cloud_config_.mqtt_topic_prefix = mqtt_topic_prefix_.data();
+    }
 
     // Create auth provider
     auth_.emplace(credentials_, &rtc_token_, cloud_config_);
@@ -105,6 +172,10 @@ public:
     // Create services
     command_service_.emplace(*client_);
     telemetry_service_.emplace(*client_, serializer_);
+    if (config_.compress_payloads) {
+      compressor_ = std::make_unique<Compressor>();
+      telemetry_service_->set_compressor(compressor_.get());
+    }
 
     state_ = CloudState::Uninitialized;
     ESP_LOGI(TAG, "Cloud manager initialized");
@@ -186,6 +257,10 @@ public:
     }
 
     ESP_LOGI(TAG, "Sending %zu measurements", measurements.size());
+    if (config_.piggyback_commands) {
+      return send_telemetry_with_commands(measurements);
+    }
+
     auto result = telemetry_service_->send(measurements);
 
     if (result.success) {
@@ -198,27 +273,122 @@ public:
     return result;
   }
 
-  /// Poll and process commands now
-  void poll_commands() {
-    if (!command_service_ || state_ != CloudState::Authenticated) {
-      return;
+  /// Stream telemetry pulled from source straight into the connection
+  ///
+  /// @param source Callable `void(Emit &&emit)` calling `emit(m)` per
+  ///        measurement (see proto::BatchStreamSource)
+  template <typename Source>
+  [[nodiscard]] TelemetryResult stream_telemetry(Source source) {
+    if (!telemetry_service_ || state_ != CloudState::Authenticated) {
+      return {.error = CloudError::NotAuthenticated};
     }
 
-    CommandBuffer cmd_buffer;
-    auto result = command_service_->poll(cmd_buffer);
+    auto body =
+        proto::make_batch_stream(std::move(source), config_.wire_encoding);
+    if (!config_.piggyback_commands) {
+      auto result = telemetry_service_->send_stream(body);
+      if (result.success) {
+        ESP_LOGI(TAG, "Telemetry streamed OK (%zu measurements)",
+                 body.count());
+      } else {
+        ESP_LOGW(TAG, "Telemetry failed: %d", static_cast<int>(result.error));
+        handle_error(result.error);
+      }
+      return result;
+    }
 
+    CommandBuffer cmd_buffer;
+    auto result = telemetry_service_->send_stream(body, cmd_buffer);
     if (!result.success) {
-      ESP_LOGW(TAG, "Command poll failed: %d", static_cast<int>(result.error));
+      ESP_LOGW(TAG, "Telemetry failed: %d", static_cast<int>(result.error));
       handle_error(result.error);
-      return;
+      return result;
     }
 
-    if (cmd_buffer.empty()) {
+    ESP_LOGI(TAG, "Telemetry streamed OK (%zu measurements, %zu commands)",
+             body.count(), cmd_buffer.size());
+    commands_piggybacked_ = true;
+    if (!cmd_buffer.empty()) {
+      process_commands(cmd_buffer);
+    }
+    return result;
+  }
+
+  /// Queue a sample for upload by priority (see Outbox)
+  ///
+  /// Immediate samples are sent right away when authenticated; batched
+  /// ones wait for service_outbox() to find the batch due.
+  /// @return false if the lane is full (keep the sample for later)
+  [[nodiscard]] bool
+  queue_telemetry(std::span<const sensor::Measurement> sample,
+                  Priority priority = Priority::Batched) {
+    if (!outbox_.push(sample, priority, core::clock::monotonic_ms())) {
+      return false;
+    }
+    if (priority == Priority::Immediate) {
+      service_outbox();
+    }
+    return true;
+  }
+
+  /// Send what the outbox has due: deferred acks and alerts whenever the
+  /// cloud is reachable, routine telemetry once the batch is due
+  /// @param force Flush routine telemetry regardless of the thresholds
+  void service_outbox(bool force = false) {
+    if (!telemetry_service_ || state_ != CloudState::Authenticated) {
       return;
     }
 
-    ESP_LOGI(TAG, "Processing %zu commands", cmd_buffer.size());
-    command_handler_.process_all(*command_service_, cmd_buffer);
+    AckBatch acks;
+    outbox_.peek_acks(acks);
+    size_t acked = 0;
+    (void)command_service_->ack_all(acks, acked);
+    outbox_.pop_acks(acked);
+
+    (void)flush_lane(Priority::Immediate);
+    if (force || outbox_.batch_due(core::clock::monotonic_ms())) {
+      (void)flush_lane(Priority::Batched);
+    }
+  }
+
+  /// Poll and process commands now
+  void poll_commands() { (void)poll_commands_once(); }
+
+  /// Route timer work to the owning task (unset: timers run it directly)
+  /// @note Set before start()
+  void set_dispatcher(CloudWorkFn dispatch) { dispatch_ = std::move(dispatch); }
+
+  /// Run work a dispatcher received
+  void run(CloudWork work) {
+    switch (work) {
+    case CloudWork::PollCommands:
+      poll_commands();
+      break;
+    case CloudWork::RefreshToken:
+      check_token_refresh();
+      break;
+    }
+  }
+
+  /// Retune command polling; a running poll timer restarts at the new base
+  /// @note Call from the owning task (e.g. a command handler)
+  void set_poll_interval(std::chrono::seconds interval,
+                         std::chrono::seconds max_interval) {
+    config_.command_poll_interval = interval;
+    config_.command_poll_max_interval = max_interval;
+    poll_interval_ = base_poll_interval();
+    if (command_timer_.is_running()) {
+      (void)command_timer_.restart(poll_interval_);
+    }
+    ESP_LOGI(TAG, "Command poll interval set to %llds (max %llds)",
+             static_cast<long long>(poll_interval_.count()),
+             static_cast<long long>(max_interval.count()));
+  }
+
+  /// Retune routine telemetry batching (see OutboxConfig)
+  void set_outbox_config(const OutboxConfig &config) {
+    config_.outbox = config;
+    outbox_.set_config(config);
   }
 
   /// Register command handler callback
@@ -226,33 +396,51 @@ public:
     command_handler_.register_handler(type, std::move(handler));
   }
 
-  /// Send device info (app_name, firmware_version) to backend
-  /// Call after successful authentication
-  [[nodiscard]] bool send_device_info(std::string_view app_name,
-                                      std::string_view firmware_version) {
+  /// Report device info to the backend if it changed since the last report
+  /// Call after successful authentication (and whenever it may have changed)
+  /// @param last_hash RTC-resident report_hash() of the last accepted report,
+  ///        updated on success
+  /// @return true if sent or unchanged
+  [[nodiscard]] bool report_device_info(const DeviceInfo &info,
+                                        core::RtcValue<uint32_t> &last_hash) {
     if (!client_ || state_ != CloudState::Authenticated) {
       return false;
     }
 
-    // Build JSON body
-    std::array<char, 256> json_buffer{};
-    int len = snprintf(json_buffer.data(), json_buffer.size(),
-                       R"({"app_name":"%.*s","app_version":"%.*s"})",
-                       static_cast<int>(app_name.size()), app_name.data(),
-                       static_cast<int>(firmware_version.size()),
-                       firmware_version.data());
+    auto report = info.coarse();
+    uint32_t hash = report_hash(report, credentials_.device_id_view());
+    if (last_hash.is_valid() && last_hash.get() == hash) {
+      ESP_LOGD(TAG, "Device info unchanged, not sent");
+      return true;
+    }
+
+    // Protobuf once the backend has shown it speaks it, JSON otherwise
+    std::array<uint8_t, device_info::JSON_SIZE> body_buffer{};
+    auto content_type = transport::ContentType::Json;
+    size_t len = 0;
+    if (command_service_ && command_service_->speaks_protobuf()) {
+      content_type = transport::ContentType::Protobuf;
+      len = encode_device_info(report, body_buffer);
+    } else {
+      len = write_device_info_json(
+          report, std::span(reinterpret_cast<char *>(body_buffer.data()),
+                            body_buffer.size()));
+    }
 
-    if (len < 0 || static_cast<size_t>(len) >= json_buffer.size()) {
-      ESP_LOGE(TAG, "Device info JSON too large");
+    if (len == 0) {
+      ESP_LOGE(TAG, "Device info too large");
       return false;
     }
 
+    EncodedPayload payload{
+        .data = std::span<const uint8_t>(body_buffer.data(), len)};
+    if (compressor_) {
+      payload = compressor_->apply(payload.data);
+    }
+
     auto response =
-        client_->put(endpoints::DEVICE_INFO,
-                     std::span<const uint8_t>(
-                         reinterpret_cast<const uint8_t *>(json_buffer.data()),
-                         static_cast<size_t>(len)),
-                     transport::ContentType::Json);
+        client_->put(core::url::static_path<endpoints::DEVICE_INFO>,
+                     payload.data, content_type, payload.encoding);
 
     if (!response.success) {
       ESP_LOGW(TAG, "Device info update failed: %d",
@@ -260,13 +448,21 @@ public:
       return false;
     }
 
+    last_hash.set(hash);
     ESP_LOGI(TAG, "Device info sent: %.*s v%.*s",
-             static_cast<int>(app_name.size()), app_name.data(),
-             static_cast<int>(firmware_version.size()),
-             firmware_version.data());
+             static_cast<int>(report.app_name.size()), report.app_name.data(),
+             static_cast<int>(report.app_version.size()),
+             report.app_version.data());
     return true;
   }
 
+  /// Close the idle HTTP connection when the heap runs low; the next
+  /// request reconnects
+  /// @return false if a request (e.g. a long poll) is using it
+  bool release_connection() {
+    return client_ && client_->release_connection();
+  }
+
   [[nodiscard]] CloudState state() const { return state_; }
   [[nodiscard]] bool is_connected() const {
     return state_ == CloudState::Authenticated;
@@ -279,41 +475,143 @@ private:
   static constexpr const char *TAG = "CloudMgr";
 
   void start_timers() {
-    // Telemetry timer
-    telemetry_timer_ = std::make_unique<core::PeriodicTimer>(
-        [this]() { on_telemetry_tick(); });
-    (void)telemetry_timer_->start(config_.telemetry_interval);
-
-    // Command poll timer
-    command_timer_ =
-        std::make_unique<core::PeriodicTimer>([this]() { poll_commands(); });
-    (void)command_timer_->start(config_.command_poll_interval);
-
-    // Token refresh timer - runs every minute, checks if refresh needed
-    token_refresh_timer_ = std::make_unique<core::PeriodicTimer>(
-        [this]() { check_token_refresh(); });
-    (void)token_refresh_timer_->start(std::chrono::minutes(1));
-
-    ESP_LOGI(
-        TAG,
-        "Timers started: telemetry=%dmin, commands=%dmin, token_check=1min",
-        static_cast<int>(config_.telemetry_interval.count()),
-        static_cast<int>(config_.command_poll_interval.count()));
+    timers_started_ = true;
+    (void)telemetry_timer_.start(config_.telemetry_interval);
+
+    // Commands: a long-poll task, or a poll timer that backs off when idle
+    poll_interval_ = base_poll_interval();
+    if (config_.command_long_poll.count() > 0) {
+      long_poll_active_ = true;
+      (void)long_poll_wake_.try_take(); // Stale give from an earlier stop
+      long_poll_task_.emplace([this]() { run_long_poll(); },
+                              core::TaskConfig{.name = "cmd_poll",
+                                               .stack_size = LONG_POLL_STACK});
+    } else {
+      (void)command_timer_.start(poll_interval_);
+    }
+
+    // Token refresh: one shot at expiry - buffer, re-armed after each run
+    schedule_token_refresh();
+
+    ESP_LOGI(TAG,
+             "Timers started: telemetry=%dmin, commands=%llds%s",
+             static_cast<int>(config_.telemetry_interval.count()),
+             static_cast<long long>(long_poll_task_
+                                        ? config_.command_long_poll.count()
+                                        : poll_interval_.count()),
+             long_poll_task_ ? " (long poll)" : "");
   }
 
   void stop_timers() {
-    if (telemetry_timer_) {
-      telemetry_timer_->stop();
-      telemetry_timer_.reset();
+    timers_started_ = false;
+    (void)telemetry_timer_.stop();
+    (void)command_timer_.stop();
+    stop_long_poll();
+    (void)token_refresh_timer_.stop();
+  }
+
+  void dispatch(CloudWork work) {
+    if (dispatch_) {
+      dispatch_(work);
+    } else {
+      run(work);
+    }
+  }
+
+  /// One command poll; not successful if skipped for lack of a session
+  CommandsResult poll_commands_once() {
+    if (!command_service_ || state_ != CloudState::Authenticated) {
+      return {.error = CloudError::NotAuthenticated};
+    }
+
+    // An upload since the last tick already carried the pending commands
+    if (config_.piggyback_commands && commands_piggybacked_.exchange(false)) {
+      return {.success = true};
+    }
+
+    CommandBuffer cmd_buffer;
+    auto result =
+        command_service_->poll(cmd_buffer, config_.command_long_poll);
+
+    if (!result.success) {
+      ESP_LOGW(TAG, "Command poll failed: %d", static_cast<int>(result.error));
+      handle_error(result.error);
+      return result;
+    }
+
+    if (command_timer_.is_running()) {
+      schedule_next_poll(result, !cmd_buffer.empty());
+    }
+    if (cmd_buffer.empty()) {
+      return result;
+    }
+
+    ESP_LOGI(TAG, "Processing %zu commands", cmd_buffer.size());
+    process_commands(cmd_buffer);
+    return result;
+  }
+
+  [[nodiscard]] std::chrono::seconds base_poll_interval() const {
+    return std::max<std::chrono::seconds>(config_.command_poll_interval,
+                                          MIN_POLL_INTERVAL);
+  }
+
+  /// Server interval if given, else back to the base on commands and
+  /// twice as long (up to the max) on an empty or unchanged queue
+  void schedule_next_poll(const CommandsResult &result, bool had_commands) {
+    auto max_interval = std::max<std::chrono::seconds>(
+        config_.command_poll_max_interval, base_poll_interval());
+    std::chrono::seconds next = base_poll_interval();
+    if (result.poll_interval.count() > 0) {
+      next = std::clamp<std::chrono::seconds>(
+          result.poll_interval, MIN_POLL_INTERVAL, max_interval);
+    } else if (!had_commands) {
+      next = std::min(poll_interval_ * 2, max_interval);
+    }
+
+    if (next == poll_interval_) {
+      return;
+    }
+    poll_interval_ = next;
+    (void)command_timer_.restart(poll_interval_);
+    ESP_LOGI(TAG, "Command poll interval now %llds",
+             static_cast<long long>(poll_interval_.count()));
+  }
+
+  /// Long-poll loop: straight back into the next poll unless it failed or
+  /// the server asked for a pause
+  void run_long_poll() {
+    while (long_poll_active_.load()) {
+      auto result = poll_commands_once();
+      auto pause = result.success ? result.poll_interval : poll_interval_;
+      if (pause.count() > 0) {
+        (void)long_poll_wake_.take_for(pause); // Given by stop_long_poll()
+      }
+    }
+    long_poll_stopped_.give();
+    vTaskSuspend(nullptr); // Deleted by stop_long_poll(), outside any call
+  }
+
+  /// Stop the long-poll task and join it
+  ///
+  /// The task may be inside a transport call holding its mutex, a client
+  /// handle or a body block, so it is never deleted there: the request in
+  /// flight is cancelled and the task returns from it by itself.
+  void stop_long_poll() {
+    if (!long_poll_task_) {
+      return;
     }
-    if (command_timer_) {
-      command_timer_->stop();
-      command_timer_.reset();
+    long_poll_active_ = false;
+    long_poll_wake_.give();
+    if (client_) {
+      client_->cancel_request();
     }
-    if (token_refresh_timer_) {
-      token_refresh_timer_->stop();
-      token_refresh_timer_.reset();
+    if (!long_poll_stopped_.take_for(LONG_POLL_MARGIN)) {
+      // Bounded by the request timeout (the server's wait plus margin)
+      ESP_LOGW(TAG, "Long poll still in a request, waiting for it");
+      (void)long_poll_stopped_.take();
     }
+    long_poll_task_.reset();
   }
 
   void on_telemetry_tick() {
@@ -321,12 +619,34 @@ private:
     // This could emit an event if needed for app to respond to
   }
 
+  /// Arm the refresh timer for when the token enters its refresh buffer
+  /// (no timer for a token without expiry; a 401 re-authenticates then)
+  void schedule_token_refresh(
+      std::optional<std::chrono::seconds> delay = std::nullopt) {
+    if (!timers_started_ || !auth_) {
+      return;
+    }
+    if (!delay) {
+      delay = auth_->time_until_refresh();
+    }
+    (void)token_refresh_timer_.stop();
+    if (!delay) {
+      return;
+    }
+    // Never zero: a refresh that is due runs on the next timer dispatch
+    auto at = std::max(*delay, std::chrono::seconds{1});
+    (void)token_refresh_timer_.start(at);
+    ESP_LOGI(TAG, "Token refresh in %llds", static_cast<long long>(at.count()));
+  }
+
   void check_token_refresh() {
     if (!auth_ || state_ != CloudState::Authenticated) {
       return;
     }
 
+    // A request may have refreshed it lazily since the timer was armed
     if (!auth_->needs_refresh()) {
+      schedule_token_refresh();
       return;
     }
 
@@ -339,10 +659,63 @@ private:
       if (auth_->is_revoked()) {
         state_ = CloudState::Revoked;
         on_revoked();
+        return;
       }
+      schedule_token_refresh(TOKEN_REFRESH_RETRY);
     } else {
       ESP_LOGI(TAG, "Token refreshed successfully");
+      schedule_token_refresh();
+    }
+  }
+
+  /// Upload and run the commands that came back with the response
+  [[nodiscard]] TelemetryResult send_telemetry_with_commands(
+      std::span<const sensor::Measurement> measurements) {
+    CommandBuffer cmd_buffer;
+    auto result = telemetry_service_->send(measurements, cmd_buffer);
+
+    if (!result.success) {
+      ESP_LOGW(TAG, "Telemetry failed: %d", static_cast<int>(result.error));
+      handle_error(result.error);
+      return result;
     }
+
+    ESP_LOGI(TAG, "Telemetry sent OK (%zu commands)", cmd_buffer.size());
+    commands_piggybacked_ = true;
+
+    // Response lease is released by now; acks are ordinary requests
+    if (!cmd_buffer.empty()) {
+      process_commands(cmd_buffer);
+    }
+    return result;
+  }
+
+  /// Run commands; acks that fail go to the outbox's immediate lane
+  void process_commands(CommandBuffer &cmd_buffer) {
+    command_handler_.process_all(
+        *command_service_, cmd_buffer,
+        [this](std::string_view id, CommandResult result) {
+          if (!outbox_.push_ack(id, result)) {
+            ESP_LOGW(TAG, "Outbox full, ack dropped");
+          }
+        });
+  }
+
+  /// Upload one outbox lane in a single streamed request
+  [[nodiscard]] bool flush_lane(Priority priority) {
+    if (outbox_.size(priority) == 0) {
+      return true;
+    }
+
+    size_t sent = 0;
+    auto result = stream_telemetry([this, priority, &sent](auto &&emit) {
+      sent = outbox_.for_each(priority, emit);
+    });
+    if (!result.success) {
+      return false;
+    }
+    outbox_.consume(priority, sent, core::clock::monotonic_ms());
+    return true;
   }
 
   void handle_error(CloudError error) {
@@ -367,6 +740,7 @@ private:
   CloudState state_{CloudState::Uninitialized};
   DeviceCredentials credentials_{};
   CloudConfig cloud_config_{};
+  std::array<char, 64> mqtt_topic_prefix_{};
 
   // Services (optional for deferred init)
   std::optional<DeviceAuthProvider> auth_;
@@ -374,17 +748,37 @@ private:
   std::optional<CommandService> command_service_;
 
   // Telemetry
-  MeasurementSerializer serializer_;
+  using Compressor = PayloadCompressor<proto::MAX_BATCH_SIZE>;
+  MeasurementSerializer serializer_{config_.wire_encoding};
   std::optional<TelemetryService<sensor::Measurement, proto::MAX_BATCH_SIZE>>
       telemetry_service_;
+  std::unique_ptr<Compressor> compressor_; // Only with compress_payloads
+
+  // Outgoing queue (lanes are uploaded with stream_telemetry)
+  static constexpr size_t OUTBOX_CAPACITY = 320;
+  Outbox<OUTBOX_CAPACITY> outbox_{config_.outbox};
 
   // Commands
   CommandHandler command_handler_;
-
-  // Timers
-  std::unique_ptr<core::PeriodicTimer> telemetry_timer_;
-  std::unique_ptr<core::PeriodicTimer> command_timer_;
-  std::unique_ptr<core::PeriodicTimer> token_refresh_timer_;
+  std::atomic<bool> commands_piggybacked_{false}; ///< Upload since last poll
+  std::chrono::seconds poll_interval_{}; ///< Current period (backs off idle)
+  static constexpr std::chrono::seconds MIN_POLL_INTERVAL{5};
+  static constexpr uint32_t LONG_POLL_STACK = 6144;
+  std::optional<core::Task> long_poll_task_;
+  std::atomic<bool> long_poll_active_{false};
+  core::BinarySemaphore long_poll_wake_;
+  core::BinarySemaphore long_poll_stopped_;
+
+  // Timers (their work goes through dispatch_ when set). Wheel timers,
+  // made once: start() and stop() only link and unlink them
+  CloudWorkFn dispatch_;
+  bool timers_started_ = false;
+  core::WheelPeriodicTimer telemetry_timer_{[this]() { on_telemetry_tick(); }};
+  core::WheelPeriodicTimer command_timer_{
+      [this]() { dispatch(CloudWork::PollCommands); }};
+  core::WheelOneShotTimer token_refresh_timer_{
+      [this]() { dispatch(CloudWork::RefreshToken); }};
+  static constexpr std::chrono::minutes TOKEN_REFRESH_RETRY{1};
 };
 
 } // namespace cloud
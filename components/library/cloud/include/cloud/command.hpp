@@ -17,9 +17,34 @@ enum class CommandType : uint8_t {
   Unknown = 0,
   Reboot,
   FactoryReset,
+  OtaUpdate,
+  ConfigUpdate,
   // Add new command types here
 };
 
+/// Command execution result (values match AckResult in command.proto)
+enum class CommandResult : uint8_t {
+  Success,
+  Failed,
+  Unknown,
+  InvalidPayload,
+};
+
+/// Convert command result to its wire name in JSON acks
+[[nodiscard]] constexpr std::string_view
+command_result_to_string(CommandResult result) {
+  switch (result) {
+  case CommandResult::Success:
+    return "success";
+  case CommandResult::Failed:
+    return "failed";
+  case CommandResult::InvalidPayload:
+    return "invalid_payload";
+  default:
+    return "unknown";
+  }
+}
+
 /// Convert string to command type
 [[nodiscard]] constexpr CommandType parse_command_type(std::string_view type) {
   if (type == "reboot") {
@@ -28,6 +53,12 @@ enum class CommandType : uint8_t {
   if (type == "factory_reset") {
     return CommandType::FactoryReset;
   }
+  if (type == "ota_update") {
+    return CommandType::OtaUpdate;
+  }
+  if (type == "config_update") {
+    return CommandType::ConfigUpdate;
+  }
   return CommandType::Unknown;
 }
 
@@ -39,6 +70,10 @@ command_type_to_string(CommandType type) {
     return "reboot";
   case CommandType::FactoryReset:
     return "factory_reset";
+  case CommandType::OtaUpdate:
+    return "ota_update";
+  case CommandType::ConfigUpdate:
+    return "config_update";
   default:
     return "unknown";
   }
@@ -120,4 +155,47 @@ private:
   size_t count_{0};
 };
 
+/// Command outcomes acknowledged together in one request
+class AckBatch {
+public:
+  struct Entry {
+    std::array<char, COMMAND_ID_SIZE> id{};
+    CommandResult result{CommandResult::Success};
+
+    [[nodiscard]] std::string_view id_view() const { return {id.data()}; }
+  };
+
+  using const_iterator = const Entry *;
+
+  void clear() { count_ = 0; }
+
+  /// Add an outcome (id truncated to COMMAND_ID_SIZE - 1)
+  [[nodiscard]] bool push(std::string_view id, CommandResult result) {
+    if (count_ >= MAX_COMMANDS) {
+      return false;
+    }
+    auto &entry = entries_.at(count_++);
+    size_t len = std::min(id.size(), entry.id.size() - 1);
+    std::copy_n(id.data(), len, entry.id.data());
+    entry.id.at(len) = '\0';
+    entry.result = result;
+    return true;
+  }
+
+  [[nodiscard]] size_t size() const { return count_; }
+  [[nodiscard]] bool empty() const { return count_ == 0; }
+  [[nodiscard]] bool full() const { return count_ >= MAX_COMMANDS; }
+
+  [[nodiscard]] const Entry &operator[](size_t i) const {
+    return entries_.at(i);
+  }
+
+  [[nodiscard]] const_iterator begin() const { return entries_.data(); }
+  [[nodiscard]] const_iterator end() const { return entries_.data() + count_; }
+
+private:
+  std::array<Entry, MAX_COMMANDS> entries_{};
+  size_t count_{0};
+};
+
 } // namespace cloud
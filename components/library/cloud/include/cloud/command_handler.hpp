@@ -23,14 +23,6 @@
 
 namespace cloud {
 
-/// Command execution result
-enum class CommandResult : uint8_t {
-  Success,
-  Failed,
-  Unknown,
-  InvalidPayload,
-};
-
 /// Command handler function type
 using CommandHandlerFn = std::function<CommandResult(std::string_view payload)>;
 
@@ -78,15 +70,21 @@ public:
     }
   }
 
-  /// Process all commands from buffer
-  size_t process_all(CommandService &service, CommandBuffer &buffer) {
+  /// Called with each outcome whose ack could not be sent
+  using AckFailedFn =
+      std::function<void(std::string_view id, CommandResult result)>;
+
+  /// Process all commands from buffer, then acknowledge them together
+  size_t process_all(CommandService &service, CommandBuffer &buffer,
+                     const AckFailedFn &on_ack_failed = {}) {
     size_t success_count = 0;
+    AckBatch acks;
 
     for (const auto &cmd : buffer) {
       auto result = process(cmd);
 
       // Always acknowledge (so server knows we received it)
-      auto ack_status = service.ack(cmd.id_view());
+      (void)acks.push(cmd.id_view(), result);
 
       if (result == CommandResult::Success) {
         success_count++;
@@ -95,9 +93,15 @@ public:
         ESP_LOGW(TAG, "Command %s failed: %d", cmd.id.data(),
                  static_cast<int>(result));
       }
+    }
 
-      if (!ack_status) {
-        ESP_LOGW(TAG, "Failed to ack command %s", cmd.id.data());
+    size_t acked = 0;
+    if (!service.ack_all(acks, acked)) {
+      ESP_LOGW(TAG, "Failed to ack %zu commands", acks.size() - acked);
+      if (on_ack_failed) {
+        for (size_t i = acked; i < acks.size(); ++i) {
+          on_ack_failed(acks[i].id_view(), acks[i].result);
+        }
       }
     }
 
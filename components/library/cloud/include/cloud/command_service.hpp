@@ -4,6 +4,25 @@
  *
  * Handles fetching commands from backend and parsing JSON responses.
  * Separated from CloudClient for single responsibility.
+ *
+ * The same `{"data": [...]}` body can also come back on the telemetry
+ * upload (see TelemetryService::send with a CommandBuffer), which saves the
+ * separate poll request per wake.
+ *
+ * Polls ask for a protobuf CommandBatch (proto/command.proto). Bodies are
+ * told apart by their first byte, so a backend that still answers JSON
+ * keeps working; once one protobuf answer came back, acks (and device
+ * info, see speaks_protobuf()) are sent as protobuf too.
+ *
+ * Polls are conditional: the ETag of the last answer goes back as
+ * If-None-Match, so an unchanged queue costs a 304 with no body. The
+ * backend may advertise when to ask next (X-Poll-Interval, seconds) and,
+ * for a long poll (`wait` seconds), hold the request open until a command
+ * arrives.
+ *
+ * ack_all() reports every outcome of a poll in one POST /commands/ack. A
+ * backend without that endpoint (404) is remembered and gets one
+ * POST /commands/{id}/ack per command instead.
  */
 
 #pragma once
@@ -11,10 +30,18 @@
 #include "cloud_client.hpp"
 #include "command.hpp"
 #include "endpoints.hpp"
+#include "json_reader.hpp"
+
+#include <core/url.hpp>
+#include <proto/command_adapter.hpp>
 
 #include <esp_log.h>
 
+#include <algorithm>
 #include <array>
+#include <charconv>
+#include <chrono>
+#include <span>
 #include <string_view>
 
 namespace cloud {
@@ -23,12 +50,24 @@ namespace cloud {
 namespace command_buffers {
 /// Path buffer for /commands/{uuid}/ack
 inline constexpr size_t ACK_PATH_SIZE = 64;
+/// JSON bulk ack body: MAX_COMMANDS entries of
+/// {"id":"<uuid>","result":"invalid_payload"}
+inline constexpr size_t ACK_BATCH_JSON_SIZE = 640;
+/// Decimal seconds of the long-poll `wait` parameter
+inline constexpr size_t WAIT_PARAM_SIZE = 8;
 } // namespace command_buffers
 
+/// Network slack on top of a long poll's wait before the request times out
+inline constexpr std::chrono::seconds LONG_POLL_MARGIN{10};
+
 /// Result of command poll
 struct CommandsResult {
   bool success{false};
   CloudError error{CloudError::None};
+  /// 304: the pending queue is unchanged since the last poll
+  bool not_modified{false};
+  /// Server-advertised wait before the next poll (0 = none given)
+  std::chrono::seconds poll_interval{0};
 };
 
 /// Command polling service
@@ -37,29 +76,77 @@ public:
   explicit CommandService(CloudClient &client) : client_(client) {}
 
   /// Poll for pending commands
-  [[nodiscard]] CommandsResult poll(CommandBuffer &buffer) {
+  /// @param wait Long poll: let the server hold the request up to this
+  ///        long until a command is pending (0 = answer at once)
+  [[nodiscard]] CommandsResult poll(CommandBuffer &buffer,
+                                    std::chrono::seconds wait = {}) {
     buffer.clear();
 
-    transport::QueryParam params[] = {{.key = "status", .value = "pending"}};
-    auto response = client_.get(endpoints::COMMANDS, params);
+    std::array<char, command_buffers::WAIT_PARAM_SIZE> wait_value{};
+    auto [end, ec] = std::to_chars(wait_value.data(),
+                                   wait_value.data() + wait_value.size(),
+                                   static_cast<long long>(wait.count()));
+    bool long_poll = wait.count() > 0 && ec == std::errc{};
+    std::string_view wait_text{wait_value.data(),
+                               static_cast<size_t>(end - wait_value.data())};
+    transport::QueryParam params[] = {
+        {.key = "status", .value = "pending"},
+        {.key = "wait", .value = wait_text},
+    };
+
+    GetOptions options{
+        .accept = transport::ContentType::Protobuf,
+        .if_none_match = {etag_.data(), etag_len_},
+    };
+    if (long_poll) {
+      options.timeout = wait + LONG_POLL_MARGIN;
+    }
+    auto response = client_.get(core::url::static_path<endpoints::COMMANDS>,
+                                std::span(params, long_poll ? 2 : 1), options);
 
     if (!response.success) {
       return {.error = response.error};
     }
 
+    if (!response.body_empty() && !is_json(response.body())) {
+      speaks_protobuf_ = true;
+    }
+    if (response.status_code != status::NOT_MODIFIED) {
+      remember_etag(response.raw.etag());
+    }
+
+    auto result = parse(response, buffer);
+    result.poll_interval = response.raw.poll_interval();
+    return result;
+  }
+
+  /// Parse pending commands from a response body (none on 204 / empty)
+  [[nodiscard]] static CommandsResult parse(const ApiResponse &response,
+                                            CommandBuffer &buffer) {
+    if (response.status_code == status::NOT_MODIFIED) {
+      return {.success = true, .not_modified = true};
+    }
     if (response.status_code == status::NO_CONTENT || response.body_empty()) {
       return {.success = true};
     }
 
-    if (!parse_commands(response.body_str(), buffer)) {
+    bool parsed = is_json(response.body())
+                      ? parse_commands(response.body_str(), buffer)
+                      : decode_commands(response.body(), buffer);
+    if (!parsed) {
       return {.error = CloudError::ParseError};
     }
 
     return {.success = true};
   }
 
+  /// Backend answered a poll in protobuf (so it accepts protobuf bodies)
+  [[nodiscard]] bool speaks_protobuf() const { return speaks_protobuf_; }
+
   /// Acknowledge command execution
-  [[nodiscard]] core::Status ack(std::string_view command_id) {
+  [[nodiscard]] core::Status
+  ack(std::string_view command_id,
+      CommandResult result = CommandResult::Success) {
     std::array<char, command_buffers::ACK_PATH_SIZE> path{};
     int len = snprintf(path.data(), path.size(), "%.*s/%.*s/ack",
                        static_cast<int>(endpoints::COMMANDS.size()),
@@ -70,8 +157,18 @@ public:
       return core::Err(ESP_ERR_INVALID_SIZE);
     }
 
+    std::string_view ack_path{path.data(), static_cast<size_t>(len)};
+    std::array<uint8_t, proto::MAX_COMMAND_ACK_SIZE> body{};
+    size_t body_size =
+        speaks_protobuf_
+            ? proto::encode_command_ack(command_id, to_ack_result(result), body)
+            : 0;
     auto response =
-        client_.post(std::string_view{path.data(), static_cast<size_t>(len)});
+        body_size > 0
+            ? client_.post(ack_path,
+                           std::span<const uint8_t>(body.data(), body_size),
+                           transport::ContentType::Protobuf)
+            : client_.post(ack_path);
 
     if (!response.success) {
       return core::Err(ESP_FAIL);
@@ -82,134 +179,189 @@ public:
     return core::Ok();
   }
 
-private:
-  static constexpr const char *TAG = "CmdService";
-
-  /// Parse commands JSON into buffer
-  [[nodiscard]] static bool parse_commands(std::string_view json,
-                                           CommandBuffer &buffer) {
-    auto data_pos = json.find("\"data\"");
-    if (data_pos == std::string_view::npos) {
-      return false;
+  /// Acknowledge a batch of outcomes in one request
+  /// @param[out] acked Leading entries the backend has (all of them on
+  ///             success; fewer only when falling back to per-command acks)
+  [[nodiscard]] core::Status ack_all(const AckBatch &batch, size_t &acked) {
+    acked = 0;
+    if (batch.empty()) {
+      return core::Ok();
     }
-
-    auto array_start = json.find('[', data_pos);
-    if (array_start == std::string_view::npos) {
-      return false;
+    if (!bulk_ack_supported_ || batch.size() == 1) {
+      return ack_each(batch, acked);
     }
 
-    size_t pos = array_start + 1;
-    while (pos < json.size() && !buffer.full()) {
-      auto obj_start = json.find('{', pos);
-      if (obj_start == std::string_view::npos)
-        break;
-
-      // Find matching closing brace (handle nested objects)
-      int depth = 1;
-      size_t obj_end = obj_start + 1;
-      while (obj_end < json.size() && depth > 0) {
-        if (json[obj_end] == '{')
-          ++depth;
-        else if (json[obj_end] == '}')
-          --depth;
-        ++obj_end;
-      }
+    std::array<uint8_t, std::max(proto::MAX_COMMAND_ACK_BATCH_SIZE,
+                                 command_buffers::ACK_BATCH_JSON_SIZE)>
+        body{};
+    auto content_type = speaks_protobuf_ ? transport::ContentType::Protobuf
+                                         : transport::ContentType::Json;
+    size_t body_size = speaks_protobuf_ ? encode_ack_batch(batch, body)
+                                        : format_ack_batch(batch, body);
+    if (body_size == 0) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
 
-      if (depth != 0)
-        break;
+    auto response =
+        client_.post(core::url::static_path<endpoints::COMMANDS_ACK>,
+                     std::span<const uint8_t>(body.data(), body_size),
+                     content_type);
+    if (response.status_code == status::NOT_FOUND) {
+      ESP_LOGI(TAG, "No bulk ack endpoint, acking one by one");
+      bulk_ack_supported_ = false;
+      return ack_each(batch, acked);
+    }
+    if (!response.success) {
+      return core::Err(ESP_FAIL);
+    }
 
-      Command cmd;
-      if (parse_command(json.substr(obj_start, obj_end - obj_start), cmd)) {
-        (void)buffer.push(cmd);
-      }
+    acked = batch.size();
+    ESP_LOGI(TAG, "%zu commands acked", acked);
+    return core::Ok();
+  }
 
-      pos = obj_end;
-    }
+private:
+  static constexpr const char *TAG = "CmdService";
 
-    return true;
+  /// Keep the tag for the next If-None-Match (none: poll unconditionally)
+  void remember_etag(std::string_view etag) {
+    etag_len_ = etag.size() <= etag_.size() ? etag.size() : 0;
+    std::copy_n(etag.data(), etag_len_, etag_.data());
   }
 
-  /// Parse single command object
-  [[nodiscard]] static bool parse_command(std::string_view json, Command &cmd) {
-    auto id = extract_field(json, "id");
-    if (id.empty()) {
-      return false;
-    }
+  [[nodiscard]] static constexpr cloud_AckResult
+  to_ack_result(CommandResult result) {
+    return static_cast<cloud_AckResult>(result);
+  }
 
-    cmd.set_id(id);
-    cmd.type = parse_command_type(extract_field(json, "type"));
-
-    // Extract payload object if present
-    auto payload_pos = json.find("\"payload\"");
-    if (payload_pos != std::string_view::npos) {
-      auto colon = json.find(':', payload_pos);
-      if (colon != std::string_view::npos) {
-        size_t start = colon + 1;
-        while (start < json.size() && json[start] == ' ')
-          ++start;
-
-        if (start < json.size() && json[start] == '{') {
-          int depth = 1;
-          size_t end = start + 1;
-          while (end < json.size() && depth > 0) {
-            if (json[end] == '{')
-              ++depth;
-            else if (json[end] == '}')
-              --depth;
-            ++end;
-          }
-          cmd.set_payload(json.substr(start, end - start));
-        }
+  /// One request per entry, stopping at the first failure
+  [[nodiscard]] core::Status ack_each(const AckBatch &batch, size_t &acked) {
+    for (const auto &entry : batch) {
+      if (auto status = ack(entry.id_view(), entry.result); !status) {
+        return status;
       }
+      ++acked;
     }
+    return core::Ok();
+  }
 
-    return true;
+  /// Encode batch as a CommandAckBatch
+  [[nodiscard]] static size_t encode_ack_batch(const AckBatch &batch,
+                                               std::span<uint8_t> body) {
+    return proto::encode_command_ack_batch(
+        batch.size(),
+        [&](size_t i, cloud_CommandAck &pb) {
+          pb.result = to_ack_result(batch[i].result);
+          return proto::copy_string(pb.id, batch[i].id_view());
+        },
+        body);
   }
 
-  /// Extract string field value
-  [[nodiscard]] static std::string_view extract_field(std::string_view json,
-                                                      std::string_view name) {
-    // Search for "name":
-    size_t pos = 0;
-    while (pos < json.size()) {
-      auto quote = json.find('"', pos);
-      if (quote == std::string_view::npos) {
-        break;
+  /// Format batch as {"acks":[{"id":"...","result":"..."},...]}
+  [[nodiscard]] static size_t format_ack_batch(const AckBatch &batch,
+                                               std::span<uint8_t> body) {
+    auto *out = reinterpret_cast<char *>(body.data());
+    size_t len = 0;
+    auto append = [&](const char *fmt, auto... args) {
+      if (len >= body.size()) {
+        return;
       }
+      int n = snprintf(out + len, body.size() - len, fmt, args...);
+      len = n < 0 ? body.size() : len + static_cast<size_t>(n);
+    };
+
+    append("%s", R"({"acks":[)");
+    for (size_t i = 0; i < batch.size(); ++i) {
+      auto id = batch[i].id_view();
+      auto result = command_result_to_string(batch[i].result);
+      append(R"(%s{"id":"%.*s","result":"%.*s"})", i == 0 ? "" : ",",
+             static_cast<int>(id.size()), id.data(),
+             static_cast<int>(result.size()), result.data());
+    }
+    append("%s", "]}");
+    return len < body.size() ? len : 0;
+  }
 
-      auto end_quote = json.find('"', quote + 1);
-      if (end_quote == std::string_view::npos) {
-        break;
-      }
+  /// JSON object (optionally after whitespace); a CommandBatch starts with
+  /// its field 1 tag (0x0A)
+  [[nodiscard]] static bool is_json(std::span<const uint8_t> body) {
+    auto it = std::ranges::find_if_not(body, [](uint8_t c) {
+      return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    });
+    return it != body.end() && *it == '{';
+  }
 
-      auto field_name = json.substr(quote + 1, end_quote - quote - 1);
-      if (field_name == name) {
-        // Find colon and value
-        auto colon = json.find(':', end_quote);
-        if (colon == std::string_view::npos) {
-          break;
-        }
-
-        auto val_quote = json.find('"', colon);
-        if (val_quote == std::string_view::npos) {
-          break;
-        }
-
-        auto val_end = json.find('"', val_quote + 1);
-        if (val_end == std::string_view::npos) {
-          break;
-        }
-
-        return json.substr(val_quote + 1, val_end - val_quote - 1);
+  /// Decode a protobuf CommandBatch into buffer
+  [[nodiscard]] static bool decode_commands(std::span<const uint8_t> body,
+                                            CommandBuffer &buffer) {
+    return proto::decode_commands(body, [&](const cloud_Command &pb) {
+      if (pb.id[0] == '\0' || buffer.full()) {
+        return;
       }
+      Command cmd;
+      cmd.set_id(pb.id);
+      cmd.type = pb.type <= _cloud_CommandType_MAX
+                     ? static_cast<CommandType>(pb.type)
+                     : CommandType::Unknown;
+      cmd.set_payload({reinterpret_cast<const char *>(pb.payload.bytes),
+                       pb.payload.size});
+      cmd.expires_at = pb.expires_at;
+      (void)buffer.push(cmd);
+    });
+  }
 
-      pos = end_quote + 1;
+  /// Parse `{"data": [command, ...]}` into buffer (one pass over the body)
+  [[nodiscard]] static bool parse_commands(std::string_view body,
+                                           CommandBuffer &buffer) {
+    json::Reader reader(body);
+    bool has_data = false;
+    bool ok = json::for_each_member(
+        reader, [&](std::string_view key, json::Reader &r) {
+          if (key != "data") {
+            return;
+          }
+          has_data = json::for_each_element(r, [&](json::Reader &element) {
+            Command cmd;
+            if (parse_command(element, cmd) && !buffer.full()) {
+              (void)buffer.push(cmd);
+            }
+          });
+        });
+    return ok && has_data;
+  }
+
+  /// Parse single command object
+  [[nodiscard]] static bool parse_command(json::Reader &reader, Command &cmd) {
+    std::string_view id;
+    std::string_view type;
+    std::string_view payload;
+    bool ok = json::for_each_member(
+        reader, [&](std::string_view key, json::Reader &r) {
+          if (key == "id") {
+            (void)r.read_string(id);
+          } else if (key == "type") {
+            (void)r.read_string(type);
+          } else if (key == "payload") {
+            (void)r.read_raw(payload);
+          }
+        });
+    if (!ok || id.empty()) {
+      return false;
     }
 
-    return {};
+    cmd.set_id(id);
+    cmd.type = parse_command_type(type);
+    if (payload.starts_with('{')) {
+      cmd.set_payload(payload);
+    }
+    return true;
   }
 
   CloudClient &client_;
+  std::array<char, transport::MAX_ETAG_SIZE> etag_{};
+  size_t etag_len_{0};
+  bool speaks_protobuf_{false};
+  bool bulk_ack_supported_{true};
 };
 
 } // namespace cloud
@@ -21,6 +21,7 @@ namespace defaults {
 inline constexpr std::chrono::milliseconds REQUEST_TIMEOUT{30000};
 inline constexpr std::chrono::seconds TOKEN_REFRESH_BUFFER{300}; // 5 minutes
 inline constexpr size_t MAX_TELEMETRY_SIZE = 1024 * 1024;        // 1MB
+inline constexpr std::chrono::seconds JWT_LIFETIME{3600};
 } // namespace defaults
 
 /// Cloud service configuration
@@ -30,6 +31,23 @@ struct CloudConfig {
   std::chrono::seconds token_refresh_buffer{defaults::TOKEN_REFRESH_BUFFER};
   size_t max_telemetry_size{defaults::MAX_TELEMETRY_SIZE};
   bool skip_cert_verify{false};
+  /// TLS material (PEM, NUL-terminated, must outlive the client; empty =
+  /// certificate bundle / no client auth), e.g. views into BlobPartition
+  std::string_view ca_cert{};
+  std::string_view client_cert{};
+  std::string_view client_key{};
+  /// Device P-256 private key (PEM, NUL-terminated, must outlive the
+  /// provider). Set: bearer tokens are ES256 JWTs minted on the device,
+  /// the /auth exchange is only the fallback while the clock isn't set.
+  std::string_view jwt_key{};
+  std::string_view jwt_audience{}; ///< "aud" claim (empty = base_url)
+  std::chrono::seconds jwt_lifetime{defaults::JWT_LIFETIME};
+  /// MQTT broker for telemetry and pushed commands (empty = HTTP only).
+  /// HTTP stays the fallback and carries auth and streamed uploads.
+  /// @note NUL-terminated, must outlive the client
+  std::string_view mqtt_broker_uri{};
+  std::string_view mqtt_client_id{};
+  std::string_view mqtt_topic_prefix{};
 };
 
 /// HTTP status codes
@@ -37,6 +55,7 @@ namespace status {
 inline constexpr int OK = 200;
 inline constexpr int CREATED = 201;
 inline constexpr int NO_CONTENT = 204;
+inline constexpr int NOT_MODIFIED = 304;
 inline constexpr int BAD_REQUEST = 400;
 inline constexpr int UNAUTHORIZED = 401;
 inline constexpr int FORBIDDEN = 403;
@@ -19,8 +19,8 @@ namespace cloud {
 
 /// Device credential storage keys
 namespace keys {
-inline constexpr std::string_view DEVICE_ID = "device_id";
-inline constexpr std::string_view SECRET = "secret";
+inline constexpr core::StorageKey DEVICE_ID{"device_id"};
+inline constexpr core::StorageKey SECRET{"secret"};
 } // namespace keys
 
 /// Device credential sizes
@@ -47,29 +47,25 @@ struct DeviceCredentials {
   [[nodiscard]] std::string_view secret_view() const { return {secret.data()}; }
 };
 
-/// Load device credentials from storage
+/// Load device credentials from storage (both keys in one batch)
 [[nodiscard]] inline core::Result<DeviceCredentials>
 load_credentials(core::IStorage &storage) {
   DeviceCredentials creds{};
 
-  auto id_size = storage.get_string_size(keys::DEVICE_ID);
-  if (!id_size || *id_size == 0) {
-    return core::Err(ESP_ERR_NOT_FOUND);
+  std::array reads{
+      core::StorageRead::string(keys::DEVICE_ID, creds.device_id),
+      core::StorageRead::string(keys::SECRET, creds.secret),
+  };
+  if (auto status = storage.get_many(reads); !status) {
+    return core::Err(status.error());
   }
-  if (auto err = storage.get_string(
-          keys::DEVICE_ID, {creds.device_id.data(), creds.device_id.size()});
-      !err) {
-    return core::Err(err.error());
-  }
-
-  auto secret_size = storage.get_string_size(keys::SECRET);
-  if (!secret_size || *secret_size == 0) {
-    return core::Err(ESP_ERR_NOT_FOUND);
-  }
-  if (auto err = storage.get_string(keys::SECRET,
-                                    {creds.secret.data(), creds.secret.size()});
-      !err) {
-    return core::Err(err.error());
+  for (const auto &read : reads) {
+    if (!read.found()) {
+      return core::Err(read.error);
+    }
+    if (read.size <= 1) {
+      return core::Err(ESP_ERR_NOT_FOUND);
+    }
   }
 
   return creds;
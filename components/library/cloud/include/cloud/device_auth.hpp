@@ -2,7 +2,8 @@
  * @file device_auth.hpp
  * @brief Device authentication provider
  *
- * Exchanges device credentials (device_id + secret) for JWT token.
+ * Exchanges device credentials (device_id + secret) for JWT token, or -
+ * with a device key configured - mints an ES256 token locally (JwtSigner).
  * Stores token in RTC memory to survive deep sleep.
  * Handles token refresh and re-authentication on 401.
  */
@@ -12,19 +13,24 @@
 #include "config.hpp"
 #include "credentials.hpp"
 #include "endpoints.hpp"
+#include "json_reader.hpp"
+#include "jwt_signer.hpp"
 
+#include <core/fault.hpp>
 #include <core/http_client.hpp>
-#include <core/mutex.hpp>
+#include <core/lock_stats.hpp>
 #include <core/result.hpp>
 #include <core/rtc_storage.hpp>
 #include <transport/auth.hpp>
 
 #include <esp_log.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <optional>
 #include <string_view>
 
 namespace cloud {
@@ -72,7 +78,11 @@ class DeviceAuthProvider final : public transport::IAuthProvider {
 public:
   DeviceAuthProvider(const DeviceCredentials &creds,
                      core::RtcAuthToken *rtc_token, const CloudConfig &config)
-      : creds_(creds), rtc_token_(rtc_token), config_(config) {}
+      : creds_(creds), rtc_token_(rtc_token), config_(config) {
+    if (!config_.jwt_key.empty() && !signer_.init(config_.jwt_key)) {
+      ESP_LOGW(TAG, "Device key unusable, using credential exchange");
+    }
+  }
 
   // IAuthProvider implementation
 
@@ -95,32 +105,30 @@ public:
       return core::Err(ESP_ERR_INVALID_STATE);
     }
 
-    // Build "Bearer <token>" into fixed buffer
-    auto token = rtc_token_->token.view();
-    ESP_LOGI(TAG, "Building auth header: token_len=%zu", token.size());
-
-    // Debug: show token prefix and suffix to verify integrity
-    if (token.size() > 20) {
-      ESP_LOGI(TAG, "Token start: %.20s...", token.data());
-      ESP_LOGI(TAG, "Token end: ...%s", token.data() + token.size() - 20);
-    }
-
-    int len =
-        snprintf(auth_header_buffer_.data(), auth_header_buffer_.size(),
-                 "Bearer %.*s", static_cast<int>(token.size()), token.data());
-
-    if (len < 0 || static_cast<size_t>(len) >= auth_header_buffer_.size()) {
-      ESP_LOGE(TAG, "Auth header buffer overflow: len=%d, buf=%zu", len,
-               auth_header_buffer_.size());
-      return core::Err(ESP_ERR_INVALID_SIZE);
+    // Rendered once per token; later calls reuse the buffer
+    if (header_len_ == 0 || header_built_version_ != token_version_) {
+      auto token = rtc_token_->token.view();
+      int len = snprintf(auth_header_buffer_.data(),
+                         auth_header_buffer_.size(), "Bearer %.*s",
+                         static_cast<int>(token.size()), token.data());
+      if (len < 0 || static_cast<size_t>(len) >= auth_header_buffer_.size()) {
+        ESP_LOGE(TAG, "Auth header buffer overflow: len=%d, buf=%zu", len,
+                 auth_header_buffer_.size());
+        header_len_ = 0;
+        return core::Err(ESP_ERR_INVALID_SIZE);
+      }
+      header_len_ = static_cast<size_t>(len);
+      header_built_version_ = token_version_;
     }
 
-    ESP_LOGI(TAG, "Auth header built: total_len=%d", len);
-
     return transport::AuthHeader{
         .name = "Authorization",
-        .value = std::string_view{auth_header_buffer_.data(),
-                                  static_cast<size_t>(len)}};
+        .value = std::string_view{auth_header_buffer_.data(), header_len_}};
+  }
+
+  [[nodiscard]] uint32_t header_version() const override {
+    core::LockGuard lock(mutex_);
+    return token_version_;
   }
 
   [[nodiscard]] bool needs_refresh() const override {
@@ -137,6 +145,27 @@ public:
     return rtc_token_->needs_refresh(config_.token_refresh_buffer);
   }
 
+  /// Time left until needs_refresh() turns true (zero if it already is)
+  /// @return std::nullopt if the token has no expiry, or after revocation
+  [[nodiscard]] std::optional<std::chrono::seconds> time_until_refresh() const {
+    core::LockGuard lock(mutex_);
+
+    if (state_ == AuthState::Revoked) {
+      return std::nullopt;
+    }
+    if (rtc_token_ == nullptr || !rtc_token_->token.is_valid()) {
+      return std::chrono::seconds{0};
+    }
+    if (!rtc_token_->expires_at.is_valid()) {
+      return std::nullopt;
+    }
+
+    auto due = rtc_token_->expires_at.get() - config_.token_refresh_buffer;
+    auto left = std::chrono::ceil<std::chrono::seconds>(
+        due - std::chrono::system_clock::now());
+    return std::max(left, std::chrono::seconds{0});
+  }
+
   [[nodiscard]] core::Status refresh() override {
     core::LockGuard lock(mutex_);
 
@@ -144,6 +173,11 @@ public:
       return core::Err(ESP_ERR_INVALID_STATE);
     }
 
+    // Local signature: no round-trip at all
+    if (mint_token()) {
+      return core::Ok();
+    }
+
     // Try refresh if we have valid token
     if (rtc_token_ != nullptr && rtc_token_->is_valid()) {
       auto result = do_token_refresh();
@@ -179,6 +213,11 @@ public:
       return {.state = AuthState::Authenticated};
     }
 
+    if (mint_token()) {
+      ESP_LOGI(TAG, "=== Minted device token ===");
+      return {.state = AuthState::Authenticated};
+    }
+
     ESP_LOGI(TAG, "No valid cached token, authenticating with backend...");
     auto status = do_authenticate();
     if (!status) {
@@ -199,12 +238,14 @@ public:
       if (rtc_token_ != nullptr) {
         rtc_token_->clear();
       }
+      ++token_version_;
       state_ = AuthState::TokenExpired;
       ESP_LOGW(TAG, "Token expired (401)");
     } else if (status_code == status::FORBIDDEN) {
       if (rtc_token_ != nullptr) {
         rtc_token_->clear();
       }
+      ++token_version_;
       state_ = AuthState::Revoked;
       ESP_LOGE(TAG, "Device revoked (403)");
     }
@@ -220,6 +261,7 @@ public:
     if (rtc_token_ != nullptr) {
       rtc_token_->clear();
     }
+    ++token_version_;
     state_ = AuthState::Unauthenticated;
   }
 
@@ -238,6 +280,38 @@ private:
                     static_cast<int>(secret.size()), secret.data());
   }
 
+  /// Sign a fresh token with the device key (if there is one)
+  /// @return ESP_ERR_NOT_SUPPORTED without a key, ESP_ERR_INVALID_STATE
+  ///         while the wall clock isn't set yet
+  [[nodiscard]] core::Status mint_token() {
+    if (!signer_.is_ready() || rtc_token_ == nullptr) {
+      return core::Err(ESP_ERR_NOT_SUPPORTED);
+    }
+
+    auto now = std::chrono::system_clock::now();
+    std::array<char, jwt::MAX_TOKEN_SIZE> token{};
+    auto len = signer_.mint({.subject = creds_.device_id_view(),
+                             .audience = config_.jwt_audience.empty()
+                                             ? config_.base_url
+                                             : config_.jwt_audience,
+                             .issued_at = now,
+                             .lifetime = config_.jwt_lifetime},
+                            token);
+    if (!len) {
+      ESP_LOGW(TAG, "Local token not minted: %s",
+               esp_err_to_name(len.error()));
+      return core::Err(len.error());
+    }
+
+    rtc_token_->set(std::string_view{token.data(), *len},
+                    now + config_.jwt_lifetime);
+    ++token_version_;
+    state_ = AuthState::Authenticated;
+    last_error_ = AuthError::None;
+    ESP_LOGI(TAG, "Minted ES256 token: len=%zu", *len);
+    return core::Ok();
+  }
+
   /// Authenticate with backend using credentials
   [[nodiscard]] core::Status do_authenticate() {
     if (!creds_.is_valid()) {
@@ -252,9 +326,9 @@ private:
         .base_url = config_.base_url,
         .timeout = config_.timeout,
         .skip_cert_verify = config_.skip_cert_verify,
-        .ca_cert = {},
-        .client_cert = {},
-        .client_key = {},
+        .ca_cert = config_.ca_cert,
+        .client_cert = config_.client_cert,
+        .client_key = config_.client_key,
     };
     core::DefaultHttpClient client(http_config);
 
@@ -274,7 +348,7 @@ private:
     }
 
     auto result = client.perform(
-        core::HttpMethod::Post, endpoints::AUTH_DEVICE,
+        core::HttpMethod::Post, core::url::static_path<endpoints::AUTH_DEVICE>,
         std::span<const uint8_t>(
             reinterpret_cast<const uint8_t *>(json_buffer.data()),
             static_cast<size_t>(json_len)),
@@ -283,7 +357,7 @@ private:
     if (!result) {
       ESP_LOGE(TAG, "Auth request failed: %s", esp_err_to_name(result.error()));
       last_error_ = AuthError::NetworkError;
-      return core::Err(result.error());
+      return core::Fail(result.error());
     }
 
     return handle_auth_response(result->status_code, result->body_view());
@@ -302,9 +376,9 @@ private:
         .base_url = config_.base_url,
         .timeout = config_.timeout,
         .skip_cert_verify = config_.skip_cert_verify,
-        .ca_cert = {},
-        .client_cert = {},
-        .client_key = {},
+        .ca_cert = config_.ca_cert,
+        .client_cert = config_.client_cert,
+        .client_key = config_.client_key,
     };
     core::DefaultHttpClient client(http_config);
 
@@ -329,13 +403,14 @@ private:
 
     // POST /auth/refresh with empty body
     auto result =
-        client.perform(core::HttpMethod::Post, endpoints::AUTH_REFRESH,
+        client.perform(core::HttpMethod::Post,
+                       core::url::static_path<endpoints::AUTH_REFRESH>,
                        std::span<const uint8_t>{}, core::ContentType::Json);
 
     if (!result) {
       ESP_LOGE(TAG, "Refresh request failed: %s",
                esp_err_to_name(result.error()));
-      return core::Err(result.error());
+      return core::Fail(result.error());
     }
 
     if (result->status_code == status::UNAUTHORIZED) {
@@ -403,59 +478,28 @@ private:
                json.data());
     }
 
-    // Find "token": "..."
-    auto token_pos = json.find("\"token\"");
-    if (token_pos == std::string_view::npos) {
+    std::string_view token;
+    int64_t expires_in = 3600; // Default 1 hour
+    json::Reader reader(json);
+    // A body truncated after the token still yields it
+    (void)json::for_each_member(
+        reader, [&](std::string_view key, json::Reader &r) {
+          if (key == "token") {
+            (void)r.read_string(token);
+          } else if (key == "expires_in") {
+            (void)r.read_int(expires_in);
+          }
+        });
+    if (token.empty()) {
       ESP_LOGE(TAG, "No 'token' field in response");
       return core::Err(ESP_ERR_INVALID_RESPONSE);
     }
 
-    auto colon = json.find(':', token_pos);
-    if (colon == std::string_view::npos) {
-      ESP_LOGE(TAG, "No colon after 'token'");
-      return core::Err(ESP_ERR_INVALID_RESPONSE);
-    }
-
-    auto quote_start = json.find('"', colon);
-    if (quote_start == std::string_view::npos) {
-      ESP_LOGE(TAG, "No opening quote for token value");
-      return core::Err(ESP_ERR_INVALID_RESPONSE);
-    }
-
-    auto quote_end = json.find('"', quote_start + 1);
-    if (quote_end == std::string_view::npos) {
-      ESP_LOGE(TAG, "No closing quote for token value");
-      return core::Err(ESP_ERR_INVALID_RESPONSE);
-    }
-
-    std::string_view token =
-        json.substr(quote_start + 1, quote_end - quote_start - 1);
-
     ESP_LOGI(TAG, "Extracted token: len=%zu", token.size());
     if (token.size() > 20) {
       ESP_LOGI(TAG, "Token prefix: %.20s...", token.data());
     }
 
-    // Find expires_in
-    int64_t expires_in = 3600; // Default 1 hour
-    auto expires_pos = json.find("\"expires_in\"");
-    if (expires_pos != std::string_view::npos) {
-      auto num_start = json.find(':', expires_pos);
-      if (num_start != std::string_view::npos) {
-        num_start++;
-        while (num_start < json.size() &&
-               (json[num_start] == ' ' || json[num_start] == '\t')) {
-          num_start++;
-        }
-        expires_in = 0;
-        while (num_start < json.size() && json[num_start] >= '0' &&
-               json[num_start] <= '9') {
-          expires_in = expires_in * 10 + (json[num_start] - '0');
-          num_start++;
-        }
-      }
-    }
-
     auto expires_at =
         std::chrono::system_clock::now() + std::chrono::seconds(expires_in);
 
@@ -463,6 +507,7 @@ private:
 
     if (rtc_token_ != nullptr) {
       rtc_token_->set(token, expires_at);
+      ++token_version_;
       ESP_LOGI(TAG, "Token stored in RTC: valid=%d, stored_len=%u",
                rtc_token_->is_valid(), rtc_token_->token.length);
 
@@ -485,10 +530,17 @@ private:
   core::RtcAuthToken *rtc_token_;
   CloudConfig config_;
 
-  mutable core::Mutex mutex_;
+  JwtSigner signer_; // Key parsed once, reused by every refresh
+
+  mutable core::ProfiledLock<core::Mutex> mutex_{"device_auth"};
   AuthState state_{AuthState::Unauthenticated};
   AuthError last_error_{AuthError::None};
 
+  // Bumped on every token change; the header is re-rendered lazily
+  uint32_t token_version_{1};
+  uint32_t header_built_version_{0};
+  size_t header_len_{0};
+
   // Fixed buffers - no heap
   std::array<char, auth_buffers::AUTH_HEADER_SIZE> auth_header_buffer_{};
 };
@@ -0,0 +1,153 @@
+/**
+ * @file device_config.hpp
+ * @brief Runtime-tunable intervals and deadbands (config_update command)
+ *
+ * DeviceConfig holds the settings a fleet operator trades between freshness
+ * and battery: how often fixed-interval sensors sample, how long routine
+ * telemetry is batched before an upload, how often commands are polled and
+ * how coarse the report-by-exception deadbands are.
+ *
+ * The config_update command carries any subset of them; the others keep
+ * their current value. The whole update is validated before anything
+ * changes, so a bad field rejects the command instead of half-applying it.
+ * The application applies the result live and stores it (key
+ * device_config::KEY), so it survives a reboot.
+ *
+ * Payload (JSON, every member optional):
+ *   {"sample_interval_s":60,"upload_interval_s":900,"poll_interval_s":300,
+ *    "poll_max_interval_s":3600,"deadband_heartbeat_s":1800,
+ *    "deadband_pct":200}
+ */
+
+#pragma once
+
+#include "json_reader.hpp"
+
+#include <core/result.hpp>
+#include <core/storage.hpp>
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace cloud {
+
+namespace device_config {
+inline constexpr core::StorageKey KEY{"device_config"};
+/// Bumped when the stored layout changes (older blobs are ignored)
+inline constexpr uint32_t VERSION = 1;
+
+inline constexpr uint32_t MAX_INTERVAL_S = 24 * 60 * 60;
+inline constexpr uint32_t MIN_UPLOAD_INTERVAL_S = 10;
+/// CloudManager never polls faster than this either
+inline constexpr uint32_t MIN_POLL_INTERVAL_S = 5;
+/// 100 = the deadbands declared per measurement, 0 = filter off
+inline constexpr uint32_t MAX_DEADBAND_PERCENT = 1000;
+} // namespace device_config
+
+/// Settings changeable with config_update
+struct DeviceConfig {
+  uint32_t sample_interval_s{60};     ///< Fixed-interval monitors (not BSEC)
+  uint32_t upload_interval_s{120};    ///< Routine telemetry batch window
+  uint32_t poll_interval_s{60};       ///< Base command poll period
+  uint32_t poll_max_interval_s{900};  ///< Idle polls back off up to this
+  uint32_t deadband_heartbeat_s{900}; ///< Report unchanged values this often
+  uint32_t deadband_percent{0};       ///< Scale of the declared deadbands
+
+  bool operator==(const DeviceConfig &) const = default;
+
+  /// Every field within its range
+  [[nodiscard]] bool valid() const {
+    using namespace device_config;
+    auto in = [](uint32_t value, uint32_t min, uint32_t max) {
+      return value >= min && value <= max;
+    };
+    return in(sample_interval_s, 1, MAX_INTERVAL_S) &&
+           in(upload_interval_s, MIN_UPLOAD_INTERVAL_S, MAX_INTERVAL_S) &&
+           in(poll_interval_s, MIN_POLL_INTERVAL_S, MAX_INTERVAL_S) &&
+           in(poll_max_interval_s, poll_interval_s, MAX_INTERVAL_S) &&
+           in(deadband_heartbeat_s, 1, MAX_INTERVAL_S) &&
+           deadband_percent <= MAX_DEADBAND_PERCENT;
+  }
+};
+
+/// Stored form: the layout version first
+struct StoredDeviceConfig {
+  uint32_t version{device_config::VERSION};
+  DeviceConfig config{};
+};
+
+/// Merge a config_update payload into config
+/// @return false (config untouched) if the payload is malformed, a member
+///         has the wrong type or the merged settings are out of range
+[[nodiscard]] inline bool parse_config_update(std::string_view payload,
+                                              DeviceConfig &config) {
+  DeviceConfig next = config;
+  bool typed = true;
+  auto read = [&typed](json::Reader &r, uint32_t &field) {
+    int64_t value = 0;
+    if (!r.read_int(value) || value < 0 || value > UINT32_MAX) {
+      typed = false;
+      return;
+    }
+    field = static_cast<uint32_t>(value);
+  };
+
+  json::Reader reader(payload);
+  bool parsed = json::for_each_member(
+      reader, [&](std::string_view key, json::Reader &r) {
+        if (key == "sample_interval_s") {
+          read(r, next.sample_interval_s);
+        } else if (key == "upload_interval_s") {
+          read(r, next.upload_interval_s);
+        } else if (key == "poll_interval_s") {
+          read(r, next.poll_interval_s);
+        } else if (key == "poll_max_interval_s") {
+          read(r, next.poll_max_interval_s);
+        } else if (key == "deadband_heartbeat_s") {
+          read(r, next.deadband_heartbeat_s);
+        } else if (key == "deadband_pct") {
+          read(r, next.deadband_percent);
+        }
+      });
+  if (!parsed || !typed || !next.valid()) {
+    return false;
+  }
+  config = next;
+  return true;
+}
+
+/// Load the stored config
+/// @return ESP_ERR_NOT_FOUND if none is stored, ESP_ERR_INVALID_VERSION for
+///         an old layout or out-of-range values
+[[nodiscard]] inline core::Result<DeviceConfig>
+load_device_config(core::IStorage &storage) {
+  StoredDeviceConfig stored{};
+  auto size = storage.get_blob_size(device_config::KEY);
+  if (!size) {
+    return core::Err(size.error());
+  }
+  if (*size != sizeof(stored)) {
+    return core::Err(ESP_ERR_INVALID_VERSION);
+  }
+  if (auto status = storage.get_blob(
+          device_config::KEY,
+          std::span(reinterpret_cast<uint8_t *>(&stored), sizeof(stored)));
+      !status) {
+    return core::Err(status.error());
+  }
+  if (stored.version != device_config::VERSION || !stored.config.valid()) {
+    return core::Err(ESP_ERR_INVALID_VERSION);
+  }
+  return stored.config;
+}
+
+/// Write of stored (which must outlive it, e.g. until StorageWorker copied it)
+[[nodiscard]] inline core::StorageWrite
+device_config_write(const StoredDeviceConfig &stored) {
+  return core::StorageWrite::blob(
+      device_config::KEY,
+      std::span(reinterpret_cast<const uint8_t *>(&stored), sizeof(stored)));
+}
+
+} // namespace cloud
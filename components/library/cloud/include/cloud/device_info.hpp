@@ -0,0 +1,121 @@
+/**
+ * @file device_info.hpp
+ * @brief Device status report (PUT /devices/info) and its change hash
+ *
+ * The report rarely changes, but it is due after every authentication -
+ * i.e. on every WiFi reconnect. report_hash() folds a report into a CRC32;
+ * CloudManager keeps the hash of the last accepted report in RTC memory and
+ * skips the PUT while it still matches.
+ *
+ * Fields that drift all the time are coarsened first (heap to 16 KiB, RSSI
+ * to 10 dB bands) and sent that way, so a report goes out on a real change
+ * and the backend sees exactly what was hashed.
+ *
+ * Usage:
+ *   auto info = DeviceInfo{.app_name = "probe", .app_version = "1.2.0",
+ *                          .free_heap = esp_get_free_heap_size()}
+ *                   .coarse();
+ *   if (last_hash.get() != report_hash(info, device_id)) { send; }
+ */
+
+#pragma once
+
+#include <core/crc.hpp>
+#include <proto/command_adapter.hpp>
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+
+namespace cloud {
+
+namespace device_info {
+inline constexpr uint32_t HEAP_GRANULE = 16384;
+inline constexpr int RSSI_BAND_DB = 10;
+/// JSON body: names and version up to 31 chars each plus the numbers
+inline constexpr size_t JSON_SIZE = 320;
+} // namespace device_info
+
+/// Snapshot reported on PUT /devices/info (see DeviceInfo in command.proto)
+struct DeviceInfo {
+  std::string_view app_name;
+  std::string_view app_version;
+  uint32_t free_heap{0};
+  uint32_t min_free_heap{0};
+  uint32_t reset_reason{0}; ///< esp_reset_reason_t
+  int8_t rssi{0};           ///< dBm, 0 when not connected
+  uint8_t iaq_accuracy{0};  ///< BSEC 0-3
+
+  /// Copy with the drifting fields rounded down (what gets sent and hashed)
+  [[nodiscard]] DeviceInfo coarse() const {
+    DeviceInfo out = *this;
+    out.free_heap -= free_heap % device_info::HEAP_GRANULE;
+    out.min_free_heap -= min_free_heap % device_info::HEAP_GRANULE;
+    int band = rssi / device_info::RSSI_BAND_DB;
+    if (rssi < 0 && rssi % device_info::RSSI_BAND_DB != 0) {
+      --band; // Toward -inf: -67 dBm is the -70 band
+    }
+    out.rssi = static_cast<int8_t>(band * device_info::RSSI_BAND_DB);
+    return out;
+  }
+};
+
+/// CRC32 of a report as sent, tied to the device it was sent for
+[[nodiscard]] inline uint32_t report_hash(const DeviceInfo &info,
+                                          std::string_view device_id) {
+  core::Crc32 crc;
+  auto text = [&crc](std::string_view s) {
+    crc.update(static_cast<uint32_t>(s.size())); // "ab"+"c" != "a"+"bc"
+    crc.update(std::span(reinterpret_cast<const uint8_t *>(s.data()),
+                         s.size()));
+  };
+  text(device_id);
+  text(info.app_name);
+  text(info.app_version);
+  crc.update(info.free_heap);
+  crc.update(info.min_free_heap);
+  crc.update(info.reset_reason);
+  crc.update(info.rssi);
+  crc.update(info.iaq_accuracy);
+  return crc.value();
+}
+
+/// Encode as a DeviceInfo message
+/// @return Bytes written, or 0 on error (e.g. a name that doesn't fit)
+[[nodiscard]] inline size_t encode_device_info(const DeviceInfo &info,
+                                               std::span<uint8_t> buffer) {
+  cloud_DeviceInfo pb = cloud_DeviceInfo_init_zero;
+  if (!proto::copy_string(pb.app_name, info.app_name) ||
+      !proto::copy_string(pb.app_version, info.app_version)) {
+    return 0;
+  }
+  pb.free_heap = info.free_heap;
+  pb.min_free_heap = info.min_free_heap;
+  pb.reset_reason = info.reset_reason;
+  pb.rssi = info.rssi;
+  pb.iaq_accuracy = info.iaq_accuracy;
+  return proto::encode_device_info(pb, buffer);
+}
+
+/// Write as a JSON object with the proto field names
+/// @return Characters written, or 0 if buffer is too small
+[[nodiscard]] inline size_t write_device_info_json(const DeviceInfo &info,
+                                                   std::span<char> buffer) {
+  int n = snprintf(
+      buffer.data(), buffer.size(),
+      R"({"app_name":"%.*s","app_version":"%.*s","free_heap":%)" PRIu32
+      R"(,"min_free_heap":%)" PRIu32 R"(,"reset_reason":%)" PRIu32
+      R"(,"rssi":%d,"iaq_accuracy":%u})",
+      static_cast<int>(info.app_name.size()), info.app_name.data(),
+      static_cast<int>(info.app_version.size()), info.app_version.data(),
+      info.free_heap, info.min_free_heap, info.reset_reason,
+      static_cast<int>(info.rssi), static_cast<unsigned>(info.iaq_accuracy));
+  return (n < 0 || static_cast<size_t>(n) >= buffer.size())
+             ? 0
+             : static_cast<size_t>(n);
+}
+
+} // namespace cloud
@@ -0,0 +1,319 @@
+/**
+ * @file json_reader.hpp
+ * @brief Single-pass, zero-allocation JSON tokenizer for backend responses
+ *
+ * Reader walks the body once, left to right; strings and numbers come back
+ * as views into the original buffer. for_each_member() / for_each_element()
+ * dispatch each field to a handler, which reads the value with one of the
+ * typed read_*() calls, descends with another for_each_*(), or ignores it -
+ * an unread value is skipped without rescanning.
+ *
+ * Usage:
+ *   json::Reader reader(body);
+ *   std::string_view token;
+ *   int64_t expires_in = 3600;
+ *   json::for_each_member(reader, [&](std::string_view key, json::Reader &r) {
+ *     if (key == "token") (void)r.read_string(token);
+ *     else if (key == "expires_in") (void)r.read_int(expires_in);
+ *   });
+ *
+ * @note Escape sequences are found (an escaped quote doesn't end a string)
+ *       but not decoded: string views hold the escaped text.
+ * @note Tolerant tokenizer, not a validator: ',' and ':' are treated as
+ *       whitespace.
+ */
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace cloud::json {
+
+/// Lexical token
+enum class Token : uint8_t {
+  ObjectBegin,
+  ObjectEnd,
+  ArrayBegin,
+  ArrayEnd,
+  String,
+  Number,
+  True,
+  False,
+  Null,
+  End,   ///< Input exhausted
+  Error, ///< Malformed input (sticky)
+};
+
+/// Forward-only JSON token stream over a borrowed buffer
+class Reader {
+public:
+  explicit Reader(std::string_view json) : json_(json) {}
+
+  /// Advance to the next token; text() describes it
+  [[nodiscard]] Token next() {
+    if (failed_) {
+      return Token::Error;
+    }
+    skip_separators();
+    start_ = pos_;
+    if (pos_ >= json_.size()) {
+      text_ = {};
+      return Token::End;
+    }
+    ++count_;
+
+    char c = json_[pos_];
+    switch (c) {
+    case '{':
+      return single(Token::ObjectBegin);
+    case '}':
+      return single(Token::ObjectEnd);
+    case '[':
+      return single(Token::ArrayBegin);
+    case ']':
+      return single(Token::ArrayEnd);
+    case '"':
+      return string();
+    default:
+      return literal(c);
+    }
+  }
+
+  /// First character of the next token ('\0' at the end), not consumed
+  [[nodiscard]] char peek() {
+    skip_separators();
+    return pos_ < json_.size() ? json_[pos_] : '\0';
+  }
+
+  /// String contents (no quotes, escapes kept) or number / literal text
+  [[nodiscard]] std::string_view text() const { return text_; }
+
+  /// Tokens consumed so far
+  [[nodiscard]] size_t count() const { return count_; }
+
+  [[nodiscard]] bool failed() const { return failed_; }
+
+  /// Consume one whole value
+  /// @param[out] raw Its source text, brackets / quotes included
+  /// @return false at the end of a container or on malformed input
+  [[nodiscard]] bool read_raw(std::string_view &raw) {
+    auto token = next();
+    size_t start = start_;
+    if (!skip_rest(token) || !is_value(token)) {
+      return false;
+    }
+    raw = json_.substr(start, pos_ - start);
+    return true;
+  }
+
+  /// Consume one value; succeeds if it is a string
+  [[nodiscard]] bool read_string(std::string_view &value) {
+    auto token = next();
+    if (token != Token::String) {
+      (void)skip_rest(token);
+      return false;
+    }
+    value = text_;
+    return true;
+  }
+
+  /// Consume one value; succeeds if it is an integer that fits
+  [[nodiscard]] bool read_int(int64_t &value) {
+    auto token = next();
+    if (token != Token::Number) {
+      (void)skip_rest(token);
+      return false;
+    }
+    int64_t parsed = 0;
+    auto [end, ec] =
+        std::from_chars(text_.data(), text_.data() + text_.size(), parsed);
+    if (ec != std::errc{} || end != text_.data() + text_.size()) {
+      return false; // Fraction, exponent or out of range
+    }
+    value = parsed;
+    return true;
+  }
+
+  /// Consume one value; succeeds if it is true / false
+  [[nodiscard]] bool read_bool(bool &value) {
+    auto token = next();
+    if (token != Token::True && token != Token::False) {
+      (void)skip_rest(token);
+      return false;
+    }
+    value = token == Token::True;
+    return true;
+  }
+
+  /// Consume the rest of a value whose first token was just read
+  [[nodiscard]] bool skip_rest(Token first) {
+    if (first != Token::ObjectBegin && first != Token::ArrayBegin) {
+      return !failed_;
+    }
+    size_t depth = 1;
+    while (depth > 0) {
+      switch (next()) {
+      case Token::ObjectBegin:
+      case Token::ArrayBegin:
+        ++depth;
+        break;
+      case Token::ObjectEnd:
+      case Token::ArrayEnd:
+        --depth;
+        break;
+      case Token::End:
+      case Token::Error:
+        failed_ = true;
+        return false;
+      default:
+        break;
+      }
+    }
+    return true;
+  }
+
+private:
+  [[nodiscard]] static constexpr bool is_value(Token token) {
+    return token != Token::ObjectEnd && token != Token::ArrayEnd &&
+           token != Token::End && token != Token::Error;
+  }
+
+  [[nodiscard]] static constexpr bool is_delimiter(char c) {
+    return c == ',' || c == ':' || c == '{' || c == '}' || c == '[' ||
+           c == ']' || c == '"' || c == ' ' || c == '\t' || c == '\r' ||
+           c == '\n';
+  }
+
+  void skip_separators() {
+    while (pos_ < json_.size()) {
+      char c = json_[pos_];
+      if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != ',' &&
+          c != ':') {
+        break;
+      }
+      ++pos_;
+    }
+  }
+
+  Token single(Token token) {
+    text_ = json_.substr(pos_, 1);
+    ++pos_;
+    return token;
+  }
+
+  Token string() {
+    size_t begin = ++pos_;
+    while (pos_ < json_.size()) {
+      char c = json_[pos_];
+      if (c == '\\') {
+        pos_ += 2; // Escaped character can't end the string
+        continue;
+      }
+      if (c == '"') {
+        text_ = json_.substr(begin, pos_ - begin);
+        ++pos_;
+        return Token::String;
+      }
+      ++pos_;
+    }
+    return fail();
+  }
+
+  Token literal(char first) {
+    size_t begin = pos_;
+    while (pos_ < json_.size() && !is_delimiter(json_[pos_])) {
+      ++pos_;
+    }
+    text_ = json_.substr(begin, pos_ - begin);
+    if (text_ == "true") {
+      return Token::True;
+    }
+    if (text_ == "false") {
+      return Token::False;
+    }
+    if (text_ == "null") {
+      return Token::Null;
+    }
+    if (first == '-' || (first >= '0' && first <= '9')) {
+      return Token::Number;
+    }
+    return fail();
+  }
+
+  Token fail() {
+    failed_ = true;
+    text_ = {};
+    return Token::Error;
+  }
+
+  std::string_view json_;
+  std::string_view text_{};
+  size_t pos_{0};
+  size_t start_{0};
+  size_t count_{0};
+  bool failed_{false};
+};
+
+/// Dispatch each member of the next value (which must be an object)
+/// @param handler void(std::string_view key, Reader &) - reads the value
+///        or leaves it to be skipped
+/// @return false if the value isn't an object or the input is malformed
+template <typename Handler>
+[[nodiscard]] bool for_each_member(Reader &reader, Handler &&handler) {
+  auto token = reader.next();
+  if (token != Token::ObjectBegin) {
+    (void)reader.skip_rest(token);
+    return false;
+  }
+  while (true) {
+    token = reader.next();
+    if (token == Token::ObjectEnd) {
+      return true;
+    }
+    if (token != Token::String) {
+      return false;
+    }
+    auto key = reader.text();
+    size_t before = reader.count();
+    handler(key, reader);
+    if (reader.failed()) {
+      return false;
+    }
+    std::string_view unused;
+    if (reader.count() == before && !reader.read_raw(unused)) {
+      return false;
+    }
+  }
+}
+
+/// Dispatch each element of the next value (which must be an array)
+/// @param handler void(Reader &) - reads the element or leaves it
+/// @return false if the value isn't an array or the input is malformed
+template <typename Handler>
+[[nodiscard]] bool for_each_element(Reader &reader, Handler &&handler) {
+  auto token = reader.next();
+  if (token != Token::ArrayBegin) {
+    (void)reader.skip_rest(token);
+    return false;
+  }
+  while (true) {
+    if (reader.peek() == ']') {
+      (void)reader.next();
+      return true;
+    }
+    size_t before = reader.count();
+    handler(reader);
+    if (reader.failed()) {
+      return false;
+    }
+    std::string_view unused;
+    if (reader.count() == before && !reader.read_raw(unused)) {
+      return false;
+    }
+  }
+}
+
+} // namespace cloud::json
@@ -0,0 +1,276 @@
+/**
+ * @file jwt_signer.hpp
+ * @brief On-device ES256 (ECDSA P-256 / SHA-256) JWT minting
+ *
+ * Lets the device issue its own short-lived bearer token instead of
+ * exchanging credentials with the backend: a refresh costs one signature
+ * (tens of ms) instead of a TLS handshake and an HTTP round-trip.
+ *
+ * The PEM key is parsed once in init(); the ECP group and private scalar are
+ * kept for the signer's lifetime, so the group's precomputed comb table is
+ * built on the first signature only. mbedTLS uses the MPI / ECC accelerator
+ * when CONFIG_MBEDTLS_HARDWARE_MPI / _ECC enable it for the target.
+ *
+ * Usage:
+ *   JwtSigner signer;
+ *   if (signer.init(device_key_pem)) {
+ *     std::array<char, jwt::MAX_TOKEN_SIZE> token{};
+ *     auto len = signer.mint({.subject = device_id, .audience = "probes",
+ *                             .issued_at = system_clock::now()}, token);
+ *   }
+ */
+
+#pragma once
+
+#include "config.hpp"
+
+#include <core/result.hpp>
+#include <power/pm.hpp>
+
+#include <esp_log.h>
+#include <esp_random.h>
+#include <mbedtls/bignum.h>
+#include <mbedtls/ecdsa.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/sha256.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+
+namespace cloud {
+
+namespace jwt {
+/// Enough for the fixed header, a UUID subject and a short audience
+inline constexpr size_t MAX_TOKEN_SIZE = 512;
+inline constexpr size_t MAX_PAYLOAD_SIZE = 192;
+/// Earliest plausible wall-clock time; before it SNTP hasn't synced and a
+/// token would be rejected as issued in the past
+inline constexpr int64_t MIN_VALID_EPOCH = 1704067200; // 2024-01-01
+
+/// Base64url without padding (RFC 7515 section 2)
+/// @return Characters written, or 0 if out is too small
+[[nodiscard]] inline size_t base64url_encode(std::span<const uint8_t> in,
+                                             std::span<char> out) {
+  static constexpr std::string_view ALPHABET =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  size_t needed = ((in.size() * 4) + 2) / 3;
+  if (needed > out.size()) {
+    return 0;
+  }
+  size_t o = 0;
+  size_t i = 0;
+  for (; i + 3 <= in.size(); i += 3) {
+    uint32_t v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+    out[o++] = ALPHABET[(v >> 18) & 0x3F];
+    out[o++] = ALPHABET[(v >> 12) & 0x3F];
+    out[o++] = ALPHABET[(v >> 6) & 0x3F];
+    out[o++] = ALPHABET[v & 0x3F];
+  }
+  if (size_t rest = in.size() - i; rest > 0) {
+    uint32_t v = in[i] << 16;
+    if (rest == 2) {
+      v |= in[i + 1] << 8;
+    }
+    out[o++] = ALPHABET[(v >> 18) & 0x3F];
+    out[o++] = ALPHABET[(v >> 12) & 0x3F];
+    if (rest == 2) {
+      out[o++] = ALPHABET[(v >> 6) & 0x3F];
+    }
+  }
+  return o;
+}
+} // namespace jwt
+
+/// Registered claims of a minted token
+struct JwtClaims {
+  std::string_view subject;  ///< "sub", the device id
+  std::string_view audience; ///< "aud"
+  std::chrono::system_clock::time_point issued_at;
+  std::chrono::seconds lifetime{defaults::JWT_LIFETIME};
+};
+
+/// ES256 token signer holding the parsed device key
+///
+/// @thread_safety Not thread-safe. Serialize calls (DeviceAuthProvider
+///                does, under its mutex).
+class JwtSigner {
+public:
+  JwtSigner() {
+    mbedtls_ecp_group_init(&group_);
+    mbedtls_mpi_init(&key_);
+  }
+
+  ~JwtSigner() {
+    mbedtls_mpi_free(&key_);
+    mbedtls_ecp_group_free(&group_);
+  }
+
+  JwtSigner(const JwtSigner &) = delete;
+  JwtSigner &operator=(const JwtSigner &) = delete;
+  JwtSigner(JwtSigner &&) = delete;
+  JwtSigner &operator=(JwtSigner &&) = delete;
+
+  /// Parse the device's P-256 private key
+  /// @param key_pem PEM (SEC1 or PKCS#8); NUL-terminated, as PEM parsing in
+  ///        mbedTLS requires (BlobPartition::text() views are)
+  /// @return ESP_ERR_INVALID_ARG if the key doesn't parse or isn't P-256
+  [[nodiscard]] core::Status init(std::string_view key_pem) {
+    ready_ = false;
+    if (key_pem.empty()) {
+      return core::Err(ESP_ERR_INVALID_ARG);
+    }
+
+    mbedtls_pk_context pk;
+    mbedtls_pk_init(&pk);
+    int ret = mbedtls_pk_parse_key(
+        &pk, reinterpret_cast<const unsigned char *>(key_pem.data()),
+        key_pem.size() + 1, nullptr, 0, random, nullptr);
+    if (ret == 0 && mbedtls_pk_get_type(&pk) != MBEDTLS_PK_ECKEY) {
+      ret = MBEDTLS_ERR_PK_KEY_INVALID_FORMAT;
+    }
+    if (ret == 0) {
+      mbedtls_ecp_point public_key;
+      mbedtls_ecp_point_init(&public_key);
+      ret = mbedtls_ecp_export(mbedtls_pk_ec(pk), &group_, &key_, &public_key);
+      mbedtls_ecp_point_free(&public_key);
+    }
+    mbedtls_pk_free(&pk);
+
+    if (ret != 0) {
+      ESP_LOGE(TAG, "Device key rejected: -0x%04x",
+               static_cast<unsigned>(-ret));
+      return core::Err(ESP_ERR_INVALID_ARG);
+    }
+    if (group_.id != MBEDTLS_ECP_DP_SECP256R1) {
+      ESP_LOGE(TAG, "Device key is not P-256");
+      return core::Err(ESP_ERR_INVALID_ARG);
+    }
+
+    ready_ = true;
+    return core::Ok();
+  }
+
+  [[nodiscard]] bool is_ready() const { return ready_; }
+
+  /// Build and sign "header.payload.signature" into out (NUL-terminated)
+  /// @return Token length; ESP_ERR_INVALID_STATE before init() or if
+  ///         issued_at predates jwt::MIN_VALID_EPOCH (clock not set),
+  ///         ESP_ERR_INVALID_SIZE if out is too small
+  [[nodiscard]] core::Result<size_t> mint(const JwtClaims &claims,
+                                          std::span<char> out) {
+    if (!ready_) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    auto iat = std::chrono::duration_cast<std::chrono::seconds>(
+                   claims.issued_at.time_since_epoch())
+                   .count();
+    if (iat < jwt::MIN_VALID_EPOCH) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+
+    std::array<char, jwt::MAX_PAYLOAD_SIZE> payload{};
+    int payload_len = std::snprintf(
+        payload.data(), payload.size(),
+        R"({"sub":"%.*s","aud":"%.*s","iat":%lld,"exp":%lld})",
+        static_cast<int>(claims.subject.size()), claims.subject.data(),
+        static_cast<int>(claims.audience.size()), claims.audience.data(),
+        static_cast<long long>(iat),
+        static_cast<long long>(iat + claims.lifetime.count()));
+    if (payload_len < 0 || static_cast<size_t>(payload_len) >= payload.size()) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    // Signing input: base64url(header) "." base64url(payload)
+    size_t len = HEADER_B64.size();
+    if (out.size() <= len + 1) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::ranges::copy(HEADER_B64, out.begin());
+    out[len++] = '.';
+    size_t n = jwt::base64url_encode(
+        std::span(reinterpret_cast<const uint8_t *>(payload.data()),
+                  static_cast<size_t>(payload_len)),
+        out.subspan(len));
+    if (n == 0) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    len += n;
+
+    std::array<uint8_t, SIGNATURE_SIZE> signature{};
+    if (auto status = sign(std::span(reinterpret_cast<const uint8_t *>(
+                                         out.data()),
+                                     len),
+                           signature);
+        !status) {
+      return core::Err(status.error());
+    }
+
+    // ".signature" plus the NUL
+    if (out.size() < len + 1 + SIGNATURE_B64_SIZE + 1) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    out[len++] = '.';
+    len += jwt::base64url_encode(signature, out.subspan(len));
+    out[len] = '\0';
+    return len;
+  }
+
+private:
+  static constexpr const char *TAG = "JwtSigner";
+
+  /// base64url({"alg":"ES256","typ":"JWT"})
+  static constexpr std::string_view HEADER_B64 =
+      "eyJhbGciOiJFUzI1NiIsInR5cCI6IkpXVCJ9";
+  /// JWS ES256 signature: R and S, 32 bytes each, big-endian (not DER)
+  static constexpr size_t COORD_SIZE = 32;
+  static constexpr size_t SIGNATURE_SIZE = 2 * COORD_SIZE;
+  static constexpr size_t SIGNATURE_B64_SIZE = 86;
+
+  /// mbedTLS RNG callback on the hardware RNG
+  static int random(void * /*ctx*/, unsigned char *buf, size_t len) {
+    esp_fill_random(buf, len);
+    return 0;
+  }
+
+  [[nodiscard]] core::Status sign(std::span<const uint8_t> input,
+                                  std::span<uint8_t, SIGNATURE_SIZE> out) {
+    power::PerformancePhase boost; // P-256 at full clock
+    std::array<uint8_t, 32> hash{};
+    if (mbedtls_sha256(input.data(), input.size(), hash.data(), 0) != 0) {
+      return core::Err(ESP_FAIL);
+    }
+
+    mbedtls_mpi r;
+    mbedtls_mpi s;
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    int ret = mbedtls_ecdsa_sign(&group_, &r, &s, &key_, hash.data(),
+                                 hash.size(), random, nullptr);
+    if (ret == 0) {
+      ret = mbedtls_mpi_write_binary(&r, out.data(), COORD_SIZE);
+    }
+    if (ret == 0) {
+      ret = mbedtls_mpi_write_binary(&s, out.data() + COORD_SIZE, COORD_SIZE);
+    }
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&r);
+
+    if (ret != 0) {
+      ESP_LOGE(TAG, "Signing failed: -0x%04x", static_cast<unsigned>(-ret));
+      return core::Err(ESP_FAIL);
+    }
+    return core::Ok();
+  }
+
+  mbedtls_ecp_group group_;
+  mbedtls_mpi key_;
+  bool ready_{false};
+};
+
+} // namespace cloud
@@ -17,10 +17,21 @@ namespace cloud {
 /// Protobuf serializer for sensor measurements
 class MeasurementSerializer final : public ISerializer<sensor::Measurement> {
 public:
+  explicit MeasurementSerializer(
+      proto::WireEncoding encoding = proto::WireEncoding::Native)
+      : encoding_(encoding) {}
+
   size_t serialize(std::span<const sensor::Measurement> items,
                    std::span<uint8_t> buffer) override {
-    return proto::encode_batch(items, buffer);
+    return proto::encode_batch(items, buffer, encoding_);
+  }
+
+  [[nodiscard]] size_t max_items() const override {
+    return proto::MAX_MEASUREMENTS_PER_BATCH;
   }
+
+private:
+  proto::WireEncoding encoding_;
 };
 
 } // namespace cloud
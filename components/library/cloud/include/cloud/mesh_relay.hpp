@@ -0,0 +1,298 @@
+/**
+ * @file mesh_relay.hpp
+ * @brief Samples of a local ESP-NOW cluster, uploaded by one probe
+ *
+ * A leaf (battery probe) skips WiFi association, DHCP and TLS: each wake
+ * hands its samples to a mains-powered aggregator over ESP-NOW
+ * (transport::EspNowTransport), milliseconds of radio time instead of
+ * seconds. The aggregator queues them in CloudManager's outbox next to its
+ * own, so the whole cluster goes out in one batched upload. CloudManager
+ * is not thread-safe: the receiving task only parks messages in an inbox,
+ * the task that owns CloudManager moves them to the outbox.
+ *
+ * A message is a MeshHeader and the leaf's packed records
+ * (sensor::PackedMeasurement, 8 bytes each, as RtcSampleBuffer keeps
+ * them); every sample starts at a Timestamp. The aggregator prefixes each
+ * sample with id=Origin (the leaf's station MAC), which tells the backend
+ * whose it is.
+ *
+ * A leaf never runs SNTP, so its Timestamps are on a clock of its own
+ * (the RTC clock, which keeps running through deep sleep). The header
+ * carries that clock's time at sending; the aggregator re-stamps each
+ * sample as its own synchronized time minus the sample's age.
+ *
+ *   // Leaf, each wake
+ *   if (cloud::send_mesh_records(mesh, g_samples.records())) {
+ *     g_samples.clear();
+ *   }
+ *
+ *   // Aggregator, on a task of its own
+ *   cloud::MeshRelay relay(mesh, cloud);
+ *   while (true) {
+ *     if (relay.relay_one(std::chrono::seconds(60))) {
+ *       cloud_worker.post(WORK_RELAY);
+ *     }
+ *   }
+ *
+ *   // Aggregator, on the task that owns the CloudManager
+ *   (void)relay.forward();
+ */
+
+#pragma once
+
+#include "cloud_manager.hpp"
+
+#include <core/clock.hpp>
+#include <core/result.hpp>
+#include <core/spsc_queue.hpp>
+#include <sensor/measurement.hpp>
+#include <sensor/packed_measurement.hpp>
+#include <transport/espnow_transport.hpp>
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace cloud {
+
+/// Header of a leaf message
+struct MeshHeader {
+  uint8_t version;  // MESH_VERSION
+  uint8_t reserved; // 0
+  uint16_t count;   // Records after the header
+  uint32_t padding; // 0
+  uint64_t sent_ms; // Sender's clock (its Timestamps' time base) at sending
+};
+
+static_assert(sizeof(MeshHeader) == 16, "Sent as laid out in memory");
+
+inline constexpr uint8_t MESH_VERSION = 2;
+
+static_assert(sizeof(sensor::PackedMeasurement) == 8,
+              "Records are sent as they are laid out in memory");
+
+/// Records in one message at most
+inline constexpr size_t MESH_MAX_RECORDS =
+    (transport::EspNowTransport::MAX_MESSAGE_SIZE - sizeof(MeshHeader)) /
+    sizeof(sensor::PackedMeasurement);
+
+/// Send packed records (as held by RtcSampleBuffer), split into messages
+/// at sample boundaries
+/// @return The first failed message's error; records sent before it may
+///         be sent again by a retry (the backend sees them twice)
+[[nodiscard]] inline core::Status
+send_mesh_records(transport::ITransport &mesh,
+                  std::span<const sensor::PackedMeasurement> records) {
+  std::array<uint8_t, transport::EspNowTransport::MAX_MESSAGE_SIZE> body{};
+
+  while (!records.empty()) {
+    size_t count = std::min(records.size(), MESH_MAX_RECORDS);
+    if (count < records.size()) {
+      // End before the last sample that doesn't fit whole
+      for (size_t i = count; i > 1; --i) {
+        if (records[i].id == sensor::MeasurementId::Timestamp) {
+          count = i;
+          break;
+        }
+      }
+    }
+
+    MeshHeader header{
+        .version = MESH_VERSION,
+        .reserved = 0,
+        .count = static_cast<uint16_t>(count),
+        .padding = 0,
+        .sent_ms = core::clock::to_epoch_ms(core::clock::monotonic_ms()),
+    };
+    std::memcpy(body.data(), &header, sizeof(header));
+    std::memcpy(body.data() + sizeof(header), records.data(),
+                count * sizeof(sensor::PackedMeasurement));
+
+    transport::Request request{
+        .method = transport::HttpMethod::Post,
+        .path = {}, // ESP-NOW carries the body only
+        .body = std::span(body.data(), sizeof(header) +
+                                           (count * sizeof(records[0]))),
+        .content_type = transport::ContentType::OctetStream,
+        .message_class = transport::MessageClass::Telemetry,
+    };
+    auto result = mesh.send(request);
+    if (!result) {
+      return core::Err(result.error());
+    }
+    records = records.subspan(count);
+  }
+  return core::Ok();
+}
+
+/// Origin of a leaf's samples (its station MAC, first byte highest)
+[[nodiscard]] inline uint64_t mesh_origin(const transport::MacAddress &mac) {
+  uint64_t origin = 0;
+  for (uint8_t b : mac) {
+    origin = (origin << 8) | b;
+  }
+  return origin;
+}
+
+/// Queues the samples of leaf messages in a CloudManager's outbox
+///
+/// @thread_safety One task calls relay_one(), the one that owns the
+///                CloudManager calls forward(); the counters from any.
+class MeshRelay {
+public:
+  /// Measurements of one relayed sample (longer ones are split)
+  static constexpr size_t MAX_SAMPLE = 32;
+  /// Leaf messages received and not yet forwarded
+  static constexpr size_t INBOX_DEPTH = 4;
+
+  MeshRelay(transport::EspNowTransport &mesh, CloudManager &cloud)
+      : mesh_(mesh), cloud_(cloud) {}
+
+  /// Wait for a leaf message and park it for forward()
+  /// @return ESP_ERR_TIMEOUT if none came, ESP_ERR_INVALID_RESPONSE if it
+  ///         was malformed, ESP_ERR_NO_MEM if the inbox was full (its
+  ///         samples dropped)
+  [[nodiscard]] core::Status relay_one(std::chrono::milliseconds timeout) {
+    transport::MacAddress from{};
+    auto message = mesh_.receive_from(timeout, from);
+    if (!message) {
+      return core::Err(message.error());
+    }
+
+    auto body = message->body();
+    MeshHeader header{};
+    if (body.size() < sizeof(header)) {
+      return core::Err(ESP_ERR_INVALID_RESPONSE);
+    }
+    std::memcpy(&header, body.data(), sizeof(header));
+    auto payload = body.subspan(sizeof(header));
+    if (header.version != MESH_VERSION || header.count > MESH_MAX_RECORDS ||
+        payload.size() != header.count * sizeof(sensor::PackedMeasurement)) {
+      ESP_LOGW(TAG, "Malformed message from " MACSTR, MAC2STR(from));
+      return core::Err(ESP_ERR_INVALID_RESPONSE);
+    }
+
+    Parked *parked = inbox_.reserve();
+    if (parked == nullptr) {
+      dropped_.fetch_add(count_samples(payload, header.count),
+                         std::memory_order_relaxed);
+      return core::Err(ESP_ERR_NO_MEM);
+    }
+    parked->origin = mesh_origin(from);
+    parked->sent_ms = header.sent_ms;
+    parked->received_ms =
+        core::clock::to_epoch_ms(core::clock::monotonic_ms());
+    parked->count = header.count;
+    std::memcpy(parked->records.data(), payload.data(), payload.size());
+    inbox_.commit();
+
+    ESP_LOGD(TAG, "%u record(s) from " MACSTR, header.count, MAC2STR(from));
+    return core::Ok();
+  }
+
+  /// Queue the samples of the parked messages (batched)
+  /// @return ESP_ERR_NO_MEM if the outbox had no room for some of them
+  ///         (dropped; the batch is due)
+  [[nodiscard]] core::Status forward() {
+    uint32_t lost_before = dropped_.load(std::memory_order_relaxed);
+    while (const Parked *parked = inbox_.front()) {
+      queue_samples(*parked);
+      inbox_.pop();
+    }
+    if (dropped_.load(std::memory_order_relaxed) != lost_before) {
+      return core::Err(ESP_ERR_NO_MEM);
+    }
+    return core::Ok();
+  }
+
+  /// Samples queued for upload
+  [[nodiscard]] uint32_t relayed() const {
+    return relayed_.load(std::memory_order_relaxed);
+  }
+
+  /// Samples the inbox or the outbox had no room for
+  [[nodiscard]] uint32_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr const char *TAG = "MeshRelay";
+
+  /// A received leaf message
+  struct Parked {
+    uint64_t origin;      ///< mesh_origin() of the sender
+    uint64_t sent_ms;     ///< MeshHeader::sent_ms
+    uint64_t received_ms; ///< This device's clock on receipt
+    size_t count;         ///< Records used
+    std::array<sensor::PackedMeasurement, MESH_MAX_RECORDS> records;
+  };
+
+  /// Samples in a message (each starts at a Timestamp)
+  [[nodiscard]] static uint32_t
+  count_samples(std::span<const uint8_t> payload, size_t count) {
+    uint32_t samples = 0;
+    for (size_t i = 0; i < count; ++i) {
+      sensor::PackedMeasurement record{};
+      std::memcpy(&record, payload.data() + (i * sizeof(record)),
+                  sizeof(record));
+      if (record.id == sensor::MeasurementId::Timestamp || samples == 0) {
+        ++samples;
+      }
+    }
+    return samples;
+  }
+
+  /// A leaf's stamp on this device's clock: now minus the sample's age
+  /// (0 while this device has no time either)
+  [[nodiscard]] static sensor::Measurement
+  restamp(uint64_t stamp_ms, uint64_t sent_ms, uint64_t now_ms) {
+    uint64_t age_ms = sent_ms > stamp_ms ? sent_ms - stamp_ms : 0;
+    uint64_t epoch_ms = now_ms > age_ms ? now_ms - age_ms : 0;
+    return sensor::make<sensor::MeasurementId::Timestamp>(epoch_ms);
+  }
+
+  void queue_samples(const Parked &parked) {
+    // sample[0] stays the Origin marker
+    std::array<sensor::Measurement, MAX_SAMPLE + 1> sample{};
+    sample.at(0) = sensor::make<sensor::MeasurementId::Origin>(parked.origin);
+    size_t len = 1;
+
+    for (size_t i = 0; i < parked.count; ++i) {
+      auto m = parked.records.at(i).unpack();
+      if (m.id == sensor::MeasurementId::Timestamp) {
+        m = restamp(m.to<uint64_t>(), parked.sent_ms, parked.received_ms);
+      }
+      if ((m.id == sensor::MeasurementId::Timestamp && len > 1) ||
+          len == sample.size()) {
+        queue(std::span(sample.data(), len));
+        len = 1;
+      }
+      sample.at(len++) = m;
+    }
+    if (len > 1) {
+      queue(std::span(sample.data(), len));
+    }
+  }
+
+  void queue(std::span<const sensor::Measurement> sample) {
+    if (cloud_.queue_telemetry(sample, Priority::Batched)) {
+      relayed_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  transport::EspNowTransport &mesh_;
+  CloudManager &cloud_;
+  core::SpscQueue<Parked, INBOX_DEPTH> inbox_;
+  std::atomic<uint32_t> relayed_{0};
+  std::atomic<uint32_t> dropped_{0};
+};
+
+} // namespace cloud
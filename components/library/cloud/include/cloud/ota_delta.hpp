@@ -0,0 +1,285 @@
+/**
+ * @file ota_delta.hpp
+ * @brief Streaming delta-image patcher for OTA updates
+ *
+ * Most releases change a few KB of a 1.5 MB image. A delta patch describes
+ * the new image as byte ranges copied from the running slot plus the bytes
+ * that are new, so only the latter travel over the air (tools/otadelta
+ * builds the patch from the two .bin files).
+ *
+ * DeltaPatcher is the download sink: it parses the patch as it arrives, in
+ * whatever pieces the connection delivers, reads copied ranges from the
+ * running partition and forwards the rebuilt image to the next stream
+ * (OtaUpdater's flash writer). It holds only its parse state and one copy
+ * buffer, and its state survives a dropped connection, so an interrupted
+ * download resumes mid-patch like a full image does.
+ *
+ * Patch format (little-endian):
+ *   "PDL1"
+ *   base_id[32]    app_elf_sha256 of the image the patch was made against
+ *   target_size    u32, size of the rebuilt image
+ *   op*            until target_size bytes are produced:
+ *     0x00 COPY    zigzag varint offset (relative to the end of the previous
+ *                  copy), varint length
+ *     0x01 INSERT  varint length, then that many literal bytes
+ */
+
+#pragma once
+
+#include <core/body_stream.hpp>
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace cloud {
+
+namespace ota_delta {
+inline constexpr std::array<uint8_t, 4> MAGIC{'P', 'D', 'L', '1'};
+inline constexpr size_t BASE_ID_SIZE = 32;
+inline constexpr size_t HEADER_SIZE = MAGIC.size() + BASE_ID_SIZE + 4;
+inline constexpr uint8_t OP_COPY = 0x00;
+inline constexpr uint8_t OP_INSERT = 0x01;
+/// Source bytes read per esp_partition_read() of a COPY
+inline constexpr size_t COPY_BUFFER_SIZE = 1024;
+} // namespace ota_delta
+
+/// Rebuilds an image from a delta patch and the running slot
+///
+/// @thread_safety Not thread-safe; fed by one download at a time.
+class DeltaPatcher final : public core::BodyStream {
+public:
+  /// @param out Receives the rebuilt image
+  /// @param source Partition the patch was made against (the running slot)
+  /// @param base_id esp_app_desc_t::app_elf_sha256 of the running image
+  /// @param max_target Largest image accepted (the update slot's size)
+  DeltaPatcher(core::BodyStream &out, const esp_partition_t *source,
+               std::span<const uint8_t, ota_delta::BASE_ID_SIZE> base_id,
+               size_t max_target)
+      : out_(out), source_(source), max_target_(max_target) {
+    std::ranges::copy(base_id, base_id_.begin());
+  }
+
+  /// Forget progress (the image is restarting from byte 0)
+  void reset() {
+    state_ = State::Header;
+    header_len_ = 0;
+    target_size_ = 0;
+    produced_ = 0;
+    source_pos_ = 0;
+    error_ = ESP_OK;
+  }
+
+  [[nodiscard]] bool write(std::span<const uint8_t> data) override {
+    while (!data.empty()) {
+      switch (state_) {
+      case State::Header: {
+        size_t n = std::min(data.size(), header_.size() - header_len_);
+        std::copy_n(data.begin(), n, header_.begin() + header_len_);
+        header_len_ += n;
+        data = data.subspan(n);
+        if (header_len_ == header_.size() && !parse_header()) {
+          return false;
+        }
+        break;
+      }
+      case State::Tag:
+        op_ = data[0];
+        data = data.subspan(1);
+        if (op_ != ota_delta::OP_COPY && op_ != ota_delta::OP_INSERT) {
+          return fail(ESP_ERR_INVALID_ARG, "unknown op");
+        }
+        start_varint(op_ == ota_delta::OP_COPY ? State::Offset
+                                               : State::Length);
+        break;
+      case State::Offset:
+      case State::Length:
+        if (!take_varint(data[0])) {
+          return false;
+        }
+        data = data.subspan(1);
+        if (varint_done_ && !on_varint()) {
+          return false;
+        }
+        break;
+      case State::Insert: {
+        size_t n = static_cast<size_t>(
+            std::min<uint64_t>(remaining_, data.size()));
+        if (!emit(data.first(n))) {
+          return false;
+        }
+        remaining_ -= n;
+        data = data.subspan(n);
+        if (remaining_ == 0) {
+          next_op();
+        }
+        break;
+      }
+      case State::Done:
+        return fail(ESP_ERR_INVALID_SIZE, "data after the last op");
+      case State::Failed:
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Every target byte produced
+  [[nodiscard]] bool done() const { return state_ == State::Done; }
+  [[nodiscard]] size_t target_size() const { return target_size_; }
+  [[nodiscard]] size_t produced() const { return produced_; }
+  /// Why write() refused (ESP_OK while healthy)
+  [[nodiscard]] esp_err_t error() const { return error_; }
+
+private:
+  static constexpr const char *TAG = "OtaDelta";
+
+  enum class State : uint8_t {
+    Header,
+    Tag,
+    Offset, ///< COPY offset varint
+    Length, ///< COPY / INSERT length varint
+    Insert, ///< Literal bytes
+    Done,
+    Failed,
+  };
+
+  [[nodiscard]] bool parse_header() {
+    if (!std::equal(ota_delta::MAGIC.begin(), ota_delta::MAGIC.end(),
+                    header_.begin())) {
+      return fail(ESP_ERR_INVALID_ARG, "not a delta patch");
+    }
+    auto base = std::span(header_).subspan(ota_delta::MAGIC.size(),
+                                           ota_delta::BASE_ID_SIZE);
+    if (!std::ranges::equal(base, base_id_)) {
+      return fail(ESP_ERR_INVALID_VERSION, "made for another base image");
+    }
+    size_t at = ota_delta::MAGIC.size() + ota_delta::BASE_ID_SIZE;
+    target_size_ = static_cast<size_t>(header_.at(at)) |
+                   (static_cast<size_t>(header_.at(at + 1)) << 8) |
+                   (static_cast<size_t>(header_.at(at + 2)) << 16) |
+                   (static_cast<size_t>(header_.at(at + 3)) << 24);
+    if (target_size_ == 0 || target_size_ > max_target_) {
+      return fail(ESP_ERR_INVALID_SIZE, "target size out of range");
+    }
+    state_ = State::Tag;
+    return true;
+  }
+
+  void start_varint(State state) {
+    state_ = state;
+    varint_ = 0;
+    varint_shift_ = 0;
+    varint_done_ = false;
+  }
+
+  [[nodiscard]] bool take_varint(uint8_t byte) {
+    if (varint_shift_ > 63) {
+      return fail(ESP_ERR_INVALID_ARG, "varint too long");
+    }
+    varint_ |= static_cast<uint64_t>(byte & 0x7F) << varint_shift_;
+    varint_shift_ += 7;
+    varint_done_ = (byte & 0x80) == 0;
+    return true;
+  }
+
+  /// A complete varint for the current state
+  [[nodiscard]] bool on_varint() {
+    if (state_ == State::Offset) {
+      // Zigzag: 0, 1, 2, 3, ... stand for 0, -1, 1, -2, ...
+      copy_delta_ = static_cast<int64_t>(varint_ >> 1) ^
+                    -static_cast<int64_t>(varint_ & 1);
+      start_varint(State::Length);
+      return true;
+    }
+    if (varint_ > target_size_ - produced_) {
+      return fail(ESP_ERR_INVALID_SIZE, "op past the end of the image");
+    }
+    if (op_ == ota_delta::OP_INSERT) {
+      remaining_ = varint_;
+      state_ = State::Insert;
+      if (remaining_ == 0) {
+        next_op();
+      }
+      return true;
+    }
+    if (!copy(copy_delta_, static_cast<size_t>(varint_))) {
+      return false;
+    }
+    next_op();
+    return true;
+  }
+
+  /// COPY length bytes from the running slot
+  [[nodiscard]] bool copy(int64_t delta, size_t length) {
+    int64_t start = static_cast<int64_t>(source_pos_) + delta;
+    if (start < 0 ||
+        static_cast<uint64_t>(start) + length > source_->size) {
+      return fail(ESP_ERR_INVALID_ARG, "copy outside the running image");
+    }
+    auto pos = static_cast<size_t>(start);
+    while (length > 0) {
+      size_t n = std::min(length, copy_buffer_.size());
+      if (esp_err_t err =
+              esp_partition_read(source_, pos, copy_buffer_.data(), n);
+          err != ESP_OK) {
+        return fail(err, "source read failed");
+      }
+      if (!emit(std::span(copy_buffer_.data(), n))) {
+        return false;
+      }
+      pos += n;
+      length -= n;
+    }
+    source_pos_ = pos;
+    return true;
+  }
+
+  [[nodiscard]] bool emit(std::span<const uint8_t> bytes) {
+    if (!out_.write(bytes)) {
+      return fail(ESP_FAIL, "image write failed");
+    }
+    produced_ += bytes.size();
+    return true;
+  }
+
+  void next_op() {
+    state_ = produced_ == target_size_ ? State::Done : State::Tag;
+  }
+
+  [[nodiscard]] bool fail(esp_err_t err, const char *why) {
+    ESP_LOGE(TAG, "Patch rejected at %zu/%zu: %s", produced_, target_size_,
+             why);
+    error_ = err;
+    state_ = State::Failed;
+    return false;
+  }
+
+  core::BodyStream &out_;
+  const esp_partition_t *source_;
+  std::array<uint8_t, ota_delta::BASE_ID_SIZE> base_id_{};
+  size_t max_target_;
+
+  State state_{State::Header};
+  std::array<uint8_t, ota_delta::HEADER_SIZE> header_{};
+  size_t header_len_{0};
+  size_t target_size_{0};
+  size_t produced_{0};
+  size_t source_pos_{0}; ///< End of the previous COPY
+  uint8_t op_{0};
+  uint64_t varint_{0};
+  uint8_t varint_shift_{0};
+  bool varint_done_{false};
+  int64_t copy_delta_{0};
+  uint64_t remaining_{0}; ///< INSERT bytes still to come
+  esp_err_t error_{ESP_OK};
+  std::array<uint8_t, ota_delta::COPY_BUFFER_SIZE> copy_buffer_{};
+};
+
+} // namespace cloud
@@ -0,0 +1,445 @@
+/**
+ * @file ota_updater.hpp
+ * @brief Streaming, resumable A/B firmware update
+ *
+ * The ota_update command names an image URL, its size and SHA-256. The
+ * updater runs on its own task: HttpClient::download() reads the image in
+ * ota::CHUNK_SIZE pieces and each one goes straight to esp_ota_write() into
+ * the idle ota_N slot and into a running SHA-256. No more than one chunk of
+ * the image is ever in RAM.
+ *
+ * With "delta":true the URL is a patch against the running image instead
+ * (see ota_delta.hpp): the download goes through a DeltaPatcher, which
+ * rebuilds the image on the way to flash. size is then the patch size and
+ * sha256 still that of the rebuilt image.
+ *
+ * A dropped connection keeps the OTA handle, the hash and patch state and
+ * the byte count; the next attempt asks for "Range: bytes=<received>-" and
+ * carries on, so a weak link costs retries, not restarts. A server that
+ * ignores the range (200 instead of 206) starts the image over.
+ *
+ * With every byte in, the digest is compared, esp_ota_end() validates the
+ * image and the new slot becomes the boot partition. on_done gets Ok() and
+ * the application decides when to reboot. After that reboot the bootloader
+ * keeps the previous slot as fallback until confirm_running_image().
+ *
+ * Payload (JSON; must fit COMMAND_PAYLOAD_SIZE, so keep the URL short - a
+ * public object or a redirecting link, redirects are followed):
+ *   {"url":"https://storage.googleapis.com/fw/probe-0.2.0.bin",
+ *    "size":1572864,"sha256":"<64 hex digits>"}
+ *   {"url":"https://storage.googleapis.com/fw/probe-0.2.0.pdl",
+ *    "size":48213,"sha256":"<of the rebuilt image>","delta":true}
+ */
+
+#pragma once
+
+#include "command.hpp"
+#include "json_reader.hpp"
+#include "ota_delta.hpp"
+
+#include <core/body_stream.hpp>
+#include <core/fault.hpp>
+#include <core/http_client.hpp>
+#include <core/result.hpp>
+#include <core/task.hpp>
+#include <core/worker.hpp>
+
+#include <esp_app_desc.h>
+#include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace cloud {
+
+namespace ota {
+/// Bytes per read and esp_ota_write() (one flash sector)
+inline constexpr size_t CHUNK_SIZE = 4096;
+inline constexpr size_t URL_SIZE = COMMAND_PAYLOAD_SIZE;
+inline constexpr size_t SHA256_SIZE = 32;
+/// Attempts in a row that add no bytes before the update is abandoned
+inline constexpr uint8_t MAX_STALLED_ATTEMPTS = 8;
+inline constexpr std::chrono::seconds RETRY_DELAY{5};
+inline constexpr std::chrono::seconds MAX_RETRY_DELAY{300};
+/// TLS handshake runs on the OTA task
+inline constexpr uint32_t TASK_STACK = 8192;
+/// Error bodies are only logged
+inline constexpr size_t ERROR_BODY_SIZE = 512;
+
+/// Decode 64 hex digits
+[[nodiscard]] inline bool
+decode_sha256(std::string_view hex, std::array<uint8_t, SHA256_SIZE> &out) {
+  auto nibble = [](char c) -> int {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  };
+  if (hex.size() != 2 * out.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < out.size(); ++i) {
+    int hi = nibble(hex[2 * i]);
+    int lo = nibble(hex[(2 * i) + 1]);
+    if (hi < 0 || lo < 0) {
+      return false;
+    }
+    out.at(i) = static_cast<uint8_t>((hi << 4) | lo);
+  }
+  return true;
+}
+} // namespace ota
+
+/// Parsed ota_update command
+struct OtaRequest {
+  std::string_view url; ///< View into the command payload
+  size_t size{0};
+  std::array<uint8_t, ota::SHA256_SIZE> sha256{}; ///< Of the final image
+  bool delta{false}; ///< url is a delta patch against the running image
+};
+
+/// Parse an ota_update payload
+/// @return std::nullopt if url, size or sha256 is missing or malformed
+[[nodiscard]] inline std::optional<OtaRequest>
+parse_ota_request(std::string_view payload) {
+  OtaRequest request;
+  std::string_view sha256;
+  int64_t size = 0;
+  json::Reader reader(payload);
+  bool parsed = json::for_each_member(
+      reader, [&](std::string_view key, json::Reader &r) {
+        if (key == "url") {
+          (void)r.read_string(request.url);
+        } else if (key == "size") {
+          (void)r.read_int(size);
+        } else if (key == "sha256") {
+          (void)r.read_string(sha256);
+        } else if (key == "delta") {
+          (void)r.read_bool(request.delta);
+        }
+      });
+  if (!parsed || request.url.empty() || size <= 0 ||
+      !ota::decode_sha256(sha256, request.sha256)) {
+    return std::nullopt;
+  }
+  request.size = static_cast<size_t>(size);
+  return request;
+}
+
+/// Update progress
+enum class OtaState : uint8_t {
+  Idle,
+  Downloading,
+  Ready,  ///< Written and verified, boots on the next restart
+  Failed, ///< The previous image stays in charge
+};
+
+/// Firmware updater
+///
+/// @thread_safety start() from one task (the command handler); state() and
+///                bytes_received() from any.
+class OtaUpdater {
+public:
+  /// Called on the OTA task once the update finished or was abandoned
+  using DoneFn = std::function<void(core::Status)>;
+
+  OtaUpdater() { mbedtls_sha256_init(&sha_); }
+
+  ~OtaUpdater() {
+    abort_image();
+    mbedtls_sha256_free(&sha_);
+  }
+
+  OtaUpdater(const OtaUpdater &) = delete;
+  OtaUpdater &operator=(const OtaUpdater &) = delete;
+  OtaUpdater(OtaUpdater &&) = delete;
+  OtaUpdater &operator=(OtaUpdater &&) = delete;
+
+  /// Queue an update; the download runs on the OTA task
+  /// @return ESP_ERR_INVALID_STATE while one is in progress,
+  ///         ESP_ERR_INVALID_SIZE if the URL is too long
+  [[nodiscard]] core::Status start(const OtaRequest &request, DoneFn on_done) {
+    if (state_ == OtaState::Downloading) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    if (request.url.size() >= url_.size()) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::ranges::copy(request.url, url_.begin());
+    url_.at(request.url.size()) = '\0';
+    url_len_ = request.url.size();
+    size_ = request.size;
+    expected_sha256_ = request.sha256;
+    delta_ = request.delta;
+    on_done_ = std::move(on_done);
+
+    if (!worker_.is_running()) {
+      if (auto status = worker_.start([this](uint32_t) { run(); });
+          !status) {
+        return status;
+      }
+    }
+    state_ = OtaState::Downloading;
+    worker_.post(1);
+    return core::Ok();
+  }
+
+  [[nodiscard]] OtaState state() const { return state_; }
+  /// Image (or patch) bytes downloaded so far
+  [[nodiscard]] size_t bytes_received() const { return received_; }
+
+  /// Keep the image now running (cancels the bootloader's rollback)
+  ///
+  /// Call once the new firmware has proven itself - e.g. after it reached
+  /// the backend. No-op unless the image is still pending verification.
+  static void confirm_running_image() {
+    esp_ota_img_states_t state{};
+    if (esp_ota_get_state_partition(esp_ota_get_running_partition(),
+                                    &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+      ESP_LOGI(TAG, "New firmware confirmed");
+      (void)esp_ota_mark_app_valid_cancel_rollback();
+    }
+  }
+
+private:
+  static constexpr const char *TAG = "Ota";
+
+  /// Feeds image bytes to flash and to the hash
+  class ImageWriter final : public core::BodyStream {
+  public:
+    explicit ImageWriter(OtaUpdater &owner) : owner_(owner) {}
+
+    [[nodiscard]] bool write(std::span<const uint8_t> data) override {
+      if (owner_.written_ + data.size() > owner_.image_limit_) {
+        owner_.sink_error_ = ESP_ERR_INVALID_SIZE; // Not our image
+        return false;
+      }
+      if (esp_err_t err =
+              esp_ota_write(owner_.handle_, data.data(), data.size());
+          err != ESP_OK) {
+        owner_.sink_error_ = err;
+        return false;
+      }
+      (void)mbedtls_sha256_update(&owner_.sha_, data.data(), data.size());
+      owner_.written_ += data.size();
+      return true;
+    }
+
+  private:
+    OtaUpdater &owner_;
+  };
+
+  /// Counts downloaded bytes (the resume offset) on the way to the image
+  class DownloadCounter final : public core::BodyStream {
+  public:
+    DownloadCounter(OtaUpdater &owner, core::BodyStream &next)
+        : owner_(owner), next_(next) {}
+
+    [[nodiscard]] bool write(std::span<const uint8_t> data) override {
+      if (!next_.write(data)) {
+        return false;
+      }
+      owner_.received_ += data.size();
+      return true;
+    }
+
+  private:
+    OtaUpdater &owner_;
+    core::BodyStream &next_;
+  };
+
+  void run() {
+    auto status = update();
+    if (!status) {
+      abort_image();
+      ESP_LOGE(TAG, "Update failed after %zu of %zu bytes: %s",
+               received_.load(), size_, esp_err_to_name(status.error()));
+    }
+    state_ = status ? OtaState::Ready : OtaState::Failed;
+    if (on_done_) {
+      on_done_(status);
+    }
+  }
+
+  [[nodiscard]] core::Status update() {
+    const esp_partition_t *partition =
+        esp_ota_get_next_update_partition(nullptr);
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    if (partition == nullptr || running == nullptr) {
+      return core::Err(ESP_ERR_NOT_FOUND);
+    }
+    // A patch is smaller than its image; the patcher checks the target
+    image_limit_ = delta_ ? partition->size : size_;
+    if (size_ > partition->size) {
+      ESP_LOGE(TAG, "Image of %zu bytes exceeds the %lu byte slot", size_,
+               static_cast<unsigned long>(partition->size));
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    ImageWriter image(*this);
+    DeltaPatcher patcher(image, running,
+                         std::span<const uint8_t, ota_delta::BASE_ID_SIZE>(
+                             esp_app_get_description()->app_elf_sha256,
+                             ota_delta::BASE_ID_SIZE),
+                         partition->size);
+    DownloadCounter sink(*this,
+                         delta_ ? static_cast<core::BodyStream &>(patcher)
+                                : image);
+    if (auto status = begin_image(partition, patcher); !status) {
+      return status;
+    }
+
+    // Own connection, no Authorization: the device token stays with the
+    // backend and never reaches the storage host
+    core::HttpClientConfig config{};
+    config.base_url = {url_.data(), url_len_};
+    config.buffer_size_tx = 1024; // Only request headers go out
+    core::HttpClient<ota::ERROR_BODY_SIZE, ota::URL_SIZE, 1> client(config);
+    if (!client.valid()) {
+      return core::Err(ESP_FAIL);
+    }
+
+    ESP_LOGI(TAG, "Downloading %zu byte %s to %s", size_,
+             delta_ ? "patch" : "image", partition->label);
+    uint8_t stalled = 0;
+    auto delay = ota::RETRY_DELAY;
+    while (received_ < size_) {
+      size_t before = received_;
+      auto response = client.download("", received_, sink, chunk_);
+
+      if (sink_error_ != ESP_OK || patcher.error() != ESP_OK) {
+        return core::Err(sink_error_ != ESP_OK ? sink_error_
+                                               : patcher.error());
+      }
+      if (response && response->is_success() && before > 0 &&
+          response->status_code != PARTIAL_CONTENT) {
+        // Range ignored: the body would start at byte 0 again
+        ESP_LOGW(TAG, "Server can't resume, restarting the image");
+        if (auto status = begin_image(partition, patcher); !status) {
+          return status;
+        }
+        if (++stalled >= ota::MAX_STALLED_ATTEMPTS) {
+          return core::Err(ESP_ERR_NOT_SUPPORTED);
+        }
+        continue;
+      }
+      if (response && response->is_client_error()) {
+        ESP_LOGE(TAG, "Image unavailable: %d", response->status_code);
+        return core::Err(ESP_ERR_NOT_FOUND);
+      }
+      if (response && response->is_success() && received_ != size_) {
+        return core::Err(ESP_ERR_INVALID_SIZE); // Complete body, short file
+      }
+      if (received_ >= size_) {
+        break;
+      }
+
+      // Dropped link or server error: wait, then resume where it stopped
+      if (received_ > before) {
+        stalled = 0;
+        delay = ota::RETRY_DELAY;
+      } else if (++stalled >= ota::MAX_STALLED_ATTEMPTS) {
+        return core::Err(ESP_ERR_TIMEOUT);
+      }
+      ESP_LOGW(TAG, "Download paused at %zu/%zu, retry in %llds",
+               received_.load(), size_,
+               static_cast<long long>(delay.count()));
+      core::Task::delay(delay);
+      delay = std::min(delay * 2, ota::MAX_RETRY_DELAY);
+    }
+
+    if (delta_ && !patcher.done()) {
+      ESP_LOGE(TAG, "Patch ended at %zu of %zu image bytes",
+               patcher.produced(), patcher.target_size());
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    std::array<uint8_t, ota::SHA256_SIZE> digest{};
+    (void)mbedtls_sha256_finish(&sha_, digest.data());
+    if (digest != expected_sha256_) {
+      ESP_LOGE(TAG, "Image hash mismatch");
+      return core::Fail(ESP_ERR_INVALID_CRC);
+    }
+
+    esp_err_t err = esp_ota_end(handle_);
+    handle_ = 0; // esp_ota_end() frees it even on failure
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "Image rejected: %s", esp_err_to_name(err));
+      return core::Fail(err);
+    }
+    if (err = esp_ota_set_boot_partition(partition); err != ESP_OK) {
+      return core::Fail(err);
+    }
+    ESP_LOGI(TAG, "Update ready in %s (%zu bytes downloaded)",
+             partition->label, received_.load());
+    return core::Ok();
+  }
+
+  /// (Re)start writing the slot from byte 0
+  [[nodiscard]] core::Status begin_image(const esp_partition_t *partition,
+                                         DeltaPatcher &patcher) {
+    abort_image();
+    // Sequential writes erase sector by sector instead of ~1.5 MB up front
+    esp_err_t err =
+        esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &handle_);
+    if (err != ESP_OK) {
+      handle_ = 0;
+      return core::Fail(err);
+    }
+    (void)mbedtls_sha256_starts(&sha_, 0);
+    patcher.reset();
+    written_ = 0;
+    received_ = 0;
+    sink_error_ = ESP_OK;
+    return core::Ok();
+  }
+
+  void abort_image() {
+    if (handle_ != 0) {
+      (void)esp_ota_abort(handle_);
+      handle_ = 0;
+    }
+  }
+
+  static constexpr int PARTIAL_CONTENT = 206;
+
+  core::Worker worker_{{.name = "ota",
+                        .stack_size = ota::TASK_STACK,
+                        .priority = 4}};
+  std::atomic<OtaState> state_{OtaState::Idle};
+  DoneFn on_done_;
+
+  std::array<char, ota::URL_SIZE> url_{};
+  size_t url_len_{0};
+  size_t size_{0};
+  std::array<uint8_t, ota::SHA256_SIZE> expected_sha256_{};
+
+  bool delta_{false};
+
+  // Survive a dropped connection: the next attempt resumes from received_
+  esp_ota_handle_t handle_{0};
+  mbedtls_sha256_context sha_{};
+  std::atomic<size_t> received_{0}; ///< Image or patch bytes downloaded
+  size_t written_{0};               ///< Image bytes flashed
+  size_t image_limit_{0};
+  esp_err_t sink_error_{ESP_OK};
+  std::array<uint8_t, ota::CHUNK_SIZE> chunk_{};
+};
+
+} // namespace cloud
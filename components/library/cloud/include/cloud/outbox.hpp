@@ -0,0 +1,198 @@
+/**
+ * @file outbox.hpp
+ * @brief Prioritized outgoing message queue (immediate vs batched)
+ *
+ * Two lanes in front of TelemetryService:
+ * - Immediate: alerts and command acks that could not be delivered. They
+ *   go out on the next service pass that finds the cloud reachable.
+ * - Batched: routine telemetry. Held until batch_threshold measurements
+ *   are queued or the oldest has waited batch_window, then uploaded
+ *   together in one streamed request - one radio wakeup instead of many.
+ *
+ * The outbox only stores and decides; CloudManager::service_outbox() does
+ * the sending. Everything is fixed-size; a full lane rejects new entries
+ * so the caller can keep them elsewhere (history ring, TelemetryLog).
+ */
+
+#pragma once
+
+#include "command.hpp"
+
+#include <core/mutex.hpp>
+#include <sensor/measurement.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace cloud {
+
+/// Delivery priority of outgoing data
+enum class Priority : uint8_t {
+  Immediate, // Alerts, acks: send as soon as a link exists
+  Batched,   // Routine telemetry: coalesce into few uploads
+};
+
+/// Batching thresholds
+struct OutboxConfig {
+  size_t batch_threshold{256};             // Measurements that trigger a flush
+  std::chrono::seconds batch_window{120};  // Longest wait for the oldest entry
+};
+
+/// Fixed-capacity two-lane outbox
+///
+/// @tparam BatchCapacity Routine measurements held at most
+/// @tparam AlertCapacity Immediate measurements held at most
+/// @tparam AckCapacity Deferred command acks held at most
+/// @thread_safety Thread-safe (command acks are deferred from the timer task)
+template <size_t BatchCapacity, size_t AlertCapacity = 32,
+          size_t AckCapacity = MAX_COMMANDS>
+class Outbox {
+public:
+  explicit Outbox(const OutboxConfig &config = {}) : config_(config) {}
+
+  /// Queue a sample (all of it or nothing)
+  /// @param now_ms Monotonic time, starts the batch window of an empty lane
+  /// @return false if the lane has no room for it
+  [[nodiscard]] bool push(std::span<const sensor::Measurement> sample,
+                          Priority priority, int64_t now_ms) {
+    core::LockGuard lock(mutex_);
+    if (priority == Priority::Immediate) {
+      return append(alerts_, alert_count_, sample);
+    }
+    if (batch_count_ == 0) {
+      batch_started_ms_ = now_ms;
+    }
+    return append(batch_, batch_count_, sample);
+  }
+
+  /// Queue an ack that failed to send
+  [[nodiscard]] bool push_ack(std::string_view id, CommandResult result) {
+    core::LockGuard lock(mutex_);
+    if (ack_count_ == AckCapacity) {
+      return false;
+    }
+    auto &slot = acks_.at(ack_count_++);
+    slot.id.fill('\0');
+    std::copy_n(id.begin(), std::min(id.size(), slot.id.size() - 1),
+                slot.id.begin());
+    slot.result = result;
+    return true;
+  }
+
+  /// Oldest deferred acks, as many as fit out (copied so no lock is held)
+  void peek_acks(AckBatch &out) const {
+    core::LockGuard lock(mutex_);
+    out.clear();
+    for (size_t i = 0; i < ack_count_ && !out.full(); ++i) {
+      (void)out.push(acks_.at(i).id_view(), acks_.at(i).result);
+    }
+  }
+
+  /// Drop the n oldest deferred acks
+  void pop_acks(size_t n) {
+    core::LockGuard lock(mutex_);
+    n = std::min(n, ack_count_);
+    std::move(acks_.begin() + n, acks_.begin() + ack_count_, acks_.begin());
+    ack_count_ -= n;
+  }
+
+  /// Anything in the immediate lane
+  [[nodiscard]] bool has_immediate() const {
+    core::LockGuard lock(mutex_);
+    return alert_count_ != 0 || ack_count_ != 0;
+  }
+
+  /// Change the batching thresholds (queued entries stay; the new window
+  /// counts from when the oldest of them was queued)
+  void set_config(const OutboxConfig &config) {
+    core::LockGuard lock(mutex_);
+    config_ = config;
+  }
+
+  /// Routine lane reached its size or age threshold
+  [[nodiscard]] bool batch_due(int64_t now_ms) const {
+    core::LockGuard lock(mutex_);
+    if (batch_count_ == 0) {
+      return false;
+    }
+    auto window_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            config_.batch_window)
+            .count();
+    return batch_count_ >= std::min(config_.batch_threshold, BatchCapacity) ||
+           now_ms - batch_started_ms_ >= window_ms;
+  }
+
+  /// Measurements queued in a lane
+  [[nodiscard]] size_t size(Priority priority) const {
+    core::LockGuard lock(mutex_);
+    return priority == Priority::Immediate ? alert_count_ : batch_count_;
+  }
+
+  /// Visit a lane's measurements in order
+  /// @param fn `bool(const sensor::Measurement &)`; false stops
+  /// @return Measurements visited
+  /// @note Entries are only removed by consume() on the sending task, so
+  ///       the walk runs unlocked while pushes append behind the count
+  template <typename Fn> size_t for_each(Priority priority, Fn &&fn) const {
+    size_t count = size(priority);
+    const auto *lane =
+        priority == Priority::Immediate ? alerts_.data() : batch_.data();
+    for (size_t i = 0; i < count; ++i) {
+      if (!fn(lane[i])) {
+        return i;
+      }
+    }
+    return count;
+  }
+
+  /// Drop the first n measurements of a lane (after they were sent)
+  /// @param now_ms Restarts the batch window for entries left behind
+  void consume(Priority priority, size_t n, int64_t now_ms) {
+    core::LockGuard lock(mutex_);
+    if (priority == Priority::Immediate) {
+      remove_front(alerts_, alert_count_, n);
+    } else {
+      remove_front(batch_, batch_count_, n);
+      batch_started_ms_ = now_ms;
+    }
+  }
+
+private:
+  template <size_t N>
+  [[nodiscard]] static bool append(std::array<sensor::Measurement, N> &lane,
+                                   size_t &count,
+                                   std::span<const sensor::Measurement> sample) {
+    if (sample.size() > N - count) {
+      return false;
+    }
+    std::ranges::copy(sample, lane.begin() + static_cast<ptrdiff_t>(count));
+    count += sample.size();
+    return true;
+  }
+
+  template <size_t N>
+  static void remove_front(std::array<sensor::Measurement, N> &lane,
+                           size_t &count, size_t n) {
+    n = std::min(n, count);
+    std::move(lane.begin() + static_cast<ptrdiff_t>(n),
+              lane.begin() + static_cast<ptrdiff_t>(count), lane.begin());
+    count -= n;
+  }
+
+  OutboxConfig config_;
+  std::array<sensor::Measurement, BatchCapacity> batch_{};
+  std::array<sensor::Measurement, AlertCapacity> alerts_{};
+  std::array<AckBatch::Entry, AckCapacity> acks_{};
+  size_t batch_count_{0};
+  size_t alert_count_{0};
+  size_t ack_count_{0};
+  int64_t batch_started_ms_{0};
+  mutable core::Mutex mutex_;
+};
+
+} // namespace cloud
@@ -0,0 +1,58 @@
+/**
+ * @file payload_compressor.hpp
+ * @brief Optional deflate stage between serialization and upload
+ *
+ * Compresses a serialized body into a scratch buffer and hands back
+ * whichever form is smaller, together with the Content-Encoding to send.
+ * Bodies that are too small to gain, or that don't shrink, go out raw -
+ * the backend never has to deal with an expanded payload.
+ */
+
+#pragma once
+
+#include <core/deflate.hpp>
+#include <transport/transport.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace cloud {
+
+/// Body ready for upload
+struct EncodedPayload {
+  std::span<const uint8_t> data;
+  transport::ContentEncoding encoding{transport::ContentEncoding::Identity};
+};
+
+/// Deflate compressor with its own output buffer
+/// @tparam BufferSize Largest compressed body (larger bodies are sent raw)
+template <size_t BufferSize> class PayloadCompressor {
+public:
+  /// Bodies below this are not worth the zlib header/trailer (6 bytes)
+  static constexpr size_t MIN_COMPRESS_SIZE = 64;
+
+  /// Compressed body if it is smaller, otherwise body itself
+  /// @note The returned span refers to the internal buffer until next call
+  [[nodiscard]] EncodedPayload apply(std::span<const uint8_t> body) {
+    if (body.size() < MIN_COMPRESS_SIZE) {
+      return {.data = body};
+    }
+
+    size_t compressed = deflate_.compress(body, buffer_);
+    if (compressed == 0 || compressed >= body.size()) {
+      return {.data = body};
+    }
+
+    return {
+        .data = std::span<const uint8_t>(buffer_.data(), compressed),
+        .encoding = transport::ContentEncoding::Deflate,
+    };
+  }
+
+private:
+  core::DeflateCompressor deflate_;
+  std::array<uint8_t, BufferSize> buffer_{};
+};
+
+} // namespace cloud
@@ -0,0 +1,155 @@
+/**
+ * @file rtc_sample_buffer.hpp
+ * @brief Telemetry batched in RTC memory across deep-sleep wakes
+ *
+ * A duty-cycled probe that uploads once an hour wakes a dozen times in
+ * between. Moving every wake's sample through the flash TelemetryLog
+ * costs a LittleFS write (and its erase share) per wake; this buffer
+ * keeps them in RTC memory instead, packed to 8 bytes per measurement
+ * (sensor::PackedMeasurement) with a CRC over the whole buffer.
+ *
+ * The wake that transmits spills the buffer into the TelemetryLog and
+ * uploads from there, so acks work as for any other backlog. A sample
+ * that no longer fits spills the buffer early (a mesh leaf, which never
+ * uploads the log, drops the oldest sample instead). Contents are lost with
+ * RTC memory (reset, power loss) and a buffer that fails its CRC reads
+ * as empty - at most one upload interval of samples.
+ *
+ *   RTC_DATA_ATTR cloud::RtcSampleBuffer<192> g_samples;
+ *
+ *   if (!g_samples.append(sample)) {
+ *     (void)g_samples.spill(log);
+ *     (void)g_samples.append(sample);
+ *   }
+ */
+
+#pragma once
+
+#include "telemetry_log.hpp"
+
+#include <core/crc.hpp>
+#include <core/result.hpp>
+#include <sensor/packed_measurement.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace cloud {
+
+/// Samples kept in RTC memory between wakes
+/// @tparam Capacity Measurements held (8 bytes each; RTC memory is ~8 KB)
+template <size_t Capacity> class RtcSampleBuffer {
+  static_assert(Capacity > 0 && Capacity <= UINT16_MAX);
+
+public:
+  /// Measurements held (0 if the CRC doesn't match)
+  [[nodiscard]] size_t size() const { return is_valid() ? count_ : 0; }
+  [[nodiscard]] bool empty() const { return size() == 0; }
+  [[nodiscard]] static constexpr size_t capacity() { return Capacity; }
+
+  /// The packed samples, oldest first (empty if the CRC doesn't match)
+  [[nodiscard]] std::span<const sensor::PackedMeasurement> records() const {
+    return {records_.data(), size()};
+  }
+
+  /// Add one sample (as produced by DataManager::drain_each)
+  ///
+  /// TimeDelta markers are stored as absolute Timestamps, so the samples
+  /// of different wakes line up. Values without a packed form (double)
+  /// are dropped.
+  /// @return false if the sample doesn't fit (buffer unchanged)
+  [[nodiscard]] bool append(std::span<const sensor::Measurement> sample) {
+    if (!is_valid()) {
+      count_ = 0;
+      last_timestamp_ms_ = 0;
+    }
+    if (sample.size() > Capacity - count_) {
+      return false;
+    }
+    uint64_t timestamp_ms = last_timestamp_ms_;
+    for (const auto &m : sample) {
+      auto stored = m;
+      if (m.id == sensor::MeasurementId::Timestamp) {
+        timestamp_ms = m.to<uint64_t>();
+      } else if (m.id == sensor::MeasurementId::TimeDelta) {
+        timestamp_ms += m.to<uint64_t>();
+        stored = sensor::make<sensor::MeasurementId::Timestamp>(timestamp_ms);
+      }
+      if (auto packed = sensor::PackedMeasurement::from(stored)) {
+        records_.at(count_++) = *packed;
+      }
+    }
+    last_timestamp_ms_ = timestamp_ms;
+    seal();
+    return true;
+  }
+
+  /// Move everything into the flash log (flushed) and clear
+  /// @return The log's error; the buffer is kept then, a retry may
+  ///         queue a sample twice but loses none
+  [[nodiscard]] core::Status spill(TelemetryLog &log) {
+    for (size_t i = 0; i < size(); ++i) {
+      auto m = records_.at(i).unpack();
+      if (auto status = log.append(std::span(&m, 1)); !status) {
+        return status;
+      }
+    }
+    if (auto status = log.flush(); !status) {
+      return status;
+    }
+    clear();
+    return core::Ok();
+  }
+
+  /// Drop the oldest sample (a mesh leaf makes room this way: it has no
+  /// flash log that would ever be uploaded)
+  /// @return false if the buffer was empty
+  bool drop_oldest() {
+    size_t held = size();
+    if (held == 0) {
+      return false;
+    }
+    size_t next = 1;
+    while (next < held &&
+           records_.at(next).id != sensor::MeasurementId::Timestamp) {
+      ++next;
+    }
+    std::copy(records_.begin() + next, records_.begin() + held,
+              records_.begin());
+    count_ = static_cast<uint16_t>(held - next);
+    seal();
+    return true;
+  }
+
+  /// Drop the samples (the time base stays for the next TimeDelta)
+  void clear() {
+    count_ = 0;
+    seal();
+  }
+
+private:
+  [[nodiscard]] uint32_t compute_crc() const {
+    core::Crc32 crc;
+    crc.update(count_);
+    crc.update(last_timestamp_ms_);
+    crc.update(std::span(reinterpret_cast<const uint8_t *>(records_.data()),
+                         count_ * sizeof(sensor::PackedMeasurement)));
+    return crc.value();
+  }
+
+  [[nodiscard]] bool is_valid() const {
+    return count_ <= Capacity && crc_ == compute_crc();
+  }
+
+  void seal() { crc_ = compute_crc(); }
+
+  uint32_t crc_{0};
+  uint16_t count_{0};
+  uint64_t last_timestamp_ms_{0}; ///< Base for TimeDelta markers
+  std::array<sensor::PackedMeasurement, Capacity> records_{};
+};
+
+} // namespace cloud
@@ -0,0 +1,202 @@
+/**
+ * @file telemetry_log.hpp
+ * @brief Store-and-forward queue for telemetry while the cloud is offline
+ *
+ * Measurements that can't be uploaded go into a core::RecordLog on the
+ * LittleFS `storage` partition (sector-aligned appends, CRC per record)
+ * and are replayed in large batches once the cloud is authenticated again.
+ * Records are only consumed after the upload that carried them succeeded,
+ * so a failed drain is retried from the same spot.
+ *
+ * Sizing: 16-byte records, 256 per sector; 20 segments of 8 sectors
+ * (640 KB of the 896 KB partition) hold ~40k measurements.
+ */
+
+#pragma once
+
+#include "telemetry_service.hpp"
+
+#include <core/record_log.hpp>
+#include <core/result.hpp>
+#include <sensor/measurement.hpp>
+
+#include <esp_log.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <variant>
+
+namespace cloud {
+
+/// Measurement as stored on flash (value bits + variant alternative)
+struct StoredMeasurement {
+  std::array<uint8_t, 8> bits;
+  uint8_t id;
+  uint8_t type; // MeasurementValue alternative index
+  std::array<uint8_t, 2> reserved;
+};
+static_assert(sizeof(StoredMeasurement) == 12);
+
+namespace detail {
+
+template <size_t I = 0>
+[[nodiscard]] std::optional<sensor::MeasurementValue>
+value_from_bits(size_t index, const std::array<uint8_t, 8> &bits) {
+  if constexpr (I < std::variant_size_v<sensor::MeasurementValue>) {
+    if (index == I) {
+      std::variant_alternative_t<I, sensor::MeasurementValue> value{};
+      std::memcpy(&value, bits.data(), sizeof(value));
+      return sensor::MeasurementValue{std::in_place_index<I>, value};
+    }
+    return value_from_bits<I + 1>(index, bits);
+  } else {
+    return std::nullopt;
+  }
+}
+
+} // namespace detail
+
+[[nodiscard]] inline StoredMeasurement to_stored(const sensor::Measurement &m) {
+  StoredMeasurement stored{
+      .bits = {},
+      .id = static_cast<uint8_t>(m.id),
+      .type = static_cast<uint8_t>(m.value.index()),
+      .reserved = {},
+  };
+  m.visit([&stored](auto v) { std::memcpy(stored.bits.data(), &v, sizeof(v)); });
+  return stored;
+}
+
+/// Decode a stored measurement (nullopt for an unknown id or type)
+[[nodiscard]] inline std::optional<sensor::Measurement>
+from_stored(const StoredMeasurement &stored) {
+  if (stored.id == 0 ||
+      stored.id >= static_cast<uint8_t>(sensor::MeasurementId::Count)) {
+    return std::nullopt;
+  }
+  auto value = detail::value_from_bits(stored.type, stored.bits);
+  if (!value) {
+    return std::nullopt;
+  }
+  sensor::Measurement m;
+  m.id = static_cast<sensor::MeasurementId>(stored.id);
+  m.value = *value;
+  return m;
+}
+
+/// Offline telemetry queue
+///
+/// @thread_safety Not thread-safe. Call from main task only.
+class TelemetryLog {
+public:
+  /// Measurements per replayed upload (rounded up to a whole sample)
+  static constexpr size_t DRAIN_BATCH = 2048;
+  /// Hard cap on records read for one upload
+  static constexpr size_t MAX_BATCH = 2 * DRAIN_BATCH;
+
+  static constexpr core::RecordLogConfig DEFAULT_CONFIG{
+      .name = "telemetry_log",
+      .segment_sectors = 8,
+      .max_segments = 20,
+  };
+
+  explicit TelemetryLog(const core::RecordLogConfig &config = DEFAULT_CONFIG)
+      : log_(config) {}
+
+  /// Open the log (after storage is mounted)
+  [[nodiscard]] core::Status init() { return log_.init(); }
+
+  [[nodiscard]] bool is_ready() const { return log_.is_ready(); }
+  [[nodiscard]] bool empty() const { return log_.empty(); }
+  [[nodiscard]] size_t pending() const { return log_.pending(); }
+
+  /// Queue one sample (as produced by DataManager::drain_each)
+  ///
+  /// TimeDelta entries are stored as absolute Timestamps, so every stored
+  /// sample carries its own time and replay may start at any sample.
+  [[nodiscard]] core::Status
+  append(std::span<const sensor::Measurement> sample) {
+    for (const auto &m : sample) {
+      auto stored = m;
+      if (m.id == sensor::MeasurementId::Timestamp) {
+        last_timestamp_ms_ = m.to<uint64_t>();
+      } else if (m.id == sensor::MeasurementId::TimeDelta) {
+        last_timestamp_ms_ += m.to<uint64_t>();
+        stored =
+            sensor::make<sensor::MeasurementId::Timestamp>(last_timestamp_ms_);
+      }
+      if (auto status = log_.append(to_stored(stored)); !status) {
+        return status;
+      }
+    }
+    return core::Ok();
+  }
+
+  /// Push buffered records to flash (e.g. before a reset)
+  [[nodiscard]] core::Status flush() { return log_.flush(); }
+
+  /// Replay the backlog, oldest first, in DRAIN_BATCH uploads
+  ///
+  /// @param upload Callable `TelemetryResult(Source)` streaming a
+  ///        measurement source (e.g. CloudManager::stream_telemetry)
+  /// @param max_batches Upper bound on uploads this call
+  /// @return Uploads that succeeded; stops at the first failure
+  template <typename Upload>
+  size_t drain(Upload &&upload, size_t max_batches = SIZE_MAX) {
+    if (!log_.is_ready() || !log_.flush()) {
+      return 0;
+    }
+
+    size_t batches = 0;
+    while (batches < max_batches && !log_.empty()) {
+      size_t slots = 0;
+      bool read_ok = true;
+      auto result = upload([this, &slots, &read_ok](auto &&emit) {
+        size_t count = 0;
+        // Batches end before a Timestamp so no sample is split
+        auto read = log_.read(MAX_BATCH, [&](const StoredMeasurement &s) {
+          auto m = from_stored(s);
+          if (!m) {
+            return true; // Skip undecodable records
+          }
+          if (count >= DRAIN_BATCH &&
+              m->id == sensor::MeasurementId::Timestamp) {
+            return false;
+          }
+          ++count;
+          return emit(*m);
+        });
+        read_ok = read.has_value();
+        slots = read.value_or(0);
+      });
+
+      if (!result.success || !read_ok || slots == 0) {
+        ESP_LOGW(TAG, "Backlog upload stopped, ~%zu pending", log_.pending());
+        break;
+      }
+      if (auto status = log_.consume(slots); !status) {
+        ESP_LOGW(TAG, "Cursor update failed: %s",
+                 esp_err_to_name(status.error()));
+        break;
+      }
+      ++batches;
+    }
+
+    if (batches != 0) {
+      ESP_LOGI(TAG, "Replayed %zu backlog batch(es), ~%zu pending", batches,
+               log_.pending());
+    }
+    return batches;
+  }
+
+private:
+  static constexpr const char *TAG = "TelemetryLog";
+
+  core::RecordLog<StoredMeasurement> log_;
+  uint64_t last_timestamp_ms_{0}; ///< Base for TimeDelta entries
+};
+
+} // namespace cloud
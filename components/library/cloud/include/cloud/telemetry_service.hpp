@@ -4,15 +4,38 @@
  *
  * Handles serialization and upload of sensor data.
  * Decoupled from CloudClient via dependency injection.
+ *
+ * Uploads that exceed one serialized frame (e.g. the 32-entry
+ * MeasurementBatch) are split into consecutive frames and sent as one
+ * length-delimited body (ProtobufDelimited): each frame is prefixed with
+ * its size as a varint, the same framing as protobuf writeDelimitedTo().
+ * Frames are parts of one logical batch, so time markers carry over from
+ * one frame to the next. One request, one TLS session - radio time grows
+ * with the payload, not with the number of frames.
+ *
+ * send() and send_stream() with a CommandBuffer ask the backend to return
+ * pending commands in the telemetry response (`?commands=pending`), so upload and command
+ * poll share one round trip.
  */
 
 #pragma once
 
 #include "cloud_client.hpp"
+#include "command_service.hpp"
 #include "endpoints.hpp"
+#include "payload_compressor.hpp"
+
+#include <core/body_stream.hpp>
+#include <core/metrics.hpp>
+#include <core/url.hpp>
 
+#include <esp_log.h>
+
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <span>
+#include <string_view>
 
 namespace cloud {
 
@@ -27,6 +50,9 @@ template <typename T> struct ISerializer {
 
   virtual size_t serialize(std::span<const T> items,
                            std::span<uint8_t> buffer) = 0;
+
+  /// Largest number of items one serialize() call encodes
+  [[nodiscard]] virtual size_t max_items() const { return SIZE_MAX; }
 };
 
 /// Result of telemetry upload
@@ -44,20 +70,124 @@ public:
       : client_(client), serializer_(serializer) {}
 
   /// Upload measurements
+  /// More than serializer max_items() are sent as several frames in one
+  /// request (see send_frames())
   [[nodiscard]] TelemetryResult send(std::span<const T> measurements) {
     if (measurements.empty()) {
       return {.success = true};
     }
+    return to_result(upload(measurements, {}));
+  }
+
+  /// Upload measurements and collect the pending commands the backend
+  /// returns with the response (no separate command poll)
+  /// @param commands Cleared, then filled from the response body
+  [[nodiscard]] TelemetryResult send(std::span<const T> measurements,
+                                     CommandBuffer &commands) {
+    commands.clear();
+    if (measurements.empty()) {
+      return {.success = true};
+    }
+
+    auto response = upload(measurements, COMMANDS_QUERY);
+    if (response.success &&
+        !CommandService::parse(response, commands).success) {
+      // The upload itself went through; only the piggybacked part is lost
+      ESP_LOGW(TAG, "Unparseable commands in telemetry response");
+    }
+    return to_result(response);
+  }
+
+  /// Deflate serialized bodies before send() posts them (nullptr = off)
+  /// Streamed bodies (send_frames, send_stream) are always sent raw.
+  void set_compressor(PayloadCompressor<BufferSize> *compressor) {
+    compressor_ = compressor;
+  }
+
+  /// Upload any number of measurements as length-delimited frames in a
+  /// single streamed request body
+  [[nodiscard]] TelemetryResult send_frames(std::span<const T> measurements) {
+    return to_result(upload_frames(measurements, {}));
+  }
+
+  /// Upload a body encoded while it is sent (no intermediate buffer)
+  [[nodiscard]] TelemetryResult send_stream(core::IBodySource &body) {
+    return to_result(upload_stream(body, {}));
+  }
+
+  /// send_stream() that also collects the pending commands (see send())
+  /// @param commands Cleared, then filled from the response body
+  [[nodiscard]] TelemetryResult send_stream(core::IBodySource &body,
+                                            CommandBuffer &commands) {
+    commands.clear();
+    auto response = upload_stream(body, COMMANDS_QUERY);
+    if (response.success &&
+        !CommandService::parse(response, commands).success) {
+      ESP_LOGW(TAG, "Unparseable commands in telemetry response");
+    }
+    return to_result(response);
+  }
+
+private:
+  static constexpr const char *TAG = "Telemetry";
+
+  /// Upload path, encoded at compile time
+  static constexpr std::string_view PATH =
+      core::url::static_path<endpoints::TELEMETRY_PROTO>;
+
+  /// Asks the backend to answer with pending commands
+  static constexpr std::array<transport::QueryParam, 1> COMMANDS_QUERY{
+      {{.key = "commands", .value = "pending"}}};
+
+  /// Serialize (one frame or several) and POST; the response keeps its body
+  [[nodiscard]] ApiResponse
+  upload(std::span<const T> measurements,
+         std::span<const transport::QueryParam> params) {
+    if (measurements.size() > serializer_.max_items()) {
+      return upload_frames(measurements, params);
+    }
 
     size_t encoded = serializer_.serialize(measurements, buffer_);
     if (encoded == 0) {
       return {.error = CloudError::ParseError};
     }
 
-    auto response =
-        client_.post(endpoints::TELEMETRY_PROTO, {buffer_.data(), encoded},
-                     transport::ContentType::Protobuf);
+    EncodedPayload payload{.data = {buffer_.data(), encoded}};
+    if (compressor_ != nullptr) {
+      payload = compressor_->apply(payload.data);
+    }
+
+    core::metrics().telemetry_bytes.add(payload.data.size());
+    return client_.post(PATH, payload.data, transport::ContentType::Protobuf,
+                        payload.encoding, params);
+  }
+
+  [[nodiscard]] ApiResponse
+  upload_stream(core::IBodySource &body,
+                std::span<const transport::QueryParam> params) {
+    core::CountingSource counted(body);
+    auto response = client_.post_stream(
+        PATH, counted, transport::ContentType::Protobuf, params);
+    core::metrics().telemetry_bytes.add(counted.bytes());
+    return response;
+  }
+
+  [[nodiscard]] ApiResponse
+  upload_frames(std::span<const T> measurements,
+                std::span<const transport::QueryParam> params) {
+    FrameSource source(serializer_, buffer_, measurements);
+    core::CountingSource counted(source);
+    auto response = client_.post_stream(
+        PATH, counted, transport::ContentType::ProtobufDelimited, params);
+    core::metrics().telemetry_bytes.add(counted.bytes());
+
+    if (source.failed()) {
+      return {.error = CloudError::ParseError};
+    }
+    return response;
+  }
 
+  [[nodiscard]] static TelemetryResult to_result(const ApiResponse &response) {
     return {
         .success = response.success,
         .status_code = response.status_code,
@@ -65,9 +195,59 @@ public:
     };
   }
 
-private:
+  /// Serializes one frame at a time into the service buffer
+  class FrameSource final : public core::IBodySource {
+  public:
+    FrameSource(ISerializer<T> &serializer, std::span<uint8_t> buffer,
+                std::span<const T> items)
+        : serializer_(serializer), buffer_(buffer), items_(items) {}
+
+    [[nodiscard]] bool produce(core::BodyStream &out) override {
+      size_t per_frame = std::max<size_t>(serializer_.max_items(), 1);
+      for (size_t pos = 0; pos < items_.size(); pos += per_frame) {
+        auto frame = items_.subspan(pos, std::min(per_frame,
+                                                  items_.size() - pos));
+        size_t encoded = serializer_.serialize(frame, buffer_);
+        if (encoded == 0) {
+          failed_ = true;
+          return false;
+        }
+
+        std::array<uint8_t, MAX_VARINT_SIZE> prefix{};
+        size_t prefix_len = encode_varint(encoded, prefix);
+        if (!out.write(std::span(prefix.data(), prefix_len)) ||
+            !out.write(buffer_.first(encoded))) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    [[nodiscard]] bool failed() const { return failed_; }
+
+  private:
+    static constexpr size_t MAX_VARINT_SIZE = 10;
+
+    static size_t encode_varint(uint64_t value,
+                                std::span<uint8_t, MAX_VARINT_SIZE> out) {
+      size_t len = 0;
+      do {
+        auto byte = static_cast<uint8_t>(value & 0x7F);
+        value >>= 7;
+        out[len++] = value != 0 ? static_cast<uint8_t>(byte | 0x80) : byte;
+      } while (value != 0);
+      return len;
+    }
+
+    ISerializer<T> &serializer_;
+    std::span<uint8_t> buffer_;
+    std::span<const T> items_;
+    bool failed_{false};
+  };
+
   CloudClient &client_;
   ISerializer<T> &serializer_;
+  PayloadCompressor<BufferSize> *compressor_{nullptr};
   std::array<uint8_t, BufferSize> buffer_{};
 };
 
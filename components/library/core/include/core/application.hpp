@@ -8,9 +8,13 @@
 #include "event_loop.hpp"
 #include "littlefs_storage.hpp"
 #include "nvs_storage.hpp"
+#include "rtc_backend.hpp"
 #include "storage_manager.hpp"
+#include "storage_worker.hpp"
+#include "wake_profile.hpp"
 
 #include <cassert>
+#include <chrono>
 
 namespace core {
 
@@ -26,6 +30,8 @@ public:
 
   /// Initialize and run the application
   [[nodiscard]] Status start() {
+    add_phase_time(WakePhase::Boot,
+                   static_cast<uint32_t>(esp_timer_get_time()));
     if (auto err = init_platform(); !err) {
       return err;
     }
@@ -41,10 +47,24 @@ public:
     return storage_manager_.open(ns);
   }
 
+  /// Access the background storage writer
+  [[nodiscard]] StorageWorker &storage_worker() { return storage_worker_; }
+
+  /// Drain queued writes and commit every namespace (before sleep/restart)
+  void flush_storage(std::chrono::milliseconds timeout = FLUSH_TIMEOUT) {
+    if (auto status = storage_worker_.flush_and_wait(timeout); !status) {
+      ESP_LOGW("Application", "Storage worker not drained: %s",
+               esp_err_to_name(status.error()));
+    }
+    storage_manager_.commit_all();
+  }
+
   /// Access event bus
   [[nodiscard]] static EventBus &events() { return EventBus::get(); }
 
 protected:
+  static constexpr std::chrono::milliseconds FLUSH_TIMEOUT{2000};
+
   Application() = default;
 
   /// Override to implement application logic
@@ -65,30 +85,40 @@ protected:
   }
 
   /// Override to provide storage configuration
-  /// Default: small data → NVS, large data → LittleFS
+  /// Default: small hot keys → NVS (cached), large blobs → LittleFS,
+  /// deep-sleep-only state → RTC memory
   [[nodiscard]] virtual StorageConfig get_storage_config() const {
     StorageConfig config{};
-    config.map(NamespaceId::App, BackendId::Nvs);
-    config.map(NamespaceId::Bsec, BackendId::Nvs);
-    config.map(NamespaceId::Wifi, BackendId::Nvs);
-    config.map(NamespaceId::Cloud, BackendId::Nvs);
-    config.map(NamespaceId::Measurements, BackendId::LittleFs);
+    config.route(NamespaceId::App, AccessPattern::Hot);
+    config.route(NamespaceId::Wifi, AccessPattern::Hot);
+    config.route(NamespaceId::Cloud, AccessPattern::Hot);
+    config.route(NamespaceId::Bsec, AccessPattern::Bulk);
+    config.route(NamespaceId::Measurements, AccessPattern::Bulk);
+    config.route(NamespaceId::Session, AccessPattern::Volatile);
+    config.cache.flush_interval = std::chrono::seconds(60);
     return config;
   }
 
   /// Initialize storage subsystem
   Status init_storage() {
+    ScopedPhase phase(WakePhase::Storage);
+
     // Add storage backends
     storage_manager_.add_backend(std::make_unique<NvsBackend>());
     storage_manager_.add_backend(std::make_unique<LittleFsBackend>());
+    storage_manager_.add_backend(std::make_unique<RtcBackend>());
 
     // Apply configuration
     storage_manager_.configure(get_storage_config());
 
-    return storage_manager_.init();
+    if (auto status = storage_manager_.init(); !status) {
+      return status;
+    }
+    return storage_worker_.start();
   }
 
   StorageManager storage_manager_; // NOLINT
+  StorageWorker storage_worker_;   // NOLINT
 };
 
 } // namespace core
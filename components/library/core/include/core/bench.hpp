@@ -0,0 +1,162 @@
+/**
+ * @file bench.hpp
+ * @brief On-target microbenchmarks in CPU cycles (CONFIG_CORE_BENCH)
+ *
+ * Kernels are plain functions registered by name; run_all() times every
+ * call with the CPU cycle counter and logs one line per kernel:
+ *
+ *   core::bench::registry().add("crc32/1k", 1000, [] -> size_t {
+ *     g_sink = core::Crc32::compute(g_block);
+ *     return g_block.size();
+ *   });
+ *   core::bench::registry().run_all();
+ *   // I bench: BENCH crc32/1k iters=1000 cyc_mean=2210 cyc_p99=2260
+ *   //          cyc_max=4810 ns_op=13812 bytes=1024 allocs=0
+ *
+ * Cycles are what the code costs as built (-Os, flash cache misses, IRAM
+ * placement), independent of the CPU clock; ns_op is the wall time at the
+ * clock the run had. The first call is an untimed warm-up, so cold flash
+ * cache shows up in cyc_max, not in the mean. Interrupts and higher
+ * priority tasks land in cyc_p99 and cyc_max.
+ *
+ * allocs needs CONFIG_HEAP_USE_HOOKS=y (counted in core.cpp), else -1.
+ */
+
+#pragma once
+
+#include <esp_cpu.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace core::bench {
+
+#ifdef CONFIG_CORE_BENCH
+inline constexpr bool kEnabled = true;
+#else
+inline constexpr bool kEnabled = false;
+#endif
+
+/// One operation of a kernel
+/// @return Bytes the operation produced or consumed (0 if meaningless)
+using KernelFn = size_t (*)();
+
+/// Heap allocations since boot, or -1 without CONFIG_HEAP_USE_HOOKS
+/// (defined in core.cpp)
+[[nodiscard]] int32_t alloc_count();
+
+/// Figures of one kernel run
+struct Stats {
+  const char *name = "";
+  uint32_t iterations = 0;
+  uint32_t mean_cycles = 0;
+  uint32_t p99_cycles = 0; ///< Of the first kMaxSamples iterations
+  uint32_t max_cycles = 0;
+  uint32_t ns_op = 0;
+  size_t bytes = 0;   ///< Of the last iteration
+  int32_t allocs = 0; ///< Per iteration, -1 if not counted
+};
+
+/// Registered kernels
+///
+/// @thread_safety Not thread-safe; register and run from one task.
+class Registry {
+public:
+  static constexpr size_t kMaxKernels = 24;
+  /// Iterations kept for the percentile (uint32_t each)
+  static constexpr size_t kMaxSamples = 256;
+
+  /// @return false if kMaxKernels are registered already
+  bool add(const char *name, uint32_t iterations, KernelFn fn) {
+    if (count_ == kernels_.size() || iterations == 0) {
+      return false;
+    }
+    kernels_.at(count_++) = {.name = name, .iterations = iterations, .fn = fn};
+    return true;
+  }
+
+  /// Time one kernel
+  [[nodiscard]] Stats run(const char *name, uint32_t iterations,
+                          KernelFn fn) {
+    Stats stats{.name = name, .iterations = iterations};
+    stats.bytes = fn();
+
+    int32_t allocs_before = alloc_count();
+    int64_t start_us = esp_timer_get_time();
+    uint64_t total_cycles = 0;
+    for (uint32_t i = 0; i < iterations; ++i) {
+      uint32_t start = esp_cpu_get_cycle_count();
+      stats.bytes = fn();
+      uint32_t cycles = esp_cpu_get_cycle_count() - start;
+      total_cycles += cycles;
+      stats.max_cycles = std::max(stats.max_cycles, cycles);
+      if (i < samples_.size()) {
+        samples_.at(i) = cycles;
+      }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    int32_t allocs_after = alloc_count();
+
+    stats.mean_cycles = static_cast<uint32_t>(total_cycles / iterations);
+    stats.ns_op = static_cast<uint32_t>(elapsed_us * 1000 / iterations);
+    stats.allocs =
+        allocs_before < 0
+            ? -1
+            : (allocs_after - allocs_before) / static_cast<int32_t>(iterations);
+
+    size_t kept = std::min<size_t>(iterations, samples_.size());
+    size_t rank = ((kept * 99) + 99) / 100 - 1;
+    auto begin = samples_.begin();
+    std::nth_element(begin, begin + rank, begin + kept);
+    stats.p99_cycles = samples_.at(rank);
+    return stats;
+  }
+
+  /// Run every kernel in registration order and log its line
+  void run_all() {
+    for (size_t i = 0; i < count_; ++i) {
+      const auto &kernel = kernels_.at(i);
+      log(run(kernel.name, kernel.iterations, kernel.fn));
+    }
+  }
+
+  /// The stable "BENCH" line a rig greps for
+  static void log(const Stats &stats) {
+    ESP_LOGI(TAG,
+             "BENCH %s iters=%lu cyc_mean=%lu cyc_p99=%lu cyc_max=%lu "
+             "ns_op=%lu bytes=%zu allocs=%ld",
+             stats.name, static_cast<unsigned long>(stats.iterations),
+             static_cast<unsigned long>(stats.mean_cycles),
+             static_cast<unsigned long>(stats.p99_cycles),
+             static_cast<unsigned long>(stats.max_cycles),
+             static_cast<unsigned long>(stats.ns_op), stats.bytes,
+             static_cast<long>(stats.allocs));
+  }
+
+  [[nodiscard]] size_t size() const { return count_; }
+
+private:
+  static constexpr const char *TAG = "bench";
+
+  struct Kernel {
+    const char *name = "";
+    uint32_t iterations = 0;
+    KernelFn fn = nullptr;
+  };
+
+  std::array<Kernel, kMaxKernels> kernels_{};
+  size_t count_ = 0;
+  std::array<uint32_t, kMaxSamples> samples_{};
+};
+
+/// The process-wide registry
+[[nodiscard]] inline Registry &registry() {
+  static Registry registry;
+  return registry;
+}
+
+} // namespace core::bench
@@ -0,0 +1,200 @@
+/**
+ * @file blob_partition.hpp
+ * @brief Read-only named blobs memory-mapped from a flash partition
+ *
+ * Certificates (PEM) and other large constant configuration live in a
+ * dedicated data partition instead of NVS or the application image. The
+ * partition is mapped into the flash cache once with esp_partition_mmap;
+ * lookups return views that point straight into flash, so a cert chain
+ * handed to esp_http_client / esp-mqtt costs no DRAM copy.
+ *
+ * Image layout (little-endian, written by tools/provision):
+ *   ImageHeader  magic "BLOB", version, entry count, image size, CRC
+ *   Entry[count] NUL-padded name, offset from image start, size
+ *   data         each blob followed by one NUL byte
+ * The CRC (Crc32, default seed) covers everything after the header and is
+ * checked once in open().
+ *
+ * Usage:
+ *   BlobPartition certs;
+ *   if (certs.open()) {
+ *     http_config.ca_cert = certs.text("ca_cert");
+ *   }
+ *
+ * @note Views stay valid while the partition is open. Flash cache is off
+ *       during flash writes, so don't read them from ISRs.
+ */
+
+#pragma once
+
+#include "crc.hpp"
+#include "result.hpp"
+
+#include <esp_log.h>
+#include <esp_partition.h>
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+namespace core {
+
+namespace blob {
+inline constexpr uint32_t MAGIC = 0x424F4C42; // "BLOB"
+inline constexpr uint16_t VERSION = 1;
+inline constexpr size_t NAME_LEN = 16; ///< Including the NUL
+inline constexpr size_t MAX_ENTRIES = 32;
+inline constexpr const char *DEFAULT_LABEL = "certs";
+
+struct ImageHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+  uint32_t size; ///< Whole image, header included
+  uint32_t crc;  ///< Over bytes [sizeof(ImageHeader), size)
+};
+static_assert(sizeof(ImageHeader) == 16);
+
+struct Entry {
+  char name[NAME_LEN];
+  uint32_t offset; ///< From image start
+  uint32_t size;   ///< Excluding the trailing NUL
+};
+static_assert(sizeof(Entry) == 24);
+} // namespace blob
+
+/// Memory-mapped, read-only blob partition
+///
+/// @thread_safety Lookups are thread-safe once open; open()/close() are not.
+class BlobPartition {
+public:
+  BlobPartition() = default;
+  ~BlobPartition() { close(); }
+
+  BlobPartition(const BlobPartition &) = delete;
+  BlobPartition &operator=(const BlobPartition &) = delete;
+  BlobPartition(BlobPartition &&) = delete;
+  BlobPartition &operator=(BlobPartition &&) = delete;
+
+  /// Validate and map the image
+  /// @param label Partition label (NUL-terminated)
+  /// @return ESP_ERR_NOT_FOUND if there is no partition or no image in it,
+  ///         ESP_ERR_INVALID_CRC / _VERSION / _SIZE for a bad image
+  [[nodiscard]] Status open(const char *label = blob::DEFAULT_LABEL) {
+    close();
+
+    const auto *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+
+    blob::ImageHeader header{};
+    if (auto err = esp_partition_read(partition, 0, &header, sizeof(header));
+        err != ESP_OK) {
+      return Err(err);
+    }
+    if (header.magic != blob::MAGIC) {
+      return Err(ESP_ERR_NOT_FOUND); // Erased or never written
+    }
+    if (header.version != blob::VERSION) {
+      ESP_LOGW(TAG, "%s: image version %u, expected %u", label,
+               header.version, blob::VERSION);
+      return Err(ESP_ERR_INVALID_VERSION);
+    }
+    size_t toc_end = sizeof(header) + (header.count * sizeof(blob::Entry));
+    if (header.count > blob::MAX_ENTRIES || header.size < toc_end ||
+        header.size > partition->size) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    const void *mapped = nullptr;
+    if (auto err =
+            esp_partition_mmap(partition, 0, header.size,
+                               ESP_PARTITION_MMAP_DATA, &mapped, &handle_);
+        err != ESP_OK) {
+      ESP_LOGE(TAG, "%s: mmap failed: %s", label, esp_err_to_name(err));
+      return Err(err);
+    }
+    image_ = {static_cast<const uint8_t *>(mapped), header.size};
+    mapped_ = true;
+
+    if (auto status = validate(header, toc_end); !status) {
+      ESP_LOGE(TAG, "%s: invalid image: %s", label,
+               esp_err_to_name(status.error()));
+      close();
+      return status;
+    }
+
+    entries_ = {reinterpret_cast<const blob::Entry *>(image_.data() +
+                                                      sizeof(header)),
+                header.count};
+    ESP_LOGI(TAG, "%s: %u blob(s), %u bytes mapped", label, header.count,
+             static_cast<unsigned>(header.size));
+    return Ok();
+  }
+
+  /// Unmap (invalidates every view handed out)
+  void close() {
+    if (mapped_) {
+      esp_partition_munmap(handle_);
+      mapped_ = false;
+    }
+    image_ = {};
+    entries_ = {};
+  }
+
+  [[nodiscard]] bool is_open() const { return mapped_; }
+  [[nodiscard]] size_t count() const { return entries_.size(); }
+
+  /// Blob bytes in flash (empty if absent)
+  [[nodiscard]] std::span<const uint8_t> find(std::string_view name) const {
+    for (const auto &entry : entries_) {
+      if (name == std::string_view(entry.name, strnlen(entry.name,
+                                                       blob::NAME_LEN))) {
+        return image_.subspan(entry.offset, entry.size);
+      }
+    }
+    return {};
+  }
+
+  /// Blob as text, e.g. PEM (empty if absent)
+  /// @note data()[size()] is the image's NUL, so the view can go to C APIs
+  ///       expecting a NUL-terminated string
+  [[nodiscard]] std::string_view text(std::string_view name) const {
+    auto bytes = find(name);
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+
+private:
+  static constexpr const char *TAG = "BlobPartition";
+
+  /// Check CRC and entry bounds of the mapped image
+  [[nodiscard]] Status validate(const blob::ImageHeader &header,
+                                size_t toc_end) const {
+    if (Crc32::compute(image_.subspan(sizeof(header))) != header.crc) {
+      return Err(ESP_ERR_INVALID_CRC);
+    }
+    const auto *toc =
+        reinterpret_cast<const blob::Entry *>(image_.data() + sizeof(header));
+    for (size_t i = 0; i < header.count; ++i) {
+      const auto &entry = toc[i];
+      // Named, inside the data area and followed by its NUL
+      if (entry.name[0] == '\0' || entry.offset < toc_end ||
+          entry.offset >= header.size ||
+          entry.size >= header.size - entry.offset ||
+          image_[entry.offset + entry.size] != '\0') {
+        return Err(ESP_ERR_INVALID_SIZE);
+      }
+    }
+    return Ok();
+  }
+
+  std::span<const uint8_t> image_{};
+  std::span<const blob::Entry> entries_{};
+  esp_partition_mmap_handle_t handle_{};
+  bool mapped_{false};
+};
+
+} // namespace core
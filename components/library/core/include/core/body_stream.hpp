@@ -0,0 +1,91 @@
+/**
+ * @file body_stream.hpp
+ * @brief Streamed request bodies (produced while the request is sent)
+ *
+ * An IBodySource writes its payload piece by piece into a BodyStream that
+ * forwards straight to the connection, so the full body never has to be
+ * materialized in RAM. HttpClient sends such bodies with chunked transfer
+ * encoding.
+ *
+ * The same BodyStream also receives downloads (HttpClient::download()), one
+ * read buffer at a time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace core {
+
+/// Sink for a streamed request body
+class BodyStream {
+public:
+  virtual ~BodyStream() = default;
+
+  /// Write the next part of the body
+  /// @return false if the connection failed (abort producing)
+  [[nodiscard]] virtual bool write(std::span<const uint8_t> data) = 0;
+
+protected:
+  BodyStream() = default;
+  BodyStream(const BodyStream &) = default;
+  BodyStream &operator=(const BodyStream &) = default;
+  BodyStream(BodyStream &&) = default;
+  BodyStream &operator=(BodyStream &&) = default;
+};
+
+/// Producer of a streamed request body
+class IBodySource {
+public:
+  virtual ~IBodySource() = default;
+
+  /// Write the whole body into out
+  ///
+  /// May be called again for the same request (a kept-alive connection
+  /// found dead): produce the same body each time.
+  /// @return false to abort the request
+  [[nodiscard]] virtual bool produce(BodyStream &out) = 0;
+
+protected:
+  IBodySource() = default;
+  IBodySource(const IBodySource &) = default;
+  IBodySource &operator=(const IBodySource &) = default;
+  IBodySource(IBodySource &&) = default;
+  IBodySource &operator=(IBodySource &&) = default;
+};
+
+/// Forwards another source's body and counts its bytes
+class CountingSource final : public IBodySource {
+public:
+  explicit CountingSource(IBodySource &source) : source_(source) {}
+
+  [[nodiscard]] bool produce(BodyStream &out) override {
+    Counting counting(out, bytes_);
+    return source_.produce(counting);
+  }
+
+  /// Bytes written so far (over all produce() calls)
+  [[nodiscard]] size_t bytes() const { return bytes_; }
+
+private:
+  class Counting final : public BodyStream {
+  public:
+    Counting(BodyStream &out, size_t &bytes) : out_(out), bytes_(bytes) {}
+
+    [[nodiscard]] bool write(std::span<const uint8_t> data) override {
+      bytes_ += data.size();
+      return out_.write(data);
+    }
+
+  private:
+    BodyStream &out_;
+    size_t &bytes_;
+  };
+
+  IBodySource &source_;
+  size_t bytes_ = 0;
+};
+
+} // namespace core
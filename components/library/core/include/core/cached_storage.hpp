@@ -0,0 +1,682 @@
+/**
+ * @file cached_storage.hpp
+ * @brief Write-back RAM cache in front of another IStorage
+ *
+ * CachedStorage decorates a namespace opened on any backend:
+ * - Reads of small values (scalars, blobs/strings up to MaxValue bytes) are
+ *   served from RAM after the first one. Missing keys are cached too, so a
+ *   repeated "is it provisioned?" probe costs one NVS lookup per boot.
+ * - Writes only update RAM. Writing the value already stored is a no-op;
+ *   several writes to a key between flushes reach flash once.
+ * - flush() / commit() write every dirty entry and then commit the inner
+ *   storage once. The inner commit is skipped when nothing was dirty.
+ *
+ * Flushes happen on explicit commit(), on StorageManager::commit_all()
+ * (called before deep sleep), and optionally from a periodic timer so an
+ * uncommitted write is not held in RAM indefinitely.
+ *
+ * Values too large for an entry go straight to the inner storage (after
+ * dropping any cached copy).
+ */
+
+#pragma once
+
+#include "mutex.hpp"
+#include "nvs_storage.hpp"
+#include "result.hpp"
+#include "storage.hpp"
+#include "timer.hpp"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace core {
+
+/// Write-back cache settings
+struct CacheConfig {
+  /// Flush dirty entries this often (0 = only on commit / commit_all)
+  std::chrono::seconds flush_interval{0};
+};
+
+/// Cache effectiveness counters
+struct CacheStats {
+  uint32_t hits{0};      // Reads served from RAM
+  uint32_t misses{0};    // Reads that went to the inner storage
+  uint32_t coalesced{0}; // Writes absorbed (same value, or overwritten)
+  uint32_t flushes{0};   // Inner commits performed
+};
+
+/// IStorage decorator caching values in RAM with deferred writes
+///
+/// @tparam Entries Keys cached at once (least recently used clean entry is
+///         evicted first; a full dirty cache flushes before evicting)
+/// @tparam MaxValue Largest blob / string body held in an entry
+/// @thread_safety Thread-safe (the flush timer runs on the esp_timer task)
+template <size_t Entries = 16, size_t MaxValue = 64>
+class CachedStorageT final : public IStorage {
+public:
+  explicit CachedStorageT(StoragePtr inner, const CacheConfig &config = {})
+      : inner_(std::move(inner)), timer_([this] { on_timer(); }) {
+    if (config.flush_interval.count() > 0) {
+      if (auto status = timer_.start(config.flush_interval); !status) {
+        ESP_LOGW(TAG, "Flush timer not started: %s",
+                 esp_err_to_name(status.error()));
+      }
+    }
+  }
+
+  ~CachedStorageT() override {
+    (void)timer_.stop();
+    (void)flush();
+  }
+
+  // The flush timer captures this
+  CachedStorageT(const CachedStorageT &) = delete;
+  CachedStorageT &operator=(const CachedStorageT &) = delete;
+  CachedStorageT(CachedStorageT &&) = delete;
+  CachedStorageT &operator=(CachedStorageT &&) = delete;
+
+  /// Write dirty entries to the inner storage and commit it
+  [[nodiscard]] Status flush() {
+    LockGuard lock(mutex_);
+    return flush_locked();
+  }
+
+  /// Number of entries waiting to be written
+  [[nodiscard]] size_t dirty_count() const {
+    LockGuard lock(mutex_);
+    return static_cast<size_t>(std::ranges::count_if(entries_, [](auto &e) {
+      return e.state == State::Dirty || e.state == State::Erased;
+    }));
+  }
+
+  [[nodiscard]] CacheStats stats() const {
+    LockGuard lock(mutex_);
+    return stats_;
+  }
+
+  [[nodiscard]] IStorage &inner() { return *inner_; }
+
+  // IStorage
+
+  [[nodiscard]] bool is_ready() const override {
+    return inner_ != nullptr && inner_->is_ready();
+  }
+
+  [[nodiscard]] Result<size_t> get_blob_size(StorageKey key) override {
+    LockGuard lock(mutex_);
+    if (auto *e = lookup(key, Kind::Blob)) {
+      return e->present() ? Result<size_t>(e->size) : Err(e->error);
+    }
+    return inner_->get_blob_size(key);
+  }
+
+  [[nodiscard]] Status get_blob(StorageKey key,
+                                std::span<uint8_t> buffer) override {
+    LockGuard lock(mutex_);
+    auto *e = lookup(key, Kind::Blob);
+    if (e == nullptr) {
+      e = load_bytes(key, Kind::Blob);
+    }
+    if (e == nullptr) {
+      return inner_->get_blob(key, buffer);
+    }
+    if (!e->present()) {
+      return Err(e->error);
+    }
+    if (buffer.size() < e->size) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::copy_n(e->data.begin(), e->size, buffer.begin());
+    return Ok();
+  }
+
+  [[nodiscard]] Status set_blob(StorageKey key,
+                                std::span<const uint8_t> data) override {
+    LockGuard lock(mutex_);
+    if (!fits(data.size())) {
+      drop(key);
+      return inner_->set_blob(key, data);
+    }
+    return store(key, Kind::Blob, data);
+  }
+
+  /// Size including the null terminator (as NVS reports it)
+  [[nodiscard]] Result<size_t> get_string_size(StorageKey key) override {
+    LockGuard lock(mutex_);
+    if (auto *e = lookup(key, Kind::String)) {
+      return e->present() ? Result<size_t>(e->size + 1) : Err(e->error);
+    }
+    return inner_->get_string_size(key);
+  }
+
+  [[nodiscard]] Status get_string(StorageKey key,
+                                  std::span<char> buffer) override {
+    LockGuard lock(mutex_);
+    auto *e = lookup(key, Kind::String);
+    if (e == nullptr) {
+      e = load_bytes(key, Kind::String);
+    }
+    if (e == nullptr) {
+      return inner_->get_string(key, buffer);
+    }
+    if (!e->present()) {
+      return Err(e->error);
+    }
+    if (buffer.size() < e->size + 1U) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::copy_n(e->data.begin(), e->size, buffer.begin());
+    buffer[e->size] = '\0';
+    return Ok();
+  }
+
+  [[nodiscard]] Status set_string(StorageKey key,
+                                  std::string_view value) override {
+    LockGuard lock(mutex_);
+    if (!fits(value.size())) {
+      drop(key);
+      return inner_->set_string(key, value);
+    }
+    return store(key, Kind::String,
+                 {reinterpret_cast<const uint8_t *>(value.data()),
+                  value.size()});
+  }
+
+  /// Hits come from RAM; each miss goes to the inner storage's get_many()
+  /// and is cached if it fits an entry
+  [[nodiscard]] Status get_many(std::span<StorageRead> items) override {
+    LockGuard lock(mutex_);
+    for (auto &item : items) {
+      Kind kind = kind_of(item.type);
+      if (auto *e = lookup(item.key, kind)) {
+        serve(*e, item);
+        continue;
+      }
+
+      ++stats_.misses;
+      (void)inner_->get_many(std::span(&item, 1));
+      if (item.found()) {
+        // Strings come back with their terminator
+        size_t length = (item.type == StorageType::String && item.size != 0)
+                            ? item.size - 1
+                            : item.size;
+        if (fits(length)) {
+          remember(item.key, kind, State::Clean, item.buffer.first(length));
+        }
+      } else if (is_not_found(item.error)) {
+        remember_absent(item.key, kind, item.error);
+      }
+    }
+    return Ok();
+  }
+
+  [[nodiscard]] bool contains(StorageKey key) override {
+    LockGuard lock(mutex_);
+    if (auto *e = find(key)) {
+      if (e->state != State::Absent || e->kind == Kind::Any) {
+        touch(*e);
+        return e->present();
+      }
+    }
+    return inner_->contains(key);
+  }
+
+  [[nodiscard]] Status erase(StorageKey key) override {
+    LockGuard lock(mutex_);
+    auto *e = find(key);
+    if (e != nullptr &&
+        (e->state == State::Erased ||
+         (e->state == State::Absent && e->kind == Kind::Any))) {
+      // Known missing; NVS reports erasing a missing key as an error
+      return Err(e->error);
+    }
+    if ((e == nullptr || !e->present()) && !inner_->contains(key)) {
+      (void)remember_absent(key, Kind::Any, ESP_ERR_NVS_NOT_FOUND);
+      return Err(ESP_ERR_NVS_NOT_FOUND);
+    }
+    if (e == nullptr) {
+      e = allocate(key);
+      if (e == nullptr) {
+        return inner_->erase(key);
+      }
+    }
+    e->kind = Kind::Any;
+    e->state = State::Erased;
+    e->error = ESP_ERR_NVS_NOT_FOUND;
+    e->size = 0;
+    touch(*e);
+    return Ok();
+  }
+
+  /// Drops the cache, then erases and commits the inner storage
+  [[nodiscard]] Status erase_all() override {
+    LockGuard lock(mutex_);
+    entries_.fill({});
+    return inner_->erase_all();
+  }
+
+  [[nodiscard]] Status commit() override {
+    LockGuard lock(mutex_);
+    return flush_locked();
+  }
+
+protected:
+  Result<int8_t> get_i8(StorageKey key) override {
+    return get_scalar<int8_t>(key);
+  }
+  Result<uint8_t> get_u8(StorageKey key) override {
+    return get_scalar<uint8_t>(key);
+  }
+  Result<int16_t> get_i16(StorageKey key) override {
+    return get_scalar<int16_t>(key);
+  }
+  Result<uint16_t> get_u16(StorageKey key) override {
+    return get_scalar<uint16_t>(key);
+  }
+  Result<int32_t> get_i32(StorageKey key) override {
+    return get_scalar<int32_t>(key);
+  }
+  Result<uint32_t> get_u32(StorageKey key) override {
+    return get_scalar<uint32_t>(key);
+  }
+
+  Status set_i8(StorageKey key, int8_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u8(StorageKey key, uint8_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_i16(StorageKey key, int16_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u16(StorageKey key, uint16_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_i32(StorageKey key, int32_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u32(StorageKey key, uint32_t value) override {
+    return set_scalar(key, value);
+  }
+
+private:
+  static constexpr const char *TAG = "CachedStorage";
+
+  static_assert(MaxValue <= UINT8_MAX, "Entry sizes are 8-bit");
+
+  /// Value type of an entry (Any: erased / missing under every type)
+  enum class Kind : uint8_t { Any, I8, U8, I16, U16, I32, U32, Blob, String };
+
+  enum class State : uint8_t {
+    Empty,  // Slot unused
+    Clean,  // Matches the inner storage
+    Dirty,  // Written here, not yet in the inner storage
+    Absent, // Inner storage reported the key missing (error holds why)
+    Erased, // Erased here, not yet in the inner storage
+  };
+
+  struct Entry {
+    std::array<char, StorageKey::MAX_LEN + 1> key{};
+    uint32_t hash{0};
+    Kind kind{Kind::Any};
+    State state{State::Empty};
+    uint8_t size{0};
+    esp_err_t error{ESP_OK};
+    uint32_t last_use{0};
+    std::array<uint8_t, MaxValue> data{};
+
+    [[nodiscard]] bool present() const {
+      return state == State::Clean || state == State::Dirty;
+    }
+  };
+
+  static constexpr Kind kind_of(StorageType type) {
+    static_assert(static_cast<uint8_t>(Kind::I8) ==
+                      static_cast<uint8_t>(StorageType::I8) + 1 &&
+                  static_cast<uint8_t>(Kind::String) ==
+                      static_cast<uint8_t>(StorageType::String) + 1);
+    return static_cast<Kind>(static_cast<uint8_t>(type) + 1);
+  }
+
+  /// Answer a batch item from a cached entry
+  static void serve(const Entry &e, StorageRead &item) {
+    item.size = 0;
+    if (!e.present()) {
+      item.error = e.error;
+      return;
+    }
+    bool is_string = e.kind == Kind::String;
+    bool is_bytes = is_string || e.kind == Kind::Blob;
+    size_t needed = e.size + (is_string ? 1U : 0U);
+    if (is_bytes ? needed > item.buffer.size() : needed != item.buffer.size()) {
+      item.error = ESP_ERR_INVALID_SIZE;
+      return;
+    }
+    std::copy_n(e.data.begin(), e.size, item.buffer.begin());
+    if (is_string) {
+      item.buffer[e.size] = '\0';
+    }
+    item.error = ESP_OK;
+    item.size = needed;
+  }
+
+  template <typename T> static constexpr Kind kind_of() {
+    if constexpr (std::is_same_v<T, int8_t>) {
+      return Kind::I8;
+    } else if constexpr (std::is_same_v<T, uint8_t>) {
+      return Kind::U8;
+    } else if constexpr (std::is_same_v<T, int16_t>) {
+      return Kind::I16;
+    } else if constexpr (std::is_same_v<T, uint16_t>) {
+      return Kind::U16;
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+      return Kind::I32;
+    } else {
+      static_assert(std::is_same_v<T, uint32_t>, "Unsupported type");
+      return Kind::U32;
+    }
+  }
+
+  [[nodiscard]] static bool fits(size_t size) { return size <= MaxValue; }
+
+  /// Forget a key (writing it back first if pending)
+  void drop(StorageKey key) {
+    if (auto *e = find(key)) {
+      if (e->state == State::Dirty || e->state == State::Erased) {
+        (void)write_back(*e);
+      }
+      *e = {};
+    }
+  }
+
+  template <typename T> Result<T> get_scalar(StorageKey key) {
+    LockGuard lock(mutex_);
+    if (auto *e = lookup(key, kind_of<T>())) {
+      if (!e->present()) {
+        return Err(e->error);
+      }
+      T value{};
+      std::memcpy(&value, e->data.data(), sizeof(T));
+      return value;
+    }
+
+    ++stats_.misses;
+    auto result = inner_->template get<T>(key);
+    if (result) {
+      T value = *result;
+      remember(key, kind_of<T>(), State::Clean,
+               {reinterpret_cast<const uint8_t *>(&value), sizeof(T)});
+    } else if (is_not_found(result.error())) {
+      remember_absent(key, kind_of<T>(), result.error());
+    }
+    return result;
+  }
+
+  template <typename T> Status set_scalar(StorageKey key, T value) {
+    LockGuard lock(mutex_);
+    return store(key, kind_of<T>(),
+                 {reinterpret_cast<const uint8_t *>(&value), sizeof(T)});
+  }
+
+  [[nodiscard]] Entry *find(StorageKey key) {
+    for (auto &e : entries_) {
+      if (e.state != State::Empty && e.hash == key.hash() &&
+          std::string_view(e.key.data()) == key.view()) {
+        return &e;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Cached entry usable for a read of this kind, else nullptr
+  ///
+  /// An entry of another kind is flushed and dropped so the inner storage
+  /// answers (and reports the type mismatch the way it normally would).
+  [[nodiscard]] Entry *lookup(StorageKey key, Kind kind) {
+    auto *e = find(key);
+    if (e == nullptr) {
+      return nullptr;
+    }
+    if (e->kind == kind || (e->kind == Kind::Any && !e->present())) {
+      ++stats_.hits;
+      touch(*e);
+      return e;
+    }
+    drop(key);
+    return nullptr;
+  }
+
+  /// Read a blob / string from the inner storage into a new entry
+  /// @return Entry, or nullptr if it can't be cached (read it directly)
+  [[nodiscard]] Entry *load_bytes(StorageKey key, Kind kind) {
+    ++stats_.misses;
+    auto size = kind == Kind::Blob ? inner_->get_blob_size(key)
+                                   : inner_->get_string_size(key);
+    if (!size) {
+      if (is_not_found(size.error())) {
+        return remember_absent(key, kind, size.error());
+      }
+      return nullptr;
+    }
+
+    // Strings come back with their terminator
+    size_t length = kind == Kind::String ? *size - 1 : *size;
+    if (*size == 0 || length > MaxValue) {
+      return nullptr;
+    }
+
+    std::array<uint8_t, MaxValue + 1> buffer{};
+    Status status = kind == Kind::Blob
+                        ? inner_->get_blob(key, std::span(buffer.data(), length))
+                        : inner_->get_string(
+                              key, std::span(reinterpret_cast<char *>(
+                                                 buffer.data()),
+                                             *size));
+    if (!status) {
+      return nullptr;
+    }
+    return remember(key, kind, State::Clean,
+                    std::span<const uint8_t>(buffer.data(), length));
+  }
+
+  /// Write path shared by all types (bytes fit an entry)
+  [[nodiscard]] Status store(StorageKey key, Kind kind,
+                             std::span<const uint8_t> bytes) {
+    auto *e = find(key);
+    if (e != nullptr) {
+      if (e->present() && e->kind == kind && e->size == bytes.size() &&
+          std::ranges::equal(std::span(e->data.data(), e->size), bytes)) {
+        ++stats_.coalesced;
+        touch(*e);
+        return Ok();
+      }
+      if (e->state == State::Dirty) {
+        ++stats_.coalesced;
+      }
+    } else {
+      e = allocate(key);
+      if (e == nullptr) {
+        return write_through(key, kind, bytes);
+      }
+    }
+
+    e->kind = kind;
+    e->state = State::Dirty;
+    e->error = ESP_OK;
+    e->size = static_cast<uint8_t>(bytes.size());
+    std::ranges::copy(bytes, e->data.begin());
+    touch(*e);
+    return Ok();
+  }
+
+  Entry *remember(StorageKey key, Kind kind, State state,
+                  std::span<const uint8_t> bytes) {
+    auto *e = find(key);
+    if (e == nullptr) {
+      e = allocate(key);
+    }
+    if (e == nullptr) {
+      return nullptr;
+    }
+    e->kind = kind;
+    e->state = state;
+    e->error = ESP_OK;
+    e->size = static_cast<uint8_t>(bytes.size());
+    std::ranges::copy(bytes, e->data.begin());
+    touch(*e);
+    return e;
+  }
+
+  Entry *remember_absent(StorageKey key, Kind kind, esp_err_t error) {
+    auto *e = remember(key, kind, State::Absent, {});
+    if (e != nullptr) {
+      e->error = error;
+    }
+    return e;
+  }
+
+  /// Free slot for key: empty, else least recently used clean one. A cache
+  /// full of pending writes is flushed first.
+  [[nodiscard]] Entry *allocate(StorageKey key) {
+    auto *slot = pick_victim();
+    if (slot == nullptr) {
+      if (!flush_locked()) {
+        return nullptr;
+      }
+      slot = pick_victim();
+    }
+    if (slot == nullptr) {
+      return nullptr;
+    }
+    *slot = {};
+    std::copy_n(key.c_str(), key.size(), slot->key.begin());
+    slot->hash = key.hash();
+    return slot;
+  }
+
+  [[nodiscard]] Entry *pick_victim() {
+    Entry *victim = nullptr;
+    for (auto &e : entries_) {
+      if (e.state == State::Empty) {
+        return &e;
+      }
+      if ((e.state == State::Clean || e.state == State::Absent) &&
+          (victim == nullptr || e.last_use < victim->last_use)) {
+        victim = &e;
+      }
+    }
+    return victim;
+  }
+
+  void touch(Entry &e) { e.last_use = ++use_counter_; }
+
+  [[nodiscard]] Status write_through(StorageKey key, Kind kind,
+                                     std::span<const uint8_t> bytes) {
+    auto scalar = [&]<typename T>(T) {
+      T value{};
+      std::memcpy(&value, bytes.data(), sizeof(T));
+      return inner_->set(key, value);
+    };
+    switch (kind) {
+    case Kind::I8:
+      return scalar(int8_t{});
+    case Kind::U8:
+      return scalar(uint8_t{});
+    case Kind::I16:
+      return scalar(int16_t{});
+    case Kind::U16:
+      return scalar(uint16_t{});
+    case Kind::I32:
+      return scalar(int32_t{});
+    case Kind::U32:
+      return scalar(uint32_t{});
+    case Kind::Blob:
+      return inner_->set_blob(key, bytes);
+    case Kind::String: {
+      // Inner storage expects a null-terminated string
+      std::array<char, MaxValue + 1> text{};
+      std::ranges::copy(bytes, reinterpret_cast<uint8_t *>(text.data()));
+      return inner_->set_string(key, std::string_view(text.data(),
+                                                      bytes.size()));
+    }
+    case Kind::Any:
+      break;
+    }
+    return Err(ESP_ERR_INVALID_ARG);
+  }
+
+  /// Push one pending entry to the inner storage (no commit)
+  [[nodiscard]] Status write_back(Entry &e) {
+    auto key = *StorageKey::from(e.key.data());
+    if (e.state == State::Erased) {
+      auto status = inner_->erase(key);
+      if (!status && !is_not_found(status.error())) {
+        return status;
+      }
+      e.state = State::Absent;
+      return Ok();
+    }
+    if (auto status =
+            write_through(key, e.kind, std::span(e.data.data(), e.size));
+        !status) {
+      return status;
+    }
+    e.state = State::Clean;
+    return Ok();
+  }
+
+  [[nodiscard]] Status flush_locked() {
+    Status result = Ok();
+    bool wrote = false;
+    for (auto &e : entries_) {
+      if (e.state != State::Dirty && e.state != State::Erased) {
+        continue;
+      }
+      if (auto status = write_back(e); !status) {
+        ESP_LOGW(TAG, "Write-back of '%s' failed: %s", e.key.data(),
+                 esp_err_to_name(status.error()));
+        result = status; // Entry stays dirty for the next flush
+        continue;
+      }
+      wrote = true;
+    }
+    if (!wrote && result && !pending_commit_) {
+      return result;
+    }
+    if (auto status = inner_->commit(); !status) {
+      pending_commit_ = true;
+      return status;
+    }
+    pending_commit_ = false;
+    ++stats_.flushes;
+    return result;
+  }
+
+  void on_timer() {
+    if (auto status = flush(); !status) {
+      ESP_LOGW(TAG, "Periodic flush failed: %s",
+               esp_err_to_name(status.error()));
+    }
+  }
+
+  StoragePtr inner_;
+  std::array<Entry, Entries> entries_{};
+  uint32_t use_counter_{0};
+  bool pending_commit_{false}; ///< Last inner commit failed
+  CacheStats stats_{};
+  mutable Mutex mutex_;
+  PeriodicTimer timer_;
+};
+
+using CachedStorage = CachedStorageT<>;
+
+} // namespace core
@@ -0,0 +1,50 @@
+/**
+ * @file clock.hpp
+ * @brief Monotonic time base with wall-clock (epoch) offset
+ *
+ * Samples are stamped with the monotonic esp_timer clock, which is cheap and
+ * never jumps. Once SNTP synchronizes, the epoch offset is recorded here so
+ * any monotonic stamp - including ones taken before sync - can be converted
+ * to Unix time.
+ */
+
+#pragma once
+
+#include <esp_timer.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace core::clock {
+
+namespace detail {
+/// Epoch ms minus monotonic ms; 0 = not synchronized
+inline std::atomic<int64_t> epoch_offset_ms{0};
+} // namespace detail
+
+/// Milliseconds since boot (esp_timer)
+[[nodiscard]] inline int64_t monotonic_ms() {
+  return esp_timer_get_time() / 1000;
+}
+
+/// Record current Unix time (call from time sync notification)
+inline void set_epoch_ms(int64_t now_epoch_ms) {
+  detail::epoch_offset_ms.store(now_epoch_ms - monotonic_ms(),
+                                std::memory_order_relaxed);
+}
+
+/// Check if an epoch offset is known
+[[nodiscard]] inline bool is_synced() {
+  return detail::epoch_offset_ms.load(std::memory_order_relaxed) != 0;
+}
+
+/// Convert a monotonic stamp to Unix time in ms (0 if not synchronized)
+[[nodiscard]] inline uint64_t to_epoch_ms(int64_t mono_ms) {
+  int64_t offset = detail::epoch_offset_ms.load(std::memory_order_relaxed);
+  if (offset == 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(mono_ms + offset);
+}
+
+} // namespace core::clock
@@ -6,20 +6,40 @@
 #pragma once
 
 #include "app_events.hpp"
+#include "blob_partition.hpp"
+#include "body_stream.hpp"
+#include "cached_storage.hpp"
+#include "clock.hpp"
 #include "application.hpp"
 #include "crc.hpp"
+#include "deflate.hpp"
 #include "event_loop.hpp"
+#include "fault.hpp"
 #include "gpio.hpp"
 #include "http_client.hpp"
 #include "littlefs_storage.hpp"
+#include "lock_stats.hpp"
 #include "monitor.hpp"
 #include "mutex.hpp"
 #include "nvs_storage.hpp"
+#include "pool.hpp"
+#include "record_log.hpp"
 #include "result.hpp"
+#include "rtc_backend.hpp"
+#include "rtc_mirror.hpp"
 #include "rtc_storage.hpp"
 #include "semaphore.hpp"
+#include "spsc_queue.hpp"
 #include "storage.hpp"
 #include "storage_backend.hpp"
+#include "storage_key.hpp"
 #include "storage_manager.hpp"
+#include "storage_worker.hpp"
 #include "task.hpp"
+#include "task_registry.hpp"
 #include "timer.hpp"
+#include "timer_wheel.hpp"
+#include "typed_event.hpp"
+#include "url.hpp"
+#include "wake_profile.hpp"
+#include "worker.hpp"
@@ -0,0 +1,376 @@
+/**
+ * @file deferred_log.hpp
+ * @brief Hot-path logging: capture now, format and print later
+ *
+ * ESP_LOGx formats on the calling task and then waits for the UART, so a
+ * log line in a sample or request path costs milliseconds of the very
+ * timing it reports. CORE_DLOGx captures the format pointer and the raw
+ * arguments into a lock-free RAM ring instead (a few hundred cycles, no
+ * lock, no allocation); a low-priority task formats and prints them when
+ * nothing else wants the CPU:
+ *
+ *   CORE_DLOGI(TAG, "HTTP response: status=%d, body_len=%zu", status, len);
+ *
+ * Sites above CONFIG_CORE_DLOG_LEVEL compile to nothing (not even their
+ * strings), whatever CONFIG_LOG_MAXIMUM_LEVEL allows. esp_log_level_set()
+ * still filters what is printed. Lines keep the timestamp of the call.
+ *
+ * Arguments are copied by value, so only printf scalars are accepted, and
+ * a pointer must outlive the line: string literals, esp_err_to_name(),
+ * trait names. Never a buffer's contents; log those with ESP_LOGx.
+ * Records beyond CONFIG_CORE_DLOG_DEPTH are dropped and counted. Call
+ * flush() before deep sleep (restarts flush themselves).
+ *
+ * Without CONFIG_CORE_DEFERRED_LOG the macros are ESP_LOG_LEVEL with the
+ * same compile-time level.
+ */
+
+#pragma once
+
+#include "task.hpp"
+
+#include <esp_log.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#ifdef CONFIG_CORE_DLOG_LEVEL
+#define CORE_DLOG_MAX_LEVEL CONFIG_CORE_DLOG_LEVEL
+#else
+#define CORE_DLOG_MAX_LEVEL 3 // Info
+#endif
+
+#ifdef CONFIG_CORE_DLOG_DEPTH
+#define CORE_DLOG_RING_DEPTH CONFIG_CORE_DLOG_DEPTH
+#else
+#define CORE_DLOG_RING_DEPTH 64
+#endif
+
+namespace core::dlog {
+
+#ifdef CONFIG_CORE_DEFERRED_LOG
+inline constexpr bool kDeferred = true;
+#else
+inline constexpr bool kDeferred = false;
+#endif
+
+/// Most verbose level compiled in
+inline constexpr esp_log_level_t kMaxLevel =
+    static_cast<esp_log_level_t>(CORE_DLOG_MAX_LEVEL);
+
+[[nodiscard]] constexpr bool enabled(esp_log_level_t level) {
+  return level <= kMaxLevel;
+}
+
+/// Argument bytes per record (a uint64_t and four pointers fit)
+inline constexpr size_t kPayloadSize = 24;
+/// Longest printed line, longer ones are cut
+inline constexpr size_t kLineSize = 192;
+
+/// Formats a record's payload with its captured argument types
+using FormatFn = int (*)(const char *format, const std::byte *payload,
+                         std::span<char> out);
+
+/// Packs Args into a payload and formats them back
+template <typename... Args> struct Packer {
+  static_assert(((std::is_arithmetic_v<Args> || std::is_enum_v<Args> ||
+                  std::is_pointer_v<Args>) &&
+                 ...),
+                "Deferred log arguments must be printf scalars");
+
+  static constexpr std::array<size_t, sizeof...(Args)> kOffsets = [] {
+    std::array<size_t, sizeof...(Args)> out{};
+    size_t pos = 0;
+    size_t i = 0;
+    ((pos = (pos + alignof(Args) - 1) / alignof(Args) * alignof(Args),
+      out.at(i++) = pos, pos += sizeof(Args)),
+     ...);
+    return out;
+  }();
+
+  static constexpr size_t kSize = [] {
+    size_t pos = 0;
+    ((pos = ((pos + alignof(Args) - 1) / alignof(Args) * alignof(Args)) +
+            sizeof(Args)),
+     ...);
+    return pos;
+  }();
+  static_assert(kSize <= kPayloadSize, "Too many deferred log arguments");
+
+  static void pack(std::byte *out, const Args &...args) {
+    pack_impl(out, std::index_sequence_for<Args...>{}, args...);
+  }
+
+  static int format(const char *format, const std::byte *payload,
+                    std::span<char> out) {
+    return format_impl(format, payload, out,
+                       std::index_sequence_for<Args...>{});
+  }
+
+private:
+  template <size_t... I>
+  static void pack_impl(std::byte *out, std::index_sequence<I...> /*seq*/,
+                        const Args &...args) {
+    (std::memcpy(out + kOffsets.at(I), &args, sizeof(Args)), ...);
+  }
+
+  template <typename T> static T load(const std::byte *in) {
+    T value{};
+    std::memcpy(&value, in, sizeof(T));
+    return value;
+  }
+
+  template <size_t... I>
+  static int format_impl(const char *format, const std::byte *payload,
+                         std::span<char> out,
+                         std::index_sequence<I...> /*seq*/) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+    // The call site checked format against these types (CORE_DLOG)
+    return std::snprintf(out.data(), out.size(), format,
+                         load<Args>(payload + kOffsets.at(I))...);
+#pragma GCC diagnostic pop
+  }
+};
+
+/// printf format check of a call site (never called, only sized)
+[[gnu::format(printf, 1, 2)]] int check_format(const char *format, ...);
+
+/// The ring and its printing task
+///
+/// A bounded multi-producer, multi-consumer ring (sequence number per
+/// slot): producers on any task claim a slot with one CAS, the log task
+/// and flush() consume the same way.
+///
+/// @thread_safety All methods are thread-safe; log() from task context.
+class DeferredLog {
+public:
+  static constexpr size_t kDepth = CORE_DLOG_RING_DEPTH;
+  static_assert(kDepth > 0 && (kDepth & (kDepth - 1)) == 0,
+                "CONFIG_CORE_DLOG_DEPTH must be a power of two");
+  static constexpr uint32_t kTaskStack = 3072;
+
+  DeferredLog() {
+    for (size_t i = 0; i < kDepth; ++i) {
+      slots_.at(i).sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  DeferredLog(const DeferredLog &) = delete;
+  DeferredLog &operator=(const DeferredLog &) = delete;
+  DeferredLog(DeferredLog &&) = delete;
+  DeferredLog &operator=(DeferredLog &&) = delete;
+
+  /// Start the printing task; records made before wait in the ring
+  void start(UBaseType_t priority = 1) {
+    if (task_) {
+      return;
+    }
+    task_.emplace([this]() { run(); }, StaticTaskConfig{
+                                           .name = "dlog",
+                                           .priority = priority,
+                                       });
+    handle_.store(task_->native_handle(), std::memory_order_release);
+    esp_register_shutdown_handler([] { instance().flush(); });
+  }
+
+  /// Capture one line (use the CORE_DLOGx macros)
+  template <typename... Args>
+  void log(esp_log_level_t level, const char *tag, const char *format,
+           Args... args) {
+    using P = Packer<Args...>;
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+      slot = &slots_.at(pos & (kDepth - 1));
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->record = {
+        .timestamp_ms = esp_log_timestamp(),
+        .tag = tag,
+        .format = format,
+        .fn = &P::format,
+        .level = level,
+    };
+    P::pack(slot->record.payload.data(), args...);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    TaskHandle_t handle = handle_.load(std::memory_order_acquire);
+    if (handle != nullptr && xPortInIsrContext() == 0) {
+      xTaskNotifyGive(handle);
+    }
+  }
+
+  /// Print everything captured so far on the calling task
+  void flush() {
+    while (print_one()) {
+    }
+    report_dropped();
+  }
+
+  /// Records lost to a full ring since boot
+  [[nodiscard]] uint32_t dropped_total() const {
+    return dropped_total_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] static DeferredLog &instance() {
+    static DeferredLog log;
+    return log;
+  }
+
+private:
+  static constexpr const char *TAG = "dlog";
+
+  struct Record {
+    uint32_t timestamp_ms = 0;
+    const char *tag = "";
+    const char *format = "";
+    FormatFn fn = nullptr;
+    esp_log_level_t level = ESP_LOG_NONE;
+    alignas(8) std::array<std::byte, kPayloadSize> payload{};
+  };
+
+  struct Slot {
+    std::atomic<size_t> sequence{0};
+    Record record;
+  };
+
+  [[noreturn]] void run() {
+    while (true) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      flush();
+    }
+  }
+
+  /// Take the oldest record and print it
+  /// @return false if the ring was empty
+  bool print_one() {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+      slot = &slots_.at(pos & (kDepth - 1));
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    Record record = slot->record;
+    slot->sequence.store(pos + kDepth, std::memory_order_release);
+
+    std::array<char, kLineSize> line{};
+    record.fn(record.format, record.payload.data(), line);
+    esp_log_write(record.level, record.tag, "%c (%lu) %s: %s\n",
+                  level_letter(record.level),
+                  static_cast<unsigned long>(record.timestamp_ms), record.tag,
+                  line.data());
+    return true;
+  }
+
+  void report_dropped() {
+    uint32_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped != 0) {
+      dropped_total_.fetch_add(dropped, std::memory_order_relaxed);
+      ESP_LOGW(TAG, "%lu deferred log line(s) dropped, ring full",
+               static_cast<unsigned long>(dropped));
+    }
+  }
+
+  [[nodiscard]] static char level_letter(esp_log_level_t level) {
+    switch (level) {
+    case ESP_LOG_ERROR:
+      return 'E';
+    case ESP_LOG_WARN:
+      return 'W';
+    case ESP_LOG_INFO:
+      return 'I';
+    case ESP_LOG_DEBUG:
+      return 'D';
+    default:
+      return 'V';
+    }
+  }
+
+  std::array<Slot, kDepth> slots_{};
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> dropped_total_{0};
+  std::atomic<TaskHandle_t> handle_{nullptr};
+  std::optional<StaticTask<kTaskStack>> task_;
+};
+
+/// Start the printing task (no-op without CONFIG_CORE_DEFERRED_LOG)
+inline void start(UBaseType_t priority = 1) {
+  if constexpr (kDeferred) {
+    DeferredLog::instance().start(priority);
+  }
+}
+
+/// Print what is pending, e.g. before deep sleep
+inline void flush() {
+  if constexpr (kDeferred) {
+    DeferredLog::instance().flush();
+  }
+}
+
+} // namespace core::dlog
+
+/// Deferred log at a compile-time level; see the file comment
+#define CORE_DLOG(level, tag, format, ...)                                     \
+  do {                                                                         \
+    if constexpr (::core::dlog::enabled(level)) {                              \
+      if constexpr (::core::dlog::kDeferred) {                                 \
+        static_cast<void>(sizeof(                                              \
+            ::core::dlog::check_format(format __VA_OPT__(, ) __VA_ARGS__)));   \
+        ::core::dlog::DeferredLog::instance().log(                             \
+            level, tag, format __VA_OPT__(, ) __VA_ARGS__);                    \
+      } else {                                                                 \
+        ESP_LOG_LEVEL(level, tag, format __VA_OPT__(, ) __VA_ARGS__);          \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+
+#define CORE_DLOGE(tag, format, ...)                                           \
+  CORE_DLOG(ESP_LOG_ERROR, tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define CORE_DLOGW(tag, format, ...)                                           \
+  CORE_DLOG(ESP_LOG_WARN, tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define CORE_DLOGI(tag, format, ...)                                           \
+  CORE_DLOG(ESP_LOG_INFO, tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define CORE_DLOGD(tag, format, ...)                                           \
+  CORE_DLOG(ESP_LOG_DEBUG, tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define CORE_DLOGV(tag, format, ...)                                           \
+  CORE_DLOG(ESP_LOG_VERBOSE, tag, format __VA_OPT__(, ) __VA_ARGS__)
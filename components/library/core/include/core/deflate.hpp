@@ -0,0 +1,267 @@
+/**
+ * @file deflate.hpp
+ * @brief Small-footprint zlib/deflate compressor for request bodies
+ *
+ * Produces a zlib stream (RFC 1950, HTTP `Content-Encoding: deflate`)
+ * with a single fixed-Huffman block (RFC 1951 BTYPE=01) - no dynamic
+ * tables, so the only state is the LZ77 match index over a static window.
+ * Any stock inflate (zlib, Go compress/zlib, browsers) decodes it.
+ *
+ * Memory: 2 * (HASH_SIZE + WindowSize) bytes inside the compressor object,
+ * input and output buffers supplied by the caller. Nothing on the heap.
+ *
+ * Usage:
+ *   core::DeflateCompressor deflate;
+ *   size_t n = deflate.compress(payload, scratch);
+ *   if (n != 0 && n < payload.size()) { send scratch.first(n) }
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace core {
+
+/// One-shot zlib compressor with a WindowSize-byte LZ77 window
+/// @tparam WindowSize Match distance limit (power of two, 256..32768)
+template <size_t WindowSize = 1024> class DeflateCompressorT {
+public:
+  static_assert(std::has_single_bit(WindowSize) && WindowSize >= 256 &&
+                    WindowSize <= 32768,
+                "WindowSize must be a power of two in 256..32768");
+
+  /// Largest input accepted (match positions are stored as uint16_t)
+  static constexpr size_t MAX_INPUT_SIZE = 0xFFFE;
+
+  /// Compress input into out as a zlib stream
+  /// @return Bytes written, or 0 if out is too small or input too large
+  [[nodiscard]] size_t compress(std::span<const uint8_t> in,
+                                std::span<uint8_t> out) {
+    if (in.size() > MAX_INPUT_SIZE) {
+      return 0;
+    }
+
+    head_.fill(0);
+    BitWriter bits{out};
+
+    bits.put_byte(ZLIB_CMF);
+    bits.put_byte(ZLIB_FLG);
+    bits.put(1, 1); // BFINAL
+    bits.put(1, 2); // BTYPE = fixed Huffman
+
+    size_t pos = 0;
+    while (pos < in.size()) {
+      auto [length, distance] = find_match(in, pos);
+      if (length >= MIN_MATCH) {
+        put_length(bits, length);
+        put_distance(bits, distance);
+        for (size_t end = pos + length; pos < end; ++pos) {
+          insert(in, pos);
+        }
+      } else {
+        put_literal(bits, in[pos]);
+        insert(in, pos);
+        ++pos;
+      }
+      if (bits.overflow) {
+        return 0;
+      }
+    }
+
+    put_literal(bits, END_OF_BLOCK);
+    bits.align();
+
+    uint32_t adler = adler32(in);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      bits.put_byte(static_cast<uint8_t>(adler >> shift));
+    }
+    return bits.overflow ? 0 : bits.used;
+  }
+
+private:
+  static constexpr size_t MIN_MATCH = 3;
+  static constexpr size_t MAX_MATCH = 258;
+  static constexpr size_t MAX_CHAIN = 32; ///< Candidates tried per position
+  static constexpr size_t HASH_BITS = 9;
+  static constexpr size_t HASH_SIZE = size_t{1} << HASH_BITS;
+  static constexpr uint16_t END_OF_BLOCK = 256;
+
+  // CM=8 (deflate), CINFO=log2(window)-8, FCHECK makes CMF:FLG % 31 == 0
+  static constexpr uint8_t ZLIB_CMF = static_cast<uint8_t>(
+      0x08 | ((std::bit_width(WindowSize) - 1 - 8) << 4));
+  static constexpr uint8_t ZLIB_FLG =
+      static_cast<uint8_t>(31 - ((ZLIB_CMF * 256U) % 31));
+
+  static constexpr std::array<uint16_t, 29> LENGTH_BASE{
+      3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  static constexpr std::array<uint8_t, 29> LENGTH_EXTRA{
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+  static constexpr std::array<uint16_t, 30> DIST_BASE{
+      1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+      33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+      1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+  static constexpr std::array<uint8_t, 30> DIST_EXTRA{
+      0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+      6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+  /// LSB-first bit packer into a caller buffer
+  struct BitWriter {
+    std::span<uint8_t> out;
+    size_t used{0};
+    uint32_t acc{0};
+    int count{0};
+    bool overflow{false};
+
+    void put_byte(uint8_t b) {
+      if (used < out.size()) {
+        out[used++] = b;
+      } else {
+        overflow = true;
+      }
+    }
+
+    void put(uint32_t value, int nbits) {
+      acc |= value << count;
+      count += nbits;
+      while (count >= 8) {
+        put_byte(static_cast<uint8_t>(acc));
+        acc >>= 8;
+        count -= 8;
+      }
+    }
+
+    /// Huffman codes are defined MSB-first
+    void put_code(uint32_t code, int nbits) {
+      uint32_t reversed = 0;
+      for (int i = 0; i < nbits; ++i) {
+        reversed = (reversed << 1) | ((code >> i) & 1U);
+      }
+      put(reversed, nbits);
+    }
+
+    void align() {
+      if (count > 0) {
+        put(0, 8 - count);
+      }
+    }
+  };
+
+  /// Fixed literal/length code (RFC 1951 3.2.6)
+  static void put_literal(BitWriter &bits, uint16_t sym) {
+    if (sym <= 143) {
+      bits.put_code(0x30 + sym, 8);
+    } else if (sym <= 255) {
+      bits.put_code(0x190 + (sym - 144), 9);
+    } else if (sym <= 279) {
+      bits.put_code(sym - 256, 7);
+    } else {
+      bits.put_code(0xC0 + (sym - 280), 8);
+    }
+  }
+
+  static void put_length(BitWriter &bits, size_t length) {
+    size_t code = LENGTH_BASE.size() - 1;
+    while (LENGTH_BASE.at(code) > length) {
+      --code;
+    }
+    put_literal(bits, static_cast<uint16_t>(257 + code));
+    if (LENGTH_EXTRA.at(code) != 0) {
+      bits.put(static_cast<uint32_t>(length - LENGTH_BASE.at(code)),
+               LENGTH_EXTRA.at(code));
+    }
+  }
+
+  static void put_distance(BitWriter &bits, size_t distance) {
+    size_t code = DIST_BASE.size() - 1;
+    while (DIST_BASE.at(code) > distance) {
+      --code;
+    }
+    bits.put_code(static_cast<uint32_t>(code), 5);
+    if (DIST_EXTRA.at(code) != 0) {
+      bits.put(static_cast<uint32_t>(distance - DIST_BASE.at(code)),
+               DIST_EXTRA.at(code));
+    }
+  }
+
+  [[nodiscard]] static size_t hash(std::span<const uint8_t> in, size_t pos) {
+    uint32_t v = (static_cast<uint32_t>(in[pos]) << 16) |
+                 (static_cast<uint32_t>(in[pos + 1]) << 8) | in[pos + 2];
+    return ((v * 2654435761U) >> (32 - HASH_BITS)) & (HASH_SIZE - 1);
+  }
+
+  /// Add pos to the match index (positions stored +1, 0 = empty)
+  void insert(std::span<const uint8_t> in, size_t pos) {
+    if (pos + MIN_MATCH > in.size()) {
+      return;
+    }
+    size_t h = hash(in, pos);
+    prev_.at(pos & (WindowSize - 1)) = head_.at(h);
+    head_.at(h) = static_cast<uint16_t>(pos + 1);
+  }
+
+  struct Match {
+    size_t length;
+    size_t distance;
+  };
+
+  /// Longest earlier occurrence of the bytes at pos within the window
+  [[nodiscard]] Match find_match(std::span<const uint8_t> in,
+                                 size_t pos) const {
+    Match best{0, 0};
+    if (pos + MIN_MATCH > in.size()) {
+      return best;
+    }
+
+    size_t limit = std::min(MAX_MATCH, in.size() - pos);
+    size_t candidate = head_.at(hash(in, pos));
+    for (size_t chain = 0; chain < MAX_CHAIN && candidate != 0; ++chain) {
+      size_t start = candidate - 1;
+      if (start >= pos || pos - start > WindowSize) {
+        break;
+      }
+      size_t len = 0;
+      while (len < limit && in[start + len] == in[pos + len]) {
+        ++len;
+      }
+      if (len > best.length) {
+        best = {len, pos - start};
+        if (len == limit) {
+          break;
+        }
+      }
+      size_t next = prev_.at(start & (WindowSize - 1));
+      // Older entries only; a newer one means the slot was reused
+      if (next == 0 || next - 1 >= start) {
+        break;
+      }
+      candidate = next;
+    }
+    return best;
+  }
+
+  [[nodiscard]] static uint32_t adler32(std::span<const uint8_t> data) {
+    constexpr uint32_t mod = 65521;
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (uint8_t byte : data) {
+      a = (a + byte) % mod;
+      b = (b + a) % mod;
+    }
+    return (b << 16) | a;
+  }
+
+  std::array<uint16_t, HASH_SIZE> head_{};
+  std::array<uint16_t, WindowSize> prev_{};
+};
+
+/// Default 1 KB window (2 KB + 1 KB index)
+using DeflateCompressor = DeflateCompressorT<>;
+
+} // namespace core
@@ -1,13 +1,25 @@
 /**
  * @file event_loop.hpp
- * @brief RAII wrapper for ESP-IDF default event loop
+ * @brief RAII wrapper for ESP-IDF event loops
+ *
+ * Events go to the default loop, whose one task also runs the WiFi and IP
+ * handlers. A base with bursty traffic can get a loop of its own with
+ * create_loop(): its own queue, task priority and stack, so a backlog on
+ * one side doesn't hold up the other. subscribe() and publish() route by
+ * base; callers don't change.
+ *
+ *   (void)core::EventBus::create_loop(SENSOR_EVENTS, {.name = "sensor_evt"});
  */
 
 #pragma once
 
 #include <esp_event.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
+#include <array>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <type_traits>
 
@@ -22,14 +34,25 @@ namespace core {
 template <typename T>
 concept EventId = std::is_enum_v<T> || std::is_integral_v<T>;
 
+/// Dedicated event loop settings (EventBus::create_loop)
+struct EventLoopConfig {
+  const char *name = "events";
+  int32_t queue_size = 16; ///< Events waiting before publish() blocks
+  UBaseType_t priority = 5;
+  uint32_t stack_size = 3072; ///< Handlers run on this stack
+  BaseType_t core_id = tskNO_AFFINITY;
+};
+
 /// RAII event handler (auto-unsubscribes)
 class EventSubscription {
 public:
   EventSubscription() = default;
 
+  /// @param loop nullptr for the default loop
   EventSubscription(esp_event_base_t base, int32_t event_id,
-                    esp_event_handler_instance_t instance)
-      : base_(base), id_(event_id), instance_(instance) {}
+                    esp_event_handler_instance_t instance,
+                    esp_event_loop_handle_t loop = nullptr)
+      : base_(base), id_(event_id), instance_(instance), loop_(loop) {}
 
   ~EventSubscription() { unsubscribe(); }
 
@@ -37,7 +60,8 @@ public:
   EventSubscription &operator=(const EventSubscription &) = delete;
 
   EventSubscription(EventSubscription &&other) noexcept
-      : base_(other.base_), id_(other.id_), instance_(other.instance_) {
+      : base_(other.base_), id_(other.id_), instance_(other.instance_),
+        loop_(other.loop_) {
     other.instance_ = nullptr;
   }
 
@@ -47,16 +71,22 @@ public:
       base_ = other.base_;
       id_ = other.id_;
       instance_ = other.instance_;
+      loop_ = other.loop_;
       other.instance_ = nullptr;
     }
     return *this;
   }
 
   void unsubscribe() {
-    if (instance_ != nullptr) {
+    if (instance_ == nullptr) {
+      return;
+    }
+    if (loop_ != nullptr) {
+      esp_event_handler_instance_unregister_with(loop_, base_, id_, instance_);
+    } else {
       esp_event_handler_instance_unregister(base_, id_, instance_);
-      instance_ = nullptr;
     }
+    instance_ = nullptr;
   }
 
   [[nodiscard]] bool active() const { return instance_ != nullptr; }
@@ -66,11 +96,15 @@ private:
   esp_event_base_t base_ = nullptr;
   int32_t id_ = 0;
   esp_event_handler_instance_t instance_ = nullptr;
+  esp_event_loop_handle_t loop_ = nullptr;
 };
 
-/// Event bus using ESP-IDF default event loop
+/// Event bus on the ESP-IDF default event loop (and dedicated ones)
 class EventBus {
 public:
+  /// Bases with a dedicated loop
+  static constexpr size_t kMaxLoops = 4;
+
   static esp_err_t initialize() {
     auto &bus = get();
     if (bus.ready_.exchange(true)) {
@@ -88,6 +122,50 @@ public:
     return bus;
   }
 
+  /// Dispatch base's events on a loop task of their own
+  ///
+  /// Call during init, before anything subscribes to or publishes base:
+  /// earlier subscriptions stay on the default loop and miss the events.
+  /// The loop lives as long as the bus.
+  /// @return ESP_ERR_INVALID_STATE if base already has a loop,
+  ///         ESP_ERR_NO_MEM if kMaxLoops are taken or the task can't start
+  static esp_err_t create_loop(esp_event_base_t base,
+                               const EventLoopConfig &config = {}) {
+    auto &bus = get();
+    if (bus.loop_for(base) != nullptr) {
+      return ESP_ERR_INVALID_STATE;
+    }
+    size_t count = bus.route_count_.load(std::memory_order_acquire);
+    if (count == kMaxLoops) {
+      return ESP_ERR_NO_MEM;
+    }
+    esp_event_loop_args_t args{
+        .queue_size = config.queue_size,
+        .task_name = config.name,
+        .task_priority = config.priority,
+        .task_stack_size = config.stack_size,
+        .task_core_id = config.core_id,
+    };
+    esp_event_loop_handle_t loop = nullptr;
+    if (esp_err_t err = esp_event_loop_create(&args, &loop); err != ESP_OK) {
+      return err;
+    }
+    bus.routes_.at(count) = {base, loop};
+    bus.route_count_.store(count + 1, std::memory_order_release);
+    return ESP_OK;
+  }
+
+  /// The dedicated loop of base (nullptr: the default loop)
+  [[nodiscard]] esp_event_loop_handle_t loop_for(esp_event_base_t base) const {
+    size_t count = route_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+      if (routes_.at(i).base == base) {
+        return routes_.at(i).loop;
+      }
+    }
+    return nullptr;
+  }
+
   EventBus(const EventBus &) = delete;
   EventBus &operator=(const EventBus &) = delete;
   EventBus(EventBus &&) = delete;
@@ -99,12 +177,18 @@ public:
                                             esp_event_handler_t handler,
                                             void *arg = nullptr) {
     esp_event_handler_instance_t inst = nullptr;
-    esp_err_t err = esp_event_handler_instance_register(
-        base, static_cast<int32_t>(event_id), handler, arg, &inst);
+    auto *loop = loop_for(base);
+    esp_err_t err =
+        loop != nullptr
+            ? esp_event_handler_instance_register_with(
+                  loop, base, static_cast<int32_t>(event_id), handler, arg,
+                  &inst)
+            : esp_event_handler_instance_register(
+                  base, static_cast<int32_t>(event_id), handler, arg, &inst);
     if (err != ESP_OK) {
       return {};
     }
-    return {base, static_cast<int32_t>(event_id), inst};
+    return {base, static_cast<int32_t>(event_id), inst, loop};
   }
 
   /// Publish event (with optional data pointer)
@@ -115,15 +199,18 @@ public:
     if (stopped_.load()) {
       return ESP_ERR_INVALID_STATE;
     }
-    if constexpr (std::is_null_pointer_v<DataPtr>) {
-      return esp_event_post(base, static_cast<int32_t>(event_id), nullptr, 0,
-                            timeout);
-    } else {
-      using Value = std::remove_cv_t<std::remove_pointer_t<DataPtr>>;
-      return esp_event_post(base, static_cast<int32_t>(event_id),
-                            static_cast<const void *>(data), sizeof(Value),
-                            timeout);
+    const void *ptr = nullptr;
+    size_t size = 0;
+    if constexpr (!std::is_null_pointer_v<DataPtr>) {
+      ptr = static_cast<const void *>(data);
+      size = sizeof(std::remove_cv_t<std::remove_pointer_t<DataPtr>>);
+    }
+    if (auto *loop = loop_for(base); loop != nullptr) {
+      return esp_event_post_to(loop, base, static_cast<int32_t>(event_id),
+                               ptr, size, timeout);
     }
+    return esp_event_post(base, static_cast<int32_t>(event_id), ptr, size,
+                          timeout);
   }
 
   /// Publish from ISR (with optional data pointer)
@@ -134,15 +221,18 @@ public:
     if (stopped_.load()) {
       return ESP_ERR_INVALID_STATE;
     }
-    if constexpr (std::is_null_pointer_v<DataPtr>) {
-      return esp_event_isr_post(base, static_cast<int32_t>(event_id), nullptr,
-                                0, woken);
-    } else {
-      using Value = std::remove_cv_t<std::remove_pointer_t<DataPtr>>;
-      return esp_event_isr_post(base, static_cast<int32_t>(event_id),
-                                static_cast<const void *>(data), sizeof(Value),
-                                woken);
+    const void *ptr = nullptr;
+    size_t size = 0;
+    if constexpr (!std::is_null_pointer_v<DataPtr>) {
+      ptr = static_cast<const void *>(data);
+      size = sizeof(std::remove_cv_t<std::remove_pointer_t<DataPtr>>);
     }
+    if (auto *loop = loop_for(base); loop != nullptr) {
+      return esp_event_isr_post_to(loop, base, static_cast<int32_t>(event_id),
+                                   ptr, size, woken);
+    }
+    return esp_event_isr_post(base, static_cast<int32_t>(event_id), ptr, size,
+                              woken);
   }
 
   [[nodiscard]] bool is_ready() const { return ready_.load(); }
@@ -151,8 +241,15 @@ private:
   EventBus() = default;
   ~EventBus() { stopped_.store(true); }
 
+  struct Route {
+    esp_event_base_t base = nullptr;
+    esp_event_loop_handle_t loop = nullptr;
+  };
+
   std::atomic<bool> ready_{false};
   std::atomic<bool> stopped_{false};
+  std::array<Route, kMaxLoops> routes_{}; ///< Written before count grows
+  std::atomic<size_t> route_count_{0};
 };
 
 inline EventBus &events() { return EventBus::get(); }
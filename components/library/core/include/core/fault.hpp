@@ -0,0 +1,161 @@
+/**
+ * @file fault.hpp
+ * @brief Errors tagged with their source line, kept in RTC memory
+ *
+ * A Status says what failed (esp_err_t), not where. Fail() returns the
+ * same Err() and also records the code with a FaultSite: an id computed
+ * at compile time from the caller's file name and line, so no file name
+ * string reaches flash and nothing is formatted when the error happens.
+ *
+ *   if (err != ESP_OK) {
+ *     return core::Fail(err); // instead of core::Err(err)
+ *   }
+ *
+ * The last kEntries faults live in a ring in RTC memory (fault_ring(),
+ * defined in core.cpp, RTC_NOINIT_ATTR): they survive deep sleep and
+ * software, panic and watchdog resets, so a boot can report what went
+ * wrong before it. Only power-on loses them. log_report()
+ * prints a site as "a1f3:118": the low 16 bits of the FNV-1a hash of the
+ * file's base name, then the line. To find the file:
+ *
+ *   python3 -c 'import sys; h=0x811c9dc5
+ *   for c in sys.argv[1].encode(): h=((h^c)*0x01000193)&0xffffffff
+ *   print(hex(h&0xffff))' http_transport.hpp
+ */
+
+#pragma once
+
+#include "mutex.hpp"
+#include "result.hpp"
+#include "rtc_storage.hpp"
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_rtc_time.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <source_location>
+
+namespace core {
+
+/// Compile-time id of a source line (base name hash << 16 | line)
+class FaultSite {
+public:
+  /// The default argument is the caller's location
+  consteval FaultSite(
+      std::source_location loc = std::source_location::current())
+      : id_((hash_base_name(loc.file_name()) << 16) |
+            (loc.line() & 0xFFFF)) {}
+
+  [[nodiscard]] constexpr uint32_t id() const { return id_; }
+
+private:
+  /// FNV-1a of the part after the last '/', low 16 bits
+  [[nodiscard]] static consteval uint32_t hash_base_name(const char *path) {
+    const char *name = path;
+    for (const char *p = path; *p != '\0'; ++p) {
+      if (*p == '/' || *p == '\\') {
+        name = p + 1;
+      }
+    }
+    uint32_t hash = 0x811C9DC5;
+    for (; *name != '\0'; ++name) {
+      hash = (hash ^ static_cast<uint8_t>(*name)) * 0x01000193;
+    }
+    return hash & 0xFFFF;
+  }
+
+  uint32_t id_;
+};
+
+/// One recorded error (12 bytes)
+struct Fault {
+  esp_err_t code;
+  uint32_t site;  ///< FaultSite::id()
+  uint32_t rtc_s; ///< esp_rtc_get_time_us() in seconds (counts sleep)
+};
+
+/// Last faults, oldest overwritten first
+struct FaultRing {
+  static constexpr size_t kEntries = 16;
+
+  std::array<Fault, kEntries> entries;
+  uint32_t total; ///< Faults recorded since power-on (next slot: % kEntries)
+};
+
+/// The RTC_NOINIT_ATTR fault ring (defined in core.cpp)
+[[nodiscard]] RtcValue<FaultRing> &fault_ring();
+
+/// Records faults into fault_ring()
+///
+/// @thread_safety All methods are thread-safe.
+class FaultLog {
+public:
+  void record(esp_err_t code, FaultSite site) {
+    LockGuard lock(mutex_);
+    auto &ring = fault_ring();
+    auto faults = ring.get();
+    faults.entries.at(faults.total % FaultRing::kEntries) = {
+        .code = code,
+        .site = site.id(),
+        .rtc_s = static_cast<uint32_t>(esp_rtc_get_time_us() / 1'000'000),
+    };
+    ++faults.total;
+    ring.set(faults);
+  }
+
+  /// Call fn(const Fault &) for each kept fault, oldest first
+  template <typename Fn> void for_each(Fn &&fn) {
+    LockGuard lock(mutex_);
+    auto faults = fault_ring().get();
+    uint32_t kept = std::min<uint32_t>(faults.total, FaultRing::kEntries);
+    for (uint32_t i = faults.total - kept; i < faults.total; ++i) {
+      fn(faults.entries.at(i % FaultRing::kEntries));
+    }
+  }
+
+  /// Faults recorded since power-on (kept or overwritten)
+  [[nodiscard]] uint32_t total() {
+    LockGuard lock(mutex_);
+    return fault_ring().get().total;
+  }
+
+  void clear() {
+    LockGuard lock(mutex_);
+    fault_ring().clear();
+  }
+
+  /// Log one line per kept fault
+  void log_report() {
+    for_each([](const Fault &fault) {
+      ESP_LOGW(TAG, "%s (0x%x) at %04lx:%lu, t=%lus",
+               esp_err_to_name(fault.code), static_cast<unsigned>(fault.code),
+               static_cast<unsigned long>(fault.site >> 16),
+               static_cast<unsigned long>(fault.site & 0xFFFF),
+               static_cast<unsigned long>(fault.rtc_s));
+    });
+  }
+
+private:
+  static constexpr const char *TAG = "fault";
+
+  Mutex mutex_;
+};
+
+/// The process-wide fault log
+[[nodiscard]] inline FaultLog &fault_log() {
+  static FaultLog log;
+  return log;
+}
+
+/// Err(code), recorded in the fault log with the caller's line
+[[nodiscard]] inline std::unexpected<esp_err_t> Fail(esp_err_t code,
+                                                     FaultSite site = {}) {
+  fault_log().record(code, site);
+  return Err(code);
+}
+
+} // namespace core
@@ -0,0 +1,173 @@
+/**
+ * @file heap_watchdog.hpp
+ * @brief Heap headroom checks around network work, optional leak tracing
+ *
+ * A TLS handshake allocates its record buffers (IN 16 KiB + OUT 4 KiB on
+ * this build) in one go. When the WiFi driver's buffers and a fragmented
+ * heap leave no block that large, the failure surfaces as a random TLS or
+ * connect error deep in esp-tls. HeapWatchdog samples the heap before and
+ * after each piece of network work and classifies it against the block
+ * sizes that work needs, so the caller can act first:
+ *
+ *   switch (watchdog.check("telemetry")) {
+ *   case core::HeapPressure::Low:      // close idle connections
+ *   case core::HeapPressure::Critical: // skip the handshake, or restart
+ *   }
+ *
+ * ScopedHeapTrace prints what a scope allocated and didn't free. It needs
+ * CONFIG_CORE_HEAP_TRACE (debug builds, with standalone heap tracing) and
+ * is empty otherwise. The trace is global: allocations of other tasks
+ * during the scope show up too, and scopes don't nest.
+ */
+
+#pragma once
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+
+#ifdef CONFIG_CORE_HEAP_TRACE
+inline constexpr bool kHeapTrace = true;
+#else
+inline constexpr bool kHeapTrace = false;
+#endif
+
+/// One reading of the default heap
+struct HeapSample {
+  uint32_t free_bytes = 0;
+  uint32_t min_free_bytes = 0; ///< Lowest since boot
+  uint32_t largest_block = 0;  ///< Largest single allocation that fits now
+
+  [[nodiscard]] static HeapSample now() {
+    return {
+        .free_bytes = static_cast<uint32_t>(
+            heap_caps_get_free_size(MALLOC_CAP_DEFAULT)),
+        .min_free_bytes = static_cast<uint32_t>(
+            heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT)),
+        .largest_block = static_cast<uint32_t>(
+            heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT)),
+    };
+  }
+};
+
+enum class HeapPressure : uint8_t {
+  Normal,
+  Low,      ///< Below low_block: give back what is idle
+  Critical, ///< Below critical_block: a TLS handshake would not fit
+};
+
+[[nodiscard]] inline const char *to_string(HeapPressure pressure) {
+  switch (pressure) {
+  case HeapPressure::Normal:
+    return "normal";
+  case HeapPressure::Low:
+    return "low";
+  case HeapPressure::Critical:
+    return "critical";
+  default:
+    return "unknown";
+  }
+}
+
+struct HeapWatchdogConfig {
+  /// Largest block below which the heap counts as Low
+  uint32_t low_block = 32 * 1024;
+  /// Largest block below which the heap counts as Critical
+  uint32_t critical_block = 24 * 1024;
+  /// Consecutive Critical checks after which exhausted() is true
+  uint8_t critical_limit = 3;
+};
+
+/// Classifies the heap at each check and keeps the worst seen
+///
+/// @thread_safety check() from one task; the getters from any.
+class HeapWatchdog {
+public:
+  explicit HeapWatchdog(const HeapWatchdogConfig &config = {})
+      : config_(config) {}
+
+  /// Sample the heap; logs when the pressure level changes
+  /// @param where What is about to run or just ran (for the log)
+  HeapPressure check(const char *where) {
+    auto sample = HeapSample::now();
+    auto pressure = classify(sample.largest_block);
+
+    lowest_block_.store(
+        std::min(lowest_block_.load(std::memory_order_relaxed),
+                 sample.largest_block),
+        std::memory_order_relaxed);
+    critical_run_ = pressure == HeapPressure::Critical
+                        ? static_cast<uint8_t>(critical_run_ + 1)
+                        : uint8_t{0};
+
+    if (pressure != last_) {
+      ESP_LOGW(TAG, "Heap %s at %s: largest block %lu, free %lu (min %lu)",
+               to_string(pressure), where,
+               static_cast<unsigned long>(sample.largest_block),
+               static_cast<unsigned long>(sample.free_bytes),
+               static_cast<unsigned long>(sample.min_free_bytes));
+    } else {
+      ESP_LOGD(TAG, "%s: largest block %lu, free %lu", where,
+               static_cast<unsigned long>(sample.largest_block),
+               static_cast<unsigned long>(sample.free_bytes));
+    }
+    last_ = pressure;
+    return pressure;
+  }
+
+  /// critical_limit Critical checks in a row: the heap isn't recovering
+  [[nodiscard]] bool exhausted() const {
+    return config_.critical_limit != 0 &&
+           critical_run_ >= config_.critical_limit;
+  }
+
+  /// Smallest largest block seen by check()
+  [[nodiscard]] uint32_t lowest_block() const {
+    return lowest_block_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] HeapPressure last() const { return last_; }
+
+private:
+  static constexpr const char *TAG = "heap";
+
+  [[nodiscard]] HeapPressure classify(uint32_t largest_block) const {
+    if (largest_block < config_.critical_block) {
+      return HeapPressure::Critical;
+    }
+    if (largest_block < config_.low_block) {
+      return HeapPressure::Low;
+    }
+    return HeapPressure::Normal;
+  }
+
+  HeapWatchdogConfig config_;
+  HeapPressure last_ = HeapPressure::Normal;
+  uint8_t critical_run_ = 0;
+  std::atomic<uint32_t> lowest_block_{UINT32_MAX};
+};
+
+/// Logs the allocations a scope leaves behind
+/// (CONFIG_CORE_HEAP_TRACE; defined in core.cpp, no-op otherwise)
+class ScopedHeapTrace {
+public:
+  explicit ScopedHeapTrace(const char *name);
+  ~ScopedHeapTrace();
+
+  ScopedHeapTrace(const ScopedHeapTrace &) = delete;
+  ScopedHeapTrace &operator=(const ScopedHeapTrace &) = delete;
+  ScopedHeapTrace(ScopedHeapTrace &&) = delete;
+  ScopedHeapTrace &operator=(ScopedHeapTrace &&) = delete;
+
+private:
+  const char *name_;
+  bool active_ = false; ///< False if another scope is tracing
+};
+
+} // namespace core
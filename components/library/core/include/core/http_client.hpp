@@ -5,24 +5,34 @@
  * Provides a modern C++ interface over ESP-IDF's HTTP client with:
  * - Zero heap allocation (template-sized buffers)
  * - Automatic resource cleanup
- * - Keep-alive connection support
- * - TLS configuration
+ * - Keep-alive connection reuse with lazy reconnect and reuse statistics
+ * - TLS configuration and session resumption
+ * - Streamed request bodies (chunked transfer encoding)
+ * - URL and query string encoded straight into the fixed URL buffer
  */
 
 #pragma once
 
+#include "body_stream.hpp"
+#include "deferred_log.hpp"
+#include "metrics.hpp"
 #include "result.hpp"
+#include "url.hpp"
+#include "wake_profile.hpp"
 
 #include <esp_crt_bundle.h>
 #include <esp_http_client.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <strings.h>
 #include <span>
 #include <string_view>
 
@@ -42,6 +52,7 @@ enum class HttpMethod : uint8_t {
 enum class ContentType : uint8_t {
   Json,
   Protobuf,
+  ProtobufDelimited,
   OctetStream,
   FormUrlEnc,
   TextPlain
@@ -55,6 +66,8 @@ content_type_str(ContentType type) noexcept {
     return "application/json";
   case ContentType::Protobuf:
     return "application/x-protobuf";
+  case ContentType::ProtobufDelimited:
+    return "application/x-protobuf-delimited";
   case ContentType::OctetStream:
     return "application/octet-stream";
   case ContentType::FormUrlEnc:
@@ -71,6 +84,8 @@ inline constexpr std::chrono::milliseconds TIMEOUT{30000};
 inline constexpr std::chrono::seconds KEEP_ALIVE_IDLE{60};
 inline constexpr std::chrono::seconds KEEP_ALIVE_INTERVAL{15};
 inline constexpr uint8_t KEEP_ALIVE_COUNT = 3;
+/// Redirects download() follows (signed storage URLs usually need one)
+inline constexpr uint8_t MAX_REDIRECTS = 3;
 /// Buffer size for HTTP receive/transmit (must fit JWT auth header ~1500 bytes)
 inline constexpr int HTTP_BUFFER_SIZE = 4096;
 } // namespace http_defaults
@@ -87,16 +102,60 @@ struct HttpClientConfig {
   std::string_view ca_cert;     // PEM format, must outlive client
   std::string_view client_cert; // PEM format, must outlive client
   std::string_view client_key;  // PEM format, must outlive client
+  /// Keep the TLS session ticket on the handle so a reconnect resumes
+  /// instead of doing a full handshake (needs
+  /// CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+  bool tls_session_resumption{true};
   int buffer_size{http_defaults::HTTP_BUFFER_SIZE};
   int buffer_size_tx{http_defaults::HTTP_BUFFER_SIZE};
 };
 
+/// Connection reuse counters (since the client was created)
+struct HttpConnectionStats {
+  uint32_t connections_opened{0}; ///< TCP (+TLS) connections established
+  uint32_t requests{0};           ///< Requests that got a response
+  uint32_t reconnects{0};         ///< Requests retried on a fresh connection
+  uint32_t requests_on_connection{0}; ///< Requests on the current connection
+  uint32_t max_requests_per_connection{0};
+  int64_t last_handshake_us{0};  ///< Connect + handshake of the last open
+  int64_t total_handshake_us{0}; ///< Sum over all opened connections
+
+  /// Average requests served per connection
+  [[nodiscard]] uint32_t requests_per_connection() const {
+    return connections_opened == 0 ? 0 : requests / connections_opened;
+  }
+
+  [[nodiscard]] int64_t avg_handshake_us() const {
+    return connections_opened == 0 ? 0
+                                   : total_handshake_us / connections_opened;
+  }
+
+  void on_connected(int64_t handshake_us) {
+    ++connections_opened;
+    requests_on_connection = 0;
+    last_handshake_us = handshake_us;
+    total_handshake_us += handshake_us;
+  }
+
+  void on_request() {
+    ++requests;
+    ++requests_on_connection;
+    max_requests_per_connection =
+        std::max(max_requests_per_connection, requests_on_connection);
+  }
+};
+
 /// HTTP response view (points into client's internal buffer)
 struct HttpResponse {
   const uint8_t *data{nullptr};
   size_t length{0};
   int status_code{0};
   size_t content_length{0};
+  uint32_t retry_after_s{0}; ///< Retry-After delta-seconds (0 = none)
+  /// X-Poll-Interval delta-seconds: when to ask again (0 = none)
+  uint32_t poll_interval_s{0};
+  /// ETag, quotes included (view into the client; empty = none)
+  std::string_view etag{};
 
   [[nodiscard]] bool is_success() const {
     return status_code >= 200 && status_code < 300;
@@ -129,6 +188,8 @@ inline constexpr size_t RESPONSE = 4096;
 inline constexpr size_t URL = 256;
 /// "Bearer " + JWT (~1500 bytes)
 inline constexpr size_t AUTH = 2048;
+/// Longest ETag kept from a response (a longer one is dropped)
+inline constexpr size_t ETAG = 64;
 } // namespace http_buffers
 
 /// RAII wrapper for esp_http_client
@@ -160,7 +221,7 @@ public:
   HttpClient(HttpClient &&other) noexcept
       : handle_(other.handle_), base_url_(other.base_url_),
         response_buffer_(other.response_buffer_),
-        response_len_(other.response_len_) {
+        response_len_(other.response_len_), stats_(other.stats_) {
     other.handle_ = nullptr;
   }
 
@@ -173,6 +234,7 @@ public:
       base_url_ = other.base_url_;
       response_buffer_ = other.response_buffer_;
       response_len_ = other.response_len_;
+      stats_ = other.stats_;
       other.handle_ = nullptr;
     }
     return *this;
@@ -182,20 +244,23 @@ public:
   [[nodiscard]] explicit operator bool() const noexcept { return valid(); }
 
   /// Perform HTTP request
+  /// @param path Already-encoded path (see url::static_path)
+  /// @param query Parameters percent-encoded into the URL buffer
   [[nodiscard]] Result<HttpResponse>
   perform(HttpMethod method, std::string_view path,
           std::span<const uint8_t> body = {},
-          ContentType content_type = ContentType::Json) {
+          ContentType content_type = ContentType::Json,
+          std::span<const QueryParam> query = {}) {
 
     if (handle_ == nullptr) {
       return Err(ESP_ERR_INVALID_STATE);
     }
 
     // Reset response
-    response_len_ = 0;
+    reset_response();
 
     // Build URL into fixed buffer
-    if (!build_url(path)) {
+    if (!build_url(path, query)) {
       return Err(ESP_ERR_INVALID_SIZE);
     }
 
@@ -223,27 +288,25 @@ public:
       }
     }
 
-    // Re-apply auth header right before perform (in case set_url cleared it)
-    if (auth_buffer_[0] != '\0') {
-      size_t auth_len = strlen(auth_buffer_.data());
-      ESP_LOGI(TAG, "Re-applying auth header: %zu bytes", auth_len);
-      err = esp_http_client_set_header(handle_, "Authorization",
-                                       auth_buffer_.data());
-      if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to re-apply auth header: %s",
-                 esp_err_to_name(err));
-      }
-    } else {
-      ESP_LOGW(TAG, "No auth header in buffer to apply");
-    }
-
+    // Reuses the open keep-alive connection if there is one
+    request_start_us_ = esp_timer_get_time();
     err = esp_http_client_perform(handle_);
+    if (stale_connection(err) && response_len_ == 0) {
+      // No answer: drop the dead socket and send the request once more
+      ESP_LOGW(TAG, "%s, reopening connection", esp_err_to_name(err));
+      esp_http_client_close(handle_);
+      ++stats_.reconnects;
+      metrics().request_retries.add();
+      reset_response();
+      request_start_us_ = esp_timer_get_time();
+      err = esp_http_client_perform(handle_);
+    }
 
     // Log response info regardless of error
     int status = esp_http_client_get_status_code(handle_);
     int64_t content_len = esp_http_client_get_content_length(handle_);
-    ESP_LOGI(TAG, "HTTP response: status=%d, content_len=%lld, body_len=%zu",
-             status, content_len, response_len_);
+    CORE_DLOGI(TAG, "HTTP response: status=%d, content_len=%lld, body_len=%zu",
+               status, content_len, response_len_);
 
     if (err != ESP_OK) {
       ESP_LOGE(TAG, "HTTP request failed: %s (status was %d)",
@@ -257,17 +320,233 @@ public:
       return Err(err);
     }
 
+    record_request();
+
     HttpResponse response{
         .data = response_buffer_.data(),
         .length = response_len_,
         .status_code = status,
         .content_length = static_cast<size_t>(content_len),
+        .retry_after_s = retry_after_s_,
+        .poll_interval_s = poll_interval_s_,
+        .etag = {etag_buffer_.data(), etag_len_},
     };
 
     return response;
   }
 
+  /// Perform HTTP request with a streamed body
+  ///
+  /// The body is sent with chunked transfer encoding as the source
+  /// produces it, so it is never buffered in full. The response is read
+  /// into the client's buffer as with perform().
+  [[nodiscard]] Result<HttpResponse>
+  perform_stream(HttpMethod method, std::string_view path,
+                 IBodySource &source,
+                 ContentType content_type = ContentType::Protobuf,
+                 std::span<const QueryParam> query = {}) {
+    if (handle_ == nullptr) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+
+    reset_response();
+
+    if (!build_url(path, query)) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    esp_err_t err = esp_http_client_set_url(handle_, url_buffer_.data());
+    if (err != ESP_OK)
+      return Err(err);
+
+    err = esp_http_client_set_method(
+        handle_, static_cast<esp_http_client_method_t>(method));
+    if (err != ESP_OK)
+      return Err(err);
+
+    err = esp_http_client_set_header(handle_, "Content-Type",
+                                     content_type_str(content_type));
+    if (err != ESP_OK) {
+      return Err(err);
+    }
+
+    request_start_us_ = esp_timer_get_time();
+    size_t sent = 0;
+    err = send_streamed(source, sent);
+    if (stale_connection(err)) {
+      // No answer yet: the source produces the same body again
+      ESP_LOGW(TAG, "%s, reopening connection", esp_err_to_name(err));
+      esp_http_client_close(handle_);
+      ++stats_.reconnects;
+      metrics().request_retries.add();
+      request_start_us_ = esp_timer_get_time();
+      err = send_streamed(source, sent);
+    }
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "Streamed request failed after %zu bytes: %s", sent,
+               esp_err_to_name(err));
+      esp_http_client_close(handle_);
+      return Err(err);
+    }
+
+    // Read the body directly (the event handler does not copy in this mode)
+    streaming_ = true;
+    int read = esp_http_client_read_response(
+        handle_, reinterpret_cast<char *>(response_buffer_.data()),
+        static_cast<int>(response_buffer_.size()));
+    streaming_ = false;
+    response_len_ = read > 0 ? static_cast<size_t>(read) : 0;
+
+    int status = esp_http_client_get_status_code(handle_);
+    int64_t content_len = esp_http_client_get_content_length(handle_);
+    CORE_DLOGI(TAG, "HTTP response: status=%d, sent=%zu, body_len=%zu", status,
+               sent, response_len_);
+
+    record_request();
+
+    HttpResponse response{
+        .data = response_buffer_.data(),
+        .length = response_len_,
+        .status_code = status,
+        .content_length = static_cast<size_t>(content_len),
+        .retry_after_s = retry_after_s_,
+        .poll_interval_s = poll_interval_s_,
+        .etag = {etag_buffer_.data(), etag_len_},
+    };
+    return response;
+  }
+
+  /// GET a body straight into a sink, one chunk-sized read at a time
+  ///
+  /// Nothing is buffered beyond chunk, so the body may be far larger than
+  /// RAM. With offset > 0 a "Range: bytes=offset-" request resumes an
+  /// interrupted download; the body is only streamed if the server answers
+  /// 206 (a 200 would restart at byte 0 and is returned unread). Redirects
+  /// are followed (up to http_defaults::MAX_REDIRECTS).
+  ///
+  /// @param chunk Read buffer, handed to sink.write() for each read
+  /// @return Response whose length is the bytes delivered (data is null);
+  ///         ESP_FAIL if the connection dropped or the sink refused a chunk
+  ///         mid-body (whatever it accepted so far stays valid)
+  [[nodiscard]] Result<HttpResponse> download(std::string_view path,
+                                              size_t offset, BodyStream &sink,
+                                              std::span<uint8_t> chunk) {
+    if (handle_ == nullptr || chunk.empty()) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+
+    reset_response();
+
+    if (!build_url(path)) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    esp_err_t err = esp_http_client_set_url(handle_, url_buffer_.data());
+    if (err != ESP_OK)
+      return Err(err);
+
+    err = esp_http_client_set_method(handle_, HTTP_METHOD_GET);
+    if (err != ESP_OK)
+      return Err(err);
+
+    // Headers persist on the handle: set the range or clear a stale one
+    if (offset > 0) {
+      std::array<char, 32> range{};
+      snprintf(range.data(), range.size(), "bytes=%zu-", offset);
+      err = esp_http_client_set_header(handle_, "Range", range.data());
+    } else {
+      err = esp_http_client_delete_header(handle_, "Range");
+    }
+    if (err != ESP_OK && offset > 0) {
+      return Err(err);
+    }
+
+    int64_t content_len = 0;
+    int status = 0;
+    for (uint8_t redirects = 0;; ++redirects) {
+      request_start_us_ = esp_timer_get_time();
+      err = esp_http_client_open(handle_, 0);
+      if (err != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP open failed: %s", esp_err_to_name(err));
+        return Err(err);
+      }
+      content_len = esp_http_client_fetch_headers(handle_);
+      if (content_len < 0) {
+        esp_http_client_close(handle_);
+        return Err(ESP_ERR_HTTP_FETCH_HEADER);
+      }
+      status = esp_http_client_get_status_code(handle_);
+      if (status < 300 || status >= 400 ||
+          redirects >= http_defaults::MAX_REDIRECTS) {
+        break;
+      }
+      // Location may change the host; set_url closes the old connection
+      (void)esp_http_client_flush_response(handle_, nullptr);
+      err = esp_http_client_set_redirection(handle_);
+      if (err != ESP_OK) {
+        esp_http_client_close(handle_);
+        return Err(err);
+      }
+    }
+
+    bool expected = offset > 0 ? status == PARTIAL_CONTENT
+                               : status >= 200 && status < 300;
+    if (!expected) {
+      ESP_LOGW(TAG, "Download not started: status=%d (offset=%zu)", status,
+               offset);
+      (void)esp_http_client_flush_response(handle_, nullptr);
+      record_request();
+      return HttpResponse{.status_code = status,
+                          .content_length = static_cast<size_t>(content_len)};
+    }
+
+    // Read the body directly (the event handler does not copy in this mode)
+    streaming_ = true;
+    size_t received = 0;
+    bool ok = true;
+    while (true) {
+      int n = esp_http_client_read(handle_, reinterpret_cast<char *>(
+                                                chunk.data()),
+                                   static_cast<int>(chunk.size()));
+      if (n < 0) {
+        ok = false;
+        break;
+      }
+      if (n == 0) {
+        // EOF before the whole body: the connection dropped
+        ok = esp_http_client_is_complete_data_received(handle_);
+        break;
+      }
+      if (!sink.write(chunk.first(static_cast<size_t>(n)))) {
+        ok = false;
+        break;
+      }
+      received += static_cast<size_t>(n);
+    }
+    streaming_ = false;
+
+    if (!ok) {
+      ESP_LOGW(TAG, "Download interrupted after %zu bytes", received);
+      esp_http_client_close(handle_);
+      return Err(ESP_FAIL);
+    }
+
+    record_request();
+    return HttpResponse{.length = received,
+                        .status_code = status,
+                        .content_length = static_cast<size_t>(content_len)};
+  }
+
+  /// Connection reuse counters
+  [[nodiscard]] const HttpConnectionStats &stats() const noexcept {
+    return stats_;
+  }
+
   /// Set authorization header
+  ///
+  /// The header stays on the handle across requests and reconnects
+  /// (esp_http_client_set_url() doesn't touch headers), so call this only
+  /// when the value changes.
   Status set_auth_header(std::string_view auth_value) {
     if (handle_ == nullptr)
       return Err(ESP_ERR_INVALID_STATE);
@@ -280,8 +559,6 @@ public:
 
     esp_err_t err = esp_http_client_set_header(handle_, "Authorization",
                                                auth_buffer_.data());
-    ESP_LOGI(TAG, "esp_http_client_set_header(Authorization, %zu bytes): %s",
-             auth_value.size(), esp_err_to_name(err));
     return err == ESP_OK ? Ok() : Err(err);
   }
 
@@ -294,6 +571,16 @@ public:
     return err == ESP_OK ? Ok() : Err(err);
   }
 
+  /// Network timeout of the following requests (e.g. a long poll)
+  Status set_timeout(std::chrono::milliseconds timeout) {
+    if (handle_ == nullptr)
+      return Err(ESP_ERR_INVALID_STATE);
+
+    esp_err_t err = esp_http_client_set_timeout_ms(
+        handle_, static_cast<int>(timeout.count()));
+    return err == ESP_OK ? Ok() : Err(err);
+  }
+
   /// Delete header
   Status delete_header(const char *key) {
     if (handle_ == nullptr)
@@ -303,6 +590,26 @@ public:
     return err == ESP_OK ? Ok() : Err(err);
   }
 
+  /// Abort the request another task is blocked in: its socket is closed,
+  /// so the read returns an error (the handle stays usable)
+  Status cancel_request() {
+    if (handle_ == nullptr)
+      return Err(ESP_ERR_INVALID_STATE);
+
+    esp_err_t err = esp_http_client_cancel_request(handle_);
+    return err == ESP_OK ? Ok() : Err(err);
+  }
+
+  /// Close the connection but keep the handle, so the next perform()
+  /// resumes the TLS session (CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+  Status close() {
+    if (handle_ == nullptr)
+      return Err(ESP_ERR_INVALID_STATE);
+
+    esp_err_t err = esp_http_client_close(handle_);
+    return err == ESP_OK ? Ok() : Err(err);
+  }
+
   [[nodiscard]] static constexpr size_t buffer_capacity() {
     return ResponseSize;
   }
@@ -312,7 +619,90 @@ public:
   }
 
 private:
+  /// Errors of a kept-alive socket the server already closed (before any
+  /// response byte): the request is sent once more on a new connection
+  [[nodiscard]] static bool stale_connection(esp_err_t err) {
+    return err == ESP_ERR_HTTP_CONNECT || err == ESP_ERR_HTTP_WRITE_DATA ||
+           err == ESP_ERR_HTTP_FETCH_HEADER || err == ESP_ERR_HTTP_EAGAIN;
+  }
+
+  /// Open, stream the chunked body and read the response headers
+  /// @param sent Body bytes written
+  /// @return ESP_FAIL if the source aborted
+  [[nodiscard]] esp_err_t send_streamed(IBodySource &source, size_t &sent) {
+    // Negative length: esp_http_client sends Transfer-Encoding: chunked
+    esp_err_t err = esp_http_client_open(handle_, -1);
+    if (err != ESP_OK) {
+      return err;
+    }
+    ChunkedStream stream(handle_);
+    bool produced = source.produce(stream);
+    sent = stream.bytes_written();
+    if (stream.failed()) {
+      return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    if (!produced) {
+      return ESP_FAIL;
+    }
+    if (!stream.finish()) {
+      return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    if (esp_http_client_fetch_headers(handle_) < 0) {
+      return ESP_ERR_HTTP_FETCH_HEADER;
+    }
+    return ESP_OK;
+  }
+
   static constexpr const char *TAG = "HttpClient";
+  static constexpr int PARTIAL_CONTENT = 206;
+
+  /// BodyStream writing HTTP/1.1 chunks straight to the connection
+  class ChunkedStream final : public BodyStream {
+  public:
+    explicit ChunkedStream(esp_http_client_handle_t handle) : handle_(handle) {}
+
+    [[nodiscard]] bool write(std::span<const uint8_t> data) override {
+      if (data.empty()) {
+        return true; // A zero-size chunk would end the body
+      }
+      std::array<char, 12> header{};
+      int len = snprintf(header.data(), header.size(), "%zx\r\n", data.size());
+      if (!send(header.data(), len) ||
+          !send(reinterpret_cast<const char *>(data.data()),
+                static_cast<int>(data.size())) ||
+          !send("\r\n", 2)) {
+        return false;
+      }
+      bytes_written_ += data.size();
+      return true;
+    }
+
+    /// Terminating zero-size chunk
+    [[nodiscard]] bool finish() { return send("0\r\n\r\n", 5); }
+
+    [[nodiscard]] size_t bytes_written() const { return bytes_written_; }
+
+    /// A write to the connection failed (not the source giving up)
+    [[nodiscard]] bool failed() const { return failed_; }
+
+  private:
+    [[nodiscard]] bool send(const char *data, int len) {
+      while (len > 0) {
+        int n = esp_http_client_write(handle_, data, len);
+        if (n <= 0) {
+          failed_ = true;
+          return false;
+        }
+        data += n;
+        len -= n;
+      }
+      return true;
+    }
+
+    esp_http_client_handle_t handle_;
+    size_t bytes_written_{0};
+    bool failed_{false};
+  };
 
   void init(const HttpClientConfig &config) {
     // Enable debug logging for HTTP layer
@@ -346,6 +736,11 @@ private:
       esp_config.crt_bundle_attach = esp_crt_bundle_attach;
     }
 
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // The ticket outlives each connection; the next open resumes with it
+    esp_config.save_client_session = config.tls_session_resumption;
+#endif
+
     // mTLS
     if (!config.client_cert.empty() && !config.client_key.empty()) {
       esp_config.client_cert_pem = config.client_cert.data();
@@ -361,16 +756,30 @@ private:
     handle_ = esp_http_client_init(&esp_config);
   }
 
-  [[nodiscard]] bool build_url(std::string_view path) {
-    size_t total = base_url_.size() + path.size();
-    if (total >= url_buffer_.size())
-      return false;
+  /// base_url + path + "?query", written once into url_buffer_
+  [[nodiscard]] bool build_url(std::string_view path,
+                               std::span<const QueryParam> query = {}) {
+    url::UrlWriter url(url_buffer_);
+    url.append(base_url_).append(path).append_query(query);
+    return url.ok();
+  }
 
-    auto it =
-        std::copy_n(base_url_.data(), base_url_.size(), url_buffer_.data());
-    it = std::copy_n(path.data(), path.size(), it);
-    *it = '\0';
-    return true;
+  void reset_response() {
+    response_len_ = 0;
+    retry_after_s_ = 0;
+    poll_interval_s_ = 0;
+    etag_len_ = 0;
+  }
+
+  void record_request() {
+    stats_.on_request();
+    metrics().requests.add();
+    metrics().request_latency_ms.record(static_cast<uint32_t>(
+        (esp_timer_get_time() - request_start_us_) / 1000));
+    CORE_DLOGD(TAG, "Request %lu on connection %lu (handshake %lld us)",
+               static_cast<unsigned long>(stats_.requests_on_connection),
+               static_cast<unsigned long>(stats_.connections_opened),
+               static_cast<long long>(stats_.last_handshake_us));
   }
 
   static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
@@ -378,7 +787,32 @@ private:
     if (self == nullptr)
       return ESP_OK;
 
-    if (evt->event_id == HTTP_EVENT_ON_DATA && evt->data_len > 0) {
+    // Only raised when a new socket is opened (not on keep-alive reuse)
+    if (evt->event_id == HTTP_EVENT_ON_CONNECTED) {
+      int64_t handshake_us = esp_timer_get_time() - self->request_start_us_;
+      self->stats_.on_connected(handshake_us);
+      add_phase_time(WakePhase::Tls, static_cast<uint32_t>(handshake_us));
+    }
+
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && evt->header_key != nullptr &&
+        evt->header_value != nullptr) {
+      // Delta-seconds form only; an HTTP-date is ignored
+      if (strcasecmp(evt->header_key, "Retry-After") == 0) {
+        self->retry_after_s_ =
+            static_cast<uint32_t>(strtoul(evt->header_value, nullptr, 10));
+      } else if (strcasecmp(evt->header_key, "X-Poll-Interval") == 0) {
+        self->poll_interval_s_ =
+            static_cast<uint32_t>(strtoul(evt->header_value, nullptr, 10));
+      } else if (strcasecmp(evt->header_key, "ETag") == 0) {
+        size_t len = strlen(evt->header_value);
+        self->etag_len_ = len <= self->etag_buffer_.size() ? len : 0;
+        std::copy_n(evt->header_value, self->etag_len_,
+                    self->etag_buffer_.data());
+      }
+    }
+
+    if (evt->event_id == HTTP_EVENT_ON_DATA && evt->data_len > 0 &&
+        !self->streaming_) {
       size_t space = ResponseSize - self->response_len_;
       size_t copy_len = std::min(static_cast<size_t>(evt->data_len), space);
 
@@ -401,6 +835,13 @@ private:
   std::array<char, UrlSize> url_buffer_{};
   std::array<char, AuthSize> auth_buffer_{};
   size_t response_len_{0};
+  HttpConnectionStats stats_{};
+  int64_t request_start_us_{0};
+  uint32_t retry_after_s_{0};
+  uint32_t poll_interval_s_{0};
+  std::array<char, http_buffers::ETAG> etag_buffer_{};
+  size_t etag_len_{0};
+  bool streaming_{false}; ///< perform_stream() reads the body itself
 };
 
 /// Type alias for common configuration
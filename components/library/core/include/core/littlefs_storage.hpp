@@ -2,20 +2,30 @@
  * @file littlefs_storage.hpp
  * @brief LittleFS storage backend implementation
  *
- * Uses files as key-value storage within namespace directories.
+ * Two layouts:
+ * - LittleFsLogStorage (default): one append-only log file per namespace
+ *   with a RAM index, compacted when mostly dead
+ * - LittleFsStorage: one file per key
  */
 
 #pragma once
 
+#include "crc.hpp"
 #include "storage.hpp"
 #include "storage_backend.hpp"
 
 #include <esp_littlefs.h>
+#include <esp_log.h>
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
 #include <cstdio>
+#include <optional>
 #include <string>
 
 namespace core {
@@ -25,9 +35,17 @@ inline constexpr size_t MAX_PATH_LEN = 64;
 inline constexpr const char *MOUNT_POINT = "/storage";
 inline constexpr const char *PARTITION_LABEL = "storage";
 
+/// Keys per namespace in the log layout (RAM index size)
+inline constexpr size_t LOG_MAX_KEYS = 32;
+/// Longest key in the log layout
+inline constexpr size_t LOG_MAX_KEY_LEN = StorageKey::MAX_LEN;
+/// Logs smaller than this are never compacted
+inline constexpr size_t LOG_COMPACT_MIN_BYTES = 4096;
+
 /// RAII wrapper for FILE*
 class FileHandle {
 public:
+  FileHandle() : file_(nullptr) {}
   FileHandle(const char *path, const char *mode) : file_(fopen(path, mode)) {}
   ~FileHandle() {
     if (file_ != nullptr) {
@@ -81,18 +99,18 @@ public:
 
   [[nodiscard]] bool is_ready() const override { return !base_path_.empty(); }
 
-  [[nodiscard]] Result<size_t> get_blob_size(std::string_view key) override {
+  [[nodiscard]] Result<size_t> get_blob_size(StorageKey key) override {
     auto path = make_path(key);
     struct stat file_stat{};
-    if (stat(path.c_str(), &file_stat) != 0) {
+    if (stat(path.data(), &file_stat) != 0) {
       return Err(ESP_ERR_NOT_FOUND);
     }
     return static_cast<size_t>(file_stat.st_size);
   }
 
-  [[nodiscard]] Status get_blob(std::string_view key,
+  [[nodiscard]] Status get_blob(StorageKey key,
                                 std::span<uint8_t> buffer) override {
-    lfs::FileHandle file(make_path(key).c_str(), "rb");
+    lfs::FileHandle file(make_path(key).data(), "rb");
     if (!file.valid()) {
       return Err(ESP_ERR_NOT_FOUND);
     }
@@ -105,9 +123,9 @@ public:
     return (bytes_read == buffer.size()) ? Ok() : Err(ESP_ERR_INVALID_SIZE);
   }
 
-  [[nodiscard]] Status set_blob(std::string_view key,
+  [[nodiscard]] Status set_blob(StorageKey key,
                                 std::span<const uint8_t> data) override {
-    lfs::FileHandle file(make_path(key).c_str(), "wb");
+    lfs::FileHandle file(make_path(key).data(), "wb");
     if (!file.valid()) {
       return Err(ESP_ERR_NO_MEM);
     }
@@ -120,11 +138,11 @@ public:
     return (written == data.size()) ? Ok() : Err(ESP_FAIL);
   }
 
-  [[nodiscard]] Result<size_t> get_string_size(std::string_view key) override {
+  [[nodiscard]] Result<size_t> get_string_size(StorageKey key) override {
     return get_blob_size(key);
   }
 
-  [[nodiscard]] Status get_string(std::string_view key,
+  [[nodiscard]] Status get_string(StorageKey key,
                                   std::span<char> buffer) override {
     auto result = get_blob(
         key, std::span<uint8_t>(reinterpret_cast<uint8_t *>(buffer.data()),
@@ -133,9 +151,9 @@ public:
   }
 
   /// @pre value must be null-terminated
-  [[nodiscard]] Status set_string(std::string_view key,
+  [[nodiscard]] Status set_string(StorageKey key,
                                   std::string_view value) override {
-    lfs::FileHandle file(make_path(key).c_str(), "wb");
+    lfs::FileHandle file(make_path(key).data(), "wb");
     if (!file.valid()) {
       return Err(ESP_ERR_NO_MEM);
     }
@@ -150,15 +168,15 @@ public:
     return (written == total) ? Ok() : Err(ESP_FAIL);
   }
 
-  [[nodiscard]] bool contains(std::string_view key) override {
+  [[nodiscard]] bool contains(StorageKey key) override {
     auto path = make_path(key);
     struct stat st{};
-    return stat(path.c_str(), &st) == 0;
+    return stat(path.data(), &st) == 0;
   }
 
-  [[nodiscard]] Status erase(std::string_view key) override {
+  [[nodiscard]] Status erase(StorageKey key) override {
     auto path = make_path(key);
-    return (remove(path.c_str()) == 0) ? Ok() : Err(ESP_ERR_NOT_FOUND);
+    return (remove(path.data()) == 0) ? Ok() : Err(ESP_ERR_NOT_FOUND);
   }
 
   [[nodiscard]] Status erase_all() override {
@@ -184,41 +202,41 @@ public:
   }
 
 protected:
-  Result<int8_t> get_i8(std::string_view key) override {
+  Result<int8_t> get_i8(StorageKey key) override {
     return get_scalar<int8_t>(key);
   }
-  Result<uint8_t> get_u8(std::string_view key) override {
+  Result<uint8_t> get_u8(StorageKey key) override {
     return get_scalar<uint8_t>(key);
   }
-  Result<int16_t> get_i16(std::string_view key) override {
+  Result<int16_t> get_i16(StorageKey key) override {
     return get_scalar<int16_t>(key);
   }
-  Result<uint16_t> get_u16(std::string_view key) override {
+  Result<uint16_t> get_u16(StorageKey key) override {
     return get_scalar<uint16_t>(key);
   }
-  Result<int32_t> get_i32(std::string_view key) override {
+  Result<int32_t> get_i32(StorageKey key) override {
     return get_scalar<int32_t>(key);
   }
-  Result<uint32_t> get_u32(std::string_view key) override {
+  Result<uint32_t> get_u32(StorageKey key) override {
     return get_scalar<uint32_t>(key);
   }
 
-  Status set_i8(std::string_view key, int8_t value) override {
+  Status set_i8(StorageKey key, int8_t value) override {
     return set_scalar(key, value);
   }
-  Status set_u8(std::string_view key, uint8_t value) override {
+  Status set_u8(StorageKey key, uint8_t value) override {
     return set_scalar(key, value);
   }
-  Status set_i16(std::string_view key, int16_t value) override {
+  Status set_i16(StorageKey key, int16_t value) override {
     return set_scalar(key, value);
   }
-  Status set_u16(std::string_view key, uint16_t value) override {
+  Status set_u16(StorageKey key, uint16_t value) override {
     return set_scalar(key, value);
   }
-  Status set_i32(std::string_view key, int32_t value) override {
+  Status set_i32(StorageKey key, int32_t value) override {
     return set_scalar(key, value);
   }
-  Status set_u32(std::string_view key, uint32_t value) override {
+  Status set_u32(StorageKey key, uint32_t value) override {
     return set_scalar(key, value);
   }
 
@@ -228,7 +246,7 @@ private:
   explicit LittleFsStorage(std::string base_path)
       : base_path_(std::move(base_path)) {}
 
-  template <typename T> Result<T> get_scalar(std::string_view key) {
+  template <typename T> Result<T> get_scalar(StorageKey key) {
     T value{};
     auto status =
         get_blob(key, std::span<uint8_t>(reinterpret_cast<uint8_t *>(&value),
@@ -239,27 +257,585 @@ private:
     return value;
   }
 
-  template <typename T> Status set_scalar(std::string_view key, T value) {
+  template <typename T> Status set_scalar(StorageKey key, T value) {
     return set_blob(
         key, std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(&value),
                                       sizeof(T)));
   }
 
-  [[nodiscard]] std::string make_path(std::string_view key) const {
+  using Path = std::array<char, lfs::MAX_PATH_LEN>;
+
+  [[nodiscard]] Path make_path(StorageKey key) const {
     // File path: /storage/ns_key (flat structure, no directories)
-    std::string path = base_path_;
-    path += '_';
-    path += key;
+    Path path{};
+    std::snprintf(path.data(), path.size(), "%s_%s", base_path_.c_str(),
+                  key.c_str());
     return path;
   }
 
   std::string base_path_;
 };
 
+/// LittleFS-based storage in one append-only log file per namespace
+///
+/// Every set appends `{header, key, value}` to `/storage/<ns>.kv`; an erase
+/// appends a tombstone. A RAM index (key -> offset of its latest value) is
+/// rebuilt by scanning the log when the namespace is opened, so reads are a
+/// seek plus fread. Small keys share flash blocks instead of costing a
+/// 4 KB block and a metadata commit each.
+///
+/// Compaction: once the log exceeds lfs::LOG_COMPACT_MIN_BYTES and dead
+/// records (overwritten values, tombstones) make up more than half of it,
+/// live records are copied to `<ns>.kv.tmp`, which then replaces the log
+/// (rename is atomic on LittleFS). A torn record at the tail (power lost
+/// mid-append) ends the scan; the log is compacted right away so new
+/// records don't land behind it.
+///
+/// Like NVS, writes are durable after commit() (fsync of the log).
+class LittleFsLogStorage final : public IStorage {
+public:
+  ~LittleFsLogStorage() override = default;
+
+  LittleFsLogStorage(const LittleFsLogStorage &) = delete;
+  LittleFsLogStorage &operator=(const LittleFsLogStorage &) = delete;
+  LittleFsLogStorage(LittleFsLogStorage &&) = default;
+  LittleFsLogStorage &operator=(LittleFsLogStorage &&) = default;
+
+  [[nodiscard]] bool is_ready() const override { return file_.valid(); }
+
+  [[nodiscard]] Result<size_t> get_blob_size(StorageKey key) override {
+    const auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    return static_cast<size_t>(entry->size);
+  }
+
+  [[nodiscard]] Status get_blob(StorageKey key,
+                                std::span<uint8_t> buffer) override {
+    const auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    if (buffer.size() > entry->size) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    return read_at(entry->offset, buffer) ? Ok() : Err(ESP_FAIL);
+  }
+
+  [[nodiscard]] Status set_blob(StorageKey key,
+                                std::span<const uint8_t> data) override {
+    return append(key, data, false);
+  }
+
+  [[nodiscard]] Result<size_t> get_string_size(StorageKey key) override {
+    return get_blob_size(key);
+  }
+
+  /// Buffer may be larger than the string (as with NVS)
+  [[nodiscard]] Status get_string(StorageKey key,
+                                  std::span<char> buffer) override {
+    const auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    if (buffer.size() < entry->size) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    return read_at(entry->offset,
+                   std::span(reinterpret_cast<uint8_t *>(buffer.data()),
+                             entry->size))
+               ? Ok()
+               : Err(ESP_FAIL);
+  }
+
+  /// Stored with its null terminator (as LittleFsStorage does)
+  [[nodiscard]] Status set_string(StorageKey key,
+                                  std::string_view value) override {
+    return append(key,
+                  std::span<const uint8_t>(
+                      reinterpret_cast<const uint8_t *>(value.data()),
+                      value.size()),
+                  true);
+  }
+
+  /// Resolves every item in the RAM index, then reads the values in file
+  /// order so neighbouring values come out of one stdio buffer fill
+  [[nodiscard]] Status get_many(std::span<StorageRead> items) override {
+    for (auto &item : items) {
+      const auto *entry = find(item.key);
+      item.size = 0;
+      if (entry == nullptr) {
+        item.error = ESP_ERR_NOT_FOUND;
+      } else if (entry->size > item.buffer.size() ||
+                 (item.type != StorageType::Blob &&
+                  item.type != StorageType::String &&
+                  entry->size != item.buffer.size())) {
+        item.error = ESP_ERR_INVALID_SIZE;
+      } else {
+        item.error = ESP_ERR_NOT_FINISHED;
+      }
+    }
+
+    while (true) {
+      StorageRead *next = nullptr;
+      const IndexEntry *next_entry = nullptr;
+      for (auto &item : items) {
+        if (item.error != ESP_ERR_NOT_FINISHED) {
+          continue;
+        }
+        const auto *entry = find(item.key);
+        if (next_entry == nullptr || entry->offset < next_entry->offset) {
+          next = &item;
+          next_entry = entry;
+        }
+      }
+      if (next == nullptr) {
+        return Ok();
+      }
+      bool ok = read_at(next_entry->offset,
+                        next->buffer.first(next_entry->size));
+      next->error = ok ? ESP_OK : ESP_FAIL;
+      next->size = ok ? next_entry->size : 0;
+    }
+  }
+
+  [[nodiscard]] bool contains(StorageKey key) override {
+    return find(key) != nullptr;
+  }
+
+  [[nodiscard]] Status erase(StorageKey key) override {
+    auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    if (auto status = write_record(key, std::nullopt, false); !status) {
+      return status;
+    }
+    *entry = index_.at(--count_);
+    return compact_if_needed();
+  }
+
+  [[nodiscard]] Status erase_all() override {
+    (void)file_.close();
+    if (remove(path_.c_str()) != 0 && errno != ENOENT) {
+      return Err(ESP_FAIL);
+    }
+    count_ = 0;
+    file_size_ = 0;
+    file_ = lfs::FileHandle(path_.c_str(), "a+b");
+    return file_.valid() ? Ok() : Err(ESP_ERR_NO_MEM);
+  }
+
+  [[nodiscard]] Status commit() override {
+    if (!file_.valid()) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+    if (fflush(file_.get()) != 0 || fsync(fileno(file_.get())) != 0) {
+      return Err(ESP_FAIL);
+    }
+    return Ok();
+  }
+
+  /// Bytes in the log, and bytes of it still referenced by the index
+  [[nodiscard]] size_t file_size() const { return file_size_; }
+  [[nodiscard]] size_t live_size() const {
+    size_t live = 0;
+    for (size_t i = 0; i < count_; ++i) {
+      live += record_size(index_.at(i).key_len, index_.at(i).size);
+    }
+    return live;
+  }
+
+protected:
+  Result<int8_t> get_i8(StorageKey key) override {
+    return get_scalar<int8_t>(key);
+  }
+  Result<uint8_t> get_u8(StorageKey key) override {
+    return get_scalar<uint8_t>(key);
+  }
+  Result<int16_t> get_i16(StorageKey key) override {
+    return get_scalar<int16_t>(key);
+  }
+  Result<uint16_t> get_u16(StorageKey key) override {
+    return get_scalar<uint16_t>(key);
+  }
+  Result<int32_t> get_i32(StorageKey key) override {
+    return get_scalar<int32_t>(key);
+  }
+  Result<uint32_t> get_u32(StorageKey key) override {
+    return get_scalar<uint32_t>(key);
+  }
+
+  Status set_i8(StorageKey key, int8_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u8(StorageKey key, uint8_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_i16(StorageKey key, int16_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u16(StorageKey key, uint16_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_i32(StorageKey key, int32_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u32(StorageKey key, uint32_t value) override {
+    return set_scalar(key, value);
+  }
+
+private:
+  friend class LittleFsBackend;
+
+  static constexpr const char *TAG = "LfsLog";
+  static constexpr uint8_t MAGIC = 0xA7;
+  static constexpr uint16_t TOMBSTONE = UINT16_MAX;
+  static constexpr size_t MAX_VALUE_SIZE = TOMBSTONE - 1;
+
+  struct RecordHeader {
+    uint8_t magic;
+    uint8_t key_len;
+    uint16_t value_len; // TOMBSTONE for an erase
+    uint32_t crc;       // Over key_len, value_len, key and value
+  };
+  static_assert(sizeof(RecordHeader) == 8);
+
+  struct IndexEntry {
+    std::array<char, lfs::LOG_MAX_KEY_LEN + 1> key{};
+    uint32_t hash{0}; // StorageKey::hash() of key
+    uint8_t key_len{0};
+    uint16_t size{0};
+    uint32_t offset{0}; // Of the value within the log
+  };
+
+  explicit LittleFsLogStorage(std::string path) : path_(std::move(path)) {}
+
+  /// Build the index from the log and open it for appending
+  [[nodiscard]] Status open() {
+    bool torn = false;
+    {
+      lfs::FileHandle file(path_.c_str(), "rb");
+      if (file.valid()) {
+        torn = !scan(file.get());
+      }
+    }
+    file_ = lfs::FileHandle(path_.c_str(), "a+b");
+    if (!file_.valid()) {
+      return Err(ESP_ERR_NO_MEM);
+    }
+    if (torn) {
+      ESP_LOGW(TAG, "%s: torn tail at %zu, compacting", path_.c_str(),
+               file_size_);
+      return compact();
+    }
+    return Ok();
+  }
+
+  /// Replay records into the index
+  /// @return false if the log ends in a partial or corrupt record
+  [[nodiscard]] bool scan(FILE *file) {
+    count_ = 0;
+    file_size_ = 0;
+    while (true) {
+      RecordHeader header{};
+      size_t n = fread(&header, 1, sizeof(header), file);
+      if (n == 0) {
+        return true;
+      }
+      if (n != sizeof(header) || header.magic != MAGIC ||
+          header.key_len == 0 || header.key_len > lfs::LOG_MAX_KEY_LEN) {
+        return false;
+      }
+
+      std::array<char, lfs::LOG_MAX_KEY_LEN + 1> key{};
+      if (fread(key.data(), 1, header.key_len, file) != header.key_len) {
+        return false;
+      }
+      auto key_view = StorageKey::from(key.data());
+      if (!key_view || key_view->size() != header.key_len) {
+        return false;
+      }
+      uint16_t size = header.value_len == TOMBSTONE ? 0 : header.value_len;
+
+      Crc32 crc;
+      crc.update(header.key_len);
+      crc.update(header.value_len);
+      crc.update(std::span(reinterpret_cast<const uint8_t *>(key.data()),
+                           header.key_len));
+      if (!copy_value(file, size, crc, nullptr) ||
+          crc.value() != header.crc) {
+        return false;
+      }
+
+      auto offset =
+          static_cast<uint32_t>(file_size_ + sizeof(header) + header.key_len);
+      if (header.value_len == TOMBSTONE) {
+        if (auto *entry = find(*key_view)) {
+          *entry = index_.at(--count_);
+        }
+      } else if (!put(*key_view, size, offset)) {
+        ESP_LOGW(TAG, "%s: index full, skipping '%s'", path_.c_str(),
+                 key_view->c_str());
+      }
+      file_size_ += record_size(header.key_len, size);
+    }
+  }
+
+  template <typename T> Result<T> get_scalar(StorageKey key) {
+    T value{};
+    auto status =
+        get_blob(key, std::span<uint8_t>(reinterpret_cast<uint8_t *>(&value),
+                                         sizeof(T)));
+    if (!status) {
+      return Err(status.error());
+    }
+    return value;
+  }
+
+  template <typename T> Status set_scalar(StorageKey key, T value) {
+    return set_blob(
+        key, std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(&value),
+                                      sizeof(T)));
+  }
+
+  [[nodiscard]] static size_t record_size(size_t key_len, size_t size) {
+    return sizeof(RecordHeader) + key_len + size;
+  }
+
+  [[nodiscard]] IndexEntry *find(StorageKey key) {
+    for (size_t i = 0; i < count_; ++i) {
+      auto &entry = index_.at(i);
+      if (entry.hash == key.hash() &&
+          std::string_view(entry.key.data(), entry.key_len) == key.view()) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Insert or update an index entry
+  [[nodiscard]] bool put(StorageKey key, uint16_t size,
+                         uint32_t offset) {
+    auto *entry = find(key);
+    if (entry == nullptr) {
+      if (count_ == index_.size()) {
+        return false;
+      }
+      entry = &index_.at(count_++);
+      *entry = {};
+      std::copy_n(key.c_str(), key.size(), entry->key.begin());
+      entry->hash = key.hash();
+      entry->key_len = static_cast<uint8_t>(key.size());
+    }
+    entry->size = size;
+    entry->offset = offset;
+    return true;
+  }
+
+  [[nodiscard]] Status append(StorageKey key,
+                              std::span<const uint8_t> value, bool terminate) {
+    size_t size = value.size() + (terminate ? 1 : 0);
+    if (size > MAX_VALUE_SIZE) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    if (find(key) == nullptr && count_ == index_.size()) {
+      return Err(ESP_ERR_NO_MEM);
+    }
+
+    auto offset =
+        static_cast<uint32_t>(file_size_ + sizeof(RecordHeader) + key.size());
+    if (auto status = write_record(key, value, terminate); !status) {
+      return status;
+    }
+    (void)put(key, static_cast<uint16_t>(size), offset);
+    return compact_if_needed();
+  }
+
+  /// Append one record (value nullopt = tombstone) at the end of the log
+  [[nodiscard]] Status write_record(StorageKey key,
+                                    std::optional<std::span<const uint8_t>> value,
+                                    bool terminate) {
+    if (!file_.valid()) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+    static constexpr uint8_t NUL = 0;
+    size_t size = value ? value->size() + (terminate ? 1 : 0) : 0;
+    RecordHeader header{
+        .magic = MAGIC,
+        .key_len = static_cast<uint8_t>(key.size()),
+        .value_len = value ? static_cast<uint16_t>(size) : TOMBSTONE,
+        .crc = 0,
+    };
+    auto key_bytes = std::span(
+        reinterpret_cast<const uint8_t *>(key.c_str()), key.size());
+    Crc32 crc;
+    crc.update(header.key_len);
+    crc.update(header.value_len);
+    crc.update(key_bytes);
+    if (value) {
+      crc.update(*value);
+      if (terminate) {
+        crc.update(NUL);
+      }
+    }
+    header.crc = crc.value();
+
+    FILE *f = file_.get();
+    bool ok = fseek(f, 0, SEEK_END) == 0 &&
+              fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+              fwrite(key_bytes.data(), 1, key_bytes.size(), f) ==
+                  key_bytes.size();
+    if (ok && value) {
+      ok = fwrite(value->data(), 1, value->size(), f) == value->size() &&
+           (!terminate || fwrite(&NUL, 1, 1, f) == 1);
+    }
+    if (!ok || fflush(f) != 0) {
+      drop_torn_tail();
+      return Err(ESP_FAIL);
+    }
+    file_size_ += record_size(key.size(), size);
+    return Ok();
+  }
+
+  /// Cut a partly written record off the log: later records' offsets and
+  /// the next scan() assume it ends at file_size_
+  void drop_torn_tail() {
+    (void)file_.close(); // Buffered bytes of the record may land first
+    if (truncate(path_.c_str(), static_cast<off_t>(file_size_)) == 0) {
+      file_ = lfs::FileHandle(path_.c_str(), "a+b");
+      if (file_.valid()) {
+        return;
+      }
+    }
+    // The index still describes the records before it
+    file_ = lfs::FileHandle(path_.c_str(), "rb");
+    ESP_LOGW(TAG, "%s: truncating a torn record failed, compacting",
+             path_.c_str());
+    if (!file_.valid() || !compact()) {
+      ESP_LOGE(TAG, "%s: log unusable until the next mount", path_.c_str());
+    }
+  }
+
+  [[nodiscard]] bool read_at(uint32_t offset, std::span<uint8_t> buffer) const {
+    FILE *f = file_.get();
+    return f != nullptr && fseek(f, static_cast<long>(offset), SEEK_SET) == 0 &&
+           fread(buffer.data(), 1, buffer.size(), f) == buffer.size();
+  }
+
+  /// Stream size bytes from file's position through crc, optionally to out
+  [[nodiscard]] static bool copy_value(FILE *file, size_t size, Crc32 &crc,
+                                       FILE *out) {
+    std::array<uint8_t, 64> chunk{};
+    while (size > 0) {
+      size_t n = std::min(size, chunk.size());
+      if (fread(chunk.data(), 1, n, file) != n) {
+        return false;
+      }
+      crc.update(std::span<const uint8_t>(chunk.data(), n));
+      if (out != nullptr && fwrite(chunk.data(), 1, n, out) != n) {
+        return false;
+      }
+      size -= n;
+    }
+    return true;
+  }
+
+  [[nodiscard]] Status compact_if_needed() {
+    if (file_size_ < lfs::LOG_COMPACT_MIN_BYTES ||
+        file_size_ < 2 * live_size()) {
+      return Ok();
+    }
+    if (auto status = compact(); !status) {
+      // The log is still intact, just larger than it needs to be
+      ESP_LOGW(TAG, "%s: compaction failed: %s", path_.c_str(),
+               esp_err_to_name(status.error()));
+    }
+    return Ok();
+  }
+
+  /// Rewrite live records into a fresh log and swap it in
+  [[nodiscard]] Status compact() {
+    std::string tmp_path = path_ + ".tmp";
+    std::array<uint32_t, lfs::LOG_MAX_KEYS> offsets{};
+    size_t size = 0;
+    {
+      lfs::FileHandle out(tmp_path.c_str(), "wb");
+      if (!out.valid()) {
+        return Err(ESP_ERR_NO_MEM);
+      }
+      FILE *in = file_.get();
+      for (size_t i = 0; i < count_; ++i) {
+        const auto &entry = index_.at(i);
+        auto key_bytes = std::span(
+            reinterpret_cast<const uint8_t *>(entry.key.data()), entry.key_len);
+        RecordHeader header{.magic = MAGIC,
+                            .key_len = entry.key_len,
+                            .value_len = entry.size,
+                            .crc = 0};
+        // First pass for the CRC, second to copy
+        Crc32 crc;
+        crc.update(header.key_len);
+        crc.update(header.value_len);
+        crc.update(key_bytes);
+        if (fseek(in, static_cast<long>(entry.offset), SEEK_SET) != 0 ||
+            !copy_value(in, entry.size, crc, nullptr)) {
+          return Err(ESP_FAIL);
+        }
+        header.crc = crc.value();
+
+        Crc32 unused;
+        if (fwrite(&header, 1, sizeof(header), out.get()) != sizeof(header) ||
+            fwrite(key_bytes.data(), 1, key_bytes.size(), out.get()) !=
+                key_bytes.size() ||
+            fseek(in, static_cast<long>(entry.offset), SEEK_SET) != 0 ||
+            !copy_value(in, entry.size, unused, out.get())) {
+          return Err(ESP_FAIL);
+        }
+        offsets.at(i) =
+            static_cast<uint32_t>(size + sizeof(header) + entry.key_len);
+        size += record_size(entry.key_len, entry.size);
+      }
+      if (!out.close()) {
+        return Err(ESP_FAIL);
+      }
+    }
+
+    (void)file_.close();
+    if (rename(tmp_path.c_str(), path_.c_str()) != 0) {
+      (void)remove(tmp_path.c_str());
+      file_ = lfs::FileHandle(path_.c_str(), "a+b");
+      return Err(ESP_FAIL);
+    }
+    for (size_t i = 0; i < count_; ++i) {
+      index_.at(i).offset = offsets.at(i);
+    }
+    ESP_LOGI(TAG, "%s: compacted %zu -> %zu bytes", path_.c_str(), file_size_,
+             size);
+    file_size_ = size;
+    file_ = lfs::FileHandle(path_.c_str(), "a+b");
+    return file_.valid() ? Ok() : Err(ESP_ERR_NO_MEM);
+  }
+
+  std::string path_;
+  lfs::FileHandle file_;
+  std::array<IndexEntry, lfs::LOG_MAX_KEYS> index_{};
+  size_t count_{0};
+  size_t file_size_{0};
+};
+
+/// How LittleFsBackend lays out a namespace
+enum class LittleFsLayout : uint8_t {
+  Log,        // LittleFsLogStorage: one log file per namespace
+  FilePerKey, // LittleFsStorage: one file per key
+};
+
 /// LittleFS storage backend
 class LittleFsBackend final : public IStorageBackend {
 public:
-  LittleFsBackend() = default;
+  explicit LittleFsBackend(LittleFsLayout layout = LittleFsLayout::Log)
+      : layout_(layout) {}
   ~LittleFsBackend() override { shutdown(); }
 
   LittleFsBackend(const LittleFsBackend &) = delete;
@@ -305,7 +881,19 @@ public:
     base_path += '/';
     base_path += namespace_name(ns);
 
-    return std::unique_ptr<IStorage>(new LittleFsStorage(std::move(base_path)));
+    if (layout_ == LittleFsLayout::FilePerKey) {
+      return std::unique_ptr<IStorage>(
+          new LittleFsStorage(std::move(base_path)));
+    }
+
+    base_path += ".kv";
+    std::unique_ptr<LittleFsLogStorage> storage(
+        new LittleFsLogStorage(std::move(base_path)));
+    if (auto status = storage->open(); !status) {
+      ESP_LOGE(LittleFsLogStorage::TAG, "Opening %s failed: %s", namespace_name(ns),
+               esp_err_to_name(status.error()));
+    }
+    return storage;
   }
 
   void shutdown() override {
@@ -315,7 +903,15 @@ public:
     }
   }
 
+  /// Erase the partition and lay down an empty filesystem (remounts it if
+  /// mounted) - no walking and deleting files one by one
+  [[nodiscard]] Status format() override {
+    esp_err_t err = esp_littlefs_format(lfs::PARTITION_LABEL);
+    return (err == ESP_OK) ? Ok() : Err(err);
+  }
+
 private:
+  LittleFsLayout layout_;
   bool initialized_ = false;
 };
 
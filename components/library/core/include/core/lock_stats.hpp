@@ -0,0 +1,244 @@
+/**
+ * @file lock_stats.hpp
+ * @brief Contention counters for named locks (CONFIG_CORE_LOCK_STATS)
+ *
+ * A ProfiledLock wraps a Mutex (or any lockable) and, with
+ * CONFIG_CORE_LOCK_STATS set, counts acquisitions, how many had to wait,
+ * the longest wait and the longest hold. Without it the policy is empty
+ * and every call forwards straight to the wrapped lock - nothing is timed
+ * or stored, so locks can stay profiled in release builds.
+ *
+ *   mutable core::ProfiledLock<core::Mutex> mutex_{"auth"};
+ *   core::LockGuard lock(mutex_);
+ *
+ *   core::lock_registry().log_report();
+ *   // I lock_stats: auth        152 acq,   3 waited (max 1840 us),
+ *   //               max hold 2210 us
+ *
+ * Counters are written while the lock is held; a report taken meanwhile
+ * may be one acquisition behind.
+ */
+
+#pragma once
+
+#include "mutex.hpp"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace core {
+
+#ifdef CONFIG_CORE_LOCK_STATS
+inline constexpr bool kLockStats = true;
+#else
+inline constexpr bool kLockStats = false;
+#endif
+
+/// Counters of one lock
+struct LockStats {
+  const char *name = "";
+  uint32_t acquisitions = 0;
+  uint32_t contended = 0;   ///< Acquisitions that had to wait
+  uint32_t max_wait_us = 0; ///< Longest wait of a contended acquisition
+  uint32_t max_hold_us = 0; ///< Longest hold (outermost lock to unlock)
+};
+
+/// Stats policy that counts nothing (release default)
+struct NullLockStats {
+  static constexpr bool kEnabled = false;
+
+  explicit NullLockStats(const char * /*name*/) {}
+  void acquired(bool /*contended*/, int64_t /*wait_start_us*/) {}
+  void released() {}
+};
+
+class CountingLockStats;
+
+/// Locks whose counters are reported
+///
+/// @thread_safety All methods are thread-safe.
+class LockRegistry {
+public:
+  /// Locks tracked at once (more are counted but not reported)
+  static constexpr size_t kMaxLocks = 16;
+
+  void add(const CountingLockStats *stats) {
+    LockGuard lock(mutex_);
+    for (auto &entry : entries_) {
+      if (entry == nullptr || entry == stats) {
+        entry = stats;
+        return;
+      }
+    }
+  }
+
+  void remove(const CountingLockStats *stats) {
+    LockGuard lock(mutex_);
+    for (auto &entry : entries_) {
+      if (entry == stats) {
+        entry = nullptr;
+      }
+    }
+  }
+
+  /// Call fn(const LockStats &) for every tracked lock
+  template <typename Fn> void for_each(Fn &&fn);
+
+  /// Log one line per tracked lock (nothing without CONFIG_CORE_LOCK_STATS)
+  void log_report() {
+    for_each([](const LockStats &stats) {
+      ESP_LOGI(TAG,
+               "%-10s %6lu acq, %3lu waited (max %lu us), max hold %lu us",
+               stats.name, static_cast<unsigned long>(stats.acquisitions),
+               static_cast<unsigned long>(stats.contended),
+               static_cast<unsigned long>(stats.max_wait_us),
+               static_cast<unsigned long>(stats.max_hold_us));
+    });
+  }
+
+private:
+  static constexpr const char *TAG = "lock_stats";
+
+  Mutex mutex_;
+  std::array<const CountingLockStats *, kMaxLocks> entries_{};
+};
+
+/// The process-wide registry
+[[nodiscard]] inline LockRegistry &lock_registry() {
+  static LockRegistry registry;
+  return registry;
+}
+
+/// Stats policy that counts (CONFIG_CORE_LOCK_STATS default)
+class CountingLockStats {
+public:
+  static constexpr bool kEnabled = true;
+
+  explicit CountingLockStats(const char *name) : stats_{.name = name} {
+    lock_registry().add(this);
+  }
+
+  ~CountingLockStats() { lock_registry().remove(this); }
+
+  CountingLockStats(const CountingLockStats &) = delete;
+  CountingLockStats &operator=(const CountingLockStats &) = delete;
+  CountingLockStats(CountingLockStats &&) = delete;
+  CountingLockStats &operator=(CountingLockStats &&) = delete;
+
+  /// Called with the lock just taken
+  void acquired(bool contended, int64_t wait_start_us) {
+    int64_t now = esp_timer_get_time();
+    ++stats_.acquisitions;
+    if (contended) {
+      ++stats_.contended;
+      stats_.max_wait_us = std::max(stats_.max_wait_us,
+                                    static_cast<uint32_t>(now - wait_start_us));
+    }
+    if (depth_++ == 0) {
+      held_since_us_ = now;
+    }
+  }
+
+  /// Called just before the lock is given back
+  void released() {
+    if (--depth_ == 0) {
+      auto hold_us =
+          static_cast<uint32_t>(esp_timer_get_time() - held_since_us_);
+      stats_.max_hold_us = std::max(stats_.max_hold_us, hold_us);
+    }
+  }
+
+  [[nodiscard]] LockStats snapshot() const { return stats_; }
+
+private:
+  LockStats stats_;
+  int64_t held_since_us_ = 0;
+  uint32_t depth_ = 0; ///< Recursive locks: hold counts from the outermost
+};
+
+template <typename Fn> void LockRegistry::for_each(Fn &&fn) {
+  LockGuard lock(mutex_);
+  for (const auto *entry : entries_) {
+    if (entry != nullptr) {
+      fn(entry->snapshot());
+    }
+  }
+}
+
+/// Default policy: counting with CONFIG_CORE_LOCK_STATS, else nothing
+using LockStatsPolicy =
+    std::conditional_t<kLockStats, CountingLockStats, NullLockStats>;
+
+/// Named lock with optional contention counters (drop-in for Lockable in
+/// LockGuard and UniqueLock)
+/// @tparam Lockable Mutex, RecursiveMutex or StaticMutex
+template <typename Lockable, typename Stats = LockStatsPolicy>
+class ProfiledLock {
+public:
+  explicit ProfiledLock(const char *name) : stats_(name) {}
+
+  ProfiledLock(const ProfiledLock &) = delete;
+  ProfiledLock &operator=(const ProfiledLock &) = delete;
+  ProfiledLock(ProfiledLock &&) = delete;
+  ProfiledLock &operator=(ProfiledLock &&) = delete;
+
+  [[nodiscard]] bool try_lock() {
+    if (!lock_.try_lock()) {
+      return false;
+    }
+    stats_.acquired(false, 0);
+    return true;
+  }
+
+  template <typename Rep, typename Period>
+  [[nodiscard]] bool try_lock_for(std::chrono::duration<Rep, Period> timeout) {
+    if constexpr (Stats::kEnabled) {
+      if (try_lock()) {
+        return true;
+      }
+      int64_t start = esp_timer_get_time();
+      if (!lock_.try_lock_for(timeout)) {
+        return false;
+      }
+      stats_.acquired(true, start);
+      return true;
+    } else {
+      return lock_.try_lock_for(timeout);
+    }
+  }
+
+  void lock() {
+    if constexpr (Stats::kEnabled) {
+      if (try_lock()) {
+        return;
+      }
+      int64_t start = esp_timer_get_time();
+      lock_.lock();
+      stats_.acquired(true, start);
+    } else {
+      lock_.lock();
+    }
+  }
+
+  void unlock() {
+    stats_.released();
+    lock_.unlock();
+  }
+
+  [[nodiscard]] SemaphoreHandle_t native_handle() const {
+    return lock_.native_handle();
+  }
+
+private:
+  Lockable lock_;
+  [[no_unique_address]] Stats stats_;
+};
+
+} // namespace core
@@ -0,0 +1,237 @@
+/**
+ * @file metrics.hpp
+ * @brief Runtime counters, gauges and histograms for fleet telemetry
+ *
+ * Each layer updates the metric it owns in the one process-wide
+ * core::metrics() block: HttpClient the request count, latency and
+ * reconnects, TelemetryService the body bytes, the WiFi manager RSSI and
+ * retries, the sensor monitors their samples. The application reads the
+ * block periodically and uploads it with the telemetry (Metric* ids), so
+ * a slow device shows why without a serial console.
+ *
+ *   core::metrics().requests.add();
+ *   core::metrics().request_latency_ms.record(elapsed_ms);
+ *
+ *   auto snapshot = core::metrics().take(); // counters restart at 0
+ *
+ * Everything lives in static storage and is updated with relaxed atomics:
+ * any task may update, no lock is taken, nothing is allocated. Counters
+ * and histograms are per export period (take() resets them), gauges hold
+ * their last value.
+ */
+
+#pragma once
+
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+
+/// Monotonic count since the last take()
+class Counter {
+public:
+  void add(uint32_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+
+  [[nodiscard]] uint32_t value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+  /// Value so far, restarting at 0
+  [[nodiscard]] uint32_t take() {
+    return value_.exchange(0, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<uint32_t> value_{0};
+};
+
+/// Last value set
+class Gauge {
+public:
+  void set(int32_t value) {
+    value_.store(value, std::memory_order_relaxed);
+    valid_.store(true, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] int32_t value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+  /// False until the first set()
+  [[nodiscard]] bool valid() const {
+    return valid_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<int32_t> value_{0};
+  std::atomic<bool> valid_{false};
+};
+
+/// Summary of a Histogram period
+struct HistogramSummary {
+  uint32_t count = 0;
+  uint32_t p50 = 0; ///< Upper bound of the bucket holding the median
+  uint32_t p90 = 0;
+  uint32_t max = 0; ///< Largest value recorded
+};
+
+/// Counts per fixed bucket: value <= Bounds[i] lands in bucket i, larger
+/// values in an overflow bucket
+template <uint32_t... Bounds> class Histogram {
+  static_assert(sizeof...(Bounds) > 0, "A histogram needs bucket bounds");
+
+public:
+  static constexpr std::array<uint32_t, sizeof...(Bounds)> kBounds{Bounds...};
+  static constexpr size_t kBuckets = kBounds.size() + 1;
+
+  void record(uint32_t value) {
+    auto bucket = static_cast<size_t>(
+        std::lower_bound(kBounds.begin(), kBounds.end(), value) -
+        kBounds.begin());
+    counts_.at(bucket).fetch_add(1, std::memory_order_relaxed);
+    uint32_t max = max_.load(std::memory_order_relaxed);
+    while (value > max &&
+           !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  /// Summary so far, restarting empty
+  [[nodiscard]] HistogramSummary take() {
+    std::array<uint32_t, kBuckets> counts{};
+    HistogramSummary summary{};
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts.at(i) = counts_.at(i).exchange(0, std::memory_order_relaxed);
+      summary.count += counts.at(i);
+    }
+    summary.max = max_.exchange(0, std::memory_order_relaxed);
+    summary.p50 = percentile(counts, summary.count, 50, summary.max);
+    summary.p90 = percentile(counts, summary.count, 90, summary.max);
+    return summary;
+  }
+
+private:
+  [[nodiscard]] static uint32_t
+  percentile(const std::array<uint32_t, kBuckets> &counts, uint32_t total,
+             uint32_t pct, uint32_t max) {
+    if (total == 0) {
+      return 0;
+    }
+    uint32_t rank = ((total * pct) + 99) / 100;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < kBounds.size(); ++i) {
+      seen += counts.at(i);
+      if (seen >= rank) {
+        return std::min(kBounds.at(i), max);
+      }
+    }
+    return max; // Overflow bucket: the largest value is the best bound
+  }
+
+  std::array<std::atomic<uint32_t>, kBuckets> counts_{};
+  std::atomic<uint32_t> max_{0};
+};
+
+/// Request latency buckets, ms
+using LatencyHistogram = Histogram<50, 100, 200, 500, 1000, 2000, 5000, 10000>;
+
+/// Per-sensor sample counts of a period, by sensor id
+struct SampleCounts {
+  static constexpr size_t kMaxSensors = 8;
+
+  std::array<uint32_t, kMaxSensors> good{};
+  std::array<uint32_t, kMaxSensors> failed{};
+
+  void add(const SampleCounts &other) {
+    for (size_t i = 0; i < kMaxSensors; ++i) {
+      good.at(i) += other.good.at(i);
+      failed.at(i) += other.failed.at(i);
+    }
+  }
+};
+
+/// One export period of Metrics
+struct MetricsSnapshot {
+  static constexpr size_t kMaxSensors = SampleCounts::kMaxSensors;
+
+  std::array<uint32_t, kMaxSensors> samples{};
+  std::array<uint32_t, kMaxSensors> sample_errors{};
+  uint32_t telemetry_bytes = 0;
+  uint32_t requests = 0;
+  uint32_t request_retries = 0;
+  HistogramSummary request_latency_ms{};
+  uint32_t wifi_retries = 0;
+  int32_t wifi_rssi = 0;
+  bool wifi_rssi_valid = false;
+  uint32_t heap_min_free = 0;      ///< Lowest free heap since boot
+  uint32_t heap_largest_block = 0; ///< Largest allocatable block now
+};
+
+/// The metrics of the whole firmware
+///
+/// @thread_safety All methods are thread-safe; take() from one task.
+class Metrics {
+public:
+  static constexpr size_t kMaxSensors = MetricsSnapshot::kMaxSensors;
+
+  /// Good samples per sensor id (ids >= kMaxSensors are not counted)
+  void sample(size_t sensor_id, bool ok) {
+    if (sensor_id < kMaxSensors) {
+      (ok ? samples_ : sample_errors_).at(sensor_id).add();
+    }
+  }
+
+  Counter telemetry_bytes; ///< Telemetry request bodies handed to HTTP
+  Counter requests;        ///< HTTP requests that got a response
+  Counter request_retries; ///< Requests repeated on a fresh connection
+  LatencyHistogram request_latency_ms; ///< Request start to response
+  Counter wifi_retries;                ///< Reconnect attempts
+  Gauge wifi_rssi;                     ///< dBm at the last association
+
+  /// Sample counts since the last take(), restarting at 0 (a duty-cycled
+  /// application keeps them in RTC memory over a wake that doesn't export)
+  [[nodiscard]] SampleCounts take_samples() {
+    SampleCounts out;
+    for (size_t i = 0; i < kMaxSensors; ++i) {
+      out.good.at(i) = samples_.at(i).take();
+      out.failed.at(i) = sample_errors_.at(i).take();
+    }
+    return out;
+  }
+
+  /// Everything since the last take(), the heap read now
+  [[nodiscard]] MetricsSnapshot take() {
+    MetricsSnapshot out;
+    auto counts = take_samples();
+    out.samples = counts.good;
+    out.sample_errors = counts.failed;
+    out.telemetry_bytes = telemetry_bytes.take();
+    out.requests = requests.take();
+    out.request_retries = request_retries.take();
+    out.request_latency_ms = request_latency_ms.take();
+    out.wifi_retries = wifi_retries.take();
+    out.wifi_rssi = wifi_rssi.value();
+    out.wifi_rssi_valid = wifi_rssi.valid();
+    out.heap_min_free = static_cast<uint32_t>(
+        heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+    out.heap_largest_block = static_cast<uint32_t>(
+        heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+    return out;
+  }
+
+private:
+  std::array<Counter, kMaxSensors> samples_{};
+  std::array<Counter, kMaxSensors> sample_errors_{};
+};
+
+/// The process-wide metrics
+[[nodiscard]] inline Metrics &metrics() {
+  static Metrics metrics;
+  return metrics;
+}
+
+} // namespace core
@@ -75,6 +75,42 @@ private:
   SemaphoreHandle_t handle_;
 };
 
+/// Mutex in its own static storage (no heap; not movable)
+class StaticMutex {
+public:
+  StaticMutex() : handle_(xSemaphoreCreateMutexStatic(&buffer_)) {}
+
+  StaticMutex(const StaticMutex &) = delete;
+  StaticMutex &operator=(const StaticMutex &) = delete;
+  StaticMutex(StaticMutex &&) = delete;
+  StaticMutex &operator=(StaticMutex &&) = delete;
+
+  [[nodiscard]] bool try_lock() { return xSemaphoreTake(handle_, 0) == pdTRUE; }
+
+  template <typename Rep, typename Period>
+  [[nodiscard]] bool try_lock_for(std::chrono::duration<Rep, Period> timeout) {
+    auto ticks = pdMS_TO_TICKS(
+        std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
+    return xSemaphoreTake(handle_, ticks) == pdTRUE;
+  }
+
+  void lock() {
+    [[maybe_unused]] auto result = xSemaphoreTake(handle_, portMAX_DELAY);
+    assert(result == pdTRUE);
+  }
+
+  void unlock() {
+    [[maybe_unused]] auto result = xSemaphoreGive(handle_);
+    assert(result == pdTRUE);
+  }
+
+  [[nodiscard]] SemaphoreHandle_t native_handle() const { return handle_; }
+
+private:
+  StaticSemaphore_t buffer_{};
+  SemaphoreHandle_t handle_;
+};
+
 /// Recursive mutex (can be locked multiple times by same task)
 class RecursiveMutex {
 public:
@@ -12,21 +12,23 @@
 #include <nvs.h>
 #include <nvs_flash.h>
 
-#include <algorithm>
-#include <array>
 #include <cstring>
+#include <memory>
 
 namespace core {
 
 /// NVS limits
 namespace nvs {
 /// Maximum NVS key length (15 chars + null terminator)
-inline constexpr size_t MAX_KEY_LEN = 15;
+inline constexpr size_t MAX_KEY_LEN = StorageKey::MAX_LEN;
 /// Key buffer size (includes null terminator)
 inline constexpr size_t KEY_BUFFER_SIZE = MAX_KEY_LEN + 1;
 } // namespace nvs
 
 /// NVS-based storage implementation
+///
+/// StorageKey is null-terminated and length-checked, so keys go to the NVS
+/// API as they are.
 class NvsStorage final : public IStorage {
 public:
   ~NvsStorage() override {
@@ -55,61 +57,101 @@ public:
 
   [[nodiscard]] bool is_ready() const override { return handle_ != 0; }
 
-  [[nodiscard]] Result<size_t> get_blob_size(std::string_view key) override {
+  [[nodiscard]] Result<size_t> get_blob_size(StorageKey key) override {
     size_t size = 0;
-    if (auto err = nvs_get_blob(handle_, make_key(key).data(), nullptr, &size);
+    if (auto err = nvs_get_blob(handle_, key.c_str(), nullptr, &size);
         err != ESP_OK) {
       return Err(err);
     }
     return size;
   }
 
-  [[nodiscard]] Status get_blob(std::string_view key,
+  [[nodiscard]] Status get_blob(StorageKey key,
                                 std::span<uint8_t> buffer) override {
     size_t size = buffer.size();
     esp_err_t err =
-        nvs_get_blob(handle_, make_key(key).data(), buffer.data(), &size);
+        nvs_get_blob(handle_, key.c_str(), buffer.data(), &size);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
 
-  [[nodiscard]] Status set_blob(std::string_view key,
+  [[nodiscard]] Status set_blob(StorageKey key,
                                 std::span<const uint8_t> data) override {
     esp_err_t err =
-        nvs_set_blob(handle_, make_key(key).data(), data.data(), data.size());
+        nvs_set_blob(handle_, key.c_str(), data.data(), data.size());
     return (err == ESP_OK) ? Ok() : Err(err);
   }
 
-  [[nodiscard]] Result<size_t> get_string_size(std::string_view key) override {
+  [[nodiscard]] Result<size_t> get_string_size(StorageKey key) override {
     size_t size = 0;
-    if (auto err = nvs_get_str(handle_, make_key(key).data(), nullptr, &size);
+    if (auto err = nvs_get_str(handle_, key.c_str(), nullptr, &size);
         err != ESP_OK) {
       return Err(err);
     }
     return size;
   }
 
-  [[nodiscard]] Status get_string(std::string_view key,
+  [[nodiscard]] Status get_string(StorageKey key,
                                   std::span<char> buffer) override {
     size_t size = buffer.size();
     esp_err_t err =
-        nvs_get_str(handle_, make_key(key).data(), buffer.data(), &size);
+        nvs_get_str(handle_, key.c_str(), buffer.data(), &size);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
 
   /// @pre value must be null-terminated
-  [[nodiscard]] Status set_string(std::string_view key,
+  [[nodiscard]] Status set_string(StorageKey key,
                                   std::string_view value) override {
-    esp_err_t err = nvs_set_str(handle_, make_key(key).data(), value.data());
+    esp_err_t err = nvs_set_str(handle_, key.c_str(), value.data());
     return (err == ESP_OK) ? Ok() : Err(err);
   }
 
-  [[nodiscard]] bool contains(std::string_view key) override {
+  /// One NVS lookup per item: blobs and strings are read straight into
+  /// their capacity (NVS reports the stored length), with no size query
+  [[nodiscard]] Status get_many(std::span<StorageRead> items) override {
+    for (auto &item : items) {
+      size_t size = item.buffer.size();
+      esp_err_t err = ESP_OK;
+      const char *key = item.key.c_str();
+      switch (item.type) {
+      case StorageType::I8:
+        err = get_scalar(key, item, nvs_get_i8);
+        break;
+      case StorageType::U8:
+        err = get_scalar(key, item, nvs_get_u8);
+        break;
+      case StorageType::I16:
+        err = get_scalar(key, item, nvs_get_i16);
+        break;
+      case StorageType::U16:
+        err = get_scalar(key, item, nvs_get_u16);
+        break;
+      case StorageType::I32:
+        err = get_scalar(key, item, nvs_get_i32);
+        break;
+      case StorageType::U32:
+        err = get_scalar(key, item, nvs_get_u32);
+        break;
+      case StorageType::Blob:
+        err = nvs_get_blob(handle_, key, item.buffer.data(), &size);
+        break;
+      case StorageType::String:
+        err = nvs_get_str(handle_, key,
+                          reinterpret_cast<char *>(item.buffer.data()), &size);
+        break;
+      }
+      item.error = err;
+      item.size = (err == ESP_OK) ? size : 0;
+    }
+    return Ok();
+  }
+
+  [[nodiscard]] bool contains(StorageKey key) override {
     nvs_type_t type{};
-    return nvs_find_key(handle_, make_key(key).data(), &type) == ESP_OK;
+    return nvs_find_key(handle_, key.c_str(), &type) == ESP_OK;
   }
 
-  [[nodiscard]] Status erase(std::string_view key) override {
-    esp_err_t err = nvs_erase_key(handle_, make_key(key).data());
+  [[nodiscard]] Status erase(StorageKey key) override {
+    esp_err_t err = nvs_erase_key(handle_, key.c_str());
     return (err == ESP_OK) ? Ok() : Err(err);
   }
 
@@ -127,77 +169,77 @@ public:
   }
 
 protected:
-  Result<int8_t> get_i8(std::string_view key) override {
+  Result<int8_t> get_i8(StorageKey key) override {
     int8_t val{};
-    if (auto err = nvs_get_i8(handle_, make_key(key).data(), &val);
+    if (auto err = nvs_get_i8(handle_, key.c_str(), &val);
         err != ESP_OK) {
       return Err(err);
     }
     return val;
   }
-  Result<uint8_t> get_u8(std::string_view key) override {
+  Result<uint8_t> get_u8(StorageKey key) override {
     uint8_t val{};
-    if (auto err = nvs_get_u8(handle_, make_key(key).data(), &val);
+    if (auto err = nvs_get_u8(handle_, key.c_str(), &val);
         err != ESP_OK) {
       return Err(err);
     }
     return val;
   }
-  Result<int16_t> get_i16(std::string_view key) override {
+  Result<int16_t> get_i16(StorageKey key) override {
     int16_t val{};
-    if (auto err = nvs_get_i16(handle_, make_key(key).data(), &val);
+    if (auto err = nvs_get_i16(handle_, key.c_str(), &val);
         err != ESP_OK) {
       return Err(err);
     }
     return val;
   }
-  Result<uint16_t> get_u16(std::string_view key) override {
+  Result<uint16_t> get_u16(StorageKey key) override {
     uint16_t val{};
-    if (auto err = nvs_get_u16(handle_, make_key(key).data(), &val);
+    if (auto err = nvs_get_u16(handle_, key.c_str(), &val);
         err != ESP_OK) {
       return Err(err);
     }
     return val;
   }
-  Result<int32_t> get_i32(std::string_view key) override {
+  Result<int32_t> get_i32(StorageKey key) override {
     int32_t val{};
-    if (auto err = nvs_get_i32(handle_, make_key(key).data(), &val);
+    if (auto err = nvs_get_i32(handle_, key.c_str(), &val);
         err != ESP_OK) {
       return Err(err);
     }
     return val;
   }
-  Result<uint32_t> get_u32(std::string_view key) override {
+  Result<uint32_t> get_u32(StorageKey key) override {
     uint32_t val{};
-    if (auto err = nvs_get_u32(handle_, make_key(key).data(), &val);
+    if (auto err = nvs_get_u32(handle_, key.c_str(), &val);
         err != ESP_OK) {
       return Err(err);
     }
     return val;
   }
 
-  Status set_i8(std::string_view key, int8_t value) override {
-    esp_err_t err = nvs_set_i8(handle_, make_key(key).data(), value);
+  Status set_i8(StorageKey key, int8_t value) override {
+    esp_err_t err = nvs_set_i8(handle_, key.c_str(), value);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
-  Status set_u8(std::string_view key, uint8_t value) override {
-    esp_err_t err = nvs_set_u8(handle_, make_key(key).data(), value);
+  Status set_u8(StorageKey key, uint8_t value) override {
+    esp_err_t err = nvs_set_u8(handle_, key.c_str(), value);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
-  Status set_i16(std::string_view key, int16_t value) override {
-    esp_err_t err = nvs_set_i16(handle_, make_key(key).data(), value);
+  Status set_i16(StorageKey key, int16_t value) override {
+    esp_err_t err = nvs_set_i16(handle_, key.c_str(), value);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
-  Status set_u16(std::string_view key, uint16_t value) override {
-    esp_err_t err = nvs_set_u16(handle_, make_key(key).data(), value);
+  Status set_u16(StorageKey key, uint16_t value) override {
+    esp_err_t err = nvs_set_u16(handle_, key.c_str(), value);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
-  Status set_i32(std::string_view key, int32_t value) override {
-    esp_err_t err = nvs_set_i32(handle_, make_key(key).data(), value);
+  Status set_i32(StorageKey key, int32_t value) override {
+    esp_err_t err = nvs_set_i32(handle_, key.c_str(), value);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
-  Status set_u32(std::string_view key, uint32_t value) override {
-    esp_err_t err = nvs_set_u32(handle_, make_key(key).data(), value);
+  Status set_u32(StorageKey key, uint32_t value) override {
+    esp_err_t err = nvs_set_u32(handle_, key.c_str(), value);
     return (err == ESP_OK) ? Ok() : Err(err);
   }
 
@@ -206,10 +248,18 @@ private:
 
   explicit NvsStorage(nvs_handle_t handle) : handle_(handle) {}
 
-  static std::array<char, nvs::KEY_BUFFER_SIZE> make_key(std::string_view key) {
-    std::array<char, nvs::KEY_BUFFER_SIZE> buf{};
-    std::memcpy(buf.data(), key.data(), std::min(key.size(), nvs::MAX_KEY_LEN));
-    return buf;
+  template <typename T>
+  esp_err_t get_scalar(const char *key, StorageRead &item,
+                       esp_err_t (*read)(nvs_handle_t, const char *, T *)) {
+    if (item.buffer.size() != sizeof(T)) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+    T value{};
+    esp_err_t err = read(handle_, key, &value);
+    if (err == ESP_OK) {
+      std::memcpy(item.buffer.data(), &value, sizeof(T));
+    }
+    return err;
   }
 
   nvs_handle_t handle_ = 0;
@@ -273,6 +323,16 @@ public:
     }
   }
 
+  /// Erase the whole NVS partition (all namespaces) and re-init it
+  [[nodiscard]] Status format() override {
+    initialized_ = false;
+    if (esp_err_t err = nvs_flash_erase_partition(NVS_DEFAULT_PART_NAME);
+        err != ESP_OK) {
+      return Err(err);
+    }
+    return init();
+  }
+
 private:
   bool initialized_ = false;
 };
@@ -0,0 +1,166 @@
+/**
+ * @file pool.hpp
+ * @brief Fixed-block pools in static storage
+ *
+ * Objects that come and go with every request (response bodies, pooled
+ * handles) cut the heap into holes over weeks of uptime until the TLS
+ * handshake's large allocations no longer fit. A pool reserves all of its
+ * blocks up front, so what it hands out never touches the heap and the
+ * heap keeps the shape it had at boot:
+ *
+ * - BlockPool<Size, Count>: raw blocks, O(1) acquire and release
+ * - Pool<T, Count>: objects of T built in such blocks
+ *
+ * An exhausted pool returns null instead of falling back to the heap; the
+ * caller reports ESP_ERR_NO_MEM. Size pools for the peak in flight.
+ *
+ *   core::Pool<Job, 4> jobs;
+ *   auto job = jobs.make(args...); // core::Pool<Job, 4>::Ptr, null if full
+ */
+
+#pragma once
+
+#include "mutex.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace core {
+
+/// Count blocks of BlockSize bytes in one static array
+///
+/// @thread_safety All methods are thread-safe (not ISR-safe).
+template <size_t BlockSize, size_t Count> class BlockPool {
+  static_assert(Count > 0, "A pool needs at least one block");
+
+public:
+  static constexpr size_t kAlign = alignof(std::max_align_t);
+  /// Bytes per block (BlockSize rounded up to kAlign)
+  static constexpr size_t kBlockSize =
+      ((std::max(BlockSize, sizeof(void *)) + kAlign - 1) / kAlign) * kAlign;
+
+  /// Returns a block to its pool
+  struct Release {
+    BlockPool *pool = nullptr;
+    void operator()(uint8_t *block) const { pool->release(block); }
+  };
+
+  /// Owned block (null if the pool was empty)
+  using Block = std::unique_ptr<uint8_t, Release>;
+
+  BlockPool() {
+    for (size_t i = 0; i < Count; ++i) {
+      push(block_at(i));
+    }
+  }
+
+  BlockPool(const BlockPool &) = delete;
+  BlockPool &operator=(const BlockPool &) = delete;
+  BlockPool(BlockPool &&) = delete;
+  BlockPool &operator=(BlockPool &&) = delete;
+
+  /// Take a block of kBlockSize bytes (contents undefined)
+  [[nodiscard]] Block acquire() {
+    LockGuard lock(mutex_);
+    if (free_ == nullptr) {
+      return Block(nullptr, Release{this});
+    }
+    auto *block = reinterpret_cast<uint8_t *>(free_);
+    free_ = free_->next;
+    --available_;
+    return Block(block, Release{this});
+  }
+
+  /// Give back a block taken with acquire().release()
+  void release(uint8_t *block) {
+    if (block != nullptr) {
+      LockGuard lock(mutex_);
+      push(block);
+    }
+  }
+
+  /// Blocks not handed out
+  [[nodiscard]] size_t available() {
+    LockGuard lock(mutex_);
+    return available_;
+  }
+
+  [[nodiscard]] static constexpr size_t capacity() { return Count; }
+
+private:
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  [[nodiscard]] uint8_t *block_at(size_t index) {
+    return storage_.data() + (index * kBlockSize);
+  }
+
+  void push(uint8_t *block) {
+    auto *node = new (block) FreeBlock{free_};
+    free_ = node;
+    ++available_;
+  }
+
+  alignas(kAlign) std::array<uint8_t, kBlockSize * Count> storage_{};
+  FreeBlock *free_ = nullptr;
+  size_t available_ = 0;
+  Mutex mutex_;
+};
+
+/// Up to Count objects of T in static storage
+///
+/// @thread_safety All methods are thread-safe (not ISR-safe).
+template <typename T, size_t Count> class Pool {
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "Over-aligned types are not supported");
+
+public:
+  /// Destroys the object and returns its block
+  struct Destroy {
+    Pool *pool = nullptr;
+    void operator()(T *object) const { pool->destroy(object); }
+  };
+
+  /// Owned object (null if the pool was full)
+  using Ptr = std::unique_ptr<T, Destroy>;
+
+  Pool() = default;
+
+  Pool(const Pool &) = delete;
+  Pool &operator=(const Pool &) = delete;
+  Pool(Pool &&) = delete;
+  Pool &operator=(Pool &&) = delete;
+
+  /// Build a T from args in a free block
+  template <typename... Args> [[nodiscard]] Ptr make(Args &&...args) {
+    auto block = blocks_.acquire();
+    if (!block) {
+      return Ptr(nullptr, Destroy{this});
+    }
+    T *object = new (block.release()) T(std::forward<Args>(args)...);
+    return Ptr(object, Destroy{this});
+  }
+
+  [[nodiscard]] size_t available() { return blocks_.available(); }
+  [[nodiscard]] static constexpr size_t capacity() { return Count; }
+
+private:
+  using Blocks = BlockPool<sizeof(T), Count>;
+
+  void destroy(T *object) {
+    if (object != nullptr) {
+      object->~T();
+      blocks_.release(reinterpret_cast<uint8_t *>(object));
+    }
+  }
+
+  Blocks blocks_;
+};
+
+} // namespace core
@@ -0,0 +1,413 @@
+/**
+ * @file record_log.hpp
+ * @brief Append-only, segment-based log of fixed-size records on LittleFS
+ *
+ * Records are `{T value; uint32_t crc}` (Crc32 of the value; T must have
+ * no padding). Appends are collected in a RAM sector buffer and written to
+ * flash one whole sector at a time, so each flash program covers a full
+ * sector instead of many small appends. Sectors go into segment files
+ * `<mount>/<name>_<seq>` of segment_sectors sectors each; once max_segments
+ * exist the oldest is deleted (ring buffer, oldest data lost first).
+ *
+ * Reading is two-phase: read() visits records from the persisted cursor
+ * without consuming them, consume() advances the cursor once the caller
+ * has processed them (e.g. after a successful upload). Segments behind the
+ * cursor are deleted. Slots that fail the CRC - sector padding, torn
+ * writes - are skipped.
+ *
+ * Records still in the RAM buffer are lost on a reset; flush() pads and
+ * writes a partial sector.
+ *
+ * Usage:
+ *   RecordLog<Sample> log({.name = "measurements_tlog"});
+ *   (void)log.init();
+ *   (void)log.append(sample);
+ *   auto slots = log.read(256, [](const Sample &s) { send(s); return true; });
+ *   if (slots && sent_ok) { (void)log.consume(*slots); }
+ */
+
+#pragma once
+
+#include "crc.hpp"
+#include "littlefs_storage.hpp"
+#include "result.hpp"
+
+#include <esp_log.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace core {
+
+/// Flash sector size the log aligns its writes to
+inline constexpr size_t FLASH_SECTOR_SIZE = 4096;
+
+/// RecordLog layout
+/// @note name must be NUL-terminated and outlive the log
+struct RecordLogConfig {
+  std::string_view name{"log"}; // File prefix under the LittleFS mount point
+  size_t segment_sectors{8};    // Sectors per segment file
+  size_t max_segments{20};      // Oldest segment dropped beyond this
+};
+
+/// Persistent FIFO of fixed-size, CRC-checked records
+///
+/// @tparam T Trivially copyable record payload
+/// @tparam SectorSize Write unit (bytes)
+/// @thread_safety Not thread-safe. Use from one task.
+template <typename T, size_t SectorSize = FLASH_SECTOR_SIZE> class RecordLog {
+public:
+  static_assert(std::is_trivially_copyable_v<T>, "Records are raw bytes");
+  static_assert(std::has_unique_object_representations_v<T>,
+                "CRC covers every byte of T: no padding, no floats");
+
+  struct Record {
+    T value;
+    uint32_t crc;
+  };
+
+  static constexpr size_t RECORD_SIZE = sizeof(Record);
+  static constexpr size_t RECORDS_PER_SECTOR = SectorSize / RECORD_SIZE;
+  static_assert(RECORDS_PER_SECTOR > 0, "Record larger than a sector");
+
+  explicit RecordLog(const RecordLogConfig &config) : config_(config) {}
+
+  RecordLog(const RecordLog &) = delete;
+  RecordLog &operator=(const RecordLog &) = delete;
+  RecordLog(RecordLog &&) = delete;
+  RecordLog &operator=(RecordLog &&) = delete;
+
+  /// Find existing segments and the saved read cursor
+  /// @pre LittleFS mounted at lfs::MOUNT_POINT
+  [[nodiscard]] Status init() {
+    DIR *dir = opendir(lfs::MOUNT_POINT);
+    if (dir == nullptr) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+
+    bool found = false;
+    uint32_t lowest = 0;
+    uint32_t highest = 0;
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+      uint32_t seq = 0;
+      if (entry->d_type == DT_REG && parse_segment(entry->d_name, seq)) {
+        lowest = found ? std::min(lowest, seq) : seq;
+        highest = found ? std::max(highest, seq) : seq;
+        found = true;
+      }
+    }
+    closedir(dir);
+
+    head_seq_ = lowest;
+    tail_seq_ = highest;
+    tail_sectors_ = 0;
+    if (found) {
+      size_t size = file_size(tail_seq_);
+      tail_sectors_ = size / SectorSize;
+      // A torn sector would misalign later appends: continue in a new file
+      if (size % SectorSize != 0 || tail_sectors_ >= config_.segment_sectors) {
+        ++tail_seq_;
+        tail_sectors_ = 0;
+      }
+    }
+
+    load_cursor();
+    ready_ = true;
+    ESP_LOGI(TAG, "%.*s: segments %" PRIu32 "..%" PRIu32 ", ~%zu pending",
+             static_cast<int>(config_.name.size()), config_.name.data(),
+             head_seq_, tail_seq_, pending());
+    return Ok();
+  }
+
+  [[nodiscard]] bool is_ready() const { return ready_; }
+
+  /// Buffer one record; writes a sector to flash when the buffer fills
+  [[nodiscard]] Status append(const T &value) {
+    if (!ready_) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+    Record record{.value = value, .crc = Crc32::compute(value)};
+    std::memcpy(sector_.data() + (buffered_ * RECORD_SIZE), &record,
+                RECORD_SIZE);
+    if (++buffered_ == RECORDS_PER_SECTOR) {
+      return write_sector();
+    }
+    return Ok();
+  }
+
+  /// Write buffered records now (pads the rest of the sector)
+  [[nodiscard]] Status flush() {
+    if (!ready_ || buffered_ == 0) {
+      return Ok();
+    }
+    return write_sector();
+  }
+
+  /// Record slots between the cursor and the end of the log, buffered
+  /// ones included (approximate: counts padding as well)
+  [[nodiscard]] size_t pending() const {
+    size_t full = (tail_seq_ - cursor_seq_) * config_.segment_sectors;
+    size_t slots = (full + tail_sectors_) * RECORDS_PER_SECTOR;
+    return slots - std::min<size_t>(slots, cursor_slot_) + buffered_;
+  }
+
+  [[nodiscard]] bool empty() const { return pending() == 0; }
+
+  /// Records overwritten before they were consumed
+  [[nodiscard]] size_t dropped() const { return dropped_; }
+
+  /// Visit up to max_records valid flushed records from the cursor
+  /// @param visit `bool(const T &)`; returning false stops before that
+  ///        record (it is not covered by the returned slots)
+  /// @return Slots covered (pass to consume()); invalid slots are skipped
+  ///         and counted
+  template <typename Visit>
+  [[nodiscard]] Result<size_t> read(size_t max_records, Visit &&visit) {
+    if (!ready_) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+
+    size_t slots = 0;
+    size_t records = 0;
+    uint32_t seq = cursor_seq_;
+    size_t slot = cursor_slot_;
+
+    while (records < max_records && seq <= tail_seq_) {
+      size_t end = segment_slots(seq);
+      if (slot < end) {
+        lfs::FileHandle file(path(seq).data(), "rb");
+        if (!file.valid() || !seek(file.get(), slot)) {
+          return Err(ESP_FAIL);
+        }
+        for (; slot < end && records < max_records; ++slot) {
+          if (slot % RECORDS_PER_SECTOR == 0 && !seek(file.get(), slot)) {
+            return Err(ESP_FAIL);
+          }
+          Record record{};
+          if (fread(&record, RECORD_SIZE, 1, file.get()) != 1) {
+            return Err(ESP_FAIL);
+          }
+          if (record.crc == Crc32::compute(record.value)) {
+            if (!visit(record.value)) {
+              return slots; // This record stays unread
+            }
+            ++records;
+          }
+          ++slots;
+        }
+      }
+      if (slot >= end) {
+        ++seq;
+        slot = 0;
+      }
+    }
+    return slots;
+  }
+
+  /// Advance the cursor past slots returned by read()
+  [[nodiscard]] Status consume(size_t slots) {
+    if (!ready_) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+
+    while (slots > 0 && cursor_seq_ <= tail_seq_) {
+      size_t end = segment_slots(cursor_seq_);
+      size_t step = std::min(slots, end - std::min(end, cursor_slot_));
+      cursor_slot_ += step;
+      slots -= step;
+      if (cursor_slot_ < end || cursor_seq_ == tail_seq_) {
+        break;
+      }
+      // Segment fully read: drop it
+      (void)remove(path(cursor_seq_).data());
+      ++cursor_seq_;
+      cursor_slot_ = 0;
+      head_seq_ = cursor_seq_;
+    }
+
+    // Everything read: start over in a fresh tail segment
+    if (cursor_seq_ == tail_seq_ && buffered_ == 0 &&
+        cursor_slot_ >= segment_slots(tail_seq_) && tail_sectors_ != 0) {
+      (void)remove(path(tail_seq_).data());
+      ++tail_seq_;
+      tail_sectors_ = 0;
+      cursor_seq_ = head_seq_ = tail_seq_;
+      cursor_slot_ = 0;
+    }
+
+    return save_cursor();
+  }
+
+private:
+  static constexpr const char *TAG = "RecordLog";
+  static constexpr size_t PATH_SIZE = lfs::MAX_PATH_LEN;
+
+  /// Persisted read position
+  struct Cursor {
+    uint32_t seq;
+    uint32_t slot;
+  };
+  static_assert(std::has_unique_object_representations_v<Cursor>);
+
+  using Path = std::array<char, PATH_SIZE>;
+
+  [[nodiscard]] Path path(uint32_t seq) const {
+    Path out{};
+    std::snprintf(out.data(), out.size(), "%s/%.*s_%08" PRIx32,
+                  lfs::MOUNT_POINT, static_cast<int>(config_.name.size()),
+                  config_.name.data(), seq);
+    return out;
+  }
+
+  [[nodiscard]] Path cursor_path() const {
+    Path out{};
+    std::snprintf(out.data(), out.size(), "%s/%.*s_cursor", lfs::MOUNT_POINT,
+                  static_cast<int>(config_.name.size()), config_.name.data());
+    return out;
+  }
+
+  /// "<name>_<8 hex digits>" -> seq
+  [[nodiscard]] bool parse_segment(const char *file, uint32_t &seq) const {
+    std::string_view name(file);
+    if (name.size() != config_.name.size() + 9 ||
+        !name.starts_with(config_.name) || name[config_.name.size()] != '_') {
+      return false;
+    }
+    uint32_t value = 0;
+    for (char c : name.substr(config_.name.size() + 1)) {
+      uint32_t digit = 0;
+      if (c >= '0' && c <= '9') {
+        digit = static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        digit = static_cast<uint32_t>(c - 'a' + 10);
+      } else {
+        return false;
+      }
+      value = (value << 4) | digit;
+    }
+    seq = value;
+    return true;
+  }
+
+  [[nodiscard]] size_t file_size(uint32_t seq) const {
+    struct stat st{};
+    if (stat(path(seq).data(), &st) != 0) {
+      return 0;
+    }
+    return static_cast<size_t>(st.st_size);
+  }
+
+  /// Record slots stored in a segment file
+  [[nodiscard]] size_t segment_slots(uint32_t seq) const {
+    size_t size = file_size(seq);
+    return ((size / SectorSize) * RECORDS_PER_SECTOR) +
+           std::min(RECORDS_PER_SECTOR, (size % SectorSize) / RECORD_SIZE);
+  }
+
+  [[nodiscard]] static bool seek(FILE *file, size_t slot) {
+    auto offset = ((slot / RECORDS_PER_SECTOR) * SectorSize) +
+                  ((slot % RECORDS_PER_SECTOR) * RECORD_SIZE);
+    return fseek(file, static_cast<long>(offset), SEEK_SET) == 0;
+  }
+
+  [[nodiscard]] Status write_sector() {
+    // Erased-flash pattern fails the CRC, so padding reads as empty slots
+    std::fill(sector_.begin() + static_cast<ptrdiff_t>(buffered_ * RECORD_SIZE),
+              sector_.end(), uint8_t{0xFF});
+
+    lfs::FileHandle file(path(tail_seq_).data(), "ab");
+    if (!file.valid()) {
+      return Err(ESP_ERR_NO_MEM);
+    }
+    size_t written = fwrite(sector_.data(), 1, SectorSize, file.get());
+    if (!file.close() || written != SectorSize) {
+      return Err(ESP_FAIL);
+    }
+    buffered_ = 0;
+
+    if (++tail_sectors_ == config_.segment_sectors) {
+      ++tail_seq_;
+      tail_sectors_ = 0;
+      drop_excess();
+    }
+    return Ok();
+  }
+
+  /// Keep at most max_segments files (full ones plus the open tail)
+  void drop_excess() {
+    while (tail_seq_ - head_seq_ >= config_.max_segments) {
+      if (cursor_seq_ == head_seq_) {
+        dropped_ += segment_slots(head_seq_) -
+                    std::min(segment_slots(head_seq_), cursor_slot_);
+        cursor_seq_ = head_seq_ + 1;
+        cursor_slot_ = 0;
+      }
+      (void)remove(path(head_seq_).data());
+      ++head_seq_;
+      ESP_LOGW(TAG, "Log full, dropped oldest segment");
+    }
+    if (cursor_seq_ < head_seq_) {
+      cursor_seq_ = head_seq_;
+      cursor_slot_ = 0;
+    }
+  }
+
+  void load_cursor() {
+    cursor_seq_ = head_seq_;
+    cursor_slot_ = 0;
+
+    struct Stored {
+      Cursor cursor;
+      uint32_t crc;
+    } stored{};
+    lfs::FileHandle file(cursor_path().data(), "rb");
+    if (!file.valid() || fread(&stored, sizeof(stored), 1, file.get()) != 1 ||
+        stored.crc != Crc32::compute(stored.cursor)) {
+      return;
+    }
+    if (stored.cursor.seq >= head_seq_ && stored.cursor.seq <= tail_seq_) {
+      cursor_seq_ = stored.cursor.seq;
+      cursor_slot_ = stored.cursor.slot;
+    }
+  }
+
+  [[nodiscard]] Status save_cursor() {
+    Cursor cursor{.seq = cursor_seq_,
+                  .slot = static_cast<uint32_t>(cursor_slot_)};
+    struct {
+      Cursor cursor;
+      uint32_t crc;
+    } stored{.cursor = cursor, .crc = Crc32::compute(cursor)};
+
+    lfs::FileHandle file(cursor_path().data(), "wb");
+    if (!file.valid()) {
+      return Err(ESP_ERR_NO_MEM);
+    }
+    size_t written = fwrite(&stored, sizeof(stored), 1, file.get());
+    return (file.close() && written == 1) ? Ok() : Err(ESP_FAIL);
+  }
+
+  RecordLogConfig config_;
+  std::array<uint8_t, SectorSize> sector_{};
+  size_t buffered_{0};
+  uint32_t head_seq_{0};    ///< Oldest segment on flash
+  uint32_t tail_seq_{0};    ///< Segment receiving sectors
+  size_t tail_sectors_{0};  ///< Sectors already in the tail segment
+  uint32_t cursor_seq_{0};  ///< Segment of the next unread slot
+  size_t cursor_slot_{0};   ///< Slot within cursor_seq_
+  size_t dropped_{0};
+  bool ready_{false};
+};
+
+} // namespace core
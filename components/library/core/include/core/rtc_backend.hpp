@@ -0,0 +1,286 @@
+/**
+ * @file rtc_backend.hpp
+ * @brief IStorage in RTC slow memory for state that only survives deep sleep
+ *
+ * A small fixed table of key/value entries in RTC memory (shared by all
+ * namespaces of the backend). Reads and writes are plain memory accesses -
+ * no flash wear, no commit latency - but everything is gone after a power
+ * loss or cold reset, so only route data here that can be rebuilt
+ * (AccessPattern::Volatile).
+ *
+ * Each entry carries a CRC over its contents: a zeroed (cold boot) or torn
+ * entry reads as free. Values are limited to rtc::KV_VALUE_SIZE bytes.
+ */
+
+#pragma once
+
+#include "crc.hpp"
+#include "result.hpp"
+#include "storage.hpp"
+#include "storage_backend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace core {
+
+namespace rtc {
+inline constexpr size_t KV_ENTRIES = 16;
+inline constexpr size_t KV_VALUE_SIZE = 32;
+
+/// One key/value slot
+struct KvEntry {
+  uint32_t crc;  ///< Over everything after this field; mismatch = free
+  uint8_t ns;    ///< NamespaceId
+  uint8_t size;  ///< Value bytes (strings include the NUL)
+  std::array<uint8_t, 2> reserved; ///< Keeps the CRC off padding bytes
+  std::array<char, StorageKey::MAX_LEN + 1> key;
+  std::array<uint8_t, KV_VALUE_SIZE> data;
+
+  [[nodiscard]] uint32_t compute_crc() const {
+    return Crc32::compute(std::span<const uint8_t>(
+        reinterpret_cast<const uint8_t *>(this) + sizeof(crc),
+        sizeof(KvEntry) - sizeof(crc)));
+  }
+  [[nodiscard]] bool is_valid() const { return crc == compute_crc(); }
+};
+static_assert(sizeof(KvEntry) == 56);
+
+/// Entry table (lives in RTC slow memory)
+struct KvArena {
+  std::array<KvEntry, KV_ENTRIES> entries;
+};
+
+/// The backend's RTC_DATA_ATTR arena (defined in core.cpp)
+[[nodiscard]] KvArena &kv_arena();
+} // namespace rtc
+
+/// RTC memory storage namespace
+///
+/// @thread_safety Not thread-safe (namespaces share one arena).
+class RtcStorage final : public IStorage {
+public:
+  RtcStorage(NamespaceId ns, rtc::KvArena &arena)
+      : ns_(static_cast<uint8_t>(ns)), arena_(arena) {}
+  ~RtcStorage() override = default;
+
+  RtcStorage(const RtcStorage &) = delete;
+  RtcStorage &operator=(const RtcStorage &) = delete;
+  RtcStorage(RtcStorage &&) = delete;
+  RtcStorage &operator=(RtcStorage &&) = delete;
+
+  [[nodiscard]] bool is_ready() const override { return true; }
+
+  [[nodiscard]] Result<size_t> get_blob_size(StorageKey key) override {
+    const auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    return static_cast<size_t>(entry->size);
+  }
+
+  [[nodiscard]] Status get_blob(StorageKey key,
+                                std::span<uint8_t> buffer) override {
+    const auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    if (buffer.size() > entry->size) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::copy_n(entry->data.begin(), buffer.size(), buffer.begin());
+    return Ok();
+  }
+
+  [[nodiscard]] Status set_blob(StorageKey key,
+                                std::span<const uint8_t> data) override {
+    return store(key, data, false);
+  }
+
+  [[nodiscard]] Result<size_t> get_string_size(StorageKey key) override {
+    return get_blob_size(key);
+  }
+
+  /// Buffer may be larger than the string (as with NVS)
+  [[nodiscard]] Status get_string(StorageKey key,
+                                  std::span<char> buffer) override {
+    const auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    if (buffer.size() < entry->size) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::copy_n(entry->data.begin(), entry->size, buffer.begin());
+    return Ok();
+  }
+
+  /// Stored with its null terminator
+  [[nodiscard]] Status set_string(StorageKey key,
+                                  std::string_view value) override {
+    return store(key,
+                 std::span<const uint8_t>(
+                     reinterpret_cast<const uint8_t *>(value.data()),
+                     value.size()),
+                 true);
+  }
+
+  [[nodiscard]] bool contains(StorageKey key) override {
+    return find(key) != nullptr;
+  }
+
+  [[nodiscard]] Status erase(StorageKey key) override {
+    auto *entry = find(key);
+    if (entry == nullptr) {
+      return Err(ESP_ERR_NOT_FOUND);
+    }
+    entry->crc = ~entry->crc;
+    return Ok();
+  }
+
+  [[nodiscard]] Status erase_all() override {
+    for (auto &entry : arena_.entries) {
+      if (entry.ns == ns_ && entry.is_valid()) {
+        entry.crc = ~entry.crc;
+      }
+    }
+    return Ok();
+  }
+
+  /// Writes take effect immediately
+  [[nodiscard]] Status commit() override { return Ok(); }
+
+protected:
+  Result<int8_t> get_i8(StorageKey key) override {
+    return get_scalar<int8_t>(key);
+  }
+  Result<uint8_t> get_u8(StorageKey key) override {
+    return get_scalar<uint8_t>(key);
+  }
+  Result<int16_t> get_i16(StorageKey key) override {
+    return get_scalar<int16_t>(key);
+  }
+  Result<uint16_t> get_u16(StorageKey key) override {
+    return get_scalar<uint16_t>(key);
+  }
+  Result<int32_t> get_i32(StorageKey key) override {
+    return get_scalar<int32_t>(key);
+  }
+  Result<uint32_t> get_u32(StorageKey key) override {
+    return get_scalar<uint32_t>(key);
+  }
+
+  Status set_i8(StorageKey key, int8_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u8(StorageKey key, uint8_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_i16(StorageKey key, int16_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u16(StorageKey key, uint16_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_i32(StorageKey key, int32_t value) override {
+    return set_scalar(key, value);
+  }
+  Status set_u32(StorageKey key, uint32_t value) override {
+    return set_scalar(key, value);
+  }
+
+private:
+  [[nodiscard]] rtc::KvEntry *find(StorageKey key) {
+    for (auto &entry : arena_.entries) {
+      if (entry.ns == ns_ && key.view() == entry.key.data() &&
+          entry.is_valid()) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  [[nodiscard]] Status store(StorageKey key, std::span<const uint8_t> value,
+                             bool terminate) {
+    size_t size = value.size() + (terminate ? 1 : 0);
+    if (size > rtc::KV_VALUE_SIZE) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    auto *entry = find(key);
+    if (entry == nullptr) {
+      auto free = std::ranges::find_if(
+          arena_.entries, [](const auto &e) { return !e.is_valid(); });
+      if (free == arena_.entries.end()) {
+        return Err(ESP_ERR_NO_MEM);
+      }
+      entry = &*free;
+    }
+
+    entry->ns = ns_;
+    entry->size = static_cast<uint8_t>(size);
+    entry->key.fill('\0');
+    std::copy_n(key.c_str(), key.size(), entry->key.begin());
+    entry->data.fill(0);
+    std::ranges::copy(value, entry->data.begin());
+    entry->crc = entry->compute_crc(); // Last: a torn write reads as free
+    return Ok();
+  }
+
+  template <typename T> Result<T> get_scalar(StorageKey key) {
+    T value{};
+    auto status =
+        get_blob(key, std::span<uint8_t>(reinterpret_cast<uint8_t *>(&value),
+                                         sizeof(T)));
+    if (!status) {
+      return Err(status.error());
+    }
+    return value;
+  }
+
+  template <typename T> Status set_scalar(StorageKey key, T value) {
+    return set_blob(
+        key, std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(&value),
+                                      sizeof(T)));
+  }
+
+  uint8_t ns_;
+  rtc::KvArena &arena_;
+};
+
+/// RTC memory storage backend
+class RtcBackend final : public IStorageBackend {
+public:
+  explicit RtcBackend(rtc::KvArena &arena = rtc::kv_arena())
+      : arena_(&arena) {}
+  ~RtcBackend() override = default;
+
+  RtcBackend(const RtcBackend &) = delete;
+  RtcBackend &operator=(const RtcBackend &) = delete;
+  RtcBackend(RtcBackend &&) = default;
+  RtcBackend &operator=(RtcBackend &&) = default;
+
+  [[nodiscard]] Status init() override { return Ok(); }
+  [[nodiscard]] bool is_ready() const override { return true; }
+  [[nodiscard]] BackendId id() const override { return BackendId::Rtc; }
+
+  [[nodiscard]] StoragePtr open_namespace(NamespaceId ns) override {
+    return std::make_unique<RtcStorage>(ns, *arena_);
+  }
+
+  void shutdown() override {}
+
+  [[nodiscard]] Status format() override {
+    *arena_ = {};
+    return Ok();
+  }
+
+private:
+  rtc::KvArena *arena_;
+};
+
+} // namespace core
@@ -0,0 +1,220 @@
+/**
+ * @file rtc_mirror.hpp
+ * @brief Flash backup of RTC values for cold boots (brownout, battery swap)
+ *
+ * RTC memory survives deep sleep but not a power loss. RtcMirror copies an
+ * RTC object (RtcValue, RtcString, RtcAuthToken, ...) into IStorage so a
+ * cold boot can restore it instead of starting over:
+ * - Lazy: sync() writes only when the object changed since the last sync.
+ * - Wear: records rotate over Slots keys ("<prefix>0".."<prefix>N-1"),
+ *   each tagged with a sequence number; restore() takes the newest record
+ *   that passes its CRC.
+ * - The mirror's cursor (sequence, slot, CRC of what was written) lives in
+ *   RTC memory next to the object, so wakes from deep sleep cost no flash
+ *   access at all; only a lost cursor makes it scan the slots.
+ * An object that became invalid (cleared, expired) erases its records, so
+ * a revoked token is not brought back on the next cold boot.
+ *
+ * Usage:
+ *   RTC_DATA_ATTR RtcAuthToken g_token;
+ *   RTC_DATA_ATTR RtcMirrorState g_token_mirror;
+ *
+ *   RtcMirror<RtcAuthToken> mirror(g_token, g_token_mirror, storage, "tok");
+ *   mirror.restore();  // at boot, before g_token is used
+ *   ...
+ *   mirror.sync();     // after g_token may have changed, before sleeping
+ */
+
+#pragma once
+
+#include "crc.hpp"
+#include "rtc_storage.hpp"
+#include "storage.hpp"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace core {
+
+/// Where the last mirrored record went
+struct RtcMirrorCursor {
+  uint32_t seq;     ///< Sequence number of the newest record
+  uint32_t slot;    ///< Slot holding it
+  uint32_t crc;     ///< CRC of the object as written
+  uint32_t written; ///< Non-zero if a valid record exists
+};
+
+/// RTC-resident cursor of an RtcMirror (place it with RTC_DATA_ATTR)
+using RtcMirrorState = RtcValue<RtcMirrorCursor>;
+
+/// Concept for RTC objects that can be mirrored
+template <typename T>
+concept RtcMirrorable =
+    std::is_trivially_copyable_v<T> && requires(const T &t, T &m) {
+      { t.is_valid() } -> std::convertible_to<bool>;
+      m.clear();
+    };
+
+/// Flash backup of one RTC object
+///
+/// @tparam T RTC object type
+/// @tparam Slots Keys the records rotate over
+/// @thread_safety Not thread-safe. Use from one task.
+template <RtcMirrorable T, size_t Slots = 4> class RtcMirror {
+public:
+  static_assert(Slots >= 1 && Slots <= 10, "Slot index is one digit");
+
+  /// Longest key prefix (one character is left for the slot digit)
+  static constexpr size_t MAX_PREFIX_LEN = StorageKey::MAX_LEN - 1;
+
+  /// @param object RTC object to back up
+  /// @param state RTC-resident cursor dedicated to this mirror
+  /// @param storage Backing store (must outlive the mirror)
+  /// @param prefix Key prefix, at most MAX_PREFIX_LEN characters
+  RtcMirror(T &object, RtcMirrorState &state, IStorage &storage,
+            std::string_view prefix)
+      : object_(object), state_(state), storage_(storage) {
+    size_t len = std::min(prefix.size(), MAX_PREFIX_LEN);
+    for (size_t i = 0; i < Slots; ++i) {
+      std::snprintf(names_[i].data(), names_[i].size(), "%.*s%zu",
+                    static_cast<int>(len), prefix.data(), i);
+    }
+  }
+
+  RtcMirror(const RtcMirror &) = delete;
+  RtcMirror &operator=(const RtcMirror &) = delete;
+  RtcMirror(RtcMirror &&) = delete;
+  RtcMirror &operator=(RtcMirror &&) = delete;
+
+  /// Bring the object back from flash if RTC memory lost it
+  /// @return true if the object was restored
+  bool restore() {
+    if (state_.is_valid()) {
+      return false; // RTC memory intact (deep sleep wake): nothing lost
+    }
+    return scan(!object_.is_valid());
+  }
+
+  /// Write the object if it changed since the last sync
+  [[nodiscard]] Status sync() {
+    if (!state_.is_valid()) {
+      (void)scan(false);
+    }
+    auto cursor = state_.get();
+
+    if (!object_.is_valid()) {
+      if (cursor.written == 0) {
+        return Ok();
+      }
+      return erase_records(cursor);
+    }
+
+    uint32_t crc = Crc32::compute(object_);
+    if (cursor.written != 0 && crc == cursor.crc) {
+      return Ok();
+    }
+
+    auto record = std::make_unique<Record>();
+    record->seq = cursor.seq + 1;
+    record->object = object_;
+    record->crc = Crc32::compute(record->seq, record->object);
+
+    uint32_t slot = cursor.written != 0 ? (cursor.slot + 1) % Slots : 0;
+    auto bytes = std::span<const uint8_t>(
+        reinterpret_cast<const uint8_t *>(record.get()), sizeof(Record));
+    if (auto status = storage_.set_blob(key(slot), bytes); !status) {
+      return status;
+    }
+    if (auto status = storage_.commit(); !status) {
+      return status;
+    }
+
+    state_.set({.seq = record->seq, .slot = slot, .crc = crc, .written = 1});
+    ESP_LOGD(TAG, "%s: record %lu", key(slot).c_str(),
+             static_cast<unsigned long>(record->seq));
+    return Ok();
+  }
+
+  /// Drop the flash copy (e.g. on factory reset)
+  [[nodiscard]] Status erase() {
+    auto cursor = state_.is_valid() ? state_.get() : RtcMirrorCursor{};
+    cursor.written = 1;
+    return erase_records(cursor);
+  }
+
+private:
+  static constexpr const char *TAG = "RtcMirror";
+
+  struct Record {
+    uint32_t seq;
+    uint32_t crc; ///< Over seq and object
+    T object;
+  };
+
+  [[nodiscard]] StorageKey key(size_t slot) const {
+    return *StorageKey::from(names_[slot].data());
+  }
+
+  /// Find the newest valid record; optionally copy it into the object
+  bool scan(bool load) {
+    auto record = std::make_unique<Record>();
+    RtcMirrorCursor cursor{};
+    bool loaded = false;
+
+    for (uint32_t slot = 0; slot < Slots; ++slot) {
+      auto bytes = std::span<uint8_t>(reinterpret_cast<uint8_t *>(record.get()),
+                                      sizeof(Record));
+      if (!storage_.get_blob(key(slot), bytes) ||
+          record->crc != Crc32::compute(record->seq, record->object) ||
+          !record->object.is_valid() ||
+          (cursor.written != 0 && record->seq <= cursor.seq)) {
+        continue;
+      }
+      cursor = {.seq = record->seq,
+                .slot = slot,
+                .crc = Crc32::compute(record->object),
+                .written = 1};
+      if (load) {
+        object_ = record->object;
+        loaded = true;
+      }
+    }
+
+    state_.set(cursor);
+    if (loaded) {
+      ESP_LOGI(TAG, "%s: restored record %lu from flash",
+               key(cursor.slot).c_str(), static_cast<unsigned long>(cursor.seq));
+    }
+    return loaded;
+  }
+
+  [[nodiscard]] Status erase_records(RtcMirrorCursor cursor) {
+    for (size_t slot = 0; slot < Slots; ++slot) {
+      if (auto status = storage_.erase(key(slot));
+          !status && !is_not_found(status.error())) {
+        return status;
+      }
+    }
+    if (auto status = storage_.commit(); !status) {
+      return status;
+    }
+    cursor.written = 0;
+    state_.set(cursor); // Keep seq so records never go backwards
+    return Ok();
+  }
+
+  T &object_;
+  RtcMirrorState &state_;
+  IStorage &storage_;
+  std::array<std::array<char, StorageKey::MAX_LEN + 1>, Slots> names_{};
+};
+
+} // namespace core
@@ -72,10 +72,11 @@ private:
 };
 
 /// RTC-stored blob with CRC validation
-struct RtcBlob {
+/// @tparam Capacity Maximum payload size (RTC memory is scarce - size to fit)
+template <size_t Capacity> struct RtcBlobT {
   uint32_t crc{0};
   uint16_t length{0};
-  std::array<uint8_t, rtc::MAX_VAR_DATA_SIZE> data{};
+  std::array<uint8_t, Capacity> data{};
 
   [[nodiscard]] bool is_valid() const {
     return length > 0 && crc == Crc32::compute(length, as_bytes());
@@ -91,6 +92,18 @@ struct RtcBlob {
     crc = Crc32::compute(length, as_bytes());
   }
 
+  /// Fill in place: write into buffer(), then commit() the length
+  /// Invalidates the blob until commit() so a torn write never validates.
+  [[nodiscard]] std::span<uint8_t> buffer() {
+    crc = 0;
+    return data;
+  }
+
+  void commit(size_t size) {
+    length = static_cast<uint16_t>(std::min(size, data.size()));
+    crc = Crc32::compute(length, as_bytes());
+  }
+
   void clear() {
     crc = 0;
     length = 0;
@@ -102,6 +115,9 @@ private:
   }
 };
 
+/// Default-capacity RTC blob
+using RtcBlob = RtcBlobT<rtc::MAX_VAR_DATA_SIZE>;
+
 /// RTC-stored scalar value with CRC validation
 template <CrcHashable T> struct RtcValue {
   uint32_t crc{0};
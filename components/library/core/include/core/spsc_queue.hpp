@@ -0,0 +1,112 @@
+/**
+ * @file spsc_queue.hpp
+ * @brief Lock-free single-producer/single-consumer ring buffer
+ *
+ * Fixed capacity, no heap allocation. One task (or timer callback) pushes,
+ * one other task pops. Neither side ever blocks on the other.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace core {
+
+/// Lock-free SPSC ring buffer
+///
+/// @tparam T Element type (copied in/out)
+/// @tparam Capacity Number of elements; must be a power of two
+///
+/// @thread_safety Safe for exactly one producer and one consumer.
+template <typename T, size_t Capacity> class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+public:
+  static constexpr size_t CAPACITY = Capacity;
+
+  SpscQueue() = default;
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+  SpscQueue(SpscQueue &&) = delete;
+  SpscQueue &operator=(SpscQueue &&) = delete;
+
+  /// Producer: reserve the next free slot for in-place writing
+  /// @return Slot pointer, or nullptr if the queue is full
+  /// @note Must be followed by commit() before the next reserve()
+  [[nodiscard]] T *reserve() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= CAPACITY) {
+      return nullptr;
+    }
+    return &slots_[head & MASK];
+  }
+
+  /// Producer: publish the slot returned by reserve()
+  void commit() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  /// Producer: copy element in
+  /// @return false if the queue is full (element dropped)
+  [[nodiscard]] bool push(const T &value) {
+    T *slot = reserve();
+    if (slot == nullptr) {
+      return false;
+    }
+    *slot = value;
+    commit();
+    return true;
+  }
+
+  /// Consumer: peek at the oldest element without removing it
+  /// @return Pointer to element, or nullptr if empty
+  [[nodiscard]] const T *front() const {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    if (head == tail) {
+      return nullptr;
+    }
+    return &slots_[tail & MASK];
+  }
+
+  /// Consumer: discard the element returned by front()
+  void pop() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  /// Consumer: copy oldest element out
+  [[nodiscard]] std::optional<T> try_pop() {
+    const T *item = front();
+    if (item == nullptr) {
+      return std::nullopt;
+    }
+    T value = *item;
+    pop();
+    return value;
+  }
+
+  /// Approximate number of queued elements (exact from either side)
+  [[nodiscard]] size_t size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+private:
+  static constexpr size_t MASK = Capacity - 1;
+
+  std::array<T, Capacity> slots_{};
+  std::atomic<size_t> head_{0}; // Written by producer only
+  std::atomic<size_t> tail_{0}; // Written by consumer only
+};
+
+} // namespace core
@@ -1,14 +1,22 @@
 /**
  * @file storage.hpp
  * @brief Storage abstraction with factory pattern
+ *
+ * Besides single-key accessors, IStorage takes batches (get_many /
+ * set_many) so boot-time reads of several keys can be served by a backend
+ * in one pass instead of a size query plus a read per key.
  */
 
 #pragma once
 
 #include "result.hpp"
+#include "storage_key.hpp"
+
+#include <nvs.h>
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <span>
 #include <string_view>
@@ -22,6 +30,87 @@ concept Storable = std::is_arithmetic_v<T> || std::is_enum_v<T>;
 
 class IStorage;
 
+/// True for the "no such key" codes of the backends (NVS and file based)
+[[nodiscard]] constexpr bool is_not_found(esp_err_t err) {
+  return err == ESP_ERR_NOT_FOUND || err == ESP_ERR_NVS_NOT_FOUND;
+}
+
+/// Value type of a batched read or write
+enum class StorageType : uint8_t { I8, U8, I16, U16, I32, U32, Blob, String };
+
+/// Batch element type for a scalar
+template <Storable T> constexpr StorageType storage_type_of() {
+  using U = std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+                               std::type_identity<T>>::type;
+  if constexpr (std::is_same_v<U, int8_t>) {
+    return StorageType::I8;
+  } else if constexpr (std::is_same_v<U, uint8_t>) {
+    return StorageType::U8;
+  } else if constexpr (std::is_same_v<U, int16_t>) {
+    return StorageType::I16;
+  } else if constexpr (std::is_same_v<U, uint16_t>) {
+    return StorageType::U16;
+  } else if constexpr (std::is_same_v<U, int32_t>) {
+    return StorageType::I32;
+  } else if constexpr (std::is_same_v<U, uint32_t>) {
+    return StorageType::U32;
+  } else {
+    static_assert(sizeof(T) == 0, "Unsupported type");
+  }
+}
+
+/// One key of a get_many() batch
+struct StorageRead {
+  StorageKey key;
+  StorageType type;
+  std::span<uint8_t> buffer; // Scalar: the value; blob/string: capacity
+  size_t size{0};            // Out: bytes read (strings include the null)
+  esp_err_t error{ESP_ERR_NOT_FOUND}; // Out: ESP_OK or why it failed
+
+  [[nodiscard]] bool found() const { return error == ESP_OK; }
+  [[nodiscard]] bool missing() const { return is_not_found(error); }
+
+  template <Storable T> static StorageRead value(StorageKey key, T &out) {
+    return {.key = key,
+            .type = storage_type_of<T>(),
+            .buffer = {reinterpret_cast<uint8_t *>(&out), sizeof(T)}};
+  }
+  static StorageRead blob(StorageKey key, std::span<uint8_t> buffer) {
+    return {.key = key, .type = StorageType::Blob, .buffer = buffer};
+  }
+  static StorageRead string(StorageKey key, std::span<char> buffer) {
+    return {.key = key,
+            .type = StorageType::String,
+            .buffer = {reinterpret_cast<uint8_t *>(buffer.data()),
+                       buffer.size()}};
+  }
+};
+
+/// One key of a set_many() batch
+struct StorageWrite {
+  StorageKey key;
+  StorageType type;
+  std::span<const uint8_t> data; // Strings: without the null, which must
+                                 // follow data in memory
+
+  template <Storable T>
+  static StorageWrite value(StorageKey key, const T &value) {
+    return {.key = key,
+            .type = storage_type_of<T>(),
+            .data = {reinterpret_cast<const uint8_t *>(&value), sizeof(T)}};
+  }
+  static StorageWrite blob(StorageKey key, std::span<const uint8_t> data) {
+    return {.key = key, .type = StorageType::Blob, .data = data};
+  }
+  /// @pre value must be null-terminated
+  static StorageWrite string(StorageKey key, std::string_view value) {
+    return {.key = key,
+            .type = StorageType::String,
+            .data = {reinterpret_cast<const uint8_t *>(value.data()),
+                     value.size()}};
+  }
+};
+
 /// RAII commit guard - commits on destruction
 class CommitGuard {
 public:
@@ -56,7 +145,7 @@ public:
   [[nodiscard]] virtual bool is_ready() const = 0;
 
   /// Get value by key
-  template <Storable T> [[nodiscard]] Result<T> get(std::string_view key) {
+  template <Storable T> [[nodiscard]] Result<T> get(StorageKey key) {
     if constexpr (std::is_same_v<T, int32_t>) {
       return get_i32(key);
     } else if constexpr (std::is_same_v<T, uint32_t>) {
@@ -82,7 +171,7 @@ public:
 
   /// Set value by key
   template <Storable T>
-  [[nodiscard]] Status set(std::string_view key, T value) {
+  [[nodiscard]] Status set(StorageKey key, T value) {
     if constexpr (std::is_same_v<T, int32_t>) {
       return set_i32(key, value);
     } else if constexpr (std::is_same_v<T, uint32_t>) {
@@ -106,40 +195,150 @@ public:
   /// Create RAII commit guard
   [[nodiscard]] CommitGuard auto_commit() { return CommitGuard(*this); }
 
-  [[nodiscard]] virtual Result<size_t> get_blob_size(std::string_view key) = 0;
-  [[nodiscard]] virtual Status get_blob(std::string_view key,
+  [[nodiscard]] virtual Result<size_t> get_blob_size(StorageKey key) = 0;
+  [[nodiscard]] virtual Status get_blob(StorageKey key,
                                         std::span<uint8_t> buffer) = 0;
-  [[nodiscard]] virtual Status set_blob(std::string_view key,
+  [[nodiscard]] virtual Status set_blob(StorageKey key,
                                         std::span<const uint8_t> data) = 0;
 
   [[nodiscard]] virtual Result<size_t>
-  get_string_size(std::string_view key) = 0;
-  [[nodiscard]] virtual Status get_string(std::string_view key,
+  get_string_size(StorageKey key) = 0;
+  [[nodiscard]] virtual Status get_string(StorageKey key,
                                           std::span<char> buffer) = 0;
-  [[nodiscard]] virtual Status set_string(std::string_view key,
+  [[nodiscard]] virtual Status set_string(StorageKey key,
                                           std::string_view value) = 0;
 
-  [[nodiscard]] virtual bool contains(std::string_view key) = 0;
-  [[nodiscard]] virtual Status erase(std::string_view key) = 0;
+  /// Read several keys in one call
+  ///
+  /// Each item reports its own outcome in StorageRead::error (a missing key
+  /// is not a batch failure). Backends override this to serve the batch in
+  /// one pass; the default reads the items one by one.
+  /// @return Ok once every item was attempted
+  [[nodiscard]] virtual Status get_many(std::span<StorageRead> items) {
+    for (auto &item : items) {
+      read_one(item);
+    }
+    return Ok();
+  }
+
+  /// Write several keys; stops at the first failure (commit() as usual)
+  [[nodiscard]] virtual Status set_many(std::span<const StorageWrite> items) {
+    for (const auto &item : items) {
+      if (auto status = write_one(item); !status) {
+        return status;
+      }
+    }
+    return Ok();
+  }
+
+  [[nodiscard]] virtual bool contains(StorageKey key) = 0;
+  [[nodiscard]] virtual Status erase(StorageKey key) = 0;
   [[nodiscard]] virtual Status erase_all() = 0;
   [[nodiscard]] virtual Status commit() = 0;
 
 protected:
   IStorage() = default;
 
-  virtual Result<int8_t> get_i8(std::string_view key) = 0;
-  virtual Result<uint8_t> get_u8(std::string_view key) = 0;
-  virtual Result<int16_t> get_i16(std::string_view key) = 0;
-  virtual Result<uint16_t> get_u16(std::string_view key) = 0;
-  virtual Result<int32_t> get_i32(std::string_view key) = 0;
-  virtual Result<uint32_t> get_u32(std::string_view key) = 0;
-
-  virtual Status set_i8(std::string_view key, int8_t value) = 0;
-  virtual Status set_u8(std::string_view key, uint8_t value) = 0;
-  virtual Status set_i16(std::string_view key, int16_t value) = 0;
-  virtual Status set_u16(std::string_view key, uint16_t value) = 0;
-  virtual Status set_i32(std::string_view key, int32_t value) = 0;
-  virtual Status set_u32(std::string_view key, uint32_t value) = 0;
+  /// Single-key read of a batch item through the virtual accessors
+  void read_one(StorageRead &item) {
+    auto scalar = [&]<typename T>(T) {
+      if (item.buffer.size() != sizeof(T)) {
+        item.error = ESP_ERR_INVALID_SIZE;
+        return;
+      }
+      auto result = get<T>(item.key);
+      item.error = result ? ESP_OK : result.error();
+      if (result) {
+        T value = *result;
+        std::memcpy(item.buffer.data(), &value, sizeof(T));
+        item.size = sizeof(T);
+      }
+    };
+    auto bytes = [&](Result<size_t> size, auto read) {
+      if (!size) {
+        item.error = size.error();
+      } else if (*size > item.buffer.size()) {
+        item.error = ESP_ERR_INVALID_SIZE;
+      } else {
+        auto status = read(*size);
+        item.error = status ? ESP_OK : status.error();
+        item.size = status ? *size : 0;
+      }
+    };
+
+    switch (item.type) {
+    case StorageType::I8:
+      return scalar(int8_t{});
+    case StorageType::U8:
+      return scalar(uint8_t{});
+    case StorageType::I16:
+      return scalar(int16_t{});
+    case StorageType::U16:
+      return scalar(uint16_t{});
+    case StorageType::I32:
+      return scalar(int32_t{});
+    case StorageType::U32:
+      return scalar(uint32_t{});
+    case StorageType::Blob:
+      return bytes(get_blob_size(item.key), [&](size_t size) {
+        return get_blob(item.key, item.buffer.first(size));
+      });
+    case StorageType::String:
+      return bytes(get_string_size(item.key), [&](size_t size) {
+        return get_string(item.key,
+                          {reinterpret_cast<char *>(item.buffer.data()), size});
+      });
+    }
+    item.error = ESP_ERR_INVALID_ARG;
+  }
+
+  /// Single-key write of a batch item through the virtual accessors
+  [[nodiscard]] Status write_one(const StorageWrite &item) {
+    auto scalar = [&]<typename T>(T) -> Status {
+      if (item.data.size() != sizeof(T)) {
+        return Err(ESP_ERR_INVALID_SIZE);
+      }
+      T value{};
+      std::memcpy(&value, item.data.data(), sizeof(T));
+      return set<T>(item.key, value);
+    };
+
+    switch (item.type) {
+    case StorageType::I8:
+      return scalar(int8_t{});
+    case StorageType::U8:
+      return scalar(uint8_t{});
+    case StorageType::I16:
+      return scalar(int16_t{});
+    case StorageType::U16:
+      return scalar(uint16_t{});
+    case StorageType::I32:
+      return scalar(int32_t{});
+    case StorageType::U32:
+      return scalar(uint32_t{});
+    case StorageType::Blob:
+      return set_blob(item.key, item.data);
+    case StorageType::String:
+      return set_string(item.key,
+                        {reinterpret_cast<const char *>(item.data.data()),
+                         item.data.size()});
+    }
+    return Err(ESP_ERR_INVALID_ARG);
+  }
+
+  virtual Result<int8_t> get_i8(StorageKey key) = 0;
+  virtual Result<uint8_t> get_u8(StorageKey key) = 0;
+  virtual Result<int16_t> get_i16(StorageKey key) = 0;
+  virtual Result<uint16_t> get_u16(StorageKey key) = 0;
+  virtual Result<int32_t> get_i32(StorageKey key) = 0;
+  virtual Result<uint32_t> get_u32(StorageKey key) = 0;
+
+  virtual Status set_i8(StorageKey key, int8_t value) = 0;
+  virtual Status set_u8(StorageKey key, uint8_t value) = 0;
+  virtual Status set_i16(StorageKey key, int16_t value) = 0;
+  virtual Status set_u16(StorageKey key, uint16_t value) = 0;
+  virtual Status set_i32(StorageKey key, int32_t value) = 0;
+  virtual Status set_u32(StorageKey key, uint32_t value) = 0;
 };
 
 inline CommitGuard::~CommitGuard() {
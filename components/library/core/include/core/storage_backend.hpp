@@ -16,7 +16,7 @@
 namespace core {
 
 /// Backend type identifier (compile-time, no string overhead)
-enum class BackendId : uint8_t { Nvs, LittleFs, Spiffs, SdCard, Count };
+enum class BackendId : uint8_t { Nvs, LittleFs, Spiffs, SdCard, Rtc, Count };
 
 /// Storage namespace identifier (define app-specific ones in config)
 enum class NamespaceId : uint8_t {
@@ -25,6 +25,7 @@ enum class NamespaceId : uint8_t {
   Wifi,
   Measurements,
   Cloud,
+  Session, ///< Deep-sleep-only state (see AccessPattern::Volatile)
   Count
 };
 
@@ -55,6 +56,12 @@ public:
   /// Shutdown the backend (unmount, close handles, etc.)
   virtual void shutdown() = 0;
 
+  /// Erase everything the backend stores in one go (bulk partition erase)
+  /// @note Namespaces opened before are invalidated (reopen them); the
+  ///       backend itself is ready again afterwards
+  /// @return ESP_ERR_NOT_SUPPORTED if it can only erase key by key
+  [[nodiscard]] virtual Status format() { return Err(ESP_ERR_NOT_SUPPORTED); }
+
 protected:
   IStorageBackend() = default;
 };
@@ -74,6 +81,8 @@ constexpr const char *namespace_name(NamespaceId ns) {
     return "measurements";
   case NamespaceId::Cloud:
     return "cloud";
+  case NamespaceId::Session:
+    return "session";
   default:
     return "unk";
   }
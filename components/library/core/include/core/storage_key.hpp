@@ -0,0 +1,88 @@
+/**
+ * @file storage_key.hpp
+ * @brief Validated, pre-hashed key for IStorage
+ *
+ * NVS limits keys to 15 characters and wants a null-terminated string.
+ * StorageKey is built from a string literal at compile time: the length is
+ * checked there (an oversized key doesn't compile), the literal already is
+ * null-terminated so backends pass it straight through, and an FNV-1a hash
+ * is computed once for the in-RAM indexes to compare against.
+ *
+ * Usage:
+ *   static constexpr core::StorageKey BOOTS{"boots"};
+ *   storage.set<uint32_t>(BOOTS, n);
+ *   storage.get<uint32_t>("boots");        // literal converts implicitly
+ *   storage.get<uint32_t>("far_too_long_key"); // compile error
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace core {
+
+namespace detail {
+/// Not constexpr: reaching it during constant evaluation is a compile error
+inline void storage_key_too_long() {}
+} // namespace detail
+
+/// Storage key (view of a null-terminated string of 1..MAX_LEN chars)
+class StorageKey {
+public:
+  /// NVS key limit (NVS_KEY_NAME_MAX_SIZE - 1)
+  static constexpr size_t MAX_LEN = 15;
+
+  /// Key from a string literal, validated at compile time
+  template <size_t N>
+  consteval StorageKey(const char (&literal)[N]) // NOLINT(*-explicit-*)
+      : data_(literal), size_(N - 1), hash_(fnv1a({literal, N - 1})) {
+    if (N < 2 || N - 1 > MAX_LEN) {
+      detail::storage_key_too_long();
+    }
+  }
+
+  /// Key checked at run time
+  /// @param key Null-terminated and outliving the key
+  /// @return nullopt if empty or longer than MAX_LEN
+  [[nodiscard]] static constexpr std::optional<StorageKey>
+  from(const char *key) {
+    std::string_view view(key);
+    if (view.empty() || view.size() > MAX_LEN) {
+      return std::nullopt;
+    }
+    return StorageKey(view);
+  }
+
+  [[nodiscard]] constexpr const char *c_str() const { return data_; }
+  [[nodiscard]] constexpr size_t size() const { return size_; }
+  [[nodiscard]] constexpr uint32_t hash() const { return hash_; }
+  [[nodiscard]] constexpr std::string_view view() const {
+    return {data_, size_};
+  }
+
+  [[nodiscard]] constexpr bool operator==(const StorageKey &other) const {
+    return hash_ == other.hash_ && view() == other.view();
+  }
+
+  /// 32-bit FNV-1a
+  [[nodiscard]] static constexpr uint32_t fnv1a(std::string_view s) {
+    uint32_t hash = 2166136261U;
+    for (char c : s) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;
+    }
+    return hash;
+  }
+
+private:
+  constexpr explicit StorageKey(std::string_view view)
+      : data_(view.data()), size_(view.size()), hash_(fnv1a(view)) {}
+
+  const char *data_;
+  size_t size_;
+  uint32_t hash_;
+};
+
+} // namespace core
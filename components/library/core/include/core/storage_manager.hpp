@@ -5,24 +5,58 @@
  * StorageManager coordinates multiple storage backends and routes
  * namespace requests to the appropriate backend based on configuration.
  * Uses enums for efficient embedded operation.
+ *
+ * Namespaces are normally routed by access pattern rather than to a named
+ * backend: StorageConfig::routes says which backend serves each pattern
+ * (hot keys -> cached NVS, bulk blobs -> LittleFS, volatile -> RTC memory)
+ * and route() files a namespace under one. Call sites keep opening
+ * namespaces; only the routing table decides where the bytes go. A key
+ * written before a namespace's route changed is moved over once with
+ * migrate_blob().
+ *
+ * Namespaces mapped with `cached = true` are wrapped in a CachedStorage:
+ * repeated reads come from RAM and writes are coalesced until commit(),
+ * commit_all() or the cache's flush timer.
  */
 
 #pragma once
 
+#include "cached_storage.hpp"
 #include "result.hpp"
+#include "rtc_backend.hpp"
 #include "storage.hpp"
 #include "storage_backend.hpp"
 
 #include <array>
 #include <cassert>
 #include <memory>
+#include <span>
+
+#include <esp_log.h>
 
 namespace core {
 
+/// How a namespace's data is accessed
+enum class AccessPattern : uint8_t {
+  Hot,      // Small keys read/written often (counters, credentials)
+  Bulk,     // Large blobs rewritten whole (BSEC state, logs)
+  Volatile, // Only has to survive deep sleep (session state)
+  Count
+};
+
+/// Backend serving one access pattern
+struct StorageRoute {
+  BackendId backend;
+  BackendId fallback{BackendId::Count}; // If backend is absent or not ready
+  bool cached{false};
+};
+
 /// Namespace to backend mapping entry
 struct NamespaceMapping {
   NamespaceId ns;
   BackendId backend;
+  bool cached{false}; // Put a write-back cache in front of the namespace
+  BackendId fallback{BackendId::Count}; // Count = none
 };
 
 /// Storage manager configuration
@@ -32,12 +66,32 @@ struct StorageConfig {
       mappings{};
   size_t mapping_count = 0;
 
+  /// Backend per access pattern (change before calling route())
+  std::array<StorageRoute, static_cast<size_t>(AccessPattern::Count)> routes{{
+      {.backend = BackendId::Nvs, .cached = true},
+      {.backend = BackendId::LittleFs, .fallback = BackendId::Nvs},
+      {.backend = BackendId::Rtc, .fallback = BackendId::Nvs},
+  }};
+
+  /// Settings shared by all cached namespaces
+  CacheConfig cache{};
+
   /// Add a mapping
-  constexpr void map(NamespaceId ns, BackendId backend) {
+  constexpr void map(NamespaceId ns, BackendId backend, bool cached = false,
+                     BackendId fallback = BackendId::Count) {
     if (mapping_count < mappings.size()) {
-      mappings.at(mapping_count++) = {.ns = ns, .backend = backend};
+      mappings.at(mapping_count++) = {.ns = ns,
+                                      .backend = backend,
+                                      .cached = cached,
+                                      .fallback = fallback};
     }
   }
+
+  /// Map a namespace to the backend serving its access pattern
+  constexpr void route(NamespaceId ns, AccessPattern pattern) {
+    const auto &r = routes.at(static_cast<size_t>(pattern));
+    map(ns, r.backend, r.cached, r.fallback);
+  }
 };
 
 /// Storage manager - coordinates multiple backends
@@ -69,8 +123,11 @@ public:
       auto ns_idx = static_cast<size_t>(mapping.ns);
       if (ns_idx < namespace_map_.size()) {
         namespace_map_.at(ns_idx) = mapping.backend;
+        fallback_map_.at(ns_idx) = mapping.fallback;
+        cached_.at(ns_idx) = mapping.cached;
       }
     }
+    cache_config_ = config.cache;
   }
 
   /// Initialize all backends
@@ -100,24 +157,85 @@ public:
       return *cached;
     }
 
-    // Find backend for this namespace
-    BackendId backend_id = namespace_map_.at(ns_idx);
-    auto backend_idx = static_cast<size_t>(backend_id);
-
-    assert(backend_idx < backends_.size() && "Invalid backend");
-    auto &backend = backends_.at(backend_idx);
+    // Find backend for this namespace (its fallback if it can't serve)
+    auto *backend = get_backend(namespace_map_.at(ns_idx));
+    if (backend == nullptr || !backend->is_ready()) {
+      auto *fallback = get_backend(fallback_map_.at(ns_idx));
+      if (fallback != nullptr && fallback->is_ready()) {
+        ESP_LOGW(TAG, "%s: backend unavailable, using fallback",
+                 namespace_name(ns));
+        backend = fallback;
+      }
+    }
     assert(backend != nullptr && "Backend not registered");
 
     // Open namespace on backend
     auto storage = backend->open_namespace(ns);
     assert(storage != nullptr && "Failed to open namespace");
+    if (cached_.at(ns_idx)) {
+      storage = std::make_unique<CachedStorage>(std::move(storage),
+                                                cache_config_);
+    }
 
     auto &ref = *storage;
     cached = std::move(storage);
     return ref;
   }
 
-  /// Commit all open namespaces
+  /// Move a blob left on the backend that served a namespace before its
+  /// route changed (read through once, then erased there)
+  ///
+  /// Nothing happens when the namespace already has the key, the old
+  /// backend doesn't, or the namespace is served by the old backend
+  /// itself (its new one unavailable).
+  /// @tparam MaxSize Largest blob moved (read into a stack buffer)
+  /// @return The old backend's read error or the new one's write error;
+  ///         the old copy is kept then and the move retried next time
+  template <size_t MaxSize>
+  [[nodiscard]] Status migrate_blob(NamespaceId ns, BackendId from,
+                                    StorageKey key) {
+    auto *primary = get_backend(namespace_map_.at(static_cast<size_t>(ns)));
+    auto *legacy = get_backend(from);
+    if (primary == nullptr || !primary->is_ready() || primary == legacy ||
+        legacy == nullptr || !legacy->is_ready()) {
+      return Ok();
+    }
+    auto &storage = open(ns);
+    if (storage.contains(key)) {
+      return Ok();
+    }
+    auto old = legacy->open_namespace(ns);
+    if (old == nullptr || !old->contains(key)) {
+      return Ok();
+    }
+
+    auto size = old->get_blob_size(key);
+    if (!size) {
+      return Err(size.error());
+    }
+    if (*size > MaxSize) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::array<uint8_t, MaxSize> buffer{};
+    std::span data(buffer.data(), *size);
+    if (auto status = old->get_blob(key, data); !status) {
+      return status;
+    }
+    if (auto status = storage.set_blob(key, data); !status) {
+      return status;
+    }
+    if (auto status = storage.commit(); !status) {
+      return status;
+    }
+    ESP_LOGI(TAG, "%s: moved %zu byte(s) to the new backend",
+             namespace_name(ns), *size);
+    if (auto status = old->erase(key); !status) {
+      return status; // Not read again: the namespace has the key now
+    }
+    return old->commit();
+  }
+
+  /// Commit all open namespaces (flushes caches; call before deep sleep)
   void commit_all() {
     for (auto &storage : open_namespaces_) {
       if (storage != nullptr) {
@@ -126,6 +244,39 @@ public:
     }
   }
 
+  /// Wipe all stored data (factory reset)
+  ///
+  /// Formats each backend with one bulk erase; backends without format()
+  /// get erase_all() on each namespace mapped to them. Caches are flushed
+  /// first so no write-back lands after the wipe.
+  /// @note Meant to be followed by a restart: namespaces already open stay
+  ///       valid objects (other tasks may hold references) but their
+  ///       handles are dead, so they just fail until then
+  /// @return First error; the remaining backends are wiped regardless
+  [[nodiscard]] Status format_all() {
+    commit_all();
+
+    Status result = Ok();
+    for (auto &backend : backends_) {
+      if (backend == nullptr) {
+        continue;
+      }
+      auto status = backend->format();
+      if (!status && status.error() == ESP_ERR_NOT_SUPPORTED) {
+        status = erase_namespaces(backend->id());
+      }
+      if (!status) {
+        ESP_LOGE(TAG, "Wiping backend %u failed: %s",
+                 static_cast<unsigned>(backend->id()),
+                 esp_err_to_name(status.error()));
+        if (result) {
+          result = status;
+        }
+      }
+    }
+    return result;
+  }
+
   /// Shutdown all backends
   void shutdown() {
     for (auto &storage : open_namespaces_) {
@@ -146,6 +297,24 @@ public:
   }
 
 private:
+  static constexpr const char *TAG = "StorageManager";
+
+  /// Key-by-key wipe of the namespaces mapped to a backend
+  [[nodiscard]] Status erase_namespaces(BackendId id) {
+    for (size_t i = 0; i < namespace_map_.size(); ++i) {
+      if (namespace_map_.at(i) != id) {
+        continue;
+      }
+      auto &storage = open(static_cast<NamespaceId>(i));
+      if (auto status = storage.erase_all(); !status) {
+        return status;
+      }
+      if (auto status = storage.commit(); !status) {
+        return status;
+      }
+    }
+    return Ok();
+  }
   static constexpr size_t kMaxBackends = static_cast<size_t>(BackendId::Count);
   static constexpr size_t kMaxNamespaces =
       static_cast<size_t>(NamespaceId::Count);
@@ -154,6 +323,9 @@ private:
 
   std::array<StorageBackendPtr, kMaxBackends> backends_{};
   std::array<BackendId, kMaxNamespaces> namespace_map_{};
+  std::array<BackendId, kMaxNamespaces> fallback_map_{};
+  std::array<bool, kMaxNamespaces> cached_{};
+  CacheConfig cache_config_{};
   std::array<StoragePtr, kMaxNamespaces> open_namespaces_{};
 };
 
@@ -0,0 +1,222 @@
+/**
+ * @file storage_worker.hpp
+ * @brief Low-priority task that performs storage writes off the caller
+ *
+ * A flash write can stall for tens of milliseconds when it has to erase a
+ * sector. Producers running on timing-sensitive contexts (sensor tasks,
+ * timer callbacks) submit() a write instead: key and value are copied into
+ * a bounded FreeRTOS queue and the call returns at once. The worker task
+ * applies the writes in order and commits where asked.
+ *
+ * flush_and_wait() queues a fence and blocks until everything submitted
+ * before it is written - call it before deep sleep or a restart.
+ *
+ * Usage:
+ *   StorageWorker worker;
+ *   (void)worker.start();
+ *   (void)worker.submit(storage, StorageWrite::blob("state", bytes));
+ *   ...
+ *   (void)worker.flush_and_wait(std::chrono::seconds(2));
+ *
+ * @note The worker calls the IStorage from its own task; for backends
+ *       that aren't thread-safe, send every write of that namespace here
+ */
+
+#pragma once
+
+#include "mutex.hpp"
+#include "result.hpp"
+#include "semaphore.hpp"
+#include "storage.hpp"
+#include "task.hpp"
+
+#include <esp_log.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace core {
+
+/// Worker task settings
+struct StorageWorkerConfig {
+  /// A LittleFS write (file sync, metadata commit) runs deeper than an NVS
+  /// set_blob; 3 KB left it no margin
+  uint32_t stack_size{4096};
+  UBaseType_t priority{1}; // Below sensors and networking
+};
+
+/// Queue-fed storage writer
+///
+/// @tparam Depth Requests queued at most
+/// @tparam MaxValue Largest value accepted (bytes, strings incl. the NUL)
+/// @thread_safety submit() and flush_and_wait() are thread-safe.
+template <size_t Depth = 4, size_t MaxValue = 256> class StorageWorkerT {
+public:
+  explicit StorageWorkerT(const StorageWorkerConfig &config = {})
+      : config_(config) {}
+
+  ~StorageWorkerT() {
+    task_.reset();
+    if (queue_ != nullptr) {
+      vQueueDelete(queue_);
+    }
+  }
+
+  StorageWorkerT(const StorageWorkerT &) = delete;
+  StorageWorkerT &operator=(const StorageWorkerT &) = delete;
+  StorageWorkerT(StorageWorkerT &&) = delete;
+  StorageWorkerT &operator=(StorageWorkerT &&) = delete;
+
+  /// Create the queue and the task
+  [[nodiscard]] Status start() {
+    if (task_) {
+      return Ok();
+    }
+    queue_ = xQueueCreate(Depth, sizeof(Request));
+    if (queue_ == nullptr) {
+      return Err(ESP_ERR_NO_MEM);
+    }
+    task_.emplace([this]() { run(); },
+                  TaskConfig{.name = "storage",
+                             .stack_size = config_.stack_size,
+                             .priority = config_.priority});
+    return Ok();
+  }
+
+  [[nodiscard]] bool is_running() const { return task_.has_value(); }
+
+  /// Queue a write (value copied; returns without touching flash)
+  /// @param commit Commit the namespace after this write
+  /// @return ESP_ERR_INVALID_SIZE if the value exceeds MaxValue,
+  ///         ESP_ERR_TIMEOUT if the queue is full, ESP_ERR_INVALID_STATE
+  ///         if the worker isn't running
+  [[nodiscard]] Status submit(IStorage &storage, const StorageWrite &write,
+                              bool commit = true) {
+    if (queue_ == nullptr) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+    // Strings keep room for the NUL that set_many() expects after the data
+    size_t needed =
+        write.data.size() + (write.type == StorageType::String ? 1 : 0);
+    if (needed > MaxValue) {
+      return Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    Request request{};
+    request.storage = &storage;
+    std::copy_n(write.key.c_str(), write.key.size(), request.key.begin());
+    request.type = write.type;
+    request.commit = commit;
+    request.size = static_cast<uint16_t>(write.data.size());
+    std::ranges::copy(write.data, request.data.begin()); // Rest stays 0
+
+    if (xQueueSend(queue_, &request, 0) != pdTRUE) {
+      ++dropped_;
+      return Err(ESP_ERR_TIMEOUT);
+    }
+    return Ok();
+  }
+
+  /// Block until everything submitted so far has been written
+  /// @return ESP_ERR_TIMEOUT if the worker didn't get there in time
+  template <typename Rep, typename Period>
+  [[nodiscard]] Status
+  flush_and_wait(std::chrono::duration<Rep, Period> timeout) {
+    if (queue_ == nullptr) {
+      return Ok();
+    }
+    LockGuard lock(flush_mutex_);
+
+    Request fence{};
+    fence.fence = ++fence_seq_;
+    auto ticks = pdMS_TO_TICKS(
+        std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
+    if (xQueueSend(queue_, &fence, ticks) != pdTRUE) {
+      return Err(ESP_ERR_TIMEOUT);
+    }
+    // A late give from an earlier, timed-out fence must not count
+    while (fence_done_.load() < fence.fence) {
+      if (!done_.take_for(timeout)) {
+        return Err(ESP_ERR_TIMEOUT);
+      }
+    }
+    return Ok();
+  }
+
+  /// Writes rejected because the queue was full
+  [[nodiscard]] uint32_t dropped() const { return dropped_.load(); }
+  /// Writes the backend failed
+  [[nodiscard]] uint32_t failed() const { return failed_.load(); }
+
+private:
+  static constexpr const char *TAG = "StorageWorker";
+
+  struct Request {
+    IStorage *storage;
+    uint32_t fence; ///< Non-zero: no write, signal flush_and_wait()
+    std::array<char, StorageKey::MAX_LEN + 1> key;
+    StorageType type;
+    bool commit;
+    uint16_t size;
+    std::array<uint8_t, MaxValue> data;
+  };
+
+  [[noreturn]] void run() {
+    Request request{};
+    while (true) {
+      if (xQueueReceive(queue_, &request, portMAX_DELAY) != pdTRUE) {
+        continue;
+      }
+      if (request.fence != 0) {
+        fence_done_.store(request.fence);
+        done_.give();
+        continue;
+      }
+      apply(request);
+    }
+  }
+
+  void apply(const Request &request) {
+    auto key = StorageKey::from(request.key.data());
+    if (!key) {
+      ++failed_;
+      return;
+    }
+    std::array write{StorageWrite{
+        .key = *key,
+        .type = request.type,
+        .data = {request.data.data(), request.size},
+    }};
+    auto status = request.storage->set_many(write);
+    if (status && request.commit) {
+      status = request.storage->commit();
+    }
+    if (!status) {
+      ++failed_;
+      ESP_LOGW(TAG, "Writing %s failed: %s", request.key.data(),
+               esp_err_to_name(status.error()));
+    }
+  }
+
+  StorageWorkerConfig config_;
+  QueueHandle_t queue_{nullptr};
+  std::optional<Task> task_;
+  Mutex flush_mutex_;
+  BinarySemaphore done_;
+  uint32_t fence_seq_{0};
+  std::atomic<uint32_t> fence_done_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> failed_{0};
+};
+
+/// Default-sized worker (fits a BSEC state blob)
+using StorageWorker = StorageWorkerT<>;
+
+} // namespace core
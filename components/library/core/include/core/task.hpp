@@ -1,13 +1,21 @@
 /**
  * @file task.hpp
- * @brief RAII task wrapper for FreeRTOS
+ * @brief RAII task wrappers for FreeRTOS
+ *
+ * Task allocates its stack and TCB from the heap at creation; StaticTask
+ * holds them in the object, sized at compile time. Both report to the
+ * task registry (task_registry.hpp).
  */
 
 #pragma once
 
+#include "task_registry.hpp"
+
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
@@ -43,10 +51,12 @@ public:
           config.priority, &handle_, config.core_id);
     }
     assert(result == pdPASS && "Failed to create task");
+    task_registry().add(handle_, config.stack_size);
   }
 
   ~Task() {
     if (handle_ != nullptr) {
+      task_registry().remove(handle_);
       vTaskDelete(handle_);
     }
   }
@@ -62,6 +72,7 @@ public:
   Task &operator=(Task &&other) noexcept {
     if (this != &other) {
       if (handle_ != nullptr) {
+        task_registry().remove(handle_);
         vTaskDelete(handle_);
       }
       handle_ = other.handle_;
@@ -146,6 +157,7 @@ private:
     if (func != nullptr && static_cast<bool>(*func)) {
       (*func)();
     }
+    task_registry().remove(xTaskGetCurrentTaskHandle());
     vTaskDelete(nullptr);
   }
 
@@ -153,4 +165,74 @@ private:
   std::unique_ptr<Function> func_;
 };
 
+/// StaticTask configuration (the stack size is a template parameter)
+struct StaticTaskConfig {
+  const char *name = "static task";
+  UBaseType_t priority = 5;
+  BaseType_t core_id = tskNO_AFFINITY;
+};
+
+/// Task with its stack and TCB in the object: no heap allocation, and the
+/// memory shows up in the image's static DRAM use instead of at runtime
+///
+/// Keep it in static storage or a long-lived owner; it can't be moved.
+/// A function that returns leaves the task suspended (finished() true)
+/// until the destructor deletes it: a task that deleted itself would leave
+/// its TCB to the idle task's cleanup, after the buffers may be gone.
+/// @tparam StackSize Stack bytes
+template <uint32_t StackSize> class StaticTask {
+  static_assert(StackSize >= configMINIMAL_STACK_SIZE, "Stack too small");
+
+public:
+  using Function = std::function<void()>;
+
+  /// Create and start the task
+  explicit StaticTask(Function func, const StaticTaskConfig &config = {})
+      : func_(std::move(func)) {
+    handle_ = xTaskCreateStaticPinnedToCore(
+        task_trampoline, config.name, StackSize, this, config.priority,
+        stack_.data(), &tcb_, config.core_id);
+    assert(handle_ != nullptr && "Failed to create task");
+    task_registry().add(handle_, StackSize, true);
+  }
+
+  /// Delete the task (not from the task itself)
+  ~StaticTask() {
+    assert(xTaskGetCurrentTaskHandle() != handle_);
+    task_registry().remove(handle_);
+    vTaskDelete(handle_);
+  }
+
+  StaticTask(const StaticTask &) = delete;
+  StaticTask &operator=(const StaticTask &) = delete;
+  StaticTask(StaticTask &&) = delete;
+  StaticTask &operator=(StaticTask &&) = delete;
+
+  [[nodiscard]] static constexpr uint32_t stack_size() { return StackSize; }
+
+  /// The function returned
+  [[nodiscard]] bool finished() const { return finished_.load(); }
+
+  /// Get task name
+  [[nodiscard]] const char *name() const { return pcTaskGetName(handle_); }
+
+  [[nodiscard]] TaskHandle_t native_handle() const { return handle_; }
+
+private:
+  static void task_trampoline(void *param) {
+    auto *self = static_cast<StaticTask *>(param);
+    if (self->func_) {
+      self->func_();
+    }
+    self->finished_ = true;
+    vTaskSuspend(nullptr); // Deleted by the destructor
+  }
+
+  Function func_;
+  TaskHandle_t handle_ = nullptr;
+  std::atomic<bool> finished_{false};
+  StaticTask_t tcb_{};
+  std::array<StackType_t, StackSize / sizeof(StackType_t)> stack_;
+};
+
 } // namespace core
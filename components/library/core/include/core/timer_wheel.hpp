@@ -0,0 +1,428 @@
+/**
+ * @file timer_wheel.hpp
+ * @brief Timers on one shared esp_timer (hierarchical timing wheel)
+ *
+ * Every OneShotTimer and PeriodicTimer owns an esp_timer, and each armed
+ * one is a wakeup of its own. The wheel keeps its timers in four levels of
+ * 64 slots (10 ms ticks, up to 46 h ahead; longer delays wait at the top
+ * level and are placed again) and arms a single esp_timer for the nearest
+ * tick anything is due or moves down a level:
+ *
+ * - start and stop link or unlink a node in a slot list: O(1)
+ * - the node is part of the timer object, so starting allocates nothing
+ * - next_deadline() is the only timer wakeup for sleep planning
+ *
+ * Callbacks run on the esp_timer task, one at a time, like ESP_TIMER_TASK
+ * callbacks. Use the wheel for coarse timing (retries, polls, timeouts):
+ * a timer fires up to one tick late. Sensor sampling keeps OneShotTimer.
+ *
+ *   core::WheelPeriodicTimer poll{[this]() { poll_commands(); }};
+ *   (void)poll.start(std::chrono::seconds(30));
+ */
+
+#pragma once
+
+#include "mutex.hpp"
+#include "result.hpp"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+namespace core {
+
+/// Process-wide timing wheel (use through WheelOneShotTimer and
+/// WheelPeriodicTimer)
+///
+/// @thread_safety All methods are thread-safe.
+class TimerWheel {
+public:
+  static constexpr int64_t kTickUs = 10'000;
+  static constexpr size_t kLevelBits = 6;
+  static constexpr size_t kSlots = size_t{1} << kLevelBits;
+  static constexpr size_t kLevels = 4;
+  /// Ticks the wheel covers; later deadlines are re-placed from the top
+  static constexpr uint64_t kMaxDelta = (uint64_t{1}
+                                         << (kLevelBits * kLevels)) - 1;
+
+  /// A timer's place in the wheel (embedded in the timer object)
+  struct Node {
+    std::function<void()> callback;
+    Node *prev = nullptr;
+    Node *next = nullptr;
+    uint64_t expires = 0;      ///< Tick the callback is due
+    uint64_t period_ticks = 0; ///< 0: one shot
+    uint8_t level = 0;
+    uint8_t slot = 0;
+    bool linked = false;
+  };
+
+  static TimerWheel &instance() {
+    static TimerWheel wheel;
+    return wheel;
+  }
+
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+  TimerWheel(TimerWheel &&) = delete;
+  TimerWheel &operator=(TimerWheel &&) = delete;
+
+  /// (Re)start node: due after delay_us (at least one tick), then every
+  /// period_us if non-zero
+  void schedule(Node &node, int64_t delay_us, int64_t period_us = 0) {
+    LockGuard lock(mutex_);
+    if (node.linked) {
+      unlink(node);
+    }
+    int64_t now_time = now_us();
+    uint64_t now = static_cast<uint64_t>(now_time / kTickUs);
+    catch_up(now);
+    // First tick boundary at or after the deadline, never the current one
+    node.expires =
+        std::max(to_ticks(now_time + std::max<int64_t>(delay_us, 0)), now + 1);
+    node.period_ticks = period_us > 0 ? to_ticks(period_us) : 0;
+    link(node);
+    rearm();
+  }
+
+  /// Stop node; with wait, also for a callback of it still running on
+  /// another task (timer destruction)
+  void cancel(Node &node, bool wait = false) {
+    while (true) {
+      {
+        LockGuard lock(mutex_);
+        if (node.linked) {
+          unlink(node);
+        }
+        // The esp_timer stays armed: an early wake finds nothing due
+        if (!wait || firing_ != &node ||
+            firing_task_ == xTaskGetCurrentTaskHandle()) {
+          return;
+        }
+      }
+      vTaskDelay(1);
+    }
+  }
+
+  [[nodiscard]] bool is_scheduled(const Node &node) {
+    LockGuard lock(mutex_);
+    return node.linked;
+  }
+
+  /// Time until the wheel's esp_timer fires (nullopt: nothing scheduled)
+  [[nodiscard]] std::optional<std::chrono::microseconds> next_deadline() {
+    LockGuard lock(mutex_);
+    if (count_ == 0) {
+      return std::nullopt;
+    }
+    int64_t delay_us =
+        static_cast<int64_t>(next_event_tick()) * kTickUs - now_us();
+    return std::chrono::microseconds(std::max<int64_t>(delay_us, 0));
+  }
+
+  /// Timers scheduled
+  [[nodiscard]] size_t size() {
+    LockGuard lock(mutex_);
+    return count_;
+  }
+
+private:
+  static constexpr uint64_t kNever = UINT64_MAX;
+  static constexpr uint64_t kSlotMask = kSlots - 1;
+
+  TimerWheel() : current_(now_tick()) {
+    esp_timer_create_args_t args = {
+        .callback = on_timer,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "timer_wheel",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&args, &handle_);
+    assert(err == ESP_OK && "Failed to create timer");
+  }
+
+  ~TimerWheel() = default;
+
+  [[nodiscard]] static int64_t now_us() { return esp_timer_get_time(); }
+
+  [[nodiscard]] static uint64_t now_tick() {
+    return static_cast<uint64_t>(now_us() / kTickUs);
+  }
+
+  /// Rounded up: a timer never fires early
+  [[nodiscard]] static uint64_t to_ticks(int64_t us) {
+    return std::max<uint64_t>(
+        static_cast<uint64_t>((std::max<int64_t>(us, 0) + kTickUs - 1) /
+                              kTickUs),
+        1);
+  }
+
+  [[nodiscard]] Node *&head(size_t level, size_t slot) {
+    return slots_.at((level * kSlots) + slot);
+  }
+
+  /// Place node by its expiry relative to current_
+  void link(Node &node) {
+    uint64_t delta = node.expires > current_ ? node.expires - current_ : 0;
+    uint64_t pos = current_ + std::min(delta, kMaxDelta);
+    size_t level = 0;
+    while (level + 1 < kLevels &&
+           std::min(delta, kMaxDelta) >= (uint64_t{1} << (kLevelBits *
+                                                          (level + 1)))) {
+      ++level;
+    }
+    auto slot = static_cast<size_t>((pos >> (kLevelBits * level)) & kSlotMask);
+
+    Node *&first = head(level, slot);
+    node.prev = nullptr;
+    node.next = first;
+    if (first != nullptr) {
+      first->prev = &node;
+    }
+    first = &node;
+    node.level = static_cast<uint8_t>(level);
+    node.slot = static_cast<uint8_t>(slot);
+    node.linked = true;
+    occupied_.at(level) |= uint64_t{1} << slot;
+    ++count_;
+  }
+
+  void unlink(Node &node) {
+    Node *&first = head(node.level, node.slot);
+    if (node.prev != nullptr) {
+      node.prev->next = node.next;
+    } else {
+      first = node.next;
+    }
+    if (node.next != nullptr) {
+      node.next->prev = node.prev;
+    }
+    if (first == nullptr) {
+      occupied_.at(node.level) &= ~(uint64_t{1} << node.slot);
+    }
+    node.prev = nullptr;
+    node.next = nullptr;
+    node.linked = false;
+    --count_;
+  }
+
+  /// First tick after current_ that expires level 0 entries or cascades a
+  /// higher level's slot
+  [[nodiscard]] uint64_t next_event_tick() const {
+    uint64_t next = kNever;
+    for (size_t level = 0; level < kLevels; ++level) {
+      uint64_t bits = occupied_.at(level);
+      if (bits == 0) {
+        continue;
+      }
+      uint64_t base = current_ >> (kLevelBits * level);
+      // Bit j of rotated: the slot j + 1 steps ahead
+      auto shift = static_cast<int>((base + 1) & kSlotMask);
+      uint64_t steps =
+          static_cast<uint64_t>(std::countr_zero(std::rotr(bits, shift))) + 1;
+      next = std::min(next, (base + steps) << (kLevelBits * level));
+    }
+    return next;
+  }
+
+  /// Move current_ to now if nothing is due on the way
+  void catch_up(uint64_t now) {
+    if (now > current_ && head(0, current_ & kSlotMask) == nullptr &&
+        next_event_tick() > now) {
+      current_ = now;
+    }
+  }
+
+  /// Re-place the higher-level slots that reach their turn at current_
+  void cascade() {
+    for (size_t level = kLevels - 1; level > 0; --level) {
+      uint64_t low_bits = (uint64_t{1} << (kLevelBits * level)) - 1;
+      if ((current_ & low_bits) != 0) {
+        continue;
+      }
+      auto slot =
+          static_cast<size_t>((current_ >> (kLevelBits * level)) & kSlotMask);
+      Node *node = head(level, slot);
+      while (node != nullptr) {
+        Node *next = node->next;
+        unlink(*node);
+        link(*node);
+        node = next;
+      }
+    }
+  }
+
+  /// Unlink one callback due by now (re-linking a periodic one)
+  [[nodiscard]] Node *pop_due(uint64_t now) {
+    while (true) {
+      if (Node *node = head(0, current_ & kSlotMask); node != nullptr) {
+        unlink(*node);
+        if (node->period_ticks != 0) {
+          node->expires =
+              std::max(node->expires + node->period_ticks, now + 1);
+          link(*node);
+        }
+        return node;
+      }
+      if (current_ >= now) {
+        return nullptr;
+      }
+      uint64_t next = next_event_tick();
+      if (next > now) {
+        current_ = now;
+        return nullptr;
+      }
+      current_ = next;
+      cascade();
+    }
+  }
+
+  /// Arm the esp_timer for the next event (stop it if there is none)
+  void rearm() {
+    uint64_t next = count_ == 0 ? kNever : next_event_tick();
+    if (next == armed_tick_) {
+      return;
+    }
+    (void)esp_timer_stop(handle_);
+    armed_tick_ = next;
+    if (next != kNever) {
+      int64_t delay_us = (static_cast<int64_t>(next) * kTickUs) - now_us();
+      (void)esp_timer_start_once(handle_, std::max<int64_t>(delay_us, 0));
+    }
+  }
+
+  static void on_timer(void *arg) {
+    auto *self = static_cast<TimerWheel *>(arg);
+    uint64_t now = now_tick();
+    while (true) {
+      Node *node = nullptr;
+      {
+        LockGuard lock(self->mutex_);
+        self->firing_ = nullptr;
+        self->armed_tick_ = kNever; // Fired
+        node = self->pop_due(now);
+        if (node == nullptr) {
+          self->rearm();
+          return;
+        }
+        self->firing_ = node;
+        self->firing_task_ = xTaskGetCurrentTaskHandle();
+      }
+      if (node->callback) {
+        node->callback(); // Unlocked: it may restart or stop timers
+      }
+    }
+  }
+
+  Mutex mutex_;
+  esp_timer_handle_t handle_ = nullptr;
+  std::array<Node *, kLevels * kSlots> slots_{};
+  std::array<uint64_t, kLevels> occupied_{}; ///< Bit n: slot n non-empty
+  uint64_t current_;                        ///< Last tick processed
+  uint64_t armed_tick_ = kNever;
+  size_t count_ = 0;
+  Node *firing_ = nullptr; ///< Callback running now
+  TaskHandle_t firing_task_ = nullptr;
+};
+
+[[nodiscard]] inline TimerWheel &timer_wheel() {
+  return TimerWheel::instance();
+}
+
+/// OneShotTimer on the timer wheel
+class WheelOneShotTimer {
+public:
+  using Callback = std::function<void()>;
+
+  // Taking the wheel here constructs it first, so it outlives the timer
+  explicit WheelOneShotTimer(Callback callback) : wheel_(timer_wheel()) {
+    node_.callback = std::move(callback);
+  }
+
+  ~WheelOneShotTimer() { wheel_.cancel(node_, true); }
+
+  WheelOneShotTimer(const WheelOneShotTimer &) = delete;
+  WheelOneShotTimer &operator=(const WheelOneShotTimer &) = delete;
+  WheelOneShotTimer(WheelOneShotTimer &&) = delete;
+  WheelOneShotTimer &operator=(WheelOneShotTimer &&) = delete;
+
+  /// Fire once after delay (restarts a running timer)
+  template <typename Rep, typename Period>
+  Status start(std::chrono::duration<Rep, Period> delay) {
+    wheel_.schedule(
+        node_,
+        std::chrono::duration_cast<std::chrono::microseconds>(delay).count());
+    return Ok();
+  }
+
+  Status stop() {
+    wheel_.cancel(node_);
+    return Ok();
+  }
+
+  [[nodiscard]] bool is_running() { return wheel_.is_scheduled(node_); }
+
+private:
+  TimerWheel &wheel_;
+  TimerWheel::Node node_;
+};
+
+/// PeriodicTimer on the timer wheel (drift-free: periods add up from the
+/// start, a missed tick is skipped)
+class WheelPeriodicTimer {
+public:
+  using Callback = std::function<void()>;
+
+  explicit WheelPeriodicTimer(Callback callback) : wheel_(timer_wheel()) {
+    node_.callback = std::move(callback);
+  }
+
+  ~WheelPeriodicTimer() { wheel_.cancel(node_, true); }
+
+  WheelPeriodicTimer(const WheelPeriodicTimer &) = delete;
+  WheelPeriodicTimer &operator=(const WheelPeriodicTimer &) = delete;
+  WheelPeriodicTimer(WheelPeriodicTimer &&) = delete;
+  WheelPeriodicTimer &operator=(WheelPeriodicTimer &&) = delete;
+
+  /// Fire every period, first after one period (restarts a running timer)
+  template <typename Rep, typename Period>
+  Status start(std::chrono::duration<Rep, Period> period) {
+    auto period_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(period).count();
+    if (period_us <= 0) {
+      return Err(ESP_ERR_INVALID_ARG);
+    }
+    wheel_.schedule(node_, period_us, period_us);
+    return Ok();
+  }
+
+  /// Restart with new period
+  template <typename Rep, typename Period>
+  Status restart(std::chrono::duration<Rep, Period> period) {
+    return start(period);
+  }
+
+  Status stop() {
+    wheel_.cancel(node_);
+    return Ok();
+  }
+
+  [[nodiscard]] bool is_running() { return wheel_.is_scheduled(node_); }
+
+private:
+  TimerWheel &wheel_;
+  TimerWheel::Node node_;
+};
+
+} // namespace core
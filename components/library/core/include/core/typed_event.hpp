@@ -0,0 +1,387 @@
+/**
+ * @file typed_event.hpp
+ * @brief Type-checked events with their payloads in fixed slots
+ *
+ * An Event descriptor ties a base, an ID and a payload type together, so
+ * a wrong payload or a handler taking the wrong type doesn't compile:
+ *
+ *   using WifiConnectedEvent =
+ *       core::Event<&NETWORK_EVENTS, NetworkEvent::WifiConnected,
+ *                   ConnectionInfo>;
+ *   sub_ = core::subscribe<WifiConnectedEvent, &Sntp::on_connected>(this);
+ *   (void)core::publish<WifiConnectedEvent>(info);
+ *
+ * esp_event_post() copies every payload to the heap. Here the payload
+ * goes into the event's own queue of Depth statically allocated slots
+ * and the post itself carries no data. One dispatcher per event,
+ * registered through EventBus (so a dedicated loop applies), pops the
+ * payload and calls the event's handler table directly.
+ *
+ * Raw EventBus subscribers to the same base and ID still run, with no data.
+ *
+ * A TypedSubscription's unsubscribe() (and destructor) returns only once
+ * no dispatch is still running its handler, so the handler's object may
+ * be destroyed right after. From inside a handler it doesn't wait.
+ */
+
+#pragma once
+
+#include "event_loop.hpp"
+#include "mutex.hpp"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace core {
+
+/// Event descriptor: base, ID and payload type (void: no payload)
+/// @tparam Depth Payloads queued for the dispatcher before publish() waits
+template <const esp_event_base_t *Base, auto Id, typename Payload = void,
+          size_t Depth = 8>
+  requires EventId<decltype(Id)>
+struct Event {
+  static_assert(std::is_void_v<Payload> ||
+                    (std::is_trivially_copyable_v<Payload> &&
+                     std::is_default_constructible_v<Payload>),
+                "Payloads are copied by value into their slots");
+  static_assert(Depth > 0 && Depth <= UINT8_MAX);
+
+  using payload_type = Payload;
+  static constexpr int32_t id = static_cast<int32_t>(Id);
+  static constexpr size_t depth = Depth;
+
+  [[nodiscard]] static esp_event_base_t base() { return *Base; }
+};
+
+/// RAII typed handler registration (auto-unsubscribes)
+class TypedSubscription {
+public:
+  using Remove = void (*)(uint8_t slot);
+
+  TypedSubscription() = default;
+  TypedSubscription(Remove remove, uint8_t slot)
+      : remove_(remove), slot_(slot) {}
+
+  ~TypedSubscription() { unsubscribe(); }
+
+  TypedSubscription(const TypedSubscription &) = delete;
+  TypedSubscription &operator=(const TypedSubscription &) = delete;
+
+  TypedSubscription(TypedSubscription &&other) noexcept
+      : remove_(other.remove_), slot_(other.slot_) {
+    other.remove_ = nullptr;
+  }
+
+  TypedSubscription &operator=(TypedSubscription &&other) noexcept {
+    if (this != &other) {
+      unsubscribe();
+      remove_ = other.remove_;
+      slot_ = other.slot_;
+      other.remove_ = nullptr;
+    }
+    return *this;
+  }
+
+  void unsubscribe() {
+    if (remove_ != nullptr) {
+      remove_(slot_);
+      remove_ = nullptr;
+    }
+  }
+
+  [[nodiscard]] bool active() const { return remove_ != nullptr; }
+  [[nodiscard]] explicit operator bool() const { return active(); }
+
+private:
+  Remove remove_ = nullptr;
+  uint8_t slot_ = 0;
+};
+
+namespace detail {
+template <typename Payload> struct HandlerOf {
+  using type = void (*)(void *ctx, const Payload &payload);
+};
+template <> struct HandlerOf<void> {
+  using type = void (*)(void *ctx);
+};
+
+/// push() result when no slot freed up
+inline constexpr size_t kNoSlot = SIZE_MAX;
+
+/// Statically allocated FIFO of payloads (nothing for void)
+///
+/// A payload is queued before its event is posted, so the dispatcher
+/// always finds it. If the post then fails, cancel() takes one payload
+/// back out, wherever it sits.
+template <typename Payload, size_t Depth> class PayloadQueue {
+public:
+  PayloadQueue()
+      : free_(xSemaphoreCreateCountingStatic(Depth, Depth, &free_buffer_)) {}
+
+  /// Append payload, waiting up to timeout for a free slot
+  /// @return Its slot (for cancel()), or kNoSlot
+  [[nodiscard]] size_t push(const Payload &payload, TickType_t timeout) {
+    if (xSemaphoreTake(free_, timeout) != pdTRUE) {
+      return kNoSlot;
+    }
+    LockGuard lock(mutex_);
+    size_t slot = (head_ + count_) % Depth;
+    entries_.at(slot) = {.payload = payload, .state = State::Queued};
+    ++count_;
+    return slot;
+  }
+
+  /// Withdraw the payload of a post that failed: the one in slot, or if a
+  /// dispatch already took it, the newest still queued. Events of one type
+  /// are alike, so each dispatched event still gets a payload of its own.
+  void cancel(size_t slot) {
+    LockGuard lock(mutex_);
+    if (entries_.at(slot).state != State::Queued) {
+      slot = kNoSlot;
+      for (size_t i = count_; i > 0 && slot == kNoSlot; --i) {
+        size_t at = (head_ + i - 1) % Depth;
+        if (entries_.at(at).state == State::Queued) {
+          slot = at;
+        }
+      }
+      if (slot == kNoSlot) {
+        return;
+      }
+    }
+    entries_.at(slot).state = State::Cancelled;
+
+    // Free cancelled entries at either end right away
+    while (count_ > 0 &&
+           entries_.at((head_ + count_ - 1) % Depth).state ==
+               State::Cancelled) {
+      release((head_ + count_ - 1) % Depth);
+      --count_;
+    }
+    while (count_ > 0 && entries_.at(head_).state == State::Cancelled) {
+      release(head_);
+      head_ = (head_ + 1) % Depth;
+      --count_;
+    }
+  }
+
+  /// Take the oldest payload, skipping cancelled ones
+  [[nodiscard]] bool pop(Payload &payload) {
+    LockGuard lock(mutex_);
+    bool found = false;
+    while (count_ > 0 && !found) {
+      auto &entry = entries_.at(head_);
+      found = entry.state == State::Queued;
+      if (found) {
+        payload = entry.payload;
+      }
+      release(head_);
+      head_ = (head_ + 1) % Depth;
+      --count_;
+    }
+    return found;
+  }
+
+private:
+  enum class State : uint8_t { Free, Queued, Cancelled };
+
+  struct Entry {
+    Payload payload;
+    State state;
+  };
+
+  /// Mark slot free and hand its token back (lock held)
+  void release(size_t slot) {
+    entries_.at(slot).state = State::Free;
+    xSemaphoreGive(free_);
+  }
+
+  Mutex mutex_;
+  std::array<Entry, Depth> entries_{};
+  size_t head_ = 0;
+  size_t count_ = 0; ///< Queued or cancelled, from head_
+  StaticSemaphore_t free_buffer_{};
+  SemaphoreHandle_t free_; ///< One token per free slot
+};
+template <size_t Depth> class PayloadQueue<void, Depth> {};
+
+/// Handler table and payload slots of one Event
+template <typename E> class EventChannel {
+  using Payload = typename E::payload_type;
+  static constexpr bool kHasPayload = !std::is_void_v<Payload>;
+
+public:
+  using Handler = typename HandlerOf<Payload>::type;
+
+  /// Typed handlers per event
+  static constexpr uint8_t kMaxHandlers = 4;
+
+  static EventChannel &get() {
+    static EventChannel channel;
+    return channel;
+  }
+
+  EventChannel(const EventChannel &) = delete;
+  EventChannel &operator=(const EventChannel &) = delete;
+  EventChannel(EventChannel &&) = delete;
+  EventChannel &operator=(EventChannel &&) = delete;
+
+  /// @return Inactive if the table is full or the dispatcher can't register
+  [[nodiscard]] TypedSubscription add(Handler handler, void *ctx) {
+    LockGuard lock(mutex_);
+    if (!dispatcher_) {
+      // Stays registered: queued payloads always have their event behind
+      dispatcher_ = events().subscribe(E::base(), E::id, &dispatch, this);
+      if (!dispatcher_) {
+        return {};
+      }
+      dispatching_.store(true);
+    }
+    for (uint8_t i = 0; i < kMaxHandlers; ++i) {
+      if (slots_.at(i).handler == nullptr) {
+        slots_.at(i) = {handler, ctx};
+        return {&remove, i};
+      }
+    }
+    return {};
+  }
+
+  /// Queue payload (if anyone dispatches it) and post the event
+  /// @return ESP_ERR_TIMEOUT if the slots stayed full, else as
+  ///         EventBus::publish()
+  [[nodiscard]] esp_err_t post(const Payload *payload, TickType_t timeout) {
+    [[maybe_unused]] size_t slot = kNoSlot;
+    if constexpr (kHasPayload) {
+      if (dispatching_.load()) {
+        slot = queue_.push(*payload, timeout);
+        if (slot == kNoSlot) {
+          return ESP_ERR_TIMEOUT;
+        }
+      }
+    }
+    esp_err_t err = events().publish(E::base(), E::id, nullptr, timeout);
+    if constexpr (kHasPayload) {
+      if (err != ESP_OK && slot != kNoSlot) {
+        queue_.cancel(slot); // No event for it
+      }
+    }
+    return err;
+  }
+
+private:
+  struct Slot {
+    Handler handler = nullptr;
+    void *ctx = nullptr;
+  };
+
+  EventChannel() = default;
+  ~EventChannel() = default;
+
+  static void remove(uint8_t slot) {
+    auto &channel = get();
+    {
+      LockGuard lock(channel.mutex_);
+      channel.slots_.at(slot) = {};
+    }
+    // A dispatch that copied the table earlier may still be in the handler:
+    // wait it out. A handler removing itself runs on that dispatch's task.
+    TaskHandle_t self_task = xTaskGetCurrentTaskHandle();
+    for (TaskHandle_t task = channel.dispatch_task_.load();
+         task != nullptr && task != self_task;
+         task = channel.dispatch_task_.load()) {
+      vTaskDelay(1);
+    }
+  }
+
+  static void dispatch(void *arg, esp_event_base_t /*base*/,
+                       int32_t /*event_id*/, void * /*data*/) {
+    auto *self = static_cast<EventChannel *>(arg);
+    if constexpr (kHasPayload) {
+      Payload payload{};
+      if (!self->queue_.pop(payload)) {
+        return; // Posted before the dispatcher registered
+      }
+      self->run_handlers(
+          [&payload](const Slot &slot) { slot.handler(slot.ctx, payload); });
+    } else {
+      self->run_handlers([](const Slot &slot) { slot.handler(slot.ctx); });
+    }
+  }
+
+  /// Call fn(slot) for each handler, from a copy of the table
+  template <typename Fn> void run_handlers(Fn &&fn) {
+    std::array<Slot, kMaxHandlers> slots{};
+    {
+      // Called unlocked: a handler may unsubscribe
+      LockGuard lock(mutex_);
+      slots = slots_;
+      dispatch_task_ = xTaskGetCurrentTaskHandle();
+    }
+    for (const auto &slot : slots) {
+      if (slot.handler != nullptr) {
+        fn(slot);
+      }
+    }
+    dispatch_task_ = nullptr; // remove() may return now
+  }
+
+  Mutex mutex_;
+  std::array<Slot, kMaxHandlers> slots_{};
+  EventSubscription dispatcher_;
+  std::atomic<bool> dispatching_{false};
+  /// Task running handlers from a copy of slots_ (nullptr: none)
+  std::atomic<TaskHandle_t> dispatch_task_{nullptr};
+  PayloadQueue<Payload, E::depth> queue_;
+};
+} // namespace detail
+
+/// Handler type of an Event: void(void *ctx, const Payload &) or
+/// void(void *ctx)
+template <typename E>
+using EventHandler = typename detail::HandlerOf<typename E::payload_type>::type;
+
+/// Subscribe a free function (or captureless lambda)
+template <typename E>
+[[nodiscard]] TypedSubscription subscribe(EventHandler<E> handler,
+                                          void *ctx = nullptr) {
+  return detail::EventChannel<E>::get().add(handler, ctx);
+}
+
+/// Subscribe a member function: Method(const Payload &) or Method()
+template <typename E, auto Method, typename T>
+[[nodiscard]] TypedSubscription subscribe(T *object) {
+  using Payload = typename E::payload_type;
+  if constexpr (std::is_void_v<Payload>) {
+    return subscribe<E>(
+        [](void *ctx) { (static_cast<T *>(ctx)->*Method)(); }, object);
+  } else {
+    return subscribe<E>(
+        [](void *ctx, const Payload &payload) {
+          (static_cast<T *>(ctx)->*Method)(payload);
+        },
+        object);
+  }
+}
+
+/// Publish an event with its payload
+template <typename E>
+  requires(!std::is_void_v<typename E::payload_type>)
+esp_err_t publish(const typename E::payload_type &payload,
+                  TickType_t timeout = portMAX_DELAY) {
+  return detail::EventChannel<E>::get().post(&payload, timeout);
+}
+
+/// Publish an event without payload
+template <typename E>
+  requires std::is_void_v<typename E::payload_type>
+esp_err_t publish(TickType_t timeout = portMAX_DELAY) {
+  return detail::EventChannel<E>::get().post(nullptr, timeout);
+}
+
+} // namespace core
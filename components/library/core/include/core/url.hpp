@@ -0,0 +1,168 @@
+/**
+ * @file url.hpp
+ * @brief Allocation-free URL building and percent-encoding
+ *
+ * UrlWriter composes base URL, path and query string straight into a
+ * caller-owned buffer (HttpClient's URL buffer) - no std::string, one copy.
+ * Paths are appended verbatim; constant endpoints are validated and, if
+ * needed, percent-encoded at compile time with static_path<>.
+ *
+ * Usage:
+ *   inline constexpr std::string_view PATH = "/telemetry/proto";
+ *   url::UrlWriter url(buffer);
+ *   url.append(base).append(url::static_path<PATH>).append_query(params);
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace core {
+
+/// Query parameter for URL construction
+struct QueryParam {
+  std::string_view key;
+  std::string_view value;
+};
+
+namespace url {
+
+/// RFC 3986 unreserved characters (never encoded)
+[[nodiscard]] constexpr bool is_unreserved(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' ||
+         c == '~';
+}
+
+/// Characters a path segment may carry verbatim (besides %XX)
+[[nodiscard]] constexpr bool is_path_char(char c) {
+  return is_unreserved(c) || c == '/' || c == ':' || c == '@' || c == '!' ||
+         c == '$' || c == '&' || c == '\'' || c == '(' || c == ')' ||
+         c == '*' || c == '+' || c == ',' || c == ';' || c == '=';
+}
+
+/// Size of s after percent-encoding everything but keep(c)
+template <typename Keep>
+[[nodiscard]] constexpr size_t encoded_size(std::string_view s, Keep keep) {
+  size_t size = 0;
+  for (char c : s) {
+    size += keep(c) ? 1 : 3;
+  }
+  return size;
+}
+
+[[nodiscard]] constexpr char hex_digit(uint8_t nibble) {
+  return "0123456789ABCDEF"[nibble & 0x0F];
+}
+
+/// Percent-encoded copy of a constant path, built at compile time
+/// @tparam Path Reference to a constexpr string_view with static storage
+template <const std::string_view &Path> struct StaticPath {
+  static constexpr size_t SIZE = encoded_size(Path, is_path_char);
+
+  static constexpr std::array<char, SIZE + 1> DATA = [] {
+    std::array<char, SIZE + 1> out{};
+    size_t pos = 0;
+    for (char c : Path) {
+      if (is_path_char(c)) {
+        out.at(pos++) = c;
+      } else {
+        auto byte = static_cast<uint8_t>(c);
+        out.at(pos++) = '%';
+        out.at(pos++) = hex_digit(byte >> 4);
+        out.at(pos++) = hex_digit(byte);
+      }
+    }
+    return out;
+  }();
+
+  static constexpr std::string_view value{DATA.data(), SIZE};
+};
+
+/// Encoded form of a constant endpoint path (no runtime encoding)
+template <const std::string_view &Path>
+inline constexpr std::string_view static_path = StaticPath<Path>::value;
+
+/// Bounded, NUL-terminated URL builder over a caller buffer
+///
+/// Appends stop at the first overflow; check ok() once at the end.
+class UrlWriter {
+public:
+  explicit UrlWriter(std::span<char> buffer) : buffer_(buffer) {
+    ok_ = !buffer_.empty();
+    terminate();
+  }
+
+  /// Append verbatim (base URL, pre-encoded path)
+  UrlWriter &append(std::string_view s) {
+    if (!reserve(s.size())) {
+      return *this;
+    }
+    for (char c : s) {
+      buffer_[len_++] = c;
+    }
+    terminate();
+    return *this;
+  }
+
+  /// Append with percent-encoding of everything but unreserved characters
+  UrlWriter &append_encoded(std::string_view s) {
+    if (!reserve(encoded_size(s, is_unreserved))) {
+      return *this;
+    }
+    for (char c : s) {
+      if (is_unreserved(c)) {
+        buffer_[len_++] = c;
+      } else {
+        auto byte = static_cast<uint8_t>(c);
+        buffer_[len_++] = '%';
+        buffer_[len_++] = hex_digit(byte >> 4);
+        buffer_[len_++] = hex_digit(byte);
+      }
+    }
+    terminate();
+    return *this;
+  }
+
+  /// Append "?k=v&k2=v2" (nothing for an empty list)
+  UrlWriter &append_query(std::span<const QueryParam> params) {
+    char separator = '?';
+    for (const auto &param : params) {
+      append({&separator, 1});
+      append_encoded(param.key);
+      append("=");
+      append_encoded(param.value);
+      separator = '&';
+    }
+    return *this;
+  }
+
+  [[nodiscard]] bool ok() const { return ok_; }
+  [[nodiscard]] size_t size() const { return len_; }
+  [[nodiscard]] const char *c_str() const { return buffer_.data(); }
+  [[nodiscard]] std::string_view view() const { return {buffer_.data(), len_}; }
+
+private:
+  [[nodiscard]] bool reserve(size_t n) {
+    // Keep room for the terminator
+    ok_ = ok_ && n < buffer_.size() - len_;
+    return ok_;
+  }
+
+  void terminate() {
+    if (!buffer_.empty()) {
+      buffer_[len_] = '\0';
+    }
+  }
+
+  std::span<char> buffer_;
+  size_t len_{0};
+  bool ok_{false};
+};
+
+} // namespace url
+} // namespace core
@@ -0,0 +1,163 @@
+/**
+ * @file wake_profile.hpp
+ * @brief Time spent per phase of a wake, for the energy budget
+ *
+ * On a duty-cycled probe the awake time is the energy bill, and which part
+ * of it dominates depends on the site: a slow router stretches
+ * association and DHCP, a distant backend the TLS handshake. Each layer
+ * marks its own phases in one process-wide profile:
+ *
+ *   core::ScopedPhase phase(core::WakePhase::Upload);  // scope = phase
+ *
+ *   core::begin_phase(core::WakePhase::Dhcp);  // spans two callbacks
+ *   core::end_phase(core::WakePhase::Dhcp);
+ *
+ * Durations add up, so retries are counted in full. Phases may overlap:
+ * Tls is the handshake part of Auth and Upload. The profile only lives
+ * until the next boot; the application copies wake_profile() into RTC
+ * memory before deep sleep and reports it from a later wake.
+ *
+ * Marks are two atomic operations and an esp_timer read, cheap enough for
+ * any task. Timestamps are 32-bit microseconds: a phase may last up to 71
+ * minutes.
+ */
+
+#pragma once
+
+#include <esp_timer.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+
+/// Phases of a wake, in the order they usually run
+enum class WakePhase : uint8_t {
+  Boot,      ///< Reset until the application starts (ROM and 2nd stage not
+             ///< included: esp_timer starts in the app)
+  Storage,   ///< NVS, LittleFS and the stored config
+  WifiAssoc, ///< esp_wifi_connect() until associated (scan included)
+  Dhcp,      ///< Associated until an IP (cached lease: a static IP)
+  Tls,       ///< TCP connect and TLS handshakes of every HTTP connection
+  Auth,      ///< Cloud start: the token exchange (skipped with a valid token)
+  Upload,    ///< Telemetry, device info and the command poll
+  Bsec,      ///< Waiting for and producing the BSEC sample
+  Sleep,     ///< BSEC snapshot and storage flush before deep sleep
+  Count
+};
+
+inline constexpr size_t WAKE_PHASE_COUNT =
+    static_cast<size_t>(WakePhase::Count);
+
+[[nodiscard]] inline const char *to_string(WakePhase phase) {
+  switch (phase) {
+  case WakePhase::Boot:
+    return "boot";
+  case WakePhase::Storage:
+    return "storage";
+  case WakePhase::WifiAssoc:
+    return "wifi_assoc";
+  case WakePhase::Dhcp:
+    return "dhcp";
+  case WakePhase::Tls:
+    return "tls";
+  case WakePhase::Auth:
+    return "auth";
+  case WakePhase::Upload:
+    return "upload";
+  case WakePhase::Bsec:
+    return "bsec";
+  case WakePhase::Sleep:
+    return "sleep";
+  default:
+    return "unknown";
+  }
+}
+
+/// Time per phase of one wake (trivially copyable: fits an RtcValue)
+struct WakeProfile {
+  std::array<uint32_t, WAKE_PHASE_COUNT> phase_us{};
+  uint32_t awake_us{0}; ///< Start of the app until the snapshot
+
+  [[nodiscard]] uint32_t operator[](WakePhase phase) const {
+    return phase_us.at(static_cast<size_t>(phase));
+  }
+};
+
+namespace detail {
+struct WakeProfileState {
+  std::array<std::atomic<uint32_t>, WAKE_PHASE_COUNT> total_us{};
+  std::array<std::atomic<uint32_t>, WAKE_PHASE_COUNT> started_us{};
+};
+
+[[nodiscard]] inline WakeProfileState &wake_profile_state() {
+  static WakeProfileState state;
+  return state;
+}
+
+[[nodiscard]] inline uint32_t profile_now_us() {
+  return static_cast<uint32_t>(esp_timer_get_time());
+}
+} // namespace detail
+
+/// Add time to a phase
+inline void add_phase_time(WakePhase phase, uint32_t us) {
+  detail::wake_profile_state()
+      .total_us.at(static_cast<size_t>(phase))
+      .fetch_add(us, std::memory_order_relaxed);
+}
+
+/// Start timing a phase (a running one restarts)
+inline void begin_phase(WakePhase phase) {
+  // 0 means not running
+  uint32_t now = detail::profile_now_us();
+  detail::wake_profile_state()
+      .started_us.at(static_cast<size_t>(phase))
+      .store(now != 0 ? now : 1, std::memory_order_relaxed);
+}
+
+/// Stop timing a phase and add what it took (no-op if it isn't running)
+inline void end_phase(WakePhase phase) {
+  uint32_t started = detail::wake_profile_state()
+                         .started_us.at(static_cast<size_t>(phase))
+                         .exchange(0, std::memory_order_relaxed);
+  if (started != 0) {
+    add_phase_time(phase, detail::profile_now_us() - started);
+  }
+}
+
+/// The phases so far (running ones not included)
+[[nodiscard]] inline WakeProfile wake_profile() {
+  auto &state = detail::wake_profile_state();
+  WakeProfile profile{};
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    profile.phase_us.at(i) =
+        state.total_us.at(i).load(std::memory_order_relaxed);
+  }
+  profile.awake_us = detail::profile_now_us();
+  return profile;
+}
+
+/// Times the enclosing scope as one phase
+class ScopedPhase {
+public:
+  explicit ScopedPhase(WakePhase phase)
+      : phase_(phase), start_us_(detail::profile_now_us()) {}
+
+  ~ScopedPhase() {
+    add_phase_time(phase_, detail::profile_now_us() - start_us_);
+  }
+
+  ScopedPhase(const ScopedPhase &) = delete;
+  ScopedPhase &operator=(const ScopedPhase &) = delete;
+  ScopedPhase(ScopedPhase &&) = delete;
+  ScopedPhase &operator=(ScopedPhase &&) = delete;
+
+private:
+  WakePhase phase_;
+  uint32_t start_us_;
+};
+
+} // namespace core
@@ -0,0 +1,107 @@
+/**
+ * @file worker.hpp
+ * @brief Task that sleeps until work is posted to it
+ *
+ * Work items are bits of the task's notification value: post() ORs them in
+ * from any task (or timer callback) and wakes the worker, which runs the
+ * handler with every bit posted since its last run. The same item posted
+ * twice before the worker gets to it runs once - fine for "something
+ * changed, go look" work such as starting a connection or draining a queue.
+ *
+ * Between posts the task is blocked with no timeout, so it adds no wakeups
+ * to the tickless idle schedule.
+ *
+ * Usage:
+ *   enum : uint32_t { WORK_CONNECT = 1U << 0, WORK_UPLOAD = 1U << 1 };
+ *   Worker worker({.name = "cloud"});
+ *   (void)worker.start([](uint32_t work) {
+ *     if (work & WORK_CONNECT) connect();
+ *     if (work & WORK_UPLOAD) upload();
+ *   });
+ *   worker.post(WORK_UPLOAD); // From anywhere
+ */
+
+#pragma once
+
+#include "result.hpp"
+#include "task.hpp"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+namespace core {
+
+/// Worker task settings
+struct WorkerConfig {
+  const char *name{"worker"};
+  uint32_t stack_size{4096};
+  UBaseType_t priority{5};
+};
+
+/// Notification-driven worker task
+///
+/// @thread_safety post() is thread-safe; the handler runs on the worker
+///                task only, so the work it does is serialized.
+class Worker {
+public:
+  using Handler = std::function<void(uint32_t work)>;
+
+  explicit Worker(const WorkerConfig &config = {}) : config_(config) {}
+
+  Worker(const Worker &) = delete;
+  Worker &operator=(const Worker &) = delete;
+  Worker(Worker &&) = delete;
+  Worker &operator=(Worker &&) = delete;
+
+  /// Create the task
+  /// @return ESP_ERR_INVALID_STATE if already started
+  [[nodiscard]] Status start(Handler handler) {
+    if (task_) {
+      return Err(ESP_ERR_INVALID_STATE);
+    }
+    handler_ = std::move(handler);
+    task_.emplace([this]() { run(); },
+                  TaskConfig{.name = config_.name,
+                             .stack_size = config_.stack_size,
+                             .priority = config_.priority});
+    handle_ = task_->native_handle();
+    return Ok();
+  }
+
+  [[nodiscard]] bool is_running() const { return handle_.load() != nullptr; }
+
+  /// Queue work (bits OR into what is pending); dropped before start()
+  void post(uint32_t work) {
+    if (auto *handle = handle_.load(); handle != nullptr && work != 0) {
+      xTaskNotify(handle, work, eSetBits);
+    }
+  }
+
+  /// True when called from the worker task itself
+  [[nodiscard]] bool on_worker() const {
+    return handle_.load() == xTaskGetCurrentTaskHandle();
+  }
+
+private:
+  [[noreturn]] void run() {
+    while (true) {
+      uint32_t work = 0;
+      if (xTaskNotifyWait(0, UINT32_MAX, &work, portMAX_DELAY) == pdTRUE &&
+          work != 0) {
+        handler_(work);
+      }
+    }
+  }
+
+  WorkerConfig config_;
+  Handler handler_;
+  std::optional<Task> task_;
+  std::atomic<TaskHandle_t> handle_{nullptr};
+};
+
+} // namespace core
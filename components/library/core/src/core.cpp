@@ -4,10 +4,101 @@
  */
 
 #include <core/app_events.hpp>
+#include <core/bench.hpp>
+#include <core/fault.hpp>
+#include <core/heap_watchdog.hpp>
+#include <core/rtc_backend.hpp>
+
+#include <esp_attr.h>
+#ifdef CONFIG_CORE_HEAP_TRACE
+#include <esp_heap_trace.h>
+#include <esp_log.h>
+#endif
+
+#include <array>
+#include <atomic>
 
 namespace core {
 
 // Define the application events base
 CORE_EVENT_DEFINE_BASE(APP_EVENTS);
 
+namespace rtc {
+namespace {
+// Zeroed on cold boot, kept across deep sleep and software resets
+RTC_DATA_ATTR KvArena g_kv_arena;
+} // namespace
+
+KvArena &kv_arena() { return g_kv_arena; }
+} // namespace rtc
+
+namespace {
+// Not initialized at all: unlike RTC_DATA_ATTR, kept across software,
+// panic and watchdog resets. On power-on the CRC rejects the garbage.
+RTC_NOINIT_ATTR RtcValue<FaultRing> g_fault_ring;
+} // namespace
+
+RtcValue<FaultRing> &fault_ring() { return g_fault_ring; }
+
+#ifdef CONFIG_CORE_HEAP_TRACE
+namespace {
+constexpr const char *HEAP_TRACE_TAG = "heap_trace";
+std::array<heap_trace_record_t, CONFIG_CORE_HEAP_TRACE_RECORDS>
+    g_heap_trace_records;
+std::atomic<bool> g_heap_trace_busy{false};
+} // namespace
+
+ScopedHeapTrace::ScopedHeapTrace(const char *name) : name_(name) {
+  static bool initialized = heap_trace_init_standalone(
+                                g_heap_trace_records.data(),
+                                g_heap_trace_records.size()) == ESP_OK;
+  if (!initialized || g_heap_trace_busy.exchange(true)) {
+    return;
+  }
+  active_ = heap_trace_start(HEAP_TRACE_LEAKS) == ESP_OK;
+  if (!active_) {
+    g_heap_trace_busy = false;
+  }
+}
+
+ScopedHeapTrace::~ScopedHeapTrace() {
+  if (!active_) {
+    return;
+  }
+  (void)heap_trace_stop();
+  ESP_LOGI(HEAP_TRACE_TAG, "%s: %zu allocation(s) not freed", name_,
+           heap_trace_get_count());
+  if (heap_trace_get_count() > 0) {
+    heap_trace_dump();
+  }
+  g_heap_trace_busy = false;
+}
+#else
+ScopedHeapTrace::ScopedHeapTrace(const char *name) : name_(name) {}
+ScopedHeapTrace::~ScopedHeapTrace() = default;
+#endif
+
+namespace bench {
+#if CONFIG_CORE_BENCH && CONFIG_HEAP_USE_HOOKS
+namespace {
+std::atomic<int32_t> g_allocs{0};
+} // namespace
+
+int32_t alloc_count() { return g_allocs.load(std::memory_order_relaxed); }
+#else
+int32_t alloc_count() { return -1; }
+#endif
+} // namespace bench
+
 } // namespace core
+
+#if CONFIG_CORE_BENCH && CONFIG_HEAP_USE_HOOKS
+// Called by the allocator on every allocation and free
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void * /*ptr*/,
+                                                    size_t /*size*/,
+                                                    uint32_t /*caps*/) {
+  core::bench::g_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void * /*ptr*/) {}
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file dns_cache.hpp
+ * @brief Host name answers kept in RTC memory across deep sleep
+ *
+ * Each wake that uploads opens fresh connections, and each one resolves
+ * the cloud host again: a UDP round trip to the router's resolver, with a
+ * tail of a second or more when a packet is lost. The cache answers
+ * lwIP's lookups itself through the netconn resolve hook
+ * (CONFIG_LWIP_HOOK_NETCONN_EXT_RESOLVE_CUSTOM, see sdkconfig.defaults),
+ * so getaddrinfo() in esp-tls and esp_http_client hits it without any
+ * change there. A miss resolves through lwIP as before and keeps the
+ * answer.
+ *
+ * lwIP doesn't pass a record's TTL on, so answers live for ttl_s: keep it
+ * at or below the endpoint's TTL. Entries are timed on the RTC clock, so
+ * the time asleep counts. A caller that suspects a stale address (a
+ * connect failed) calls clear(). Only IPv4 answers are cached.
+ */
+
+#pragma once
+
+#include <core/mutex.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace network {
+
+/// DNS cache configuration
+struct DnsCacheConfig {
+  /// How long an answer is used (s, 0 = cache off)
+  uint32_t ttl_s = 300;
+};
+
+/// DNS answer cache (singleton)
+class DnsCache {
+public:
+  /// Hosts kept (least recently resolved replaced first)
+  static constexpr size_t kMaxEntries = 4;
+
+  /// Longer names are resolved every time
+  static constexpr size_t kMaxHostLen = 63;
+
+  static DnsCache &instance();
+
+  DnsCache(const DnsCache &) = delete;
+  DnsCache &operator=(const DnsCache &) = delete;
+
+  void configure(const DnsCacheConfig &config) { config_ = config; }
+
+  /// Fresh cached address of host (IPv4, network byte order)
+  [[nodiscard]] std::optional<uint32_t> lookup(const char *host);
+
+  /// Keep an answer for ttl_s
+  void store(const char *host, uint32_t addr);
+
+  /// Drop every answer (the next lookups resolve again)
+  void clear();
+
+  /// Fresh entries
+  [[nodiscard]] size_t size();
+
+private:
+  DnsCache() = default;
+  ~DnsCache() = default;
+
+  core::Mutex mutex_;
+  DnsCacheConfig config_{};
+};
+
+/// Get DNS cache singleton
+inline DnsCache &dns_cache() { return DnsCache::instance(); }
+
+} // namespace network
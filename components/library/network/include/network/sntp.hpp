@@ -7,11 +7,23 @@
  *
  * Optionally call sntp().configure() before WiFi connects to customize
  * settings.
+ *
+ * Each sync is kept in RTC memory with the RTC clock's drift, measured
+ * between two syncs. After deep sleep the first sntp() call restores the
+ * wall clock from it, so samples and JWTs have a time before WiFi is up.
+ * The RTC clock runs off an RC oscillator that drifts with temperature,
+ * so the restored time's error bound grows with the time since the sync;
+ * only once it passes max_error_ms does a WiFi connect run NTP again.
+ * A connect that skips NTP arms a one-shot timer for the moment the bound
+ * reaches max_error_ms, so a device that stays connected still re-syncs.
  */
 
 #pragma once
 
-#include <core/event_loop.hpp>
+#include "wifi_types.hpp"
+
+#include <core/timer.hpp>
+#include <core/typed_event.hpp>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
@@ -31,6 +43,15 @@ struct SntpConfig {
   /// Timezone string (POSIX format, default: UTC)
   /// Examples: "UTC", "EST5EDT", "CET-1CEST,M3.5.0,M10.5.0/3"
   const char *timezone = "UTC";
+
+  /// Skip NTP on connect while the restored time is good to this (ms)
+  uint32_t max_error_ms = 2000;
+
+  /// RTC clock error assumed until two syncs have measured it (ppm)
+  uint32_t uncalibrated_drift_ppm = 1500;
+
+  /// Error left once the drift is compensated (temperature changes it)
+  uint32_t calibrated_drift_ppm = 150;
 };
 
 /// SNTP time synchronization service (singleton)
@@ -46,9 +67,17 @@ public:
   /// Configure SNTP settings (call before WiFi connects)
   void configure(const SntpConfig &config);
 
-  /// Check if time has been synchronized
+  /// Check if time has been synchronized (or restored after deep sleep)
   [[nodiscard]] bool is_synced() const;
 
+  /// Error bound of the current time (ms, UINT32_MAX if never synced)
+  [[nodiscard]] uint32_t error_bound_ms() const;
+
+  /// The time is too uncertain to skip NTP on the next connect
+  [[nodiscard]] bool needs_sync() const {
+    return error_bound_ms() > config_.max_error_ms;
+  }
+
   /// Wait for time synchronization (blocking)
   /// @param timeout_ms Maximum time to wait (0 = wait forever)
   /// @return true if synced, false if timeout
@@ -67,9 +96,22 @@ private:
   void register_events();
   void do_init();
 
+  /// Run do_init() once the error bound reaches max_error_ms
+  void schedule_resync();
+
+  /// RTC clock error assumed for the current sync record (ppm)
+  [[nodiscard]] uint32_t drift_ppm() const;
+
+  /// Set the clock from the RTC sync record (deep-sleep wake)
+  void restore();
+
+  /// Keep a sync in RTC memory, measuring the drift since the last one
+  static void record_sync(int64_t epoch_ms);
+
   static void on_time_sync(struct timeval *tv);
-  static void on_network_event(void *arg, esp_event_base_t base,
-                               int32_t event_id, void *event_data);
+
+  /// WifiConnectedEvent: run NTP unless the restored time is good enough
+  void on_wifi_connected(const ConnectionInfo &info);
 
   /// Event group bits
   static constexpr EventBits_t kBitRegistered = BIT0;
@@ -78,7 +120,8 @@ private:
 
   EventGroupHandle_t event_group_ = nullptr;
   SntpConfig config_{};
-  core::EventSubscription wifi_sub_;
+  core::TypedSubscription wifi_sub_;
+  core::OneShotTimer resync_timer_{[this] { do_init(); }};
 };
 
 /// Get SNTP singleton
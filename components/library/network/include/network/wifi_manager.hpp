@@ -10,7 +10,8 @@
 #include <core/event_loop.hpp>
 #include <core/result.hpp>
 #include <core/storage.hpp>
-#include <core/timer.hpp>
+#include <core/timer_wheel.hpp>
+#include <core/typed_event.hpp>
 
 #include <esp_event.h>
 #include <esp_netif.h>
@@ -18,13 +19,16 @@
 
 #include <atomic>
 #include <functional>
-#include <memory>
 
 /// Network events base (for event bus subscriptions)
 CORE_EVENT_DECLARE_BASE(NETWORK_EVENTS);
 
 namespace network {
 
+/// NetworkEvent::WifiConnected with its ConnectionInfo (core::subscribe)
+using WifiConnectedEvent =
+    core::Event<&NETWORK_EVENTS, NetworkEvent::WifiConnected, ConnectionInfo>;
+
 /// WiFi manager - handles connection lifecycle, credentials, and reconnection
 class WifiManager {
 public:
@@ -51,13 +55,50 @@ public:
   /// Connect with specific credentials (stores them)
   [[nodiscard]] core::Status connect(const WifiCredentials &creds);
 
+  /// Reconnect the way the last connection went (e.g. across deep sleep)
+  ///
+  /// The next connect probes one channel for one BSSID instead of scanning
+  /// them all. With an address in the cache, it is set as a static IP once
+  /// associated, so no DHCP exchange runs either. The cache is dropped
+  /// after the first failed attempt, which then scans and leases normally:
+  /// a moved AP costs one retry.
+  void set_fast_connect(const FastConnect &cache) { fast_connect_ = cache; }
+
+  /// APs seen by the last scans and the one last joined (ScanMode::BestAp
+  /// scans their channels first and roams with hysteresis)
+  void set_ap_cache(const ApCache &cache) { ap_cache_ = cache; }
+
+  /// The cache to keep for the next connect (updated by scans and joins)
+  [[nodiscard]] const ApCache &ap_cache() const { return ap_cache_; }
+
+  /// Switch the modem sleep profile, e.g. off for a bulk download
+  ///
+  /// Takes effect at once. The listen interval of WifiConfig only changes
+  /// with the next association.
+  [[nodiscard]] core::Status set_power_save(PowerSave mode);
+
+  /// Current modem sleep profile
+  [[nodiscard]] PowerSave power_save() const { return config_.power_save; }
+
+  /// The current address came from the fast-connect cache, not DHCP
+  [[nodiscard]] bool is_static_ip() const { return static_ip_; }
+
   /// Disconnect from WiFi
   [[nodiscard]] core::Status disconnect();
 
   /// Start BLE provisioning mode
+  /// @return ESP_ERR_INVALID_STATE once BLE memory was released
   [[nodiscard]] core::Status
   start_provisioning(const ProvisioningConfig &config);
 
+  /// Give the BLE controller's reserved DRAM back to the heap
+  ///
+  /// BLE is only brought up by start_provisioning(). A device that boots
+  /// with credentials calls this so the memory serves TLS and telemetry
+  /// instead. Provisioning is then unavailable until the next reboot
+  /// (the stack also frees it itself when a provisioning session ends).
+  [[nodiscard]] core::Status release_ble();
+
   /// Stop provisioning mode
   [[nodiscard]] core::Status stop_provisioning();
 
@@ -93,8 +134,8 @@ public:
 
 private:
   /// NVS keys for credentials
-  static constexpr const char *kKeySsid = "ssid";
-  static constexpr const char *kKeyPassword = "pass";
+  static constexpr core::StorageKey kKeySsid{"ssid"};
+  static constexpr core::StorageKey kKeyPassword{"pass"};
 
   /// Load credentials from storage
   [[nodiscard]] core::Result<WifiCredentials> load_credentials();
@@ -102,17 +143,44 @@ private:
   /// Save credentials to storage
   [[nodiscard]] core::Status save_credentials(const WifiCredentials &creds);
 
-  /// Start the actual connection attempt
+  /// Start the actual connection attempt (scan first with BestAp)
   [[nodiscard]] core::Status start_connect(const WifiCredentials &creds);
 
-  /// Calculate backoff delay for current retry
+  /// Configure pending_creds_ and esp_wifi_connect(): to the fast-connect
+  /// AP, to target, or (both absent) to what the driver's scan finds
+  [[nodiscard]] core::Status associate(const ApRecord *target);
+
+  /// ScanMode::BestAp and no fast connect to an AP that was still strong
+  [[nodiscard]] bool needs_scan() const;
+
+  /// Start a non-blocking scan for pending_creds_ (WIFI_EVENT_SCAN_DONE)
+  /// @param cached_channels Only the channels of ap_cache_
+  [[nodiscard]] core::Status start_scan(bool cached_channels);
+
+  /// Pick the AP from the scan results and associate
+  void on_scan_done();
+
+  /// Set the cached address (DHCP stopped) after association
+  void apply_static_ip();
+
+  /// Forget the fast-connect cache, back to scan and DHCP
+  void drop_fast_connect();
+
+  /// Calculate backoff delay for current retry (jittered if enabled)
   [[nodiscard]] uint32_t calculate_backoff() const;
 
+  /// A disconnect that a quick retry won't fix (see weak_rssi_dbm)
+  [[nodiscard]] bool is_out_of_range(uint8_t reason, int8_t rssi) const;
+
   /// Reset retry counter and backoff
   void reset_retry_state();
 
   /// Schedule a reconnection attempt with backoff (non-blocking)
-  void schedule_reconnect(uint32_t backoff_ms);
+  /// @param out_of_range Wait at least out_of_range_backoff_ms (or give up)
+  void schedule_reconnect(uint32_t backoff_ms, bool out_of_range = false);
+
+  /// Stop retrying: WifiState::Failed and WifiConnectionFailed
+  void give_up();
 
   /// Timer callback for reconnection
   void on_reconnect_timer();
@@ -144,6 +212,11 @@ private:
   ConnectionInfo conn_info_{};
 
   WifiCredentials pending_creds_{};
+  FastConnect fast_connect_{};
+  ApCache ap_cache_{};
+  bool scanning_ = false;
+  bool scan_limited_ = false; ///< The running scan is of cached channels
+  bool static_ip_ = false;
   uint8_t retry_count_ = 0;
   StateCallback state_callback_;
 
@@ -152,13 +225,13 @@ private:
   core::EventSubscription prov_sub_;
 
   /// Timer for non-blocking reconnection with backoff
-  /// Uses unique_ptr for lazy initialization (timer is non-movable)
-  std::unique_ptr<core::OneShotTimer> reconnect_timer_;
+  core::WheelOneShotTimer reconnect_timer_{[this]() { on_reconnect_timer(); }};
 
   /// Timer for provisioning timeout
-  std::unique_ptr<core::OneShotTimer> prov_timeout_timer_;
+  core::WheelOneShotTimer prov_timeout_timer_{[this]() { on_prov_timeout(); }};
 
   bool initialized_ = false;
+  bool ble_released_ = false;
 
   static WifiManager *instance_;
 };
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <cstring>
@@ -53,6 +54,27 @@ struct WifiCredentials {
   }
 };
 
+/// Modem sleep while connected: the radio sleeps between the beacons it
+/// listens to, the AP buffers frames meanwhile
+///
+/// Combined with automatic light sleep (power::enable_auto_light_sleep)
+/// a connected, idle station draws a few mA. None keeps the radio on, and
+/// its PM lock keeps the chip out of light sleep as well.
+enum class PowerSave : uint8_t {
+  None, ///< Radio always on: lowest latency, ~100 mA
+  Min,  ///< Wake for every DTIM beacon (ESP-IDF default)
+  Max,  ///< Wake every listen_interval beacons: lowest current
+};
+
+/// How a connect without a usable fast-connect cache finds its AP
+enum class ScanMode : uint8_t {
+  /// esp_wifi_connect()'s own active scan: joins the first AP it hears
+  FirstMatch,
+  /// Scan (non-blocking), then join the strongest BSSID of the SSID. The
+  /// channels of cached APs (ApCache) are scanned on their own first
+  BestAp,
+};
+
 /// Configuration for WiFi manager
 struct WifiConfig {
   /// Maximum reconnection attempts before giving up (0 = infinite)
@@ -66,6 +88,47 @@ struct WifiConfig {
 
   /// Backoff multiplier (x2 each attempt)
   static constexpr uint8_t kBackoffMultiplier = 2;
+
+  /// Randomize each backoff over its upper half, so the probes of a site
+  /// that lost the same AP don't retry in lockstep
+  bool backoff_jitter = true;
+
+  /// A link lost below this RSSI (dBm), or an SSID no scan found, counts
+  /// as out of range: the AP won't be back within a short backoff
+  int8_t weak_rssi_dbm = -85;
+
+  /// Out of range: retry no sooner than this (ms)
+  uint32_t out_of_range_backoff_ms = 30000;
+
+  /// Out of range: fail at once (WifiState::Failed, WifiConnectionFailed)
+  /// instead of retrying - for duty-cycled callers that rather sleep and
+  /// try again on a later wake
+  bool give_up_out_of_range = false;
+
+  /// Modem sleep profile (WifiManager::set_power_save changes it live)
+  PowerSave power_save = PowerSave::Min;
+
+  /// Beacon intervals between wakes in PowerSave::Max (sent when
+  /// associating; the AP drops frames buffered longer than it allows)
+  uint16_t listen_interval = 3;
+
+  ScanMode scan_mode = ScanMode::FirstMatch;
+
+  /// BestAp: listen for beacons instead of probing on cached channels. A
+  /// full scan always probes: a passive one would listen ~13x as long
+  bool passive_scan = true;
+
+  /// BestAp: time per channel (ms). Passive needs one beacon (~102 ms)
+  uint16_t passive_dwell_ms = 120;
+  uint16_t active_dwell_ms = 60;
+
+  /// BestAp: another BSSID only replaces the last one when it is this
+  /// much stronger, so two similar APs don't alternate every wake
+  uint8_t roam_hysteresis_db = 6;
+
+  /// BestAp: a fast connect to an AP last seen weaker than this scans
+  /// first (and may roam)
+  int8_t roam_rssi_dbm = -75;
 };
 
 /// Provisioning configuration
@@ -86,15 +149,124 @@ struct ProvisioningConfig {
 /// IPv4 address as 4-byte array
 using IPv4Address = std::array<uint8_t, 4>;
 
+/// BSSID (AP MAC address)
+using Bssid = std::array<uint8_t, 6>;
+
 /// Connection info after successful connection
 struct ConnectionInfo {
   IPv4Address ip{};
   IPv4Address gateway{};
   IPv4Address netmask{};
+  IPv4Address dns{};
+  Bssid bssid{};
   int8_t rssi = 0;
   uint8_t channel = 0;
 };
 
+/// What a reconnect to the same AP needs to skip the all-channel scan and
+/// DHCP. The caller keeps it between connects (e.g. in RTC memory over
+/// deep sleep), see WifiManager::set_fast_connect().
+struct FastConnect {
+  Bssid bssid{};
+  uint8_t channel = 0; ///< 0 = empty
+  IPv4Address ip{};    ///< 0.0.0.0 = lease one with DHCP
+  IPv4Address gateway{};
+  IPv4Address netmask{};
+  IPv4Address dns{};
+
+  [[nodiscard]] bool is_valid() const { return channel != 0; }
+  [[nodiscard]] bool has_ip() const { return ip != IPv4Address{}; }
+
+  /// Keep the directed connect but lease a fresh address
+  void forget_ip() { ip = {}; }
+
+  [[nodiscard]] static FastConnect from(const ConnectionInfo &info) {
+    return {
+        .bssid = info.bssid,
+        .channel = info.channel,
+        .ip = info.ip,
+        .gateway = info.gateway,
+        .netmask = info.netmask,
+        .dns = info.dns,
+    };
+  }
+};
+
+/// An access point a scan (or a connect) saw
+struct ApRecord {
+  Bssid bssid{};
+  uint8_t channel = 0; ///< 0 = empty slot
+  int8_t rssi = 0;
+};
+
+/// The APs of the SSID, strongest first, and the one last joined. The
+/// caller keeps it between connects like FastConnect (RTC memory), see
+/// WifiManager::set_ap_cache()
+struct ApCache {
+  static constexpr size_t kMaxAps = 4;
+
+  std::array<ApRecord, kMaxAps> aps{};
+  Bssid last{}; ///< Last BSSID associated with
+
+  [[nodiscard]] bool empty() const { return aps[0].channel == 0; }
+
+  /// Channels to scan (bit n = channel n, wifi_scan_channel_bitmap_t)
+  [[nodiscard]] uint16_t channel_mask() const {
+    uint16_t mask = 0;
+    for (const auto &ap : aps) {
+      if (ap.channel != 0 && ap.channel < 16) {
+        mask |= static_cast<uint16_t>(1U << ap.channel);
+      }
+    }
+    return mask;
+  }
+
+  [[nodiscard]] const ApRecord *find(const Bssid &bssid) const {
+    for (const auto &ap : aps) {
+      if (ap.channel != 0 && ap.bssid == bssid) {
+        return &ap;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Add or update an AP, keeping the strongest kMaxAps
+  void insert(const ApRecord &record) {
+    auto end = aps.end();
+    auto slot = std::find_if(aps.begin(), end, [&](const ApRecord &ap) {
+      return ap.channel == 0 || ap.bssid == record.bssid;
+    });
+    if (slot == end) {
+      slot = end - 1; // Weakest
+      if (record.rssi <= slot->rssi) {
+        return;
+      }
+    }
+    *slot = record;
+    std::stable_sort(aps.begin(), end,
+                     [](const ApRecord &a, const ApRecord &b) {
+                       if ((a.channel == 0) != (b.channel == 0)) {
+                         return b.channel == 0;
+                       }
+                       return a.rssi > b.rssi;
+                     });
+  }
+};
+
+/// AP of found to join: the strongest, unless last is among them and
+/// less than hysteresis_db weaker
+/// @return Index into found.aps (found must not be empty)
+[[nodiscard]] inline size_t select_ap(const ApCache &found, const Bssid &last,
+                                      uint8_t hysteresis_db) {
+  for (size_t i = 0; i < found.aps.size(); ++i) {
+    const auto &ap = found.aps.at(i);
+    if (ap.channel != 0 && ap.bssid == last) {
+      return found.aps[0].rssi - ap.rssi < hysteresis_db ? i : 0;
+    }
+  }
+  return 0;
+}
+
 /// WiFi manager events (published via event bus)
 /// Subscribe to NETWORK_EVENTS base with these IDs
 enum class NetworkEvent : int32_t {
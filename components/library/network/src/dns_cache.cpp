@@ -0,0 +1,152 @@
+/**
+ * @file dns_cache.cpp
+ * @brief DNS cache and the lwIP netconn resolve hook
+ */
+
+#include "network/dns_cache.hpp"
+
+#include <core/rtc_storage.hpp>
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_rtc_time.h>
+#include <lwip/api.h>
+#include <lwip/ip_addr.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace network {
+
+namespace {
+constexpr const char *TAG = "dns_cache";
+
+struct DnsEntry {
+  std::array<char, DnsCache::kMaxHostLen + 1> host; ///< Empty: unused
+  uint32_t addr;          ///< IPv4, network byte order
+  int64_t expires_rtc_us; ///< esp_rtc_get_time_us() deadline
+};
+
+struct DnsCacheRecord {
+  std::array<DnsEntry, DnsCache::kMaxEntries> entries;
+};
+
+RTC_DATA_ATTR core::RtcValue<DnsCacheRecord> g_rtc_dns;
+
+/// Set while the hook resolves a miss through lwIP (which calls it again)
+thread_local bool t_resolving = false;
+
+[[nodiscard]] int64_t rtc_now_us() {
+  return static_cast<int64_t>(esp_rtc_get_time_us());
+}
+
+[[nodiscard]] bool is_fresh(const DnsEntry &entry, int64_t now_us) {
+  return entry.host[0] != '\0' && entry.expires_rtc_us > now_us;
+}
+} // namespace
+
+DnsCache &DnsCache::instance() {
+  static DnsCache instance;
+  return instance;
+}
+
+std::optional<uint32_t> DnsCache::lookup(const char *host) {
+  core::LockGuard lock(mutex_);
+  if (!g_rtc_dns.is_valid()) {
+    return std::nullopt;
+  }
+  int64_t now_us = rtc_now_us();
+  for (const auto &entry : g_rtc_dns.value.entries) {
+    if (is_fresh(entry, now_us) && strcmp(entry.host.data(), host) == 0) {
+      return entry.addr;
+    }
+  }
+  return std::nullopt;
+}
+
+void DnsCache::store(const char *host, uint32_t addr) {
+  size_t len = strlen(host);
+  if (config_.ttl_s == 0 || len > kMaxHostLen) {
+    return;
+  }
+  core::LockGuard lock(mutex_);
+  auto record = g_rtc_dns.get();
+  int64_t now_us = rtc_now_us();
+
+  // The host's own slot, else a stale one, else the soonest to expire
+  auto &entries = record.entries;
+  auto slot = std::ranges::find_if(entries, [&](const DnsEntry &entry) {
+    return strcmp(entry.host.data(), host) == 0;
+  });
+  if (slot == entries.end()) {
+    slot = std::ranges::find_if(entries, [&](const DnsEntry &entry) {
+      return !is_fresh(entry, now_us);
+    });
+  }
+  if (slot == entries.end()) {
+    slot = std::ranges::min_element(entries, {}, &DnsEntry::expires_rtc_us);
+  }
+
+  *slot = {};
+  std::copy_n(host, len, slot->host.begin());
+  slot->addr = addr;
+  slot->expires_rtc_us =
+      now_us + (static_cast<int64_t>(config_.ttl_s) * 1'000'000);
+  g_rtc_dns.set(record);
+}
+
+void DnsCache::clear() {
+  core::LockGuard lock(mutex_);
+  g_rtc_dns.clear();
+}
+
+size_t DnsCache::size() {
+  core::LockGuard lock(mutex_);
+  if (!g_rtc_dns.is_valid()) {
+    return 0;
+  }
+  int64_t now_us = rtc_now_us();
+  return static_cast<size_t>(
+      std::ranges::count_if(g_rtc_dns.value.entries, [&](const auto &entry) {
+        return is_fresh(entry, now_us);
+      }));
+}
+
+} // namespace network
+
+/// netconn_gethostbyname() calls this first (getaddrinfo() included)
+/// @return 1 if *addr and *err are the answer, 0 to let lwIP resolve
+extern "C" int lwip_hook_netconn_external_resolve(const char *name,
+                                                  ip_addr_t *addr,
+                                                  u8_t addrtype,
+                                                  err_t *err) {
+  using network::dns_cache;
+
+  ip4_addr_t literal{};
+  if (network::t_resolving || ip4addr_aton(name, &literal) != 0) {
+    return 0;
+  }
+#if LWIP_IPV4 && LWIP_IPV6
+  if (addrtype == NETCONN_DNS_IPV6) {
+    return 0;
+  }
+#else
+  (void)addrtype;
+#endif
+
+  if (auto cached = dns_cache().lookup(name)) {
+    ESP_LOGD(network::TAG, "%s: cached", name);
+    ip_addr_set_ip4_u32(addr, *cached);
+    *err = ERR_OK;
+    return 1;
+  }
+
+  network::t_resolving = true;
+  *err = netconn_gethostbyname_addrtype(name, addr, addrtype);
+  network::t_resolving = false;
+  if (*err == ERR_OK && IP_IS_V4(addr)) {
+    dns_cache().store(name, ip4_addr_get_u32(ip_2_ip4(addr)));
+  }
+  return 1;
+}
@@ -4,11 +4,20 @@
  */
 
 #include "network/sntp.hpp"
-#include "network/wifi_manager.hpp" // For NETWORK_EVENTS
+#include "network/wifi_manager.hpp" // For WifiConnectedEvent
 
+#include <core/clock.hpp>
+#include <core/rtc_storage.hpp>
+
+#include <esp_attr.h>
 #include <esp_log.h>
+#include <esp_rtc_time.h>
 #include <esp_sntp.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdlib>
 #include <ctime>
 #include <sys/time.h>
 
@@ -17,6 +26,40 @@ namespace network {
 namespace {
 constexpr const char *TAG = "sntp";
 constexpr int kMinValidYear = 2026;
+
+/// Error of a sync itself (NTP over WiFi, rounded up)
+constexpr int64_t kSyncErrorMs = 100;
+
+/// Shortest span that measures the drift: over a shorter one the syncs'
+/// own error would dominate
+constexpr int64_t kMinCalibrationUs = 30LL * 60 * 1'000'000;
+
+/// Measurements beyond this are a reset RTC counter, not drift
+constexpr float kMaxDriftPpm = 50'000.0F;
+
+/// Last sync and the RTC clock's drift, kept across deep sleep
+struct TimeSyncRecord {
+  int64_t epoch_ms;        ///< NTP time at the last sync
+  int64_t rtc_us;          ///< esp_rtc_get_time_us() at the same moment
+  int64_t anchor_epoch_ms; ///< Start of the drift measurement span
+  int64_t anchor_rtc_us;
+  float drift_ppm; ///< RTC clock gain over real time (positive: fast)
+  bool calibrated; ///< drift_ppm measured, not assumed 0
+};
+
+RTC_DATA_ATTR core::RtcValue<TimeSyncRecord> g_rtc_time_sync;
+
+[[nodiscard]] int64_t rtc_now_us() {
+  return static_cast<int64_t>(esp_rtc_get_time_us());
+}
+
+/// The record's time plus the RTC time since, drift removed
+[[nodiscard]] int64_t estimate_epoch_ms(const TimeSyncRecord &sync,
+                                        int64_t rtc_us) {
+  double elapsed_us = static_cast<double>(rtc_us - sync.rtc_us);
+  double real_us = elapsed_us / (1.0 + (sync.drift_ppm * 1e-6));
+  return sync.epoch_ms + static_cast<int64_t>(real_us / 1000.0);
+}
 } // namespace
 
 Sntp &Sntp::instance() {
@@ -26,6 +69,7 @@ Sntp &Sntp::instance() {
 
 Sntp::Sntp() {
   event_group_ = xEventGroupCreate();
+  restore();
   register_events();
 }
 
@@ -41,8 +85,8 @@ void Sntp::register_events() {
     return;
   }
 
-  wifi_sub_ = core::events().subscribe(
-      NETWORK_EVENTS, NetworkEvent::WifiConnected, on_network_event, this);
+  wifi_sub_ =
+      core::subscribe<WifiConnectedEvent, &Sntp::on_wifi_connected>(this);
 
   xEventGroupSetBits(event_group_, kBitRegistered);
   ESP_LOGI(TAG, "Registered for WiFi events");
@@ -52,6 +96,13 @@ void Sntp::do_init() {
   if ((xEventGroupGetBits(event_group_) & kBitInitialized) != 0) {
     return;
   }
+  if (!needs_sync()) {
+    // A device that stays connected sees no next connect: re-check then
+    ESP_LOGI(TAG, "Time good to %" PRIu32 " ms, skipping NTP",
+             error_bound_ms());
+    schedule_resync();
+    return;
+  }
 
   // Set timezone
   setenv("TZ", config_.timezone, 1);
@@ -74,18 +125,123 @@ void Sntp::do_init() {
   ESP_LOGI(TAG, "SNTP initialized, waiting for sync...");
 }
 
-void Sntp::on_time_sync(struct timeval * /*tv*/) {
-  ESP_LOGI(TAG, "Time synchronized");
-  xEventGroupSetBits(instance().event_group_, kBitSynced);
+void Sntp::restore() {
+  if (!g_rtc_time_sync.is_valid()) {
+    return;
+  }
+  const auto &sync = g_rtc_time_sync.value;
+  int64_t rtc_us = rtc_now_us();
+  if (rtc_us < sync.rtc_us) {
+    g_rtc_time_sync.clear(); // RTC counter reset since
+    return;
+  }
+
+  int64_t now_ms = estimate_epoch_ms(sync, rtc_us);
+  timeval tv{.tv_sec = static_cast<time_t>(now_ms / 1000),
+             .tv_usec = static_cast<suseconds_t>((now_ms % 1000) * 1000)};
+  settimeofday(&tv, nullptr);
+  core::clock::set_epoch_ms(now_ms);
+  xEventGroupSetBits(event_group_, kBitSynced);
+  ESP_LOGI(TAG, "Time restored from RTC, good to %" PRIu32 " ms (drift %s)",
+           error_bound_ms(), sync.calibrated ? "compensated" : "unknown");
+}
+
+void Sntp::schedule_resync() {
+  if (!g_rtc_time_sync.is_valid()) {
+    return;
+  }
+  uint32_t ppm = drift_ppm();
+  if (ppm == 0) {
+    return; // Bound never grows
+  }
+  const auto &sync = g_rtc_time_sync.value;
+  int64_t elapsed_ms = (rtc_now_us() - sync.rtc_us) / 1000;
+  int64_t limit_ms =
+      (static_cast<int64_t>(config_.max_error_ms) - kSyncErrorMs) *
+      1'000'000 / ppm;
+  // At least a second, so a bound right at the limit does not spin
+  int64_t delay_ms = std::max<int64_t>(limit_ms - elapsed_ms, 1000);
+
+  (void)resync_timer_.stop();
+  if (!resync_timer_.start(std::chrono::milliseconds(delay_ms))) {
+    ESP_LOGW(TAG, "Failed to arm the re-check, waiting for a connect");
+    return;
+  }
+  ESP_LOGI(TAG, "Re-checking time in %" PRId64 " s", delay_ms / 1000);
+}
+
+uint32_t Sntp::drift_ppm() const {
+  return g_rtc_time_sync.value.calibrated ? config_.calibrated_drift_ppm
+                                          : config_.uncalibrated_drift_ppm;
+}
+
+uint32_t Sntp::error_bound_ms() const {
+  if (!g_rtc_time_sync.is_valid()) {
+    return UINT32_MAX;
+  }
+  const auto &sync = g_rtc_time_sync.value;
+  int64_t elapsed_ms = (rtc_now_us() - sync.rtc_us) / 1000;
+  if (elapsed_ms < 0) {
+    return UINT32_MAX;
+  }
+  uint32_t ppm = drift_ppm();
+  int64_t bound = kSyncErrorMs + (elapsed_ms * ppm / 1'000'000);
+  return bound < UINT32_MAX ? static_cast<uint32_t>(bound) : UINT32_MAX;
+}
+
+void Sntp::record_sync(int64_t epoch_ms) {
+  int64_t rtc_us = rtc_now_us();
+  TimeSyncRecord sync{
+      .epoch_ms = epoch_ms,
+      .rtc_us = rtc_us,
+      .anchor_epoch_ms = epoch_ms,
+      .anchor_rtc_us = rtc_us,
+      .drift_ppm = 0.0F,
+      .calibrated = false,
+  };
+
+  if (g_rtc_time_sync.is_valid()) {
+    const auto &last = g_rtc_time_sync.value;
+    sync.drift_ppm = last.drift_ppm;
+    sync.calibrated = last.calibrated;
+    int64_t rtc_span_us = rtc_us - last.anchor_rtc_us;
+    int64_t real_span_us = (epoch_ms - last.anchor_epoch_ms) * 1000;
+    if (rtc_span_us < kMinCalibrationUs && rtc_span_us >= 0) {
+      // Too short to measure: keep extending the span
+      sync.anchor_epoch_ms = last.anchor_epoch_ms;
+      sync.anchor_rtc_us = last.anchor_rtc_us;
+    } else if (real_span_us > 0) {
+      auto measured = static_cast<float>(
+          static_cast<double>(rtc_span_us - real_span_us) * 1e6 /
+          static_cast<double>(real_span_us));
+      if (std::abs(measured) < kMaxDriftPpm) {
+        // Averaged, so one sync's own error moves the estimate little
+        sync.drift_ppm = last.calibrated
+                             ? ((3.0F * last.drift_ppm) + measured) / 4.0F
+                             : measured;
+        sync.calibrated = true;
+        ESP_LOGI(TAG, "RTC drift %.0f ppm (measured %.0f ppm)",
+                 static_cast<double>(sync.drift_ppm),
+                 static_cast<double>(measured));
+      }
+    }
+  }
+  g_rtc_time_sync.set(sync);
 }
 
-void Sntp::on_network_event(void *arg, esp_event_base_t /*base*/,
-                            int32_t event_id, void * /*event_data*/) {
-  if (event_id == static_cast<int32_t>(NetworkEvent::WifiConnected)) {
-    static_cast<Sntp *>(arg)->do_init();
+void Sntp::on_time_sync(struct timeval *tv) {
+  ESP_LOGI(TAG, "Time synchronized");
+  if (tv != nullptr) {
+    int64_t epoch_ms =
+        (static_cast<int64_t>(tv->tv_sec) * 1000) + (tv->tv_usec / 1000);
+    core::clock::set_epoch_ms(epoch_ms);
+    record_sync(epoch_ms);
   }
+  xEventGroupSetBits(instance().event_group_, kBitSynced);
 }
 
+void Sntp::on_wifi_connected(const ConnectionInfo & /*info*/) { do_init(); }
+
 bool Sntp::is_synced() const {
   // Check event group flag first (fast path)
   if ((xEventGroupGetBits(event_group_) & kBitSynced) == 0) {
@@ -5,7 +5,14 @@
 
 #include "network/wifi_manager.hpp"
 
+#include <core/fault.hpp>
+#include <core/metrics.hpp>
+#include <core/wake_profile.hpp>
+
+#include <esp_bt.h>
 #include <esp_log.h>
+#include <esp_random.h>
+#include <esp_system.h>
 #include <esp_wifi.h>
 #include <wifi_provisioning/manager.h>
 #include <wifi_provisioning/scheme_ble.h>
@@ -29,8 +36,28 @@ void publish_event(NetworkEvent event, const void *data = nullptr,
                  0);
 }
 
-template <typename T> void publish_event(NetworkEvent event, const T *data) {
-  publish_event(event, data, sizeof(T));
+wifi_ps_type_t to_ps_type(PowerSave mode) {
+  switch (mode) {
+  case PowerSave::None:
+    return WIFI_PS_NONE;
+  case PowerSave::Max:
+    return WIFI_PS_MAX_MODEM;
+  case PowerSave::Min:
+  default:
+    return WIFI_PS_MIN_MODEM;
+  }
+}
+
+esp_ip4_addr_t to_ip4(const IPv4Address &address) {
+  esp_ip4_addr_t ip{};
+  esp_netif_set_ip4_addr(&ip, address[0], address[1], address[2],
+                         address[3]);
+  return ip;
+}
+
+IPv4Address from_ip4(const esp_ip4_addr_t &ip) {
+  return {esp_ip4_addr1(&ip), esp_ip4_addr2(&ip), esp_ip4_addr3(&ip),
+          esp_ip4_addr4(&ip)};
 }
 
 } // namespace
@@ -74,7 +101,7 @@ core::Status WifiManager::init(core::IStorage &storage,
   wifi_init_config_t wifi_init = WIFI_INIT_CONFIG_DEFAULT();
   if (auto err = esp_wifi_init(&wifi_init); err != ESP_OK) {
     ESP_LOGE(TAG, "esp_wifi_init failed: %s", esp_err_to_name(err));
-    return core::Err(err);
+    return core::Fail(err);
   }
 
   // Set storage mode to RAM (we manage credentials ourselves)
@@ -83,7 +110,12 @@ core::Status WifiManager::init(core::IStorage &storage,
   // Set station mode
   if (auto err = esp_wifi_set_mode(WIFI_MODE_STA); err != ESP_OK) {
     ESP_LOGE(TAG, "esp_wifi_set_mode failed: %s", esp_err_to_name(err));
-    return core::Err(err);
+    return core::Fail(err);
+  }
+
+  if (auto err = esp_wifi_set_ps(to_ps_type(config_.power_save));
+      err != ESP_OK) {
+    ESP_LOGW(TAG, "esp_wifi_set_ps failed: %s", esp_err_to_name(err));
   }
 
   // Subscribe to WiFi events
@@ -97,7 +129,7 @@ core::Status WifiManager::init(core::IStorage &storage,
   // Start WiFi
   if (auto err = esp_wifi_start(); err != ESP_OK) {
     ESP_LOGE(TAG, "esp_wifi_start failed: %s", esp_err_to_name(err));
-    return core::Err(err);
+    return core::Fail(err);
   }
 
   initialized_ = true;
@@ -164,6 +196,10 @@ core::Status WifiManager::start_provisioning(const ProvisioningConfig &config) {
   if (!initialized_) {
     return core::Err(ESP_ERR_INVALID_STATE);
   }
+  if (ble_released_) {
+    ESP_LOGE(TAG, "BLE memory released, reboot to provision");
+    return core::Err(ESP_ERR_INVALID_STATE);
+  }
 
   // Enforce PoP for security - never allow unsecured provisioning
   if (config.pop == nullptr || config.pop[0] == '\0') {
@@ -223,17 +259,13 @@ core::Status WifiManager::start_provisioning(const ProvisioningConfig &config) {
       err != ESP_OK) {
     ESP_LOGE(TAG, "Failed to start provisioning: %s", esp_err_to_name(err));
     wifi_prov_mgr_deinit();
+    ble_released_ = true;
     return core::Err(err);
   }
 
   // Start provisioning timeout timer
   if (config.timeout_sec > 0) {
-    if (!prov_timeout_timer_) {
-      prov_timeout_timer_ =
-          std::make_unique<core::OneShotTimer>([this]() { on_prov_timeout(); });
-    }
-    (void)prov_timeout_timer_->stop();
-    (void)prov_timeout_timer_->start(std::chrono::seconds(config.timeout_sec));
+    (void)prov_timeout_timer_.start(std::chrono::seconds(config.timeout_sec));
   }
 
   set_state(WifiState::Provisioning);
@@ -248,12 +280,11 @@ core::Status WifiManager::stop_provisioning() {
   }
 
   // Stop timeout timer
-  if (prov_timeout_timer_) {
-    (void)prov_timeout_timer_->stop();
-  }
+  (void)prov_timeout_timer_.stop();
 
   wifi_prov_mgr_stop_provisioning();
-  wifi_prov_mgr_deinit();
+  wifi_prov_mgr_deinit(); // Frees BLE (FREE_BLE scheme handler)
+  ble_released_ = true;
   prov_sub_.unsubscribe();
 
   set_state(WifiState::Disconnected);
@@ -261,6 +292,38 @@ core::Status WifiManager::stop_provisioning() {
   return core::Ok();
 }
 
+core::Status WifiManager::release_ble() {
+  if (ble_released_) {
+    return core::Ok();
+  }
+  if (state_ == WifiState::Provisioning) {
+    return core::Err(ESP_ERR_INVALID_STATE);
+  }
+
+  if (auto err = esp_bt_controller_mem_release(ESP_BT_MODE_BLE);
+      err != ESP_OK) {
+    ESP_LOGW(TAG, "BLE memory release failed: %s", esp_err_to_name(err));
+    return core::Err(err);
+  }
+  ble_released_ = true;
+  ESP_LOGI(TAG, "BLE memory released, %lu bytes free",
+           static_cast<unsigned long>(esp_get_free_heap_size()));
+  return core::Ok();
+}
+
+core::Status WifiManager::set_power_save(PowerSave mode) {
+  if (!initialized_) {
+    return core::Err(ESP_ERR_INVALID_STATE);
+  }
+  if (auto err = esp_wifi_set_ps(to_ps_type(mode)); err != ESP_OK) {
+    ESP_LOGW(TAG, "esp_wifi_set_ps failed: %s", esp_err_to_name(err));
+    return core::Err(err);
+  }
+  config_.power_save = mode;
+  ESP_LOGI(TAG, "Power save: %d", static_cast<int>(mode));
+  return core::Ok();
+}
+
 bool WifiManager::has_credentials() const {
   if (storage_ == nullptr) {
     return false;
@@ -288,23 +351,23 @@ core::Result<WifiCredentials> WifiManager::load_credentials() {
 
   WifiCredentials creds{};
 
-  // Load SSID
-  auto ssid_size = storage_->get_string_size(kKeySsid);
-  if (!ssid_size || *ssid_size == 0) {
-    return core::Err(ESP_ERR_NOT_FOUND);
+  // SSID and password in one batch (password is optional for open networks)
+  std::array reads{
+      core::StorageRead::string(kKeySsid, creds.ssid),
+      core::StorageRead::string(kKeyPassword, creds.password),
+  };
+  if (auto status = storage_->get_many(reads); !status) {
+    return core::Err(status.error());
   }
-
-  if (auto err = storage_->get_string(kKeySsid,
-                                      {creds.ssid.data(), creds.ssid.size()});
-      !err) {
-    return core::Err(err.error());
+  const auto &ssid = reads[0];
+  if (!ssid.found()) {
+    return core::Err(ssid.error);
   }
-
-  // Load password (optional for open networks)
-  auto pass_size = storage_->get_string_size(kKeyPassword);
-  if (pass_size && *pass_size > 0) {
-    (void)storage_->get_string(kKeyPassword,
-                               {creds.password.data(), creds.password.size()});
+  if (ssid.size <= 1) {
+    return core::Err(ESP_ERR_NOT_FOUND);
+  }
+  if (!reads[1].found()) {
+    creds.password.fill('\0');
   }
 
   ESP_LOGI(TAG, "Loaded credentials for '%s'", creds.ssid.data());
@@ -339,6 +402,110 @@ core::Status WifiManager::start_connect(const WifiCredentials &creds) {
   // Store credentials for retry attempts
   pending_creds_ = creds;
 
+  if (needs_scan()) {
+    return start_scan(!ap_cache_.empty());
+  }
+  return associate(nullptr);
+}
+
+bool WifiManager::needs_scan() const {
+  if (config_.scan_mode != ScanMode::BestAp) {
+    return false;
+  }
+  if (!fast_connect_.is_valid()) {
+    return true;
+  }
+  const auto *cached = ap_cache_.find(fast_connect_.bssid);
+  return cached != nullptr && cached->rssi < config_.roam_rssi_dbm;
+}
+
+core::Status WifiManager::start_scan(bool cached_channels) {
+  wifi_scan_config_t scan{};
+  scan.ssid = reinterpret_cast<uint8_t *>(pending_creds_.ssid.data());
+  if (cached_channels) {
+    scan.channel_bitmap.ghz_2_channels = ap_cache_.channel_mask();
+  }
+  if (cached_channels && config_.passive_scan) {
+    scan.scan_type = WIFI_SCAN_TYPE_PASSIVE;
+    scan.scan_time.passive = config_.passive_dwell_ms;
+  } else {
+    scan.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+    scan.scan_time.active = {.min = config_.active_dwell_ms,
+                             .max = config_.active_dwell_ms};
+  }
+
+  set_state(WifiState::Connecting);
+  core::begin_phase(core::WakePhase::WifiAssoc);
+  scanning_ = true;
+  scan_limited_ = cached_channels;
+  if (auto err = esp_wifi_scan_start(&scan, false); err != ESP_OK) {
+    // The driver's own scan still finds the AP
+    ESP_LOGW(TAG, "Scan failed (%s), connecting directly",
+             esp_err_to_name(err));
+    scanning_ = false;
+    return associate(nullptr);
+  }
+  ESP_LOGI(TAG, "Scanning %s for '%s'...",
+           cached_channels ? "cached channels" : "all channels",
+           pending_creds_.ssid.data());
+  return core::Ok();
+}
+
+void WifiManager::on_scan_done() {
+  core::end_phase(core::WakePhase::WifiAssoc);
+  scanning_ = false;
+
+  // Filtered by SSID: a few records cover any site
+  std::array<wifi_ap_record_t, 8> records{};
+  auto count = static_cast<uint16_t>(records.size());
+  if (esp_wifi_scan_get_ap_records(&count, records.data()) != ESP_OK) {
+    count = 0;
+  }
+  (void)esp_wifi_clear_ap_list(); // Records beyond the first few
+
+  ApCache found{};
+  for (size_t i = 0; i < count; ++i) {
+    ApRecord record{.channel = records.at(i).primary,
+                    .rssi = records.at(i).rssi};
+    std::copy(std::begin(records.at(i).bssid), std::end(records.at(i).bssid),
+              record.bssid.begin());
+    found.insert(record);
+  }
+
+  if (found.empty()) {
+    if (scan_limited_) {
+      ESP_LOGI(TAG, "No AP on the cached channels, scanning all");
+      (void)start_scan(false);
+      return;
+    }
+    ESP_LOGW(TAG, "'%s' not found", pending_creds_.ssid.data());
+    set_state(WifiState::Disconnected);
+    schedule_reconnect(calculate_backoff(), true);
+    return;
+  }
+
+  found.last = ap_cache_.last; // Updated once associated
+  auto pick = select_ap(found, ap_cache_.last, config_.roam_hysteresis_db);
+  auto target = found.aps.at(pick);
+  ap_cache_ = found;
+  if (fast_connect_.is_valid() && fast_connect_.bssid != target.bssid) {
+    ESP_LOGI(TAG, "Roaming away from the cached AP");
+    drop_fast_connect(); // Its address may belong to another network
+  }
+  const auto &b = target.bssid;
+  ESP_LOGI(TAG,
+           "Joining %02x:%02x:%02x:%02x:%02x:%02x on channel %u (%d dBm, "
+           "%u AP(s) found)",
+           b[0], b[1], b[2], b[3], b[4], b[5], target.channel, target.rssi,
+           count);
+  if (auto status = associate(&target); !status) {
+    schedule_reconnect(calculate_backoff());
+  }
+}
+
+core::Status WifiManager::associate(const ApRecord *target) {
+  const auto &creds = pending_creds_;
+
   // Configure WiFi
   wifi_config_t wifi_config{};
   std::strncpy(reinterpret_cast<char *>(wifi_config.sta.ssid),
@@ -353,20 +520,36 @@ core::Status WifiManager::start_connect(const WifiCredentials &creds) {
   }
 
   wifi_config.sta.pmf_cfg.capable = true;
+  if (config_.power_save == PowerSave::Max) {
+    wifi_config.sta.listen_interval = config_.listen_interval;
+  }
+
+  const ApRecord fast{.bssid = fast_connect_.bssid,
+                      .channel = fast_connect_.channel};
+  if (fast_connect_.is_valid()) {
+    target = &fast;
+  }
+  if (target != nullptr) {
+    wifi_config.sta.channel = target->channel;
+    wifi_config.sta.bssid_set = true;
+    std::copy(target->bssid.begin(), target->bssid.end(),
+              wifi_config.sta.bssid);
+  }
 
   if (auto err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
       err != ESP_OK) {
     ESP_LOGE(TAG, "esp_wifi_set_config failed: %s", esp_err_to_name(err));
-    return core::Err(err);
+    return core::Fail(err);
   }
 
   ESP_LOGI(TAG, "Connecting to '%s'...", creds.ssid.data());
   set_state(WifiState::Connecting);
 
+  core::begin_phase(core::WakePhase::WifiAssoc);
   if (auto err = esp_wifi_connect(); err != ESP_OK) {
     ESP_LOGE(TAG, "esp_wifi_connect failed: %s", esp_err_to_name(err));
     set_state(WifiState::Failed);
-    return core::Err(err);
+    return core::Fail(err);
   }
 
   return core::Ok();
@@ -379,50 +562,132 @@ uint32_t WifiManager::calculate_backoff() const {
        ++i) {
     backoff *= WifiConfig::kBackoffMultiplier;
   }
-  return std::min(backoff, config_.max_backoff_ms);
+  backoff = std::min(backoff, config_.max_backoff_ms);
+  if (!config_.backoff_jitter) {
+    return backoff;
+  }
+  // Half fixed: a retry never comes right on the heels of a failure
+  uint32_t half = backoff / 2;
+  return half + (esp_random() % (backoff - half + 1));
+}
+
+bool WifiManager::is_out_of_range(uint8_t reason, int8_t rssi) const {
+  if (fast_connect_.is_valid()) {
+    // The cached channel may just be stale: the retry scans
+    return false;
+  }
+  switch (reason) {
+  case WIFI_REASON_NO_AP_FOUND:
+    return true;
+  case WIFI_REASON_BEACON_TIMEOUT:
+  case WIFI_REASON_ASSOC_FAIL:
+  case WIFI_REASON_CONNECTION_FAIL:
+  case WIFI_REASON_HANDSHAKE_TIMEOUT:
+    // Lost frames: only range if the signal was weak
+    return rssi != 0 && rssi < config_.weak_rssi_dbm;
+  default:
+    // Rejected by the AP (auth, AP restart): range isn't the problem
+    return false;
+  }
 }
 
 void WifiManager::reset_retry_state() {
   retry_count_ = 0;
-  if (reconnect_timer_) {
-    (void)reconnect_timer_->stop();
-  }
+  (void)reconnect_timer_.stop();
 }
 
-void WifiManager::schedule_reconnect(uint32_t backoff_ms) {
+void WifiManager::schedule_reconnect(uint32_t backoff_ms, bool out_of_range) {
   if (!pending_creds_.is_valid()) {
     return;
   }
 
   if (config_.max_retries != 0 && retry_count_ >= config_.max_retries) {
     ESP_LOGE(TAG, "Max retries reached");
-    set_state(WifiState::Failed);
-    publish_event(NetworkEvent::WifiConnectionFailed);
+    give_up();
     return;
   }
 
   uint32_t backoff = backoff_ms;
+  if (out_of_range) {
+    if (config_.give_up_out_of_range) {
+      ESP_LOGW(TAG, "AP out of range, giving up");
+      give_up();
+      return;
+    }
+    ESP_LOGW(TAG, "AP out of range, backing off");
+    backoff = std::max(backoff, config_.out_of_range_backoff_ms);
+  }
   ESP_LOGI(TAG, "Reconnecting in %lu ms (attempt %d)",
            static_cast<unsigned long>(backoff), retry_count_ + 1);
   retry_count_++;
+  core::metrics().wifi_retries.add();
 
-  // Initialize timer lazily (needs 'this' pointer)
-  if (!reconnect_timer_) {
-    reconnect_timer_ = std::make_unique<core::OneShotTimer>(
-        [this]() { on_reconnect_timer(); });
-  }
+  (void)reconnect_timer_.start(std::chrono::milliseconds(backoff));
+}
 
-  (void)reconnect_timer_->stop();
-  (void)reconnect_timer_->start(std::chrono::milliseconds(backoff));
+void WifiManager::give_up() {
+  (void)reconnect_timer_.stop();
+  set_state(WifiState::Failed);
+  publish_event(NetworkEvent::WifiConnectionFailed);
 }
 
 void WifiManager::on_reconnect_timer() {
   if (state_ == WifiState::Disconnected && pending_creds_.is_valid()) {
+    if (fast_connect_.is_valid()) {
+      // The cached AP didn't answer: scan for the SSID instead
+      ESP_LOGI(TAG, "Fast connect failed, scanning all channels");
+      drop_fast_connect();
+      (void)start_connect(pending_creds_);
+      return;
+    }
+    if (config_.scan_mode == ScanMode::BestAp) {
+      (void)start_connect(pending_creds_); // Scan again
+      return;
+    }
     set_state(WifiState::Connecting);
+    core::begin_phase(core::WakePhase::WifiAssoc);
     esp_wifi_connect();
   }
 }
 
+void WifiManager::apply_static_ip() {
+  esp_netif_ip_info_t ip_info{
+      .ip = to_ip4(fast_connect_.ip),
+      .netmask = to_ip4(fast_connect_.netmask),
+      .gw = to_ip4(fast_connect_.gateway),
+  };
+
+  if (auto err = esp_netif_dhcpc_stop(netif_);
+      err != ESP_OK && err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+    ESP_LOGW(TAG, "DHCP stop failed: %s", esp_err_to_name(err));
+    fast_connect_.forget_ip();
+    return;
+  }
+  // Posts IP_EVENT_STA_GOT_IP, which completes the connection as usual
+  if (auto err = esp_netif_set_ip_info(netif_, &ip_info); err != ESP_OK) {
+    ESP_LOGW(TAG, "Static IP failed: %s", esp_err_to_name(err));
+    fast_connect_.forget_ip();
+    (void)esp_netif_dhcpc_start(netif_);
+    return;
+  }
+  static_ip_ = true;
+
+  if (fast_connect_.dns != IPv4Address{}) {
+    esp_netif_dns_info_t dns{};
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    dns.ip.u_addr.ip4 = to_ip4(fast_connect_.dns);
+    (void)esp_netif_set_dns_info(netif_, ESP_NETIF_DNS_MAIN, &dns);
+  }
+}
+
+void WifiManager::drop_fast_connect() {
+  fast_connect_ = {};
+  if (static_ip_) {
+    static_ip_ = false;
+    (void)esp_netif_dhcpc_start(netif_);
+  }
+}
+
 void WifiManager::on_prov_timeout() {
   ESP_LOGW(TAG, "Provisioning timeout - stopping");
   publish_event(NetworkEvent::ProvisioningTimeout);
@@ -451,13 +716,28 @@ void WifiManager::wifi_event_handler(void *arg, esp_event_base_t /*base*/,
     ESP_LOGD(TAG, "WIFI_EVENT_STA_START");
     break;
 
+  case WIFI_EVENT_SCAN_DONE:
+    if (self->scanning_) {
+      self->on_scan_done();
+    }
+    break;
+
   case WIFI_EVENT_STA_CONNECTED:
     ESP_LOGI(TAG, "Connected to AP");
+    core::end_phase(core::WakePhase::WifiAssoc);
+    core::begin_phase(core::WakePhase::Dhcp);
+    if (self->fast_connect_.has_ip() && !self->static_ip_) {
+      self->apply_static_ip();
+    }
     break;
 
   case WIFI_EVENT_STA_DISCONNECTED: {
     auto *info = static_cast<wifi_event_sta_disconnected_t *>(event_data);
-    ESP_LOGW(TAG, "Disconnected from AP, reason: %d", info->reason);
+    ESP_LOGW(TAG, "Disconnected from AP, reason: %d, RSSI: %d dBm",
+             info->reason, info->rssi);
+    // A failed attempt counts in full; the backoff doesn't
+    core::end_phase(core::WakePhase::WifiAssoc);
+    core::end_phase(core::WakePhase::Dhcp);
 
     if (self->state_ == WifiState::Provisioning) {
       // Don't reconnect during provisioning
@@ -470,7 +750,8 @@ void WifiManager::wifi_event_handler(void *arg, esp_event_base_t /*base*/,
 
     // Schedule non-blocking reconnect with backoff
     uint32_t backoff = self->calculate_backoff();
-    self->schedule_reconnect(backoff);
+    self->schedule_reconnect(backoff,
+                             self->is_out_of_range(info->reason, info->rssi));
     break;
   }
 
@@ -486,35 +767,39 @@ void WifiManager::ip_event_handler(void *arg, esp_event_base_t /*base*/,
   if (event_id == IP_EVENT_STA_GOT_IP) {
     auto *info = static_cast<ip_event_got_ip_t *>(event_data);
     ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&info->ip_info.ip));
+    core::end_phase(core::WakePhase::Dhcp);
 
     // Store connection info
-    self->conn_info_.ip[0] = esp_ip4_addr1(&info->ip_info.ip);
-    self->conn_info_.ip[1] = esp_ip4_addr2(&info->ip_info.ip);
-    self->conn_info_.ip[2] = esp_ip4_addr3(&info->ip_info.ip);
-    self->conn_info_.ip[3] = esp_ip4_addr4(&info->ip_info.ip);
-
-    self->conn_info_.gateway[0] = esp_ip4_addr1(&info->ip_info.gw);
-    self->conn_info_.gateway[1] = esp_ip4_addr2(&info->ip_info.gw);
-    self->conn_info_.gateway[2] = esp_ip4_addr3(&info->ip_info.gw);
-    self->conn_info_.gateway[3] = esp_ip4_addr4(&info->ip_info.gw);
-
-    self->conn_info_.netmask[0] = esp_ip4_addr1(&info->ip_info.netmask);
-    self->conn_info_.netmask[1] = esp_ip4_addr2(&info->ip_info.netmask);
-    self->conn_info_.netmask[2] = esp_ip4_addr3(&info->ip_info.netmask);
-    self->conn_info_.netmask[3] = esp_ip4_addr4(&info->ip_info.netmask);
+    self->conn_info_.ip = from_ip4(info->ip_info.ip);
+    self->conn_info_.gateway = from_ip4(info->ip_info.gw);
+    self->conn_info_.netmask = from_ip4(info->ip_info.netmask);
+
+    esp_netif_dns_info_t dns{};
+    if (esp_netif_get_dns_info(self->netif_, ESP_NETIF_DNS_MAIN, &dns) ==
+            ESP_OK &&
+        dns.ip.type == ESP_IPADDR_TYPE_V4) {
+      self->conn_info_.dns = from_ip4(dns.ip.u_addr.ip4);
+    }
 
     // Get RSSI
     wifi_ap_record_t ap_info;
     if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
       self->conn_info_.rssi = ap_info.rssi;
+      core::metrics().wifi_rssi.set(ap_info.rssi);
       self->conn_info_.channel = ap_info.primary;
+      std::copy(std::begin(ap_info.bssid), std::end(ap_info.bssid),
+                self->conn_info_.bssid.begin());
+      self->ap_cache_.last = self->conn_info_.bssid;
+      self->ap_cache_.insert({.bssid = self->conn_info_.bssid,
+                              .channel = self->conn_info_.channel,
+                              .rssi = self->conn_info_.rssi});
     }
 
     self->reset_retry_state();
     self->set_state(WifiState::Connected);
 
     // Publish connected event with connection info
-    publish_event(NetworkEvent::WifiConnected, &self->conn_info_);
+    (void)core::publish<WifiConnectedEvent>(self->conn_info_, 0);
   }
 }
 
@@ -562,10 +847,9 @@ void WifiManager::prov_event_handler(void *arg, esp_event_base_t /*base*/,
   case WIFI_PROV_END:
     ESP_LOGI(TAG, "Provisioning ended");
     // Stop timeout timer - provisioning succeeded
-    if (self->prov_timeout_timer_) {
-      (void)self->prov_timeout_timer_->stop();
-    }
-    wifi_prov_mgr_deinit();
+    (void)self->prov_timeout_timer_.stop();
+    wifi_prov_mgr_deinit(); // Frees BLE (FREE_BLE scheme handler)
+    self->ble_released_ = true;
     self->prov_sub_.unsubscribe();
     publish_event(NetworkEvent::ProvisioningComplete);
     // State will change to Connected when IP is obtained
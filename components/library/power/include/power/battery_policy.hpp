@@ -0,0 +1,106 @@
+/**
+ * @file battery_policy.hpp
+ * @brief Battery levels and how far they stretch the device's intervals
+ *
+ * A falling cell first buys time: on Low and Critical the application
+ * multiplies its sample, upload and poll intervals, so the radio - the
+ * largest load - runs less often. At Shutdown it stops before a WiFi TX
+ * burst can pull the supply under the brownout threshold in the middle of
+ * a TLS handshake or a flash write, and deep-sleeps, checking again now
+ * and then (a cold lithium cell recovers as it warms up).
+ *
+ * A level only improves once the voltage is hysteresis_v above its
+ * threshold, so a cell sitting at a threshold doesn't flip the intervals
+ * back and forth (the voltage sags under load and recovers at rest).
+ *
+ * The defaults suit a CR123A powering the ESP32-C3 directly: the cell is
+ * flat around 3.0 V for most of its life, then falls off quickly.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace power {
+
+/// Battery state, ordered from healthy to empty
+enum class BatteryLevel : uint8_t {
+  Normal,   ///< Configured intervals
+  Low,      ///< Intervals stretched by low_stretch
+  Critical, ///< Intervals stretched by critical_stretch
+  Shutdown, ///< No radio: deep sleep until the cell has recovered
+};
+
+[[nodiscard]] inline const char *to_string(BatteryLevel level) {
+  switch (level) {
+  case BatteryLevel::Normal:
+    return "normal";
+  case BatteryLevel::Low:
+    return "low";
+  case BatteryLevel::Critical:
+    return "critical";
+  case BatteryLevel::Shutdown:
+    return "shutdown";
+  default:
+    return "unknown";
+  }
+}
+
+/// Thresholds (cell voltage under light load) and interval factors
+struct BatteryPolicy {
+  float low_v{2.9F};
+  float critical_v{2.8F};
+  float shutdown_v{2.7F};
+  /// Margin above a threshold before the level improves again
+  float hysteresis_v{0.1F};
+  /// Readings below this are no cell at all (USB supply, divider not
+  /// fitted): treated as Normal
+  float absent_v{2.0F};
+  uint32_t low_stretch{2};
+  uint32_t critical_stretch{4};
+};
+
+/// Level for a voltage reading, given the level before it
+[[nodiscard]] constexpr BatteryLevel
+classify_battery(const BatteryPolicy &policy, float volts,
+                 BatteryLevel previous) {
+  if (volts < policy.absent_v) {
+    return BatteryLevel::Normal;
+  }
+  auto level_at = [&](float margin) {
+    if (volts < policy.shutdown_v + margin) {
+      return BatteryLevel::Shutdown;
+    }
+    if (volts < policy.critical_v + margin) {
+      return BatteryLevel::Critical;
+    }
+    if (volts < policy.low_v + margin) {
+      return BatteryLevel::Low;
+    }
+    return BatteryLevel::Normal;
+  };
+  auto level = level_at(0.0F);
+  if (level >= previous) {
+    return level; // Worse (or unchanged) right away
+  }
+  // Better only with the margin, and never worse than before
+  auto recovered = level_at(policy.hysteresis_v);
+  return recovered < previous ? recovered : previous;
+}
+
+/// Factor the intervals are multiplied by (0 for Shutdown: nothing runs)
+[[nodiscard]] constexpr uint32_t interval_stretch(const BatteryPolicy &policy,
+                                                  BatteryLevel level) {
+  switch (level) {
+  case BatteryLevel::Normal:
+    return 1;
+  case BatteryLevel::Low:
+    return policy.low_stretch;
+  case BatteryLevel::Critical:
+    return policy.critical_stretch;
+  default:
+    return 0;
+  }
+}
+
+} // namespace power
@@ -0,0 +1,107 @@
+/**
+ * @file cycle_planner.hpp
+ * @brief Decides whether a duty-cycle wake needs the radio
+ *
+ * Bringing WiFi up, associating and authenticating costs far more energy
+ * than a measurement, and with batched uploads most wakes have nothing due.
+ * plan_cycle() looks at what is waiting and tells the wake to either
+ * buffer its sample and sleep again, or transmit:
+ * - no upload on record (cold boot): report in
+ * - the upload interval would be exceeded before the next wake
+ * - the buffer holds enough for a full upload
+ * - an external event woke the device (GPIO wake)
+ * - an alert is active, or just cleared (the backend sees the recovery)
+ * - the anomaly detector flagged a sample
+ *
+ * A wake that does not transmit doesn't poll commands either, so the upload
+ * interval is also the command latency of a sleeping device.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace power {
+
+/// Why a wake transmits
+enum class TransmitReason : uint8_t {
+  None,      ///< Measure only: buffer the sample, sleep again
+  NoHistory, ///< No upload on record
+  Interval,  ///< Upload interval elapsed (or would before the next wake)
+  Backlog,   ///< Buffer reached its limit
+  Alert,     ///< Alert active, raised or cleared
+  Event,     ///< Woken by an external event
+  Anomaly,   ///< A sample was flagged as anomalous
+};
+
+[[nodiscard]] inline const char *to_string(TransmitReason reason) {
+  switch (reason) {
+  case TransmitReason::None:
+    return "none";
+  case TransmitReason::NoHistory:
+    return "no upload on record";
+  case TransmitReason::Interval:
+    return "interval";
+  case TransmitReason::Backlog:
+    return "backlog";
+  case TransmitReason::Alert:
+    return "alert";
+  case TransmitReason::Event:
+    return "wake event";
+  case TransmitReason::Anomaly:
+    return "anomaly";
+  default:
+    return "unknown";
+  }
+}
+
+/// Limits the planner enforces
+struct CyclePlanConfig {
+  /// Longest a sample may wait for its upload
+  std::chrono::seconds upload_interval{std::chrono::minutes(15)};
+  /// Transmit once this many records are buffered
+  size_t max_pending{2048};
+};
+
+/// What one wake knows when it plans
+struct CycleState {
+  /// Since the last accepted upload (nullopt = none on record)
+  std::optional<std::chrono::seconds> since_upload;
+  /// Until the wake after this one
+  std::chrono::seconds until_next_wake{0};
+  /// Records buffered for upload
+  size_t pending{0};
+  bool alert{false};     ///< Alert condition now
+  bool was_alert{false}; ///< Alert condition at the last upload
+  bool event{false};     ///< An external event woke this cycle
+  bool anomaly{false};   ///< An anomaly since the last upload
+};
+
+/// Pick this wake's work
+[[nodiscard]] constexpr TransmitReason plan_cycle(const CyclePlanConfig &config,
+                                                  const CycleState &state) {
+  if (state.event) {
+    return TransmitReason::Event;
+  }
+  if (state.anomaly) {
+    return TransmitReason::Anomaly;
+  }
+  if (state.alert || state.alert != state.was_alert) {
+    return TransmitReason::Alert;
+  }
+  if (!state.since_upload) {
+    return TransmitReason::NoHistory;
+  }
+  if (*state.since_upload + state.until_next_wake > config.upload_interval) {
+    return TransmitReason::Interval;
+  }
+  if (state.pending >= config.max_pending) {
+    return TransmitReason::Backlog;
+  }
+  return TransmitReason::None;
+}
+
+} // namespace power
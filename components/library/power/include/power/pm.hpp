@@ -0,0 +1,90 @@
+/**
+ * @file pm.hpp
+ * @brief CPU frequency phases on top of ESP-IDF power management locks
+ *
+ * With CONFIG_PM_ENABLE the CPU runs at the minimum frequency (and, once
+ * enable_auto_light_sleep() was called, light-sleeps) whenever no task holds
+ * a PM lock. CPU-bound work - TLS handshakes, ECDSA signing, BSEC do_steps -
+ * finishes several times faster at the maximum clock, which costs less
+ * energy than running it slowly. Wrap it in a PerformancePhase:
+ *
+ *   {
+ *     power::PerformancePhase boost;  // max CPU, no light sleep
+ *     bsec_do_steps(...);
+ *   }                                 // back to DFS at scope exit
+ *
+ * All phases share one ESP_PM_CPU_FREQ_MAX lock, created on first use. The
+ * lock counts, so nested and concurrent phases are fine. Without
+ * CONFIG_PM_ENABLE the lock can't be created and phases do nothing.
+ */
+
+#pragma once
+
+#include <esp_log.h>
+#include <esp_pm.h>
+
+namespace power {
+
+namespace detail {
+inline constexpr const char *TAG = "power";
+
+/// Shared CPU_FREQ_MAX lock (nullptr if power management is off)
+[[nodiscard]] inline esp_pm_lock_handle_t cpu_max_lock() {
+  static esp_pm_lock_handle_t lock = [] {
+    esp_pm_lock_handle_t handle = nullptr;
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "cpu_max", &handle) !=
+        ESP_OK) {
+      return static_cast<esp_pm_lock_handle_t>(nullptr);
+    }
+    return handle;
+  }();
+  return lock;
+}
+} // namespace detail
+
+/// Scoped maximum-CPU-frequency phase
+///
+/// @thread_safety Thread-safe (each task holds its own guard)
+class PerformancePhase {
+public:
+  PerformancePhase() : lock_(detail::cpu_max_lock()) {
+    if (lock_ != nullptr && esp_pm_lock_acquire(lock_) != ESP_OK) {
+      lock_ = nullptr;
+    }
+  }
+
+  ~PerformancePhase() {
+    if (lock_ != nullptr) {
+      esp_pm_lock_release(lock_);
+    }
+  }
+
+  PerformancePhase(const PerformancePhase &) = delete;
+  PerformancePhase &operator=(const PerformancePhase &) = delete;
+  PerformancePhase(PerformancePhase &&) = delete;
+  PerformancePhase &operator=(PerformancePhase &&) = delete;
+
+private:
+  esp_pm_lock_handle_t lock_;
+};
+
+/// Let the idle task enter light sleep when no PM lock is held
+///
+/// CONFIG_PM_DFS_INIT_AUTO starts frequency scaling only. WiFi keeps its
+/// association through light sleep, and peripheral drivers (I2C, WiFi)
+/// hold their own locks while they need the clock.
+inline esp_err_t enable_auto_light_sleep() {
+  esp_pm_config_t config{};
+  if (auto err = esp_pm_get_configuration(&config); err != ESP_OK) {
+    return err;
+  }
+  config.light_sleep_enable = true;
+  if (auto err = esp_pm_configure(&config); err != ESP_OK) {
+    ESP_LOGW(detail::TAG, "Auto light sleep unavailable: %s",
+             esp_err_to_name(err));
+    return err;
+  }
+  return ESP_OK;
+}
+
+} // namespace power
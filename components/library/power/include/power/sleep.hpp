@@ -1,12 +1,20 @@
 /**
  * @file sleep.hpp
  * @brief Sleep management with proper safety
+ *
+ * Deep sleep always arms the timer. enable_gpio_wakeup() adds external
+ * pins (a PIR output, a comparator on a threshold) as a second wake
+ * source, so the timer can run much longer while events still wake the
+ * chip within its boot time.
  */
 
 #pragma once
 
+#include <driver/gpio.h>
 #include <esp_sleep.h>
+#include <soc/soc_caps.h>
 
+#include <algorithm>
 #include <chrono>
 
 namespace power {
@@ -51,6 +59,64 @@ enum class WakeReason : uint8_t {
   }
 }
 
+/// Pin level that wakes the chip
+enum class WakeLevel : uint8_t { Low, High };
+
+/// Also wake from the next deep sleep when one of pins (bit n = GPIO n)
+/// is at level - call right before sleeping
+///
+/// ESP32-C3: GPIO0-5 only (the VDD3P3_RTC domain). The internal pull
+/// towards the idle level keeps an unconnected pin from waking the chip.
+/// The wake is level-triggered: a signal that is still active would end
+/// the sleep at once, so nothing is armed then and the timer wakes
+/// instead.
+/// @return ESP_ERR_INVALID_STATE if a pin is still at level
+[[nodiscard]] inline esp_err_t enable_gpio_wakeup(uint64_t pins,
+                                                  WakeLevel level) {
+#if SOC_GPIO_SUPPORT_DEEPSLEEP_WAKEUP
+  bool active = false;
+  for (int pin = 0; pin < GPIO_NUM_MAX; ++pin) {
+    if ((pins & (1ULL << pin)) == 0) {
+      continue;
+    }
+    auto num = static_cast<gpio_num_t>(pin);
+    if (!esp_sleep_is_valid_wakeup_gpio(num)) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    (void)gpio_set_direction(num, GPIO_MODE_INPUT);
+    if (level == WakeLevel::High) {
+      (void)gpio_pullup_dis(num);
+      (void)gpio_pulldown_en(num);
+    } else {
+      (void)gpio_pulldown_dis(num);
+      (void)gpio_pullup_en(num);
+    }
+    active |= gpio_get_level(num) == (level == WakeLevel::High ? 1 : 0);
+  }
+  if (active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  return esp_deep_sleep_enable_gpio_wakeup(
+      pins, level == WakeLevel::High ? ESP_GPIO_WAKEUP_GPIO_HIGH
+                                     : ESP_GPIO_WAKEUP_GPIO_LOW);
+#else
+  (void)pins;
+  (void)level;
+  return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/// Pins that ended the last deep sleep (0 unless WakeReason::Gpio)
+[[nodiscard]] inline uint64_t gpio_wake_pins() {
+#if SOC_GPIO_SUPPORT_DEEPSLEEP_WAKEUP
+  return get_wake_reason() == WakeReason::Gpio
+             ? esp_sleep_get_gpio_wakeup_status()
+             : 0;
+#else
+  return 0;
+#endif
+}
+
 class DeepSleep {
 public:
   using Duration = std::chrono::seconds;
@@ -80,6 +146,18 @@ public:
     __builtin_unreachable();
   }
 
+  /// Sleep for an explicit duration (e.g. until a sensor deadline)
+  /// Clamped to [1 ms, MAX_SLEEP_DURATION].
+  template <typename Rep, typename Period>
+  [[noreturn]] static void enter_for(std::chrono::duration<Rep, Period> d) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(d);
+    us = std::clamp(us, std::chrono::microseconds(std::chrono::milliseconds(1)),
+                    std::chrono::microseconds(limits::MAX_SLEEP_DURATION));
+    esp_sleep_enable_timer_wakeup(static_cast<uint64_t>(us.count()));
+    esp_deep_sleep_start();
+    __builtin_unreachable();
+  }
+
   [[nodiscard]] constexpr Duration interval() const { return interval_; }
 
 private:
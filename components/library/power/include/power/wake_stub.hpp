@@ -0,0 +1,37 @@
+/**
+ * @file wake_stub.hpp
+ * @brief Deep-sleep wake stub that sleeps through GPIO glitches
+ *
+ * A full boot (2nd-stage bootloader, image load, static constructors,
+ * component init) costs a wake far more than the event itself. The wake
+ * stub runs from RTC fast memory before any of that: on a GPIO wake whose
+ * pins are no longer active - a contact bounce, EMI coupled into a long
+ * PIR lead - it counts the wake and goes straight back to sleep. The
+ * timer target stays armed, so the next BSEC deadline is kept. Timer
+ * wakes and events that still hold their level boot as usual.
+ *
+ * Events therefore have to hold their level for the time the ROM takes to
+ * reach the stub (well under a millisecond); a PIR output holds it for
+ * seconds.
+ *
+ * The stub can't do more than that: flash (the I2C driver, BSEC, the
+ * telemetry log) is only mapped after the bootloader.
+ */
+
+#pragma once
+
+#include "sleep.hpp"
+
+#include <cstdint>
+
+namespace power {
+
+/// Run the glitch filter on the next deep-sleep wake: a GPIO wake boots
+/// only if one of pins is still at level (call with the pins passed to
+/// enable_gpio_wakeup(), right before sleeping)
+void install_wake_stub(uint64_t pins, WakeLevel level);
+
+/// GPIO wakes the stub slept through since the last call
+[[nodiscard]] uint32_t take_filtered_wakes();
+
+} // namespace power
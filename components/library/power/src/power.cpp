@@ -1,6 +1,6 @@
 /**
  * @file power.cpp
- * @brief Power library (header-only, kept for build system)
+ * @brief Power library (header-only apart from wake_stub.cpp)
  */
 
 namespace power::detail {
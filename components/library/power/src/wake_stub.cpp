@@ -0,0 +1,56 @@
+/**
+ * @file wake_stub.cpp
+ * @brief Wake stub implementation (RTC fast memory)
+ *
+ * Everything the stub touches lives in RTC memory or is a register: no
+ * flash, no ROM printf, no C++ runtime.
+ */
+
+#include "power/wake_stub.hpp"
+
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <esp_wake_stub.h>
+#include <soc/gpio_reg.h>
+#include <soc/rtc.h>
+#include <soc/soc.h>
+
+namespace power {
+
+namespace {
+struct WakeStubState {
+  uint32_t pins;     ///< GPIO0-31 mask (deep-sleep wake pins are GPIO0-5)
+  uint32_t filtered; ///< Wakes slept through since take_filtered_wakes()
+  bool active_high;
+};
+
+RTC_DATA_ATTR WakeStubState s_stub_state{};
+
+RTC_IRAM_ATTR void glitch_filter_stub() {
+  uint32_t cause = esp_wake_stub_get_wakeup_cause();
+  if ((cause & RTC_GPIO_TRIG_EN) != 0 && (cause & RTC_TIMER_TRIG_EN) == 0) {
+    uint32_t in = REG_READ(GPIO_IN_REG);
+    uint32_t level = s_stub_state.active_high ? in : ~in;
+    if ((level & s_stub_state.pins) == 0) {
+      // Back to sleep with the wake sources (and timer target) unchanged
+      ++s_stub_state.filtered;
+      esp_wake_stub_sleep(&glitch_filter_stub);
+    }
+  }
+  esp_default_wake_deep_sleep();
+}
+} // namespace
+
+void install_wake_stub(uint64_t pins, WakeLevel level) {
+  s_stub_state.pins = static_cast<uint32_t>(pins);
+  s_stub_state.active_high = level == WakeLevel::High;
+  esp_set_deep_sleep_wake_stub(&glitch_filter_stub);
+}
+
+uint32_t take_filtered_wakes() {
+  uint32_t filtered = s_stub_state.filtered;
+  s_stub_state.filtered = 0;
+  return filtered;
+}
+
+} // namespace power
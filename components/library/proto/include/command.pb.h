@@ -0,0 +1,176 @@
+/* Automatically generated nanopb header */
+/* Generated by nanopb-0.4.9.1 */
+
+#ifndef PB_CLOUD_COMMAND_PB_H_INCLUDED
+#define PB_CLOUD_COMMAND_PB_H_INCLUDED
+#include <pb.h>
+
+#if PB_PROTO_HEADER_VERSION != 40
+#error Regenerate this file with the current version of nanopb generator.
+#endif
+
+/* Enum definitions */
+typedef enum _cloud_CommandType {
+    cloud_CommandType_COMMAND_TYPE_UNKNOWN = 0,
+    cloud_CommandType_COMMAND_TYPE_REBOOT = 1,
+    cloud_CommandType_COMMAND_TYPE_FACTORY_RESET = 2,
+    cloud_CommandType_COMMAND_TYPE_OTA_UPDATE = 3,
+    cloud_CommandType_COMMAND_TYPE_CONFIG_UPDATE = 4
+} cloud_CommandType;
+
+typedef enum _cloud_AckResult {
+    cloud_AckResult_ACK_RESULT_SUCCESS = 0,
+    cloud_AckResult_ACK_RESULT_FAILED = 1,
+    cloud_AckResult_ACK_RESULT_UNKNOWN = 2,
+    cloud_AckResult_ACK_RESULT_INVALID_PAYLOAD = 3
+} cloud_AckResult;
+
+/* Struct definitions */
+typedef PB_BYTES_ARRAY_T(255) cloud_Command_payload_t;
+typedef struct _cloud_Command {
+    char id[37];
+    cloud_CommandType type;
+    cloud_Command_payload_t payload;
+    int64_t expires_at;
+} cloud_Command;
+
+typedef struct _cloud_CommandBatch {
+    pb_size_t commands_count;
+    cloud_Command commands[8];
+} cloud_CommandBatch;
+
+typedef struct _cloud_CommandAck {
+    char id[37];
+    cloud_AckResult result;
+} cloud_CommandAck;
+
+typedef struct _cloud_CommandAckBatch {
+    pb_size_t acks_count;
+    cloud_CommandAck acks[8];
+} cloud_CommandAckBatch;
+
+typedef struct _cloud_DeviceInfo {
+    char app_name[32];
+    char app_version[32];
+    uint32_t free_heap;
+    uint32_t min_free_heap;
+    uint32_t reset_reason;
+    int32_t rssi;
+    uint32_t iaq_accuracy;
+} cloud_DeviceInfo;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Helper constants for enums */
+#define _cloud_CommandType_MIN cloud_CommandType_COMMAND_TYPE_UNKNOWN
+#define _cloud_CommandType_MAX cloud_CommandType_COMMAND_TYPE_CONFIG_UPDATE
+#define _cloud_CommandType_ARRAYSIZE ((cloud_CommandType)(cloud_CommandType_COMMAND_TYPE_CONFIG_UPDATE+1))
+
+#define _cloud_AckResult_MIN cloud_AckResult_ACK_RESULT_SUCCESS
+#define _cloud_AckResult_MAX cloud_AckResult_ACK_RESULT_INVALID_PAYLOAD
+#define _cloud_AckResult_ARRAYSIZE ((cloud_AckResult)(cloud_AckResult_ACK_RESULT_INVALID_PAYLOAD+1))
+
+#define cloud_Command_type_ENUMTYPE cloud_CommandType
+
+
+#define cloud_CommandAck_result_ENUMTYPE cloud_AckResult
+
+
+
+
+/* Initializer values for message structs */
+#define cloud_Command_init_default               {"", _cloud_CommandType_MIN, {0, {0}}, 0}
+#define cloud_CommandBatch_init_default          {0, {cloud_Command_init_default, cloud_Command_init_default, cloud_Command_init_default, cloud_Command_init_default, cloud_Command_init_default, cloud_Command_init_default, cloud_Command_init_default, cloud_Command_init_default}}
+#define cloud_CommandAck_init_default            {"", _cloud_AckResult_MIN}
+#define cloud_CommandAckBatch_init_default       {0, {cloud_CommandAck_init_default, cloud_CommandAck_init_default, cloud_CommandAck_init_default, cloud_CommandAck_init_default, cloud_CommandAck_init_default, cloud_CommandAck_init_default, cloud_CommandAck_init_default, cloud_CommandAck_init_default}}
+#define cloud_DeviceInfo_init_default            {"", "", 0, 0, 0, 0, 0}
+#define cloud_Command_init_zero                  {"", _cloud_CommandType_MIN, {0, {0}}, 0}
+#define cloud_CommandBatch_init_zero             {0, {cloud_Command_init_zero, cloud_Command_init_zero, cloud_Command_init_zero, cloud_Command_init_zero, cloud_Command_init_zero, cloud_Command_init_zero, cloud_Command_init_zero, cloud_Command_init_zero}}
+#define cloud_CommandAck_init_zero               {"", _cloud_AckResult_MIN}
+#define cloud_CommandAckBatch_init_zero          {0, {cloud_CommandAck_init_zero, cloud_CommandAck_init_zero, cloud_CommandAck_init_zero, cloud_CommandAck_init_zero, cloud_CommandAck_init_zero, cloud_CommandAck_init_zero, cloud_CommandAck_init_zero, cloud_CommandAck_init_zero}}
+#define cloud_DeviceInfo_init_zero               {"", "", 0, 0, 0, 0, 0}
+
+/* Field tags (for use in manual encoding/decoding) */
+#define cloud_Command_id_tag                     1
+#define cloud_Command_type_tag                   2
+#define cloud_Command_payload_tag                3
+#define cloud_Command_expires_at_tag             4
+#define cloud_CommandBatch_commands_tag          1
+#define cloud_CommandAck_id_tag                  1
+#define cloud_CommandAck_result_tag              2
+#define cloud_CommandAckBatch_acks_tag           1
+#define cloud_DeviceInfo_app_name_tag            1
+#define cloud_DeviceInfo_app_version_tag         2
+#define cloud_DeviceInfo_free_heap_tag           3
+#define cloud_DeviceInfo_min_free_heap_tag       4
+#define cloud_DeviceInfo_reset_reason_tag        5
+#define cloud_DeviceInfo_rssi_tag                6
+#define cloud_DeviceInfo_iaq_accuracy_tag        7
+
+/* Struct field encoding specification for nanopb */
+#define cloud_Command_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, STRING,   id,                1) \
+X(a, STATIC,   SINGULAR, UENUM,    type,              2) \
+X(a, STATIC,   SINGULAR, BYTES,    payload,           3) \
+X(a, STATIC,   SINGULAR, INT64,    expires_at,        4)
+#define cloud_Command_CALLBACK NULL
+#define cloud_Command_DEFAULT NULL
+
+#define cloud_CommandBatch_FIELDLIST(X, a) \
+X(a, STATIC,   REPEATED, MESSAGE,  commands,          1)
+#define cloud_CommandBatch_CALLBACK NULL
+#define cloud_CommandBatch_DEFAULT NULL
+#define cloud_CommandBatch_commands_MSGTYPE cloud_Command
+
+#define cloud_CommandAck_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, STRING,   id,                1) \
+X(a, STATIC,   SINGULAR, UENUM,    result,            2)
+#define cloud_CommandAck_CALLBACK NULL
+#define cloud_CommandAck_DEFAULT NULL
+
+#define cloud_CommandAckBatch_FIELDLIST(X, a) \
+X(a, STATIC,   REPEATED, MESSAGE,  acks,              1)
+#define cloud_CommandAckBatch_CALLBACK NULL
+#define cloud_CommandAckBatch_DEFAULT NULL
+#define cloud_CommandAckBatch_acks_MSGTYPE cloud_CommandAck
+
+#define cloud_DeviceInfo_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, STRING,   app_name,          1) \
+X(a, STATIC,   SINGULAR, STRING,   app_version,       2) \
+X(a, STATIC,   SINGULAR, UINT32,   free_heap,         3) \
+X(a, STATIC,   SINGULAR, UINT32,   min_free_heap,     4) \
+X(a, STATIC,   SINGULAR, UINT32,   reset_reason,      5) \
+X(a, STATIC,   SINGULAR, SINT32,   rssi,              6) \
+X(a, STATIC,   SINGULAR, UINT32,   iaq_accuracy,      7)
+#define cloud_DeviceInfo_CALLBACK NULL
+#define cloud_DeviceInfo_DEFAULT NULL
+
+extern const pb_msgdesc_t cloud_Command_msg;
+extern const pb_msgdesc_t cloud_CommandBatch_msg;
+extern const pb_msgdesc_t cloud_CommandAck_msg;
+extern const pb_msgdesc_t cloud_CommandAckBatch_msg;
+extern const pb_msgdesc_t cloud_DeviceInfo_msg;
+
+/* Defines for backwards compatibility with code written before nanopb-0.4.0 */
+#define cloud_Command_fields &cloud_Command_msg
+#define cloud_CommandBatch_fields &cloud_CommandBatch_msg
+#define cloud_CommandAck_fields &cloud_CommandAck_msg
+#define cloud_CommandAckBatch_fields &cloud_CommandAckBatch_msg
+#define cloud_DeviceInfo_fields &cloud_DeviceInfo_msg
+
+/* Maximum encoded size of messages (where known) */
+#define CLOUD_COMMAND_PB_H_MAX_SIZE              cloud_CommandBatch_size
+#define cloud_CommandAckBatch_size               336
+#define cloud_CommandAck_size                    40
+#define cloud_CommandBatch_size                  2496
+#define cloud_Command_size                       309
+#define cloud_DeviceInfo_size                    96
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -21,6 +21,7 @@ typedef struct _sensor_Measurement {
         uint32_t uint32_val;
         uint64_t uint64_val;
         bool bool_val;
+        int32_t quantized_val;
     } value;
 } sensor_Measurement;
 
@@ -49,6 +50,7 @@ extern "C" {
 #define sensor_Measurement_uint32_val_tag        6
 #define sensor_Measurement_uint64_val_tag        7
 #define sensor_Measurement_bool_val_tag          8
+#define sensor_Measurement_quantized_val_tag     9
 #define sensor_MeasurementBatch_measurements_tag 1
 
 /* Struct field encoding specification for nanopb */
@@ -60,7 +62,8 @@ X(a, STATIC,   ONEOF,    INT32,    (value,int32_val,value.int32_val),   4) \
 X(a, STATIC,   ONEOF,    INT64,    (value,int64_val,value.int64_val),   5) \
 X(a, STATIC,   ONEOF,    UINT32,   (value,uint32_val,value.uint32_val),   6) \
 X(a, STATIC,   ONEOF,    UINT64,   (value,uint64_val,value.uint64_val),   7) \
-X(a, STATIC,   ONEOF,    BOOL,     (value,bool_val,value.bool_val),   8)
+X(a, STATIC,   ONEOF,    BOOL,     (value,bool_val,value.bool_val),   8) \
+X(a, STATIC,   ONEOF,    SINT32,   (value,quantized_val,value.quantized_val),   9)
 #define sensor_Measurement_CALLBACK NULL
 #define sensor_Measurement_DEFAULT NULL
 
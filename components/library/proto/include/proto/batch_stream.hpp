@@ -0,0 +1,129 @@
+/**
+ * @file batch_stream.hpp
+ * @brief Streaming MeasurementBatch encoder
+ *
+ * Encodes a sensor_MeasurementBatch while it is being sent: measurements
+ * are pulled from a source one at a time, each is encoded as a repeated
+ * `measurements` submessage (the same bytes a pb_callback_t encoder would
+ * emit) and the output goes through a small chunk buffer straight into a
+ * core::BodyStream. No sensor_MeasurementBatch (32 entries) is built and
+ * the whole payload is never held in RAM.
+ *
+ * The wire format is identical to encode_batch(), except that the batch is
+ * not limited to MAX_MEASUREMENTS_PER_BATCH entries.
+ */
+
+#pragma once
+
+#include "measurement_adapter.hpp"
+
+#include <core/body_stream.hpp>
+#include <sensor/measurement.hpp>
+
+#include <pb_encode.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+
+namespace proto {
+
+/// Default size of the encoder's chunk buffer (one socket write each)
+inline constexpr size_t STREAM_CHUNK_SIZE = 256;
+
+/// Body source that encodes a batch pulled from a measurement source
+///
+/// @tparam Source Callable `void(Emit &&emit)`; calls `emit(m)` for each
+///         sensor::Measurement. emit returns false once the stream failed,
+///         after which the source should stop.
+/// @tparam ChunkSize Bytes buffered before each write to the stream
+template <typename Source, size_t ChunkSize = STREAM_CHUNK_SIZE>
+class BatchStreamSource final : public core::IBodySource {
+public:
+  explicit BatchStreamSource(Source source,
+                             WireEncoding encoding = WireEncoding::Native)
+      : source_(std::move(source)), encoding_(encoding) {}
+
+  [[nodiscard]] bool produce(core::BodyStream &out) override {
+    Chunker chunker{.out = &out};
+    pb_ostream_t stream{
+        .callback = &Chunker::write,
+        .state = &chunker,
+        .max_size = SIZE_MAX,
+        .bytes_written = 0,
+        .errmsg = nullptr,
+    };
+
+    bool ok = true;
+    count_ = 0;
+    source_([&](const sensor::Measurement &m) {
+      if (ok) {
+        ok = encode_measurement(stream, m, encoding_);
+        count_ += ok ? 1 : 0;
+      }
+      return ok;
+    });
+
+    return ok && chunker.flush();
+  }
+
+  /// Measurements encoded by the last produce()
+  [[nodiscard]] size_t count() const { return count_; }
+
+private:
+  /// pb_ostream_t sink buffering into fixed chunks
+  struct Chunker {
+    core::BodyStream *out;
+    std::array<uint8_t, ChunkSize> buffer{};
+    size_t used{0};
+
+    [[nodiscard]] bool flush() {
+      bool ok = used == 0 || out->write(std::span(buffer.data(), used));
+      used = 0;
+      return ok;
+    }
+
+    static bool write(pb_ostream_t *stream, const pb_byte_t *buf,
+                      size_t count) {
+      auto *self = static_cast<Chunker *>(stream->state);
+      while (count > 0) {
+        size_t n = std::min(count, self->buffer.size() - self->used);
+        std::memcpy(self->buffer.data() + self->used, buf, n);
+        self->used += n;
+        buf += n;
+        count -= n;
+        if (self->used == self->buffer.size() && !self->flush()) {
+          return false;
+        }
+      }
+      return true;
+    }
+  };
+
+  /// One `repeated Measurement measurements = 1` element
+  static bool encode_measurement(pb_ostream_t &stream,
+                                 const sensor::Measurement &m,
+                                 WireEncoding encoding) {
+    sensor_Measurement pb = to_proto(m, encoding);
+    return pb_encode_tag(&stream, PB_WT_STRING,
+                         sensor_MeasurementBatch_measurements_tag) &&
+           pb_encode_submessage(&stream, sensor_Measurement_fields, &pb);
+  }
+
+  Source source_;
+  WireEncoding encoding_;
+  size_t count_{0};
+};
+
+/// Build a streaming batch encoder over source (see BatchStreamSource)
+template <size_t ChunkSize = STREAM_CHUNK_SIZE, typename Source>
+[[nodiscard]] BatchStreamSource<Source, ChunkSize>
+make_batch_stream(Source source,
+                  WireEncoding encoding = WireEncoding::Native) {
+  return BatchStreamSource<Source, ChunkSize>(std::move(source), encoding);
+}
+
+} // namespace proto
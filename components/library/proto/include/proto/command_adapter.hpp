@@ -0,0 +1,128 @@
+/**
+ * @file command_adapter.hpp
+ * @brief nanopb helpers for the command channel (command.proto)
+ *
+ * decode_commands() walks a CommandBatch one Command at a time, so only a
+ * single decoded command (~320 bytes) is on the stack instead of the whole
+ * batch struct. The encoders fill CommandAck / CommandAckBatch / DeviceInfo
+ * bodies into a caller buffer.
+ */
+
+#pragma once
+
+#include "../command.pb.h"
+
+#include <pb_decode.h>
+#include <pb_encode.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string_view>
+
+namespace proto {
+
+/// Largest encoded bodies
+inline constexpr size_t MAX_COMMAND_ACK_SIZE = cloud_CommandAck_size;
+inline constexpr size_t MAX_COMMAND_ACK_BATCH_SIZE = cloud_CommandAckBatch_size;
+inline constexpr size_t MAX_DEVICE_INFO_SIZE = cloud_DeviceInfo_size;
+
+/// Copy into a nanopb string field (false if it doesn't fit with its NUL)
+template <size_t N>
+[[nodiscard]] inline bool copy_string(char (&dst)[N], std::string_view src) {
+  if (src.size() >= N) {
+    return false;
+  }
+  std::ranges::copy(src, dst);
+  dst[src.size()] = '\0';
+  return true;
+}
+
+/// Decode a CommandBatch, calling fn(const cloud_Command &) per command
+/// @return false on malformed input (commands before the error were
+///         already delivered)
+template <typename Fn>
+[[nodiscard]] bool decode_commands(std::span<const uint8_t> buffer, Fn &&fn) {
+  pb_istream_t stream = pb_istream_from_buffer(buffer.data(), buffer.size());
+  while (true) {
+    pb_wire_type_t wire_type{};
+    uint32_t tag = 0;
+    bool eof = false;
+    if (!pb_decode_tag(&stream, &wire_type, &tag, &eof)) {
+      return eof;
+    }
+    if (tag != cloud_CommandBatch_commands_tag ||
+        wire_type != PB_WT_STRING) {
+      if (!pb_skip_field(&stream, wire_type)) {
+        return false;
+      }
+      continue;
+    }
+
+    cloud_Command command = cloud_Command_init_zero;
+    pb_istream_t sub{};
+    if (!pb_make_string_substream(&stream, &sub)) {
+      return false;
+    }
+    bool decoded = pb_decode(&sub, cloud_Command_fields, &command);
+    if (!pb_close_string_substream(&stream, &sub) || !decoded) {
+      return false;
+    }
+    fn(command);
+  }
+}
+
+/// Encode a CommandAck
+/// @return Bytes written, or 0 on error
+[[nodiscard]] inline size_t encode_command_ack(std::string_view id,
+                                               cloud_AckResult result,
+                                               std::span<uint8_t> buffer) {
+  cloud_CommandAck pb = cloud_CommandAck_init_zero;
+  if (!copy_string(pb.id, id)) {
+    return 0;
+  }
+  pb.result = result;
+  pb_ostream_t stream = pb_ostream_from_buffer(buffer.data(), buffer.size());
+  if (!pb_encode(&stream, cloud_CommandAck_fields, &pb)) {
+    return 0;
+  }
+  return stream.bytes_written;
+}
+
+/// Encode a CommandAckBatch of count acks, filled by fill(size_t i,
+/// cloud_CommandAck &) - which returns false to fail the encoding
+/// @return Bytes written, or 0 on error (or more than max_count acks)
+template <typename Fill>
+[[nodiscard]] size_t encode_command_ack_batch(size_t count, Fill &&fill,
+                                              std::span<uint8_t> buffer) {
+  cloud_CommandAckBatch pb = cloud_CommandAckBatch_init_zero;
+  if (count > std::size(pb.acks)) {
+    return 0;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (!fill(i, pb.acks[i])) {
+      return 0;
+    }
+  }
+  pb.acks_count = static_cast<pb_size_t>(count);
+  pb_ostream_t stream = pb_ostream_from_buffer(buffer.data(), buffer.size());
+  if (!pb_encode(&stream, cloud_CommandAckBatch_fields, &pb)) {
+    return 0;
+  }
+  return stream.bytes_written;
+}
+
+/// Encode a filled-in DeviceInfo
+/// @return Bytes written, or 0 on error
+[[nodiscard]] inline size_t encode_device_info(const cloud_DeviceInfo &pb,
+                                               std::span<uint8_t> buffer) {
+  pb_ostream_t stream = pb_ostream_from_buffer(buffer.data(), buffer.size());
+  if (!pb_encode(&stream, cloud_DeviceInfo_fields, &pb)) {
+    return 0;
+  }
+  return stream.bytes_written;
+}
+
+} // namespace proto
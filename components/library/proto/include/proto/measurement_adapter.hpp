@@ -4,12 +4,15 @@
  *
  * Converts sensor::Measurement ↔ sensor_Measurement (nanopb)
  *
+ * WireEncoding::Quantized sends measurements with a fixed-point form
+ * (MEASUREMENT_TRAIT_Q) as a small sint32 instead of a 32-bit float.
  */
 
 #pragma once
 
 #include "../measurement.pb.h"
 
+#include <sensor/layout.hpp>
 #include <sensor/measurement.hpp>
 
 #include <pb_decode.h>
@@ -17,47 +20,86 @@
 
 #include <cstdint>
 #include <span>
+#include <type_traits>
 #include <vector>
 
 namespace proto {
 
+/// How values with a fixed-point form travel on the wire
+enum class WireEncoding : uint8_t {
+  Native,    // As stored (float, uint32, ...)
+  Quantized, // quantized_val where the traits define a fixed-point form
+};
+
+/// Set the oneof value of a nanopb measurement from a statically typed value
+template <typename T> inline void set_proto_value(sensor_Measurement &pb, T v) {
+  static_assert(sensor::is_measurement_type_v<T>,
+                "T must be a MeasurementValue type");
+  if constexpr (std::is_same_v<T, float>) {
+    pb.which_value = sensor_Measurement_float_val_tag;
+    pb.value.float_val = v;
+  } else if constexpr (std::is_same_v<T, double>) {
+    pb.which_value = sensor_Measurement_double_val_tag;
+    pb.value.double_val = v;
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    pb.which_value = sensor_Measurement_int32_val_tag;
+    pb.value.int32_val = v;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    pb.which_value = sensor_Measurement_int64_val_tag;
+    pb.value.int64_val = v;
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    // uint8 maps to uint32 in protobuf
+    pb.which_value = sensor_Measurement_uint32_val_tag;
+    pb.value.uint32_val = v;
+  } else if constexpr (std::is_same_v<T, uint32_t>) {
+    pb.which_value = sensor_Measurement_uint32_val_tag;
+    pb.value.uint32_val = v;
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    pb.which_value = sensor_Measurement_uint64_val_tag;
+    pb.value.uint64_val = v;
+  } else if constexpr (std::is_same_v<T, bool>) {
+    pb.which_value = sensor_Measurement_bool_val_tag;
+    pb.value.bool_val = v;
+  }
+}
+
+/// Set the oneof to a fixed-point raw value
+inline void set_proto_quantized(sensor_Measurement &pb, int32_t raw) {
+  pb.which_value = sensor_Measurement_quantized_val_tag;
+  pb.value.quantized_val = raw;
+}
+
+/// Convert a statically typed value to nanopb struct (no variant dispatch)
+template <sensor::MeasurementId Id>
+inline sensor_Measurement to_proto(sensor::MeasurementTag<Id> /*unused*/,
+                                   sensor::measurement_type_t<Id> v,
+                                   WireEncoding encoding = WireEncoding::Native) {
+  sensor_Measurement pb = sensor_Measurement_init_zero;
+  pb.id = static_cast<uint32_t>(Id);
+  if constexpr (sensor::is_quantized_v<Id>) {
+    if (encoding == WireEncoding::Quantized) {
+      if (auto raw = sensor::quantize<Id>(v)) {
+        set_proto_quantized(pb, *raw);
+        return pb;
+      }
+    }
+  }
+  set_proto_value(pb, v);
+  return pb;
+}
+
 /// Convert C++ Measurement to nanopb struct
-inline sensor_Measurement to_proto(const sensor::Measurement &m) {
+inline sensor_Measurement to_proto(const sensor::Measurement &m,
+                                   WireEncoding encoding = WireEncoding::Native) {
   sensor_Measurement pb = sensor_Measurement_init_zero;
   pb.id = static_cast<uint32_t>(m.id);
-
-  std::visit(
-      [&pb](auto &&v) {
-        using T = std::decay_t<decltype(v)>;
-        if constexpr (std::is_same_v<T, float>) {
-          pb.which_value = sensor_Measurement_float_val_tag;
-          pb.value.float_val = v;
-        } else if constexpr (std::is_same_v<T, double>) {
-          pb.which_value = sensor_Measurement_double_val_tag;
-          pb.value.double_val = v;
-        } else if constexpr (std::is_same_v<T, int32_t>) {
-          pb.which_value = sensor_Measurement_int32_val_tag;
-          pb.value.int32_val = v;
-        } else if constexpr (std::is_same_v<T, int64_t>) {
-          pb.which_value = sensor_Measurement_int64_val_tag;
-          pb.value.int64_val = v;
-        } else if constexpr (std::is_same_v<T, uint8_t>) {
-          // uint8 maps to uint32 in protobuf
-          pb.which_value = sensor_Measurement_uint32_val_tag;
-          pb.value.uint32_val = v;
-        } else if constexpr (std::is_same_v<T, uint32_t>) {
-          pb.which_value = sensor_Measurement_uint32_val_tag;
-          pb.value.uint32_val = v;
-        } else if constexpr (std::is_same_v<T, uint64_t>) {
-          pb.which_value = sensor_Measurement_uint64_val_tag;
-          pb.value.uint64_val = v;
-        } else if constexpr (std::is_same_v<T, bool>) {
-          pb.which_value = sensor_Measurement_bool_val_tag;
-          pb.value.bool_val = v;
-        }
-      },
-      m.value);
-
+  if (encoding == WireEncoding::Quantized) {
+    if (auto raw = sensor::quantize(m)) {
+      set_proto_quantized(pb, *raw);
+      return pb;
+    }
+  }
+  m.visit([&pb](auto &&v) { set_proto_value(pb, v); });
   return pb;
 }
 
@@ -80,6 +122,8 @@ inline sensor::Measurement from_proto(const sensor_Measurement &pb) {
     return {id, pb.value.uint64_val};
   case sensor_Measurement_bool_val_tag:
     return {id, pb.value.bool_val};
+  case sensor_Measurement_quantized_val_tag:
+    return sensor::dequantize(id, pb.value.quantized_val);
   default:
     return {id, 0.0F}; // fallback
   }
@@ -87,7 +131,8 @@ inline sensor::Measurement from_proto(const sensor_Measurement &pb) {
 
 /// Convert C++ measurements to nanopb batch
 inline sensor_MeasurementBatch
-to_proto_batch(std::span<const sensor::Measurement> measurements) {
+to_proto_batch(std::span<const sensor::Measurement> measurements,
+               WireEncoding encoding = WireEncoding::Native) {
   sensor_MeasurementBatch pb = sensor_MeasurementBatch_init_zero;
 
   // Copy measurements (up to max_count from .options file)
@@ -97,13 +142,34 @@ to_proto_batch(std::span<const sensor::Measurement> measurements) {
   }
 
   for (size_t i = 0; i < count; ++i) {
-    pb.measurements[i] = to_proto(measurements[i]);
+    pb.measurements[i] = to_proto(measurements[i], encoding);
   }
   pb.measurements_count = static_cast<pb_size_t>(count);
 
   return pb;
 }
 
+/// Convert a batch with a known layout to nanopb (values copied with their
+/// static types; falls back to the generic path if the batch differs)
+template <typename L>
+inline sensor_MeasurementBatch
+to_proto_batch(std::span<const sensor::Measurement> measurements,
+               WireEncoding encoding = WireEncoding::Native) {
+  auto view = sensor::TypedView<L>::from(measurements);
+  if (!view) {
+    return to_proto_batch(measurements, encoding);
+  }
+
+  sensor_MeasurementBatch pb = sensor_MeasurementBatch_init_zero;
+  static_assert(L::size <= sizeof(pb.measurements) / sizeof(pb.measurements[0]),
+                "Layout exceeds batch capacity");
+
+  view.for_each([&pb, encoding](auto id, auto v) {
+    pb.measurements[pb.measurements_count++] = to_proto(id, v, encoding);
+  });
+  return pb;
+}
+
 /// Convert nanopb batch to C++ measurements
 inline std::vector<sensor::Measurement>
 from_proto_batch(const sensor_MeasurementBatch &pb) {
@@ -120,10 +186,18 @@ from_proto_batch(const sensor_MeasurementBatch &pb) {
 /// Encode a batch of measurements to bytes
 /// @param measurements All measurements to encode (from read_all)
 /// @param buffer Output buffer
+/// @param encoding Native or fixed-point values
 /// @return Number of bytes written, or 0 on error
 inline size_t encode_batch(std::span<const sensor::Measurement> measurements,
-                           std::span<uint8_t> buffer) {
-  sensor_MeasurementBatch pb = to_proto_batch(measurements);
+                           std::span<uint8_t> buffer,
+                           WireEncoding encoding = WireEncoding::Native) {
+  // Refuse rather than truncate; callers split (TelemetryService frames)
+  constexpr size_t capacity = sizeof(sensor_MeasurementBatch::measurements) /
+                              sizeof(sensor_MeasurementBatch::measurements[0]);
+  if (measurements.size() > capacity) {
+    return 0;
+  }
+  sensor_MeasurementBatch pb = to_proto_batch(measurements, encoding);
   pb_ostream_t stream = pb_ostream_from_buffer(buffer.data(), buffer.size());
   if (!pb_encode(&stream, sensor_MeasurementBatch_fields, &pb)) {
     return 0;
@@ -0,0 +1,18 @@
+/* Automatically generated nanopb constant definitions */
+/* Generated by nanopb-0.4.9.1 */
+
+#include "command.pb.h"
+#if PB_PROTO_HEADER_VERSION != 40
+#error Regenerate this file with the current version of nanopb generator.
+#endif
+
+PB_BIND(cloud_Command, cloud_Command, 2)
+
+PB_BIND(cloud_CommandBatch, cloud_CommandBatch, 2)
+
+PB_BIND(cloud_CommandAck, cloud_CommandAck, AUTO)
+
+PB_BIND(cloud_CommandAckBatch, cloud_CommandAckBatch, 2)
+
+PB_BIND(cloud_DeviceInfo, cloud_DeviceInfo, AUTO)
+
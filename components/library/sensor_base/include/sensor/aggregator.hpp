@@ -0,0 +1,227 @@
+/**
+ * @file aggregator.hpp
+ * @brief Windowed aggregation stage for the sensor data path
+ *
+ * WindowAggregator is an IDataHandler decorator that sits between monitors
+ * and the DataManager. It keeps running min/max/mean/last/count per
+ * MeasurementId over a fixed time window and forwards one aggregate batch
+ * per window instead of every raw sample. Memory is O(1) per MeasurementId,
+ * independent of the sample rate.
+ *
+ * Output format (one on_data call per selected statistic):
+ *   [Aggregate(kind), <id>=value, <id>=value, ...]
+ * The Aggregate marker tells the receiver which statistic follows. Min, max
+ * and last keep the original value type; mean is float (double for double
+ * inputs); count is uint32.
+ */
+
+#pragma once
+
+#include "data_manager.hpp"
+#include "measurement.hpp"
+#include "sensor.hpp"
+
+#include <core/clock.hpp>
+#include <core/mutex.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+namespace sensor {
+
+/// Statistic carried by an aggregate batch (value of MeasurementId::Aggregate)
+enum class AggregateKind : uint8_t { Mean, Min, Max, Last, Count };
+
+/// Bitmask of statistics to emit
+enum class AggregateStats : uint8_t {
+  Mean = 1U << static_cast<uint8_t>(AggregateKind::Mean),
+  Min = 1U << static_cast<uint8_t>(AggregateKind::Min),
+  Max = 1U << static_cast<uint8_t>(AggregateKind::Max),
+  Last = 1U << static_cast<uint8_t>(AggregateKind::Last),
+  Count = 1U << static_cast<uint8_t>(AggregateKind::Count),
+};
+
+[[nodiscard]] constexpr AggregateStats operator|(AggregateStats a,
+                                                 AggregateStats b) {
+  return static_cast<AggregateStats>(static_cast<uint8_t>(a) |
+                                     static_cast<uint8_t>(b));
+}
+
+[[nodiscard]] constexpr bool has_stat(AggregateStats set, AggregateKind kind) {
+  return (static_cast<uint8_t>(set) & (1U << static_cast<uint8_t>(kind))) !=
+         0;
+}
+
+/// Aggregation configuration
+struct AggregationConfig {
+  std::chrono::milliseconds window{std::chrono::minutes(1)};
+  AggregateStats stats{AggregateStats::Mean | AggregateStats::Min |
+                       AggregateStats::Max};
+};
+
+/// Windowed min/max/mean aggregator (IDataHandler decorator)
+///
+/// Windows are per sensor and start at the first sample after a flush. A
+/// sample arriving after the window has elapsed first flushes the previous
+/// window, so no extra timer wakeups are needed.
+///
+/// @tparam MaxSensors Maximum number of sensor types (use SensorId::Count)
+///
+/// @thread_safety Thread-safe (on_data from timer task, flush from any task)
+template <size_t MaxSensors> class WindowAggregator final : public IDataHandler {
+public:
+  static constexpr size_t SENSOR_COUNT = MaxSensors;
+  static constexpr size_t ID_COUNT = static_cast<size_t>(MeasurementId::Count);
+
+  WindowAggregator(IDataHandler &downstream, const AggregationConfig &config)
+      : downstream_(downstream), config_(config) {}
+
+  ~WindowAggregator() override = default;
+
+  WindowAggregator(const WindowAggregator &) = delete;
+  WindowAggregator &operator=(const WindowAggregator &) = delete;
+  WindowAggregator(WindowAggregator &&) = delete;
+  WindowAggregator &operator=(WindowAggregator &&) = delete;
+
+  void on_data(SensorIdType sensor_id,
+               std::span<const Measurement> measurements) override {
+    auto idx = static_cast<size_t>(sensor_id);
+    if (idx >= SENSOR_COUNT) {
+      return;
+    }
+
+    core::LockGuard lock(mutex_);
+    auto &window = windows_.at(idx);
+    int64_t now = core::clock::monotonic_ms();
+
+    if (window.active && now - window.start_ms >= config_.window.count()) {
+      flush_locked(sensor_id);
+    }
+    if (!window.active) {
+      window.active = true;
+      window.start_ms = now;
+    }
+
+    for (const auto &m : measurements) {
+      auto id = static_cast<size_t>(m.id);
+      if (id < ID_COUNT) {
+        window.stats.at(id).add(m);
+      }
+    }
+  }
+
+  /// Emit and reset all open windows (e.g. before upload or deep sleep)
+  void flush() {
+    core::LockGuard lock(mutex_);
+    for (size_t i = 0; i < SENSOR_COUNT; ++i) {
+      flush_locked(static_cast<SensorIdType>(i));
+    }
+  }
+
+  [[nodiscard]] const AggregationConfig &config() const { return config_; }
+
+private:
+  /// Running statistics for one MeasurementId (O(1) memory)
+  struct Stat {
+    Measurement last{};
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    uint32_t count = 0;
+
+    void add(const Measurement &m) {
+      auto v = m.to<double>();
+      last = m;
+      sum += v;
+      min = std::min(min, v);
+      max = std::max(max, v);
+      ++count;
+    }
+  };
+
+  struct Window {
+    std::array<Stat, ID_COUNT> stats{};
+    int64_t start_ms = 0;
+    bool active = false;
+  };
+
+  /// Largest batch: one marker plus one value per MeasurementId
+  static constexpr size_t MAX_BATCH = ID_COUNT;
+
+  /// Convert a double back to the stored type of a reference measurement
+  [[nodiscard]] static Measurement same_type(const Measurement &ref,
+                                             double value) {
+    return ref.visit([&ref, value](auto &&v) -> Measurement {
+      using T = std::decay_t<decltype(v)>;
+      if constexpr (std::is_same_v<T, bool>) {
+        return {ref.id, value != 0.0};
+      } else {
+        return {ref.id, static_cast<T>(value)};
+      }
+    });
+  }
+
+  [[nodiscard]] static Measurement mean_of(const Stat &stat) {
+    double mean = stat.sum / stat.count;
+    if (stat.last.template is<double>()) {
+      return {stat.last.id, mean};
+    }
+    return {stat.last.id, static_cast<float>(mean)};
+  }
+
+  [[nodiscard]] static Measurement stat_value(const Stat &stat,
+                                              AggregateKind kind) {
+    switch (kind) {
+    case AggregateKind::Mean:
+      return mean_of(stat);
+    case AggregateKind::Min:
+      return same_type(stat.last, stat.min);
+    case AggregateKind::Max:
+      return same_type(stat.last, stat.max);
+    case AggregateKind::Count:
+      return {stat.last.id, stat.count};
+    case AggregateKind::Last:
+    default:
+      return stat.last;
+    }
+  }
+
+  /// @note Caller must hold the lock
+  void flush_locked(SensorIdType sensor_id) {
+    auto &window = windows_.at(static_cast<size_t>(sensor_id));
+    if (!window.active) {
+      return;
+    }
+
+    for (uint8_t k = 0; k <= static_cast<uint8_t>(AggregateKind::Count); ++k) {
+      auto kind = static_cast<AggregateKind>(k);
+      if (!has_stat(config_.stats, kind)) {
+        continue;
+      }
+
+      std::array<Measurement, MAX_BATCH> batch{};
+      size_t n = 0;
+      batch.at(n++) = make<MeasurementId::Aggregate>(k);
+      for (const auto &stat : window.stats) {
+        if (stat.count > 0 && n < batch.size()) {
+          batch.at(n++) = stat_value(stat, kind);
+        }
+      }
+      downstream_.on_data(sensor_id, std::span(batch.data(), n));
+    }
+
+    window = Window{};
+  }
+
+  IDataHandler &downstream_;
+  AggregationConfig config_;
+  core::Mutex mutex_;
+  std::array<Window, SENSOR_COUNT> windows_{};
+};
+
+} // namespace sensor
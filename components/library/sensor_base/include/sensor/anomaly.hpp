@@ -0,0 +1,283 @@
+/**
+ * @file anomaly.hpp
+ * @brief Online anomaly detection on the sensor data path
+ *
+ * AnomalyDetector is an IDataHandler stage that forwards every sample
+ * unchanged and watches a few measurement ids with two O(1) detectors:
+ * - z-score against an exponentially weighted mean and variance: a value
+ *   far outside what the id has been doing lately
+ * - rate of change (units per minute): a step such as a CO2 or VOC source,
+ *   caught before the averages have any history
+ * An id that crosses a limit is reported once to the handler; it can be
+ * reported again after it has settled within half its limits. Uploads can
+ * then follow the interesting samples instead of the clock.
+ *
+ * Each watched (sensor, rule) keeps 24 bytes of state. A duty-cycled
+ * device keeps it across deep sleep with state() / restore() and takes the
+ * time from a clock that runs in deep sleep (AnomalyConfig::now_ms).
+ */
+
+#pragma once
+
+#include "data_manager.hpp"
+#include "measurement.hpp"
+#include "sensor.hpp"
+
+#include <core/clock.hpp>
+#include <core/mutex.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+
+namespace sensor {
+
+/// Which detector fired
+enum class AnomalyKind : uint8_t {
+  ZScore = 1, ///< Far from the moving average
+  Rate = 2,   ///< Changing faster than its limit
+};
+
+[[nodiscard]] inline const char *to_string(AnomalyKind kind) {
+  switch (kind) {
+  case AnomalyKind::ZScore:
+    return "z-score";
+  case AnomalyKind::Rate:
+    return "rate";
+  default:
+    return "unknown";
+  }
+}
+
+/// Limits of one watched measurement id (0 turns a detector off)
+struct AnomalyRule {
+  MeasurementId id{MeasurementId::Count};
+  float z_limit{0.0F};    ///< Standard deviations from the moving average
+  float rate_limit{0.0F}; ///< Units per minute
+};
+
+/// Detector settings
+struct AnomalyConfig {
+  /// Weight of a new sample in the moving average (memory ~1/alpha samples)
+  float alpha{0.05F};
+  /// Samples of an id before its z-score counts
+  uint16_t warmup{20};
+  /// Time base of the rates; must keep running across deep sleep when the
+  /// state is kept in RTC memory
+  int64_t (*now_ms)(){core::clock::monotonic_ms};
+};
+
+/// One report
+struct Anomaly {
+  SensorIdType sensor_id{0};
+  MeasurementId id{MeasurementId::Count};
+  AnomalyKind kind{AnomalyKind::ZScore};
+  float value{0.0F};
+  float score{0.0F}; ///< |z|, or units per minute
+};
+
+/// Anomaly detector (IDataHandler stage)
+///
+/// The noise floor of the z-score is the id's absolute deadband
+/// (MEASUREMENT_TRAIT): a change the deadband would hide is never an
+/// anomaly, however steady the value was before.
+///
+/// @tparam MaxSensors Maximum number of sensor types (use SensorId::Count)
+/// @tparam MaxRules Watched measurement ids
+///
+/// @thread_safety Thread-safe; the handler runs on the sampling task
+template <size_t MaxSensors, size_t MaxRules = 6>
+class AnomalyDetector final : public IDataHandler {
+public:
+  static constexpr size_t SENSOR_COUNT = MaxSensors;
+  static constexpr size_t MAX_RULES = MaxRules;
+
+  using Handler = std::function<void(const Anomaly &)>;
+
+  /// Moving statistics of one (sensor, rule)
+  struct Track {
+    int64_t last_ms = 0;
+    float mean = 0.0F;
+    float variance = 0.0F;
+    float last = 0.0F;
+    uint16_t count = 0;
+    bool flagged = false; ///< Reported, not settled yet
+  };
+  using State = std::array<std::array<Track, MaxRules>, MaxSensors>;
+
+  /// @param rules Watched ids; those beyond MaxRules are ignored
+  AnomalyDetector(IDataHandler &downstream, std::span<const AnomalyRule> rules,
+                  const AnomalyConfig &config = {})
+      : downstream_(downstream), config_(config) {
+    rule_count_ = std::min(rules.size(), rules_.size());
+    std::copy_n(rules.begin(), rule_count_, rules_.begin());
+  }
+
+  ~AnomalyDetector() override = default;
+
+  AnomalyDetector(const AnomalyDetector &) = delete;
+  AnomalyDetector &operator=(const AnomalyDetector &) = delete;
+  AnomalyDetector(AnomalyDetector &&) = delete;
+  AnomalyDetector &operator=(AnomalyDetector &&) = delete;
+
+  /// Called once per anomaly, before the sample goes downstream: whoever
+  /// the sample wakes sees the anomaly already
+  void set_handler(Handler handler) {
+    core::LockGuard lock(mutex_);
+    handler_ = std::move(handler);
+  }
+
+  void on_data(SensorIdType sensor_id,
+               std::span<const Measurement> measurements) override {
+    auto idx = static_cast<size_t>(sensor_id);
+    if (idx < SENSOR_COUNT) {
+      detect(sensor_id, measurements);
+    }
+    downstream_.on_data(sensor_id, measurements);
+  }
+
+  /// Statistics, e.g. to keep in RTC memory across deep sleep
+  [[nodiscard]] State state() const {
+    core::LockGuard lock(mutex_);
+    return tracks_;
+  }
+
+  void restore(const State &state) {
+    core::LockGuard lock(mutex_);
+    tracks_ = state;
+  }
+
+  /// Forget every average (e.g. after recalibration)
+  void reset() {
+    core::LockGuard lock(mutex_);
+    tracks_ = {};
+  }
+
+  /// Anomalies reported since boot
+  [[nodiscard]] uint32_t anomaly_count() const {
+    core::LockGuard lock(mutex_);
+    return anomalies_;
+  }
+
+private:
+  void detect(SensorIdType sensor_id,
+              std::span<const Measurement> measurements) {
+    std::array<Anomaly, MaxRules> found{};
+    size_t n = 0;
+    Handler handler;
+    {
+      core::LockGuard lock(mutex_);
+      auto &tracks = tracks_.at(static_cast<size_t>(sensor_id));
+      int64_t now = config_.now_ms();
+      for (const auto &m : measurements) {
+        size_t rule = find_rule(m.id);
+        if (rule == rule_count_ || n == found.size()) {
+          continue;
+        }
+        auto anomaly = update(tracks.at(rule), rules_.at(rule), m, now);
+        if (anomaly) {
+          anomaly->sensor_id = sensor_id;
+          found.at(n++) = *anomaly;
+        }
+      }
+      anomalies_ += n;
+      if (n > 0) {
+        handler = handler_;
+      }
+    }
+
+    if (handler) {
+      for (size_t i = 0; i < n; ++i) {
+        handler(found.at(i));
+      }
+    }
+  }
+
+  [[nodiscard]] size_t find_rule(MeasurementId id) const {
+    for (size_t i = 0; i < rule_count_; ++i) {
+      if (rules_.at(i).id == id) {
+        return i;
+      }
+    }
+    return rule_count_;
+  }
+
+  /// Score one value, then fold it into the track
+  [[nodiscard]] std::optional<Anomaly> update(Track &track,
+                                              const AnomalyRule &rule,
+                                              const Measurement &m,
+                                              int64_t now) const {
+    auto value = m.to<float>();
+    if (!std::isfinite(value)) {
+      return std::nullopt;
+    }
+
+    std::optional<Anomaly> hit;
+    bool settled = true;
+    if (rule.rate_limit > 0.0F && track.count > 0 && now > track.last_ms) {
+      float minutes = static_cast<float>(now - track.last_ms) / 60'000.0F;
+      float rate = std::fabs(value - track.last) / minutes;
+      if (rate > rule.rate_limit) {
+        hit = Anomaly{.id = m.id,
+                      .kind = AnomalyKind::Rate,
+                      .value = value,
+                      .score = rate};
+      }
+      settled = rate <= rule.rate_limit / 2.0F;
+    }
+    if (rule.z_limit > 0.0F && track.count >= config_.warmup) {
+      float sigma =
+          std::max(std::sqrt(track.variance), m.meta().deadband_abs);
+      float z = sigma > 0.0F ? std::fabs(value - track.mean) / sigma : 0.0F;
+      if (!hit && z > rule.z_limit) {
+        hit = Anomaly{.id = m.id,
+                      .kind = AnomalyKind::ZScore,
+                      .value = value,
+                      .score = z};
+      }
+      settled = settled && z <= rule.z_limit / 2.0F;
+    }
+
+    // West's incremental EWMA mean and variance
+    if (track.count == 0) {
+      track.mean = value;
+      track.variance = 0.0F;
+    } else {
+      float diff = value - track.mean;
+      float step = config_.alpha * diff;
+      track.mean += step;
+      track.variance = (1.0F - config_.alpha) * (track.variance + diff * step);
+    }
+    track.last = value;
+    track.last_ms = now;
+    if (track.count < std::numeric_limits<uint16_t>::max()) {
+      ++track.count;
+    }
+
+    if (hit && !track.flagged) {
+      track.flagged = true;
+      return hit;
+    }
+    if (track.flagged && settled) {
+      track.flagged = false;
+    }
+    return std::nullopt;
+  }
+
+  IDataHandler &downstream_;
+  AnomalyConfig config_;
+  std::array<AnomalyRule, MaxRules> rules_{};
+  size_t rule_count_ = 0;
+  mutable core::Mutex mutex_;
+  State tracks_{};
+  Handler handler_;
+  uint32_t anomalies_ = 0;
+};
+
+} // namespace sensor
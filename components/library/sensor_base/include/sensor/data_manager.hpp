@@ -4,30 +4,40 @@
  *
  * Monitors push data here; DataManager decides where it goes:
  * - Cache (for read_all())
+ * - History ring buffer (for drain_into())
  * - Flash storage (future)
  * - Network queue (future)
  *
+ * Consumers learn about new data through notifier() rather than the event
+ * loop.
+ *
  * Memory: Uses fixed-size arrays and static mutex allocation.
  * Zero heap allocation - suitable for embedded systems.
  * For zero-allocation reads, use for_each() or read_into().
  *
  * Decoupled from SensorId enum - application provides sizing constants.
+ * Storage is per sensor present, not per ID: a SlotTable maps each ID to a
+ * dense slot, so sparse IDs cost nothing and reads walk only real sensors.
  */
 
 #pragma once
 
-#include "events.hpp"
 #include "measurement.hpp"
+#include "notifier.hpp"
+#include "packed_measurement.hpp"
 #include "sensor.hpp"
+#include "slot_table.hpp"
 
-#include <core/event_loop.hpp>
+#include <core/clock.hpp>
+#include <core/lock_stats.hpp>
 
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <optional>
 #include <span>
 
 namespace sensor {
@@ -67,16 +77,45 @@ protected:
 /// Manages sensor data caching and routing
 /// Thread-safe for concurrent access from timer callbacks and app
 ///
-/// @tparam MaxSensors Maximum number of sensor types (use SensorId::Count)
+/// Besides the last-value cache, every sample is appended to a fixed-depth
+/// per-sensor ring buffer. When a ring is full the oldest sample is
+/// overwritten (counted in history_overruns()). History is held as
+/// PackedMeasurement (8 bytes each) and unpacked on drain.
+///
+/// Each on_data batch is stamped with core::clock::monotonic_ms(); the
+/// epoch conversion happens at drain time, so samples taken before SNTP
+/// sync still get correct wall-clock times once it completes.
+///
+/// Sensors get their slot from the constructor's table, add_sensor()
+/// (SensorManagerT calls it for each monitor) or their first on_data(),
+/// whichever comes first. The notifier's bits and sequences are per slot:
+/// use bit() and sequence() to address them by sensor ID.
+///
+/// @tparam MaxSensors Sensors held (any IDs; at most 32 for the notifier)
 /// @tparam MaxMeasurementsPerSensor Maximum measurements per sensor
-template <size_t MaxSensors, size_t MaxMeasurementsPerSensor = 16>
+/// @tparam HistoryDepth Samples retained per sensor until drained
+template <size_t MaxSensors, size_t MaxMeasurementsPerSensor = 16,
+          size_t HistoryDepth = 4>
 class DataManagerT : public IDataHandler {
 public:
   static constexpr size_t SENSOR_COUNT = MaxSensors;
   static constexpr size_t MAX_MEASUREMENTS = MaxMeasurementsPerSensor;
+  static constexpr size_t HISTORY_DEPTH = HistoryDepth;
+
+  static_assert(HISTORY_DEPTH > 0, "HistoryDepth must be at least 1");
 
   /// Constructor - uses statically allocated mutex (no heap)
-  DataManagerT() : mutex_(xSemaphoreCreateMutexStatic(&mutex_buffer_)) {}
+  DataManagerT() = default;
+
+  /// Start with the slots of a known set of sensors (e.g. made at compile
+  /// time with make_slot_table()); the rest stay free
+  template <size_t N>
+    requires(N <= MaxSensors)
+  explicit DataManagerT(const SlotTable<N> &slots) {
+    for (size_t slot = 0; slot < slots.size(); ++slot) {
+      (void)slots_.add(slots.id_of(slot));
+    }
+  }
 
   ~DataManagerT() override = default;
 
@@ -88,24 +127,212 @@ public:
   /// Called by monitors when they have new data
   void on_data(SensorIdType sensor_id,
                std::span<const Measurement> measurements) override {
-    Lock lock(mutex_);
+    size_t slot = Slots::NONE;
+    std::optional<MeasurementId> unpackable;
+    {
+      core::LockGuard lock(mutex_);
+
+      slot = slots_.add(sensor_id);
+      if (slot != Slots::NONE) {
+        auto &entry = cache_.at(slot);
+        entry.count = std::min(measurements.size(), MAX_MEASUREMENTS);
+        std::copy_n(measurements.begin(), entry.count, entry.data.begin());
+        entry.valid = true;
+
+        unpackable =
+            push_history(slot, std::span(entry.data.data(), entry.count));
+
+        // Wake consumers directly (no event loop copy/dispatch per sample)
+        notifier_.notify(slot);
+        // Future: could also write to flash, queue for network, etc.
+      }
+    }
 
-    auto idx = static_cast<size_t>(sensor_id);
-    if (idx >= SENSOR_COUNT) {
-      ESP_LOGW(TAG, "Sensor ID %u out of range (max: %zu)", sensor_id,
+    // Logged after the lock: ESP_LOG can block on the console
+    if (slot == Slots::NONE) {
+      ESP_LOGW(TAG, "Sensor ID %u has no slot (all %zu in use)", sensor_id,
                SENSOR_COUNT);
-      return;
+    } else if (unpackable) {
+      ESP_LOGW(TAG, "Measurement %u not packable, not kept in history",
+               static_cast<unsigned>(*unpackable));
     }
+  }
 
-    auto &entry = cache_.at(idx);
-    entry.count = std::min(measurements.size(), MAX_MEASUREMENTS);
-    std::copy_n(measurements.begin(), entry.count, entry.data.begin());
-    entry.valid = true;
+  /// Give a sensor its slot ahead of its first sample
+  /// @return false if every slot is taken by other sensors
+  bool add_sensor(SensorIdType sensor_id) {
+    core::LockGuard lock(mutex_);
+    return slots_.add(sensor_id) != Slots::NONE;
+  }
+
+  /// New-data signal (sequence counters + task notification bitmask, both
+  /// per slot)
+  [[nodiscard]] DataNotifier<SENSOR_COUNT> &notifier() { return notifier_; }
+
+  /// Bit of a sensor in the notifier's masks (0 if it has no slot)
+  [[nodiscard]] uint32_t bit(SensorIdType sensor_id) const {
+    size_t slot = find_slot(sensor_id);
+    return slot == Slots::NONE ? 0 : DataNotifier<SENSOR_COUNT>::bit(slot);
+  }
 
-    // Publish event so consumers can react without polling
-    SensorDataEvent evt{sensor_id, entry.count};
-    (void)core::events().publish(SENSOR_EVENTS, SensorEvent::DataReady, &evt);
-    // Future: could also write to flash, queue for network, etc.
+  /// Samples published for a sensor (wraps; 0 if it has no slot)
+  [[nodiscard]] uint32_t sequence(SensorIdType sensor_id) const {
+    size_t slot = find_slot(sensor_id);
+    return slot == Slots::NONE ? 0 : notifier_.sequence(slot);
+  }
+
+  /// Visit the sensors that have a slot, in ID order
+  /// Callback: void(SensorIdType)
+  template <typename Func> void for_each_sensor(const Func &callback) const {
+    std::array<SensorIdType, SENSOR_COUNT> ids{};
+    size_t count = 0;
+    {
+      core::LockGuard lock(mutex_);
+      for (const auto &entry : slots_.entries()) {
+        ids.at(count++) = entry.id;
+      }
+    }
+    for (size_t i = 0; i < count; ++i) {
+      callback(ids.at(i));
+    }
+  }
+
+  // ==========================================================================
+  // History (multi-sample ring buffer)
+  // ==========================================================================
+
+  /// Move buffered samples into caller-provided buffer, oldest first
+  ///
+  /// Samples from all sensors are merged in arrival order. Only whole samples
+  /// are copied; whatever does not fit stays buffered for the next call.
+  ///
+  /// Sample times are delta-encoded in-line: the output starts with a
+  /// Timestamp (Unix ms, 0 if not synchronized) for the first sample, and a
+  /// TimeDelta (ms since the previous sample) precedes each later sample
+  /// taken at a different time. Every other measurement belongs to the most
+  /// recent time marker.
+  /// @return Number of measurements written (including time markers)
+  [[nodiscard]] size_t drain_into(std::span<Measurement> out) {
+    core::LockGuard lock(mutex_);
+    size_t written = 0;
+    bool first = true;
+    int64_t prev_ms = 0;
+
+    while (true) {
+      auto *ring = oldest_ring();
+      if (ring == nullptr) {
+        break;
+      }
+
+      const auto &sample = ring->samples.at(ring->tail);
+      int64_t delta_ms = sample.mono_ms - prev_ms;
+      bool needs_marker = first || delta_ms != 0;
+      size_t needed = sample.count + (needs_marker ? 1 : 0);
+      if (needed > out.size() - written) {
+        break;
+      }
+
+      if (first) {
+        out[written++] = make<MeasurementId::Timestamp>(
+            core::clock::to_epoch_ms(sample.mono_ms));
+      } else if (needs_marker) {
+        out[written++] =
+            make<MeasurementId::TimeDelta>(static_cast<uint32_t>(delta_ms));
+      }
+      first = false;
+      prev_ms = sample.mono_ms;
+
+      for (size_t i = 0; i < sample.count; ++i) {
+        out[written++] = sample.data[i].unpack();
+      }
+
+      ring->tail = (ring->tail + 1) % HISTORY_DEPTH;
+      --ring->size;
+    }
+    return written;
+  }
+
+  /// Visit buffered samples oldest first without an intermediate batch
+  ///
+  /// fn(std::span<const Measurement>) is called once per sample, prefixed
+  /// by the same Timestamp / TimeDelta markers drain_into() emits. The
+  /// sample is removed when fn returns true; on false it stays buffered and
+  /// the walk stops. The lock is only held while one sample is unpacked,
+  /// never while fn runs, so fn may block (e.g. on a socket write).
+  /// @return Number of samples consumed
+  template <typename Func> size_t drain_each(const Func &fn) {
+    std::array<Measurement, MAX_MEASUREMENTS + 1> out{};
+    size_t consumed = 0;
+    bool first = true;
+    int64_t prev_ms = 0;
+
+    while (true) {
+      size_t written = 0;
+      size_t ring_idx = 0;
+      uint32_t seq = 0;
+      int64_t mono_ms = 0;
+
+      {
+        core::LockGuard lock(mutex_);
+        auto *ring = oldest_ring();
+        if (ring == nullptr) {
+          break;
+        }
+
+        const auto &sample = ring->samples.at(ring->tail);
+        ring_idx = static_cast<size_t>(ring - history_.data());
+        seq = sample.seq;
+        mono_ms = sample.mono_ms;
+
+        if (first) {
+          out[written++] = make<MeasurementId::Timestamp>(
+              core::clock::to_epoch_ms(mono_ms));
+        } else if (mono_ms != prev_ms) {
+          out[written++] = make<MeasurementId::TimeDelta>(
+              static_cast<uint32_t>(mono_ms - prev_ms));
+        }
+        for (size_t i = 0; i < sample.count; ++i) {
+          out[written++] = sample.data[i].unpack();
+        }
+      }
+
+      if (!fn(std::span<const Measurement>(out.data(), written))) {
+        break;
+      }
+
+      {
+        core::LockGuard lock(mutex_);
+        // Pop unless the sample was overwritten while fn ran
+        auto &ring = history_.at(ring_idx);
+        if (ring.size > 0 && ring.samples.at(ring.tail).seq == seq) {
+          ring.tail = (ring.tail + 1) % HISTORY_DEPTH;
+          --ring.size;
+        }
+      }
+
+      first = false;
+      prev_ms = mono_ms;
+      ++consumed;
+    }
+    return consumed;
+  }
+
+  /// Get number of measurements waiting in the history buffers
+  [[nodiscard]] size_t history_measurement_count() const {
+    core::LockGuard lock(mutex_);
+    size_t total = 0;
+    for (const auto &ring : std::span(history_.data(), slots_.size())) {
+      for (size_t i = 0; i < ring.size; ++i) {
+        total += ring.samples.at((ring.tail + i) % HISTORY_DEPTH).count;
+      }
+    }
+    return total;
+  }
+
+  /// Get number of samples overwritten before they were drained
+  [[nodiscard]] uint32_t history_overruns() const {
+    core::LockGuard lock(mutex_);
+    return overruns_;
   }
 
   // ==========================================================================
@@ -116,14 +343,14 @@ public:
   /// @return Number of measurements written
   [[nodiscard]] size_t read_into(SensorIdType sensor_id,
                                  std::span<Measurement> out) const {
-    Lock lock(mutex_);
+    core::LockGuard lock(mutex_);
 
-    auto idx = static_cast<size_t>(sensor_id);
-    if (idx >= SENSOR_COUNT || !cache_.at(idx).valid) {
+    size_t slot = slots_.find(sensor_id);
+    if (slot == Slots::NONE || !cache_.at(slot).valid) {
       return 0;
     }
 
-    const auto &entry = cache_.at(idx);
+    const auto &entry = cache_.at(slot);
     size_t to_copy = std::min(entry.count, out.size());
     std::copy_n(entry.data.begin(), to_copy, out.begin());
     return to_copy;
@@ -132,10 +359,11 @@ public:
   /// Read all into caller-provided buffer (zero allocation)
   /// @return Number of measurements written
   [[nodiscard]] size_t read_all_into(std::span<Measurement> out) const {
-    Lock lock(mutex_);
+    core::LockGuard lock(mutex_);
     size_t written = 0;
 
-    for (const auto &entry : cache_) {
+    for (const auto &slot : slots_.entries()) {
+      const auto &entry = cache_.at(slot.slot);
       if (entry.valid) {
         size_t to_copy = std::min(entry.count, out.size() - written);
         std::copy_n(entry.data.begin(), to_copy,
@@ -152,8 +380,9 @@ public:
   /// Visit each measurement (zero allocation)
   /// Callback: void(const Measurement&)
   template <typename Func> void for_each(const Func &callback) const {
-    Lock lock(mutex_);
-    for (const auto &entry : cache_) {
+    core::LockGuard lock(mutex_);
+    for (const auto &slot : slots_.entries()) {
+      const auto &entry = cache_.at(slot.slot);
       if (entry.valid) {
         for (size_t i = 0; i < entry.count; ++i) {
           callback(entry.data[i]);
@@ -165,12 +394,12 @@ public:
   /// Visit measurements for a specific sensor (zero allocation)
   template <typename Func>
   void for_each(SensorIdType sensor_id, const Func &callback) const {
-    Lock lock(mutex_);
-    auto idx = static_cast<size_t>(sensor_id);
-    if (idx >= SENSOR_COUNT || !cache_.at(idx).valid) {
+    core::LockGuard lock(mutex_);
+    size_t slot = slots_.find(sensor_id);
+    if (slot == Slots::NONE || !cache_.at(slot).valid) {
       return;
     }
-    const auto &entry = cache_.at(idx);
+    const auto &entry = cache_.at(slot);
     for (size_t i = 0; i < entry.count; ++i) {
       callback(entry.data[i]);
     }
@@ -178,7 +407,7 @@ public:
 
   /// Get total measurement count across all sensors
   [[nodiscard]] size_t total_measurement_count() const {
-    Lock lock(mutex_);
+    core::LockGuard lock(mutex_);
     size_t total = 0;
     for (const auto &entry : cache_) {
       if (entry.valid) {
@@ -190,7 +419,7 @@ public:
 
   /// Get number of sensors with cached data
   [[nodiscard]] size_t sensor_count() const {
-    Lock lock(mutex_);
+    core::LockGuard lock(mutex_);
     size_t count = 0;
     for (const auto &entry : cache_) {
       if (entry.valid) {
@@ -200,37 +429,28 @@ public:
     return count;
   }
 
-  /// Clear all cached data
+  /// Clear all cached data and buffered history
+  /// @note Sensors keep their slots
   void clear() {
-    Lock lock(mutex_);
+    core::LockGuard lock(mutex_);
     for (auto &entry : cache_) {
       entry.valid = false;
       entry.count = 0;
     }
+    for (auto &ring : history_) {
+      ring.head = 0;
+      ring.tail = 0;
+      ring.size = 0;
+    }
   }
 
 private:
-  /// RAII lock guard for FreeRTOS mutex
-  class Lock {
-  public:
-    explicit Lock(SemaphoreHandle_t mutex) : mutex_(mutex) {
-      if (mutex_ != nullptr) {
-        xSemaphoreTake(mutex_, portMAX_DELAY);
-      }
-    }
-    ~Lock() {
-      if (mutex_ != nullptr) {
-        xSemaphoreGive(mutex_);
-      }
-    }
-    Lock(const Lock &) = delete;
-    Lock &operator=(const Lock &) = delete;
-    Lock(Lock &&) = delete;
-    Lock &operator=(Lock &&) = delete;
+  using Slots = SlotTable<SENSOR_COUNT>;
 
-  private:
-    SemaphoreHandle_t mutex_;
-  };
+  [[nodiscard]] size_t find_slot(SensorIdType sensor_id) const {
+    core::LockGuard lock(mutex_);
+    return slots_.find(sensor_id);
+  }
 
   /// Cache entry for one sensor
   struct CacheEntry {
@@ -239,10 +459,79 @@ private:
     bool valid = false;
   };
 
+  /// One buffered sample in a history ring
+  struct HistorySample {
+    std::array<PackedMeasurement, MAX_MEASUREMENTS> data{};
+    size_t count = 0;
+    uint32_t seq = 0;     // Arrival order across all sensors
+    int64_t mono_ms = 0;  // core::clock::monotonic_ms() at on_data
+  };
+
+  /// Fixed-capacity ring of samples for one sensor
+  struct HistoryRing {
+    std::array<HistorySample, HISTORY_DEPTH> samples{};
+    size_t head = 0; // Next write slot
+    size_t tail = 0; // Oldest sample
+    size_t size = 0;
+  };
+
+  /// Append sample to sensor's ring, overwriting the oldest when full
+  /// @return First measurement left out for having no packed form
+  /// @note Caller must hold the lock
+  [[nodiscard]] std::optional<MeasurementId>
+  push_history(size_t slot, std::span<const Measurement> measurements) {
+    std::optional<MeasurementId> unpackable;
+    auto &ring = history_.at(slot);
+
+    if (ring.size == HISTORY_DEPTH) {
+      ring.tail = (ring.tail + 1) % HISTORY_DEPTH;
+      --ring.size;
+      ++overruns_;
+    }
+
+    auto &sample = ring.samples.at(ring.head);
+    sample.count = 0;
+    sample.seq = next_seq_++;
+    sample.mono_ms = core::clock::monotonic_ms();
+    for (const auto &m : measurements) {
+      if (auto packed = PackedMeasurement::from(m)) {
+        sample.data[sample.count++] = *packed;
+      } else if (!unpackable) {
+        unpackable = m.id;
+      }
+    }
+
+    ring.head = (ring.head + 1) % HISTORY_DEPTH;
+    ++ring.size;
+    return unpackable;
+  }
+
+  /// Find the non-empty ring whose oldest sample arrived first
+  /// @note Caller must hold the lock
+  [[nodiscard]] HistoryRing *oldest_ring() {
+    HistoryRing *oldest = nullptr;
+    for (auto &ring : std::span(history_.data(), slots_.size())) {
+      if (ring.size == 0) {
+        continue;
+      }
+      // Wrap-safe comparison of sequence numbers
+      if (oldest == nullptr ||
+          static_cast<int32_t>(ring.samples.at(ring.tail).seq -
+                               oldest->samples.at(oldest->tail).seq) < 0) {
+        oldest = &ring;
+      }
+    }
+    return oldest;
+  }
+
   /// Static buffer for mutex (no heap allocation)
-  mutable StaticSemaphore_t mutex_buffer_{};
-  mutable SemaphoreHandle_t mutex_ = nullptr;
-  std::array<CacheEntry, SENSOR_COUNT> cache_{};
+  mutable core::ProfiledLock<core::StaticMutex> mutex_{"data_mgr"};
+  Slots slots_;
+  std::array<CacheEntry, SENSOR_COUNT> cache_{};   ///< By slot
+  std::array<HistoryRing, SENSOR_COUNT> history_{}; ///< By slot
+  uint32_t next_seq_ = 0;
+  uint32_t overruns_ = 0;
+  DataNotifier<SENSOR_COUNT> notifier_;
 };
 
 /// Convenience alias - application should define with its SensorId::Count
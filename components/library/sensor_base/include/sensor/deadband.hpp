@@ -0,0 +1,149 @@
+/**
+ * @file deadband.hpp
+ * @brief Report-by-exception filter for the sensor data path
+ *
+ * DeadbandFilter is an IDataHandler decorator that only forwards a
+ * measurement when it has moved past the deadband declared for its
+ * MeasurementId (see MEASUREMENT_TRAIT) or when the heartbeat timeout has
+ * expired since it was last forwarded. Slowly changing values such as
+ * pressure then cost almost nothing to store and upload.
+ */
+
+#pragma once
+
+#include "data_manager.hpp"
+#include "measurement.hpp"
+#include "sensor.hpp"
+
+#include <core/clock.hpp>
+#include <core/mutex.hpp>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+namespace sensor {
+
+/// Deadband filter configuration
+struct DeadbandConfig {
+  /// Forward a value at least this often even if it did not change
+  std::chrono::milliseconds heartbeat{std::chrono::minutes(15)};
+  /// Declared deadbands are scaled by this (percent; 0 forwards everything)
+  uint16_t scale_percent{100};
+};
+
+/// Report-by-exception filter (IDataHandler decorator)
+///
+/// Deadbands are compared against the last *forwarded* value, so slow drift
+/// is reported once it accumulates past the deadband. Batches left empty
+/// after filtering are not forwarded at all.
+///
+/// @tparam MaxSensors Maximum number of sensor types (use SensorId::Count)
+///
+/// @thread_safety Thread-safe
+template <size_t MaxSensors> class DeadbandFilter final : public IDataHandler {
+public:
+  static constexpr size_t SENSOR_COUNT = MaxSensors;
+  static constexpr size_t ID_COUNT = static_cast<size_t>(MeasurementId::Count);
+  static constexpr size_t MAX_BATCH = 16;
+
+  DeadbandFilter(IDataHandler &downstream, const DeadbandConfig &config)
+      : downstream_(downstream), config_(config) {}
+
+  ~DeadbandFilter() override = default;
+
+  DeadbandFilter(const DeadbandFilter &) = delete;
+  DeadbandFilter &operator=(const DeadbandFilter &) = delete;
+  DeadbandFilter(DeadbandFilter &&) = delete;
+  DeadbandFilter &operator=(DeadbandFilter &&) = delete;
+
+  void on_data(SensorIdType sensor_id,
+               std::span<const Measurement> measurements) override {
+    auto idx = static_cast<size_t>(sensor_id);
+    if (idx >= SENSOR_COUNT) {
+      return;
+    }
+
+    std::array<Measurement, MAX_BATCH> batch{};
+    size_t n = 0;
+    {
+      core::LockGuard lock(mutex_);
+      auto &states = states_.at(idx);
+      int64_t now = core::clock::monotonic_ms();
+
+      for (const auto &m : measurements) {
+        auto id = static_cast<size_t>(m.id);
+        if (id >= ID_COUNT || n >= batch.size()) {
+          continue;
+        }
+        auto &state = states.at(id);
+        auto value = m.to<double>();
+        if (should_forward(m.meta(), state, value, now)) {
+          state = {.value = value, .sent_ms = now, .valid = true};
+          batch.at(n++) = m;
+        } else {
+          ++suppressed_;
+        }
+      }
+    }
+
+    if (n > 0) {
+      downstream_.on_data(sensor_id, std::span(batch.data(), n));
+    }
+  }
+
+  /// Change heartbeat and scale; applies from the next measurement
+  void set_config(const DeadbandConfig &config) {
+    core::LockGuard lock(mutex_);
+    config_ = config;
+  }
+
+  /// Forget the last forwarded values so every id is reported again
+  void reset() {
+    core::LockGuard lock(mutex_);
+    states_ = {};
+  }
+
+  /// Measurements dropped because they stayed inside their deadband
+  [[nodiscard]] uint32_t suppressed_count() const {
+    core::LockGuard lock(mutex_);
+    return suppressed_;
+  }
+
+private:
+  struct State {
+    double value = 0.0;
+    int64_t sent_ms = 0;
+    bool valid = false;
+  };
+
+  [[nodiscard]] bool should_forward(const MeasurementMeta &meta,
+                                    const State &state, double value,
+                                    int64_t now) const {
+    if (!state.valid || now - state.sent_ms >= config_.heartbeat.count()) {
+      return true;
+    }
+    if (config_.scale_percent == 0 ||
+        (meta.deadband_abs <= 0.0F && meta.deadband_rel <= 0.0F)) {
+      return true;
+    }
+
+    double scale = config_.scale_percent / 100.0;
+    double delta = std::fabs(value - state.value);
+    if (meta.deadband_abs > 0.0F && delta >= meta.deadband_abs * scale) {
+      return true;
+    }
+    return meta.deadband_rel > 0.0F &&
+           delta >= meta.deadband_rel * scale * std::fabs(state.value);
+  }
+
+  IDataHandler &downstream_;
+  DeadbandConfig config_;
+  mutable core::Mutex mutex_;
+  std::array<std::array<State, ID_COUNT>, SENSOR_COUNT> states_{};
+  uint32_t suppressed_ = 0;
+};
+
+} // namespace sensor
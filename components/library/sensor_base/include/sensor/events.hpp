@@ -20,7 +20,8 @@ namespace sensor {
 /// Note: ESP-IDF event API uses int32_t internally, but we use uint8_t for
 /// storage
 enum class SensorEvent : uint8_t {
-  DataReady, ///< A sensor has new data available
+  DataReady, ///< A sensor has new data available (not posted by
+             ///< DataManager; per-sample signalling uses DataNotifier)
 };
 
 /// Payload for SensorEvent::DataReady
@@ -0,0 +1,116 @@
+/**
+ * @file layout.hpp
+ * @brief Compile-time measurement layouts and statically typed batch views
+ *
+ * A sensor's measurement layout is a type list of MeasurementIds in the
+ * order its sample() fills them (the same order as SensorBase store()
+ * indices):
+ *
+ *   using Layout = sensor::Layout<MeasurementId::Temperature,
+ *                                 MeasurementId::Humidity>;
+ *
+ * TypedView<Layout> checks a runtime batch against the layout once, then
+ * hands every value to the caller with its MeasurementTraits type. Loops
+ * over the view are unrolled at compile time - no std::visit jump table
+ * per value.
+ */
+
+#pragma once
+
+#include "measurement.hpp"
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace sensor {
+
+/// Value type of a MeasurementId
+template <MeasurementId Id>
+using measurement_type_t = typename MeasurementTraits<Id>::type;
+
+/// Compile-time MeasurementId tag passed to typed visitors
+template <MeasurementId Id>
+using MeasurementTag = std::integral_constant<MeasurementId, Id>;
+
+/// Ordered compile-time list of measurements
+template <MeasurementId... Ids> struct Layout {
+  static constexpr size_t size = sizeof...(Ids);
+  static constexpr std::array<MeasurementId, size> ids{Ids...};
+
+  /// Position of Id in the layout (Id must be present)
+  template <MeasurementId Id>
+  static constexpr size_t index_of = [] {
+    for (size_t i = 0; i < ids.size(); ++i) {
+      if (ids.at(i) == Id) {
+        return i;
+      }
+    }
+    return ids.size();
+  }();
+
+  template <MeasurementId Id>
+  static constexpr bool contains = index_of<Id> < size;
+
+  /// True if measurements has exactly this layout (ids and stored types)
+  [[nodiscard]] static bool matches(std::span<const Measurement> ms) {
+    if (ms.size() != size) {
+      return false;
+    }
+    size_t i = 0;
+    return ((ms[i].id == Ids &&
+             ms[i].value.index() ==
+                 detail::variant_index_of<measurement_type_t<Ids>,
+                                          MeasurementValue> &&
+             ++i != 0) &&
+            ...);
+  }
+};
+
+/// Statically typed view over a batch with a known Layout
+template <typename L> class TypedView {
+public:
+  TypedView() = default;
+
+  /// View measurements, or an empty view if they don't match L
+  [[nodiscard]] static TypedView from(std::span<const Measurement> ms) {
+    return L::matches(ms) ? TypedView(ms) : TypedView();
+  }
+
+  [[nodiscard]] bool valid() const { return !data_.empty(); }
+  explicit operator bool() const { return valid(); }
+
+  /// Value of Id with its static type
+  template <MeasurementId Id> [[nodiscard]] measurement_type_t<Id> get() const {
+    static_assert(L::template contains<Id>, "Id is not part of the layout");
+    // Type checked once in from(); no per-value dispatch
+    return *std::get_if<measurement_type_t<Id>>(
+        &data_[L::template index_of<Id>].value);
+  }
+
+  /// Call fn(MeasurementTag<Id>{}, value) for each entry in layout order
+  template <typename Fn> void for_each(Fn &&fn) const {
+    if (valid()) {
+      for_each_impl(fn, std::make_index_sequence<L::size>{});
+    }
+  }
+
+  [[nodiscard]] std::span<const Measurement> measurements() const {
+    return data_;
+  }
+
+private:
+  explicit TypedView(std::span<const Measurement> ms) : data_(ms) {}
+
+  template <typename Fn, size_t... Is>
+  void for_each_impl(Fn &fn, std::index_sequence<Is...> /*unused*/) const {
+    (fn(MeasurementTag<L::ids[Is]>{}, get<L::ids[Is]>()), ...);
+  }
+
+  std::span<const Measurement> data_{};
+};
+
+} // namespace sensor
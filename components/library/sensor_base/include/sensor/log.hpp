@@ -5,9 +5,10 @@
 
 #pragma once
 
+#include "layout.hpp"
 #include "measurement.hpp"
 
-#include <esp_log.h>
+#include <core/deferred_log.hpp>
 
 #include <cinttypes>
 #include <span>
@@ -15,38 +16,62 @@
 
 namespace sensor {
 
-/// Log a batch of measurements
+namespace detail {
+/// Log one value with its static type
+template <typename T>
+void log_value(const char *tag, const char *name, const char *unit, T v) {
+  if constexpr (std::is_same_v<T, bool>) {
+    CORE_DLOGI(tag, "  %s: %s", name, v ? "true" : "false");
+  } else if constexpr (std::is_same_v<T, uint64_t>) {
+    CORE_DLOGI(tag, "  %s: %" PRIu64 " %s", name, v, unit);
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    CORE_DLOGI(tag, "  %s: %" PRId64 " %s", name, v, unit);
+  } else if constexpr (std::is_same_v<T, uint32_t>) {
+    CORE_DLOGI(tag, "  %s: %" PRIu32 " %s", name, v, unit);
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    CORE_DLOGI(tag, "  %s: %" PRId32 " %s", name, v, unit);
+  } else if constexpr (std::is_same_v<T, uint8_t>) {
+    CORE_DLOGI(tag, "  %s: %u %s", name, static_cast<unsigned>(v), unit);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    CORE_DLOGI(tag, "  %s: %.2f %s", name, static_cast<double>(v), unit);
+  }
+}
+} // namespace detail
+
+/// Log a batch of measurements (deferred, core::dlog)
+/// @param tag Must outlive the printed lines: a TAG constant
 inline void log_measurements(const char *tag,
                              std::span<const Measurement> measurements) {
   if (measurements.empty()) {
     return;
   }
 
-  ESP_LOGI(tag, "--- Sensor Readings (%zu) ---", measurements.size());
+  CORE_DLOGI(tag, "--- Sensor Readings (%zu) ---", measurements.size());
 
   for (const auto &m : measurements) {
     m.visit([&m, tag](auto &&v) {
-      using T = std::decay_t<decltype(v)>;
-
-      if constexpr (std::is_same_v<T, bool>) {
-        ESP_LOGI(tag, "  %s: %s", m.name(), v ? "true" : "false");
-      } else if constexpr (std::is_same_v<T, uint64_t>) {
-        ESP_LOGI(tag, "  %s: %" PRIu64 " %s", m.name(), v, m.unit());
-      } else if constexpr (std::is_same_v<T, int64_t>) {
-        ESP_LOGI(tag, "  %s: %" PRId64 " %s", m.name(), v, m.unit());
-      } else if constexpr (std::is_same_v<T, uint32_t>) {
-        ESP_LOGI(tag, "  %s: %" PRIu32 " %s", m.name(), v, m.unit());
-      } else if constexpr (std::is_same_v<T, int32_t>) {
-        ESP_LOGI(tag, "  %s: %" PRId32 " %s", m.name(), v, m.unit());
-      } else if constexpr (std::is_same_v<T, uint8_t>) {
-        ESP_LOGI(tag, "  %s: %u %s", m.name(), static_cast<unsigned>(v),
-                 m.unit());
-      } else if constexpr (std::is_floating_point_v<T>) {
-        ESP_LOGI(tag, "  %s: %.2f %s", m.name(), static_cast<double>(v),
-                 m.unit());
-      }
+      detail::log_value(tag, m.name(), m.unit(), v);
     });
   }
 }
 
+/// Log a batch with a known layout (names, units and formats resolved at
+/// compile time); falls back to the generic path if the batch differs
+template <typename L>
+void log_measurements(const char *tag,
+                      std::span<const Measurement> measurements) {
+  auto view = TypedView<L>::from(measurements);
+  if (!view) {
+    log_measurements(tag, measurements);
+    return;
+  }
+
+  CORE_DLOGI(tag, "--- Sensor Readings (%zu) ---", L::size);
+
+  view.for_each([tag](auto id, auto v) {
+    using Traits = MeasurementTraits<decltype(id)::value>;
+    detail::log_value(tag, Traits::name, Traits::unit, v);
+  });
+}
+
 } // namespace sensor
@@ -17,6 +17,7 @@
 #include "monitor.hpp"
 
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <span>
 
@@ -73,16 +74,31 @@ public:
   /// @endcode
   ///
   /// @param monitor Monitor to add (must outlive this manager)
-  /// @return true if added, false if at capacity
+  /// @return true if added, false if at capacity (monitors, or DataManager
+  ///         slots for its sensor)
   bool add_monitor(IMonitor &monitor) {
-    if (count_ >= MAX_MONITORS) {
+    if (count_ >= MAX_MONITORS || !data_manager_.add_sensor(monitor.id())) {
       return false;
     }
-    monitor.set_data_handler(&data_manager_);
+    monitor.set_data_handler(pipeline_ != nullptr
+                                 ? pipeline_
+                                 : static_cast<IDataHandler *>(&data_manager_));
+    if (scheduler_ != nullptr) {
+      monitor.set_scheduler(scheduler_);
+    }
     monitors_.at(count_++) = &monitor;
     return true;
   }
 
+  /// Share one scheduler between all monitors added from now on
+  /// @note Call before registering monitors
+  void set_scheduler(SensorScheduler &scheduler) { scheduler_ = &scheduler; }
+
+  /// Route monitors through a processing stage (e.g. WindowAggregator) that
+  /// forwards to the DataManager, instead of feeding it directly
+  /// @note Call before registering monitors
+  void set_pipeline(IDataHandler &handler) { pipeline_ = &handler; }
+
   /// Get number of registered monitors
   [[nodiscard]] size_t monitor_count() const { return count_; }
 
@@ -125,6 +141,16 @@ public:
     return data_manager_.read_all_into(out);
   }
 
+  /// Drain buffered history (oldest first) into caller-provided buffer
+  [[nodiscard]] size_t drain_into(std::span<Measurement> out) {
+    return data_manager_.drain_into(out);
+  }
+
+  /// Visit buffered history per sample without copying it out first
+  template <typename Func> size_t drain_each(const Func &callback) {
+    return data_manager_.drain_each(callback);
+  }
+
   /// Visit each measurement
   template <typename Func>
   void for_each_measurement(const Func &callback) const {
@@ -150,6 +176,16 @@ public:
     }
   }
 
+  /// Change the interval of every fixed-interval monitor
+  /// @return Monitors that took it (externally timed ones keep their own)
+  size_t set_sample_interval(std::chrono::milliseconds interval) {
+    size_t changed = 0;
+    for (size_t i = 0; i < count_; ++i) {
+      changed += monitors_.at(i)->set_interval(interval) ? 1 : 0;
+    }
+    return changed;
+  }
+
   /// Iterate over all monitors
   template <typename Func> void for_each(const Func &callback) {
     for (size_t i = 0; i < count_; ++i) {
@@ -170,6 +206,8 @@ private:
   std::array<IMonitor *, MAX_MONITORS> monitors_{};
   size_t count_ = 0;
   DataManagerType &data_manager_;
+  SensorScheduler *scheduler_ = nullptr;
+  IDataHandler *pipeline_ = nullptr;
 };
 
 } // namespace sensor
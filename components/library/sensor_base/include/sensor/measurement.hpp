@@ -4,6 +4,11 @@
  *
  * Uses MeasurementTraits for compile-time type safety.
  * Each MeasurementId has an associated type, name, and unit.
+ *
+ * Measurements with a fixed-point form (quantized) can travel and be stored
+ * as a small integer: value = raw * 10^quant_exp + quant_offset. The
+ * conversion constants come from the traits, so quantize<Id>() folds to a
+ * multiply and a round.
  */
 
 #pragma once
@@ -11,6 +16,8 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <optional>
 #include <variant>
 
 namespace sensor {
@@ -24,6 +31,42 @@ enum class MeasurementId : uint8_t {
   IAQAccuracy,
   CO2,
   VOC,
+  TimeDelta,
+  Aggregate,
+  BatteryVoltage,
+  WakeEvent,
+  // Wake profile: one per core::WakePhase, in its order
+  ProfileBoot,
+  ProfileStorage,
+  ProfileWifiAssoc,
+  ProfileDhcp,
+  ProfileTls,
+  ProfileAuth,
+  ProfileUpload,
+  ProfileBsec,
+  ProfileSleep,
+  ProfileAwake,        ///< Whole wake of the profile above
+  ProfileMeasureAwake, ///< Whole last wake that didn't transmit
+  // Runtime metrics (core::Metrics), counts per export period
+  MetricSensor, ///< Sensor the MetricSamples / MetricSampleErrors after it
+                ///< are for
+  MetricSamples,
+  MetricSampleErrors,
+  MetricTelemetryBytes,
+  MetricRequests,
+  MetricRequestRetries,
+  MetricLatencyP50,
+  MetricLatencyP90,
+  MetricLatencyMax,
+  MetricWifiRetries,
+  MetricWifiRssi,
+  MetricHeapMinFree,
+  MetricHeapLargestBlock,
+  // Edge anomaly detection (sensor::AnomalyDetector)
+  Anomaly,      ///< (kind << 16) | (sensor << 8) | measurement id
+  AnomalyScore, ///< |z| or units per minute of the Anomaly before it
+  // Local ESP-NOW cluster (cloud::MeshRelay)
+  Origin, ///< Station MAC of the probe that took the sample after it
   Count
 };
 
@@ -37,33 +80,117 @@ using MeasurementValue = std::variant<float, double, int32_t, int64_t, uint32_t,
 
 template <MeasurementId Id> struct MeasurementTraits;
 
-// Helper macro to reduce boilerplate
-#define MEASUREMENT_TRAIT(ID, TYPE, NAME, UNIT)                                \
+// Helper macros to reduce boilerplate
+// DB_ABS / DB_REL: report-by-exception deadband (absolute units / fraction of
+// the last reported value). A value is only forwarded by DeadbandFilter when
+// it moves by at least one of them; 0, 0 forwards every sample.
+// Q_EXP / Q_OFFSET (MEASUREMENT_TRAIT_Q only): fixed-point form, resolution
+// 10^Q_EXP units around Q_OFFSET.
+#define MEASUREMENT_TRAIT_IMPL(ID, TYPE, NAME, UNIT, DB_ABS, DB_REL, QUANT,    \
+                               Q_EXP, Q_OFFSET)                                \
   template <> struct MeasurementTraits<MeasurementId::ID> {                    \
     using type = TYPE;                                                         \
     static constexpr const char *name = NAME;                                  \
     static constexpr const char *unit = UNIT;                                  \
+    static constexpr float deadband_abs = DB_ABS;                              \
+    static constexpr float deadband_rel = DB_REL;                              \
+    static constexpr bool quantized = QUANT;                                   \
+    static constexpr int8_t quant_exp = Q_EXP;                                 \
+    static constexpr float quant_offset = Q_OFFSET;                            \
   }
 
+#define MEASUREMENT_TRAIT(ID, TYPE, NAME, UNIT, DB_ABS, DB_REL)                \
+  MEASUREMENT_TRAIT_IMPL(ID, TYPE, NAME, UNIT, DB_ABS, DB_REL, false, 0, 0.0F)
+
+#define MEASUREMENT_TRAIT_Q(ID, TYPE, NAME, UNIT, DB_ABS, DB_REL, Q_EXP,       \
+                            Q_OFFSET)                                          \
+  MEASUREMENT_TRAIT_IMPL(ID, TYPE, NAME, UNIT, DB_ABS, DB_REL, true, Q_EXP,    \
+                         Q_OFFSET)
+
 // System
-MEASUREMENT_TRAIT(Timestamp, uint64_t, "timestamp", "ms");
+MEASUREMENT_TRAIT(Timestamp, uint64_t, "timestamp", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(TimeDelta, uint32_t, "time_delta", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(Aggregate, uint8_t, "aggregate", "", 0.0F, 0.0F);
+/// GPIOs that woke the device (bit n = GPIO n)
+MEASUREMENT_TRAIT(WakeEvent, uint32_t, "wake_event", "", 0.0F, 0.0F);
+
+// Wake profile (time spent per phase of an earlier wake)
+MEASUREMENT_TRAIT(ProfileBoot, uint32_t, "profile_boot", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileStorage, uint32_t, "profile_storage", "ms", 0.0F,
+                  0.0F);
+MEASUREMENT_TRAIT(ProfileWifiAssoc, uint32_t, "profile_wifi_assoc", "ms", 0.0F,
+                  0.0F);
+MEASUREMENT_TRAIT(ProfileDhcp, uint32_t, "profile_dhcp", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileTls, uint32_t, "profile_tls", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileAuth, uint32_t, "profile_auth", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileUpload, uint32_t, "profile_upload", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileBsec, uint32_t, "profile_bsec", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileSleep, uint32_t, "profile_sleep", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileAwake, uint32_t, "profile_awake", "ms", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(ProfileMeasureAwake, uint32_t, "profile_measure_awake", "ms",
+                  0.0F, 0.0F);
+
+// Runtime metrics (per export period; latency from bucket bounds)
+MEASUREMENT_TRAIT(MetricSensor, uint8_t, "metric_sensor", "", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(MetricSamples, uint32_t, "metric_samples", "", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(MetricSampleErrors, uint32_t, "metric_sample_errors", "",
+                  0.0F, 0.0F);
+MEASUREMENT_TRAIT(MetricTelemetryBytes, uint32_t, "metric_telemetry_bytes",
+                  "B", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(MetricRequests, uint32_t, "metric_requests", "", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(MetricRequestRetries, uint32_t, "metric_request_retries", "",
+                  0.0F, 0.0F);
+MEASUREMENT_TRAIT(MetricLatencyP50, uint32_t, "metric_latency_p50", "ms", 0.0F,
+                  0.0F);
+MEASUREMENT_TRAIT(MetricLatencyP90, uint32_t, "metric_latency_p90", "ms", 0.0F,
+                  0.0F);
+MEASUREMENT_TRAIT(MetricLatencyMax, uint32_t, "metric_latency_max", "ms", 0.0F,
+                  0.0F);
+MEASUREMENT_TRAIT(MetricWifiRetries, uint32_t, "metric_wifi_retries", "", 0.0F,
+                  0.0F);
+MEASUREMENT_TRAIT(MetricWifiRssi, int32_t, "metric_wifi_rssi", "dBm", 0.0F,
+                  0.0F);
+MEASUREMENT_TRAIT(MetricHeapMinFree, uint32_t, "metric_heap_min_free", "B",
+                  0.0F, 0.0F);
+MEASUREMENT_TRAIT(MetricHeapLargestBlock, uint32_t, "metric_heap_largest_block",
+                  "B", 0.0F, 0.0F);
+
+// Anomalies (one sample per anomaly)
+MEASUREMENT_TRAIT(Anomaly, uint32_t, "anomaly", "", 0.0F, 0.0F);
+MEASUREMENT_TRAIT(AnomalyScore, float, "anomaly_score", "", 0.0F, 0.0F);
+
+// Relayed samples (one marker per sample)
+MEASUREMENT_TRAIT(Origin, uint64_t, "origin", "", 0.0F, 0.0F);
 
 // Environmental
-MEASUREMENT_TRAIT(Temperature, float, "temperature", "°C");
-MEASUREMENT_TRAIT(Humidity, float, "humidity", "%");
-MEASUREMENT_TRAIT(Pressure, float, "pressure", "hPa");
+MEASUREMENT_TRAIT_Q(Temperature, float, "temperature", "°C", 0.1F, 0.0F, -2,
+                    0.0F);
+MEASUREMENT_TRAIT_Q(Humidity, float, "humidity", "%", 0.5F, 0.0F, -2, 0.0F);
+MEASUREMENT_TRAIT_Q(Pressure, float, "pressure", "hPa", 0.1F, 0.0F, -2,
+                    1000.0F);
 
 // Air quality
-MEASUREMENT_TRAIT(IAQ, float, "iaq", "");
-MEASUREMENT_TRAIT(IAQAccuracy, uint8_t, "iaq_accuracy", "/3");
-MEASUREMENT_TRAIT(CO2, float, "co2", "ppm");
-MEASUREMENT_TRAIT(VOC, float, "voc", "ppm");
+MEASUREMENT_TRAIT_Q(IAQ, float, "iaq", "", 2.0F, 0.02F, -1, 0.0F);
+MEASUREMENT_TRAIT(IAQAccuracy, uint8_t, "iaq_accuracy", "/3", 1.0F, 0.0F);
+MEASUREMENT_TRAIT_Q(CO2, float, "co2", "ppm", 10.0F, 0.02F, 0, 400.0F);
+MEASUREMENT_TRAIT_Q(VOC, float, "voc", "ppm", 0.05F, 0.05F, -2, 0.0F);
 
+// Supply
+MEASUREMENT_TRAIT_Q(BatteryVoltage, float, "battery", "V", 0.02F, 0.0F, -3,
+                    3.0F);
+
+#undef MEASUREMENT_TRAIT_Q
 #undef MEASUREMENT_TRAIT
+#undef MEASUREMENT_TRAIT_IMPL
 
 struct MeasurementMeta {
   const char *name;
   const char *unit;
+  float deadband_abs;
+  float deadband_rel;
+  bool quantized;
+  int8_t quant_exp;
+  float quant_offset;
 };
 
 namespace detail {
@@ -71,7 +198,12 @@ template <std::size_t... Is>
 constexpr auto make_meta_table(std::index_sequence<Is...>) {
   return std::array<MeasurementMeta, sizeof...(Is)>{MeasurementMeta{
       MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::name,
-      MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::unit}...};
+      MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::unit,
+      MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::deadband_abs,
+      MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::deadband_rel,
+      MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::quantized,
+      MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::quant_exp,
+      MeasurementTraits<static_cast<MeasurementId>(Is + 1)>::quant_offset}...};
 }
 } // namespace detail
 
@@ -93,6 +225,28 @@ template <typename T>
 inline constexpr bool is_measurement_type_v =
     is_variant_member<T, MeasurementValue>::value;
 
+namespace detail {
+/// Index of T within a std::variant (T must be a member)
+template <typename T, typename Variant> struct variant_index;
+
+template <typename T, typename... Types>
+struct variant_index<T, std::variant<Types...>> {
+  static constexpr size_t value = [] {
+    constexpr std::array<bool, sizeof...(Types)> matches{
+        std::is_same_v<T, Types>...};
+    for (size_t i = 0; i < matches.size(); ++i) {
+      if (matches.at(i)) {
+        return i;
+      }
+    }
+    return matches.size();
+  }();
+};
+
+template <typename T, typename Variant>
+inline constexpr size_t variant_index_of = variant_index<T, Variant>::value;
+} // namespace detail
+
 // ============================================================================
 // Measurement struct - Runtime storage
 // ============================================================================
@@ -127,6 +281,12 @@ struct Measurement {
 
   /// Convert value to target type
   template <typename Target> [[nodiscard]] Target to() const {
+    // Stored type already matches: no variant dispatch
+    if constexpr (is_measurement_type_v<Target>) {
+      if (const auto *v = std::get_if<Target>(&value)) {
+        return *v;
+      }
+    }
     return std::visit(
         [](auto &&v) -> Target {
           using T = std::decay_t<decltype(v)>;
@@ -171,4 +331,104 @@ template <MeasurementId Id>
   return Measurement(Id, value);
 }
 
+// ============================================================================
+// Fixed-point quantization (MEASUREMENT_TRAIT_Q)
+// ============================================================================
+
+template <MeasurementId Id>
+inline constexpr bool is_quantized_v = MeasurementTraits<Id>::quantized;
+
+namespace detail {
+[[nodiscard]] constexpr double pow10(int exp) {
+  double r = 1.0;
+  for (; exp > 0; --exp) {
+    r *= 10.0;
+  }
+  for (; exp < 0; ++exp) {
+    r /= 10.0;
+  }
+  return r;
+}
+
+/// Round to nearest and range-check into int32
+[[nodiscard]] constexpr std::optional<int32_t> round_to_i32(double v) {
+  constexpr double lo = std::numeric_limits<int32_t>::min();
+  constexpr double hi = std::numeric_limits<int32_t>::max();
+  double r = v < 0.0 ? v - 0.5 : v + 0.5;
+  if (!(r > lo - 1.0 && r < hi + 1.0)) { // also rejects NaN
+    return std::nullopt;
+  }
+  return static_cast<int32_t>(r);
+}
+
+[[nodiscard]] constexpr std::optional<int32_t>
+quantize(double value, int exp, double offset) {
+  return round_to_i32((value - offset) / pow10(exp));
+}
+
+[[nodiscard]] constexpr double dequantize(int32_t raw, int exp,
+                                          double offset) {
+  return (static_cast<double>(raw) * pow10(exp)) + offset;
+}
+} // namespace detail
+
+/// Fixed-point form of a value (resolution and offset from the traits)
+/// @return Raw integer, or nullopt if out of int32 range
+template <MeasurementId Id>
+[[nodiscard]] constexpr std::optional<int32_t>
+quantize(typename MeasurementTraits<Id>::type value) {
+  using Traits = MeasurementTraits<Id>;
+  static_assert(Traits::quantized, "Measurement has no fixed-point form");
+  return detail::quantize(static_cast<double>(value), Traits::quant_exp,
+                          Traits::quant_offset);
+}
+
+/// Value of a fixed-point raw integer, in the measurement's type
+template <MeasurementId Id>
+[[nodiscard]] constexpr typename MeasurementTraits<Id>::type
+dequantize(int32_t raw) {
+  using Traits = MeasurementTraits<Id>;
+  static_assert(Traits::quantized, "Measurement has no fixed-point form");
+  return static_cast<typename Traits::type>(
+      detail::dequantize(raw, Traits::quant_exp, Traits::quant_offset));
+}
+
+/// Fixed-point form of a runtime measurement
+/// @return nullopt if the id has no fixed-point form or is out of range
+[[nodiscard]] inline std::optional<int32_t> quantize(const Measurement &m) {
+  const auto &meta = m.meta();
+  if (!meta.quantized) {
+    return std::nullopt;
+  }
+  return detail::quantize(m.to<double>(), meta.quant_exp, meta.quant_offset);
+}
+
+namespace detail {
+template <size_t... Is>
+[[nodiscard]] Measurement dequantize_any(MeasurementId id, int32_t raw,
+                                         std::index_sequence<Is...>) {
+  Measurement out(id, 0.0F);
+  (void)((id == static_cast<MeasurementId>(Is + 1) &&
+          (out = [raw] {
+             constexpr auto Id = static_cast<MeasurementId>(Is + 1);
+             if constexpr (is_quantized_v<Id>) {
+               return make<Id>(sensor::dequantize<Id>(raw));
+             } else {
+               return Measurement(Id, raw);
+             }
+           }(),
+           true)) ||
+         ...);
+  return out;
+}
+} // namespace detail
+
+/// Rebuild a measurement from its fixed-point form (stored as the id's type)
+[[nodiscard]] inline Measurement dequantize(MeasurementId id, int32_t raw) {
+  return detail::dequantize_any(
+      id, raw,
+      std::make_index_sequence<static_cast<size_t>(MeasurementId::Count) -
+                               1>{});
+}
+
 } // namespace sensor
@@ -9,15 +9,22 @@
  * Two types:
  * - SensorMonitor: Fixed interval, user-configurable
  * - ExternallyTimedMonitor: Sensor controls timing (e.g., BSEC)
+ *
+ * By default each monitor arms its own timer. Attach a SensorScheduler
+ * (before start) to share wakeups between monitors instead.
  */
 
 #pragma once
 
 #include "data_manager.hpp"
+#include "scheduler.hpp"
 #include "sensor.hpp"
 
+#include <core/metrics.hpp>
 #include <core/timer.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <string_view>
 #include <type_traits>
@@ -61,9 +68,18 @@ public:
   /// Set data handler for routing measurements to DataManager
   virtual void set_data_handler(IDataHandler *handler) = 0;
 
+  /// Use a shared scheduler instead of the monitor's own timer
+  /// @note Call while stopped; nullptr reverts to the own timer
+  virtual void set_scheduler(SensorScheduler *scheduler) = 0;
+
   /// Consecutive error count (resets on successful sample)
   [[nodiscard]] virtual uint32_t error_count() const = 0;
 
+  /// Change the sampling interval (from any task; the pending wait runs
+  /// out first)
+  /// @return false if the sensor dictates its own timing
+  virtual bool set_interval(std::chrono::milliseconds interval) = 0;
+
 protected:
   IMonitor() = default;
 };
@@ -73,7 +89,8 @@ protected:
 // ============================================================================
 
 /// Monitor that samples a sensor at a fixed interval
-template <typename Sensor> class SensorMonitor final : public IMonitor {
+template <typename Sensor>
+class SensorMonitor final : public IMonitor, public IScheduledTask {
   static_assert(std::is_base_of_v<ISensor, Sensor>,
                 "Sensor must implement ISensor");
 
@@ -96,6 +113,9 @@ public:
 
   void stop() override {
     running_ = false;
+    if (scheduler_ != nullptr) {
+      scheduler_->cancel(slot_);
+    }
     [[maybe_unused]] auto status = timer_.stop();
   }
 
@@ -115,12 +135,35 @@ public:
     data_handler_ = handler;
   }
 
+  void set_scheduler(SensorScheduler *scheduler) override {
+    if (scheduler_ != nullptr) {
+      scheduler_->remove(slot_);
+      slot_ = SensorScheduler::INVALID_SLOT;
+    }
+    scheduler_ = scheduler;
+    if (scheduler_ != nullptr) {
+      slot_ = scheduler_->add(*this);
+      if (slot_ == SensorScheduler::INVALID_SLOT) {
+        scheduler_ = nullptr; // Table full - keep using own timer
+      }
+    }
+  }
+
+  void run_scheduled() override { on_timer(); }
+
   [[nodiscard]] uint32_t error_count() const override {
     return consecutive_errors_;
   }
 
+  bool set_interval(std::chrono::milliseconds interval) override {
+    interval_ = interval;
+    return true;
+  }
+
   /// Get the configured interval
-  [[nodiscard]] std::chrono::milliseconds interval() const { return interval_; }
+  [[nodiscard]] std::chrono::milliseconds interval() const {
+    return interval_.load();
+  }
 
   /// Access underlying sensor (for sensor-specific operations)
   [[nodiscard]] Sensor &sensor() { return sensor_; }
@@ -129,12 +172,13 @@ public:
 private:
   void on_timer() {
     do_sample();
-    schedule_next();
+    schedule_next(true);
   }
 
   void do_sample() {
     auto measurements = sensor_.sample();
 
+    core::metrics().sample(sensor_.id(), !measurements.empty());
     if (measurements.empty()) {
       consecutive_errors_++;
       return;
@@ -147,15 +191,27 @@ private:
     }
   }
 
-  void schedule_next() {
-    if (running_) {
-      [[maybe_unused]] auto status = timer_.start(interval_);
+  /// @param periodic One interval after the last deadline (else from now)
+  void schedule_next(bool periodic = false) {
+    if (!running_) {
+      return;
+    }
+    if (scheduler_ != nullptr) {
+      if (periodic) {
+        scheduler_->reschedule(slot_, interval_.load());
+      } else {
+        scheduler_->schedule(slot_, interval_.load());
+      }
+      return;
     }
+    [[maybe_unused]] auto status = timer_.start(interval_.load());
   }
 
   Sensor sensor_;
-  std::chrono::milliseconds interval_;
+  std::atomic<std::chrono::milliseconds> interval_; ///< Set from any task
   core::OneShotTimer timer_;
+  SensorScheduler *scheduler_ = nullptr;
+  SensorScheduler::Slot slot_ = SensorScheduler::INVALID_SLOT;
   IDataHandler *data_handler_ = nullptr;
   uint32_t consecutive_errors_ = 0;
   bool running_ = false;
@@ -168,7 +224,7 @@ private:
 /// Monitor for sensors that control their own timing (e.g., BSEC)
 /// Sensor must implement IExternallyTimedSensor
 template <typename Sensor>
-class ExternallyTimedMonitor final : public IMonitor {
+class ExternallyTimedMonitor final : public IMonitor, public IScheduledTask {
   static_assert(std::is_base_of_v<IExternallyTimedSensor, Sensor>,
                 "Sensor must implement IExternallyTimedSensor");
 
@@ -191,6 +247,9 @@ public:
 
   void stop() override {
     running_ = false;
+    if (scheduler_ != nullptr) {
+      scheduler_->cancel(slot_);
+    }
     [[maybe_unused]] auto status = timer_.stop();
   }
 
@@ -208,10 +267,31 @@ public:
     data_handler_ = handler;
   }
 
+  void set_scheduler(SensorScheduler *scheduler) override {
+    if (scheduler_ != nullptr) {
+      scheduler_->remove(slot_);
+      slot_ = SensorScheduler::INVALID_SLOT;
+    }
+    scheduler_ = scheduler;
+    if (scheduler_ != nullptr) {
+      slot_ = scheduler_->add(*this);
+      if (slot_ == SensorScheduler::INVALID_SLOT) {
+        scheduler_ = nullptr; // Table full - keep using own timer
+      }
+    }
+  }
+
+  void run_scheduled() override { on_timer(); }
+
   [[nodiscard]] uint32_t error_count() const override {
     return consecutive_errors_;
   }
 
+  /// Timing comes from the sensor (e.g. BSEC's sample rate)
+  bool set_interval(std::chrono::milliseconds /*interval*/) override {
+    return false;
+  }
+
   /// Access underlying sensor
   [[nodiscard]] Sensor &sensor() { return sensor_; }
   [[nodiscard]] const Sensor &sensor() const { return sensor_; }
@@ -225,6 +305,11 @@ private:
   void do_sample() {
     auto measurements = sensor_.sample();
 
+    if (sensor_.sample_pending()) {
+      return; // Measurement started; collected on the next run
+    }
+
+    core::metrics().sample(sensor_.id(), !measurements.empty());
     if (measurements.empty()) {
       consecutive_errors_++;
       return;
@@ -242,15 +327,26 @@ private:
       return;
     }
     auto delay = sensor_.next_sample_delay();
-    // Minimum 10ms to avoid busy-looping
-    if (delay < std::chrono::microseconds(10000)) {
-      delay = std::chrono::microseconds(10000);
+    // Minimum 10ms to avoid busy-looping; down to 1ms for a sensor whose
+    // min_interval() asks for it (e.g. the simulated sensor at 1 kHz)
+    auto floor = std::chrono::microseconds(
+        std::clamp(sensor_.min_interval(), std::chrono::milliseconds(1),
+                   std::chrono::milliseconds(10)));
+    if (delay < floor) {
+      delay = floor;
+    }
+    if (scheduler_ != nullptr) {
+      // Sensor-dictated timing must not run early: zero tolerance
+      scheduler_->schedule(slot_, delay, std::chrono::microseconds(0));
+      return;
     }
     [[maybe_unused]] auto status = timer_.start(delay);
   }
 
   Sensor sensor_;
   core::OneShotTimer timer_;
+  SensorScheduler *scheduler_ = nullptr;
+  SensorScheduler::Slot slot_ = SensorScheduler::INVALID_SLOT;
   IDataHandler *data_handler_ = nullptr;
   uint32_t consecutive_errors_ = 0;
   bool running_ = false;
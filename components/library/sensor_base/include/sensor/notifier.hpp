@@ -0,0 +1,101 @@
+/**
+ * @file notifier.hpp
+ * @brief Lightweight "new data" signal for sensor consumers
+ *
+ * Replaces posting DataReady to the default esp_event loop on every sample.
+ * Producers bump a per-sensor sequence counter and set a bit in a pending
+ * mask; an optional waiting task is woken with a direct task notification
+ * carrying the same bitmask. Nothing is copied and no queue is involved.
+ *
+ * Consumers either block in wait() or poll take_pending() / sequence().
+ *
+ * Sensors are addressed by a dense slot (0..MaxSensors-1), such as
+ * DataManagerT's slot of a sensor (DataManagerT::bit() maps an ID to it).
+ */
+
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace sensor {
+
+/// Per-sensor sequence counters plus a task-notification bitmask
+///
+/// @tparam MaxSensors Slots (at most 32)
+///
+/// @thread_safety notify() from any task; one waiter task
+template <size_t MaxSensors> class DataNotifier {
+public:
+  static constexpr size_t SENSOR_COUNT = MaxSensors;
+  static_assert(SENSOR_COUNT <= 32, "Sensor bitmask is 32 bits wide");
+
+  /// Bit for a slot in pending / wait() masks
+  [[nodiscard]] static constexpr uint32_t bit(size_t slot) {
+    return 1U << slot;
+  }
+
+  /// Task woken (eSetBits) on every notify()
+  /// @note Uses notification index 0 of that task
+  void set_waiter(TaskHandle_t task) {
+    waiter_.store(task, std::memory_order_release);
+  }
+
+  /// Signal new data for a slot (called by the producer)
+  void notify(size_t slot) {
+    if (slot >= SENSOR_COUNT) {
+      return;
+    }
+    sequences_.at(slot).fetch_add(1, std::memory_order_release);
+    pending_.fetch_or(bit(slot), std::memory_order_release);
+
+    if (TaskHandle_t task = waiter_.load(std::memory_order_acquire)) {
+      xTaskNotify(task, bit(slot), eSetBits);
+    }
+  }
+
+  /// Block the waiter task until data arrives or timeout expires
+  /// @return Mask of slots updated since the last wait/take (0 on timeout)
+  template <typename Rep, typename Period>
+  [[nodiscard]] uint32_t wait(std::chrono::duration<Rep, Period> timeout) {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(timeout);
+    uint32_t bits = 0;
+    (void)xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(ms.count()));
+    return bits | take_pending();
+  }
+
+  /// Block the waiter task until data arrives
+  /// @return Mask of slots updated since the last wait/take
+  [[nodiscard]] uint32_t wait() {
+    uint32_t bits = 0;
+    (void)xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+    return bits | take_pending();
+  }
+
+  /// Non-blocking: mask of slots updated since the last call
+  [[nodiscard]] uint32_t take_pending() {
+    return pending_.exchange(0, std::memory_order_acq_rel);
+  }
+
+  /// Number of samples published for a slot (wraps)
+  /// Consumers compare against a saved value to detect new data.
+  [[nodiscard]] uint32_t sequence(size_t slot) const {
+    if (slot >= SENSOR_COUNT) {
+      return 0;
+    }
+    return sequences_.at(slot).load(std::memory_order_acquire);
+  }
+
+private:
+  std::array<std::atomic<uint32_t>, SENSOR_COUNT> sequences_{};
+  std::atomic<uint32_t> pending_{0};
+  std::atomic<TaskHandle_t> waiter_{nullptr};
+};
+
+} // namespace sensor
@@ -0,0 +1,145 @@
+/**
+ * @file packed_measurement.hpp
+ * @brief 8-byte packed storage form of Measurement
+ *
+ * Measurement carries a std::variant sized for 64-bit values, so every
+ * stored float costs 24 bytes. PackedMeasurement keeps id, type tag and a
+ * 48-bit payload in 8 bytes for ring buffers and flash queues.
+ *
+ * Encoding:
+ * - 32-bit and smaller types: bit pattern in `lo`, `hi` = 0
+ * - int64_t / uint64_t: low 48 bits split across `hi`:`lo`
+ *   (enough for millisecond Unix timestamps until year 10889)
+ * - double: not packable (no lossless 48-bit form)
+ *
+ * Conversion is lossless; values that do not fit are rejected.
+ */
+
+#pragma once
+
+#include "measurement.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <variant>
+
+namespace sensor {
+
+/// Check if a value type has a lossless packed encoding
+template <typename T>
+inline constexpr bool is_packable_v =
+    is_measurement_type_v<T> && !std::is_same_v<T, double>;
+
+namespace detail {
+/// Type tag stored in PackedMeasurement (index into MeasurementValue)
+template <typename T>
+inline constexpr uint8_t packed_tag =
+    static_cast<uint8_t>(variant_index_of<T, MeasurementValue>);
+} // namespace detail
+
+/// Compact measurement record (8 bytes, 4-byte aligned)
+struct PackedMeasurement {
+  MeasurementId id{MeasurementId::Timestamp};
+  uint8_t tag{0};  // Index into MeasurementValue
+  uint16_t hi{0};  // Bits 32..47 of 64-bit integers
+  uint32_t lo{0};  // Bits 0..31 of the value
+
+  /// Largest magnitude representable by 64-bit integer payloads
+  static constexpr uint64_t PAYLOAD_MAX_U64 = (uint64_t{1} << 48) - 1;
+  static constexpr int64_t PAYLOAD_MIN_I64 = -(int64_t{1} << 47);
+  static constexpr int64_t PAYLOAD_MAX_I64 = (int64_t{1} << 47) - 1;
+
+  /// Pack a value with compile-time type check against MeasurementTraits
+  /// @return Packed record, or nullopt if a 64-bit value exceeds 48 bits
+  template <MeasurementId Id>
+  [[nodiscard]] static constexpr std::optional<PackedMeasurement>
+  pack(typename MeasurementTraits<Id>::type value) {
+    using T = typename MeasurementTraits<Id>::type;
+    static_assert(is_packable_v<T>, "Measurement type has no packed encoding");
+    return encode<T>(Id, value);
+  }
+
+  /// Pack a runtime Measurement
+  /// @return Packed record, or nullopt if the value cannot be packed
+  [[nodiscard]] static std::optional<PackedMeasurement>
+  from(const Measurement &m) {
+    return std::visit(
+        [&m](auto &&v) -> std::optional<PackedMeasurement> {
+          using T = std::decay_t<decltype(v)>;
+          if constexpr (is_packable_v<T>) {
+            return encode<T>(m.id, v);
+          } else {
+            return std::nullopt;
+          }
+        },
+        m.value);
+  }
+
+  /// Restore the original Measurement
+  [[nodiscard]] Measurement unpack() const {
+    switch (tag) {
+    case detail::packed_tag<float>:
+      return {id, std::bit_cast<float>(lo)};
+    case detail::packed_tag<int32_t>:
+      return {id, std::bit_cast<int32_t>(lo)};
+    case detail::packed_tag<int64_t>:
+      return {id, sign_extend_48(payload_48())};
+    case detail::packed_tag<uint32_t>:
+      return {id, lo};
+    case detail::packed_tag<uint64_t>:
+      return {id, payload_48()};
+    case detail::packed_tag<uint8_t>:
+      return {id, static_cast<uint8_t>(lo)};
+    case detail::packed_tag<bool>:
+      return {id, lo != 0};
+    default:
+      return {id, 0.0F};
+    }
+  }
+
+private:
+  [[nodiscard]] constexpr uint64_t payload_48() const {
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+  }
+
+  [[nodiscard]] static constexpr int64_t sign_extend_48(uint64_t raw) {
+    constexpr uint64_t sign_bit = uint64_t{1} << 47;
+    return static_cast<int64_t>((raw ^ sign_bit) - sign_bit);
+  }
+
+  template <typename T>
+  [[nodiscard]] static constexpr std::optional<PackedMeasurement>
+  encode(MeasurementId id, T value) {
+    PackedMeasurement p{};
+    p.id = id;
+    p.tag = detail::packed_tag<T>;
+
+    if constexpr (std::is_same_v<T, uint64_t>) {
+      if (value > PAYLOAD_MAX_U64) {
+        return std::nullopt;
+      }
+      p.hi = static_cast<uint16_t>(value >> 32);
+      p.lo = static_cast<uint32_t>(value);
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+      if (value < PAYLOAD_MIN_I64 || value > PAYLOAD_MAX_I64) {
+        return std::nullopt;
+      }
+      auto raw = static_cast<uint64_t>(value);
+      p.hi = static_cast<uint16_t>(raw >> 32);
+      p.lo = static_cast<uint32_t>(raw);
+    } else if constexpr (std::is_same_v<T, float> ||
+                         std::is_same_v<T, int32_t>) {
+      p.lo = std::bit_cast<uint32_t>(value);
+    } else {
+      p.lo = static_cast<uint32_t>(value);
+    }
+    return p;
+  }
+};
+
+static_assert(sizeof(PackedMeasurement) == 8,
+              "PackedMeasurement must stay 8 bytes");
+
+} // namespace sensor
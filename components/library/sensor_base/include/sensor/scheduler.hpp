@@ -0,0 +1,247 @@
+/**
+ * @file scheduler.hpp
+ * @brief SensorScheduler - Coalesces monitor wakeups into shared timer slots
+ *
+ * Without a scheduler every monitor arms its own esp_timer, so the CPU leaves
+ * tickless idle at unrelated instants. The scheduler owns a single one-shot
+ * timer armed for the earliest deadline. When it fires, every entry whose
+ * deadline falls within its tolerance window is run back-to-back in the same
+ * wakeup, so flexible samplers piggyback on the strict ones.
+ *
+ * Tolerance is per entry and only ever runs work EARLY (never late):
+ * - Fixed-interval monitors use the scheduler's default tolerance
+ * - Externally timed monitors (BSEC) use zero and act as anchors
+ *
+ * Fixed-interval work re-arms with reschedule(), from its previous deadline,
+ * so running early for a shared wakeup doesn't pull its period in.
+ *
+ * Memory: Fixed-size entry table, no heap allocation after construction.
+ */
+
+#pragma once
+
+#include <core/mutex.hpp>
+#include <core/timer.hpp>
+
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace sensor {
+
+/// Work item run by SensorScheduler
+class IScheduledTask {
+public:
+  virtual ~IScheduledTask() = default;
+
+  IScheduledTask(const IScheduledTask &) = delete;
+  IScheduledTask &operator=(const IScheduledTask &) = delete;
+  IScheduledTask(IScheduledTask &&) = delete;
+  IScheduledTask &operator=(IScheduledTask &&) = delete;
+
+  /// Called from the scheduler's timer (esp_timer task context)
+  virtual void run_scheduled() = 0;
+
+protected:
+  IScheduledTask() = default;
+};
+
+/// Maximum number of tasks a scheduler can hold
+inline constexpr size_t MAX_SCHEDULED_TASKS = 8;
+
+/// Shared wakeup scheduler for sensor monitors
+///
+/// @thread_safety Thread-safe. schedule()/cancel() may be called from any
+/// task, including from inside run_scheduled().
+class SensorScheduler {
+public:
+  using Slot = uint8_t;
+  static constexpr Slot INVALID_SLOT = std::numeric_limits<Slot>::max();
+
+  /// @param default_tolerance How early fixed-interval work may run to share
+  ///        a wakeup with another deadline
+  explicit SensorScheduler(std::chrono::milliseconds default_tolerance =
+                               std::chrono::milliseconds(500))
+      : default_tolerance_(default_tolerance),
+        timer_([this]() { on_timer(); }) {}
+
+  ~SensorScheduler() { (void)timer_.stop(); }
+
+  SensorScheduler(const SensorScheduler &) = delete;
+  SensorScheduler &operator=(const SensorScheduler &) = delete;
+  SensorScheduler(SensorScheduler &&) = delete;
+  SensorScheduler &operator=(SensorScheduler &&) = delete;
+
+  /// Register a task
+  /// @return Slot handle, or INVALID_SLOT if the table is full
+  [[nodiscard]] Slot add(IScheduledTask &task) {
+    core::LockGuard lock(mutex_);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      if (entries_.at(i).task == nullptr) {
+        entries_.at(i) = Entry{.task = &task};
+        return static_cast<Slot>(i);
+      }
+    }
+    return INVALID_SLOT;
+  }
+
+  /// Unregister a task (cancels any pending run)
+  void remove(Slot slot) {
+    core::LockGuard lock(mutex_);
+    if (slot < entries_.size()) {
+      entries_.at(slot) = Entry{};
+      rearm_locked();
+    }
+  }
+
+  /// Schedule a task to run after delay
+  /// @param tolerance How much earlier than the deadline it may run
+  template <typename Rep, typename Period, typename TolRep, typename TolPeriod>
+  void schedule(Slot slot, std::chrono::duration<Rep, Period> delay,
+                std::chrono::duration<TolRep, TolPeriod> tolerance) {
+    int64_t delay_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(delay).count();
+    int64_t tol_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(tolerance)
+            .count();
+
+    core::LockGuard lock(mutex_);
+    if (slot >= entries_.size() || entries_.at(slot).task == nullptr) {
+      return;
+    }
+    auto &entry = entries_.at(slot);
+    entry.deadline_us = esp_timer_get_time() + std::max<int64_t>(delay_us, 0);
+    entry.tolerance_us = std::max<int64_t>(tol_us, 0);
+    entry.armed = true;
+    rearm_locked();
+  }
+
+  /// Schedule with the scheduler's default tolerance
+  template <typename Rep, typename Period>
+  void schedule(Slot slot, std::chrono::duration<Rep, Period> delay) {
+    schedule(slot, delay, default_tolerance_);
+  }
+
+  /// Re-arm periodic work one period after its previous deadline, not after
+  /// now: running early (within the tolerance) or late doesn't shift the
+  /// grid. Periods already missed are skipped, not run back-to-back.
+  /// @note Call from run_scheduled(); the first run comes from schedule()
+  template <typename Rep, typename Period>
+  void reschedule(Slot slot, std::chrono::duration<Rep, Period> period) {
+    int64_t period_us = std::max<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(period).count(),
+        1);
+    int64_t tol_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            default_tolerance_)
+            .count();
+
+    core::LockGuard lock(mutex_);
+    if (slot >= entries_.size() || entries_.at(slot).task == nullptr) {
+      return;
+    }
+    auto &entry = entries_.at(slot);
+    int64_t now = esp_timer_get_time();
+    int64_t deadline_us = entry.deadline_us + period_us;
+    if (deadline_us < now) {
+      deadline_us += (((now - deadline_us) / period_us) + 1) * period_us;
+    }
+    entry.deadline_us = deadline_us;
+    entry.tolerance_us = std::max<int64_t>(tol_us, 0);
+    entry.armed = true;
+    rearm_locked();
+  }
+
+  /// Cancel a pending run
+  void cancel(Slot slot) {
+    core::LockGuard lock(mutex_);
+    if (slot < entries_.size()) {
+      entries_.at(slot).armed = false;
+      rearm_locked();
+    }
+  }
+
+  [[nodiscard]] std::chrono::milliseconds default_tolerance() const {
+    return default_tolerance_;
+  }
+
+  /// Number of timer wakeups so far
+  [[nodiscard]] uint32_t wakeup_count() const { return wakeups_; }
+
+  /// Number of tasks run so far (runs / wakeups = coalescing ratio)
+  [[nodiscard]] uint32_t run_count() const { return runs_; }
+
+private:
+  struct Entry {
+    IScheduledTask *task = nullptr;
+    int64_t deadline_us = 0;
+    int64_t tolerance_us = 0;
+    bool armed = false;
+  };
+
+  /// Arm the timer for the earliest deadline
+  /// @note Caller must hold the lock
+  void rearm_locked() {
+    if (dispatching_) {
+      return; // on_timer() re-arms once after the batch
+    }
+
+    int64_t earliest = std::numeric_limits<int64_t>::max();
+    for (const auto &entry : entries_) {
+      if (entry.armed) {
+        earliest = std::min(earliest, entry.deadline_us);
+      }
+    }
+
+    (void)timer_.stop();
+    if (earliest == std::numeric_limits<int64_t>::max()) {
+      return;
+    }
+
+    int64_t delay_us = std::max<int64_t>(earliest - esp_timer_get_time(), 0);
+    (void)timer_.start(std::chrono::microseconds(delay_us));
+  }
+
+  void on_timer() {
+    std::array<IScheduledTask *, MAX_SCHEDULED_TASKS> due{};
+    size_t due_count = 0;
+
+    {
+      core::LockGuard lock(mutex_);
+      int64_t now = esp_timer_get_time();
+      for (auto &entry : entries_) {
+        if (entry.armed && entry.deadline_us - entry.tolerance_us <= now) {
+          entry.armed = false;
+          due.at(due_count++) = entry.task;
+        }
+      }
+      dispatching_ = true;
+      ++wakeups_;
+      runs_ += due_count;
+    }
+
+    // Run outside the lock so tasks can reschedule themselves
+    for (size_t i = 0; i < due_count; ++i) {
+      due.at(i)->run_scheduled();
+    }
+
+    core::LockGuard lock(mutex_);
+    dispatching_ = false;
+    rearm_locked();
+  }
+
+  std::chrono::milliseconds default_tolerance_;
+  core::OneShotTimer timer_;
+  core::Mutex mutex_;
+  std::array<Entry, MAX_SCHEDULED_TASKS> entries_{};
+  bool dispatching_ = false;
+  uint32_t wakeups_ = 0;
+  uint32_t runs_ = 0;
+};
+
+} // namespace sensor
@@ -53,6 +53,13 @@ class IExternallyTimedSensor : public ISensor {
 public:
   /// Get delay until next sample should occur
   [[nodiscard]] virtual std::chrono::microseconds next_sample_delay() = 0;
+
+  /// True if the last sample() only started a measurement
+  ///
+  /// Split-phase sensors trigger a conversion in one sample() call and
+  /// collect it in the next (after next_sample_delay()). The monitor
+  /// publishes nothing for the triggering call.
+  [[nodiscard]] virtual bool sample_pending() const { return false; }
 };
 
 /// Helper base class for sensors with fixed measurement count
@@ -5,7 +5,13 @@
 
 #pragma once
 
-#include "manager.hpp"          // IWYU pragma: export
-#include "measurement.hpp"      // IWYU pragma: export
-#include "sensor.hpp"           // IWYU pragma: export
-#include "timestamp_sensor.hpp" // IWYU pragma: export
+#include "aggregator.hpp"         // IWYU pragma: export
+#include "deadband.hpp"           // IWYU pragma: export
+#include "layout.hpp"             // IWYU pragma: export
+#include "manager.hpp"            // IWYU pragma: export
+#include "measurement.hpp"        // IWYU pragma: export
+#include "notifier.hpp"           // IWYU pragma: export
+#include "packed_measurement.hpp" // IWYU pragma: export
+#include "sensor.hpp"             // IWYU pragma: export
+#include "slot_table.hpp"         // IWYU pragma: export
+#include "spsc_data_handler.hpp"  // IWYU pragma: export
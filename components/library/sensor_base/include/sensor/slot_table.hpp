@@ -0,0 +1,132 @@
+/**
+ * @file slot_table.hpp
+ * @brief Compact, sorted map from sensor ID to storage slot
+ *
+ * Per-sensor state indexed directly by SensorIdType grows with the largest
+ * ID, however few sensors exist. A SlotTable gives each sensor that is
+ * actually present a dense slot (0..size()-1, in the order sensors were
+ * added) and keeps the entries sorted by ID: lookups are a binary search,
+ * and iteration visits only present sensors, in ID order.
+ *
+ * Slots never move once handed out, so storage indexed by slot stays valid
+ * while sensors are added. The table is constexpr, so an application that
+ * knows its sensors builds it at compile time:
+ *
+ *   inline constexpr auto SLOTS =
+ *       sensor::make_slot_table(SensorId::BME680, SensorId::Battery);
+ *   sensor::DataManagerT<SLOTS.capacity()> data{SLOTS};
+ */
+
+#pragma once
+
+#include "sensor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace sensor {
+
+/// Sorted ID -> slot map with fixed capacity
+///
+/// @tparam N Most sensors held
+///
+/// @thread_safety Not thread-safe; the owner locks
+template <size_t N> class SlotTable {
+public:
+  static_assert(N > 0, "A slot table holds at least one sensor");
+  static_assert(N <= 256, "Slots are stored as uint8_t");
+
+  /// find() / add() result when there is no slot
+  static constexpr size_t NONE = N;
+
+  /// One present sensor
+  struct Entry {
+    SensorIdType id;
+    uint8_t slot;
+  };
+
+  constexpr SlotTable() = default;
+
+  /// Table holding ids (duplicates share a slot; those beyond N are dropped)
+  constexpr explicit SlotTable(std::span<const SensorIdType> ids) {
+    for (auto id : ids) {
+      (void)add(id);
+    }
+  }
+
+  [[nodiscard]] static constexpr size_t capacity() { return N; }
+  [[nodiscard]] constexpr size_t size() const { return size_; }
+  [[nodiscard]] constexpr bool full() const { return size_ == N; }
+
+  /// Slot of a sensor, NONE if it has none
+  [[nodiscard]] constexpr size_t find(SensorIdType id) const {
+    const auto *it = lower_bound(id);
+    if (it == end() || it->id != id) {
+      return NONE;
+    }
+    return it->slot;
+  }
+
+  /// Slot of a sensor, given the next free one if it has none
+  /// @return NONE if the table is full
+  constexpr size_t add(SensorIdType id) {
+    auto *it = lower_bound(id);
+    if (it != end() && it->id == id) {
+      return it->slot;
+    }
+    if (full()) {
+      return NONE;
+    }
+    std::copy_backward(it, end(), end() + 1);
+    *it = Entry{.id = id, .slot = static_cast<uint8_t>(size_)};
+    return size_++;
+  }
+
+  /// Present sensors, sorted by ID
+  [[nodiscard]] constexpr std::span<const Entry> entries() const {
+    return std::span<const Entry>(entries_.data(), size_);
+  }
+
+  /// ID of the sensor in a slot (slot < size())
+  [[nodiscard]] constexpr SensorIdType id_of(size_t slot) const {
+    for (const auto &entry : entries()) {
+      if (entry.slot == slot) {
+        return entry.id;
+      }
+    }
+    return 0;
+  }
+
+private:
+  [[nodiscard]] constexpr const Entry *end() const {
+    return entries_.data() + size_;
+  }
+  [[nodiscard]] constexpr Entry *end() { return entries_.data() + size_; }
+
+  [[nodiscard]] constexpr const Entry *lower_bound(SensorIdType id) const {
+    return std::lower_bound(
+        entries_.data(), end(), id,
+        [](const Entry &entry, SensorIdType key) { return entry.id < key; });
+  }
+  [[nodiscard]] constexpr Entry *lower_bound(SensorIdType id) {
+    return std::lower_bound(
+        entries_.data(), end(), id,
+        [](const Entry &entry, SensorIdType key) { return entry.id < key; });
+  }
+
+  std::array<Entry, N> entries_{};
+  size_t size_ = 0;
+};
+
+/// Slot table of exactly the given sensors (e.g. SensorId values)
+template <typename... Ids>
+[[nodiscard]] constexpr SlotTable<sizeof...(Ids)> make_slot_table(Ids... ids) {
+  std::array<SensorIdType, sizeof...(Ids)> list{
+      static_cast<SensorIdType>(ids)...};
+  return SlotTable<sizeof...(Ids)>(list);
+}
+
+} // namespace sensor
@@ -0,0 +1,153 @@
+/**
+ * @file spsc_data_handler.hpp
+ * @brief Lock-free IDataHandler for timer-driven monitors
+ *
+ * Alternative to DataManagerT for consumers that drain data from their own
+ * task. Each sensor gets its own SPSC queue: the sensor's monitor is the
+ * only producer, the draining task the only consumer. on_data never takes
+ * a lock and never waits, so sampling timing is unaffected by slow readers.
+ *
+ * When a queue is full the new sample is dropped and counted, leaving the
+ * slower consumer to catch up without stalling the esp_timer task.
+ */
+
+#pragma once
+
+#include "data_manager.hpp"
+#include "measurement.hpp"
+#include "sensor.hpp"
+
+#include <core/spsc_queue.hpp>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+namespace sensor {
+
+/// Lock-free per-sensor sample queues
+///
+/// @tparam MaxSensors Maximum number of sensor types (use SensorId::Count)
+/// @tparam MaxMeasurementsPerSensor Maximum measurements per sample
+/// @tparam QueueDepth Samples per sensor queue (power of two)
+///
+/// @thread_safety One monitor per sensor ID, one consumer task.
+template <size_t MaxSensors, size_t MaxMeasurementsPerSensor = 16,
+          size_t QueueDepth = 8>
+class SpscDataHandlerT : public IDataHandler {
+public:
+  static constexpr size_t SENSOR_COUNT = MaxSensors;
+  static constexpr size_t MAX_MEASUREMENTS = MaxMeasurementsPerSensor;
+  static constexpr size_t QUEUE_DEPTH = QueueDepth;
+
+  /// One queued sample
+  struct Sample {
+    std::array<Measurement, MAX_MEASUREMENTS> data{};
+    size_t count = 0;
+
+    [[nodiscard]] std::span<const Measurement> measurements() const {
+      return {data.data(), count};
+    }
+  };
+
+  SpscDataHandlerT() = default;
+  ~SpscDataHandlerT() override = default;
+
+  SpscDataHandlerT(const SpscDataHandlerT &) = delete;
+  SpscDataHandlerT &operator=(const SpscDataHandlerT &) = delete;
+  SpscDataHandlerT(SpscDataHandlerT &&) = delete;
+  SpscDataHandlerT &operator=(SpscDataHandlerT &&) = delete;
+
+  /// Task to notify (xTaskNotifyGive) whenever a sample is queued
+  /// @note Set before monitors start
+  void set_consumer(TaskHandle_t task) { consumer_ = task; }
+
+  /// Producer side - called from the monitor's timer callback
+  void on_data(SensorIdType sensor_id,
+               std::span<const Measurement> measurements) override {
+    auto idx = static_cast<size_t>(sensor_id);
+    if (idx >= SENSOR_COUNT) {
+      return;
+    }
+
+    auto &queue = queues_.at(idx);
+    Sample *slot = queue.reserve();
+    if (slot == nullptr) {
+      drops_.at(idx).fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    slot->count = std::min(measurements.size(), MAX_MEASUREMENTS);
+    std::copy_n(measurements.begin(), slot->count, slot->data.begin());
+    queue.commit();
+
+    if (consumer_ != nullptr) {
+      xTaskNotifyGive(consumer_);
+    }
+  }
+
+  // ==========================================================================
+  // Consumer side - call from a single task
+  // ==========================================================================
+
+  /// Visit and remove every queued sample
+  /// Callback: void(SensorIdType, std::span<const Measurement>)
+  /// @return Number of samples consumed
+  template <typename Func> size_t consume(const Func &callback) {
+    size_t consumed = 0;
+    for (size_t idx = 0; idx < SENSOR_COUNT; ++idx) {
+      auto &queue = queues_.at(idx);
+      while (const Sample *sample = queue.front()) {
+        callback(static_cast<SensorIdType>(idx), sample->measurements());
+        queue.pop();
+        ++consumed;
+      }
+    }
+    return consumed;
+  }
+
+  /// Move queued samples into caller-provided buffer
+  /// Only whole samples are copied; the rest stay queued.
+  /// @return Number of measurements written
+  [[nodiscard]] size_t drain_into(std::span<Measurement> out) {
+    size_t written = 0;
+    for (auto &queue : queues_) {
+      while (const Sample *sample = queue.front()) {
+        if (sample->count > out.size() - written) {
+          return written;
+        }
+        std::copy_n(sample->data.begin(), sample->count,
+                    out.begin() + static_cast<std::ptrdiff_t>(written));
+        written += sample->count;
+        queue.pop();
+      }
+    }
+    return written;
+  }
+
+  /// Number of samples waiting for a sensor
+  [[nodiscard]] size_t pending(SensorIdType sensor_id) const {
+    auto idx = static_cast<size_t>(sensor_id);
+    return idx < SENSOR_COUNT ? queues_.at(idx).size() : 0;
+  }
+
+  /// Number of samples dropped because the sensor's queue was full
+  [[nodiscard]] uint32_t drop_count(SensorIdType sensor_id) const {
+    auto idx = static_cast<size_t>(sensor_id);
+    return idx < SENSOR_COUNT
+               ? drops_.at(idx).load(std::memory_order_relaxed)
+               : 0;
+  }
+
+private:
+  std::array<core::SpscQueue<Sample, QUEUE_DEPTH>, SENSOR_COUNT> queues_{};
+  std::array<std::atomic<uint32_t>, SENSOR_COUNT> drops_{};
+  TaskHandle_t consumer_ = nullptr;
+};
+
+} // namespace sensor
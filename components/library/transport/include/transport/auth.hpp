@@ -8,7 +8,7 @@
 
 #pragma once
 
-#include <core/mutex.hpp>
+#include <core/lock_stats.hpp>
 #include <core/result.hpp>
 
 #include <array>
@@ -42,6 +42,11 @@ public:
 
   /// Check if provider has valid credentials
   [[nodiscard]] virtual bool has_credentials() const = 0;
+
+  /// Changes whenever get_auth_header() would return a different value, so
+  /// transports can set the header once per token instead of per request
+  /// @return 0 if the provider doesn't track it (fetch it every time)
+  [[nodiscard]] virtual uint32_t header_version() const { return 0; }
 };
 
 /// Buffer sizes for auth providers
@@ -183,7 +188,7 @@ private:
     return core::Ok();
   }
 
-  mutable core::Mutex mutex_;
+  mutable core::ProfiledLock<core::Mutex> mutex_{"jwt_auth"};
   std::array<char, auth_buffers::TOKEN_SIZE> token_buffer_{};
   std::array<char, auth_buffers::HEADER_SIZE> header_buffer_{};
   size_t token_len_{0};
@@ -217,6 +222,7 @@ public:
     std::copy_n(key.data(), len, key_buffer_.data());
     key_buffer_.at(len) = '\0';
     key_len_ = len;
+    ++version_;
   }
 
   [[nodiscard]] core::Result<AuthHeader> get_auth_header() override {
@@ -250,10 +256,13 @@ public:
 
   [[nodiscard]] bool has_credentials() const override { return key_len_ > 0; }
 
+  [[nodiscard]] uint32_t header_version() const override { return version_; }
+
 private:
   std::array<char, auth_buffers::TOKEN_SIZE> key_buffer_{};
   std::array<char, auth_buffers::HEADER_SIZE> header_buffer_{};
   size_t key_len_{0};
+  uint32_t version_{0};
   const char *header_name_{"X-API-Key"};
   Location location_{Location::Header};
 };
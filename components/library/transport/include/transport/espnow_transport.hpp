@@ -0,0 +1,558 @@
+/**
+ * @file espnow_transport.hpp
+ * @brief ESP-NOW transport for a local probe cluster
+ *
+ * Implements ITransport over ESP-NOW: connectionless 802.11 action frames
+ * between stations on one channel, with no association, DHCP or TLS. A
+ * battery probe (leaf) hands its measurements to a mains-powered probe
+ * (aggregator) nearby, which uploads for the whole cluster:
+ * - send() carries a request body to the configured peer, split into
+ *   frames of FRAGMENT_SIZE bytes. Each frame waits for its MAC-layer ack
+ *   and is retried; send() returns 202 once every frame was acked. Path
+ *   and content type are not transmitted: a cluster carries one kind of
+ *   message (see cloud::MeshRelay)
+ * - Frames from the accepted senders are reassembled; receive() returns
+ *   the next complete message, receive_from() its sender as well
+ *
+ * ESP-NOW needs the WiFi driver started (network::WifiManager::init()) and
+ * every station on one channel. An associated aggregator is on its AP's
+ * channel, so the leaves are configured with that channel. Modem sleep
+ * drops frames: an aggregator keeps WiFi power save off. An ack means the
+ * aggregator's radio got the frame, not that anything was uploaded.
+ *
+ * Not supported: GET requests (nothing answers them), streamed bodies and
+ * Content-Encoding; such requests fail with ESP_ERR_NOT_SUPPORTED. ESP-NOW
+ * callbacks carry no context, so one instance can be connected at a time.
+ */
+
+#pragma once
+
+#include "transport.hpp"
+
+#include <core/clock.hpp>
+#include <core/fault.hpp>
+#include <core/mutex.hpp>
+#include <core/pool.hpp>
+#include <core/semaphore.hpp>
+
+#include <esp_log.h>
+#include <esp_mac.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <utility>
+
+namespace transport {
+
+/// Station MAC address
+using MacAddress = std::array<uint8_t, ESP_NOW_ETH_ALEN>;
+
+/// ESP-NOW transport configuration
+/// @note Spans must outlive the transport
+struct EspNowTransportConfig {
+  MacAddress peer{};  // Receiver of send() (all zero: receive only)
+  uint8_t channel{0}; // 0: stay on the current one (an associated STA's)
+  /// Stations whose frames are received (empty: any); added as peers
+  std::span<const MacAddress> senders{};
+  /// ESP_NOW_KEY_LEN bytes each to encrypt; both empty: plain frames
+  std::span<const uint8_t> pmk{};
+  std::span<const uint8_t> lmk{};
+  std::chrono::milliseconds ack_timeout{100}; // Per frame attempt
+  uint8_t retries{3};                         // Per frame
+  /// Longest gap between the frames of one message
+  std::chrono::milliseconds reassembly_timeout{1000};
+};
+
+/// ESP-NOW transport
+///
+/// @thread_safety Thread-safe. Frames are reassembled on the WiFi task.
+class EspNowTransport final : public ITransport {
+public:
+  /// Bytes of one ESP-NOW frame
+  static constexpr size_t FRAME_SIZE = ESP_NOW_MAX_DATA_LEN;
+  /// Frames of one message at most
+  static constexpr size_t MAX_FRAGMENTS = 4;
+  /// Messages being reassembled or waiting for receive()
+  static constexpr size_t INBOX_SLOTS = 4;
+  /// Senders whose last message is remembered to drop repeats
+  static constexpr size_t SENDER_HISTORY = 16;
+
+  /// Header in front of each frame's part of the message
+  struct FrameHeader {
+    uint8_t magic; // FRAME_MAGIC
+    uint8_t seq;   // Message number of the sender
+    uint8_t index; // Fragment of the message
+    uint8_t count; // Fragments of the message
+  };
+
+  static constexpr uint8_t FRAME_MAGIC = 0xE5;
+  static constexpr size_t FRAGMENT_SIZE = FRAME_SIZE - sizeof(FrameHeader);
+  /// Longest request body
+  static constexpr size_t MAX_MESSAGE_SIZE = FRAGMENT_SIZE * MAX_FRAGMENTS;
+  static_assert(MAX_FRAGMENTS <= 8, "Fragments are tracked in a uint8_t");
+
+  explicit EspNowTransport(const EspNowTransportConfig &config)
+      : config_(config) {}
+
+  ~EspNowTransport() override { (void)disconnect(); }
+
+  // Non-copyable, non-movable (ESP-NOW callbacks find it by address)
+  EspNowTransport(const EspNowTransport &) = delete;
+  EspNowTransport &operator=(const EspNowTransport &) = delete;
+  EspNowTransport(EspNowTransport &&) = delete;
+  EspNowTransport &operator=(EspNowTransport &&) = delete;
+
+  // ITransport implementation
+
+  /// Start ESP-NOW and add the peers (the WiFi driver must be started)
+  [[nodiscard]] core::Status connect() override {
+    core::LockGuard lock(mutex_);
+
+    if (started_) {
+      return core::Ok();
+    }
+    EspNowTransport *none = nullptr;
+    if (!instance_.compare_exchange_strong(none, this)) {
+      return core::Err(ESP_ERR_INVALID_STATE); // Another instance runs
+    }
+
+    auto status = start();
+    if (!status) {
+      stop();
+      return status;
+    }
+    started_ = true;
+
+    ESP_LOGI(TAG, "Started on channel %u", config_.channel);
+    return core::Ok();
+  }
+
+  [[nodiscard]] core::Status disconnect() override {
+    core::LockGuard lock(mutex_);
+
+    if (started_) {
+      stop();
+      started_ = false;
+      ESP_LOGI(TAG, "Stopped");
+    }
+    return core::Ok();
+  }
+
+  /// ESP-NOW has no link: true while started
+  [[nodiscard]] bool is_connected() const noexcept override {
+    return started_.load();
+  }
+
+  [[nodiscard]] core::Result<Response> send(const Request &request) override {
+    core::LockGuard lock(mutex_);
+
+    if (auto status = check_send(request); !status) {
+      return core::Err(status.error());
+    }
+    if (auto status = send_message(request.body); !status) {
+      return core::Err(status.error());
+    }
+    return empty_response(STATUS_ACCEPTED);
+  }
+
+  /// Sends before returning (a few frames take milliseconds), then
+  /// completes
+  [[nodiscard]] core::Status send_async(const Request &request,
+                                        OnComplete on_complete) override {
+    core::LockGuard lock(mutex_);
+
+    if (auto status = check_send(request); !status) {
+      return status;
+    }
+    auto status = send_message(request.body);
+    if (on_complete) {
+      on_complete(status ? core::Result<Response>(
+                               empty_response(STATUS_ACCEPTED))
+                         : core::Err(status.error()));
+    }
+    return core::Ok();
+  }
+
+  /// Next message from any accepted sender
+  [[nodiscard]] core::Result<Response>
+  receive(std::chrono::milliseconds timeout) override {
+    MacAddress from{};
+    return receive_from(timeout, from);
+  }
+
+  /// Next message and its sender
+  [[nodiscard]] core::Result<Response>
+  receive_from(std::chrono::milliseconds timeout, MacAddress &from) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+      if (auto message = take_message(from)) {
+        return std::move(*message);
+      }
+      // A give can be left over from a message taken without waiting
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0 || !inbox_sem_.take_for(remaining)) {
+        return core::Err(ESP_ERR_TIMEOUT);
+      }
+    }
+  }
+
+  /// Add a station to send to or to receive encrypted frames from
+  [[nodiscard]] core::Status add_peer(const MacAddress &mac) {
+    core::LockGuard lock(mutex_);
+    if (!started_) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    return register_peer(mac);
+  }
+
+  /// Messages dropped because every inbox slot was taken
+  [[nodiscard]] uint32_t dropped() const { return dropped_.load(); }
+
+private:
+  static constexpr const char *TAG = "EspNowTransport";
+  static constexpr uint16_t STATUS_ACCEPTED = 202;
+  static constexpr uint16_t STATUS_OK = 200;
+
+  /// A message being reassembled, or complete and waiting for receive()
+  struct Slot {
+    enum class State : uint8_t { Free, Assembling, Ready };
+
+    State state{State::Free};
+    MacAddress mac{};
+    uint8_t seq{0};
+    uint8_t count{0};
+    uint8_t received{0}; // Bit per fragment
+    size_t len{0};
+    int64_t started_ms{0};
+    uint32_t order{0}; // Completion order (receive() is FIFO)
+    std::array<uint8_t, MAX_MESSAGE_SIZE> data{};
+  };
+
+  /// Last message completed per sender
+  struct Seen {
+    MacAddress mac{};
+    uint8_t seq{0};
+    int64_t at_ms{0};
+    bool valid{false};
+  };
+
+  [[nodiscard]] static Response empty_response(uint16_t status) {
+    return *Response::owned({}, status); // No body: takes no block
+  }
+
+  [[nodiscard]] static bool is_unset(const MacAddress &mac) {
+    return std::ranges::all_of(mac, [](uint8_t b) { return b == 0; });
+  }
+
+  [[nodiscard]] bool encrypted() const {
+    return config_.pmk.size() == ESP_NOW_KEY_LEN &&
+           config_.lmk.size() == ESP_NOW_KEY_LEN;
+  }
+
+  [[nodiscard]] core::Status start() {
+    if (config_.channel != 0) {
+      if (auto err =
+              esp_wifi_set_channel(config_.channel, WIFI_SECOND_CHAN_NONE);
+          err != ESP_OK) {
+        ESP_LOGE(TAG, "Channel %u: %s", config_.channel, esp_err_to_name(err));
+        return core::Fail(err);
+      }
+    }
+    if (auto err = esp_now_init(); err != ESP_OK) {
+      ESP_LOGE(TAG, "Init failed: %s", esp_err_to_name(err));
+      return core::Fail(err);
+    }
+    initialized_ = true;
+    (void)esp_now_register_send_cb(&on_sent);
+    (void)esp_now_register_recv_cb(&on_received);
+
+    if (encrypted()) {
+      if (auto err = esp_now_set_pmk(config_.pmk.data()); err != ESP_OK) {
+        return core::Fail(err);
+      }
+    }
+    if (!is_unset(config_.peer)) {
+      if (auto status = register_peer(config_.peer); !status) {
+        return status;
+      }
+    }
+    for (const auto &sender : config_.senders) {
+      if (auto status = register_peer(sender); !status) {
+        return status;
+      }
+    }
+    return core::Ok();
+  }
+
+  void stop() {
+    if (initialized_) {
+      (void)esp_now_unregister_recv_cb();
+      (void)esp_now_unregister_send_cb();
+      (void)esp_now_deinit();
+      initialized_ = false;
+    }
+    instance_ = nullptr;
+  }
+
+  [[nodiscard]] core::Status register_peer(const MacAddress &mac) {
+    if (esp_now_is_peer_exist(mac.data())) {
+      return core::Ok();
+    }
+    esp_now_peer_info_t peer{};
+    std::ranges::copy(mac, std::begin(peer.peer_addr));
+    peer.channel = 0; // The current channel
+    peer.ifidx = WIFI_IF_STA;
+    peer.encrypt = encrypted();
+    if (peer.encrypt) {
+      std::ranges::copy(config_.lmk, std::begin(peer.lmk));
+    }
+    if (auto err = esp_now_add_peer(&peer); err != ESP_OK) {
+      ESP_LOGE(TAG, "Peer " MACSTR ": %s", MAC2STR(mac),
+               esp_err_to_name(err));
+      return core::Fail(err);
+    }
+    return core::Ok();
+  }
+
+  [[nodiscard]] core::Status check_send(const Request &request) const {
+    if (!started_ || is_unset(config_.peer)) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    if (request.method == HttpMethod::Get || request.body_source != nullptr ||
+        request.content_encoding != ContentEncoding::Identity) {
+      return core::Err(ESP_ERR_NOT_SUPPORTED);
+    }
+    if (request.body.size() > MAX_MESSAGE_SIZE) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    return core::Ok();
+  }
+
+  /// Frame the body to the peer (caller holds mutex_)
+  [[nodiscard]] core::Status send_message(std::span<const uint8_t> body) {
+    size_t count = std::max<size_t>(
+        1, (body.size() + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE);
+    uint8_t seq = next_seq_++;
+
+    std::array<uint8_t, FRAME_SIZE> frame{};
+    for (size_t i = 0; i < count; ++i) {
+      auto part = body.subspan(i * FRAGMENT_SIZE,
+                               std::min(FRAGMENT_SIZE,
+                                        body.size() - (i * FRAGMENT_SIZE)));
+      FrameHeader header{.magic = FRAME_MAGIC,
+                         .seq = seq,
+                         .index = static_cast<uint8_t>(i),
+                         .count = static_cast<uint8_t>(count)};
+      std::memcpy(frame.data(), &header, sizeof(header));
+      std::ranges::copy(part, frame.begin() + sizeof(header));
+      if (auto status =
+              send_frame(std::span(frame.data(), sizeof(header) + part.size()));
+          !status) {
+        ESP_LOGW(TAG, "Frame %zu/%zu not acked: %s", i + 1, count,
+                 esp_err_to_name(status.error()));
+        return status;
+      }
+    }
+    return core::Ok();
+  }
+
+  [[nodiscard]] core::Status send_frame(std::span<const uint8_t> frame) {
+    esp_err_t last = ESP_ERR_TIMEOUT;
+    for (uint8_t attempt = 0; attempt <= config_.retries; ++attempt) {
+      (void)sent_sem_.try_take(); // Late callback of an earlier attempt
+      esp_err_t err =
+          esp_now_send(config_.peer.data(), frame.data(), frame.size());
+      if (err == ESP_ERR_ESPNOW_NO_MEM) {
+        // The driver's queue is full: give it a frame time to drain
+        (void)sent_sem_.take_for(config_.ack_timeout);
+        last = err;
+        continue;
+      }
+      if (err != ESP_OK) {
+        return core::Fail(err);
+      }
+      if (sent_sem_.take_for(config_.ack_timeout) && sent_ok_.load()) {
+        return core::Ok();
+      }
+      last = ESP_ERR_TIMEOUT;
+    }
+    return core::Err(last);
+  }
+
+  /// Oldest complete message, freed on read
+  [[nodiscard]] std::optional<Response> take_message(MacAddress &from) {
+    core::LockGuard lock(inbox_mutex_);
+    Slot *oldest = nullptr;
+    for (auto &slot : inbox_) {
+      if (slot.state == Slot::State::Ready &&
+          (oldest == nullptr || slot.order - oldest->order > UINT32_MAX / 2)) {
+        oldest = &slot;
+      }
+    }
+    if (oldest == nullptr) {
+      return std::nullopt;
+    }
+    auto response = Response::owned(
+        std::span(oldest->data.data(), oldest->len), STATUS_OK, body_pool_);
+    if (!response) {
+      ESP_LOGW(TAG, "No block for a message, kept for the next read");
+      return std::nullopt;
+    }
+    from = oldest->mac;
+    oldest->state = Slot::State::Free;
+    return std::move(*response);
+  }
+
+  [[nodiscard]] bool accepts(const MacAddress &mac) const {
+    return config_.senders.empty() ||
+           std::ranges::find(config_.senders, mac) != config_.senders.end();
+  }
+
+  /// The sender's last message again (its ack was lost)? (inbox_mutex_)
+  [[nodiscard]] bool is_repeat(const MacAddress &mac, uint8_t seq,
+                               int64_t now_ms) const {
+    // Message numbers restart each boot: only a recent one is a repeat
+    auto window = config_.reassembly_timeout.count();
+    return std::ranges::any_of(seen_, [&](const Seen &seen) {
+      return seen.valid && seen.mac == mac && seen.seq == seq &&
+             now_ms - seen.at_ms < window;
+    });
+  }
+
+  void remember(const MacAddress &mac, uint8_t seq, int64_t now_ms) {
+    auto entry = std::ranges::find_if(
+        seen_, [&](const Seen &seen) { return seen.valid && seen.mac == mac; });
+    if (entry == seen_.end()) {
+      entry = seen_.begin() + static_cast<ptrdiff_t>(next_seen_);
+      next_seen_ = (next_seen_ + 1) % seen_.size();
+    }
+    *entry = {.mac = mac, .seq = seq, .at_ms = now_ms, .valid = true};
+  }
+
+  /// Slot of (mac, seq): the one in progress, a free one, or a stale one
+  [[nodiscard]] Slot *slot_for(const MacAddress &mac, uint8_t seq,
+                               int64_t now_ms) {
+    Slot *free = nullptr;
+    for (auto &slot : inbox_) {
+      if (slot.state == Slot::State::Assembling) {
+        if (slot.mac == mac && slot.seq == seq) {
+          return &slot;
+        }
+        if (now_ms - slot.started_ms >= config_.reassembly_timeout.count()) {
+          slot.state = Slot::State::Free; // A frame was lost for good
+        }
+      }
+      if (slot.state == Slot::State::Free && free == nullptr) {
+        free = &slot;
+      }
+    }
+    return free;
+  }
+
+  /// File one frame (WiFi task)
+  void on_frame(const MacAddress &mac, std::span<const uint8_t> frame) {
+    FrameHeader header{};
+    if (frame.size() < sizeof(header) || !accepts(mac)) {
+      return;
+    }
+    std::memcpy(&header, frame.data(), sizeof(header));
+    auto part = frame.subspan(sizeof(header));
+    if (header.magic != FRAME_MAGIC || header.count == 0 ||
+        header.count > MAX_FRAGMENTS || header.index >= header.count ||
+        (header.index + 1 < header.count && part.size() != FRAGMENT_SIZE)) {
+      return;
+    }
+
+    core::LockGuard lock(inbox_mutex_);
+    int64_t now = core::clock::monotonic_ms();
+    if (is_repeat(mac, header.seq, now)) {
+      return;
+    }
+    Slot *slot = slot_for(mac, header.seq, now);
+    if (slot == nullptr) {
+      // Count a message once, at its first fragment
+      if (header.index == 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+      return;
+    }
+    if (slot->state == Slot::State::Free) {
+      *slot = {};
+      slot->state = Slot::State::Assembling;
+      slot->mac = mac;
+      slot->seq = header.seq;
+      slot->count = header.count;
+      slot->started_ms = now;
+    }
+    if (header.count != slot->count) {
+      return;
+    }
+
+    size_t offset = size_t{header.index} * FRAGMENT_SIZE;
+    std::ranges::copy(part, slot->data.begin() + offset);
+    slot->received |= static_cast<uint8_t>(1U << header.index);
+    if (header.index + 1 == header.count) {
+      slot->len = offset + part.size();
+    }
+    if (slot->received == static_cast<uint8_t>((1U << header.count) - 1)) {
+      slot->state = Slot::State::Ready;
+      slot->order = next_order_++;
+      remember(mac, header.seq, now);
+      inbox_sem_.give();
+    }
+  }
+
+  static void on_sent(const esp_now_send_info_t * /*info*/,
+                      esp_now_send_status_t status) {
+    if (auto *self = instance_.load()) {
+      self->sent_ok_ = status == ESP_NOW_SEND_SUCCESS;
+      self->sent_sem_.give();
+    }
+  }
+
+  static void on_received(const esp_now_recv_info_t *info,
+                          const uint8_t *data, int len) {
+    auto *self = instance_.load();
+    if (self == nullptr || info == nullptr || data == nullptr || len <= 0) {
+      return;
+    }
+    MacAddress mac{};
+    std::copy_n(info->src_addr, mac.size(), mac.begin());
+    self->on_frame(mac, std::span(data, static_cast<size_t>(len)));
+  }
+
+  static inline std::atomic<EspNowTransport *> instance_{nullptr};
+
+  EspNowTransportConfig config_;
+  core::Mutex mutex_;
+  std::atomic<bool> started_{false};
+  bool initialized_{false}; ///< esp_now_init() succeeded
+
+  // Sending
+  uint8_t next_seq_{0};
+  core::BinarySemaphore sent_sem_;
+  std::atomic<bool> sent_ok_{false};
+
+  // Reassembly
+  core::Mutex inbox_mutex_;
+  core::BinarySemaphore inbox_sem_;
+  std::array<Slot, INBOX_SLOTS> inbox_{};
+  /// Bodies of messages handed out: the relay task reading them doesn't
+  /// compete with other transports for response_body_pool()
+  core::BlockPool<MAX_MESSAGE_SIZE, INBOX_SLOTS> body_pool_;
+  std::array<Seen, SENDER_HISTORY> seen_{};
+  size_t next_seen_{0};
+  uint32_t next_order_{0};
+  std::atomic<uint32_t> dropped_{0};
+};
+
+} // namespace transport
@@ -9,25 +9,30 @@
  * - Authentication via IAuthProvider
  * - Path + query parameter URL building
  * - Content-type handling (JSON/Protobuf)
+ * - Heap-free async queue: requests are copied into a RequestPool
+ *   (ASYNC_SLOTS x ASYNC_SLOT_STORAGE bytes); send_async() applies
+ *   backpressure when all slots are taken, and sends a request that
+ *   doesn't fit a slot synchronously
  */
 
 #pragma once
 
 #include "auth.hpp"
+#include "request_pool.hpp"
 #include "transport.hpp"
 
+#include <core/fault.hpp>
 #include <core/http_client.hpp>
 #include <core/mutex.hpp>
 #include <core/task.hpp>
+#include <power/pm.hpp>
 
 #include <esp_log.h>
 
+#include <array>
 #include <atomic>
-#include <cctype>
 #include <memory>
 #include <optional>
-#include <queue>
-#include <string>
 
 namespace transport {
 
@@ -40,11 +45,13 @@ struct HttpTransportConfig {
   std::string_view ca_cert{};     // PEM format, must outlive transport
   std::string_view client_cert{}; // PEM format, must outlive transport
   std::string_view client_key{};  // PEM format, must outlive transport
+  bool tls_session_resumption{true}; ///< See core::HttpClientConfig
 
   std::string_view commands_path{"/commands"};
 
-  uint32_t async_task_stack{4096};
   UBaseType_t async_task_priority{5};
+  /// How long send_async() waits for a free slot before ESP_ERR_NO_MEM
+  std::chrono::milliseconds async_enqueue_timeout{0};
 };
 
 /// HTTP transport implementation
@@ -56,6 +63,15 @@ struct HttpTransportConfig {
 ///                Async operations run on dedicated task.
 class HttpTransport final : public ITransport {
 public:
+  /// Requests that can be queued for the async task at once
+  static constexpr size_t ASYNC_SLOTS = request_pool_defaults::SLOTS;
+  /// Bytes per slot for path, query strings and body together
+  static constexpr size_t ASYNC_SLOT_STORAGE = request_pool_defaults::STORAGE;
+  /// Query parameters per async request
+  static constexpr size_t ASYNC_MAX_PARAMS = request_pool_defaults::MAX_PARAMS;
+  /// Async task stack bytes (held in the transport, see core::StaticTask)
+  static constexpr uint32_t ASYNC_TASK_STACK = 4096;
+
   /// Create HTTP transport
   /// @param config Transport configuration
   /// @param auth Optional authentication provider
@@ -78,7 +94,10 @@ public:
   [[nodiscard]] core::Status connect() override {
     core::LockGuard lock(mutex_);
 
+    // Reuse the handle kept by disconnect(): the next request resumes the
+    // saved TLS session instead of a full handshake
     if (client_) {
+      connected_ = true;
       return core::Ok();
     }
 
@@ -90,9 +109,11 @@ public:
         .ca_cert = config_.ca_cert,
         .client_cert = config_.client_cert,
         .client_key = config_.client_key,
+        .tls_session_resumption = config_.tls_session_resumption,
     };
 
     client_.emplace(http_config);
+    applied_auth_version_ = 0; // Fresh handle carries no headers
 
     if (!client_->valid()) {
       client_.reset();
@@ -114,7 +135,7 @@ public:
     core::LockGuard lock(mutex_);
 
     if (client_) {
-      client_.reset();
+      (void)client_->close();
       connected_ = false;
       ESP_LOGI(TAG, "Disconnected");
     }
@@ -125,6 +146,33 @@ public:
     return connected_.load();
   }
 
+  /// Close the keep-alive connection unless a request or borrowed response
+  /// holds it, giving its TLS buffers back to the heap. Stays connected:
+  /// the next request opens a new connection (and handshake).
+  /// @return false if the connection is in use
+  bool release_connection() {
+    core::UniqueLock lock(mutex_, std::try_to_lock);
+    if (!lock || !client_ || active_leases_ != 0) {
+      return false;
+    }
+    (void)client_->close();
+    return true;
+  }
+
+  /// Make a request blocked on another task return (e.g. a long poll)
+  /// Takes no lock: the blocked task holds it. Call while connected.
+  void cancel_request() {
+    if (client_) {
+      (void)client_->cancel_request();
+    }
+  }
+
+  /// Connection reuse counters of the underlying HTTP client
+  [[nodiscard]] core::HttpConnectionStats connection_stats() const {
+    core::LockGuard lock(mutex_);
+    return client_ ? client_->stats() : core::HttpConnectionStats{};
+  }
+
   [[nodiscard]] core::Result<Response> send(const Request &request) override {
     core::LockGuard lock(mutex_);
 
@@ -132,71 +180,116 @@ public:
       return core::Err(ESP_ERR_INVALID_STATE);
     }
 
-    // Apply authentication if available
-    if (auth_ == nullptr) {
-      ESP_LOGW(TAG, "No auth provider set");
-    } else if (!auth_->has_credentials()) {
-      ESP_LOGW(TAG, "Auth provider has no credentials");
-    } else {
-      auto auth_result = auth_->get_auth_header();
-      if (auth_result) {
-        ESP_LOGI(TAG, "Setting auth header: %zu bytes",
-                 auth_result->value.size());
-        auto status = client_->set_auth_header(auth_result->value);
-        if (!status) {
-          ESP_LOGW(TAG, "Failed to set auth header: %s",
-                   esp_err_to_name(status.error()));
-        }
-      } else {
-        ESP_LOGW(TAG, "get_auth_header failed: %s",
-                 esp_err_to_name(auth_result.error()));
-      }
+    // Only the leasing task gets here; a new request would overwrite the
+    // body it is still reading
+    if (active_leases_ != 0) {
+      ESP_LOGE(TAG, "Request while a borrowed response is still held");
+      return core::Err(ESP_ERR_INVALID_STATE);
     }
 
-    // Build URL with query parameters
-    std::string path = build_url(request.path, request.query_params);
+    apply_auth();
+
+    // TLS handshake and body encoding are CPU-bound: run them at full clock
+    power::PerformancePhase boost;
 
     // Map content type and method
     auto http_content_type = map_content_type(request.content_type);
     auto http_method = map_method(request.method);
 
+    // Headers persist on the handle; clear a stale encoding explicitly
+    auto encoding_status =
+        request.content_encoding == ContentEncoding::Deflate
+            ? client_->set_header("Content-Encoding", "deflate")
+            : client_->delete_header("Content-Encoding");
+    if (!encoding_status &&
+        request.content_encoding != ContentEncoding::Identity) {
+      return core::Err(encoding_status.error());
+    }
+    if (auto status = client_->set_header(
+            "Accept",
+            core::content_type_str(map_content_type(request.accept)));
+        !status) {
+      ESP_LOGW(TAG, "Failed to set Accept: %s",
+               esp_err_to_name(status.error()));
+    }
+    apply_if_none_match(request.if_none_match);
+    if (request.timeout.count() > 0) {
+      (void)client_->set_timeout(request.timeout);
+    }
+
     // Perform request
-    auto result =
-        client_->perform(http_method, path, request.body, http_content_type);
+    auto result = request.body_source != nullptr
+                      ? client_->perform_stream(
+                            http_method, request.path, *request.body_source,
+                            http_content_type, request.query_params)
+                      : client_->perform(http_method, request.path,
+                                         request.body, http_content_type,
+                                         request.query_params);
+    if (request.timeout.count() > 0) {
+      (void)client_->set_timeout(config_.timeout);
+    }
 
     if (!result) {
       connected_ = false; // Connection might be broken
-      return core::Err(result.error());
+      return core::Fail(result.error());
     }
 
     // Convert to transport Response
-    return Response(result->body_span(),
-                    static_cast<uint16_t>(result->status_code));
+    auto status_code = static_cast<uint16_t>(result->status_code);
+    auto response =
+        request.response_mode == ResponseMode::Borrowed
+            ? core::Result<Response>(
+                  Response::borrowed(result->body_span(), status_code,
+                                     ResponseLease(mutex_, active_leases_)))
+            : Response::owned(result->body_span(), status_code);
+    if (!response) {
+      ESP_LOGW(TAG, "No block for response body");
+      return core::Fail(response.error());
+    }
+    response->set_retry_after(std::chrono::seconds(result->retry_after_s));
+    response->set_poll_interval(
+        std::chrono::seconds(result->poll_interval_s));
+    response->set_etag(result->etag);
+    return response;
   }
 
   [[nodiscard]] core::Status send_async(const Request &request,
                                         OnComplete on_complete) override {
+    // A streamed body is produced on the caller's stack, and a large body
+    // doesn't fit a slot: neither can be queued, so send it now
+    if (!decltype(async_pool_)::fits(request)) {
+      auto result = send(request);
+      if (on_complete) {
+        on_complete(std::move(result));
+      }
+      return core::Ok();
+    }
+
     // Ensure async task is running
     auto status = ensure_async_task();
     if (!status) {
       return status;
     }
 
-    // Queue the request
+    // Backpressure: waits for a free slot up to async_enqueue_timeout
+    auto index = async_pool_.acquire(request, std::move(on_complete),
+                                     config_.async_enqueue_timeout);
+    if (!index) {
+      if (index.error() == ESP_ERR_NO_MEM) {
+        ESP_LOGW(TAG, "Async queue full");
+      }
+      return core::Err(index.error());
+    }
+
     {
       core::LockGuard lock(async_mutex_);
-      async_queue_.push(
-          AsyncRequest{.method = request.method,
-                       .path = std::string(request.path),
-                       .body = std::vector<uint8_t>(request.body.begin(),
-                                                    request.body.end()),
-                       .content_type = request.content_type,
-                       .query_params = copy_query_params(request.query_params),
-                       .callback = std::move(on_complete)});
+      async_ready_.at((async_head_ + async_count_) % ASYNC_SLOTS) =
+          static_cast<uint8_t>(*index);
+      ++async_count_;
     }
 
     // Wake up the async task
-    xTaskNotifyGive(async_task_handle_);
+    xTaskNotifyGive(async_task_->native_handle());
 
     return core::Ok();
   }
@@ -212,17 +305,13 @@ public:
       return core::Err(ESP_ERR_INVALID_STATE);
     }
 
-    // Apply authentication
-    if (auth_ != nullptr && auth_->has_credentials()) {
-      auto auth_result = auth_->get_auth_header();
-      if (auth_result) {
-        [[maybe_unused]] auto _ = client_->set_auth_header(auth_result->value);
-      }
-    }
+    apply_auth();
+
+    // May open a connection (TLS handshake)
+    power::PerformancePhase boost;
 
     // Poll commands endpoint
-    auto result = client_->perform(core::HttpMethod::Get,
-                                   std::string(config_.commands_path));
+    auto result = client_->perform(core::HttpMethod::Get, config_.commands_path);
 
     if (!result) {
       if (result.error() == ESP_ERR_HTTP_FETCH_HEADER) {
@@ -230,7 +319,7 @@ public:
         return core::Err(ESP_ERR_TIMEOUT);
       }
       connected_ = false;
-      return core::Err(result.error());
+      return core::Fail(result.error());
     }
 
     if (result->status_code == 204 || result->length == 0) {
@@ -238,14 +327,15 @@ public:
       return core::Err(ESP_ERR_TIMEOUT);
     }
 
-    return Response(result->body_span(),
-                    static_cast<uint16_t>(result->status_code));
+    return Response::owned(result->body_span(),
+                           static_cast<uint16_t>(result->status_code));
   }
 
   /// Set or replace authentication provider
   void set_auth_provider(IAuthProvider *auth) {
     core::LockGuard lock(mutex_);
     auth_ = auth;
+    applied_auth_version_ = 0;
   }
 
   /// Get current auth provider
@@ -254,70 +344,41 @@ public:
 private:
   static constexpr const char *TAG = "HttpTransport";
 
-  /// Async request structure
-  struct AsyncRequest {
-    HttpMethod method;
-    std::string path;
-    std::vector<uint8_t> body;
-    ContentType content_type;
-    std::vector<std::pair<std::string, std::string>> query_params;
-    OnComplete callback;
-  };
-
-  /// URL encode a string (percent encoding)
-  [[nodiscard]] static std::string url_encode(std::string_view str) {
-    std::string result;
-    result.reserve(str.size());
-
-    for (char c : str) {
-      if (std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ||
-          c == '.' || c == '~') {
-        result += c;
-      } else {
-        // Percent encode
-        result += '%';
-        constexpr char hex[] = "0123456789ABCDEF";
-        result += hex[static_cast<unsigned char>(c) >> 4];
-        result += hex[static_cast<unsigned char>(c) & 0x0F];
-      }
+  /// Set the auth header when the provider's version moved on; it stays on
+  /// the handle otherwise, so most requests skip both copies
+  void apply_auth() {
+    if (auth_ == nullptr || !auth_->has_credentials()) {
+      return;
     }
-    return result;
-  }
-
-  /// Build URL with query parameters
-  [[nodiscard]] static std::string
-  build_url(std::string_view path, std::span<const QueryParam> params) {
-
-    std::string url(path);
-
-    if (params.empty()) {
-      return url;
+    uint32_t version = auth_->header_version();
+    if (version != 0 && version == applied_auth_version_) {
+      return;
     }
-
-    url += '?';
-    bool first = true;
-    for (const auto &param : params) {
-      if (!first) {
-        url += '&';
-      }
-      url += url_encode(param.key);
-      url += '=';
-      url += url_encode(param.value);
-      first = false;
+    auto header = auth_->get_auth_header();
+    if (!header) {
+      ESP_LOGW(TAG, "get_auth_header failed: %s",
+               esp_err_to_name(header.error()));
+      applied_auth_version_ = 0;
+      return;
     }
-
-    return url;
+    if (auto status = client_->set_auth_header(header->value); !status) {
+      ESP_LOGW(TAG, "Failed to set auth header: %s",
+               esp_err_to_name(status.error()));
+      applied_auth_version_ = 0;
+      return;
+    }
+    applied_auth_version_ = version;
   }
 
-  /// Copy query params to owned storage
-  [[nodiscard]] static std::vector<std::pair<std::string, std::string>>
-  copy_query_params(std::span<const QueryParam> params) {
-    std::vector<std::pair<std::string, std::string>> result;
-    result.reserve(params.size());
-    for (const auto &p : params) {
-      result.emplace_back(std::string(p.key), std::string(p.value));
+  /// Headers persist on the handle: set the tag or clear a stale one
+  void apply_if_none_match(std::string_view etag) {
+    if (etag.empty() || etag.size() >= if_none_match_.size()) {
+      (void)client_->delete_header("If-None-Match");
+      return;
     }
-    return result;
+    std::ranges::copy(etag, if_none_match_.begin());
+    if_none_match_.at(etag.size()) = '\0';
+    (void)client_->set_header("If-None-Match", if_none_match_.data());
   }
 
   /// Map transport ContentType to core::ContentType
@@ -327,6 +388,8 @@ private:
       return core::ContentType::Json;
     case ContentType::Protobuf:
       return core::ContentType::Protobuf;
+    case ContentType::ProtobufDelimited:
+      return core::ContentType::ProtobufDelimited;
     case ContentType::OctetStream:
       return core::ContentType::OctetStream;
     }
@@ -352,85 +415,65 @@ private:
 
   /// Ensure async task is running
   core::Status ensure_async_task() {
-    if (async_task_handle_ != nullptr) {
+    if (async_task_) {
       return core::Ok();
     }
-
-    BaseType_t result =
-        xTaskCreate(async_task_entry, "http_async", config_.async_task_stack,
-                    this, config_.async_task_priority, &async_task_handle_);
-
-    if (result != pdPASS) {
-      ESP_LOGE(TAG, "Failed to create async task");
-      return core::Err(ESP_ERR_NO_MEM);
-    }
-
+    async_task_running_ = true;
+    async_task_.emplace([this]() { async_task_loop(); },
+                        core::StaticTaskConfig{
+                            .name = "http_async",
+                            .priority = config_.async_task_priority,
+                        });
     return core::Ok();
   }
 
   /// Stop async task
   void stop_async_task() {
-    if (async_task_handle_ != nullptr) {
+    if (async_task_) {
       async_task_running_ = false;
-      xTaskNotifyGive(async_task_handle_);
-
-      // Wait for task to exit
-      vTaskDelay(pdMS_TO_TICKS(100));
+      xTaskNotifyGive(async_task_->native_handle());
 
-      // Force delete if still running (shouldn't happen)
-      if (eTaskGetState(async_task_handle_) != eDeleted) {
-        vTaskDelete(async_task_handle_);
+      // Let a request in flight finish; deleted mid-request otherwise
+      for (int i = 0; i < 10 && !async_task_->finished(); ++i) {
+        vTaskDelay(pdMS_TO_TICKS(10));
       }
-      async_task_handle_ = nullptr;
+      async_task_.reset();
     }
   }
 
-  /// Async task entry point
-  static void async_task_entry(void *arg) {
-    auto *self = static_cast<HttpTransport *>(arg);
-    self->async_task_loop();
-    vTaskDelete(nullptr);
-  }
-
   /// Async task main loop
   void async_task_loop() {
-    async_task_running_ = true;
-
     while (async_task_running_) {
       // Wait for notification
       ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
 
       // Process queued requests
       while (async_task_running_) {
-        AsyncRequest req;
-
+        size_t index = 0;
         {
           core::LockGuard lock(async_mutex_);
-          if (async_queue_.empty()) {
+          if (async_count_ == 0) {
             break;
           }
-          req = std::move(async_queue_.front());
-          async_queue_.pop();
+          index = async_ready_.at(async_head_);
+          async_head_ = (async_head_ + 1) % ASYNC_SLOTS;
+          --async_count_;
         }
 
-        // Build request and send
-        std::vector<QueryParam> params;
-        params.reserve(req.query_params.size());
-        for (const auto &p : req.query_params) {
-          params.push_back({p.first, p.second});
-        }
+        // The slot is ours until released; read it in place
+        auto &slot = async_pool_[index];
 
-        Request transport_req{.method = req.method,
-                              .path = req.path,
-                              .query_params = params,
-                              .body = req.body,
-                              .content_type = req.content_type};
+        // Borrowed: the callback reads the body from the client buffer
+        Request transport_req = slot.request();
+        transport_req.response_mode = ResponseMode::Borrowed;
 
         auto result = send(transport_req);
 
-        // Invoke callback
-        if (req.callback) {
-          req.callback(std::move(result));
+        OnComplete callback = std::move(slot.callback);
+        async_pool_.release(index);
+
+        if (callback) {
+          callback(std::move(result));
         }
       }
     }
@@ -440,13 +483,22 @@ private:
   HttpTransportConfig config_;
   std::optional<core::DefaultHttpClient> client_;
   std::atomic<bool> connected_{false};
-  core::Mutex mutex_;
+  mutable RequestMutex mutex_{"http"};
+  uint32_t active_leases_{0};  // Borrowed responses alive (under mutex_)
+  uint32_t applied_auth_version_{0}; // Provider header_version() on handle
+  std::array<char, MAX_ETAG_SIZE + 1> if_none_match_{}; // Header value
 
   // Async support
-  TaskHandle_t async_task_handle_{nullptr};
+  std::optional<core::StaticTask<ASYNC_TASK_STACK>> async_task_;
   std::atomic<bool> async_task_running_{false};
-  std::queue<AsyncRequest> async_queue_;
-  core::Mutex async_mutex_;
+  RequestPool<ASYNC_SLOTS, ASYNC_SLOT_STORAGE, ASYNC_MAX_PARAMS> async_pool_;
+  std::array<uint8_t, ASYNC_SLOTS> async_ready_{}; // FIFO of slot indices
+  size_t async_head_{0};
+  size_t async_count_{0};
+  core::ProfiledLock<core::Mutex> async_mutex_{"http_async"}; // The FIFO
+  static_assert(ASYNC_SLOT_STORAGE <= UINT16_MAX, "Ranges are 16-bit");
+  static_assert(core::http_buffers::RESPONSE <= RESPONSE_BODY_SIZE,
+                "An owned body must fit one response block");
 };
 
 } // namespace transport
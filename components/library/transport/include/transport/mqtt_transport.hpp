@@ -0,0 +1,578 @@
+/**
+ * @file mqtt_transport.hpp
+ * @brief MQTT transport implementation (esp-mqtt)
+ *
+ * Implements ITransport over one persistent MQTT connection:
+ * - Requests are publishes to `topic_prefix + request.path`
+ *   (e.g. "probes/<id>/telemetry/proto"); POST/PUT use telemetry_qos
+ *   (QoS 1 by default) and a synchronous send() returns once the broker
+ *   acknowledged the message (PUBACK)
+ * - Commands are pushed: the transport subscribes to
+ *   `topic_prefix + commands_path`, where the backend keeps the pending
+ *   commands as a retained message. The latest document is buffered and
+ *   served to receive() and to `GET commands_path` requests, so
+ *   CommandService::poll() works unchanged and costs no radio time
+ * - Persistent session (clean_session = 0): the broker queues QoS 1
+ *   messages and keeps the subscription while the probe is offline
+ * - The bearer token of the IAuthProvider is sent as the MQTT password,
+ *   read again before every connection attempt (esp-mqtt's background
+ *   reconnects included), so a refreshed token is used
+ *
+ * Not supported: streamed bodies (body_source) and Content-Encoding
+ * (MQTT 3.1.1 has no headers); such requests fail with
+ * ESP_ERR_NOT_SUPPORTED.
+ */
+
+#pragma once
+
+#include "auth.hpp"
+#include "transport.hpp"
+
+#include <core/fault.hpp>
+#include <core/mutex.hpp>
+#include <core/semaphore.hpp>
+
+#include <esp_crt_bundle.h>
+#include <esp_log.h>
+#include <mqtt_client.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace transport {
+
+/// MQTT transport configuration
+/// @note String fields must be NUL-terminated and outlive the transport
+struct MqttTransportConfig {
+  std::string_view broker_uri;   // e.g. "mqtts://broker.example.com:8883"
+  std::string_view client_id;    // Stable: keys the persistent session
+  std::string_view topic_prefix; // e.g. "probes/<device-id>"
+  std::string_view username{};
+  std::string_view commands_path{"/commands"}; // Retained, subscribed
+  std::chrono::milliseconds timeout{30000};    // Connect / PUBACK wait
+  std::chrono::seconds keep_alive{60};
+  bool persistent_session{true}; // clean_session = 0
+  bool skip_cert_verify{false};
+  std::string_view ca_cert{}; // PEM format (default: certificate bundle)
+  uint8_t telemetry_qos{1};
+  int buffer_size{2048};
+};
+
+/// MQTT transport
+///
+/// @thread_safety Thread-safe for send operations (protected by mutex).
+///                Async completions run on the esp-mqtt task.
+class MqttTransport final : public ITransport {
+public:
+  /// Room for topic_prefix + request path
+  static constexpr size_t TOPIC_SIZE = 128;
+  /// Largest retained command document kept for receive()
+  static constexpr size_t COMMAND_BUFFER_SIZE = 1024;
+  static_assert(COMMAND_BUFFER_SIZE <= RESPONSE_BODY_SIZE);
+  /// Publishes awaiting PUBACK for send_async()
+  static constexpr size_t ASYNC_SLOTS = 4;
+
+  explicit MqttTransport(const MqttTransportConfig &config,
+                         IAuthProvider *auth = nullptr)
+      : auth_(auth), config_(config) {
+    (void)build_topic(config_.commands_path, commands_topic_);
+  }
+
+  ~MqttTransport() override {
+    (void)disconnect();
+    if (client_ != nullptr) {
+      esp_mqtt_client_destroy(client_);
+    }
+  }
+
+  // Non-copyable, non-movable (registered as event handler argument)
+  MqttTransport(const MqttTransport &) = delete;
+  MqttTransport &operator=(const MqttTransport &) = delete;
+  MqttTransport(MqttTransport &&) = delete;
+  MqttTransport &operator=(MqttTransport &&) = delete;
+
+  // ITransport implementation
+
+  [[nodiscard]] core::Status connect() override {
+    core::LockGuard lock(mutex_);
+
+    if (connected_) {
+      return core::Ok();
+    }
+
+    if (client_ == nullptr) {
+      auto status = create_client();
+      if (!status) {
+        return status;
+      }
+    } else if (auto status = apply_credentials(); !status) {
+      return status;
+    }
+
+    // Once started, esp-mqtt reconnects by itself: only wait for it
+    if (!started_) {
+      esp_err_t err = esp_mqtt_client_start(client_);
+      if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Start failed: %s", esp_err_to_name(err));
+        return core::Fail(err);
+      }
+      started_ = true;
+    }
+
+    if (!connected_sem_.take_for(config_.timeout) || !connected_) {
+      // esp-mqtt keeps reconnecting in the background
+      ESP_LOGW(TAG, "Broker not reachable yet");
+      return core::Err(ESP_ERR_TIMEOUT);
+    }
+
+    ESP_LOGI(TAG, "Connected to %s", config_.broker_uri.data());
+    return core::Ok();
+  }
+
+  [[nodiscard]] core::Status disconnect() override {
+    core::LockGuard lock(mutex_);
+
+    if (client_ != nullptr && started_) {
+      (void)esp_mqtt_client_stop(client_);
+      started_ = false;
+      connected_ = false;
+      fail_pending(ESP_ERR_INVALID_STATE);
+      ESP_LOGI(TAG, "Disconnected");
+    }
+    return core::Ok();
+  }
+
+  [[nodiscard]] bool is_connected() const noexcept override {
+    return connected_.load();
+  }
+
+  [[nodiscard]] core::Result<Response> send(const Request &request) override {
+    core::LockGuard lock(mutex_);
+
+    if (request.method == HttpMethod::Get) {
+      if (request.path != config_.commands_path) {
+        return core::Err(ESP_ERR_NOT_SUPPORTED);
+      }
+      // Pushed commands: answer from the buffer, no round trip
+      return take_commands().value_or(empty_response(STATUS_NO_CONTENT));
+    }
+
+    std::array<char, TOPIC_SIZE> topic{};
+    auto status = check_publish(request, topic);
+    if (!status) {
+      return core::Err(status.error());
+    }
+
+    int qos = qos_for(request);
+    int msg_id = esp_mqtt_client_publish(
+        client_, topic.data(),
+        reinterpret_cast<const char *>(request.body.data()),
+        static_cast<int>(request.body.size()), qos, 0);
+    if (msg_id < 0) {
+      return core::Err(ESP_FAIL);
+    }
+
+    if (qos == 0) {
+      return empty_response(STATUS_ACCEPTED);
+    }
+
+    // Wait for this message's PUBACK (acks can arrive before we get here)
+    auto deadline = std::chrono::steady_clock::now() + config_.timeout;
+    while (!was_acked(msg_id)) {
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0 || !acked_sem_.take_for(remaining)) {
+        // Still in the outbox; the session redelivers it after reconnect
+        ESP_LOGW(TAG, "No PUBACK for message %d", msg_id);
+        return core::Err(ESP_ERR_TIMEOUT);
+      }
+    }
+    return empty_response(STATUS_OK);
+  }
+
+  [[nodiscard]] core::Status send_async(const Request &request,
+                                        OnComplete on_complete) override {
+    core::LockGuard lock(mutex_);
+
+    if (request.method == HttpMethod::Get) {
+      return core::Err(ESP_ERR_NOT_SUPPORTED);
+    }
+
+    std::array<char, TOPIC_SIZE> topic{};
+    auto status = check_publish(request, topic);
+    if (!status) {
+      return status;
+    }
+
+    core::LockGuard pending_lock(pending_mutex_);
+    auto slot = std::ranges::find_if(
+        pending_, [](const Pending &p) { return !p.callback; });
+    if (slot == pending_.end()) {
+      return core::Err(ESP_ERR_NO_MEM);
+    }
+
+    // Copied into the esp-mqtt outbox; returns without waiting
+    int qos = qos_for(request);
+    int msg_id = esp_mqtt_client_enqueue(
+        client_, topic.data(),
+        reinterpret_cast<const char *>(request.body.data()),
+        static_cast<int>(request.body.size()), qos, 0, true);
+    if (msg_id < 0) {
+      return core::Err(ESP_ERR_NO_MEM);
+    }
+
+    if (qos == 0) {
+      if (on_complete) {
+        on_complete(empty_response(STATUS_ACCEPTED));
+      }
+      return core::Ok();
+    }
+
+    *slot = {.msg_id = msg_id, .callback = std::move(on_complete)};
+    if (!slot->callback) {
+      slot->callback = [](core::Result<Response> /*unused*/) {};
+    }
+    return core::Ok();
+  }
+
+  [[nodiscard]] core::Result<Response>
+  receive(std::chrono::milliseconds timeout) override {
+    // Commands are pushed; wait for the next retained document
+    if (auto commands = take_commands()) {
+      return std::move(*commands);
+    }
+    if (!inbox_sem_.take_for(timeout)) {
+      return core::Err(ESP_ERR_TIMEOUT);
+    }
+    if (auto commands = take_commands()) {
+      return std::move(*commands);
+    }
+    return core::Err(ESP_ERR_TIMEOUT);
+  }
+
+  /// Set or replace authentication provider (used on next connect)
+  void set_auth_provider(IAuthProvider *auth) {
+    core::LockGuard lock(mutex_);
+    auth_ = auth;
+  }
+
+  /// Get current auth provider
+  [[nodiscard]] IAuthProvider *auth_provider() const { return auth_; }
+
+private:
+  static constexpr const char *TAG = "MqttTransport";
+  static constexpr uint16_t STATUS_OK = 200;
+  static constexpr uint16_t STATUS_ACCEPTED = 202;
+  static constexpr uint16_t STATUS_NO_CONTENT = 204;
+  static constexpr std::string_view BEARER_PREFIX = "Bearer ";
+
+  /// send_async() publish waiting for its PUBACK
+  struct Pending {
+    int msg_id{-1};
+    OnComplete callback;
+  };
+
+  [[nodiscard]] static Response empty_response(uint16_t status) {
+    return *Response::owned({}, status); // No body: takes no block
+  }
+
+  [[nodiscard]] core::Status create_client() {
+    core::LockGuard lock(credentials_mutex_);
+    if (auto status = load_password(); !status) {
+      return status;
+    }
+
+    auto mqtt_config = client_config();
+    client_ = esp_mqtt_client_init(&mqtt_config);
+    if (client_ == nullptr) {
+      ESP_LOGE(TAG, "Failed to create MQTT client");
+      return core::Err(ESP_FAIL);
+    }
+
+    esp_err_t err = esp_mqtt_client_register_event(client_, MQTT_EVENT_ANY,
+                                                   &event_handler, this);
+    if (err != ESP_OK) {
+      esp_mqtt_client_destroy(client_);
+      client_ = nullptr;
+      return core::Fail(err);
+    }
+    return core::Ok();
+  }
+
+  /// Bearer token as password, copied so the provider may refresh it
+  /// (credentials_mutex_ held)
+  [[nodiscard]] core::Status load_password() {
+    password_[0] = '\0';
+    applied_auth_version_ = 0;
+    if (auth_ == nullptr || !auth_->has_credentials()) {
+      return core::Ok();
+    }
+    auto header = auth_->get_auth_header();
+    if (!header) {
+      return core::Ok();
+    }
+    auto token = header->value;
+    if (token.starts_with(BEARER_PREFIX)) {
+      token.remove_prefix(BEARER_PREFIX.size());
+    }
+    if (token.size() >= password_.size()) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    std::ranges::copy(token, password_.begin());
+    password_.at(token.size()) = '\0';
+    applied_auth_version_ = auth_->header_version();
+    return core::Ok();
+  }
+
+  /// Hand the provider's current token to the client if it changed
+  /// (before each connection attempt; esp-mqtt copies the password)
+  [[nodiscard]] core::Status apply_credentials() {
+    core::LockGuard lock(credentials_mutex_);
+    if (client_ == nullptr) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    if (auth_ == nullptr) {
+      return core::Ok();
+    }
+    uint32_t version = auth_->header_version();
+    if (version != 0 && version == applied_auth_version_) {
+      return core::Ok(); // Token unchanged since it was applied
+    }
+    if (auto status = load_password(); !status) {
+      return status;
+    }
+    auto mqtt_config = client_config();
+    esp_err_t err = esp_mqtt_set_config(client_, &mqtt_config);
+    return err == ESP_OK ? core::Ok() : core::Fail(err);
+  }
+
+  /// Client configuration with the current password_
+  [[nodiscard]] esp_mqtt_client_config_t client_config() const {
+    esp_mqtt_client_config_t mqtt_config{};
+    mqtt_config.broker.address.uri = config_.broker_uri.data();
+    mqtt_config.credentials.client_id = config_.client_id.data();
+    if (!config_.username.empty()) {
+      mqtt_config.credentials.username = config_.username.data();
+    }
+    if (password_[0] != '\0') {
+      mqtt_config.credentials.authentication.password = password_.data();
+    }
+    mqtt_config.session.keepalive =
+        static_cast<int>(config_.keep_alive.count());
+    mqtt_config.session.disable_clean_session = config_.persistent_session;
+    mqtt_config.network.timeout_ms =
+        static_cast<int>(config_.timeout.count());
+    mqtt_config.buffer.size = config_.buffer_size;
+
+    if (config_.skip_cert_verify) {
+      mqtt_config.broker.verification.skip_cert_common_name_check = true;
+    } else if (!config_.ca_cert.empty()) {
+      mqtt_config.broker.verification.certificate = config_.ca_cert.data();
+    } else {
+      mqtt_config.broker.verification.crt_bundle_attach =
+          esp_crt_bundle_attach;
+    }
+    return mqtt_config;
+  }
+
+  /// Validate a publish and build its topic
+  [[nodiscard]] core::Status
+  check_publish(const Request &request, std::array<char, TOPIC_SIZE> &topic) {
+    if (!connected_ || client_ == nullptr) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    if (request.body_source != nullptr ||
+        request.content_encoding != ContentEncoding::Identity) {
+      return core::Err(ESP_ERR_NOT_SUPPORTED);
+    }
+    if (!build_topic(request.path, topic)) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    return core::Ok();
+  }
+
+  [[nodiscard]] bool build_topic(std::string_view path,
+                                 std::array<char, TOPIC_SIZE> &topic) const {
+    int len = snprintf(topic.data(), topic.size(), "%.*s%.*s",
+                       static_cast<int>(config_.topic_prefix.size()),
+                       config_.topic_prefix.data(),
+                       static_cast<int>(path.size()), path.data());
+    return len > 0 && static_cast<size_t>(len) < topic.size();
+  }
+
+  [[nodiscard]] int qos_for(const Request &request) const {
+    return request.method == HttpMethod::Post ||
+                   request.method == HttpMethod::Put
+               ? config_.telemetry_qos
+               : 1;
+  }
+
+  /// Latest pushed command document, consumed on read
+  /// @return A copy in its own body block, made under the lock: on_data()
+  ///         may overwrite inbox_ as soon as it is released
+  [[nodiscard]] std::optional<Response> take_commands() {
+    core::LockGuard lock(inbox_mutex_);
+    if (!inbox_ready_) {
+      return std::nullopt;
+    }
+    if (inbox_len_ == 0) {
+      inbox_ready_ = false;
+      return std::nullopt; // Retained message cleared by the backend
+    }
+    auto response =
+        Response::owned(std::span(inbox_.data(), inbox_len_), STATUS_OK);
+    if (!response) {
+      ESP_LOGW(TAG, "No block for commands, kept for the next read");
+      return std::nullopt;
+    }
+    inbox_ready_ = false;
+    return std::move(*response);
+  }
+
+  void fail_pending(esp_err_t error) {
+    core::LockGuard lock(pending_mutex_);
+    for (auto &p : pending_) {
+      if (p.callback) {
+        auto callback = std::exchange(p.callback, nullptr);
+        callback(core::Err(error));
+      }
+    }
+  }
+
+  /// PUBACK for msg_id seen lately
+  [[nodiscard]] bool was_acked(int msg_id) const {
+    return std::ranges::any_of(acked_, [msg_id](const std::atomic<int> &id) {
+      return id.load() == msg_id;
+    });
+  }
+
+  void on_published(int msg_id) {
+    // Recorded per message: a PUBACK for an async publish arriving in
+    // between must not hide the one send() waits for
+    acked_.at(acked_next_++ % acked_.size()) = msg_id;
+    acked_sem_.give();
+
+    OnComplete callback;
+    {
+      core::LockGuard lock(pending_mutex_);
+      auto slot = std::ranges::find_if(pending_, [msg_id](const Pending &p) {
+        return p.callback && p.msg_id == msg_id;
+      });
+      if (slot == pending_.end()) {
+        return;
+      }
+      callback = std::exchange(slot->callback, nullptr);
+    }
+    callback(empty_response(STATUS_OK));
+  }
+
+  /// Reassemble a (possibly fragmented) message on the commands topic
+  void on_data(const esp_mqtt_event_t &event) {
+    core::LockGuard lock(inbox_mutex_);
+
+    // Only the first fragment carries the topic
+    if (event.current_data_offset == 0) {
+      inbox_receiving_ =
+          std::string_view(event.topic, event.topic_len) ==
+          std::string_view(commands_topic_.data());
+    }
+    if (!inbox_receiving_) {
+      return;
+    }
+
+    auto total = static_cast<size_t>(event.total_data_len);
+    auto offset = static_cast<size_t>(event.current_data_offset);
+    if (total > inbox_.size()) {
+      if (offset == 0) {
+        ESP_LOGW(TAG, "Command document too large: %zu bytes", total);
+      }
+      return;
+    }
+
+    std::copy_n(event.data, event.data_len, inbox_.begin() + offset);
+    if (offset + static_cast<size_t>(event.data_len) == total) {
+      inbox_len_ = total;
+      inbox_ready_ = true;
+      inbox_sem_.give();
+    }
+  }
+
+  static void event_handler(void *arg, esp_event_base_t /*base*/,
+                            int32_t event_id, void *event_data) {
+    auto *self = static_cast<MqttTransport *>(arg);
+    auto *event = static_cast<esp_mqtt_event_handle_t>(event_data);
+
+    switch (static_cast<esp_mqtt_event_id_t>(event_id)) {
+    case MQTT_EVENT_CONNECTED:
+      // A resumed session still holds the subscription
+      if (event->session_present == 0) {
+        (void)esp_mqtt_client_subscribe_single(
+            event->client, self->commands_topic_.data(), 1);
+      }
+      self->connected_ = true;
+      self->connected_sem_.give();
+      break;
+    case MQTT_EVENT_BEFORE_CONNECT:
+      // Also before esp-mqtt's own reconnects: the token may have changed
+      if (auto status = self->apply_credentials(); !status) {
+        ESP_LOGW(TAG, "Credentials not updated: %s",
+                 esp_err_to_name(status.error()));
+      }
+      break;
+    case MQTT_EVENT_DISCONNECTED:
+      self->connected_ = false;
+      break;
+    case MQTT_EVENT_PUBLISHED:
+      self->on_published(event->msg_id);
+      break;
+    case MQTT_EVENT_DATA:
+      self->on_data(*event);
+      break;
+    case MQTT_EVENT_ERROR:
+      ESP_LOGW(TAG, "MQTT error event");
+      break;
+    default:
+      break;
+    }
+  }
+
+  IAuthProvider *auth_;
+  MqttTransportConfig config_;
+  esp_mqtt_client_handle_t client_{nullptr};
+  core::Mutex mutex_;
+  std::atomic<bool> connected_{false};
+  bool started_{false};
+
+  std::array<char, TOPIC_SIZE> commands_topic_{};
+  core::Mutex credentials_mutex_; ///< password_ (connect vs. mqtt task)
+  std::array<char, auth_buffers::TOKEN_SIZE> password_{};
+  uint32_t applied_auth_version_{0}; ///< Provider header_version() applied
+
+  // PUBACK tracking
+  core::BinarySemaphore connected_sem_;
+  core::BinarySemaphore acked_sem_;
+  /// Latest PUBACKed msg_ids (esp-mqtt ids start at 1: 0 is empty)
+  std::array<std::atomic<int>, 2 * (ASYNC_SLOTS + 1)> acked_{};
+  std::atomic<size_t> acked_next_{0};
+  core::Mutex pending_mutex_;
+  std::array<Pending, ASYNC_SLOTS> pending_{};
+
+  // Pushed commands
+  core::Mutex inbox_mutex_;
+  core::BinarySemaphore inbox_sem_;
+  std::array<uint8_t, COMMAND_BUFFER_SIZE> inbox_{};
+  size_t inbox_len_{0};
+  bool inbox_ready_{false};
+  bool inbox_receiving_{false}; ///< Fragments belong to the commands topic
+};
+
+} // namespace transport
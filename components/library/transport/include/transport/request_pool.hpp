@@ -0,0 +1,172 @@
+/**
+ * @file request_pool.hpp
+ * @brief Fixed pool of request slots for queued / retried requests
+ *
+ * A Request only holds views into the caller's data. Anything that outlives
+ * the call (an async queue, a scheduled retry) copies it into a slot: path,
+ * query strings and body go into the slot's own storage and the slot keeps
+ * a Request viewing that copy. No heap; a full pool applies backpressure.
+ *
+ * Usage:
+ *   RequestPool<4, 768, 4> pool;
+ *   auto index = pool.acquire(request, std::move(on_complete), timeout);
+ *   if (index) { use pool[*index].request(); pool.release(*index); }
+ */
+
+#pragma once
+
+#include "transport.hpp"
+
+#include <core/mutex.hpp>
+#include <core/result.hpp>
+#include <core/semaphore.hpp>
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace transport {
+
+/// Default pool dimensions (shared by HttpTransport and RetryTransport)
+namespace request_pool_defaults {
+inline constexpr size_t SLOTS = 4;      ///< Requests held at once
+inline constexpr size_t STORAGE = 768;  ///< Bytes per slot: path+query+body
+inline constexpr size_t MAX_PARAMS = 4; ///< Query parameters per request
+} // namespace request_pool_defaults
+
+/// Fixed set of slots, each owning a copy of one Request
+/// @tparam Slots Number of slots (at most 32)
+/// @tparam Storage Bytes per slot for path, query strings and body together
+/// @tparam MaxParams Query parameters per request
+template <size_t Slots = request_pool_defaults::SLOTS,
+          size_t Storage = request_pool_defaults::STORAGE,
+          size_t MaxParams = request_pool_defaults::MAX_PARAMS>
+class RequestPool {
+public:
+  static_assert(Slots > 0 && Slots <= 32, "Free mask is 32 bits");
+  static_assert(Storage <= UINT16_MAX, "Ranges are 16-bit");
+
+  /// One stored request; views stay valid until the slot is released
+  class Slot {
+  public:
+    [[nodiscard]] const Request &request() const { return request_; }
+
+    OnComplete callback;
+
+  private:
+    friend class RequestPool;
+
+    /// Copy request data into storage (size checked by the pool)
+    void assign(const Request &request) {
+      size_t used = 0;
+      auto append = [this, &used](const void *data, size_t len) {
+        auto *dest = storage_.data() + used;
+        if (len != 0) {
+          std::memcpy(dest, data, len);
+        }
+        used += len;
+        return dest;
+      };
+      auto append_str = [&append](std::string_view s) {
+        return std::string_view(
+            reinterpret_cast<const char *>(append(s.data(), s.size())),
+            s.size());
+      };
+
+      for (size_t i = 0; i < request.query_params.size(); ++i) {
+        const auto &p = request.query_params[i];
+        params_.at(i) = {.key = append_str(p.key),
+                         .value = append_str(p.value)};
+      }
+
+      request_ = request;
+      request_.path = append_str(request.path);
+      request_.query_params =
+          std::span(params_.data(), request.query_params.size());
+      request_.body = {append(request.body.data(), request.body.size()),
+                       request.body.size()};
+      request_.if_none_match = append_str(request.if_none_match);
+      request_.body_source = nullptr;
+    }
+
+    Request request_{};
+    std::array<QueryParam, MaxParams> params_{};
+    std::array<uint8_t, Storage> storage_{};
+  };
+
+  RequestPool() = default;
+
+  // Slots are referenced by index and hold views into themselves
+  RequestPool(const RequestPool &) = delete;
+  RequestPool &operator=(const RequestPool &) = delete;
+  RequestPool(RequestPool &&) = delete;
+  RequestPool &operator=(RequestPool &&) = delete;
+
+  /// Bytes a request needs in slot storage
+  [[nodiscard]] static size_t stored_size(const Request &request) {
+    size_t size = request.path.size() + request.body.size() +
+                  request.if_none_match.size();
+    for (const auto &p : request.query_params) {
+      size += p.key.size() + p.value.size();
+    }
+    return size;
+  }
+
+  /// True if request can be stored (no streamed body, within limits)
+  [[nodiscard]] static bool fits(const Request &request) {
+    return request.body_source == nullptr &&
+           request.query_params.size() <= MaxParams &&
+           stored_size(request) <= Storage;
+  }
+
+  /// Copy request into a free slot, waiting up to timeout for one
+  /// @return Slot index; ESP_ERR_INVALID_SIZE if it doesn't fit,
+  ///         ESP_ERR_NO_MEM if no slot freed up in time
+  [[nodiscard]] core::Result<size_t> acquire(const Request &request,
+                                             OnComplete on_complete,
+                                             std::chrono::milliseconds timeout) {
+    if (!fits(request)) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+
+    // Backpressure: one token per free slot
+    if (!free_.take_for(timeout)) {
+      return core::Err(ESP_ERR_NO_MEM);
+    }
+
+    size_t index = 0;
+    {
+      core::LockGuard lock(mutex_);
+      index = static_cast<size_t>(std::countr_zero(free_mask_));
+      free_mask_ &= ~(1U << index);
+    }
+
+    auto &slot = slots_.at(index);
+    slot.assign(request);
+    slot.callback = std::move(on_complete);
+    return index;
+  }
+
+  /// Return a slot to the pool (its request views become invalid)
+  void release(size_t index) {
+    slots_.at(index).callback = nullptr;
+    {
+      core::LockGuard lock(mutex_);
+      free_mask_ |= 1U << index;
+    }
+    free_.give();
+  }
+
+  [[nodiscard]] Slot &operator[](size_t index) { return slots_.at(index); }
+
+private:
+  std::array<Slot, Slots> slots_{};
+  uint32_t free_mask_{(Slots == 32) ? UINT32_MAX : (1U << Slots) - 1};
+  core::CountingSemaphore free_{Slots, Slots};
+  core::Mutex mutex_;
+};
+
+} // namespace transport
@@ -4,25 +4,42 @@
  *
  * Provides automatic retry with exponential backoff for transient failures.
  * Wraps any ITransport implementation.
+ *
+ * Retry decisions live in AdaptiveRetry:
+ * - Full jitter: each wait is uniform in [0, backoff], so a fleet that
+ *   failed together does not retry together
+ * - A server's Retry-After (429 / 503) replaces the computed backoff, up
+ *   to max_retry_after; a longer one fails the request at once
+ * - Circuit breaker: after breaker_threshold failed operations in a row,
+ *   requests fail fast with ESP_ERR_NOT_ALLOWED for breaker_cooldown, then
+ *   a single probe request decides whether to close it again
+ *
+ * send() retries the caller's Request in place (held by reference) and
+ * sleeps the caller between attempts. send_async() copies the request once
+ * into a fixed RequestPool slot and reschedules each retry from that slot's
+ * one-shot timer, never blocking; a request over the slot's STORAGE bytes
+ * falls back to send() on the caller's task. Neither path allocates on
+ * success.
  */
 
 #pragma once
 
+#include "request_pool.hpp"
 #include "transport.hpp"
 
+#include <core/clock.hpp>
 #include <core/task.hpp>
 
 #include <esp_log.h>
+#include <esp_random.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/timers.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
-#include <memory>
-#include <string>
 #include <utility>
-#include <vector>
 
 namespace transport {
 
@@ -35,12 +52,169 @@ struct RetryPolicy {
   bool retry_on_timeout{true};                // Retry on timeout errors
   bool retry_on_server_error{true};           // Retry on 5xx responses
   bool retry_on_connection_error{true};       // Retry on connection failures
+  bool retry_on_rate_limit{true};             // Retry on 429 responses
+  bool jitter{true};            // Full jitter: wait uniform in [0, backoff]
+  bool honor_retry_after{true}; // Server Retry-After replaces the backoff
+  /// Longest Retry-After waited out; a longer one fails the request (the
+  /// sender's task would block meanwhile, left to the breaker / outbox)
+  std::chrono::milliseconds max_retry_after{5000};
+  uint8_t breaker_threshold{5}; // Failed operations that open the breaker
+                                // (0 = no breaker)
+  std::chrono::milliseconds breaker_cooldown{60000}; // Open -> half-open
+};
+
+/// Circuit breaker state
+enum class CircuitState : uint8_t {
+  Closed,   // Requests go through
+  Open,     // Requests fail fast until the cooldown ends
+  HalfOpen, // One probe request is in flight
+};
+
+/// Retry policy object: backoff schedule, retryable outcomes and the
+/// circuit breaker shared by every request through one transport
+class AdaptiveRetry {
+public:
+  static constexpr uint16_t STATUS_TOO_MANY_REQUESTS = 429;
+
+  explicit AdaptiveRetry(const RetryPolicy &policy = {}) : policy_(policy) {}
+
+  // Shared breaker state: one instance per transport
+  AdaptiveRetry(const AdaptiveRetry &) = delete;
+  AdaptiveRetry &operator=(const AdaptiveRetry &) = delete;
+  AdaptiveRetry(AdaptiveRetry &&) = delete;
+  AdaptiveRetry &operator=(AdaptiveRetry &&) = delete;
+
+  [[nodiscard]] const RetryPolicy &policy() const { return policy_; }
+  void set_policy(const RetryPolicy &policy) { policy_ = policy; }
+
+  [[nodiscard]] CircuitState state() const { return state_.load(); }
+
+  /// False while the breaker is open: skip the attempt entirely
+  [[nodiscard]] bool allow() {
+    auto state = state_.load();
+    if (state == CircuitState::Closed) {
+      return true;
+    }
+    if (state == CircuitState::HalfOpen ||
+        core::clock::monotonic_ms() - opened_at_ms_.load() <
+            policy_.breaker_cooldown.count()) {
+      return false;
+    }
+    // Cooldown over: exactly one caller gets to probe
+    return state_.compare_exchange_strong(state, CircuitState::HalfOpen);
+  }
+
+  /// The operation allow() let through never started (no slot, base
+  /// refused it): a probe hands the half-open state back, so the next
+  /// caller probes instead
+  void abandon() {
+    auto state = CircuitState::HalfOpen;
+    // opened_at_ms_ is unchanged: the cooldown stays over
+    (void)state_.compare_exchange_strong(state, CircuitState::Open);
+  }
+
+  /// Record the final outcome of an operation (after its retries)
+  void record(bool failed) {
+    if (!failed) {
+      failures_ = 0;
+      state_ = CircuitState::Closed;
+      return;
+    }
+    if (policy_.breaker_threshold == 0) {
+      return;
+    }
+    if (state_.load() == CircuitState::HalfOpen ||
+        failures_.fetch_add(1) + 1 >= policy_.breaker_threshold) {
+      opened_at_ms_ = core::clock::monotonic_ms();
+      state_ = CircuitState::Open;
+      ESP_LOGW(TAG, "Circuit open for %lldms",
+               static_cast<long long>(policy_.breaker_cooldown.count()));
+    }
+  }
+
+  /// Error worth another attempt
+  [[nodiscard]] bool is_retryable_error(esp_err_t err) const {
+    switch (err) {
+    case ESP_ERR_TIMEOUT:
+      return policy_.retry_on_timeout;
+
+    case ESP_ERR_INVALID_STATE:
+    case ESP_FAIL:
+    case ESP_ERR_NO_MEM:
+      return policy_.retry_on_connection_error;
+
+    default:
+      // ESP HTTP client errors that indicate connection issues
+      if (err >= 0x7000 && err <= 0x70FF) { // ESP_HTTP_CLIENT_ERR_BASE range
+        return policy_.retry_on_connection_error;
+      }
+      return false;
+    }
+  }
+
+  /// Response worth another attempt (5xx, 429)
+  [[nodiscard]] bool is_retryable_response(const Response &response) const {
+    if (response.is_server_error()) {
+      return policy_.retry_on_server_error;
+    }
+    return response.status_code() == STATUS_TOO_MANY_REQUESTS &&
+           policy_.retry_on_rate_limit;
+  }
+
+  /// Outcome counts against the breaker (transport or server trouble)
+  [[nodiscard]] bool is_failure(const core::Result<Response> &result) const {
+    return result ? is_retryable_response(*result)
+                  : is_retryable_error(result.error());
+  }
+
+  [[nodiscard]] bool should_retry(const core::Result<Response> &result,
+                                  uint8_t attempts) const {
+    if (attempts >= policy_.max_retries || !is_failure(result)) {
+      return false;
+    }
+    return !policy_.honor_retry_after || !result ||
+           result->retry_after() <= policy_.max_retry_after;
+  }
+
+  /// Wait before retry number attempt (0-based) after result
+  [[nodiscard]] std::chrono::milliseconds
+  delay(uint8_t attempts, const core::Result<Response> &result) const {
+    if (policy_.honor_retry_after && result &&
+        result->retry_after().count() > 0) {
+      return std::min<std::chrono::milliseconds>(result->retry_after(),
+                                                 policy_.max_retry_after);
+    }
+    return backoff(attempts);
+  }
+
+  /// Exponential backoff ceiling for attempt, jittered if enabled
+  [[nodiscard]] std::chrono::milliseconds backoff(uint8_t attempts) const {
+    auto ceiling = static_cast<double>(policy_.initial_delay.count());
+    for (uint8_t i = 0; i < attempts; ++i) {
+      ceiling *= policy_.backoff_multiplier;
+    }
+    auto capped = std::min(static_cast<int64_t>(ceiling),
+                           static_cast<int64_t>(policy_.max_delay.count()));
+    if (!policy_.jitter || capped <= 0) {
+      return std::chrono::milliseconds(capped);
+    }
+    return std::chrono::milliseconds(esp_random() %
+                                     (static_cast<uint64_t>(capped) + 1));
+  }
+
+private:
+  static constexpr const char *TAG = "RetryPolicy";
+
+  RetryPolicy policy_;
+  std::atomic<CircuitState> state_{CircuitState::Closed};
+  std::atomic<uint8_t> failures_{0};
+  std::atomic<int64_t> opened_at_ms_{0};
 };
 
 /// Retry transport decorator
 ///
 /// Wraps another transport and automatically retries failed requests
-/// using exponential backoff. Configurable via RetryPolicy.
+/// as decided by an AdaptiveRetry built from the RetryPolicy.
 ///
 /// @tparam BaseTransport The underlying transport type
 template <typename BaseTransport>
@@ -50,15 +224,21 @@ public:
   /// @param base The underlying transport (takes ownership)
   /// @param policy Retry policy configuration
   explicit RetryTransport(BaseTransport base, const RetryPolicy &policy = {})
-      : base_(std::move(base)), policy_(policy) {}
+      : base_(std::move(base)), retry_(policy) {}
 
-  // Non-copyable
+  ~RetryTransport() override {
+    for (auto &attempt : attempts_) {
+      if (attempt.timer != nullptr) {
+        xTimerDelete(attempt.timer, portMAX_DELAY);
+      }
+    }
+  }
+
+  // Non-copyable, non-movable (pool slots and timers refer to this)
   RetryTransport(const RetryTransport &) = delete;
   RetryTransport &operator=(const RetryTransport &) = delete;
-
-  // Movable
-  RetryTransport(RetryTransport &&) = default;
-  RetryTransport &operator=(RetryTransport &&) = default;
+  RetryTransport(RetryTransport &&) = delete;
+  RetryTransport &operator=(RetryTransport &&) = delete;
 
   // ITransport implementation
 
@@ -76,43 +256,55 @@ public:
   }
 
   [[nodiscard]] core::Result<Response> send(const Request &request) override {
-    uint8_t attempts = 0;
-    auto delay = policy_.initial_delay;
+    if (!retry_.allow()) {
+      return core::Err(ESP_ERR_NOT_ALLOWED);
+    }
 
+    uint8_t attempts = 0;
     while (true) {
       auto result = base_.send(request);
 
-      if (result) {
-        // Check for server error responses
-        if (result->is_server_error() && policy_.retry_on_server_error) {
-          if (should_retry(attempts)) {
-            wait_and_backoff(attempts, delay);
-            continue;
-          }
-        }
-        return result;
-      }
-
-      // Check if error is retryable
-      if (!is_retryable_error(result.error())) {
+      if (!retry_.should_retry(result, attempts)) {
+        retry_.record(retry_.is_failure(result));
         return result;
       }
 
-      if (!should_retry(attempts)) {
-        return result;
-      }
-
-      wait_and_backoff(attempts, delay);
+      wait(attempts, retry_.delay(attempts, result));
+      ++attempts;
     }
   }
 
+  /// Retries from a pool slot; a request too large for one is sent (and
+  /// retried) synchronously on the caller's task
   [[nodiscard]] core::Status send_async(const Request &request,
                                         OnComplete on_complete) override {
-    // Create shared retry state with owned copies of request data
-    auto state = std::make_shared<AsyncRetryState>(
-        OwnedRequest::from(request), std::move(on_complete), policy_, this);
+    if (!RequestPool<>::fits(request)) {
+      auto result = send(request);
+      if (on_complete) {
+        on_complete(std::move(result));
+      }
+      return core::Ok();
+    }
+
+    if (!retry_.allow()) {
+      return core::Err(ESP_ERR_NOT_ALLOWED);
+    }
+
+    // One copy, held until the last attempt completes
+    auto index = pool_.acquire(request, std::move(on_complete),
+                               std::chrono::milliseconds{0});
+    if (!index) {
+      retry_.abandon();
+      return core::Err(index.error());
+    }
 
-    return start_async_attempt(std::move(state));
+    attempts_.at(*index).attempts = 0;
+    auto status = start_async_attempt(*index);
+    if (!status) {
+      retry_.abandon();
+      pool_.release(*index);
+    }
+    return status;
   }
 
   [[nodiscard]] core::Result<Response>
@@ -126,228 +318,130 @@ public:
   [[nodiscard]] const BaseTransport &base() const { return base_; }
 
   /// Get current retry policy
-  [[nodiscard]] const RetryPolicy &policy() const { return policy_; }
+  [[nodiscard]] const RetryPolicy &policy() const { return retry_.policy(); }
 
   /// Update retry policy
-  void set_policy(const RetryPolicy &policy) { policy_ = policy; }
+  void set_policy(const RetryPolicy &policy) { retry_.set_policy(policy); }
+
+  /// Circuit breaker state
+  [[nodiscard]] CircuitState circuit_state() const { return retry_.state(); }
 
 private:
   static constexpr const char *TAG = "RetryTransport";
 
-  /// Check if error is retryable
-  [[nodiscard]] bool is_retryable_error(esp_err_t err) const {
-    switch (err) {
-    case ESP_ERR_TIMEOUT:
-      return policy_.retry_on_timeout;
-
-    case ESP_ERR_INVALID_STATE:
-    case ESP_FAIL:
-    case ESP_ERR_NO_MEM:
-      return policy_.retry_on_connection_error;
-
-    default:
-      // ESP HTTP client errors that indicate connection issues
-      if (err >= 0x7000 && err <= 0x70FF) { // ESP_HTTP_CLIENT_ERR_BASE range
-        return policy_.retry_on_connection_error;
-      }
-      return false;
-    }
-  }
-
-  /// Check if we should retry (haven't exceeded max attempts)
-  [[nodiscard]] bool should_retry(uint8_t attempts) const {
-    return attempts < policy_.max_retries;
-  }
-
-  /// Wait for backoff delay and update for next attempt
-  void wait_and_backoff(uint8_t &attempts, std::chrono::milliseconds &delay) {
-    ESP_LOGW(TAG, "Retry %d/%d after %lldms", attempts + 1, policy_.max_retries,
-             delay.count());
-
+  /// Sleep the calling task before the next attempt
+  void wait(uint8_t attempts, std::chrono::milliseconds delay) {
+    ESP_LOGW(TAG, "Retry %d/%d after %lldms", attempts + 1,
+             retry_.policy().max_retries,
+             static_cast<long long>(delay.count()));
     core::Task::delay(delay);
-
-    ++attempts;
-    delay = std::chrono::milliseconds(std::min(
-        static_cast<int64_t>(delay.count() * policy_.backoff_multiplier),
-        policy_.max_delay.count()));
   }
 
   /// Execute a status-returning operation with retry
   template <typename Fn> core::Status execute_with_retry(Fn &&fn) {
-    uint8_t attempts = 0;
-    auto delay = policy_.initial_delay;
-
-    while (true) {
+    for (uint8_t attempts = 0;; ++attempts) {
       auto status = fn();
 
-      if (status) {
-        return status;
-      }
-
-      if (!is_retryable_error(status.error()) || !should_retry(attempts)) {
+      if (status || !retry_.is_retryable_error(status.error()) ||
+          attempts >= retry_.policy().max_retries) {
         return status;
       }
 
-      wait_and_backoff(attempts, delay);
+      wait(attempts, retry_.backoff(attempts));
     }
   }
 
-  /// Owned request data for async operations (survives caller scope)
-  struct OwnedRequest {
-    HttpMethod method;
-    std::string path;
-    std::vector<std::pair<std::string, std::string>> query_params;
-    std::vector<uint8_t> body;
-    ContentType content_type;
-
-    /// Create owned copy from non-owning Request
-    static OwnedRequest from(const Request &req) {
-      OwnedRequest owned;
-      owned.method = req.method;
-      owned.path = std::string(req.path);
-      owned.body = std::vector<uint8_t>(req.body.begin(), req.body.end());
-      owned.content_type = req.content_type;
-
-      owned.query_params.reserve(req.query_params.size());
-      for (const auto &p : req.query_params) {
-        owned.query_params.emplace_back(std::string(p.key),
-                                        std::string(p.value));
-      }
-      return owned;
-    }
+  /// Retry bookkeeping of one pool slot
+  struct AsyncAttempt {
+    RetryTransport *self{nullptr};
+    uint8_t index{0};
+    uint8_t attempts{0};
+    TimerHandle_t timer{nullptr}; ///< Created on the slot's first retry
   };
 
-  /// State for async retry operations
-  struct AsyncRetryState {
-    OwnedRequest request;
-    std::vector<QueryParam>
-        query_param_views; // Views into request.query_params
-    OnComplete callback;
-    RetryPolicy policy;
-    RetryTransport *transport;
-    uint8_t attempts{0};
-    std::chrono::milliseconds delay;
-
-    AsyncRetryState(OwnedRequest req, OnComplete cb, const RetryPolicy &p,
-                    RetryTransport *t)
-        : request(std::move(req)), callback(std::move(cb)), policy(p),
-          transport(t), delay(p.initial_delay) {
-      // Build views pointing to owned data
-      rebuild_views();
-    }
+  /// Hand the slot's request to the base transport
+  core::Status start_async_attempt(size_t index) {
+    // Two words: fits std::function's inline storage
+    return base_.send_async(pool_[index].request(),
+                            [this, index](core::Result<Response> result) {
+                              handle_async_result(index, std::move(result));
+                            });
+  }
 
-    /// Rebuild query param views after move
-    void rebuild_views() {
-      query_param_views.clear();
-      query_param_views.reserve(request.query_params.size());
-      for (const auto &p : request.query_params) {
-        query_param_views.push_back({p.first, p.second});
+  /// Handle async result and potentially retry
+  void handle_async_result(size_t index, core::Result<Response> result) {
+    auto &attempt = attempts_.at(index);
+    if (retry_.should_retry(result, attempt.attempts)) {
+      auto delay = retry_.delay(attempt.attempts, result);
+      if (schedule_retry(attempt, delay)) {
+        return;
       }
+      result = core::Err(ESP_ERR_NO_MEM);
     }
 
-    /// Get Request with views into owned data
-    [[nodiscard]] Request as_request() const {
-      return Request{.method = request.method,
-                     .path = request.path,
-                     .query_params = query_param_views,
-                     .body = request.body,
-                     .content_type = request.content_type};
-    }
-  };
-
-  /// Start an async attempt
-  core::Status start_async_attempt(std::shared_ptr<AsyncRetryState> state) {
-    auto retry_callback = [state](core::Result<Response> result) mutable {
-      state->transport->handle_async_result(std::move(state),
-                                            std::move(result));
-    };
-
-    return base_.send_async(state->as_request(), std::move(retry_callback));
+    retry_.record(retry_.is_failure(result));
+    finish(index, std::move(result));
   }
 
-  /// Handle async result and potentially retry
-  void handle_async_result(std::shared_ptr<AsyncRetryState> state,
-                           core::Result<Response> result) {
-    // Check if successful (but with server error that should retry)
-    if (result) {
-      if (result->is_server_error() && policy_.retry_on_server_error) {
-        if (state->attempts < state->policy.max_retries) {
-          schedule_retry(std::move(state));
-          return;
-        }
-      }
-      // Success or non-retryable response
-      if (state->callback) {
-        state->callback(std::move(result));
-      }
-      return;
+  /// Invoke the caller's callback and free the slot
+  void finish(size_t index, core::Result<Response> result) {
+    OnComplete callback = std::move(pool_[index].callback);
+    pool_.release(index);
+    if (callback) {
+      callback(std::move(result));
     }
+  }
 
-    // Check if error is retryable
-    if (!is_retryable_error(result.error()) ||
-        state->attempts >= state->policy.max_retries) {
-      if (state->callback) {
-        state->callback(std::move(result));
+  /// Restart the slot's one-shot timer for delay (never blocks)
+  [[nodiscard]] bool schedule_retry(AsyncAttempt &attempt,
+                                    std::chrono::milliseconds delay) {
+    ESP_LOGW(TAG, "Async retry %d/%d after %lldms", attempt.attempts + 1,
+             retry_.policy().max_retries,
+             static_cast<long long>(delay.count()));
+
+    // A zero-tick period is invalid for FreeRTOS timers
+    TickType_t ticks = std::max<TickType_t>(pdMS_TO_TICKS(delay.count()), 1);
+
+    if (attempt.timer == nullptr) {
+      attempt.self = this;
+      attempt.timer =
+          xTimerCreate("retry", ticks, pdFALSE, &attempt, &on_retry_timer);
+      if (attempt.timer == nullptr) {
+        return false;
       }
-      return;
+      return xTimerStart(attempt.timer, 0) == pdPASS;
     }
-
-    // Schedule retry
-    schedule_retry(std::move(state));
+    // From the timer task itself the command queue must not block
+    return xTimerChangePeriod(attempt.timer, ticks, 0) == pdPASS;
   }
 
-  /// Schedule a retry after backoff delay
-  void schedule_retry(std::shared_ptr<AsyncRetryState> state) {
-    ESP_LOGW(TAG, "Async retry %d/%d after %lldms", state->attempts + 1,
-             state->policy.max_retries, state->delay.count());
-
-    // Create a one-shot timer for the retry
-    auto timer_callback = [](TimerHandle_t timer) {
-      auto *state_ptr = static_cast<std::shared_ptr<AsyncRetryState> *>(
-          pvTimerGetTimerID(timer));
-      auto state = std::move(*state_ptr);
-      delete state_ptr;
-      xTimerDelete(timer, 0);
-
-      // Update retry state
-      state->attempts++;
-      state->delay = std::chrono::milliseconds(
-          std::min(static_cast<int64_t>(state->delay.count() *
-                                        state->policy.backoff_multiplier),
-                   state->policy.max_delay.count()));
-
-      // Start next attempt
-      state->transport->start_async_attempt(std::move(state));
-    };
-
-    // Store state in heap for timer callback
-    auto *state_ptr = new std::shared_ptr<AsyncRetryState>(std::move(state));
-
-    TimerHandle_t timer =
-        xTimerCreate("retry", pdMS_TO_TICKS((*state_ptr)->delay.count()),
-                     pdFALSE, state_ptr, timer_callback);
-
-    if (timer == nullptr) {
-      // Timer creation failed - invoke callback with error
-      if ((*state_ptr)->callback) {
-        (*state_ptr)->callback(core::Err(ESP_ERR_NO_MEM));
-      }
-      delete state_ptr;
-      return;
+  static void on_retry_timer(TimerHandle_t timer) {
+    auto *attempt = static_cast<AsyncAttempt *>(pvTimerGetTimerID(timer));
+    auto *self = attempt->self;
+
+    ++attempt->attempts;
+    auto status = self->start_async_attempt(attempt->index);
+    if (!status) {
+      self->retry_.record(true);
+      self->finish(attempt->index, core::Err(status.error()));
     }
+  }
 
-    if (xTimerStart(timer, 0) != pdPASS) {
-      // Timer start failed
-      if ((*state_ptr)->callback) {
-        (*state_ptr)->callback(core::Err(ESP_FAIL));
-      }
-      xTimerDelete(timer, 0);
-      delete state_ptr;
+  /// AsyncAttempt entries know their own index
+  [[nodiscard]] static std::array<AsyncAttempt, request_pool_defaults::SLOTS>
+  make_attempts() {
+    std::array<AsyncAttempt, request_pool_defaults::SLOTS> attempts{};
+    for (size_t i = 0; i < attempts.size(); ++i) {
+      attempts.at(i).index = static_cast<uint8_t>(i);
     }
+    return attempts;
   }
 
   BaseTransport base_;
-  RetryPolicy policy_;
+  AdaptiveRetry retry_;
+  RequestPool<> pool_;
+  std::array<AsyncAttempt, request_pool_defaults::SLOTS> attempts_ =
+      make_attempts();
 };
 
 /// Factory function for creating retry transport
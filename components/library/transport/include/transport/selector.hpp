@@ -0,0 +1,341 @@
+/**
+ * @file selector.hpp
+ * @brief Runtime transport selection with per-class routing and failover
+ *
+ * TransportSelector is an ITransport over up to MAX_TRANSPORTS registered
+ * transports (non-owning). Each MessageClass has an ordered preference
+ * list, e.g. telemetry over MQTT with HTTP as fallback, bulk and auth over
+ * HTTP only. The same firmware then uses the cheapest transport that works
+ * at a site.
+ *
+ * Health: every send reports its outcome and latency back to the selector.
+ * After failover_threshold consecutive transport errors a transport is
+ * marked down for down_time and skipped; once that expires it is tried
+ * again. HTTP status codes are not transport errors - a 5xx reached the
+ * server. ESP_ERR_NOT_SUPPORTED / ESP_ERR_INVALID_SIZE (request shape the
+ * transport can't carry) move on to the next transport without counting.
+ *
+ * Failover:
+ * - send(): tries the next transport in the class's list on error, except
+ *   for streamed bodies (body_source), which are produced only once
+ * - send_async(): picks the first healthy transport; the outcome updates
+ *   health but the request is not resubmitted elsewhere
+ *
+ * Usage:
+ *   TransportSelector selector;
+ *   auto mqtt_index = selector.add(mqtt, "mqtt");
+ *   auto http_index = selector.add(http, "http");
+ *   selector.route(MessageClass::Telemetry, {*mqtt_index, *http_index});
+ *   selector.route(MessageClass::Bulk, {*http_index});
+ */
+
+#pragma once
+
+#include "transport.hpp"
+
+#include <core/clock.hpp>
+#include <core/mutex.hpp>
+#include <core/result.hpp>
+
+#include <esp_log.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+namespace transport {
+
+/// Failover thresholds for TransportSelector
+struct SelectorPolicy {
+  uint8_t failover_threshold{2}; // Consecutive errors that mark a transport down
+  std::chrono::milliseconds down_time{60000}; // Skip a down transport this long
+};
+
+/// Health metrics a transport accumulates through the selector
+struct TransportHealth {
+  uint32_t successes{0};           // Requests that got a response
+  uint32_t failures{0};            // Requests that failed in the transport
+  uint8_t consecutive_failures{0}; // Failures since the last success
+  uint32_t last_latency_ms{0};     // Duration of the last successful request
+  uint32_t avg_latency_ms{0};      // Moving average (1/8 weight per sample)
+  int64_t down_until_ms{0};        // Monotonic time until which it is skipped
+
+  [[nodiscard]] bool is_down(int64_t now_ms) const {
+    return now_ms < down_until_ms;
+  }
+};
+
+/// ITransport routing each request to the best registered transport
+///
+/// @thread_safety Thread-safe; routing tables are meant to be set up before
+///                the first request.
+class TransportSelector final : public ITransport {
+public:
+  static constexpr size_t MAX_TRANSPORTS = 3;
+
+  explicit TransportSelector(const SelectorPolicy &policy = {})
+      : policy_(policy) {}
+
+  // Async callbacks capture this
+  TransportSelector(const TransportSelector &) = delete;
+  TransportSelector &operator=(const TransportSelector &) = delete;
+  TransportSelector(TransportSelector &&) = delete;
+  TransportSelector &operator=(TransportSelector &&) = delete;
+
+  /// Register a transport (must outlive the selector)
+  /// @return Index for route(); classes without a route use registration
+  ///         order, so the first transport added is everyone's default
+  [[nodiscard]] core::Result<size_t> add(ITransport &transport,
+                                         const char *name) {
+    if (count_ == MAX_TRANSPORTS) {
+      return core::Err(ESP_ERR_NO_MEM);
+    }
+    entries_.at(count_) = {.transport = &transport, .name = name};
+    return count_++;
+  }
+
+  /// Set the preference order for a message class
+  [[nodiscard]] core::Status route(MessageClass message_class,
+                                   std::initializer_list<size_t> order) {
+    if (order.size() == 0 || order.size() > MAX_TRANSPORTS) {
+      return core::Err(ESP_ERR_INVALID_ARG);
+    }
+    Route route{};
+    for (size_t index : order) {
+      if (index >= count_) {
+        return core::Err(ESP_ERR_INVALID_ARG);
+      }
+      route.order.at(route.size++) = static_cast<uint8_t>(index);
+    }
+    routes_.at(static_cast<size_t>(message_class)) = route;
+    return core::Ok();
+  }
+
+  [[nodiscard]] size_t size() const { return count_; }
+
+  [[nodiscard]] const char *name(size_t index) const {
+    return entries_.at(index).name;
+  }
+
+  /// Snapshot of a transport's health
+  [[nodiscard]] TransportHealth health(size_t index) const {
+    core::LockGuard lock(mutex_);
+    return entries_.at(index).health;
+  }
+
+  /// Transport the next request of this class would try first
+  /// @return Index, or ESP_ERR_INVALID_STATE if none is registered
+  [[nodiscard]] core::Result<size_t>
+  active(MessageClass message_class) const {
+    auto index = pick(message_class);
+    if (index == NONE) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    return index;
+  }
+
+  // ITransport
+
+  /// Connect every transport; succeeds if at least one connects
+  [[nodiscard]] core::Status connect() override {
+    core::Status last = core::Err(ESP_ERR_INVALID_STATE);
+    bool any = false;
+    for (size_t i = 0; i < count_; ++i) {
+      auto status = entries_.at(i).transport->connect();
+      if (status) {
+        any = true;
+      } else {
+        ESP_LOGW(TAG, "%s: connect failed: %s", entries_.at(i).name,
+                 esp_err_to_name(status.error()));
+        last = status;
+      }
+    }
+    return any ? core::Ok() : last;
+  }
+
+  [[nodiscard]] core::Status disconnect() override {
+    core::Status result = core::Ok();
+    for (size_t i = 0; i < count_; ++i) {
+      if (auto status = entries_.at(i).transport->disconnect(); !status) {
+        result = status;
+      }
+    }
+    return result;
+  }
+
+  [[nodiscard]] bool is_connected() const noexcept override {
+    for (size_t i = 0; i < count_; ++i) {
+      if (entries_.at(i).transport->is_connected()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  [[nodiscard]] core::Result<Response> send(const Request &request) override {
+    auto route = route_for(request.message_class);
+    core::Result<Response> last = core::Err(ESP_ERR_INVALID_STATE);
+
+    // Healthy transports first; if all are down, try them anyway rather
+    // than failing without a single attempt
+    bool attempted = false;
+    for (bool down_pass : {false, true}) {
+      if (down_pass && attempted) {
+        break;
+      }
+      for (size_t i = 0; i < route.size; ++i) {
+        size_t index = route.order.at(i);
+        auto &entry = entries_.at(index);
+        if (is_down(index) != down_pass) {
+          continue;
+        }
+
+        attempted = true;
+        int64_t start = core::clock::monotonic_ms();
+        auto result = entry.transport->send(request);
+        if (result) {
+          record(index, true, core::clock::monotonic_ms() - start);
+          return result;
+        }
+
+        esp_err_t err = result.error();
+        if (err == ESP_ERR_NOT_SUPPORTED || err == ESP_ERR_INVALID_SIZE) {
+          last = std::move(result);
+          continue;
+        }
+
+        record(index, false, 0);
+        ESP_LOGW(TAG, "%s: send failed: %s", entry.name, esp_err_to_name(err));
+        if (request.body_source != nullptr) {
+          return result; // Streamed body already consumed
+        }
+        last = std::move(result);
+      }
+    }
+    return last;
+  }
+
+  [[nodiscard]] core::Status send_async(const Request &request,
+                                        OnComplete on_complete) override {
+    size_t index = pick(request.message_class);
+    if (index == NONE) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+
+    int64_t start = core::clock::monotonic_ms();
+    return entries_.at(index).transport->send_async(
+        request, [this, index, start, cb = std::move(on_complete)](
+                     core::Result<Response> result) mutable {
+          if (result) {
+            record(index, true, core::clock::monotonic_ms() - start);
+          } else if (result.error() != ESP_ERR_NOT_SUPPORTED) {
+            record(index, false, 0);
+          }
+          if (cb) {
+            cb(std::move(result));
+          }
+        });
+  }
+
+  /// Commands arrive on the first healthy transport of the Commands class
+  [[nodiscard]] core::Result<Response>
+  receive(std::chrono::milliseconds timeout) override {
+    size_t index = pick(MessageClass::Commands);
+    if (index == NONE) {
+      return core::Err(ESP_ERR_INVALID_STATE);
+    }
+    return entries_.at(index).transport->receive(timeout);
+  }
+
+private:
+  static constexpr const char *TAG = "TransportSel";
+  static constexpr size_t NONE = SIZE_MAX;
+
+  struct Entry {
+    ITransport *transport{nullptr};
+    const char *name{""};
+    TransportHealth health{};
+  };
+
+  struct Route {
+    std::array<uint8_t, MAX_TRANSPORTS> order{};
+    uint8_t size{0};
+  };
+
+  /// Explicit route, or all transports in registration order
+  [[nodiscard]] Route route_for(MessageClass message_class) const {
+    const auto &route = routes_.at(static_cast<size_t>(message_class));
+    if (route.size != 0) {
+      return route;
+    }
+    Route fallback{};
+    for (size_t i = 0; i < count_; ++i) {
+      fallback.order.at(fallback.size++) = static_cast<uint8_t>(i);
+    }
+    return fallback;
+  }
+
+  [[nodiscard]] bool is_down(size_t index) const {
+    core::LockGuard lock(mutex_);
+    return entries_.at(index).health.is_down(core::clock::monotonic_ms());
+  }
+
+  /// First healthy transport of the route, else the first one
+  [[nodiscard]] size_t pick(MessageClass message_class) const {
+    auto route = route_for(message_class);
+    size_t fallback = NONE;
+    for (size_t i = 0; i < route.size; ++i) {
+      size_t index = route.order.at(i);
+      if (!is_down(index)) {
+        return index;
+      }
+      if (fallback == NONE) {
+        fallback = index;
+      }
+    }
+    return fallback;
+  }
+
+  void record(size_t index, bool ok, int64_t latency_ms) {
+    core::LockGuard lock(mutex_);
+    auto &entry = entries_.at(index);
+    auto &health = entry.health;
+
+    if (ok) {
+      auto latency = static_cast<uint32_t>(latency_ms);
+      ++health.successes;
+      health.consecutive_failures = 0;
+      health.down_until_ms = 0;
+      health.last_latency_ms = latency;
+      health.avg_latency_ms =
+          health.successes == 1
+              ? latency
+              : health.avg_latency_ms - (health.avg_latency_ms / 8) +
+                    (latency / 8);
+      return;
+    }
+
+    ++health.failures;
+    if (health.consecutive_failures < UINT8_MAX) {
+      ++health.consecutive_failures;
+    }
+    if (policy_.failover_threshold != 0 &&
+        health.consecutive_failures >= policy_.failover_threshold) {
+      health.down_until_ms =
+          core::clock::monotonic_ms() + policy_.down_time.count();
+      ESP_LOGW(TAG, "%s: down for %lld ms after %u failures", entry.name,
+               static_cast<long long>(policy_.down_time.count()),
+               health.consecutive_failures);
+    }
+  }
+
+  SelectorPolicy policy_;
+  std::array<Entry, MAX_TRANSPORTS> entries_{};
+  std::array<Route, MESSAGE_CLASS_COUNT> routes_{};
+  size_t count_{0};
+  mutable core::Mutex mutex_;
+};
+
+} // namespace transport
@@ -8,34 +8,67 @@
 
 #pragma once
 
+#include <core/body_stream.hpp>
+#include <core/lock_stats.hpp>
+#include <core/mutex.hpp>
+#include <core/pool.hpp>
 #include <core/result.hpp>
+#include <core/url.hpp>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <span>
 #include <string>
 #include <string_view>
-#include <vector>
+#include <utility>
 
 namespace transport {
 
 /// Content types for payload serialization
 enum class ContentType : uint8_t {
-  Json,       // application/json - for configuration, commands
-  Protobuf,   // application/x-protobuf - for telemetry data
-  OctetStream // application/octet-stream - for raw binary
+  Json,              // application/json - for configuration, commands
+  Protobuf,          // application/x-protobuf - for telemetry data
+  ProtobufDelimited, // varint-length-prefixed protobuf messages
+  OctetStream        // application/octet-stream - for raw binary
+};
+
+/// Content encodings applied to a request body
+enum class ContentEncoding : uint8_t {
+  Identity, // Sent as is
+  Deflate   // zlib stream (Content-Encoding: deflate)
+};
+
+/// How a Response holds its body
+enum class ResponseMode : uint8_t {
+  Owned,   // Copied into the Response (heap)
+  Borrowed // View into the transport's buffer, held by a ResponseLease
 };
 
 /// HTTP methods
 enum class HttpMethod : uint8_t { Get, Post, Put, Delete, Patch };
 
-/// Query parameter for URL construction
-struct QueryParam {
-  std::string_view key;
-  std::string_view value;
+/// Traffic class a request belongs to (routing hint for TransportSelector)
+enum class MessageClass : uint8_t {
+  Default,   // Anything not classified below (auth, device info)
+  Telemetry, // Small periodic uploads
+  Commands,  // Command polling / acknowledgements
+  Bulk,      // Large or streamed uploads
 };
 
+/// Number of MessageClass values
+inline constexpr size_t MESSAGE_CLASS_COUNT = 4;
+
+/// Longest entity tag a Response keeps (matches core::http_buffers::ETAG)
+inline constexpr size_t MAX_ETAG_SIZE = 64;
+
+/// Query parameter for URL construction (encoded by the HTTP client)
+using QueryParam = core::QueryParam;
+
 /// HTTP-like request structure
 /// @note Uses non-owning views - caller must ensure data lifetime
 struct Request {
@@ -44,28 +77,170 @@ struct Request {
   std::span<const QueryParam> query_params{}; // Optional query parameters
   std::span<const uint8_t> body{};            // Request body (protobuf or JSON)
   ContentType content_type{ContentType::Protobuf};
+  ContentEncoding content_encoding{ContentEncoding::Identity};
+  /// Response body format to ask for (HTTP Accept; a server may ignore it)
+  ContentType accept{ContentType::Json};
+  /// Borrow the response body from the transport buffer (sync send only)
+  ResponseMode response_mode{ResponseMode::Owned};
+  /// Streamed body (replaces body; produced while sending, sync only)
+  core::IBodySource *body_source{nullptr};
+  /// Routing hint; ignored by single transports
+  MessageClass message_class{MessageClass::Default};
+  /// Entity tag from an earlier response (If-None-Match; empty = none)
+  std::string_view if_none_match{};
+  /// Network timeout for this request (0 = transport default), e.g. for a
+  /// long poll the server holds open
+  std::chrono::milliseconds timeout{0};
+};
+
+/// A transport's request lock (recursive: taken again by ResponseLease)
+using RequestMutex = core::ProfiledLock<core::RecursiveMutex>;
+
+/// Keeps a transport's receive buffer unchanged while a borrowed Response
+/// refers to it
+///
+/// Holds the transport's (recursive) request mutex: other tasks block until
+/// the lease ends, and the owning task must release it before its next
+/// request (the transport rejects that request otherwise).
+class ResponseLease {
+public:
+  ResponseLease() = default;
+
+  ResponseLease(RequestMutex &mutex, uint32_t &active)
+      : mutex_(&mutex), active_(&active) {
+    mutex_->lock();
+    ++*active_;
+  }
+
+  ~ResponseLease() { release(); }
+
+  ResponseLease(const ResponseLease &) = delete;
+  ResponseLease &operator=(const ResponseLease &) = delete;
+
+  ResponseLease(ResponseLease &&other) noexcept
+      : mutex_(std::exchange(other.mutex_, nullptr)),
+        active_(std::exchange(other.active_, nullptr)) {}
+
+  ResponseLease &operator=(ResponseLease &&other) noexcept {
+    if (this != &other) {
+      release();
+      mutex_ = std::exchange(other.mutex_, nullptr);
+      active_ = std::exchange(other.active_, nullptr);
+    }
+    return *this;
+  }
+
+  [[nodiscard]] bool held() const { return mutex_ != nullptr; }
+
+  /// End the lease early (the borrowed body becomes invalid)
+  void release() {
+    if (mutex_ != nullptr) {
+      --*active_;
+      mutex_->unlock();
+      mutex_ = nullptr;
+      active_ = nullptr;
+    }
+  }
+
+private:
+  RequestMutex *mutex_{nullptr};
+  uint32_t *active_{nullptr};
+};
+
+/// Largest owned response body (HttpClient's default response buffer)
+inline constexpr size_t RESPONSE_BODY_SIZE = 4096;
+/// Owned response bodies alive at once, one per concurrent holder:
+/// - a synchronous call's response
+/// - TransportSelector::send() keeping the previous transport's failure
+///   while the next one answers
+/// - an async completion running meanwhile on a transport's task
+/// EspNowTransport serves received messages from a pool of its own.
+inline constexpr size_t RESPONSE_BODY_BLOCKS = 3;
+
+using ResponseBodyPool =
+    core::BlockPool<RESPONSE_BODY_SIZE, RESPONSE_BODY_BLOCKS>;
+
+/// Blocks for owned response bodies (no heap per response)
+[[nodiscard]] inline ResponseBodyPool &response_body_pool() {
+  static ResponseBodyPool pool;
+  return pool;
+}
+
+/// Returns an owned response body to whichever BlockPool it came from
+struct ResponseBodyRelease {
+  void (*release)(void *pool, uint8_t *block) = nullptr;
+  void *pool = nullptr;
+  void operator()(uint8_t *block) const { release(pool, block); }
 };
 
 /// Response from transport
-/// @note Owns the body data (stored in pre-allocated buffer)
+/// @note Owns the body in a response_body_pool() block (owned()), or
+///       borrows it under a ResponseLease (borrowed()); either body is
+///       valid while the Response lives
 class Response {
 public:
   Response() = default;
 
-  Response(std::vector<uint8_t> body_data, uint16_t status)
-      : body_(std::move(body_data)), status_code_(status) {}
+  /// Response with a copy of body
+  /// @return ESP_ERR_NO_MEM if every body block is in use,
+  ///         ESP_ERR_INVALID_SIZE if body exceeds RESPONSE_BODY_SIZE
+  [[nodiscard]] static core::Result<Response>
+  owned(std::span<const uint8_t> body, uint16_t status) {
+    return owned(body, status, response_body_pool());
+  }
 
-  Response(std::span<const uint8_t> body_view, uint16_t status)
-      : body_(body_view.begin(), body_view.end()), status_code_(status) {}
+  /// Response with a copy of body in a block of pool (a transport's own)
+  /// @return ESP_ERR_NO_MEM if every block of pool is in use,
+  ///         ESP_ERR_INVALID_SIZE if body exceeds its blocks
+  template <size_t BlockSize, size_t Count>
+  [[nodiscard]] static core::Result<Response>
+  owned(std::span<const uint8_t> body, uint16_t status,
+        core::BlockPool<BlockSize, Count> &pool) {
+    using Pool = core::BlockPool<BlockSize, Count>;
+    Response response;
+    response.status_code_ = status;
+    if (body.empty()) {
+      return response;
+    }
+    if (body.size() > BlockSize) {
+      return core::Err(ESP_ERR_INVALID_SIZE);
+    }
+    auto block = pool.acquire();
+    if (!block) {
+      return core::Err(ESP_ERR_NO_MEM);
+    }
+    response.block_ = {block.release(),
+                       {.release =
+                            [](void *from, uint8_t *data) {
+                              static_cast<Pool *>(from)->release(data);
+                            },
+                        .pool = &pool}};
+    std::ranges::copy(body, response.block_.get());
+    response.view_ = {response.block_.get(), body.size()};
+    return response;
+  }
 
-  /// Get response body as span
-  [[nodiscard]] std::span<const uint8_t> body() const {
-    return {body_.data(), body_.size()};
+  /// Response viewing body in place (no copy, no heap)
+  [[nodiscard]] static Response borrowed(std::span<const uint8_t> body_view,
+                                         uint16_t status,
+                                         ResponseLease lease) {
+    Response response;
+    response.view_ = body_view;
+    response.status_code_ = status;
+    response.lease_ = std::move(lease);
+    return response;
   }
 
+  /// True if the body is a view into the transport buffer
+  [[nodiscard]] bool is_borrowed() const { return lease_.held(); }
+
+  /// Get response body as span
+  [[nodiscard]] std::span<const uint8_t> body() const { return view_; }
+
   /// Get response body as string view
   [[nodiscard]] std::string_view body_str() const {
-    return {reinterpret_cast<const char *>(body_.data()), body_.size()};
+    auto data = body();
+    return {reinterpret_cast<const char *>(data.data()), data.size()};
   }
 
   /// Get HTTP status code
@@ -85,10 +260,43 @@ public:
   [[nodiscard]] bool is_server_error() const { return status_code_ >= 500; }
 
   /// Check if response body is empty
-  [[nodiscard]] bool empty() const { return body_.empty(); }
+  [[nodiscard]] bool empty() const { return body().empty(); }
+
+  /// Server-requested wait before retrying (Retry-After; 0 = none)
+  [[nodiscard]] std::chrono::seconds retry_after() const {
+    return retry_after_;
+  }
+  void set_retry_after(std::chrono::seconds delay) { retry_after_ = delay; }
+
+  /// Server-advertised wait before the next poll (X-Poll-Interval; 0 = none)
+  [[nodiscard]] std::chrono::seconds poll_interval() const {
+    return poll_interval_;
+  }
+  void set_poll_interval(std::chrono::seconds interval) {
+    poll_interval_ = interval;
+  }
+
+  /// Entity tag of the body (ETag, quotes included; empty = none)
+  [[nodiscard]] std::string_view etag() const {
+    return {etag_.data(), etag_len_};
+  }
+  /// Copy the tag (one longer than MAX_ETAG_SIZE is dropped)
+  void set_etag(std::string_view etag) {
+    etag_len_ = etag.size() <= etag_.size() ? etag.size() : 0;
+    std::copy_n(etag.data(), etag_len_, etag_.data());
+  }
+
+  /// 304: the resource still matches the If-None-Match tag
+  [[nodiscard]] bool not_modified() const { return status_code_ == 304; }
 
 private:
-  std::vector<uint8_t> body_;
+  std::unique_ptr<uint8_t, ResponseBodyRelease> block_{}; // Owned body
+  std::span<const uint8_t> view_{};            // Owned or borrowed body
+  ResponseLease lease_;
+  std::chrono::seconds retry_after_{0};
+  std::chrono::seconds poll_interval_{0};
+  std::array<char, MAX_ETAG_SIZE> etag_{};
+  size_t etag_len_{0};
   uint16_t status_code_{0};
 };
 
@@ -126,9 +334,15 @@ public:
   [[nodiscard]] virtual core::Result<Response> send(const Request &request) = 0;
 
   /// Send a request asynchronously
+  ///
+  /// Queueing transports copy the request into a RequestPool slot
+  /// (request_pool_defaults::STORAGE bytes of path, query and body). A
+  /// request that doesn't fit there - a larger body, or a body_source -
+  /// is sent synchronously instead: on_complete then runs on the
+  /// caller's task before send_async() returns.
   /// @param request The request to send
   /// @param on_complete Callback invoked when complete
-  /// @return Status (ESP_OK if request was queued)
+  /// @return Status (ESP_OK if request was queued or sent)
   [[nodiscard]] virtual core::Status send_async(const Request &request,
                                                 OnComplete on_complete) = 0;
 
@@ -8,6 +8,9 @@
 #pragma once
 
 #include "auth.hpp"
+#include "espnow_transport.hpp"
 #include "http_transport.hpp"
+#include "mqtt_transport.hpp"
 #include "retry.hpp"
+#include "selector.hpp"
 #include "transport.hpp"
@@ -0,0 +1,85 @@
+/**
+ * @file sensor.hpp
+ * @brief Battery voltage sensor on an ADC pin
+ *
+ * Reads the cell through a resistive divider with the ADC oneshot driver.
+ * Each sample averages several conversions and converts them with the
+ * eFuse curve-fitting calibration, so readings are good to a few tens of
+ * mV without per-board trimming. Without calibration data the reading
+ * falls back to the nominal attenuation range and is coarser.
+ *
+ * The pin must be on ADC1: ADC2 is unusable while WiFi is on.
+ *
+ * A plain ISensor: a SensorMonitor samples it at the fixed interval and
+ * the voltage travels with the other measurements (BatteryVoltage).
+ */
+
+#pragma once
+
+#include <core/result.hpp>
+#include <sensor/layout.hpp>
+#include <sensor/sensor.hpp>
+
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_oneshot.h>
+#include <hal/gpio_types.h>
+
+namespace sensor::battery {
+
+/// Compile-time measurement layout
+using BatteryLayout = Layout<MeasurementId::BatteryVoltage>;
+
+/// Cell voltage through a divider on an ADC1 pin
+class BatterySensor final : public SensorBase<BatterySensor, 1>,
+                            public ISensor {
+public:
+  using MeasurementLayout = BatteryLayout;
+
+  /// Configuration for the sensor
+  struct Config {
+    gpio_num_t pin = GPIO_NUM_NC;
+    /// Cell voltage / pin voltage (e.g. 2.0 for two equal resistors)
+    float divider_ratio = 2.0F;
+    /// Conversions averaged per sample (divider noise, WiFi TX droop)
+    uint8_t oversample = 16;
+    SensorIdType sensor_id = 0; ///< ID from application's SensorId enum
+  };
+
+  explicit BatterySensor(const Config &config);
+  ~BatterySensor() override;
+
+  BatterySensor(const BatterySensor &) = delete;
+  BatterySensor &operator=(const BatterySensor &) = delete;
+  BatterySensor(BatterySensor &&) = delete;
+  BatterySensor &operator=(BatterySensor &&) = delete;
+
+  // ISensor interface
+  [[nodiscard]] SensorIdType id() const override { return sensor_id_; }
+  [[nodiscard]] std::string_view name() const override { return "battery"; }
+
+  [[nodiscard]] size_t measurement_count() const override {
+    return MEASUREMENT_COUNT;
+  }
+
+  [[nodiscard]] std::chrono::milliseconds min_interval() const override {
+    return std::chrono::seconds(1);
+  }
+
+  [[nodiscard]] std::span<const Measurement> sample() override;
+
+  /// Check if the ADC channel is ready
+  [[nodiscard]] bool valid() const { return adc_ != nullptr; }
+
+  /// Read the cell voltage now (V)
+  [[nodiscard]] core::Result<float> read_voltage();
+
+private:
+  adc_oneshot_unit_handle_t adc_ = nullptr;
+  adc_cali_handle_t cali_ = nullptr; ///< nullptr: no eFuse calibration
+  adc_channel_t channel_{};
+  float divider_ratio_;
+  uint8_t oversample_;
+  SensorIdType sensor_id_;
+};
+
+} // namespace sensor::battery
@@ -0,0 +1,110 @@
+/**
+ * @file sensor.cpp
+ * @brief Battery voltage sensor implementation
+ */
+
+#include "battery/sensor.hpp"
+
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_log.h>
+
+#include <algorithm>
+
+namespace sensor::battery {
+
+namespace {
+constexpr const char *TAG = "battery";
+
+/// 12 dB: the widest range (a halved 3 V cell sits mid-scale)
+constexpr adc_atten_t ATTEN = ADC_ATTEN_DB_12;
+
+/// Uncalibrated conversion at ATTEN (12-bit full scale)
+constexpr int FULL_SCALE_MV = 2500;
+constexpr int FULL_SCALE_RAW = 4095;
+} // namespace
+
+BatterySensor::BatterySensor(const Config &config)
+    : divider_ratio_(config.divider_ratio),
+      oversample_(std::max<uint8_t>(config.oversample, 1)),
+      sensor_id_(config.sensor_id) {
+  adc_unit_t unit{};
+  if (auto err = adc_oneshot_io_to_channel(config.pin, &unit, &channel_);
+      err != ESP_OK || unit != ADC_UNIT_1) {
+    ESP_LOGE(TAG, "GPIO %d is not an ADC1 pin", static_cast<int>(config.pin));
+    return;
+  }
+
+  adc_oneshot_unit_init_cfg_t unit_config{};
+  unit_config.unit_id = unit;
+  if (auto err = adc_oneshot_new_unit(&unit_config, &adc_); err != ESP_OK) {
+    ESP_LOGE(TAG, "ADC unit init failed: %s", esp_err_to_name(err));
+    adc_ = nullptr;
+    return;
+  }
+
+  adc_oneshot_chan_cfg_t channel_config{};
+  channel_config.atten = ATTEN;
+  channel_config.bitwidth = ADC_BITWIDTH_DEFAULT;
+  if (auto err = adc_oneshot_config_channel(adc_, channel_, &channel_config);
+      err != ESP_OK) {
+    ESP_LOGE(TAG, "ADC channel config failed: %s", esp_err_to_name(err));
+    (void)adc_oneshot_del_unit(adc_);
+    adc_ = nullptr;
+    return;
+  }
+
+  adc_cali_curve_fitting_config_t cali_config{};
+  cali_config.unit_id = unit;
+  cali_config.chan = channel_;
+  cali_config.atten = ATTEN;
+  cali_config.bitwidth = ADC_BITWIDTH_DEFAULT;
+  if (adc_cali_create_scheme_curve_fitting(&cali_config, &cali_) != ESP_OK) {
+    ESP_LOGW(TAG, "No ADC calibration in eFuse, readings are approximate");
+    cali_ = nullptr;
+  }
+}
+
+BatterySensor::~BatterySensor() {
+  if (cali_ != nullptr) {
+    (void)adc_cali_delete_scheme_curve_fitting(cali_);
+  }
+  if (adc_ != nullptr) {
+    (void)adc_oneshot_del_unit(adc_);
+  }
+}
+
+core::Result<float> BatterySensor::read_voltage() {
+  if (adc_ == nullptr) {
+    return core::Err(ESP_ERR_INVALID_STATE);
+  }
+
+  int32_t sum_mv = 0;
+  for (uint8_t i = 0; i < oversample_; ++i) {
+    int raw = 0;
+    if (auto err = adc_oneshot_read(adc_, channel_, &raw); err != ESP_OK) {
+      return core::Err(err);
+    }
+    int mv = raw * FULL_SCALE_MV / FULL_SCALE_RAW;
+    if (cali_ != nullptr) {
+      if (auto err = adc_cali_raw_to_voltage(cali_, raw, &mv); err != ESP_OK) {
+        return core::Err(err);
+      }
+    }
+    sum_mv += mv;
+  }
+  float pin_volts = static_cast<float>(sum_mv) /
+                    static_cast<float>(oversample_) / 1000.0F;
+  return pin_volts * divider_ratio_;
+}
+
+std::span<const Measurement> BatterySensor::sample() {
+  auto volts = read_voltage();
+  if (!volts) {
+    ESP_LOGW(TAG, "Read failed: %s", esp_err_to_name(volts.error()));
+    return {};
+  }
+  store<MeasurementId::BatteryVoltage>(0, *volts);
+  return get_measurements();
+}
+
+} // namespace sensor::battery
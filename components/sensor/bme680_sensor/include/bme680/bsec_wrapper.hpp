@@ -15,6 +15,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <span>
 
 namespace sensor::bme680 {
 
@@ -32,16 +33,34 @@ struct BsecOutput {
   bool valid;
 };
 
+/// Heater profile steps BSEC may request (BME688 parallel mode)
+inline constexpr size_t BSEC_MAX_HEATER_STEPS = 10;
+
 /// BSEC sensor settings for BME68x
 struct BsecSensorSettings {
   int64_t next_call_time_ns;
   uint32_t process_data;
   uint16_t heater_temperature;
   uint16_t heater_duration;
+  std::array<uint16_t, BSEC_MAX_HEATER_STEPS> heater_temperature_profile;
+  std::array<uint16_t, BSEC_MAX_HEATER_STEPS> heater_duration_profile;
+  uint8_t heater_profile_len;
   uint8_t run_gas;
   uint8_t temperature_oversampling;
   uint8_t pressure_oversampling;
   uint8_t humidity_oversampling;
+  uint8_t op_mode; // BME68X_*_MODE requested by the BSEC configuration
+};
+
+/// One BME68x data field for BSEC
+struct BsecSample {
+  int64_t time_ns;
+  float temperature;    // °C
+  float pressure;       // Pa
+  float humidity;       // %RH
+  float gas_resistance; // Ω
+  uint8_t gas_index;    // Heater profile step (parallel mode)
+  bool gas_valid;
 };
 
 /// Callback type for reading BME68x sensor
@@ -50,6 +69,10 @@ using SensorReadCallback = std::function<bool(
     float &humidity, float &gas_resistance, bool &gas_valid)>;
 
 /// BSEC2 wrapper class
+/// BSEC keeps a single global library instance, so all scratch memory
+/// (work buffer, state blob, do_steps inputs/outputs) lives in one static
+/// arena shared by every call instead of on the caller's stack.
+/// @note Not thread-safe; drive BSEC from one task only
 class BsecWrapper {
 public:
   BsecWrapper() = default;
@@ -61,7 +84,9 @@ public:
   BsecWrapper &operator=(BsecWrapper &&) = delete;
 
   /// Initialize BSEC library
-  [[nodiscard]] core::Status init();
+  /// @param config Serialized BSEC configuration (empty = compiled-in IAQ
+  ///        config); read in place, so it may point into mapped flash
+  [[nodiscard]] core::Status init(std::span<const uint8_t> config = {});
 
   /// Subscribe to all standard outputs
   [[nodiscard]] core::Status subscribe_all();
@@ -74,6 +99,15 @@ public:
   process(int64_t time_ns, float temperature, float pressure, float humidity,
           float gas_resistance, bool gas_valid) const;
 
+  /// Process several data fields (parallel / sequential mode) in one
+  /// bsec_do_steps call
+  /// @param with_profile_part Tag gas inputs with their heater step
+  [[nodiscard]] core::Result<BsecOutput>
+  process(std::span<const BsecSample> samples, bool with_profile_part) const;
+
+  /// Fields accepted by one process() call
+  static constexpr size_t MAX_SAMPLES = 3;
+
   /// Get BSEC version string
   [[nodiscard]] const char *version() const;
 
@@ -83,6 +117,19 @@ public:
   /// Load BSEC state from storage
   [[nodiscard]] core::Status load_state(core::IStorage &storage);
 
+  /// Serialize BSEC state into a caller buffer (e.g. RTC memory)
+  /// @return Number of bytes written
+  [[nodiscard]] core::Result<size_t> save_state(std::span<uint8_t> out);
+
+  /// Restore BSEC state from a serialized blob
+  [[nodiscard]] core::Status load_state(std::span<const uint8_t> blob);
+
+  /// Largest serialized state blob
+  static constexpr size_t STATE_SIZE = BSEC_MAX_STATE_BLOB_SIZE;
+
+  /// Storage key of the persisted state blob
+  static constexpr core::StorageKey STATE_KEY{"bsec_state"};
+
   /// Check if BSEC is initialized
   [[nodiscard]] bool initialized() const { return initialized_; }
 
@@ -92,16 +139,11 @@ public:
   }
 
 private:
-  static constexpr const char *STATE_KEY = "bsec_state";
-  static constexpr size_t STATE_SIZE = BSEC_MAX_STATE_BLOB_SIZE;
   static constexpr size_t VERSION_STR_SIZE = 32; // "X.X.X.X" format
 
   bool initialized_ = false;
   std::array<char, VERSION_STR_SIZE> version_str_{};
   std::chrono::milliseconds sample_interval_{BSEC_CONFIGURED_INTERVAL_MS};
-
-  // Pre-allocated work buffer (too large for stack)
-  std::array<uint8_t, BSEC_MAX_WORKBUFFER_SIZE> work_buffer_{};
 };
 
 } // namespace sensor::bme680
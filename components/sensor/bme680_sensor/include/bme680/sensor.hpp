@@ -5,6 +5,27 @@
  * Implements IExternallyTimedSensor - BSEC controls sampling timing.
  * The sensor just knows how to read; Monitor handles when to read.
  *
+ * Sampling is split-phase: one sample() call configures the sensor and
+ * triggers the forced-mode conversion, the next (scheduled after the
+ * measurement + heater duration) collects and runs BSEC. The timer task
+ * never sleeps through the heater cycle.
+ *
+ * The BME68x operating mode follows the BSEC configuration: IAQ configs
+ * use forced mode, BME688 gas-scan configs request parallel mode with a
+ * heater profile. In parallel / sequential mode every collect reads all
+ * buffered fields and feeds them to BSEC in a single call.
+ *
+ * BSEC state is checkpointed in two tiers: every processed sample goes to
+ * a CRC-protected RTC memory slot (no flash access), and the slot is
+ * flushed to NVS only when IAQ accuracy changes or nvs_flush_interval has
+ * elapsed. After a deep sleep wakeup the state is restored from RTC,
+ * without a flash read.
+ *
+ * With Config::deep_sleep the sensor survives deep sleep between BSEC
+ * calls (ULP mode): timestamps come from the RTC timer, which keeps
+ * counting while the CPU is off, and the checkpoint also carries the next
+ * BSEC call deadline.
+ *
  * Sensor ID is provided by the application via Config.
  */
 
@@ -14,8 +35,12 @@
 
 #include <bme680/driver.hpp>
 #include <core/storage.hpp>
+#include <core/storage_worker.hpp>
+#include <sensor/layout.hpp>
 #include <sensor/sensor.hpp>
 
+#include <optional>
+
 namespace sensor::bme680 {
 
 /// Measurement indices for BME680 sensor
@@ -33,23 +58,48 @@ enum class Idx : size_t {
 /// Number of measurements provided by BME680 with BSEC
 inline constexpr size_t MEASUREMENT_COUNT = static_cast<size_t>(Idx::Count);
 
+/// Compile-time measurement layout (same order as Idx)
+using BME680Layout =
+    Layout<MeasurementId::Temperature, MeasurementId::Humidity,
+           MeasurementId::Pressure, MeasurementId::IAQ,
+           MeasurementId::IAQAccuracy, MeasurementId::CO2, MeasurementId::VOC>;
+
+static_assert(BME680Layout::size == MEASUREMENT_COUNT);
+static_assert(BME680Layout::index_of<MeasurementId::VOC> ==
+              static_cast<size_t>(Idx::VOC));
+
 /// BME680 sensor with BSEC for IAQ/CO2/VOC
 /// Implements IExternallyTimedSensor - BSEC dictates when to sample
 class BME680Sensor final : public SensorBase<BME680Sensor, MEASUREMENT_COUNT>,
                            public IExternallyTimedSensor {
 public:
   static constexpr size_t MEASUREMENT_COUNT_V = MEASUREMENT_COUNT;
+  using MeasurementLayout = BME680Layout;
 
   /// Configuration for the sensor
   struct Config {
     uint8_t address = driver::bme680::I2C_ADDR_SECONDARY;
+    gpio_num_t spi_cs = GPIO_NUM_NC; ///< Chip select (SPI constructor)
     SensorIdType sensor_id = 0; ///< ID from application's SensorId enum
+    bool deep_sleep = false;    ///< Keep BSEC timing across deep sleep
+    /// Longest time a calibration change may live only in RTC memory
+    std::chrono::minutes nvs_flush_interval{60};
+    /// BSEC configuration blob, e.g. from core::BlobPartition (empty = the
+    /// one compiled in); must outlive the sensor
+    std::span<const uint8_t> bsec_config{};
+    /// Hand state flushes to this worker instead of writing inline (the
+    /// worker must outlive the sensor)
+    core::StorageWorker *writer{nullptr};
   };
 
   /// Create sensor with I2C bus, storage, and config
   BME680Sensor(driver::i2c::IMaster &bus, core::IStorage &storage,
                const Config &config);
 
+  /// Create sensor with SPI bus (CSB on config.spi_cs), storage, and config
+  BME680Sensor(driver::spi::IMaster &bus, core::IStorage &storage,
+               const Config &config);
+
   ~BME680Sensor() override = default;
 
   BME680Sensor(const BME680Sensor &) = delete;
@@ -73,24 +123,69 @@ public:
 
   // IExternallyTimedSensor interface
   [[nodiscard]] std::chrono::microseconds next_sample_delay() override;
+  [[nodiscard]] bool sample_pending() const override { return measuring_; }
 
   /// Check if sensor is ready for use
   [[nodiscard]] bool valid() const { return initialized_; }
 
-  /// Save BSEC state to storage
+  /// Check if the chip answered on its bus (BSEC may still be starting)
+  [[nodiscard]] bool driver_open() const { return driver_.is_open(); }
+
+  /// IAQ accuracy (0-3) of the last BSEC output
+  [[nodiscard]] uint8_t iaq_accuracy() const {
+    return last_output_.iaq_accuracy;
+  }
+
+  /// Flush BSEC state to storage (NVS) now
   [[nodiscard]] core::Status save_state();
 
+  /// Refresh the RTC checkpoint (state + next call deadline)
+  /// @note Call after the monitor is stopped, right before deep sleep
+  [[nodiscard]] core::Status prepare_for_sleep();
+
 private:
+  /// Open the driver and start BSEC (both constructors)
+  void open_driver();
+
   [[nodiscard]] core::Status init_bsec();
 
+  /// BSEC timestamp (RTC timer when deep_sleep, esp_timer otherwise)
+  [[nodiscard]] int64_t now_ns() const;
+
+  /// Restore BSEC state and deadline from RTC after a deep sleep wakeup
+  [[nodiscard]] bool resume_from_rtc();
+
+  /// Write BSEC state to the RTC slot (every processed sample)
+  [[nodiscard]] core::Status checkpoint_rtc();
+
+  /// Flush the RTC slot to NVS if accuracy changed or the interval elapsed
+  void maybe_flush_to_nvs(uint8_t iaq_accuracy);
+
+  /// Phase 1: apply BSEC settings and start a measurement
+  [[nodiscard]] core::Status trigger(int64_t time_ns,
+                                     const BsecSensorSettings &settings);
+
+  /// Phase 2: read the finished measurement and process it through BSEC
+  [[nodiscard]] std::span<const Measurement> collect();
+
   driver::bme680::BME680Driver driver_;
   core::IStorage &storage_;
   BsecWrapper bsec_;
   BsecOutput last_output_{};
   SensorIdType sensor_id_;
   int64_t next_call_time_ns_ = 0;
+  int64_t trigger_time_ns_ = 0; ///< BSEC timestamp of the pending conversion
+  int64_t collect_time_ns_ = 0; ///< When the pending conversion is done
+  int64_t field_period_ns_ = 0; ///< Time per field (multi-field modes)
+  /// Last configuration written to the chip (reconfigure only on change)
+  std::optional<driver::bme680::Config> applied_config_;
+  bool measuring_ = false;
+  bool parallel_ = false; ///< Heater profile steps tag BSEC gas inputs
+  bool deep_sleep_ = false;
   bool initialized_ = false;
-  uint32_t sample_count_ = 0;
+  std::chrono::minutes nvs_flush_interval_;
+  std::span<const uint8_t> bsec_config_;
+  core::StorageWorker *writer_;
 };
 
 } // namespace sensor::bme680
@@ -6,21 +6,39 @@
 #include "bme680/bsec_wrapper.hpp"
 
 #include <bsec_config.h>
+#include <power/pm.hpp>
 
 #include <esp_log.h>
 #include <esp_timer.h>
 
+#include <algorithm>
 #include <array>
 #include <cstdio>
 #include <cstring>
+#include <iterator>
 
 namespace sensor::bme680 {
 
 namespace {
 constexpr const char *TAG = "bsec";
+
+/// BSEC inputs per data field (T, H, P, gas, heater profile part)
+constexpr size_t INPUTS_PER_SAMPLE = 5;
+
+/// Static BSEC scratch arena (keeps stack usage independent of BSEC sizes)
+struct BsecArena {
+  std::array<uint8_t, BSEC_MAX_WORKBUFFER_SIZE> work;
+  std::array<uint8_t, BsecWrapper::STATE_SIZE> state;
+  std::array<bsec_input_t, BsecWrapper::MAX_SAMPLES * INPUTS_PER_SAMPLE>
+      inputs;
+  std::array<bsec_output_t, BsecWrapper::MAX_SAMPLES * BSEC_NUMBER_OUTPUTS>
+      outputs;
+};
+
+BsecArena g_arena{};
 } // namespace
 
-core::Status BsecWrapper::init() {
+core::Status BsecWrapper::init(std::span<const uint8_t> config) {
   bsec_library_return_t rslt = bsec_init();
   if (rslt != BSEC_OK) {
     ESP_LOGE(TAG, "bsec_init failed: %d", rslt);
@@ -36,13 +54,21 @@ core::Status BsecWrapper::init() {
   ESP_LOGI(TAG, "BSEC v%s initialized", version_str_.data());
 
   // Load BME680 IAQ configuration (required for LP mode)
-  rslt = bsec_set_configuration(&bsec_config_iaq[0], bsec_config_iaq_len,
-                                work_buffer_.data(), work_buffer_.size());
+  // The config blob is const data read in place; only the work buffer is
+  // scratch
+  bool external = !config.empty();
+  if (!external) {
+    config = {&bsec_config_iaq[0], bsec_config_iaq_len};
+  }
+  rslt = bsec_set_configuration(config.data(),
+                                static_cast<uint32_t>(config.size()),
+                                g_arena.work.data(), g_arena.work.size());
   if (rslt != BSEC_OK) {
     ESP_LOGE(TAG, "bsec_set_configuration failed: %d", rslt);
     return core::Err(ESP_FAIL);
   }
-  ESP_LOGI(TAG, "BSEC config loaded (LP mode, 3s)");
+  ESP_LOGI(TAG, "BSEC config loaded (%s, %zu bytes)",
+           external ? "partition" : "built-in", config.size());
 
   initialized_ = true;
   return core::Ok();
@@ -112,6 +138,15 @@ BsecSensorSettings BsecWrapper::get_sensor_settings(int64_t time_ns) const {
   result.process_data = settings.process_data;
   result.heater_temperature = settings.heater_temperature;
   result.heater_duration = settings.heater_duration;
+  result.heater_profile_len = std::min<uint8_t>(settings.heater_profile_len,
+                                                BSEC_MAX_HEATER_STEPS);
+  std::copy_n(std::begin(settings.heater_temperature_profile),
+              result.heater_profile_len,
+              result.heater_temperature_profile.begin());
+  std::copy_n(std::begin(settings.heater_duration_profile),
+              result.heater_profile_len,
+              result.heater_duration_profile.begin());
+  result.op_mode = settings.op_mode;
   result.run_gas = settings.run_gas;
   result.temperature_oversampling = settings.temperature_oversampling;
   result.pressure_oversampling = settings.pressure_oversampling;
@@ -125,41 +160,65 @@ core::Result<BsecOutput> BsecWrapper::process(int64_t time_ns,
                                               float humidity,
                                               float gas_resistance,
                                               bool gas_valid) const {
+  const BsecSample sample{
+      .time_ns = time_ns,
+      .temperature = temperature,
+      .pressure = pressure,
+      .humidity = humidity,
+      .gas_resistance = gas_resistance,
+      .gas_index = 0,
+      .gas_valid = gas_valid,
+  };
+  return process(std::span(&sample, 1), false);
+}
+
+core::Result<BsecOutput>
+BsecWrapper::process(std::span<const BsecSample> samples,
+                     bool with_profile_part) const {
   if (!initialized_) {
     return core::Err(ESP_ERR_INVALID_STATE);
   }
+  if (samples.empty() || samples.size() > MAX_SAMPLES) {
+    return core::Err(ESP_ERR_INVALID_ARG);
+  }
 
-  // Build BSEC inputs
-  enum class In : uint8_t { Temperature, Humidity, Pressure, Gas, Count };
-  auto I = [](In i) { return static_cast<size_t>(i); };
+  // Build BSEC inputs; each input carries its own timestamp, so fields
+  // from one parallel-mode read go to bsec_do_steps together
+  auto &inputs = g_arena.inputs;
+  uint8_t n_inputs = 0;
 
-  auto make_input = [time_ns](uint8_t id, float signal) {
-    bsec_input_t input{};
+  auto add_input = [&inputs, &n_inputs](int64_t time_ns, uint8_t id,
+                                        float signal) {
+    bsec_input_t &input = inputs.at(n_inputs++);
+    input = {};
     input.sensor_id = id;
     input.signal = signal;
     input.time_stamp = time_ns;
-    return input;
   };
 
-  std::array<bsec_input_t, I(In::Count)> inputs{};
-  inputs.at(I(In::Temperature)) =
-      make_input(BSEC_INPUT_TEMPERATURE, temperature);
-  inputs.at(I(In::Humidity)) = make_input(BSEC_INPUT_HUMIDITY, humidity);
-  inputs.at(I(In::Pressure)) = make_input(BSEC_INPUT_PRESSURE, pressure);
-
-  auto n_inputs = static_cast<uint8_t>(I(In::Gas)); // 3 inputs without gas
-
-  if (gas_valid) {
-    inputs.at(I(In::Gas)) = make_input(BSEC_INPUT_GASRESISTOR, gas_resistance);
-    n_inputs = static_cast<uint8_t>(I(In::Count)); // 4 inputs with gas
+  for (const auto &sample : samples) {
+    add_input(sample.time_ns, BSEC_INPUT_TEMPERATURE, sample.temperature);
+    add_input(sample.time_ns, BSEC_INPUT_HUMIDITY, sample.humidity);
+    add_input(sample.time_ns, BSEC_INPUT_PRESSURE, sample.pressure);
+
+    if (sample.gas_valid) {
+      add_input(sample.time_ns, BSEC_INPUT_GASRESISTOR, sample.gas_resistance);
+      if (with_profile_part) {
+        add_input(sample.time_ns, BSEC_INPUT_PROFILE_PART,
+                  static_cast<float>(sample.gas_index));
+      }
+    }
   }
 
   // Process through BSEC
-  std::array<bsec_output_t, BSEC_NUMBER_OUTPUTS> outputs{};
+  auto &outputs = g_arena.outputs;
   uint8_t n_outputs = outputs.size();
 
-  bsec_library_return_t rslt =
-      bsec_do_steps(inputs.data(), n_inputs, outputs.data(), &n_outputs);
+  bsec_library_return_t rslt{};
+  {
+    power::PerformancePhase boost;
+    rslt = bsec_do_steps(inputs.data(), n_inputs, outputs.data(), &n_outputs);
+  }
 
   if (rslt != BSEC_OK) {
     ESP_LOGE(TAG, "bsec_do_steps failed: %d", rslt);
@@ -214,28 +273,49 @@ core::Result<BsecOutput> BsecWrapper::process(int64_t time_ns,
 
 const char *BsecWrapper::version() const { return version_str_.data(); }
 
-core::Status BsecWrapper::save_state(core::IStorage &storage) {
+core::Result<size_t> BsecWrapper::save_state(std::span<uint8_t> out) {
   if (!initialized_) {
     return core::Err(ESP_ERR_INVALID_STATE);
   }
 
-  std::array<uint8_t, STATE_SIZE> state{};
   uint32_t n_state = 0;
-
   bsec_library_return_t rslt =
-      bsec_get_state(0, state.data(), state.size(), work_buffer_.data(),
-                     work_buffer_.size(), &n_state);
+      bsec_get_state(0, out.data(), out.size(), g_arena.work.data(),
+                     g_arena.work.size(), &n_state);
 
   if (rslt != BSEC_OK) {
     ESP_LOGE(TAG, "bsec_get_state failed: %d", rslt);
     return core::Err(ESP_FAIL);
   }
+  return static_cast<size_t>(n_state);
+}
+
+core::Status BsecWrapper::load_state(std::span<const uint8_t> blob) {
+  if (!initialized_) {
+    return core::Err(ESP_ERR_INVALID_STATE);
+  }
+
+  bsec_library_return_t rslt = bsec_set_state(
+      blob.data(), blob.size(), g_arena.work.data(), g_arena.work.size());
+
+  if (rslt != BSEC_OK) {
+    ESP_LOGW(TAG, "bsec_set_state failed: %d (state may be stale)", rslt);
+    return core::Err(ESP_FAIL);
+  }
+  return core::Ok();
+}
+
+core::Status BsecWrapper::save_state(core::IStorage &storage) {
+  auto &state = g_arena.state;
+  auto n_state = save_state(state);
+  if (!n_state) {
+    return core::Err(n_state.error());
+  }
 
   // Store as blob
-  auto result = storage.set_blob(STATE_KEY, std::span{state.data(), n_state});
+  auto result = storage.set_blob(STATE_KEY, std::span{state.data(), *n_state});
   if (result) {
-    ESP_LOGI(TAG, "Saved BSEC state (%lu bytes)",
-             static_cast<unsigned long>(n_state));
+    ESP_LOGI(TAG, "Saved BSEC state (%zu bytes)", *n_state);
   }
   return result;
 }
@@ -245,36 +325,27 @@ core::Status BsecWrapper::load_state(core::IStorage &storage) {
     return core::Err(ESP_ERR_INVALID_STATE);
   }
 
-  // Get blob size first
-  auto size_result = storage.get_blob_size(STATE_KEY);
-  if (!size_result) {
+  // Read straight into the arena (one lookup, no size query)
+  auto &state = g_arena.state;
+  auto read = core::StorageRead::blob(STATE_KEY, {state.data(), STATE_SIZE});
+  if (auto status = storage.get_many(std::span(&read, 1)); !status) {
+    return status;
+  }
+  if (read.missing()) {
     ESP_LOGI(TAG, "No saved BSEC state found");
     return core::Ok(); // Not an error, just no saved state
   }
-
-  size_t n_state = *size_result;
-  if (n_state > STATE_SIZE) {
-    ESP_LOGW(TAG, "BSEC state too large: %zu", n_state);
-    return core::Err(ESP_FAIL);
+  if (!read.found()) {
+    ESP_LOGW(TAG, "Failed to read BSEC state: %s", esp_err_to_name(read.error));
+    return core::Err(read.error);
   }
+  size_t n_state = read.size;
 
-  std::array<uint8_t, STATE_SIZE> state{};
-  auto status = storage.get_blob(STATE_KEY, std::span{state.data(), n_state});
-  if (!status) {
-    ESP_LOGW(TAG, "Failed to read BSEC state");
-    return status;
+  auto status = load_state(std::span<const uint8_t>{state.data(), n_state});
+  if (status) {
+    ESP_LOGI(TAG, "Loaded BSEC state (%zu bytes)", n_state);
   }
-
-  bsec_library_return_t rslt = bsec_set_state(
-      state.data(), n_state, work_buffer_.data(), work_buffer_.size());
-
-  if (rslt != BSEC_OK) {
-    ESP_LOGW(TAG, "bsec_set_state failed: %d (state may be stale)", rslt);
-    return core::Err(ESP_FAIL);
-  }
-
-  ESP_LOGI(TAG, "Loaded BSEC state (%zu bytes)", n_state);
-  return core::Ok();
+  return status;
 }
 
 } // namespace sensor::bme680
@@ -5,29 +5,63 @@
 
 #include "bme680/sensor.hpp"
 
+#include <core/fault.hpp>
+#include <core/rtc_storage.hpp>
+
+#include <esp_attr.h>
 #include <esp_log.h>
+#include <esp_rtc_time.h>
 #include <esp_timer.h>
 
 #include <algorithm>
-#include <array>
-#include <cstring>
+#include <any>
 
 namespace sensor::bme680 {
 
 namespace {
 constexpr const char *TAG = "bme680";
 
-int64_t get_timestamp_ns() {
-  return esp_timer_get_time() * 1000LL; // µs to ns
+/// BSEC context kept across deep sleep (tier 1 checkpoint)
+struct BsecRtcSnapshot {
+  core::RtcValue<int64_t> next_call_ns;
+  core::RtcBlobT<BsecWrapper::STATE_SIZE> state;
+  core::RtcValue<uint8_t> flushed_accuracy; ///< IAQ accuracy last in NVS
+  core::RtcValue<int64_t> flushed_us; ///< RTC time of last NVS flush
+};
+
+RTC_DATA_ATTR BsecRtcSnapshot g_bsec_rtc;
+
+driver::bme680::Mode to_driver_mode(uint8_t op_mode) {
+  switch (op_mode) {
+  case BME68X_PARALLEL_MODE:
+    return driver::bme680::Mode::Parallel;
+  case BME68X_SEQUENTIAL_MODE:
+    return driver::bme680::Mode::Sequential;
+  default:
+    return driver::bme680::Mode::Forced;
+  }
 }
 } // namespace
 
 BME680Sensor::BME680Sensor(driver::i2c::IMaster &bus, core::IStorage &storage,
                            const Config &config)
     : driver_(bus, config.address), storage_(storage),
-      sensor_id_(config.sensor_id) {
+      sensor_id_(config.sensor_id), deep_sleep_(config.deep_sleep),
+      nvs_flush_interval_(config.nvs_flush_interval),
+      bsec_config_(config.bsec_config), writer_(config.writer) {
+  open_driver();
+}
+
+BME680Sensor::BME680Sensor(driver::spi::IMaster &bus, core::IStorage &storage,
+                           const Config &config)
+    : driver_(bus, config.spi_cs), storage_(storage),
+      sensor_id_(config.sensor_id), deep_sleep_(config.deep_sleep),
+      nvs_flush_interval_(config.nvs_flush_interval),
+      bsec_config_(config.bsec_config), writer_(config.writer) {
+  open_driver();
+}
 
-  // Open driver
+void BME680Sensor::open_driver() {
   auto status = driver_.open();
   if (!status) {
     ESP_LOGE(TAG, "Failed to open driver: %s", esp_err_to_name(status.error()));
@@ -54,14 +88,17 @@ core::Status BME680Sensor::init_bsec() {
   }
 
   if (!bsec_.initialized()) {
-    auto status = bsec_.init();
+    auto status = bsec_.init(bsec_config_);
     if (!status) {
       ESP_LOGE(TAG, "BSEC init failed");
       return status;
     }
 
-    // Try to load saved state (non-fatal if missing)
-    (void)bsec_.load_state(storage_);
+    // Resume from RTC after deep sleep, else load saved state from NVS
+    // (non-fatal if missing)
+    if (!resume_from_rtc()) {
+      (void)bsec_.load_state(storage_);
+    }
 
     // Subscribe to outputs
     status = bsec_.subscribe_all();
@@ -84,7 +121,11 @@ std::span<const Measurement> BME680Sensor::sample() {
     }
   }
 
-  int64_t time_ns = get_timestamp_ns();
+  if (measuring_) {
+    return collect();
+  }
+
+  int64_t time_ns = now_ns();
 
   // Get BSEC sensor settings
   auto settings = bsec_.get_sensor_settings(time_ns);
@@ -99,6 +140,14 @@ std::span<const Measurement> BME680Sensor::sample() {
     return get_measurements(); // Return cached
   }
 
+  if (auto status = trigger(time_ns, settings); !status) {
+    ESP_LOGW(TAG, "Trigger failed: %s", esp_err_to_name(status.error()));
+  }
+  return get_measurements();
+}
+
+core::Status BME680Sensor::trigger(int64_t time_ns,
+                                   const BsecSensorSettings &settings) {
   // Configure BME680 based on BSEC requirements
   driver::bme680::Config config{};
   config.temp_os = settings.temperature_oversampling;
@@ -107,31 +156,92 @@ std::span<const Measurement> BME680Sensor::sample() {
   config.heater_temp = settings.heater_temperature;
   config.heater_dur = settings.heater_duration;
   config.enable_gas = settings.run_gas != 0;
+  config.mode = to_driver_mode(settings.op_mode);
+
+  if (config.mode != driver::bme680::Mode::Forced) {
+    auto &profile = config.profile;
+    profile.length = std::min<uint8_t>(settings.heater_profile_len,
+                                       driver::bme680::MAX_HEATER_STEPS);
+    std::copy_n(settings.heater_temperature_profile.begin(), profile.length,
+                profile.temperature.begin());
+    std::copy_n(settings.heater_duration_profile.begin(), profile.length,
+                profile.duration.begin());
+  }
 
-  const driver::bme680::Config *config_ptr = &config;
-  (void)driver_.ioctl(
-      static_cast<uint32_t>(driver::bme680::IoctlCmd::Configure), config_ptr);
+  // BSEC asks for the same settings cycle after cycle; writing them again
+  // costs a bus round trip and stops a continuous mode
+  if (applied_config_ != config) {
+    const driver::bme680::Config *config_ptr = &config;
+    auto configured = driver_.ioctl(
+        static_cast<uint32_t>(driver::bme680::IoctlCmd::Configure),
+        config_ptr);
+    if (!configured) {
+      applied_config_.reset(); // Chip state unknown: write it all next time
+      return core::Fail(configured.error());
+    }
+    applied_config_ = config;
+  }
+
+  auto duration = driver_.ioctl(
+      static_cast<uint32_t>(driver::bme680::IoctlCmd::TriggerMeasurement),
+      std::any{});
+  if (!duration) {
+    return core::Err(duration.error());
+  }
+
+  auto wait = std::any_cast<std::chrono::microseconds>(*duration);
+  trigger_time_ns_ = time_ns;
+  field_period_ns_ = wait.count() * 1000LL;
+  collect_time_ns_ = now_ns() + field_period_ns_;
+  parallel_ = config.mode == driver::bme680::Mode::Parallel;
+  measuring_ = true;
+  return core::Ok();
+}
 
-  // Read raw sensor data
-  std::array<uint8_t, sizeof(driver::bme680::SensorData)> buffer{};
-  auto read_result = driver_.read(buffer);
+std::span<const Measurement> BME680Sensor::collect() {
+  measuring_ = false;
 
-  if (!read_result) {
+  auto data_result = driver_.ioctl(
+      static_cast<uint32_t>(driver::bme680::IoctlCmd::CollectFields),
+      std::any{});
+  if (!data_result) {
+    ESP_LOGW(TAG, "Collect failed: %s", esp_err_to_name(data_result.error()));
     return get_measurements(); // Return cached on error
   }
 
-  driver::bme680::SensorData raw{};
-  std::memcpy(&raw, buffer.data(), sizeof(raw));
+  auto field_set = std::any_cast<driver::bme680::FieldSet>(*data_result);
+  auto fields = field_set.view();
+  if (fields.empty()) {
+    ESP_LOGW(TAG, "Collect returned no new data");
+    return get_measurements();
+  }
+  const auto &raw = fields.back();
 
   // Debug: log raw sensor values
-  ESP_LOGW(TAG, "Raw: T=%.2f°C P=%.2fhPa H=%.2f%% Gas=%.0fΩ valid=%d",
+  ESP_LOGW(TAG, "Raw: T=%.2f°C P=%.2fhPa H=%.2f%% Gas=%.0fΩ valid=%d (%zu)",
            raw.temperature, raw.pressure, raw.humidity, raw.gas_resistance,
-           raw.gas_valid);
+           raw.gas_valid, fields.size());
+
+  // All fields go through BSEC in one call; fields were produced one
+  // period apart, ending at the newest (BSEC expects pressure in Pa)
+  std::array<BsecSample, BsecWrapper::MAX_SAMPLES> samples{};
+  size_t n_samples = std::min(fields.size(), samples.size());
+  for (size_t i = 0; i < n_samples; ++i) {
+    const auto &field = fields[fields.size() - n_samples + i];
+    samples.at(i) = {
+        .time_ns = trigger_time_ns_ -
+                   (static_cast<int64_t>(n_samples - 1 - i) * field_period_ns_),
+        .temperature = field.temperature,
+        .pressure = field.pressure * 100.0F,
+        .humidity = field.humidity,
+        .gas_resistance = field.gas_resistance,
+        .gas_index = field.gas_index,
+        .gas_valid = field.gas_valid,
+    };
+  }
 
-  // Process through BSEC (expects pressure in Pa, we have hPa)
   auto bsec_result =
-      bsec_.process(time_ns, raw.temperature, raw.pressure * 100.0F,
-                    raw.humidity, raw.gas_resistance, raw.gas_valid);
+      bsec_.process(std::span(samples.data(), n_samples), parallel_);
 
   auto I = [](Idx i) { return static_cast<size_t>(i); };
 
@@ -154,10 +264,9 @@ std::span<const Measurement> BME680Sensor::sample() {
     store<MeasurementId::CO2>(I(Idx::CO2), last_output_.co2);
     store<MeasurementId::VOC>(I(Idx::VOC), last_output_.voc);
 
-    // Periodically save state (every 100 samples ≈ 5 minutes at 3s)
-    sample_count_++;
-    if (sample_count_ % 100 == 0) {
-      (void)save_state();
+    // Checkpoint every cycle to RTC; flash only when it matters
+    if (checkpoint_rtc()) {
+      maybe_flush_to_nvs(last_output_.iaq_accuracy);
     }
   } else {
     // Fall back to raw values
@@ -174,8 +283,8 @@ std::span<const Measurement> BME680Sensor::sample() {
 }
 
 std::chrono::microseconds BME680Sensor::next_sample_delay() {
-  int64_t now_ns = get_timestamp_ns();
-  int64_t delay_ns = next_call_time_ns_ - now_ns;
+  int64_t due_ns = measuring_ ? collect_time_ns_ : next_call_time_ns_;
+  int64_t delay_ns = due_ns - now_ns();
 
   // Minimum 10ms
   delay_ns = std::max(delay_ns, 10'000'000LL);
@@ -184,8 +293,94 @@ std::chrono::microseconds BME680Sensor::next_sample_delay() {
 }
 
 core::Status BME680Sensor::save_state() {
-  auto guard = storage_.auto_commit();
-  return bsec_.save_state(storage_);
+  if (!g_bsec_rtc.state.is_valid()) {
+    if (auto status = checkpoint_rtc(); !status) {
+      return status;
+    }
+  }
+
+  core::Status status = core::Ok();
+  if (writer_ != nullptr) {
+    // Copied into the queue; the flash write happens on the worker task
+    status = writer_->submit(
+        storage_, core::StorageWrite::blob(BsecWrapper::STATE_KEY,
+                                           g_bsec_rtc.state.span()));
+  } else {
+    auto guard = storage_.auto_commit();
+    status =
+        storage_.set_blob(BsecWrapper::STATE_KEY, g_bsec_rtc.state.span());
+  }
+  if (status) {
+    g_bsec_rtc.flushed_us.set(static_cast<int64_t>(esp_rtc_get_time_us()));
+    ESP_LOGI(TAG, "%s BSEC state (%zu bytes)",
+             writer_ != nullptr ? "Queued" : "Saved",
+             g_bsec_rtc.state.span().size());
+  }
+  return status;
+}
+
+core::Status BME680Sensor::prepare_for_sleep() { return checkpoint_rtc(); }
+
+core::Status BME680Sensor::checkpoint_rtc() {
+  if (!initialized_) {
+    return core::Err(ESP_ERR_INVALID_STATE);
+  }
+
+  auto n_state = bsec_.save_state(g_bsec_rtc.state.buffer());
+  if (!n_state) {
+    return core::Err(n_state.error());
+  }
+
+  g_bsec_rtc.state.commit(*n_state);
+  g_bsec_rtc.next_call_ns.set(next_call_time_ns_);
+  return core::Ok();
+}
+
+void BME680Sensor::maybe_flush_to_nvs(uint8_t iaq_accuracy) {
+  auto now_us = static_cast<int64_t>(esp_rtc_get_time_us());
+  if (!g_bsec_rtc.flushed_us.is_valid()) {
+    // First checkpoint since power-on: start the interval now, NVS already
+    // holds whatever state we booted from
+    g_bsec_rtc.flushed_us.set(now_us);
+    g_bsec_rtc.flushed_accuracy.set(iaq_accuracy);
+    return;
+  }
+
+  bool accuracy_changed = g_bsec_rtc.flushed_accuracy.get() != iaq_accuracy;
+  auto interval_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(nvs_flush_interval_)
+          .count();
+  bool interval_elapsed = now_us - g_bsec_rtc.flushed_us.get() >= interval_us;
+
+  if (accuracy_changed || interval_elapsed) {
+    if (save_state()) {
+      g_bsec_rtc.flushed_accuracy.set(iaq_accuracy);
+    }
+  }
+}
+
+int64_t BME680Sensor::now_ns() const {
+  // RTC time keeps running through deep sleep; esp_timer restarts at boot
+  auto us = deep_sleep_ ? static_cast<int64_t>(esp_rtc_get_time_us())
+                        : esp_timer_get_time();
+  return us * 1000LL;
+}
+
+bool BME680Sensor::resume_from_rtc() {
+  if (!core::woke_from_deep_sleep() || !g_bsec_rtc.state.is_valid()) {
+    return false;
+  }
+
+  if (!bsec_.load_state(g_bsec_rtc.state.span())) {
+    return false;
+  }
+
+  // The deadline is only meaningful on the RTC time base
+  if (deep_sleep_ && g_bsec_rtc.next_call_ns.is_valid()) {
+    next_call_time_ns_ = g_bsec_rtc.next_call_ns.get();
+  }
+  ESP_LOGI(TAG, "BSEC state resumed from RTC");
+  return true;
 }
 
 } // namespace sensor::bme680
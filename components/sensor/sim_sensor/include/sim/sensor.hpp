@@ -0,0 +1,128 @@
+/**
+ * @file sensor.hpp
+ * @brief Simulated sensor for load and soak tests of the data path
+ *
+ * Produces synthetic samples of up to seven float measurements (the
+ * BME680's and the battery's ids, around typical values) at a configured
+ * rate of up to 1 kHz, far beyond any real sensor on the board. Registered
+ * like any other monitor, its samples take the whole path: deadband,
+ * DataManager, anomaly detection, telemetry and the offline log. Raising
+ * the rate until stats() reports missed slots, or a later stage its own
+ * drops, finds the saturation point of each stage.
+ *
+ * An IExternallyTimedSensor: it keeps its own schedule from esp_timer
+ * time, so a late timer shows up as missed samples instead of a slower
+ * rate.
+ *
+ *   using SimMonitor = sensor::ExternallyTimedMonitor<sensor::sim::SimSensor>;
+ *   SimMonitor monitor(sensor::sim::SimSensor::Config{.rate_hz = 500,
+ *                                                     .sensor_id = id});
+ *   sensors.register_monitor(monitor);
+ */
+
+#pragma once
+
+#include <sensor/layout.hpp>
+#include <sensor/sensor.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace sensor::sim {
+
+/// Shape of the simulated values
+enum class Pattern : uint8_t {
+  Constant, ///< The typical value
+  Ramp,     ///< Sawtooth through the swing
+  Sine,     ///< Sine through the swing
+  Square,   ///< Alternates between the swing's ends
+  Noise,    ///< Uniform noise within the swing
+};
+
+[[nodiscard]] const char *to_string(Pattern pattern);
+
+/// Compile-time measurement layout (the first measurement_count are sent)
+using SimLayout =
+    Layout<MeasurementId::Temperature, MeasurementId::Humidity,
+           MeasurementId::Pressure, MeasurementId::IAQ, MeasurementId::CO2,
+           MeasurementId::VOC, MeasurementId::BatteryVoltage>;
+
+/// Synthetic sample source
+///
+/// @thread_safety sample() and next_sample_delay() run on the monitor's
+/// timer task; stats() may be called from any task.
+class SimSensor final : public SensorBase<SimSensor, SimLayout::size>,
+                        public IExternallyTimedSensor {
+public:
+  using MeasurementLayout = SimLayout;
+
+  /// Highest sample rate
+  static constexpr uint32_t MAX_RATE_HZ = 1000;
+
+  /// Configuration for the sensor
+  struct Config {
+    /// Measurements per sample (1 to MEASUREMENT_COUNT)
+    uint8_t measurement_count = MEASUREMENT_COUNT;
+    /// Samples per second (1 to MAX_RATE_HZ)
+    uint32_t rate_hz = 10;
+    Pattern pattern = Pattern::Sine;
+    /// Samples per ramp, sine or square period
+    uint32_t cycle = 100;
+    /// Half the swing, as a fraction of each measurement's typical value
+    float amplitude = 0.1F;
+    /// Fail every nth sample (0: never), to exercise the error paths
+    uint32_t fail_every = 0;
+    uint32_t seed = 1; ///< Noise generator seed
+    SensorIdType sensor_id = 0; ///< ID from application's SensorId enum
+  };
+
+  /// Counters since construction
+  struct Stats {
+    uint32_t samples;  ///< Returned with measurements
+    uint32_t failures; ///< Failed on purpose (fail_every)
+    uint32_t missed;   ///< Slots skipped because the timer ran late
+  };
+
+  explicit SimSensor(const Config &config);
+
+  // ISensor interface
+  [[nodiscard]] SensorIdType id() const override { return sensor_id_; }
+  [[nodiscard]] std::string_view name() const override { return "sim"; }
+
+  [[nodiscard]] size_t measurement_count() const override { return count_; }
+
+  /// One sample period (at least 1 ms)
+  [[nodiscard]] std::chrono::milliseconds min_interval() const override;
+
+  [[nodiscard]] std::span<const Measurement> sample() override;
+
+  // IExternallyTimedSensor interface
+  [[nodiscard]] std::chrono::microseconds next_sample_delay() override;
+
+  [[nodiscard]] Stats stats() const;
+
+private:
+  /// Position within the swing for the sample at index (-1 to 1)
+  [[nodiscard]] float shape(uint32_t index, size_t channel);
+
+  /// xorshift32: uniform in [-1, 1]
+  [[nodiscard]] float noise();
+
+  size_t count_;
+  int64_t period_us_;
+  Pattern pattern_;
+  uint32_t cycle_;
+  float amplitude_;
+  uint32_t fail_every_;
+  uint32_t rng_;
+  SensorIdType sensor_id_;
+
+  uint32_t index_ = 0;
+  int64_t next_due_us_ = 0; ///< esp_timer time of the next slot (0: none)
+  std::atomic<uint32_t> samples_{0};
+  std::atomic<uint32_t> failures_{0};
+  std::atomic<uint32_t> missed_{0};
+};
+
+} // namespace sensor::sim
@@ -0,0 +1,131 @@
+/**
+ * @file sensor.cpp
+ * @brief Simulated sensor implementation
+ */
+
+#include "sim/sensor.hpp"
+
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+namespace sensor::sim {
+
+namespace {
+/// Typical value of each SimLayout measurement, in its order
+constexpr std::array<float, SimLayout::size> TYPICAL{
+    21.0F,   // Temperature (°C)
+    45.0F,   // Humidity (%)
+    1013.0F, // Pressure (hPa)
+    50.0F,   // IAQ
+    600.0F,  // CO2 (ppm)
+    0.5F,    // VOC (ppm)
+    3.0F,    // BatteryVoltage (V)
+};
+} // namespace
+
+const char *to_string(Pattern pattern) {
+  switch (pattern) {
+  case Pattern::Constant:
+    return "constant";
+  case Pattern::Ramp:
+    return "ramp";
+  case Pattern::Sine:
+    return "sine";
+  case Pattern::Square:
+    return "square";
+  case Pattern::Noise:
+    return "noise";
+  default:
+    return "unknown";
+  }
+}
+
+SimSensor::SimSensor(const Config &config)
+    : count_(std::clamp<size_t>(config.measurement_count, 1,
+                                MEASUREMENT_COUNT)),
+      period_us_(1'000'000 / std::clamp<uint32_t>(config.rate_hz, 1,
+                                                   MAX_RATE_HZ)),
+      pattern_(config.pattern), cycle_(std::max<uint32_t>(config.cycle, 2)),
+      amplitude_(config.amplitude), fail_every_(config.fail_every),
+      rng_(config.seed != 0 ? config.seed : 1), sensor_id_(config.sensor_id) {
+  for (size_t i = 0; i < MEASUREMENT_COUNT; ++i) {
+    measurements_.at(i) = Measurement(SimLayout::ids.at(i), TYPICAL.at(i));
+  }
+}
+
+std::chrono::milliseconds SimSensor::min_interval() const {
+  return std::max(std::chrono::milliseconds(1),
+                  std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::microseconds(period_us_)));
+}
+
+std::span<const Measurement> SimSensor::sample() {
+  uint32_t index = index_++;
+  if (fail_every_ != 0 && (index + 1) % fail_every_ == 0) {
+    failures_.fetch_add(1, std::memory_order_relaxed);
+    return {};
+  }
+
+  for (size_t i = 0; i < count_; ++i) {
+    float value = TYPICAL.at(i) * (1.0F + (amplitude_ * shape(index, i)));
+    measurements_.at(i) = Measurement(SimLayout::ids.at(i), value);
+  }
+  samples_.fetch_add(1, std::memory_order_relaxed);
+  return std::span<const Measurement>(measurements_.data(), count_);
+}
+
+std::chrono::microseconds SimSensor::next_sample_delay() {
+  int64_t now = esp_timer_get_time();
+  if (next_due_us_ == 0) {
+    next_due_us_ = now;
+  }
+  next_due_us_ += period_us_;
+
+  // More than a whole period behind: skip the slots instead of bursting
+  if (int64_t behind = now - next_due_us_; behind >= period_us_) {
+    int64_t skipped = behind / period_us_;
+    missed_.fetch_add(static_cast<uint32_t>(skipped),
+                      std::memory_order_relaxed);
+    next_due_us_ += skipped * period_us_;
+  }
+  return std::chrono::microseconds(std::max<int64_t>(next_due_us_ - now, 0));
+}
+
+SimSensor::Stats SimSensor::stats() const {
+  return Stats{.samples = samples_.load(std::memory_order_relaxed),
+               .failures = failures_.load(std::memory_order_relaxed),
+               .missed = missed_.load(std::memory_order_relaxed)};
+}
+
+float SimSensor::shape(uint32_t index, size_t channel) {
+  // Channels are spread over the cycle so they don't move in lockstep
+  uint32_t offset = static_cast<uint32_t>(channel) * cycle_ / count_;
+  float phase = static_cast<float>((index + offset) % cycle_) /
+                static_cast<float>(cycle_);
+  switch (pattern_) {
+  case Pattern::Ramp:
+    return (2.0F * phase) - 1.0F;
+  case Pattern::Sine:
+    return std::sin(2.0F * std::numbers::pi_v<float> * phase);
+  case Pattern::Square:
+    return phase < 0.5F ? 1.0F : -1.0F;
+  case Pattern::Noise:
+    return noise();
+  case Pattern::Constant:
+  default:
+    return 0.0F;
+  }
+}
+
+float SimSensor::noise() {
+  rng_ ^= rng_ << 13;
+  rng_ ^= rng_ >> 17;
+  rng_ ^= rng_ << 5;
+  return (static_cast<float>(rng_) / 2147483648.0F) - 1.0F;
+}
+
+} // namespace sensor::sim
@@ -15,7 +15,15 @@
 #include <provisioning_config.h>
 
 #include <driver/gpio.h>
+#include <network/wifi_types.hpp>
+#include <power/sleep.hpp>
+#include <proto/measurement_adapter.hpp>
+#include <sensor/anomaly.hpp>
+#include <sim/sensor.hpp>
+#include <transport/espnow_transport.hpp>
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 
@@ -31,6 +39,80 @@ inline constexpr uint64_t SLEEP_INTERVAL_SEC = 30;
 /// BSEC operation mode (generated by setup tool)
 inline constexpr bool BSEC_DEEP_SLEEP_MODE = false;
 
+/// Duty cycle for battery units: wake, measure, upload, deep sleep until
+/// the next sample. Needs the Deep Sleep BSEC mode (tools/setup)
+inline constexpr bool DUTY_CYCLE_MODE = false;
+
+/// Phase limits of one duty cycle
+namespace duty_cycle {
+/// Wait for the cycle's sample
+inline constexpr uint32_t MEASURE_TIMEOUT_SEC = 5;
+/// WiFi connect, authentication and upload
+inline constexpr uint32_t TRANSMIT_TIMEOUT_SEC = 30;
+/// Whole wake, whatever hangs (covers INIT too)
+inline constexpr uint32_t AWAKE_TIMEOUT_SEC = 90;
+/// WiFi attempts per wake (fast connect, then scans). The wake sleeps when
+/// they fail or the AP is out of range; the upload stays due for the next
+inline constexpr uint8_t WIFI_MAX_RETRIES = 2;
+/// Wakes only bring up WiFi when an upload is due (power::plan_cycle):
+/// the upload interval (config_update upload_interval_s) runs out, this
+/// many records are buffered, or an alert is raised or cleared
+inline constexpr size_t BACKLOG_UPLOAD_RECORDS = 2048;
+/// Measurements batched in RTC memory (8 bytes each) by wakes that don't
+/// transmit; flash only sees them on the wake that uploads. A BSEC wake
+/// stores ~10, so an hour of 5 minute wakes fits
+inline constexpr size_t RTC_BATCH_MEASUREMENTS = 192;
+/// IAQ at or above this (heavily polluted air) is uploaded right away
+inline constexpr float ALERT_IAQ = 200.0F;
+/// Upload the time per phase of the last transmitting wake (and the awake
+/// time of the last measure-only one) with each upload (Profile* ids)
+inline constexpr bool REPORT_WAKE_PROFILE = true;
+} // namespace duty_cycle
+
+/// External wake source (PIR, comparator output) for the duty cycle: a GPIO
+/// wake records a WakeEvent and uploads it at once
+namespace wake {
+inline constexpr bool GPIO_WAKE = false;
+/// GPIO0-5 on the ESP32-C3
+inline constexpr gpio_num_t GPIO_PIN = GPIO_NUM_3;
+inline constexpr power::WakeLevel GPIO_LEVEL = power::WakeLevel::High;
+/// Timer wakes of a board without a BSEC sensor, events wake it sooner
+inline constexpr uint64_t IDLE_SLEEP_SEC = 3600;
+/// Sleep through GPIO wakes whose pin is inactive again by the time the
+/// wake stub runs (bounce, EMI), without a full boot (power::wake_stub)
+inline constexpr bool FILTER_GLITCHES = true;
+} // namespace wake
+
+/// Light sleep between tasks whenever no PM lock is held (CPU at its
+/// minimum clock otherwise). A USB-Serial-JTAG console drops out while
+/// asleep: turn off for debugging
+inline constexpr bool AUTO_LIGHT_SLEEP = true;
+
+/// Heap headroom for TLS (core::HeapWatchdog), checked around every cloud
+/// operation. A handshake needs its IN (16 KiB) and OUT (4 KiB) record
+/// buffers as single blocks
+namespace heap {
+/// Largest free block below which idle connections are closed
+inline constexpr uint32_t LOW_BLOCK = 32 * 1024;
+/// Largest free block below which cloud work is deferred
+inline constexpr uint32_t CRITICAL_BLOCK = 22 * 1024;
+/// Critical checks in a row (two per operation) before a soft restart
+/// (continuous mode only)
+inline constexpr uint8_t CRITICAL_LIMIT = 6;
+} // namespace heap
+
+/// SENSOR_EVENTS get an event loop task of their own (core::EventBus), so
+/// a burst of sensor events and the WiFi/IP handlers on the default loop
+/// don't queue behind each other. Off: nothing posts to SENSOR_EVENTS yet
+/// (DataManager notifies through DataNotifier), and the loop would only
+/// cost its stack and queue
+namespace sensor_events {
+inline constexpr bool DEDICATED_LOOP = false;
+inline constexpr int32_t QUEUE_SIZE = 32;
+inline constexpr uint8_t PRIORITY = 5;
+inline constexpr uint32_t STACK_SIZE = 3072;
+} // namespace sensor_events
+
 /// Minimum battery voltage (mV) before entering permanent sleep
 inline constexpr uint32_t BATTERY_MIN_MV = 2400;
 
@@ -47,12 +129,82 @@ inline constexpr gpio_num_t I2C_SCL_PIN = GPIO_NUM_9;
 /// I2C bus speed in Hz
 inline constexpr uint32_t I2C_FREQ_HZ = 100'000;
 
+/// I2C transaction queue depth (>0 = ISR-completed async transfers). 0
+/// keeps Device::transfer() batching register ops into one bus operation;
+/// an async bus splits them up again
+inline constexpr size_t I2C_QUEUE_DEPTH = 0;
+
+// =============================================================================
+// SPI Bus Configuration
+// =============================================================================
+// Optional: a BME68x wired for SPI (CSB to a GPIO) reads its registers at
+// 8 MHz instead of 100 kHz. GPIO_NUM_NC leaves the bus off; the BME680 is
+// then looked for on I2C.
+
+/// SPI clock pin
+inline constexpr gpio_num_t SPI_SCLK_PIN = GPIO_NUM_NC;
+
+/// SPI MOSI pin (BME68x SDI)
+inline constexpr gpio_num_t SPI_MOSI_PIN = GPIO_NUM_NC;
+
+/// SPI MISO pin (BME68x SDO)
+inline constexpr gpio_num_t SPI_MISO_PIN = GPIO_NUM_NC;
+
+/// BME68x chip select (NC: BME680 on I2C)
+inline constexpr gpio_num_t BME680_SPI_CS = GPIO_NUM_NC;
+
 // =============================================================================
 // Sensor Configuration
 // =============================================================================
+// Sensors are auto-discovered on the I2C bus (see driver::i2c::DriverRegistry)
+// Defaults below can be changed per device with the config_update command
+
+/// Fixed-interval sensor sampling in seconds (BSEC sensors keep their own)
+inline constexpr uint32_t SENSOR_SAMPLE_INTERVAL_SEC = 60;
 
-/// BME680 I2C address (SDO→GND = 0x76, SDO→VCC = 0x77)
-inline constexpr uint8_t BME680_ADDRESS = 0x77;
+/// Edge anomaly detection (sensor::AnomalyDetector) on the raw samples.
+/// An anomaly is uploaded right away (a duty-cycled unit transmits on that
+/// wake), so routine data can wait QUIET_STRETCH upload intervals
+namespace anomaly {
+inline constexpr bool ENABLED = true;
+/// Moving average weight: ~20 samples of memory
+inline constexpr float ALPHA = 0.05F;
+inline constexpr uint16_t WARMUP_SAMPLES = 20;
+/// z limit in standard deviations, rate limit in units per minute
+inline constexpr std::array<sensor::AnomalyRule, 6> RULES{{
+    {.id = sensor::MeasurementId::Temperature, .z_limit = 5.0F,
+     .rate_limit = 1.0F},
+    {.id = sensor::MeasurementId::Humidity, .z_limit = 5.0F,
+     .rate_limit = 5.0F},
+    {.id = sensor::MeasurementId::Pressure, .z_limit = 6.0F},
+    {.id = sensor::MeasurementId::IAQ, .z_limit = 4.0F},
+    {.id = sensor::MeasurementId::CO2, .z_limit = 4.0F, .rate_limit = 150.0F},
+    {.id = sensor::MeasurementId::VOC, .z_limit = 4.0F, .rate_limit = 1.0F},
+}};
+/// Upload interval multiplier for routine data while detection is on
+inline constexpr uint32_t QUIET_STRETCH = 4;
+} // namespace anomaly
+
+/// Simulated sensor (sensor::sim::SimSensor) next to the real ones, for
+/// load and soak tests: its samples take the whole data path up to the
+/// uploads. Continuous mode only. Its values swing, so turn anomaly
+/// detection off unless the anomaly uploads are under test too
+namespace sim {
+inline constexpr bool ENABLED = false;
+inline constexpr uint8_t MEASUREMENTS = 7;
+inline constexpr uint32_t RATE_HZ = 100; ///< Up to 1 kHz
+inline constexpr sensor::sim::Pattern PATTERN = sensor::sim::Pattern::Sine;
+/// Half the swing, as a fraction of the typical values
+inline constexpr float AMPLITUDE = 0.1F;
+/// Fail every nth sample (0: never)
+inline constexpr uint32_t FAIL_EVERY = 0;
+} // namespace sim
+
+/// Report unchanged values at least this often (seconds)
+inline constexpr uint32_t DEADBAND_HEARTBEAT_SEC = 900;
+
+/// Scale of the per-measurement deadbands in percent (0 = report all)
+inline constexpr uint32_t DEADBAND_PERCENT = 0;
 
 // =============================================================================
 // WiFi Configuration
@@ -63,6 +215,59 @@ inline constexpr uint8_t BME680_ADDRESS = 0x77;
 inline constexpr uint8_t WIFI_MAX_RETRIES = 5;
 inline constexpr uint32_t WIFI_TIMEOUT_MS = 15'000;
 
+/// Modem sleep while connected. With AUTO_LIGHT_SLEEP a continuous-mode
+/// probe idles at a few mA; firmware downloads run with it off
+inline constexpr network::PowerSave WIFI_POWER_SAVE = network::PowerSave::Max;
+
+/// Beacons (~102 ms each) between wakes in PowerSave::Max: bounds the
+/// latency of inbound traffic
+inline constexpr uint16_t WIFI_LISTEN_INTERVAL = 3;
+
+/// Sites with several APs for the SSID: scan (passively, on the channels
+/// seen before) and join the strongest, roaming off a weak one. FirstMatch
+/// takes the first AP the driver finds
+inline constexpr network::ScanMode WIFI_SCAN_MODE = network::ScanMode::BestAp;
+
+/// Deep-sleep wakes reuse the last DHCP lease as a static IP (no DHCP
+/// exchange) for this long, then lease again. Keep it well inside the
+/// router's lease time
+inline constexpr uint32_t WIFI_CACHED_LEASE_MAX_AGE_SEC = 30 * 60;
+
+/// Wall clock (network::Sntp). Deep-sleep wakes restore it from RTC memory
+/// and only run NTP on connect once it may be off by more than
+/// MAX_ERROR_MS (the RTC clock's drift is measured between syncs)
+namespace ntp {
+inline constexpr const char *SERVER = "pool.ntp.org";
+inline constexpr uint32_t MAX_ERROR_MS = 2000;
+} // namespace ntp
+
+/// Cloud host answers are reused from RTC memory for this long (lwIP hides
+/// the record's TTL: keep it at or below the endpoint's)
+inline constexpr uint32_t DNS_CACHE_TTL_SEC = 300;
+
+// =============================================================================
+// Local Cluster (ESP-NOW)
+// =============================================================================
+// Battery probes (leaves) hand their samples to one mains-powered probe
+// nearby (the aggregator), which uploads them with its own in one batch
+// (cloud::MeshRelay). A leaf never associates, authenticates or opens TLS:
+// it needs DUTY_CYCLE_MODE and gets no commands, OTA or config updates.
+
+namespace mesh {
+enum class Role : uint8_t {
+  Off,        ///< Uploads its own samples
+  Leaf,       ///< Sends every wake's sample to AGGREGATOR_MAC over ESP-NOW
+  Aggregator, ///< Continuous mode: uploads its samples and the leaves'
+};
+inline constexpr Role ROLE = Role::Off;
+/// Station MAC of the aggregator (leaves)
+inline constexpr transport::MacAddress AGGREGATOR_MAC{};
+/// Channel of the aggregator's AP (leaves don't scan for it)
+inline constexpr uint8_t CHANNEL = 1;
+/// Stations the aggregator accepts (none listed: any on its channel)
+inline constexpr std::array<transport::MacAddress, 0> LEAVES{};
+} // namespace mesh
+
 // =============================================================================
 // Cloud Configuration
 // =============================================================================
@@ -80,9 +285,33 @@ inline constexpr uint32_t TOKEN_REFRESH_BUFFER_SEC = 300; // 5 minutes
 /// Command poll interval in minutes
 inline constexpr uint8_t COMMAND_POLL_INTERVAL_MIN = 1;
 
+/// Idle command polls back off up to this many minutes
+inline constexpr uint8_t COMMAND_POLL_MAX_INTERVAL_MIN = 15;
+
+/// Long-poll wait in seconds (0 = periodic polling; mains power only)
+inline constexpr uint16_t COMMAND_LONG_POLL_SEC = 0;
+
+/// Take pending commands from each telemetry upload's response; the poll
+/// timer then skips its request after an upload (backend must honor
+/// `?commands=pending`)
+inline constexpr bool PIGGYBACK_COMMANDS = false;
+
+/// Send values with a fixed-point form (MEASUREMENT_TRAIT_Q) as small
+/// sint32s instead of floats (backend must decode quantized_val)
+inline constexpr proto::WireEncoding WIRE_ENCODING =
+    proto::WireEncoding::Native;
+
 /// Telemetry send interval in minutes
 inline constexpr uint8_t TELEMETRY_INTERVAL_MIN = 5;
 
+/// Routine telemetry is batched up to this many seconds before an upload
+inline constexpr uint32_t TELEMETRY_BATCH_WINDOW_SEC = 120;
+
+/// Runtime metrics (core::Metrics) ride along with the telemetry upload at
+/// most this often; a duty-cycled unit sends them every transmitting wake.
+/// 0 = off
+inline constexpr uint32_t METRICS_INTERVAL_MIN = 60;
+
 /// Skip TLS certificate verification (ONLY for development!)
 inline constexpr bool SKIP_CERT_VERIFY = false;
 
@@ -99,9 +328,24 @@ inline constexpr uint32_t NETWORK_TIMEOUT_MS = 30'000;
 // =============================================================================
 
 namespace battery {
-inline constexpr gpio_num_t ADC_PIN = GPIO_NUM_2;
+/// Sample the cell (sensor interval) and adapt to its level
+inline constexpr bool MONITOR = true;
+inline constexpr gpio_num_t ADC_PIN = GPIO_NUM_2; ///< ADC1 channel 2
 inline constexpr float VOLTAGE_DIVIDER_RATIO = 2.0F;
-inline constexpr uint32_t ADC_VREF_MV = 1100;
+
+/// CR123A levels at rest (see power::BatteryPolicy). WiFi TX pulls the
+/// cell ~0.2 V lower; the C3 browns out near 2.5 V
+inline constexpr float LOW_V = 2.9F;
+inline constexpr float CRITICAL_V = 2.8F;
+inline constexpr float SHUTDOWN_V = 2.7F;
+inline constexpr float HYSTERESIS_V = 0.1F;
+
+/// Sample, upload and poll intervals are multiplied by these
+inline constexpr uint32_t LOW_STRETCH = 2;
+inline constexpr uint32_t CRITICAL_STRETCH = 4;
+
+/// Deep sleep between checks once shut down
+inline constexpr uint32_t SHUTDOWN_RECHECK_SEC = 3600;
 } // namespace battery
 
 } // namespace app::config
@@ -8,9 +8,15 @@
 #include "app_config.hpp"
 
 #include <application/app.hpp>
+#include <application/benchmarks.hpp>
 #include <application/board.hpp>
+#include <core/bench.hpp>
+#include <core/deferred_log.hpp>
+#include <core/task_registry.hpp>
 
 #include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include <memory>
 
@@ -19,10 +25,28 @@ constexpr const char *TAG = "main";
 } // namespace
 
 extern "C" void app_main() {
+  // The application runs on the main task: report its stack too
+  core::task_registry().add(xTaskGetCurrentTaskHandle(),
+                            CONFIG_ESP_MAIN_TASK_STACK_SIZE);
+  // Every wheel timer and monitor callback runs there: measure it before
+  // trimming CONFIG_ESP_TIMER_TASK_STACK_SIZE
+  core::task_registry().add(xTaskGetHandle("esp_timer"),
+                            CONFIG_ESP_TIMER_TASK_STACK_SIZE);
+  // Prints the hot paths' CORE_DLOGx lines below every application task
+  core::dlog::start(tskIDLE_PRIORITY + 1);
+
+  if constexpr (core::bench::kEnabled) {
+    application::run_benchmarks();
+  }
+
   // Create board with configuration
   application::BoardConfig board_config{
       .i2c_sda = app::config::I2C_SDA_PIN,
       .i2c_scl = app::config::I2C_SCL_PIN,
+      .i2c_queue_depth = app::config::I2C_QUEUE_DEPTH,
+      .spi_sclk = app::config::SPI_SCLK_PIN,
+      .spi_mosi = app::config::SPI_MOSI_PIN,
+      .spi_miso = app::config::SPI_MISO_PIN,
   };
 
   // Board on stack is small
@@ -34,7 +58,9 @@ extern "C" void app_main() {
 
   // Application is too large for stack - allocate on heap
   auto app = std::make_unique<application::MeasurementProbe>(
-      board, std::chrono::seconds(app::config::SLEEP_INTERVAL_SEC));
+      board, std::chrono::seconds(app::config::wake::GPIO_WAKE
+                                      ? app::config::wake::IDLE_SLEEP_SEC
+                                      : app::config::SLEEP_INTERVAL_SEC));
 
   if (auto err = app->start(); !err) {
     ESP_LOGE(TAG, "App failed: %s", esp_err_to_name(err.error()));
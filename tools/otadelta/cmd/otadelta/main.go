@@ -0,0 +1,67 @@
+// Package main builds a delta OTA patch between two firmware images and
+// prints the ota_update command payload that installs it.
+package main
+
+import (
+	"bytes"
+	"crypto/sha256"
+	"encoding/hex"
+	"flag"
+	"fmt"
+	"os"
+
+	"measurement-probe/tools/otadelta/internal/delta"
+)
+
+func main() {
+	if err := run(); err != nil {
+		fmt.Fprintf(os.Stderr, "\n❌ Error: %v\n", err)
+		os.Exit(1)
+	}
+}
+
+func run() error {
+	basePath := flag.String("base", "", "Image the devices run now (.bin)")
+	targetPath := flag.String("target", "", "Image to update to (.bin)")
+	outPath := flag.String("o", "", "Patch file to write (default <target>.pdl)")
+	url := flag.String("url", "<patch url>", "URL the patch will be served from")
+	flag.Parse()
+
+	if *basePath == "" || *targetPath == "" {
+		flag.Usage()
+		return fmt.Errorf("-base and -target are required")
+	}
+	if *outPath == "" {
+		*outPath = *targetPath + ".pdl"
+	}
+
+	base, err := os.ReadFile(*basePath)
+	if err != nil {
+		return err
+	}
+	target, err := os.ReadFile(*targetPath)
+	if err != nil {
+		return err
+	}
+
+	patch, err := delta.Diff(base, target)
+	if err != nil {
+		return err
+	}
+	// Check the patch the way a device would before anyone ships it
+	rebuilt, err := delta.Apply(base, patch)
+	if err != nil || !bytes.Equal(rebuilt, target) {
+		return fmt.Errorf("patch does not rebuild the target: %v", err)
+	}
+	if err := os.WriteFile(*outPath, patch, 0o644); err != nil {
+		return err
+	}
+
+	digest := sha256.Sum256(target)
+	fmt.Printf("✓ %s: %d bytes (%.1f%% of the %d byte image)\n", *outPath,
+		len(patch), 100*float64(len(patch))/float64(len(target)), len(target))
+	fmt.Println("\nota_update payload:")
+	fmt.Printf("{\"url\":%q,\"size\":%d,\"sha256\":\"%s\",\"delta\":true}\n",
+		*url, len(patch), hex.EncodeToString(digest[:]))
+	return nil
+}
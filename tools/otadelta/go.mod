@@ -0,0 +1,3 @@
+module measurement-probe/tools/otadelta
+
+go 1.21
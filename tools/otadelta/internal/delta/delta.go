@@ -0,0 +1,204 @@
+// Package delta builds and applies the firmware delta patches understood by
+// the probe's OTA updater (components/library/cloud/include/cloud/ota_delta.hpp).
+//
+// A patch rebuilds the target image from COPY ranges of the base image (the
+// one running on the device) and INSERTed literal bytes:
+//
+//	"PDL1" | base_id[32] | target_size u32le | op*
+//	0x00 COPY   zigzag varint offset (relative to the end of the previous copy), varint length
+//	0x01 INSERT varint length, literal bytes
+package delta
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"math"
+)
+
+const (
+	opCopy   = 0x00
+	opInsert = 0x01
+
+	// BaseIDSize is the size of the base image id (its app_elf_sha256).
+	BaseIDSize = 32
+
+	// esp_image_header_t (24) + first esp_image_segment_header_t (8)
+	appDescOffset = 32
+	appDescMagic  = 0xABCD5432
+	// Offset of app_elf_sha256 within esp_app_desc_t
+	elfSHA256Offset = 144
+
+	// Bytes hashed per index entry, and the shortest match worth a COPY
+	// (shorter ones cost about as much as inserting the bytes)
+	windowSize = 16
+	minMatch   = 24
+)
+
+var magic = []byte("PDL1")
+
+// ErrWrongBase is returned by Apply for a patch made against another image.
+var ErrWrongBase = errors.New("patch was made for another base image")
+
+// BaseID returns the app_elf_sha256 stored in an ESP-IDF app image. The
+// device compares it with its running image before applying a patch.
+func BaseID(image []byte) ([BaseIDSize]byte, error) {
+	var id [BaseIDSize]byte
+	end := appDescOffset + elfSHA256Offset + BaseIDSize
+	if len(image) < end || image[0] != 0xE9 {
+		return id, errors.New("not an ESP-IDF app image")
+	}
+	if binary.LittleEndian.Uint32(image[appDescOffset:]) != appDescMagic {
+		return id, errors.New("app description not found in image")
+	}
+	copy(id[:], image[end-BaseIDSize:end])
+	return id, nil
+}
+
+// Diff builds a patch that turns base into target.
+func Diff(base, target []byte) ([]byte, error) {
+	id, err := BaseID(base)
+	if err != nil {
+		return nil, fmt.Errorf("base: %w", err)
+	}
+	if len(target) == 0 || uint64(len(target)) > math.MaxUint32 {
+		return nil, fmt.Errorf("target size %d out of range", len(target))
+	}
+
+	patch := append([]byte{}, magic...)
+	patch = append(patch, id[:]...)
+	patch = binary.LittleEndian.AppendUint32(patch, uint32(len(target)))
+
+	// First occurrence of every window in base
+	index := make(map[[windowSize]byte]int, len(base))
+	for p := 0; p+windowSize <= len(base); p++ {
+		key := [windowSize]byte(base[p : p+windowSize])
+		if _, ok := index[key]; !ok {
+			index[key] = p
+		}
+	}
+
+	srcPos := 0 // End of the previous copy
+	literal := 0
+	flush := func(end int) {
+		if end > literal {
+			patch = append(patch, opInsert)
+			patch = binary.AppendUvarint(patch, uint64(end-literal))
+			patch = append(patch, target[literal:end]...)
+		}
+	}
+
+	for i := 0; i < len(target); {
+		// Small edits keep the layout: try the spot right after the last
+		// copy (skipping what was inserted since) before the index
+		from, length := -1, 0
+		if expected := srcPos + (i - literal); expected < len(base) {
+			from, length = expected, matchLen(base[expected:], target[i:])
+		}
+		if length < minMatch && i+windowSize <= len(target) {
+			if p, ok := index[[windowSize]byte(target[i:i+windowSize])]; ok {
+				if n := matchLen(base[p:], target[i:]); n > length {
+					from, length = p, n
+				}
+			}
+		}
+		if length < minMatch {
+			i++
+			continue
+		}
+
+		flush(i)
+		rel := int64(from) - int64(srcPos)
+		patch = append(patch, opCopy)
+		patch = binary.AppendUvarint(patch, uint64((rel<<1)^(rel>>63)))
+		patch = binary.AppendUvarint(patch, uint64(length))
+		srcPos = from + length
+		i += length
+		literal = i
+	}
+	flush(len(target))
+	return patch, nil
+}
+
+// Apply rebuilds the target image from base and a patch, checking the patch
+// the way the device does.
+func Apply(base, patch []byte) ([]byte, error) {
+	header := len(magic) + BaseIDSize + 4
+	if len(patch) < header || !bytes.Equal(patch[:len(magic)], magic) {
+		return nil, errors.New("not a delta patch")
+	}
+	id, err := BaseID(base)
+	if err != nil {
+		return nil, fmt.Errorf("base: %w", err)
+	}
+	if !bytes.Equal(patch[len(magic):len(magic)+BaseIDSize], id[:]) {
+		return nil, ErrWrongBase
+	}
+	size := int(binary.LittleEndian.Uint32(patch[header-4:]))
+	ops := bytes.NewReader(patch[header:])
+
+	out := make([]byte, 0, size)
+	srcPos := int64(0)
+	for len(out) < size {
+		op, err := ops.ReadByte()
+		if err != nil {
+			return nil, fmt.Errorf("patch ends at %d of %d bytes", len(out), size)
+		}
+		switch op {
+		case opCopy:
+			zz, err := binary.ReadUvarint(ops)
+			if err != nil {
+				return nil, fmt.Errorf("copy offset: %w", err)
+			}
+			n, err := readLength(ops, size-len(out))
+			if err != nil {
+				return nil, err
+			}
+			start := srcPos + (int64(zz>>1) ^ -int64(zz&1))
+			if start < 0 || start+int64(n) > int64(len(base)) {
+				return nil, fmt.Errorf("copy outside the base image at %d", len(out))
+			}
+			out = append(out, base[start:start+int64(n)]...)
+			srcPos = start + int64(n)
+		case opInsert:
+			n, err := readLength(ops, size-len(out))
+			if err != nil {
+				return nil, err
+			}
+			literal := make([]byte, n)
+			if _, err := io.ReadFull(ops, literal); err != nil {
+				return nil, fmt.Errorf("insert: %w", err)
+			}
+			out = append(out, literal...)
+		default:
+			return nil, fmt.Errorf("unknown op 0x%02x", op)
+		}
+	}
+	if ops.Len() != 0 {
+		return nil, errors.New("data after the last op")
+	}
+	return out, nil
+}
+
+func readLength(r *bytes.Reader, remaining int) (int, error) {
+	n, err := binary.ReadUvarint(r)
+	if err != nil {
+		return 0, fmt.Errorf("op length: %w", err)
+	}
+	if n > uint64(remaining) {
+		return 0, errors.New("op past the end of the image")
+	}
+	return int(n), nil
+}
+
+func matchLen(a, b []byte) int {
+	n := min(len(a), len(b))
+	for i := 0; i < n; i++ {
+		if a[i] != b[i] {
+			return i
+		}
+	}
+	return n
+}
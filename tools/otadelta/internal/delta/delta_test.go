@@ -0,0 +1,118 @@
+package delta_test
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"math/rand"
+	"testing"
+
+	"measurement-probe/tools/otadelta/internal/delta"
+)
+
+// fakeImage returns size random bytes laid out like an ESP-IDF app image
+// whose app_elf_sha256 is filled with elf.
+func fakeImage(t *testing.T, seed int64, size int, elf byte) []byte {
+	t.Helper()
+	image := make([]byte, size)
+	rand.New(rand.NewSource(seed)).Read(image)
+	image[0] = 0xE9
+	binary.LittleEndian.PutUint32(image[32:], 0xABCD5432)
+	copy(image[176:208], bytes.Repeat([]byte{elf}, 32))
+	return image
+}
+
+func TestBaseID(t *testing.T) {
+	t.Parallel()
+
+	id, err := delta.BaseID(fakeImage(t, 1, 4096, 0x5A))
+	if err != nil {
+		t.Fatalf("BaseID() error = %v", err)
+	}
+	if id != [delta.BaseIDSize]byte(bytes.Repeat([]byte{0x5A}, 32)) {
+		t.Errorf("BaseID() = %x, want 5a...", id)
+	}
+
+	if _, err := delta.BaseID(make([]byte, 4096)); err == nil {
+		t.Error("BaseID() accepted an image without a header")
+	}
+}
+
+func TestDiffApply_RoundTrip(t *testing.T) {
+	t.Parallel()
+
+	base := fakeImage(t, 1, 256<<10, 0x11)
+	target := append([]byte{}, base...)
+	copy(target[176:208], bytes.Repeat([]byte{0x22}, 32))
+	copy(target[5000:], []byte("patched in place"))
+	// Code added in the middle shifts everything after it
+	target = append(target[:100000], append(bytes.Repeat([]byte{0xAB}, 300),
+		target[100000:]...)...)
+	target = append(target, []byte("new tail")...)
+
+	patch, err := delta.Diff(base, target)
+	if err != nil {
+		t.Fatalf("Diff() error = %v", err)
+	}
+	if len(patch) > 2048 {
+		t.Errorf("Diff() patch is %d bytes, want a small one", len(patch))
+	}
+
+	got, err := delta.Apply(base, patch)
+	if err != nil {
+		t.Fatalf("Apply() error = %v", err)
+	}
+	if !bytes.Equal(got, target) {
+		t.Error("Apply() did not rebuild the target")
+	}
+}
+
+func TestDiffApply_Unrelated(t *testing.T) {
+	t.Parallel()
+
+	base := fakeImage(t, 1, 64<<10, 0x11)
+	target := fakeImage(t, 2, 70<<10, 0x22)
+
+	patch, err := delta.Diff(base, target)
+	if err != nil {
+		t.Fatalf("Diff() error = %v", err)
+	}
+	got, err := delta.Apply(base, patch)
+	if err != nil {
+		t.Fatalf("Apply() error = %v", err)
+	}
+	if !bytes.Equal(got, target) {
+		t.Error("Apply() did not rebuild the target")
+	}
+}
+
+func TestApply_WrongBase(t *testing.T) {
+	t.Parallel()
+
+	base := fakeImage(t, 1, 64<<10, 0x11)
+	target := append([]byte{}, base...)
+	target[40000] ^= 0xFF
+
+	patch, err := delta.Diff(base, target)
+	if err != nil {
+		t.Fatalf("Diff() error = %v", err)
+	}
+	other := fakeImage(t, 1, 64<<10, 0x33)
+	if _, err := delta.Apply(other, patch); !errors.Is(err, delta.ErrWrongBase) {
+		t.Errorf("Apply() error = %v, want ErrWrongBase", err)
+	}
+}
+
+func TestApply_Truncated(t *testing.T) {
+	t.Parallel()
+
+	base := fakeImage(t, 1, 64<<10, 0x11)
+	target := fakeImage(t, 2, 8<<10, 0x22)
+	patch, err := delta.Diff(base, target)
+	if err != nil {
+		t.Fatalf("Diff() error = %v", err)
+	}
+	if _, err := delta.Apply(base, patch[:len(patch)-1]); err == nil {
+		t.Error("Apply() accepted a truncated patch")
+	}
+}
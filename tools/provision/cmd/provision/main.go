@@ -9,6 +9,7 @@ import (
 	"strings"
 
 	"measurement-probe/tools/provision/internal/api"
+	"measurement-probe/tools/provision/internal/blobs"
 	"measurement-probe/tools/provision/internal/endpoints"
 	"measurement-probe/tools/provision/internal/gcloud"
 	"measurement-probe/tools/provision/internal/nvs"
@@ -18,6 +19,7 @@ import (
 
 const (
 	nvsPartitionName      = "nvs"
+	blobPartitionName     = "certs"
 	defaultPartitionTable = "partitions.csv"
 	defaultService        = "telemetry-api"
 	defaultRegion         = "us-west1"
@@ -39,6 +41,7 @@ func run() error {
 	macAddress := flag.String("mac", "", "Device MAC (skip auto-detection)")
 	dryRun := flag.Bool("dry-run", false, "Provision only, don't flash to device")
 	skipBuild := flag.Bool("skip-build", false, "Skip automatic rebuild")
+	blobDir := flag.String("blobs", "", "Directory of certs/config files to flash to the certs partition")
 	flag.Parse()
 
 	fmt.Println("╔═══════════════════════════════════════════════════════════╗")
@@ -213,6 +216,22 @@ func run() error {
 		return fmt.Errorf("write NVS: %w", err)
 	}
 
+	// Step 10: Write certs / config blobs (optional)
+	if *blobDir != "" {
+		fmt.Println("\n→ Writing blob partition...")
+		blobPartition, err := partTable.FindByName(blobPartitionName)
+		if err != nil {
+			return fmt.Errorf("find blob partition: %w", err)
+		}
+		binPath := filepath.Join(tmpDir, "blobs.bin")
+		if err := blobs.WriteImage(*blobDir, binPath, blobPartition.Size); err != nil {
+			return fmt.Errorf("pack blobs: %w", err)
+		}
+		if err := blobs.Flash(serialPort, binPath, blobPartition.Offset); err != nil {
+			return fmt.Errorf("flash blobs: %w", err)
+		}
+	}
+
 	fmt.Println("\n" + strings.Repeat("═", 60))
 	fmt.Println("✓ Device provisioned successfully!")
 	printCredentials(resp, serviceURL)
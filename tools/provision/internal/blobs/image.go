@@ -0,0 +1,130 @@
+// Package blobs packs files into the read-only blob partition image that
+// the firmware memory-maps (see core/blob_partition.hpp).
+package blobs
+
+import (
+	"encoding/binary"
+	"fmt"
+	"hash/crc32"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"sort"
+	"strings"
+)
+
+const (
+	Magic      = 0x424F4C42 // "BLOB"
+	Version    = 1
+	NameLen    = 16 // Including the NUL
+	MaxEntries = 32
+
+	headerSize = 16
+	entrySize  = 24
+
+	// Crc32 DEFAULT_SEED in core/crc.hpp
+	crcSeed = 0x9E83B3D1
+)
+
+// Blob is one named entry of the image
+type Blob struct {
+	Name string
+	Data []byte
+}
+
+// Pack builds an image: header, table of contents, then each blob followed
+// by a NUL byte (so PEM blobs can be used as C strings in place)
+func Pack(blobs []Blob) ([]byte, error) {
+	if len(blobs) > MaxEntries {
+		return nil, fmt.Errorf("%d blobs, at most %d fit", len(blobs), MaxEntries)
+	}
+
+	tocEnd := headerSize + entrySize*len(blobs)
+	image := make([]byte, tocEnd)
+	seen := make(map[string]bool)
+
+	for i, b := range blobs {
+		if b.Name == "" || len(b.Name) >= NameLen {
+			return nil, fmt.Errorf("blob name %q: must be 1-%d chars", b.Name, NameLen-1)
+		}
+		if seen[b.Name] {
+			return nil, fmt.Errorf("duplicate blob %q", b.Name)
+		}
+		seen[b.Name] = true
+
+		entry := image[headerSize+entrySize*i:]
+		copy(entry[:NameLen], b.Name)
+		binary.LittleEndian.PutUint32(entry[NameLen:], uint32(len(image)))
+		binary.LittleEndian.PutUint32(entry[NameLen+4:], uint32(len(b.Data)))
+
+		image = append(image, b.Data...)
+		image = append(image, 0)
+	}
+
+	binary.LittleEndian.PutUint32(image[0:], Magic)
+	binary.LittleEndian.PutUint16(image[4:], Version)
+	binary.LittleEndian.PutUint16(image[6:], uint16(len(blobs)))
+	binary.LittleEndian.PutUint32(image[8:], uint32(len(image)))
+	binary.LittleEndian.PutUint32(image[12:], crc32.Update(crcSeed, crc32.IEEETable, image[headerSize:]))
+
+	return image, nil
+}
+
+// LoadDir reads every regular file of dir as a blob named after the file
+// without its extension (ca_cert.pem -> "ca_cert")
+func LoadDir(dir string) ([]Blob, error) {
+	entries, err := os.ReadDir(dir)
+	if err != nil {
+		return nil, fmt.Errorf("read blob dir: %w", err)
+	}
+
+	var blobs []Blob
+	for _, e := range entries {
+		if !e.Type().IsRegular() {
+			continue
+		}
+		data, err := os.ReadFile(filepath.Join(dir, e.Name()))
+		if err != nil {
+			return nil, fmt.Errorf("read blob: %w", err)
+		}
+		name := strings.TrimSuffix(e.Name(), filepath.Ext(e.Name()))
+		blobs = append(blobs, Blob{Name: name, Data: data})
+	}
+
+	sort.Slice(blobs, func(i, j int) bool { return blobs[i].Name < blobs[j].Name })
+	return blobs, nil
+}
+
+// WriteImage packs dir into binPath, checking it fits the partition
+func WriteImage(dir, binPath string, partitionSize int) error {
+	blobs, err := LoadDir(dir)
+	if err != nil {
+		return err
+	}
+
+	image, err := Pack(blobs)
+	if err != nil {
+		return err
+	}
+	if len(image) > partitionSize {
+		return fmt.Errorf("image is %d bytes, partition holds %d", len(image), partitionSize)
+	}
+
+	return os.WriteFile(binPath, image, 0600)
+}
+
+// Flash writes the image to the device with esptool.py
+func Flash(port, binPath string, offset int) error {
+	cmd := exec.Command("esptool.py",
+		"--port", port,
+		"write_flash", fmt.Sprintf("0x%x", offset), binPath,
+	)
+	cmd.Stdout = os.Stdout
+	cmd.Stderr = os.Stderr
+
+	if err := cmd.Run(); err != nil {
+		return fmt.Errorf("esptool.py failed: %w", err)
+	}
+
+	return nil
+}
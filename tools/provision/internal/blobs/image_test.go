@@ -0,0 +1,100 @@
+package blobs
+
+import (
+	"bytes"
+	"encoding/binary"
+	"hash/crc32"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+func TestPackLayout(t *testing.T) {
+	pem := []byte("-----BEGIN CERTIFICATE-----\nMIIB\n-----END CERTIFICATE-----\n")
+	image, err := Pack([]Blob{
+		{Name: "ca_cert", Data: pem},
+		{Name: "bsec_config", Data: []byte{1, 2, 3}},
+	})
+	if err != nil {
+		t.Fatalf("Pack() error = %v", err)
+	}
+
+	le := binary.LittleEndian
+	if got := le.Uint32(image[0:]); got != Magic {
+		t.Errorf("magic = %#x, want %#x", got, Magic)
+	}
+	if got := le.Uint16(image[6:]); got != 2 {
+		t.Errorf("count = %d, want 2", got)
+	}
+	if got := le.Uint32(image[8:]); int(got) != len(image) {
+		t.Errorf("size = %d, want %d", got, len(image))
+	}
+	if got, want := le.Uint32(image[12:]), crc32.Update(crcSeed, crc32.IEEETable, image[headerSize:]); got != want {
+		t.Errorf("crc = %#x, want %#x", got, want)
+	}
+
+	entry := image[headerSize:]
+	if name := string(bytes.TrimRight(entry[:NameLen], "\x00")); name != "ca_cert" {
+		t.Errorf("name = %q, want ca_cert", name)
+	}
+	offset := le.Uint32(entry[NameLen:])
+	size := le.Uint32(entry[NameLen+4:])
+	if offset != headerSize+2*entrySize {
+		t.Errorf("offset = %d, want %d", offset, headerSize+2*entrySize)
+	}
+	if !bytes.Equal(image[offset:offset+size], pem) {
+		t.Error("blob data mismatch")
+	}
+	if image[offset+size] != 0 {
+		t.Error("blob not NUL-terminated")
+	}
+}
+
+func TestPackRejects(t *testing.T) {
+	tests := []struct {
+		name  string
+		blobs []Blob
+	}{
+		{name: "empty name", blobs: []Blob{{Name: ""}}},
+		{name: "long name", blobs: []Blob{{Name: strings.Repeat("x", NameLen)}}},
+		{name: "duplicate", blobs: []Blob{{Name: "a"}, {Name: "a"}}},
+		{name: "too many", blobs: make([]Blob, MaxEntries+1)},
+	}
+
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			if _, err := Pack(tt.blobs); err == nil {
+				t.Error("Pack() expected error")
+			}
+		})
+	}
+}
+
+func TestWriteImage(t *testing.T) {
+	dir := t.TempDir()
+	if err := os.WriteFile(filepath.Join(dir, "ca_cert.pem"), []byte("pem"), 0600); err != nil {
+		t.Fatal(err)
+	}
+	if err := os.WriteFile(filepath.Join(dir, "bsec_config.bin"), []byte{9}, 0600); err != nil {
+		t.Fatal(err)
+	}
+
+	binPath := filepath.Join(t.TempDir(), "blobs.bin")
+	if err := WriteImage(dir, binPath, 0x1000); err != nil {
+		t.Fatalf("WriteImage() error = %v", err)
+	}
+
+	image, err := os.ReadFile(binPath)
+	if err != nil {
+		t.Fatal(err)
+	}
+	// Sorted by name: bsec_config first
+	if name := string(bytes.TrimRight(image[headerSize:headerSize+NameLen], "\x00")); name != "bsec_config" {
+		t.Errorf("first entry = %q, want bsec_config", name)
+	}
+
+	if err := WriteImage(dir, binPath, 16); err == nil {
+		t.Error("WriteImage() expected error for undersized partition")
+	}
+}
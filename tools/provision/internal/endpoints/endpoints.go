@@ -71,6 +71,7 @@ inline constexpr std::string_view AUTH_DEVICE = "/auth/device";
 inline constexpr std::string_view AUTH_REFRESH = "/auth/refresh";
 inline constexpr std::string_view TELEMETRY_PROTO = "/telemetry/proto";
 inline constexpr std::string_view COMMANDS = "/commands";
+inline constexpr std::string_view COMMANDS_ACK = "/commands/ack";
 inline constexpr std::string_view DEVICE_INFO = "/devices/info";
 
 } // namespace cloud::endpoints